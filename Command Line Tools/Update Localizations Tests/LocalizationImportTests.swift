@@ -0,0 +1,581 @@
+import XCTest
+
+class LocalizationImportTests: XCTestCase {
+
+    var directoryURL: URL!
+
+    override func setUpWithError() throws {
+        directoryURL = FileManager.default.temporaryDirectory.appendingPathComponent(UUID().uuidString, isDirectory: true)
+        try FileManager.default.createDirectory(at: directoryURL, withIntermediateDirectories: true)
+    }
+
+    override func tearDownWithError() throws {
+        try? FileManager.default.removeItem(at: directoryURL)
+    }
+
+    // MARK: - Fixtures
+
+    private let availableLocales: Set<String> = ["en", "fr", "de", "pl", "ru", "sr", "uk", "ja", "ar", "he", "zh", "pt", "es"]
+
+    private let englishStrings: [String: String] = [
+        "article-title": "Article",
+        "welcome-user": "Welcome, %1$@!",
+        "edited-by": "%1$@ edited %2$@",
+        "saved-count": "%1$d saved articles",
+        "saved-count-in-list": "%1$d articles in %2$@",
+        "gender-thanks": "%1$@ thanked you",
+        "quoted": "Search for \"%1$@\"\non %2$@",
+        "percent-complete": "%1$d% complete",
+        "unnumbered": "%@ items",
+        "path": "Files in C:\\Wikipedia",
+        "app-store-short-description": "The free encyclopedia",
+        "app-store-keywords": "wikipedia,encyclopedia",
+        "app-store-subtitle": "The free encyclopedia"
+    ]
+
+    private let twnStrings: [String: [String: String]] = [
+        "en": [
+            "article-title": "Article",
+            "welcome-user": "Welcome, $1!",
+            "edited-by": "$1 edited $2",
+            "saved-count": "{{PLURAL:$1|$1 saved article|$1 saved articles}}",
+            "saved-count-in-list": "{{PLURAL:$1|One article|$1 articles}} in $2",
+            "gender-thanks": "{{GENDER:$1|He|She|They}} thanked you",
+            "quoted": "Search for \"$1\"\non $2",
+            "percent-complete": "$1% complete",
+            "unnumbered": "$1 items",
+            "path": "Files in C:\\Wikipedia",
+            "app-store-short-description": "The free encyclopedia",
+            "app-store-keywords": "wikipedia,encyclopedia",
+            "app-store-subtitle": "The free encyclopedia"
+        ],
+        "fr": [
+            "article-title": "Article",
+            "welcome-user": "Bienvenue, $1 !",
+            "edited-by": "$2 modifié par $1",
+            "saved-count": "{{PLURAL:$1|$1 article sauvegardé|$1 articles sauvegardés}}",
+            "saved-count-in-list": "{{PLURAL:$1|1=Un article|$1 articles}} dans $2",
+            "gender-thanks": "{{GENDER:$1|Il|Elle}} vous a remercié",
+            "quoted": "Rechercher « $1 »\nsur $2",
+            "percent-complete": "$1 % terminé",
+            "app-store-short-description": "L’encyclopédie libre",
+            "app-store-keywords": "wikipédia,encyclopédie",
+            "app-store-subtitle": ""
+        ],
+        "de": [
+            "article-title": "Artikel",
+            "welcome-user": "Willkommen, $1!",
+            "edited-by": "$1 hat $2 bearbeitet",
+            "saved-count": "{{PLURAL:$1|one=Ein gespeicherter Artikel|$1 gespeicherte Artikel}}",
+            "quoted": "Nach „$1“ suchen\nauf $2",
+            "path": "Dateien in C:\\Wikipedia",
+            "app-store-short-description": "Die freie Enzyklopädie"
+        ],
+        "pl": [
+            "article-title": "Artykuł",
+            "saved-count": "{{PLURAL:$1|$1 zapisany artykuł|$1 zapisane artykuły|$1 zapisanych artykułów}}",
+            "saved-count-in-list": "{{PLURAL:$1|1=Jeden artykuł|$1 artykuły|$1 artykułów}} w $2",
+            "welcome-user": "Witaj, $1!"
+        ],
+        "ru": [
+            "article-title": "Статья",
+            "saved-count": "{{PLURAL:$1|one=$1 сохранённая статья|few=$1 сохранённые статьи|many=$1 сохранённых статей|$1 сохранённых статей}}",
+            "edited-by": "$1 изменил(а) $2",
+            // Mismatched token, dropped
+            "welcome-user": "Добро пожаловать, $2!",
+            "app-store-keywords": "википедия,энциклопедия"
+        ],
+        "sr": [
+            "article-title": "Чланак",
+            "saved-count": "{{PLURAL:$1|$1 сачуван чланак|$1 сачувана чланка|$1 сачуваних чланака}}",
+            "gender-thanks": "{{GENDER:$1|Захвалио|Захвалила}} вам је"
+        ],
+        "uk": [
+            "article-title": "Стаття",
+            "saved-count": "{{PLURAL:$1|1=Одна збережена стаття|$1 збережена стаття|$1 збережені статті|$1 збережених статей}}",
+            "quoted": "Шукати «$1»\nу $2"
+        ],
+        "ja": [
+            "article-title": "記事",
+            "welcome-user": "ようこそ、$1さん",
+            "edited-by": "$1が$2を編集しました",
+            "unnumbered": "$1 件",
+            "app-store-short-description": "フリー百科事典",
+            "app-store-subtitle": "ウィキペディア"
+        ],
+        "ar": [
+            "article-title": "مقالة",
+            "saved-count": "{{PLURAL:$1|0=لا مقالات|مقالة واحدة|مقالتان|$1 مقالات|$1 مقالة|$1 مقالة}}",
+            "edited-by": "‏$1 عدّل $2"
+        ],
+        "he": [
+            "article-title": "ערך",
+            "saved-count": "{{PLURAL:$1|ערך שמור אחד|$1 ערכים שמורים}}",
+            "gender-thanks": "{{GENDER:$1|הוא|היא}} הודה לך",
+            "percent-complete": "הושלמו $1%"
+        ],
+        "zh-hans": [
+            "article-title": "条目",
+            "welcome-user": "欢迎，$1！",
+            "saved-count": "{{PLURAL:$1|$1篇已保存条目}}",
+            "app-store-short-description": "自由的百科全书",
+            "app-store-keywords": "维基百科,百科全书"
+        ],
+        "pt": [
+            "article-title": "Artigo",
+            "saved-count": "{{PLURAL:$1|$1 artigo salvo|$1 artigos salvos}}",
+            "quoted": "Pesquisar por \"$1\"\nem $2",
+            "path": "Arquivos em C:\\Wikipédia",
+            "app-store-short-description": "A enciclopédia livre"
+        ],
+        "es": [
+            "article-title": "Artículo",
+            "welcome-user": "¡Bienvenido, $1!",
+            "saved-count-in-list": "{{PLURAL:$1|Un artículo|$1 artículos}} en $2",
+            "edited-by": "$1 editó $2",
+            "app-store-subtitle": "La enciclopedia libre"
+        ],
+        // Not an available locale, its native localizations are removed
+        "xx": [
+            "article-title": "Xxx"
+        ]
+    ]
+
+    private let displayNames: [String: String] = [
+        "fr": "Wikipédia",
+        "de": "Wikipedia",
+        "ja": "ウィキペディア",
+        "ru": "Википедия",
+        "zh-hans": "维基百科"
+    ]
+
+    private let defaultMetadata: [String: String] = [
+        "description.txt": "Wikipedia is the free encyclopedia.",
+        "keywords.txt": "wikipedia,encyclopedia",
+        "marketing_url.txt": "https://wikipedia.org",
+        "name.txt": "Wikipedia",
+        "privacy_url.txt": "https://foundation.wikimedia.org/wiki/Privacy_policy",
+        "promotional_text.txt": "",
+        "release_notes.txt": "Bug fixes",
+        "subtitle.txt": "The free encyclopedia",
+        "support_url.txt": "https://www.mediawiki.org/wiki/Wikimedia_Apps/iOS_FAQ"
+    ]
+
+    private func writeFixtures(to root: URL) throws {
+        let fm = FileManager.default
+        let nativeURL = root.appendingPathComponent("Wikipedia/iOS Native Localizations")
+        let twnURL = root.appendingPathComponent("Wikipedia/Localizations")
+
+        try fm.createDirectory(at: nativeURL.appendingPathComponent("en.lproj"), withIntermediateDirectories: true)
+        try writeTWNStrings(fromDictionary: englishStrings, toFile: nativeURL.appendingPathComponent("en.lproj/Localizable.strings").path, escaped: true)
+
+        for (locale, strings) in twnStrings {
+            let folderURL = twnURL.appendingPathComponent("\(locale).lproj")
+            try fm.createDirectory(at: folderURL, withIntermediateDirectories: true)
+            try writeTWNStrings(fromDictionary: strings, toFile: folderURL.appendingPathComponent("Localizable.strings").path, escaped: true)
+        }
+
+        for (locale, displayName) in displayNames {
+            let folderURL = nativeURL.appendingPathComponent("\(locale).lproj")
+            try fm.createDirectory(at: folderURL, withIntermediateDirectories: true)
+            try writeTWNStrings(fromDictionary: ["CFBundleDisplayName": displayName], toFile: folderURL.appendingPathComponent("InfoPlist.strings").path, escaped: true)
+        }
+
+        // Left over from an earlier import
+        let staleFolderURL = nativeURL.appendingPathComponent("xx.lproj")
+        try fm.createDirectory(at: staleFolderURL, withIntermediateDirectories: true)
+        try writeTWNStrings(fromDictionary: ["article-title": "Xxx"], toFile: staleFolderURL.appendingPathComponent("Localizable.strings").path, escaped: true)
+
+        let defaultMetadataURL = root.appendingPathComponent("fastlane/metadata/en-us")
+        try fm.createDirectory(at: defaultMetadataURL, withIntermediateDirectories: true)
+        for (filename, contents) in defaultMetadata {
+            try contents.write(to: defaultMetadataURL.appendingPathComponent(filename), atomically: true, encoding: .utf8)
+        }
+
+        let frenchMetadataURL = root.appendingPathComponent("fastlane/metadata/fr-fr")
+        try fm.createDirectory(at: frenchMetadataURL, withIntermediateDirectories: true)
+        try "https://old.example.org".write(to: frenchMetadataURL.appendingPathComponent("marketing_url.txt"), atomically: true, encoding: .utf8)
+
+        let staleMetadataURL = root.appendingPathComponent("fastlane/metadata/he")
+        try fm.createDirectory(at: staleMetadataURL, withIntermediateDirectories: true)
+        try "ויקיפדיה".write(to: staleMetadataURL.appendingPathComponent("name.txt"), atomically: true, encoding: .utf8)
+    }
+
+    private func filesByRelativePath(in root: URL) throws -> [String: Data] {
+        var files: [String: Data] = [:]
+        guard let enumerator = FileManager.default.enumerator(at: root, includingPropertiesForKeys: [.isRegularFileKey]) else {
+            return files
+        }
+        let rootPath = root.resolvingSymlinksInPath().path
+        for case let fileURL as URL in enumerator {
+            guard try fileURL.resourceValues(forKeys: [.isRegularFileKey]).isRegularFile == true else {
+                continue
+            }
+            let relativePath = String(fileURL.resolvingSymlinksInPath().path.dropFirst(rootPath.count))
+            files[relativePath] = try Data(contentsOf: fileURL)
+        }
+        return files
+    }
+
+    // MARK: - Tests
+
+    func testScannerMatchesRegexes() {
+        var strings = Array(twnStrings.values.flatMap { $0.values })
+        strings += [
+            "{{GENDER:|He|She}} and {{gender:}} and {{PLURAL:$1|$1}}",
+            "{{GENDER:$1|He|She}} {still open",
+            "{{}} {{ :x}} {{1:x}} {{PLURAL:$1|a}}}",
+            "$ $a $:1 $:x $12 $1$2",
+            "{{PLURAL:$1|a}} {{PLURAL:$2|b}}}} {{c}}",
+            "😀{{GENDER:😀|😀}}😀 $1"
+        ]
+        let tokens = ["1": "d", "2": "@", "12": "f"]
+        for string in strings {
+            let nativeLocalization = string.iOSNativeLocalization(tokens: tokens)
+            XCTAssertEqual(nativeLocalization, LegacyLocalizationImport.iOSNativeLocalization(string, tokens: tokens), "Unexpected conversion of \(string)")
+            XCTAssertEqual(nativeLocalization.iOSTokenDictionary, LegacyLocalizationImport.iOSTokenDictionary(nativeLocalization), "Unexpected tokens in \(nativeLocalization)")
+        }
+
+        for string in ["%1$@ %2$d", "%@ and %d%%", "%3$s %1$F %2$x", "100% done", "%1$ld", "%$@", "%12$u"] {
+            XCTAssertEqual(string.iOSTokenDictionary, LegacyLocalizationImport.iOSTokenDictionary(string), "Unexpected tokens in \(string)")
+        }
+    }
+
+    func testImportMatchesLegacyImport() throws {
+        let legacyRoot = directoryURL.appendingPathComponent("legacy")
+        let root = directoryURL.appendingPathComponent("pipeline")
+        try writeFixtures(to: legacyRoot)
+        try writeFixtures(to: root)
+
+        LegacyLocalizationImport.importLocalizationsFromTWN(legacyRoot.path, availableLocales: availableLocales)
+        let report = importLocalizationsFromTWN(root.path, availableLocales: availableLocales, manifestURL: directoryURL.appendingPathComponent("manifest.json"))
+
+        let legacyFiles = try filesByRelativePath(in: legacyRoot)
+        let files = try filesByRelativePath(in: root)
+        XCTAssertEqual(Set(files.keys), Set(legacyFiles.keys))
+        for (relativePath, data) in legacyFiles {
+            XCTAssertEqual(files[relativePath], data, "\(relativePath) differs from the legacy import")
+        }
+
+        XCTAssertNotNil(files["/Wikipedia/iOS Native Localizations/pl.lproj/Localizable.stringsdict"])
+        XCTAssertEqual(files["/Wikipedia/iOS Native Localizations/ja.lproj/Localizable.stringsdict"], files["/Wikipedia/iOS Native Localizations/en.lproj/Localizable.stringsdict"])
+        XCTAssertNil(files["/Wikipedia/iOS Native Localizations/xx.lproj/Localizable.strings"])
+        XCTAssertNil(files["/fastlane/metadata/he/name.txt"])
+
+        XCTAssertEqual(report.locales.count, twnStrings.count)
+        let reportsByLocale = Dictionary(uniqueKeysWithValues: report.locales.map { ($0.locale, $0) })
+        XCTAssertEqual(reportsByLocale["xx"]?.outcome, .removed)
+        XCTAssertEqual(reportsByLocale["fr"]?.outcome, .imported)
+        XCTAssertEqual(reportsByLocale["ru"]?.stringCount, 4)
+        XCTAssertEqual(reportsByLocale["ru"]?.pluralCount, 1)
+        XCTAssertEqual(reportsByLocale["de"]?.stringsDiff.added, twnStrings["de"]?.count)
+    }
+
+    func testUnchangedLocalesAreSkipped() throws {
+        let root = directoryURL.appendingPathComponent("repo")
+        let manifestURL = directoryURL.appendingPathComponent("manifest.json")
+        try writeFixtures(to: root)
+
+        importLocalizationsFromTWN(root.path, availableLocales: availableLocales, manifestURL: manifestURL)
+        let files = try filesByRelativePath(in: root)
+
+        let report = importLocalizationsFromTWN(root.path, availableLocales: availableLocales, manifestURL: manifestURL)
+        for localeReport in report.locales {
+            switch localeReport.locale {
+            case "en":
+                XCTAssertEqual(localeReport.outcome, .imported)
+                XCTAssertFalse(localeReport.wroteStringsDict)
+            case "xx":
+                XCTAssertEqual(localeReport.outcome, .removed)
+            default:
+                XCTAssertEqual(localeReport.outcome, .unchanged, "\(localeReport.locale) wasn't skipped")
+            }
+        }
+        XCTAssertEqual(try filesByRelativePath(in: root), files)
+
+        // Changed inputs and outputs are imported again
+        var frenchStrings = twnStrings["fr"] ?? [:]
+        frenchStrings["article-title"] = "Un article"
+        try writeTWNStrings(fromDictionary: frenchStrings, toFile: root.appendingPathComponent("Wikipedia/Localizations/fr.lproj/Localizable.strings").path, escaped: true)
+        try FileManager.default.removeItem(at: root.appendingPathComponent("Wikipedia/iOS Native Localizations/de.lproj/Localizable.strings"))
+
+        let changedReport = importLocalizationsFromTWN(root.path, availableLocales: availableLocales, manifestURL: manifestURL)
+        let reportsByLocale = Dictionary(uniqueKeysWithValues: changedReport.locales.map { ($0.locale, $0) })
+        XCTAssertEqual(reportsByLocale["fr"]?.outcome, .imported)
+        XCTAssertEqual(reportsByLocale["fr"]?.stringsDiff.changed, 1)
+        XCTAssertEqual(reportsByLocale["fr"]?.stringsDiff.added, 0)
+        XCTAssertEqual(reportsByLocale["de"]?.outcome, .imported)
+        XCTAssertEqual(reportsByLocale["pl"]?.outcome, .unchanged)
+        XCTAssertEqual(try filesByRelativePath(in: root)["/Wikipedia/iOS Native Localizations/de.lproj/Localizable.strings"], files["/Wikipedia/iOS Native Localizations/de.lproj/Localizable.strings"])
+    }
+
+    func testLocalesSharingMetadataFolder() throws {
+        let root = directoryURL.appendingPathComponent("repo")
+        let manifestURL = directoryURL.appendingPathComponent("manifest.json")
+        try writeFixtures(to: root)
+
+        // pt writes the pt-br metadata, and pt-br, which is available as pt, has none of its own
+        let brazilianFolderURL = root.appendingPathComponent("Wikipedia/Localizations/pt-br.lproj")
+        try FileManager.default.createDirectory(at: brazilianFolderURL, withIntermediateDirectories: true)
+        try writeTWNStrings(fromDictionary: ["article-title": "Artigo", "app-store-short-description": "A enciclopédia livre (Brasil)"], toFile: brazilianFolderURL.appendingPathComponent("Localizable.strings").path, escaped: true)
+
+        let brazilianDescriptionPath = "/fastlane/metadata/pt-br/description.txt"
+        for _ in 0..<5 {
+            try? FileManager.default.removeItem(at: manifestURL)
+            let report = importLocalizationsFromTWN(root.path, availableLocales: availableLocales, manifestURL: manifestURL)
+            let reportsByLocale = Dictionary(uniqueKeysWithValues: report.locales.map { ($0.locale, $0) })
+            XCTAssertEqual(reportsByLocale["pt"]?.outcome, .imported)
+            XCTAssertEqual(reportsByLocale["pt-br"]?.outcome, .imported)
+
+            let files = try filesByRelativePath(in: root)
+            XCTAssertEqual(files[brazilianDescriptionPath].flatMap { String(data: $0, encoding: .utf8) }, "A enciclopédia livre")
+            XCTAssertEqual(files["/fastlane/metadata/pt-pt/description.txt"], files[brazilianDescriptionPath])
+        }
+
+        let files = try filesByRelativePath(in: root)
+        let report = importLocalizationsFromTWN(root.path, availableLocales: availableLocales, manifestURL: manifestURL)
+        let reportsByLocale = Dictionary(uniqueKeysWithValues: report.locales.map { ($0.locale, $0) })
+        XCTAssertEqual(reportsByLocale["pt"]?.outcome, .unchanged, "pt-br shouldn't change the metadata pt wrote")
+        XCTAssertEqual(reportsByLocale["pt-br"]?.outcome, .unchanged)
+        XCTAssertEqual(try filesByRelativePath(in: root), files)
+    }
+}
+
+/// The regex based, serial import the pipeline replaced, kept to compare against
+private enum LegacyLocalizationImport {
+
+    private static let curlyBraceRegex = try! NSRegularExpression(pattern: "(?:[{][{][a-z]+:)(:?[^{]*)(?:[}][}])", options: [.caseInsensitive])
+    private static let twnTokenRegex = try! NSRegularExpression(pattern: "(?:[$])(:?[0-9]+)", options: [])
+    private static let iOSTokenRegex = try! NSRegularExpression(pattern: "%([0-9]*)\\$?([@dDuUxXoOfeEgGcCsSpaAF])", options: [])
+
+    private static func replacingMatches(in string: String, fromRegex regex: NSRegularExpression, withFormat format: String) -> String {
+        let nativeLocalization = NSMutableString(string: string)
+        var offset = 0
+        let fullRange = NSRange(location: 0, length: nativeLocalization.length)
+        var index = 1
+        regex.enumerateMatches(in: string, options: [], range: fullRange) { (result, flags, stop) in
+            guard let result = result else {
+                return
+            }
+            var token = regex.replacementString(for: result, in: nativeLocalization as String, offset: offset, template: "$1")
+            if token == "" {
+                token = "\(index)"
+            }
+            let replacement = String(format: format, token)
+            let replacementRange = NSRange(location: result.range.location + offset, length: result.range.length)
+            nativeLocalization.replaceCharacters(in: replacementRange, with: replacement)
+            offset += (replacement as NSString).length - result.range.length
+            index += 1
+        }
+        return nativeLocalization as String
+    }
+
+    private static func replacingMatches(in string: String, fromTokenRegex regex: NSRegularExpression, withFormat format: String, tokens: [String: String]) -> String {
+        let nativeLocalization = NSMutableString(string: string)
+        var offset = 0
+        let fullRange = NSRange(location: 0, length: nativeLocalization.length)
+        regex.enumerateMatches(in: string, options: [], range: fullRange) { (result, flags, stop) in
+            guard let result = result else {
+                return
+            }
+            let token = regex.replacementString(for: result, in: nativeLocalization as String, offset: offset, template: "$1")
+            let replacement = String(format: format, token, tokens[token] ?? "@")
+            let replacementRange = NSRange(location: result.range.location + offset, length: result.range.length)
+            nativeLocalization.replaceCharacters(in: replacementRange, with: replacement)
+            offset += (replacement as NSString).length - result.range.length
+        }
+        return nativeLocalization as String
+    }
+
+    static func iOSNativeLocalization(_ string: String, tokens: [String: String]) -> String {
+        let magicWordsReplaced = replacingMatches(in: string, fromRegex: curlyBraceRegex, withFormat: "%@")
+        return replacingMatches(in: magicWordsReplaced, fromTokenRegex: twnTokenRegex, withFormat: "%%%@$%@", tokens: tokens)
+    }
+
+    static func iOSTokenDictionary(_ string: String) -> [String: String] {
+        var tokenDictionary = [String: String]()
+        iOSTokenRegex.enumerateMatches(in: string, options: [], range: string.fullRange, using: { (result, flags, stop) in
+            guard let result = result else {
+                return
+            }
+            var number = iOSTokenRegex.replacementString(for: result, in: string, offset: 0, template: "$1")
+            if number == "" {
+                number = "1"
+            }
+            let token = iOSTokenRegex.replacementString(for: result, in: string, offset: 0, template: "$2")
+            if tokenDictionary[number] == nil {
+                tokenDictionary[number] = token
+            }
+        })
+        return tokenDictionary
+    }
+
+    private static func writeStrings(fromDictionary dictionary: NSDictionary, toFile: String) throws {
+        var shouldWrite = true
+
+        if let existingDictionary = NSDictionary(contentsOfFile: toFile) {
+            shouldWrite = existingDictionary.count != dictionary.count
+            if !shouldWrite {
+                for (key, value) in dictionary {
+                    guard let value = value as? String, let existingValue = existingDictionary[key] as? NSString else {
+                        shouldWrite = true
+                        break
+                    }
+                    shouldWrite = !existingValue.isEqual(to: value)
+                    if shouldWrite {
+                        break
+                    }
+                }
+            }
+        }
+
+        guard shouldWrite else {
+            return
+        }
+
+        let folder = (toFile as NSString).deletingLastPathComponent
+        try? FileManager.default.createDirectory(atPath: folder, withIntermediateDirectories: true, attributes: nil)
+        try dictionary.descriptionInStringsFileFormat.write(toFile: toFile, atomically: true, encoding: .utf16)
+    }
+
+    private static func writeFastlaneMetadata(_ metadata: Any?, to filename: String, for locale: String, in path: String) throws {
+        let metadataFileURL = fileURLForFastlaneMetadataFile(filename, for: locale, in: path)
+        guard let metadata = metadata as? String, metadata.count > 0 else {
+            let defaultDescriptionFileURL = fileURLForFastlaneMetadataFile(filename, for: defaultAppStoreMetadataLocale, in: path)
+            let fm = FileManager.default
+            try fm.removeItem(at: metadataFileURL)
+            try fm.copyItem(at: defaultDescriptionFileURL, to: metadataFileURL)
+            return
+        }
+        try metadata.write(to: metadataFileURL, atomically: true, encoding: .utf8)
+    }
+
+    static func importLocalizationsFromTWN(_ path: String, availableLocales: Set<String>) {
+        let enPath = "\(path)/Wikipedia/iOS Native Localizations/en.lproj/Localizable.strings"
+
+        guard let enDictionary = NSDictionary(contentsOfFile: enPath) as? [String: String] else {
+            XCTFail("Unable to read \(enPath)")
+            return
+        }
+
+        var enTokensByKey = [String: [String: String]]()
+
+        for (key, value) in enDictionary {
+            enTokensByKey[key] = iOSTokenDictionary(value)
+        }
+
+        let fm = FileManager.default
+        do {
+            let keysByLanguage = ["pl": ["one", "few"], "sr": ["one", "few", "many"], "ru": ["one", "few", "many"]]
+            let defaultKeys = ["one"]
+            let appStoreMetadataLocales: [String: [String]] = [
+                "da": ["da"],
+                "de": ["de-de"],
+                "el": ["el"],
+                "es": ["es-mx", "es-es"],
+                "fi": ["fi"],
+                "fr": ["fr-ca", "fr-fr"],
+                "id": ["id"],
+                "it": ["it"],
+                "ja": ["ja"],
+                "ko": ["ko"],
+                "ms": ["ms"],
+                "nl": ["nl-nl"],
+                "no": ["no"],
+                "pt": ["pt-br", "pt-pt"],
+                "ru": ["ru"],
+                "sv": ["sv"],
+                "th": ["th"],
+                "tr": ["tr"],
+                "vi": ["vi"],
+                "zh-hans": ["zh-hans"],
+                "zh-hant": ["zh-hant"]
+            ]
+
+            let contents = try fm.contentsOfDirectory(atPath: "\(path)/Wikipedia/Localizations")
+            var pathsForEnglishPlurals: [String] = []
+            var englishPluralDictionary: NSMutableDictionary?
+            for filename in contents {
+                guard let locale = filename.components(separatedBy: ".").first?.lowercased() else {
+                    continue
+                }
+
+                let localeFolder = "\(path)/Wikipedia/iOS Native Localizations/\(locale).lproj"
+
+                guard localeIsAvailable(locale, in: availableLocales), let twnStrings = NSDictionary(contentsOfFile: "\(path)/Wikipedia/Localizations/\(locale).lproj/Localizable.strings") else {
+                    try? fm.removeItem(atPath: localeFolder)
+                    continue
+                }
+
+                let stringsDictFilePath = "\(localeFolder)/Localizable.stringsdict"
+                let stringsFilePath = "\(localeFolder)/Localizable.strings"
+
+                let stringsDict = NSMutableDictionary(capacity: twnStrings.count)
+                let strings = NSMutableDictionary(capacity: twnStrings.count)
+                for (key, value) in twnStrings {
+                    guard let twnString = value as? String, let key = key as? String, let enTokens = enTokensByKey[key] else {
+                        continue
+                    }
+                    let nativeLocalization = iOSNativeLocalization(twnString, tokens: enTokens)
+                    let nativeLocalizationTokens = iOSTokenDictionary(nativeLocalization)
+                    guard nativeLocalizationTokens == enTokens else {
+                        continue
+                    }
+                    if twnString.contains("{{PLURAL:") {
+                        let lang = locale.components(separatedBy: "-").first ?? ""
+                        let keys = keysByLanguage[lang] ?? defaultKeys
+                        let supportsOneEquals = !localesWhereMediaWikiPluralRulesDoNotMatchiOSPluralRulesForOne.contains(lang)
+                        stringsDict[key] = twnString.pluralDictionary(with: keys, tokens:enTokens, supportsOneEquals: supportsOneEquals)
+                        strings[key] = nativeLocalization
+                    } else {
+                        strings[key] = nativeLocalization
+                    }
+                }
+                if locale != "en" {
+                    if strings.count > 0 {
+                        try writeStrings(fromDictionary: strings, toFile: stringsFilePath)
+                    } else {
+                        try? fm.removeItem(atPath: stringsFilePath)
+                    }
+                } else {
+                    englishPluralDictionary = stringsDict
+                }
+
+                if let metadataLocales = appStoreMetadataLocales[locale] {
+                    for metadataLocale in metadataLocales {
+                        let folderURL = fileURLForFastlaneMetadataFolder(for: metadataLocale, in: path)
+                        try fm.createDirectory(at: folderURL, withIntermediateDirectories: true, attributes: nil)
+
+                        let infoPlistPath = "\(path)/Wikipedia/iOS Native Localizations/\(locale).lproj/InfoPlist.strings"
+                        let infoPlist = NSDictionary(contentsOfFile: infoPlistPath)
+
+                        try? writeFastlaneMetadata(strings["app-store-short-description"], to: "description.txt", for: metadataLocale, in: path)
+                        try? writeFastlaneMetadata(strings["app-store-keywords"], to: "keywords.txt", for: metadataLocale, in: path)
+                        try? writeFastlaneMetadata(nil, to: "marketing_url.txt", for: metadataLocale, in: path)
+                        try? writeFastlaneMetadata(infoPlist?["CFBundleDisplayName"], to: "name.txt", for: metadataLocale, in: path)
+                        try? writeFastlaneMetadata(nil, to: "privacy_url.txt", for: metadataLocale, in: path)
+                        try? writeFastlaneMetadata(nil, to: "promotional_text.txt", for: metadataLocale, in: path)
+                        try? writeFastlaneMetadata(nil, to: "release_notes.txt", for: metadataLocale, in: path)
+                        try? writeFastlaneMetadata(strings["app-store-subtitle"], to: "subtitle.txt", for: metadataLocale, in: path)
+                        try? writeFastlaneMetadata(nil, to: "support_url.txt", for: metadataLocale, in: path)
+                    }
+                } else {
+                    let folderURL = fileURLForFastlaneMetadataFolder(for: locale, in: path)
+                    try? fm.removeItem(at: folderURL)
+                }
+
+                if stringsDict.count > 0 {
+                    stringsDict.write(toFile: stringsDictFilePath, atomically: true)
+                } else {
+                    pathsForEnglishPlurals.append(stringsDictFilePath)
+                }
+            }
+
+            for stringsDictFilePath in pathsForEnglishPlurals {
+                englishPluralDictionary?.write(toFile: stringsDictFilePath, atomically: true)
+            }
+        } catch let error {
+            XCTFail("Error importing localizations: \(error)")
+        }
+    }
+}
@@ -11,25 +11,6 @@ fileprivate var dictionaryRegex: NSRegularExpression? = {
     return nil
 }()
 
-fileprivate var curlyBraceRegex: NSRegularExpression? = {
-    do {
-        return try NSRegularExpression(pattern: "(?:[{][{][a-z]+:)(:?[^{]*)(?:[}][}])", options: [.caseInsensitive])
-    } catch {
-        assertionFailure("Localization regex failed to compile")
-    }
-    return nil
-}()
-
-
-fileprivate var twnTokenRegex: NSRegularExpression? = {
-    do {
-        return try NSRegularExpression(pattern: "(?:[$])(:?[0-9]+)", options: [])
-    } catch {
-        assertionFailure("Localization token regex failed to compile")
-    }
-    return nil
-}()
-
 fileprivate var iOSTokenRegex: NSRegularExpression? = {
     do {
         return try NSRegularExpression(pattern: "%([0-9]*)\\$?([@dDuUxXoOfeEgGcCsSpaAF])", options: [])
@@ -233,86 +214,49 @@ extension String {
         return nativeLocalization as String
     }
     
-    public func replacingMatches(fromTokenRegex regex: NSRegularExpression, withFormat format: String, tokens: [String: String]) -> String {
-        let nativeLocalization = NSMutableString(string: self)
-        var offset = 0
-        let fullRange = NSRange(location: 0, length: nativeLocalization.length)
-        regex.enumerateMatches(in: self, options: [], range: fullRange) { (result, flags, stop) in
-            guard let result = result else {
-                return
-            }
-            let token = regex.replacementString(for: result, in: nativeLocalization as String, offset: offset, template: "$1")
-            let replacement = String(format: format, token, tokens[token] ?? "@")
-            let replacementRange = NSRange(location: result.range.location + offset, length: result.range.length)
-            nativeLocalization.replaceCharacters(in: replacementRange, with: replacement)
-            offset += (replacement as NSString).length - result.range.length
-        }
-        return nativeLocalization as String
-    }
-    
-    func iOSNativeLocalization(tokens: [String: String]) -> String {
-        guard let tokenRegex = twnTokenRegex, let braceRegex = curlyBraceRegex else {
-            return ""
-        }
-        return self.replacingMatches(fromRegex: braceRegex, withFormat: "%@").replacingMatches(fromTokenRegex: tokenRegex, withFormat: "%%%@$%@", tokens: tokens)
-    }
-    
     var twnNativeLocalization: String {
         guard let tokenRegex = iOSTokenRegex else {
             return ""
         }
         return self.replacingMatches(fromRegex: tokenRegex, withFormat: "$%@")
     }
-    
-    var iOSTokenDictionary: [String: String] {
-        guard let iOSTokenRegex = iOSTokenRegex else {
-            print("Unable to compile iOS token regex")
-            abort()
-        }
-        var tokenDictionary = [String:String]()
-        iOSTokenRegex.enumerateMatches(in: self, options: [], range:self.fullRange, using: { (result, flags, stop) in
-            guard let result = result else {
-                return
-            }
-            var number = iOSTokenRegex.replacementString(for: result, in: self as String, offset: 0, template: "$1")
-            // treat an un-numbered token as 1
-            if number == "" {
-                number = "1"
-            }
-            let token = iOSTokenRegex.replacementString(for: result, in: self as String, offset: 0, template: "$2")
-            if tokenDictionary[number] == nil {
-                tokenDictionary[number] = token
-            } else if token != tokenDictionary[number] {
-                print("Internal token mismatch: \(self)")
-                abort()
-            }
-        })
-        return tokenDictionary
+}
+
+/// Keys added, removed and changed when a strings file is rewritten
+struct StringsDiff {
+    var added = 0
+    var removed = 0
+    var changed = 0
+
+    var isEmpty: Bool {
+        return added == 0 && removed == 0 && changed == 0
     }
 }
 
-func writeStrings(fromDictionary dictionary: NSDictionary, toFile: String) throws {
-    var shouldWrite = true
+@discardableResult
+func writeStrings(fromDictionary dictionary: NSDictionary, toFile: String) throws -> StringsDiff {
+    var diff = StringsDiff()
     
     if let existingDictionary = NSDictionary(contentsOfFile: toFile) {
-        shouldWrite = existingDictionary.count != dictionary.count
-        if !shouldWrite {
-            for (key, value) in dictionary {
-                guard let value = value as? String, let existingValue = existingDictionary[key] as? NSString else {
-                    shouldWrite = true
-                    break
-                }
-                shouldWrite = !existingValue.isEqual(to: value)
-                if shouldWrite {
-                    break
-                }
+        for (key, value) in dictionary {
+            guard let existingValue = existingDictionary[key] else {
+                diff.added += 1
+                continue
             }
+            guard let value = value as? String, let existingValue = existingValue as? NSString, existingValue.isEqual(to: value) else {
+                diff.changed += 1
+                continue
+            }
+        }
+        for key in existingDictionary.allKeys where dictionary[key] == nil {
+            diff.removed += 1
         }
+    } else {
+        diff.added = dictionary.count
     }
     
-    
-    guard shouldWrite else {
-        return
+    guard !diff.isEmpty else {
+        return diff
     }
     
     let folder = (toFile as NSString).deletingLastPathComponent
@@ -321,27 +265,44 @@ func writeStrings(fromDictionary dictionary: NSDictionary, toFile: String) throw
     } catch { }
     let output = dictionary.descriptionInStringsFileFormat
     try output.write(toFile: toFile, atomically: true, encoding: .utf16) // From Apple: Note: It is recommended that you save strings files using the UTF-16 encoding, which is the default encoding for standard strings files. It is possible to create strings files using other property-list formats, including binary property-list formats and XML formats that use the UTF-8 encoding, but doing so is not recommended. For more information about Unicode and its text encodings, go to http://www.unicode.org/ or http://en.wikipedia.org/wiki/Unicode.
+    return diff
+}
+
+/// Writes a stringsdict unless the file already has the same contents. Returns whether it was written.
+@discardableResult
+func writeStringsDict(_ dictionary: NSDictionary, toFile: String) -> Bool {
+    if let existingDictionary = NSDictionary(contentsOfFile: toFile), existingDictionary.isEqual(dictionary) {
+        return false
+    }
+    return dictionary.write(toFile: toFile, atomically: true)
 }
 
 // See "Localized Metadata" section here: https://docs.fastlane.tools/actions/deliver/
-func fileURLForFastlaneMetadataFolder(for locale: String) -> URL {
+func fileURLForFastlaneMetadataFolder(for locale: String, in path: String) -> URL {
     return URL(fileURLWithPath:"\(path)/fastlane/metadata/\(locale)")
 }
 
-func fileURLForFastlaneMetadataFile(_ file: String, for locale: String) -> URL {
-    return fileURLForFastlaneMetadataFolder(for: locale).appendingPathComponent(file)
+func fileURLForFastlaneMetadataFile(_ file: String, for locale: String, in path: String) -> URL {
+    return fileURLForFastlaneMetadataFolder(for: locale, in: path).appendingPathComponent(file)
 }
 
 let defaultAppStoreMetadataLocale = "en-us"
-func writeFastlaneMetadata(_ metadata: Any?, to filename: String, for locale: String) throws {
-    let metadataFileURL = fileURLForFastlaneMetadataFile(filename, for: locale)
+func writeFastlaneMetadata(_ metadata: Any?, to filename: String, for locale: String, in path: String) throws {
+    let metadataFileURL = fileURLForFastlaneMetadataFile(filename, for: locale, in: path)
+    let existingData = try? Data(contentsOf: metadataFileURL)
     guard let metadata = metadata as? String, metadata.count > 0 else {
-        let defaultDescriptionFileURL = fileURLForFastlaneMetadataFile(filename, for: defaultAppStoreMetadataLocale)
+        let defaultDescriptionFileURL = fileURLForFastlaneMetadataFile(filename, for: defaultAppStoreMetadataLocale, in: path)
+        guard existingData == nil || existingData != (try? Data(contentsOf: defaultDescriptionFileURL)) else {
+            return
+        }
         let fm = FileManager.default
         try fm.removeItem(at: metadataFileURL)
         try fm.copyItem(at: defaultDescriptionFileURL, to: metadataFileURL)
         return
     }
+    guard existingData != metadata.data(using: .utf8) else {
+        return
+    }
     try metadata.write(to: metadataFileURL, atomically: true, encoding: .utf8)
 }
 
@@ -412,7 +373,8 @@ func exportLocalizationsFromSourceCode(_ path: String) {
     }
 }
 
-let locales: Set<String> =  {
+/// Locales iOS supports, plus any the app already has native localizations for
+func availableLocales(in path: String) -> Set<String> {
     var identifiers = Locale.availableIdentifiers
     if let filenames = try? FileManager.default.contentsOfDirectory(atPath: "\(path)/Wikipedia/iOS Native Localizations") {
         let additional = filenames.compactMap { $0.components(separatedBy: ".").first?.lowercased() }
@@ -420,154 +382,15 @@ let locales: Set<String> =  {
     }
     identifiers += ["ku"] // iOS 13 added support for ku but macOS 10.14 doesn't include it, add it manually. This line can be removed when macOS 10.15 ships.
     return Set<String>(identifiers)
-}()
+}
 
 // See supportsOneEquals documentation. Utilized this list: https://unicode-org.github.io/cldr-staging/charts/37/supplemental/language_plural_rules.html to verify languages where that applies for the cardinal -> one rule
-let localesWhereMediaWikiPluralRulesDoNotMatchiOSPluralRulesForOne = {
-    return Set<String>(["be", "bs", "br", "ceb", "tzm", "hr", "fil", "is", "lv", "lt", "dsb", "mk", "gv", "prg", "ru", "gd", "sr", "sl", "uk", "hsb"]).intersection(locales)
-}()
+// Only checked for available locales, so this doesn't need to be limited to them
+let localesWhereMediaWikiPluralRulesDoNotMatchiOSPluralRulesForOne = Set<String>(["be", "bs", "br", "ceb", "tzm", "hr", "fil", "is", "lv", "lt", "dsb", "mk", "gv", "prg", "ru", "gd", "sr", "sl", "uk", "hsb"])
 
-func localeIsAvailable(_ locale: String) -> Bool {
+func localeIsAvailable(_ locale: String, in availableLocales: Set<String>) -> Bool {
     let prefix = locale.components(separatedBy: "-").first ?? locale
-    return locales.contains(prefix)
-}
-
-func importLocalizationsFromTWN(_ path: String) {
-    let enPath = "\(path)/Wikipedia/iOS Native Localizations/en.lproj/Localizable.strings"
-    
-    guard let enDictionary = NSDictionary(contentsOfFile: enPath) as? [String: String] else {
-        print("Unable to read \(enPath)")
-        abort()
-    }
-    
-    var enTokensByKey = [String: [String: String]]()
-    
-    for (key, value) in enDictionary {
-        enTokensByKey[key] = value.iOSTokenDictionary
-    }
-    
-    let fm = FileManager.default
-    do {
-        let keysByLanguage = ["pl": ["one", "few"], "sr": ["one", "few", "many"], "ru": ["one", "few", "many"]]
-        let defaultKeys = ["one"]
-        let appStoreMetadataLocales: [String: [String]] = [
-            "da": ["da"],
-            "de": ["de-de"],
-            "el": ["el"],
-            // "en": ["en-au", "en-ca", "en-gb"],
-            "es": ["es-mx", "es-es"],
-            "fi": ["fi"],
-            "fr": ["fr-ca", "fr-fr"],
-            "id": ["id"],
-            "it": ["it"],
-            "ja": ["ja"],
-            "ko": ["ko"],
-            "ms": ["ms"],
-            "nl": ["nl-nl"],
-            "no": ["no"],
-            "pt": ["pt-br", "pt-pt"],
-            "ru": ["ru"],
-            "sv": ["sv"],
-            "th": ["th"],
-            "tr": ["tr"],
-            "vi": ["vi"],
-            "zh-hans": ["zh-hans"],
-            "zh-hant": ["zh-hant"]
-        ]
-        
-        let contents = try fm.contentsOfDirectory(atPath: "\(path)/Wikipedia/Localizations")
-        var pathsForEnglishPlurals: [String] = [] // write english plurals to these paths as placeholders
-        var englishPluralDictionary: NSMutableDictionary?
-        for filename in contents {
-            guard let locale = filename.components(separatedBy: ".").first?.lowercased() else {
-                continue
-            }
-            
-            let localeFolder = "\(path)/Wikipedia/iOS Native Localizations/\(locale).lproj"
-
-            guard localeIsAvailable(locale), let twnStrings = NSDictionary(contentsOfFile: "\(path)/Wikipedia/Localizations/\(locale).lproj/Localizable.strings") else {
-                try? fm.removeItem(atPath: localeFolder)
-                continue
-            }
-            
-            let stringsDictFilePath = "\(localeFolder)/Localizable.stringsdict"
-            let stringsFilePath = "\(localeFolder)/Localizable.strings"
-            
-            let stringsDict = NSMutableDictionary(capacity: twnStrings.count)
-            let strings = NSMutableDictionary(capacity: twnStrings.count)
-            for (key, value) in twnStrings {
-                guard let twnString = value as? String, let key = key as? String, let enTokens = enTokensByKey[key] else {
-                    continue
-                }
-                let nativeLocalization = twnString.iOSNativeLocalization(tokens: enTokens)
-                let nativeLocalizationTokens = nativeLocalization.iOSTokenDictionary
-                guard nativeLocalizationTokens == enTokens else {
-                    #if DEBUG
-                    print("Mismatched tokens in \(locale) for \(key):\n\(enDictionary[key] ?? "")\n\(nativeLocalization)")
-                    #endif
-                    continue
-                }
-                if twnString.contains("{{PLURAL:") {
-                    let lang = locale.components(separatedBy: "-").first ?? ""
-                    let keys = keysByLanguage[lang] ?? defaultKeys
-                    let supportsOneEquals = !localesWhereMediaWikiPluralRulesDoNotMatchiOSPluralRulesForOne.contains(lang)
-                    stringsDict[key] = twnString.pluralDictionary(with: keys, tokens:enTokens, supportsOneEquals: supportsOneEquals)
-                    strings[key] = nativeLocalization
-                } else {
-                    strings[key] = nativeLocalization
-                }
-            }
-            if locale != "en" { // only write the english plurals, skip the main file
-                if strings.count > 0 {
-                    try writeStrings(fromDictionary: strings, toFile: stringsFilePath)
-                } else {
-                    try? fm.removeItem(atPath: stringsFilePath)
-                }
-            } else {
-                englishPluralDictionary = stringsDict
-            }
-            
-           
-            if let metadataLocales = appStoreMetadataLocales[locale] {
-                for metadataLocale in metadataLocales {
-                    let folderURL = fileURLForFastlaneMetadataFolder(for: metadataLocale)
-                    try fm.createDirectory(at: folderURL, withIntermediateDirectories: true, attributes: nil)
-                    
-                    let infoPlistPath = "\(path)/Wikipedia/iOS Native Localizations/\(locale).lproj/InfoPlist.strings"
-                    let infoPlist = NSDictionary(contentsOfFile: infoPlistPath)
-                    
-                    try? writeFastlaneMetadata(strings["app-store-short-description"], to: "description.txt", for: metadataLocale)
-                    try? writeFastlaneMetadata(strings["app-store-keywords"], to: "keywords.txt", for: metadataLocale)
-                    try? writeFastlaneMetadata(nil, to: "marketing_url.txt", for: metadataLocale) // use nil to copy from en-US. all fields need to be specified.
-                    try? writeFastlaneMetadata(infoPlist?["CFBundleDisplayName"], to: "name.txt", for: metadataLocale)
-                    try? writeFastlaneMetadata(nil, to: "privacy_url.txt", for: metadataLocale) // use nil to copy from en-US. all fields need to be specified.
-                    try? writeFastlaneMetadata(nil, to: "promotional_text.txt", for: metadataLocale) // use nil to copy from en-US. all fields need to be specified.
-                    try? writeFastlaneMetadata(nil, to: "release_notes.txt", for: metadataLocale) // use nil to copy from en-US. all fields need to be specified.
-                    try? writeFastlaneMetadata(strings["app-store-subtitle"], to: "subtitle.txt", for: metadataLocale)
-                    try? writeFastlaneMetadata(nil, to: "support_url.txt", for: metadataLocale) // use nil to copy from en-US. all fields need to be specified.
-                }
-            
-            } else {
-                let folderURL = fileURLForFastlaneMetadataFolder(for: locale)
-                try? fm.removeItem(at: folderURL)
-            }
-            
-            if stringsDict.count > 0 {
-                stringsDict.write(toFile: stringsDictFilePath, atomically: true)
-            } else {
-                pathsForEnglishPlurals.append(stringsDictFilePath)
-            }
-            
-        }
-        
-        for stringsDictFilePath in pathsForEnglishPlurals {
-            englishPluralDictionary?.write(toFile: stringsDictFilePath, atomically: true)
-        }
-        
-    } catch let error {
-        print("Error importing localizations: \(error)")
-        abort()
-    }
+    return availableLocales.contains(prefix)
 }
 
 // Code that updated source translations
@@ -0,0 +1,379 @@
+import Foundation
+import CryptoKit
+
+/// **THIS IS NOT PART OF THE MAIN APP - IT'S A COMMAND LINE UTILITY**
+
+fileprivate let keysByLanguage = ["pl": ["one", "few"], "sr": ["one", "few", "many"], "ru": ["one", "few", "many"]]
+fileprivate let defaultKeys = ["one"]
+fileprivate let appStoreMetadataLocales: [String: [String]] = [
+    "da": ["da"],
+    "de": ["de-de"],
+    "el": ["el"],
+    // "en": ["en-au", "en-ca", "en-gb"],
+    "es": ["es-mx", "es-es"],
+    "fi": ["fi"],
+    "fr": ["fr-ca", "fr-fr"],
+    "id": ["id"],
+    "it": ["it"],
+    "ja": ["ja"],
+    "ko": ["ko"],
+    "ms": ["ms"],
+    "nl": ["nl-nl"],
+    "no": ["no"],
+    "pt": ["pt-br", "pt-pt"],
+    "ru": ["ru"],
+    "sv": ["sv"],
+    "th": ["th"],
+    "tr": ["tr"],
+    "vi": ["vi"],
+    "zh-hans": ["zh-hans"],
+    "zh-hant": ["zh-hant"]
+]
+fileprivate let fastlaneMetadataFilenames = ["description.txt", "keywords.txt", "marketing_url.txt", "name.txt", "privacy_url.txt", "promotional_text.txt", "release_notes.txt", "subtitle.txt", "support_url.txt"]
+
+// MARK: - Report
+
+struct LocaleImportReport {
+    enum Outcome {
+        case imported
+        case unchanged
+        case removed
+    }
+
+    let locale: String
+    var outcome: Outcome
+    var duration: TimeInterval = 0
+    var stringCount = 0
+    var pluralCount = 0
+    var stringsDiff = StringsDiff()
+    var wroteStringsDict = false
+
+    var summary: String {
+        let milliseconds = String(format: "%.1f ms", duration * 1000)
+        switch outcome {
+        case .removed:
+            return "\(locale): not available, removed (\(milliseconds))"
+        case .unchanged:
+            return "\(locale): unchanged since last import (\(milliseconds))"
+        case .imported:
+            let stringsDictSummary = wroteStringsDict ? "stringsdict written" : "stringsdict unchanged"
+            return "\(locale): \(stringCount) strings (+\(stringsDiff.added) -\(stringsDiff.removed) ~\(stringsDiff.changed)), \(pluralCount) plurals, \(stringsDictSummary) (\(milliseconds))"
+        }
+    }
+}
+
+struct LocalizationImportReport {
+    var locales: [LocaleImportReport]
+    var duration: TimeInterval
+
+    func printSummary() {
+        for report in locales.sorted(by: { $0.locale < $1.locale }) {
+            print(report.summary)
+        }
+        let importedCount = locales.filter { $0.outcome == .imported }.count
+        let unchangedCount = locales.filter { $0.outcome == .unchanged }.count
+        print(String(format: "Imported %d locales, skipped %d unchanged locales in %.2fs", importedCount, unchangedCount, duration))
+    }
+}
+
+// MARK: - Manifest
+
+/// Hashes of each locale's inputs, and of the files imported from them, as of the last import.
+/// A locale is skipped when its inputs are unchanged and its files still have the contents the import left them with.
+struct LocalizationImportManifest: Codable {
+    // Bump when the import's output changes so every locale is imported again
+    static let currentVersion = 1
+
+    struct Entry: Codable {
+        var inputHash: String
+        // Keyed by path relative to the repo
+        var outputHashes: [String: String]
+    }
+
+    var version = currentVersion
+    var entries: [String: Entry] = [:]
+
+    static func load(from url: URL) -> LocalizationImportManifest {
+        guard let data = try? Data(contentsOf: url),
+              let manifest = try? JSONDecoder().decode(LocalizationImportManifest.self, from: data),
+              manifest.version == currentVersion else {
+            return LocalizationImportManifest()
+        }
+        return manifest
+    }
+
+    func write(to url: URL) throws {
+        try FileManager.default.createDirectory(at: url.deletingLastPathComponent(), withIntermediateDirectories: true, attributes: nil)
+        let encoder = JSONEncoder()
+        encoder.outputFormatting = [.prettyPrinted, .sortedKeys]
+        try encoder.encode(self).write(to: url, options: .atomic)
+    }
+
+    /// Kept out of the repo in the user's caches, one per checkout
+    static func defaultURL(for path: String) -> URL {
+        let cachesURL = FileManager.default.urls(for: .cachesDirectory, in: .userDomainMask).first ?? URL(fileURLWithPath: NSTemporaryDirectory())
+        let pathHash = contentHash(of: Data(URL(fileURLWithPath: path).standardizedFileURL.path.utf8))
+        return cachesURL.appendingPathComponent("org.wikimedia.localization").appendingPathComponent("import-manifest-\(pathHash.prefix(16)).json")
+    }
+}
+
+fileprivate func contentHash(of data: Data?) -> String {
+    guard let data else {
+        return "missing"
+    }
+    return SHA256.hash(data: data).map { String(format: "%02x", $0) }.joined()
+}
+
+fileprivate func contentHash(of parts: [Data?]) -> String {
+    var hasher = SHA256()
+    for part in parts {
+        let partHash = contentHash(of: part)
+        hasher.update(data: Data(partHash.utf8))
+    }
+    return hasher.finalize().map { String(format: "%02x", $0) }.joined()
+}
+
+// MARK: - Import
+
+/// Everything a locale's import reads that isn't specific to the locale
+fileprivate struct LocaleImportContext {
+    let path: String
+    let availableLocales: Set<String>
+    let enTokensByKey: [String: [String: String]]
+    let sharedInputHash: String
+    let manifest: LocalizationImportManifest
+}
+
+/// App Store metadata for a locale's metadata folders, written after every locale is imported
+fileprivate struct FastlaneMetadata {
+    let metadataLocales: [String]
+    let description: Any?
+    let keywords: Any?
+    let name: Any?
+    let subtitle: Any?
+}
+
+fileprivate struct LocaleImportResult {
+    var report: LocaleImportReport
+    var manifestEntry: LocalizationImportManifest.Entry?
+    var stringsDict: NSDictionary?
+    var fastlaneMetadata: FastlaneMetadata?
+    var removesFastlaneMetadataFolder = false
+    /// Inputs and outputs to hash into the manifest entry once metadata is written
+    var inputHash: String?
+    var outputPaths: [String] = []
+}
+
+/// Converts every locale's TWN strings into iOS strings and stringsdict files, and App Store metadata.
+/// English is imported first, since its plurals are placeholders for locales without plurals, then the other locales are imported concurrently.
+/// App Store metadata is written afterwards in one pass, since locales share metadata folders, like pt-br written by pt.
+/// Files are only written when their contents change, and locales whose inputs haven't changed since the last import are skipped.
+@discardableResult
+func importLocalizationsFromTWN(_ path: String, availableLocales locales: Set<String>? = nil, manifestURL: URL? = nil) -> LocalizationImportReport {
+    let start = CFAbsoluteTimeGetCurrent()
+    let enPath = "\(path)/Wikipedia/iOS Native Localizations/en.lproj/Localizable.strings"
+    let twnENPath = "\(path)/Wikipedia/Localizations/en.lproj/Localizable.strings"
+
+    guard let enDictionary = NSDictionary(contentsOfFile: enPath) as? [String: String] else {
+        print("Unable to read \(enPath)")
+        abort()
+    }
+
+    var enTokensByKey = [String: [String: String]]()
+
+    for (key, value) in enDictionary {
+        enTokensByKey[key] = value.iOSTokenDictionary
+    }
+
+    let fm = FileManager.default
+    let manifestURL = manifestURL ?? LocalizationImportManifest.defaultURL(for: path)
+    let manifest = LocalizationImportManifest.load(from: manifestURL)
+
+    let defaultMetadataData = fastlaneMetadataFilenames.map { fm.contents(atPath: fileURLForFastlaneMetadataFile($0, for: defaultAppStoreMetadataLocale, in: path).path) }
+    let sharedInputHash = contentHash(of: [Data("\(LocalizationImportManifest.currentVersion)".utf8), fm.contents(atPath: enPath), fm.contents(atPath: twnENPath)] + defaultMetadataData)
+
+    let context = LocaleImportContext(path: path, availableLocales: locales ?? availableLocales(in: path), enTokensByKey: enTokensByKey, sharedInputHash: sharedInputHash, manifest: manifest)
+
+    do {
+        let contents = try fm.contentsOfDirectory(atPath: "\(path)/Wikipedia/Localizations")
+        let twnLocales = contents.compactMap { $0.components(separatedBy: ".").first?.lowercased() }
+
+        var results: [LocaleImportResult] = []
+        var englishPluralDictionary: NSDictionary?
+        if twnLocales.contains("en") {
+            let result = try importLocale("en", context: context, englishPluralDictionary: nil)
+            englishPluralDictionary = result.stringsDict
+            results.append(result)
+        }
+
+        let otherLocales = twnLocales.filter { $0 != "en" }
+        var otherResults = [Result<LocaleImportResult, Error>?](repeating: nil, count: otherLocales.count)
+        let resultsLock = NSLock()
+        DispatchQueue.concurrentPerform(iterations: otherLocales.count) { (index) in
+            let result = Result { try importLocale(otherLocales[index], context: context, englishPluralDictionary: englishPluralDictionary) }
+            resultsLock.lock()
+            otherResults[index] = result
+            resultsLock.unlock()
+        }
+        for result in otherResults {
+            guard let result else {
+                continue
+            }
+            results.append(try result.get())
+        }
+
+        try applyFastlaneMetadata(to: &results, in: path)
+
+        var updatedManifest = LocalizationImportManifest()
+        for result in results {
+            updatedManifest.entries[result.report.locale] = result.manifestEntry
+        }
+        do {
+            try updatedManifest.write(to: manifestURL)
+        } catch let error {
+            print("Unable to write import manifest, the next import won't skip unchanged locales: \(error)")
+        }
+
+        return LocalizationImportReport(locales: results.map { $0.report }, duration: CFAbsoluteTimeGetCurrent() - start)
+    } catch let error {
+        print("Error importing localizations: \(error)")
+        abort()
+    }
+}
+
+fileprivate func importLocale(_ locale: String, context: LocaleImportContext, englishPluralDictionary: NSDictionary?) throws -> LocaleImportResult {
+    let start = CFAbsoluteTimeGetCurrent()
+    let fm = FileManager.default
+    let path = context.path
+    let localeFolder = "\(path)/Wikipedia/iOS Native Localizations/\(locale).lproj"
+    let twnPath = "\(path)/Wikipedia/Localizations/\(locale).lproj/Localizable.strings"
+
+    guard localeIsAvailable(locale, in: context.availableLocales), let twnStrings = NSDictionary(contentsOfFile: twnPath) else {
+        try? fm.removeItem(atPath: localeFolder)
+        return LocaleImportResult(report: LocaleImportReport(locale: locale, outcome: .removed, duration: CFAbsoluteTimeGetCurrent() - start))
+    }
+
+    let stringsDictFilePath = "\(localeFolder)/Localizable.stringsdict"
+    let stringsFilePath = "\(localeFolder)/Localizable.strings"
+    let infoPlistPath = "\(localeFolder)/InfoPlist.strings"
+    let metadataLocales = appStoreMetadataLocales[locale]
+
+    var outputPaths = [stringsDictFilePath]
+    if locale != "en" {
+        outputPaths.append(stringsFilePath)
+    }
+    for metadataLocale in metadataLocales ?? [] {
+        outputPaths += fastlaneMetadataFilenames.map { fileURLForFastlaneMetadataFile($0, for: metadataLocale, in: path).path }
+    }
+
+    let inputHash = contentHash(of: [Data(context.sharedInputHash.utf8), fm.contents(atPath: twnPath), metadataLocales != nil ? fm.contents(atPath: infoPlistPath) : nil])
+
+    // English is always imported since its plurals are needed for other locales
+    if locale != "en",
+       let entry = context.manifest.entries[locale],
+       entry.inputHash == inputHash,
+       entry.outputHashes == outputHashes(of: outputPaths, in: path) {
+        return LocaleImportResult(report: LocaleImportReport(locale: locale, outcome: .unchanged, duration: CFAbsoluteTimeGetCurrent() - start), manifestEntry: entry, removesFastlaneMetadataFolder: metadataLocales == nil)
+    }
+
+    var report = LocaleImportReport(locale: locale, outcome: .imported)
+    let stringsDict = NSMutableDictionary(capacity: twnStrings.count)
+    let strings = NSMutableDictionary(capacity: twnStrings.count)
+    for (key, value) in twnStrings {
+        guard let twnString = value as? String, let key = key as? String, let enTokens = context.enTokensByKey[key] else {
+            continue
+        }
+        let nativeLocalization = twnString.iOSNativeLocalization(tokens: enTokens)
+        let nativeLocalizationTokens = nativeLocalization.iOSTokenDictionary
+        guard nativeLocalizationTokens == enTokens else {
+            #if DEBUG
+            print("Mismatched tokens in \(locale) for \(key):\n\(nativeLocalization)")
+            #endif
+            continue
+        }
+        if twnString.contains("{{PLURAL:") {
+            let lang = locale.components(separatedBy: "-").first ?? ""
+            let keys = keysByLanguage[lang] ?? defaultKeys
+            let supportsOneEquals = !localesWhereMediaWikiPluralRulesDoNotMatchiOSPluralRulesForOne.contains(lang)
+            stringsDict[key] = twnString.pluralDictionary(with: keys, tokens:enTokens, supportsOneEquals: supportsOneEquals)
+            strings[key] = nativeLocalization
+        } else {
+            strings[key] = nativeLocalization
+        }
+    }
+    report.stringCount = strings.count
+    report.pluralCount = stringsDict.count
+
+    if locale != "en" { // only write the english plurals, skip the main file
+        if strings.count > 0 {
+            report.stringsDiff = try writeStrings(fromDictionary: strings, toFile: stringsFilePath)
+        } else {
+            try? fm.removeItem(atPath: stringsFilePath)
+        }
+    }
+
+    var fastlaneMetadata: FastlaneMetadata?
+    if let metadataLocales {
+        let infoPlist = NSDictionary(contentsOfFile: infoPlistPath)
+        fastlaneMetadata = FastlaneMetadata(metadataLocales: metadataLocales, description: strings["app-store-short-description"], keywords: strings["app-store-keywords"], name: infoPlist?["CFBundleDisplayName"], subtitle: strings["app-store-subtitle"])
+    }
+
+    // Locales without plurals get the english plurals as placeholders
+    if stringsDict.count > 0 || locale == "en" {
+        report.wroteStringsDict = writeStringsDict(stringsDict, toFile: stringsDictFilePath)
+    } else if let englishPluralDictionary {
+        report.wroteStringsDict = writeStringsDict(englishPluralDictionary, toFile: stringsDictFilePath)
+    }
+
+    report.duration = CFAbsoluteTimeGetCurrent() - start
+    return LocaleImportResult(report: report, stringsDict: stringsDict.copy() as? NSDictionary, fastlaneMetadata: fastlaneMetadata, removesFastlaneMetadataFolder: metadataLocales == nil, inputHash: inputHash, outputPaths: outputPaths)
+}
+
+/// Writes and removes App Store metadata for the imported locales, then hashes their outputs into manifest entries.
+/// Folders are removed before any are written, and a folder another locale writes to is never removed, so the result doesn't depend on the order locales are imported in.
+fileprivate func applyFastlaneMetadata(to results: inout [LocaleImportResult], in path: String) throws {
+    let fm = FileManager.default
+    let writtenMetadataLocales = Set(appStoreMetadataLocales.values.joined())
+
+    for result in results where result.removesFastlaneMetadataFolder && !writtenMetadataLocales.contains(result.report.locale) {
+        try? fm.removeItem(at: fileURLForFastlaneMetadataFolder(for: result.report.locale, in: path))
+    }
+
+    for index in results.indices {
+        guard let metadata = results[index].fastlaneMetadata else {
+            continue
+        }
+        let start = CFAbsoluteTimeGetCurrent()
+        for metadataLocale in metadata.metadataLocales {
+            let folderURL = fileURLForFastlaneMetadataFolder(for: metadataLocale, in: path)
+            try fm.createDirectory(at: folderURL, withIntermediateDirectories: true, attributes: nil)
+
+            try? writeFastlaneMetadata(metadata.description, to: "description.txt", for: metadataLocale, in: path)
+            try? writeFastlaneMetadata(metadata.keywords, to: "keywords.txt", for: metadataLocale, in: path)
+            try? writeFastlaneMetadata(nil, to: "marketing_url.txt", for: metadataLocale, in: path) // use nil to copy from en-US. all fields need to be specified.
+            try? writeFastlaneMetadata(metadata.name, to: "name.txt", for: metadataLocale, in: path)
+            try? writeFastlaneMetadata(nil, to: "privacy_url.txt", for: metadataLocale, in: path) // use nil to copy from en-US. all fields need to be specified.
+            try? writeFastlaneMetadata(nil, to: "promotional_text.txt", for: metadataLocale, in: path) // use nil to copy from en-US. all fields need to be specified.
+            try? writeFastlaneMetadata(nil, to: "release_notes.txt", for: metadataLocale, in: path) // use nil to copy from en-US. all fields need to be specified.
+            try? writeFastlaneMetadata(metadata.subtitle, to: "subtitle.txt", for: metadataLocale, in: path)
+            try? writeFastlaneMetadata(nil, to: "support_url.txt", for: metadataLocale, in: path) // use nil to copy from en-US. all fields need to be specified.
+        }
+        results[index].report.duration += CFAbsoluteTimeGetCurrent() - start
+    }
+
+    for index in results.indices {
+        guard let inputHash = results[index].inputHash else {
+            continue
+        }
+        results[index].manifestEntry = LocalizationImportManifest.Entry(inputHash: inputHash, outputHashes: outputHashes(of: results[index].outputPaths, in: path))
+    }
+}
+
+fileprivate func outputHashes(of outputPaths: [String], in path: String) -> [String: String] {
+    var hashes: [String: String] = [:]
+    for outputPath in outputPaths {
+        let relativePath = outputPath.hasPrefix(path) ? String(outputPath.dropFirst(path.count)) : outputPath
+        hashes[relativePath] = contentHash(of: FileManager.default.contents(atPath: outputPath))
+    }
+    return hashes
+}
@@ -0,0 +1,170 @@
+import Foundation
+
+/// **THIS IS NOT PART OF THE MAIN APP - IT'S A COMMAND LINE UTILITY**
+
+/// Single pass replacements for the regexes that converted TWN strings to iOS format strings.
+/// Each function matches exactly what the regex it replaced matched, so the converted strings are unchanged.
+extension String {
+
+    /// Converts `{{GENDER:$1|he|she}}` style magic words to their contents and `$1` tokens to `%1$@`, using the types of the English tokens
+    func iOSNativeLocalization(tokens: [String: String]) -> String {
+        let source = Array(utf16)
+        var magicWordsReplaced: [UInt16] = []
+        magicWordsReplaced.reserveCapacity(source.count)
+
+        // Same as replacing (?:[{][{][a-z]+:)(:?[^{]*)(?:[}][}]) with its contents, numbering magic words without contents
+        var index = 0
+        var matchNumber = 1
+        while index < source.count {
+            guard let match = source.magicWord(at: index) else {
+                magicWordsReplaced.append(source[index])
+                index += 1
+                continue
+            }
+            if match.contents.isEmpty {
+                magicWordsReplaced.append(contentsOf: "\(matchNumber)".utf16)
+            } else {
+                magicWordsReplaced.append(contentsOf: source[match.contents])
+            }
+            matchNumber += 1
+            index = match.end
+        }
+
+        // Same as replacing (?:[$])(:?[0-9]+) with %<token>$<type>
+        var output: [UInt16] = []
+        output.reserveCapacity(magicWordsReplaced.count + 8)
+        index = 0
+        while index < magicWordsReplaced.count {
+            guard let token = magicWordsReplaced.twnToken(at: index) else {
+                output.append(magicWordsReplaced[index])
+                index += 1
+                continue
+            }
+            let tokenString = String(decoding: magicWordsReplaced[token], as: UTF16.self)
+            output.append(.percent)
+            output.append(contentsOf: magicWordsReplaced[token])
+            output.append(.dollar)
+            output.append(contentsOf: (tokens[tokenString] ?? "@").utf16)
+            index = token.upperBound
+        }
+
+        return String(decoding: output, as: UTF16.self)
+    }
+
+    /// Types of the `%1$@` style tokens in an iOS format string, by position. Un-numbered tokens are treated as 1.
+    var iOSTokenDictionary: [String: String] {
+        let source = Array(utf16)
+        var tokenDictionary = [String: String]()
+
+        // Same as matching %([0-9]*)\$?([@dDuUxXoOfeEgGcCsSpaAF])
+        var index = 0
+        while index < source.count {
+            guard let match = source.iOSToken(at: index) else {
+                index += 1
+                continue
+            }
+            var number = String(decoding: source[match.number], as: UTF16.self)
+            // treat an un-numbered token as 1
+            if number == "" {
+                number = "1"
+            }
+            let token = String(decoding: [source[match.type]], as: UTF16.self)
+            if tokenDictionary[number] == nil {
+                tokenDictionary[number] = token
+            } else if token != tokenDictionary[number] {
+                print("Internal token mismatch: \(self)")
+                abort()
+            }
+            index = match.type + 1
+        }
+        return tokenDictionary
+    }
+}
+
+fileprivate extension UInt16 {
+    static let openBrace = UInt16(UInt8(ascii: "{"))
+    static let closeBrace = UInt16(UInt8(ascii: "}"))
+    static let colon = UInt16(UInt8(ascii: ":"))
+    static let dollar = UInt16(UInt8(ascii: "$"))
+    static let percent = UInt16(UInt8(ascii: "%"))
+
+    var isASCIILetter: Bool {
+        return (0x41...0x5A).contains(self) || (0x61...0x7A).contains(self)
+    }
+
+    var isASCIIDigit: Bool {
+        return (0x30...0x39).contains(self)
+    }
+
+    static let iOSTokenTypes = Set("@dDuUxXoOfeEgGcCsSpaAF".utf16)
+}
+
+fileprivate extension Array where Element == UInt16 {
+
+    /// A magic word like `{{GENDER:$1|he|she}}` starting at `index`. Like the greedy `[^{]*` it replaces, the contents run to the last `}}` before the next `{`.
+    func magicWord(at index: Int) -> (contents: Range<Int>, end: Int)? {
+        guard index + 1 < count, self[index] == .openBrace, self[index + 1] == .openBrace else {
+            return nil
+        }
+        var nameEnd = index + 2
+        while nameEnd < count && self[nameEnd].isASCIILetter {
+            nameEnd += 1
+        }
+        guard nameEnd > index + 2, nameEnd < count, self[nameEnd] == .colon else {
+            return nil
+        }
+        let contentsStart = nameEnd + 1
+        var nextOpenBrace = contentsStart
+        while nextOpenBrace < count && self[nextOpenBrace] != .openBrace {
+            nextOpenBrace += 1
+        }
+        var closeStart = nextOpenBrace - 2
+        while closeStart >= contentsStart {
+            if self[closeStart] == .closeBrace && self[closeStart + 1] == .closeBrace {
+                return (contentsStart..<closeStart, closeStart + 2)
+            }
+            closeStart -= 1
+        }
+        return nil
+    }
+
+    /// The range of a TWN token's number, like `1` in `$1`, for a `$` at `index`
+    func twnToken(at index: Int) -> Range<Int>? {
+        guard self[index] == .dollar else {
+            return nil
+        }
+        let tokenStart = index + 1
+        var digitsStart = tokenStart
+        if digitsStart < count && self[digitsStart] == .colon {
+            digitsStart += 1
+        }
+        var tokenEnd = digitsStart
+        while tokenEnd < count && self[tokenEnd].isASCIIDigit {
+            tokenEnd += 1
+        }
+        guard tokenEnd > digitsStart else {
+            return nil
+        }
+        return tokenStart..<tokenEnd
+    }
+
+    /// The number and type of an iOS token like `%1$@` for a `%` at `index`
+    func iOSToken(at index: Int) -> (number: Range<Int>, type: Int)? {
+        guard self[index] == .percent else {
+            return nil
+        }
+        let numberStart = index + 1
+        var numberEnd = numberStart
+        while numberEnd < count && self[numberEnd].isASCIIDigit {
+            numberEnd += 1
+        }
+        var typeIndex = numberEnd
+        if typeIndex < count && self[typeIndex] == .dollar {
+            typeIndex += 1
+        }
+        guard typeIndex < count, UInt16.iOSTokenTypes.contains(self[typeIndex]) else {
+            return nil
+        }
+        return (numberStart..<numberEnd, typeIndex)
+    }
+}
@@ -18,7 +18,8 @@ if extractProcess.terminationStatus == 0 {
     print("Exporting localizations from source code...")
     exportLocalizationsFromSourceCode(path)
     print("Importing localizations from TWN...")
-    importLocalizationsFromTWN(path)
+    let report = importLocalizationsFromTWN(path)
+    report.printSummary()
     print("Localizations imported successfully.")
 } else {
     print("Failed to extract localizations from source code.")
@@ -51,9 +51,7 @@ class NotificationService: UNNotificationServiceExtension {
                 let finalNotificationsToDisplay = finalNotifications.notificationsToDisplay
                 let finalNotificationsToCache = finalNotifications.notificationsToCache
                 
-                var newCache = cache
-                newCache.notifications = finalNotificationsToCache
-                self.sharedCache.saveCache(newCache)
+                self.sharedCache.updateCache(\PushNotificationsCache.notifications, codingKey: PushNotificationsCache.CodingKeys.notifications, to: finalNotificationsToCache, default: cache)
                 
                 // specific handling for talk page types (New messages title, bundled body)
                 if let talkPageContent = NotificationServiceHelper.talkPageContent(for: finalNotificationsToDisplay) {
@@ -148,6 +148,8 @@ extension ArticleCacheDBWriter {
                 let networkItemsForAdd: Set<NetworkItem> = Set(offlineResourceItems + finalMediaListItems + imageInfoItems)
                 let networkItemsForRemove: Set<NetworkItem> = Set([mobileHTMLNetworkItem] + [mediaListNetworkItem] + offlineResourceItems + finalMediaListItems + imageInfoItems)
                 
+                // Compare against writes that haven't been flushed yet
+                self.writeBehindQueue.flush()
                 self.context.perform { [weak self] in
                     guard let self = self else {
                         return
@@ -212,6 +214,7 @@ extension ArticleCacheDBWriter {
     }
     
     private func cacheItems(groupKey: String, items: Set<NetworkItem>, completion: @escaping ((SaveResult) -> Void)) {
+        writeBehindQueue.flush()
         context.perform {
 
             guard let group = CacheDBWriterHelper.fetchOrCreateCacheGroup(with: groupKey, in: self.context) else {
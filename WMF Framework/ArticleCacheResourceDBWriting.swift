@@ -79,25 +79,22 @@ extension ArticleCacheResourceDBWriting {
     }
     
     func cacheURLs(groupKey: String, mustHaveURLRequests: [URLRequest], niceToHaveURLRequests: [URLRequest], completion: @escaping ((SaveResult) -> Void)) {
-        context.perform {
+        writeBehindQueue.enqueue(operation: { (context) in
 
-            guard let group = CacheDBWriterHelper.fetchOrCreateCacheGroup(with: groupKey, in: self.context) else {
-                completion(.failure(ArticleCacheDBWriterError.failureFetchOrCreateCacheGroup))
-                return
+            guard let group = CacheDBWriterHelper.fetchOrCreateCacheGroup(with: groupKey, in: context) else {
+                throw ArticleCacheDBWriterError.failureFetchOrCreateCacheGroup
             }
             
             for urlRequest in mustHaveURLRequests {
                 
                 guard let url = urlRequest.url,
                     let itemKey = self.fetcher.itemKeyForURLRequest(urlRequest) else {
-                        completion(.failure(ArticleCacheDBWriterError.unableToDetermineItemKey))
-                        return
+                        throw ArticleCacheDBWriterError.unableToDetermineItemKey
                 }
                 
                 // note, we purposefully do not set variant here. We need to wait until CacheFileWriter determines if the response varies on language, then set it when we call markDownloaded
-                guard let item = CacheDBWriterHelper.fetchOrCreateCacheItem(with: url, itemKey: itemKey, variant: nil, in: self.context) else {
-                    completion(.failure(ArticleCacheDBWriterError.failureFetchOrCreateMustHaveCacheItem))
-                    return
+                guard let item = CacheDBWriterHelper.fetchOrCreateCacheItem(with: url, itemKey: itemKey, variant: nil, in: context) else {
+                    throw ArticleCacheDBWriterError.failureFetchOrCreateMustHaveCacheItem
                 }
                 
                 group.addToCacheItems(item)
@@ -111,15 +108,20 @@ extension ArticleCacheResourceDBWriting {
                         continue
                 }
                 
-                guard let item = CacheDBWriterHelper.fetchOrCreateCacheItem(with: url, itemKey: itemKey, variant: nil, in: self.context) else {
+                guard let item = CacheDBWriterHelper.fetchOrCreateCacheItem(with: url, itemKey: itemKey, variant: nil, in: context) else {
                     continue
                 }
                 
                 group.addToCacheItems(item)
             }
-            
-            CacheDBWriterHelper.save(moc: self.context, completion: completion)
-        }
+        }, completion: { (result) in
+            switch result {
+            case .success:
+                completion(.success)
+            case .failure(let error):
+                completion(.failure(error))
+            }
+        })
     }
     
     func fetchImageAndResourceURLsForArticleURL(_ articleURL: URL, groupKey: CacheController.GroupKey, completion: @escaping ImageAndResourceCompletion) {
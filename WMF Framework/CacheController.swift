@@ -1,4 +1,5 @@
 import Foundation
+import CocoaLumberjackSwift
 
 public enum CacheControllerError: Error {
     case unableToCreateBackgroundCacheContext
@@ -57,6 +58,7 @@ public class CacheController {
         }
     }
 
+    /// Work on the returned context shouldn't leave unsaved changes between `perform` blocks. `CacheDBWriteBehindQueue` rolls back the context when a write fails.
     static func createCacheContext(cacheURL: URL) -> NSManagedObjectContext? {
         
         // create cacheURL directory
@@ -76,6 +78,7 @@ public class CacheController {
 
         // create persistent store coordinator / persistent store
         let dbURL = cacheURL.appendingPathComponent("Cache.sqlite", isDirectory: false)
+        migrateFirstVersionStoreIfNeeded(at: dbURL, modelURL: modelURL, currentModel: model)
         let persistentStoreCoordinator = NSPersistentStoreCoordinator(managedObjectModel: model)
 
         let options = [
@@ -106,6 +109,33 @@ public class CacheController {
         return cacheBackgroundContext
     }
     
+    /// Migrates a store from the first Cache model to Cache 2 with `CacheItemMappingModel`, so lightweight migration can take it the rest of the way.
+    /// Core Data only looks for a mapping model from the store's version straight to the current one, and can't infer the first version's change of `variant` from an integer to a string.
+    private static func migrateFirstVersionStoreIfNeeded(at dbURL: URL, modelURL: URL, currentModel: NSManagedObjectModel) {
+        guard FileManager.default.fileExists(atPath: dbURL.path),
+              let metadata = try? NSPersistentStoreCoordinator.metadataForPersistentStore(ofType: NSSQLiteStoreType, at: dbURL, options: nil),
+              !currentModel.isConfiguration(withName: nil, compatibleWithStoreMetadata: metadata),
+              let sourceModel = NSManagedObjectModel(contentsOf: modelURL.appendingPathComponent("Cache.mom", isDirectory: false)),
+              sourceModel.isConfiguration(withName: nil, compatibleWithStoreMetadata: metadata),
+              let destinationModel = NSManagedObjectModel(contentsOf: modelURL.appendingPathComponent("Cache 2.mom", isDirectory: false)),
+              let mappingModel = NSMappingModel(from: [Bundle.wmf], forSourceModel: sourceModel, destinationModel: destinationModel) else {
+            return
+        }
+        
+        let migratedDBURL = dbURL.deletingLastPathComponent().appendingPathComponent("Cache 2.sqlite", isDirectory: false)
+        let coordinator = NSPersistentStoreCoordinator(managedObjectModel: destinationModel)
+        do {
+            try coordinator.destroyPersistentStore(at: migratedDBURL, ofType: NSSQLiteStoreType, options: nil)
+            let migrationManager = NSMigrationManager(sourceModel: sourceModel, destinationModel: destinationModel)
+            try migrationManager.migrateStore(from: dbURL, sourceType: NSSQLiteStoreType, options: nil, with: mappingModel, toDestinationURL: migratedDBURL, destinationType: NSSQLiteStoreType, destinationOptions: nil)
+            try coordinator.replacePersistentStore(at: dbURL, destinationOptions: nil, withPersistentStoreFrom: migratedDBURL, sourceOptions: nil, ofType: NSSQLiteStoreType)
+            try coordinator.destroyPersistentStore(at: migratedDBURL, ofType: NSSQLiteStoreType, options: nil)
+        } catch let error {
+            // Adding the store fails and it's recreated
+            DDLogError("Error migrating cache store from its first version: \(error)")
+        }
+    }
+    
     public typealias ItemKey = String
     public typealias GroupKey = String
     public typealias UniqueKey = String // combo of item key + variant
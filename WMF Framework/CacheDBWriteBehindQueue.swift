@@ -0,0 +1,178 @@
+import Foundation
+
+/// Buffers cache database writes and applies them to the context in batches, saving once per batch instead of once per write.
+///
+/// Writes are applied in the order they were enqueued. A batch is flushed when it reaches `maxBatchSize` or `flushDelay` after its first write.
+/// Writes sharing a dedupe key within a batch are applied once, with the latest write winning. Writes without a dedupe key (like removals) end the dedupe window so they're never reordered around.
+/// Completions are called on the context's queue after the save covering their write.
+/// A write that fails is rolled back without losing the rest of its batch. If the batch fails to save, its writes are retried and saved one at a time.
+///
+/// Failed writes are undone with `rollback()` on the whole context, which is the cache background context shared by the cache writers.
+/// Any other work on that context must save or roll back its changes before its `perform` block ends, or a failed write will discard them.
+final class CacheDBWriteBehindQueue {
+
+    typealias Operation = (NSManagedObjectContext) throws -> Void
+
+    static let defaultMaxBatchSize = 64
+    static let defaultFlushDelay: DispatchTimeInterval = .milliseconds(200)
+
+    private struct PendingWrite {
+        var operation: Operation
+        var completions: [(CacheDBWritingResult) -> Void]
+    }
+
+    let context: NSManagedObjectContext
+    let maxBatchSize: Int
+    let flushDelay: DispatchTimeInterval
+
+    private let lock = NSLock()
+    private var pendingWrites: [PendingWrite] = []
+    private var pendingWriteIndexesByDedupeKey: [String: Int] = [:]
+    // Incremented on every flush so a scheduled flush for an earlier batch doesn't flush a later one early
+    private var batchIdentifier = 0
+
+    init(context: NSManagedObjectContext, maxBatchSize: Int = CacheDBWriteBehindQueue.defaultMaxBatchSize, flushDelay: DispatchTimeInterval = CacheDBWriteBehindQueue.defaultFlushDelay) {
+        self.context = context
+        self.maxBatchSize = max(1, maxBatchSize)
+        self.flushDelay = flushDelay
+    }
+
+    /// - Parameters:
+    ///   - dedupeKey: identifies writes that replace one another, for example marking the same item downloaded twice
+    ///   - operation: changes to make on the context. Called on the context's queue. Shouldn't save.
+    ///   - completion: called with the operation's error, or the save's result if it succeeded
+    func enqueue(dedupeKey: String? = nil, operation: @escaping Operation, completion: @escaping (CacheDBWritingResult) -> Void) {
+        lock.lock()
+
+        if let dedupeKey, let index = pendingWriteIndexesByDedupeKey[dedupeKey] {
+            pendingWrites[index].operation = operation
+            pendingWrites[index].completions.append(completion)
+        } else {
+            if let dedupeKey {
+                pendingWriteIndexesByDedupeKey[dedupeKey] = pendingWrites.count
+            } else {
+                pendingWriteIndexesByDedupeKey.removeAll()
+            }
+            pendingWrites.append(PendingWrite(operation: operation, completions: [completion]))
+        }
+
+        let pendingWriteCount = pendingWrites.count
+        let batchIdentifier = self.batchIdentifier
+
+        lock.unlock()
+
+        if pendingWriteCount >= maxBatchSize {
+            flush()
+        } else if pendingWriteCount == 1 {
+            DispatchQueue.global(qos: .utility).asyncAfter(deadline: .now() + flushDelay) { [weak self] in
+                self?.flush(batchIdentifier: batchIdentifier)
+            }
+        }
+    }
+
+    /// Applies and saves any pending writes. Work submitted to the context after this returns sees them.
+    /// - Parameter completion: called on the context's queue once pending writes are saved
+    func flush(completion: (() -> Void)? = nil) {
+        flush(batchIdentifier: nil, completion: completion)
+    }
+
+    // MARK: - Private
+
+    private func flush(batchIdentifier expectedBatchIdentifier: Int?, completion: (() -> Void)? = nil) {
+        lock.lock()
+
+        if let expectedBatchIdentifier, expectedBatchIdentifier != batchIdentifier {
+            lock.unlock()
+            return
+        }
+
+        let writes = pendingWrites
+        pendingWrites.removeAll()
+        pendingWriteIndexesByDedupeKey.removeAll()
+        batchIdentifier += 1
+
+        // Perform while locked so batches reach the context in the order they were taken
+        context.perform {
+            self.apply(writes)
+            completion?()
+        }
+
+        lock.unlock()
+    }
+
+    // Called on the context's queue
+    private func apply(_ writes: [PendingWrite]) {
+        guard !writes.isEmpty else {
+            return
+        }
+
+        var results: [CacheDBWritingResult] = Array(repeating: .success, count: writes.count)
+        var appliedIndexes = Array(writes.indices)
+
+        // A failed operation may have made some of its changes. Roll them back and apply the other operations again without it.
+        while let failedIndex = applyUntilFailure(writes, at: appliedIndexes, results: &results) {
+            context.rollback()
+            appliedIndexes.removeAll { $0 == failedIndex }
+        }
+
+        if case .failure(let error) = save() {
+            context.rollback()
+            if appliedIndexes.count == 1 {
+                results[appliedIndexes[0]] = .failure(error)
+            } else {
+                // Save the writes one at a time, so only the ones that can't be saved fail
+                for index in appliedIndexes {
+                    do {
+                        try writes[index].operation(context)
+                        if case .failure(let error) = save() {
+                            throw error
+                        }
+                    } catch let error {
+                        context.rollback()
+                        results[index] = .failure(error)
+                    }
+                }
+            }
+        }
+
+        for (write, result) in zip(writes, results) {
+            for completion in write.completions {
+                completion(result)
+            }
+        }
+    }
+
+    /// Applies the operations at `indexes` in order, stopping at the first one that throws
+    /// - Returns: The index of the operation that threw, with its error recorded in `results`
+    private func applyUntilFailure(_ writes: [PendingWrite], at indexes: [Int], results: inout [CacheDBWritingResult]) -> Int? {
+        for index in indexes {
+            do {
+                try writes[index].operation(context)
+            } catch let error {
+                results[index] = .failure(error)
+                return index
+            }
+        }
+        return nil
+    }
+
+    private func save() -> SaveResult {
+        var result: SaveResult = .success
+        CacheDBWriterHelper.save(moc: context) { (saveResult) in
+            result = saveResult
+        }
+        return result
+    }
+}
+
+// MARK: - Dedupe keys
+
+extension CacheDBWriteBehindQueue {
+    static func markDownloadedDedupeKey(itemKey: CacheController.ItemKey, variant: String?) -> String {
+        return "markDownloaded|\(itemKey)|\(variant ?? "")"
+    }
+    
+    static func addDedupeKey(groupKey: CacheController.GroupKey, itemKey: CacheController.ItemKey, variant: String?) -> String {
+        return "add|\(groupKey)|\(itemKey)|\(variant ?? "")"
+    }
+}
@@ -69,6 +69,13 @@ final class CacheDBWriterHelper {
         return item
     }
     
+    static func markDownloaded(itemKey: CacheController.ItemKey, variant: String?, in moc: NSManagedObjectContext) throws {
+        guard let cacheItem = cacheItem(with: itemKey, variant: variant, in: moc) else {
+            throw CacheDBWritingMarkDownloadedError.cannotFindCacheItem
+        }
+        cacheItem.isDownloaded = true
+    }
+    
     static func isCached(itemKey: CacheController.ItemKey, variant: String?, in moc: NSManagedObjectContext, completion: @escaping (Bool) -> Void) {
         return moc.perform {
             let isCached = CacheDBWriterHelper.cacheItem(with: itemKey, variant: variant, in: moc) != nil
@@ -35,6 +35,7 @@ enum CacheDBWritingRemoveError: Error {
 
 protocol CacheDBWriting: CacheTaskTracking {
     var context: NSManagedObjectContext { get }
+    var writeBehindQueue: CacheDBWriteBehindQueue { get }
     
     typealias CacheDBWritingCompletionWithURLRequests = (CacheDBWritingResultWithURLRequests) -> Void
     typealias CacheDBWritingCompletionWithItemAndVariantKeys = (CacheDBWritingResultWithItemAndVariantKeys) -> Void
@@ -56,6 +57,8 @@ protocol CacheDBWriting: CacheTaskTracking {
 extension CacheDBWriting {
 
     func fetchKeysToRemove(for groupKey: CacheController.GroupKey, completion: @escaping CacheDBWritingCompletionWithItemAndVariantKeys) {
+        // Include writes that haven't been flushed yet
+        writeBehindQueue.flush()
         context.perform {
             guard let group = CacheDBWriterHelper.cacheGroup(with: groupKey, in: self.context) else {
                 completion(.failure(CacheDBWritingMarkDownloadedError.cannotFindCacheGroup))
@@ -75,43 +78,23 @@ extension CacheDBWriting {
     }
     
     func remove(itemAndVariantKey: CacheController.ItemKeyAndVariant, completion: @escaping (CacheDBWritingResult) -> Void) {
-        context.perform {
-            guard let cacheItem = CacheDBWriterHelper.cacheItem(with: itemAndVariantKey.itemKey, variant: itemAndVariantKey.variant, in: self.context) else {
-                completion(.failure(CacheDBWritingRemoveError.cannotFindCacheItem))
-                return
+        writeBehindQueue.enqueue(operation: { (context) in
+            guard let cacheItem = CacheDBWriterHelper.cacheItem(with: itemAndVariantKey.itemKey, variant: itemAndVariantKey.variant, in: context) else {
+                throw CacheDBWritingRemoveError.cannotFindCacheItem
             }
             
-            self.context.delete(cacheItem)
-            
-            CacheDBWriterHelper.save(moc: self.context) { (result) in
-                switch result {
-                case .success:
-                    completion(.success)
-                case .failure(let error):
-                    completion(.failure(error))
-                }
-            }
-        }
+            context.delete(cacheItem)
+        }, completion: completion)
     }
     
     func remove(groupKey: CacheController.GroupKey, completion: @escaping (CacheDBWritingResult) -> Void) {
-        context.perform {
-            guard let cacheGroup = CacheDBWriterHelper.cacheGroup(with: groupKey, in: self.context) else {
-                completion(.failure(CacheDBWritingRemoveError.cannotFindCacheItem))
-                return
+        writeBehindQueue.enqueue(operation: { (context) in
+            guard let cacheGroup = CacheDBWriterHelper.cacheGroup(with: groupKey, in: context) else {
+                throw CacheDBWritingRemoveError.cannotFindCacheItem
             }
             
-            self.context.delete(cacheGroup)
-            
-            CacheDBWriterHelper.save(moc: self.context) { (result) in
-                switch result {
-                case .success:
-                    completion(.success)
-                case .failure(let error):
-                    completion(.failure(error))
-                }
-            }
-        }
+            context.delete(cacheGroup)
+        }, completion: completion)
     }
     
     func shouldDownloadVariant(urlRequest: URLRequest) -> Bool {
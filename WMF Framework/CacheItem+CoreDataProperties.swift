@@ -8,9 +8,11 @@ extension CacheItem {
         return NSFetchRequest<CacheItem>(entityName: "CacheItem")
     }
 
+    @NSManaged public var byteCount: Int64
     @NSManaged public var date: Date?
     @NSManaged public var isDownloaded: Bool
     @NSManaged public var key: String?
+    @NSManaged public var lastAccessDate: Date?
     @NSManaged public var url: URL?
     @NSManaged public var variant: String?
     @NSManaged public var cacheGroups: NSSet?
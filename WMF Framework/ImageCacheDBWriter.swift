@@ -9,6 +9,7 @@ enum ImageCacheDBWriterError: Error {
 final class ImageCacheDBWriter: CacheDBWriting {
 
     let context: NSManagedObjectContext
+    let writeBehindQueue: CacheDBWriteBehindQueue
     private let imageFetcher: ImageFetcher
     
     var fetcher: CacheFetching {
@@ -20,6 +21,7 @@ final class ImageCacheDBWriter: CacheDBWriting {
     init(imageFetcher: ImageFetcher, cacheBackgroundContext: NSManagedObjectContext) {
         self.imageFetcher = imageFetcher
         self.context = cacheBackgroundContext
+        self.writeBehindQueue = CacheDBWriteBehindQueue(context: cacheBackgroundContext)
     }
     
     func add(url: URL, groupKey: CacheController.GroupKey, completion: @escaping (CacheDBWritingResultWithURLRequests) -> Void) {
@@ -49,22 +51,10 @@ final class ImageCacheDBWriter: CacheDBWriting {
         }
         
         let variant = fetcher.variantForURLRequest(urlRequest)
-    
-        context.perform {
-            guard let cacheItem = CacheDBWriterHelper.cacheItem(with: itemKey, variant: variant, in: self.context) else {
-                completion(.failure(CacheDBWritingMarkDownloadedError.cannotFindCacheItem))
-                return
-            }
-            cacheItem.isDownloaded = true
-            CacheDBWriterHelper.save(moc: self.context) { (result) in
-                switch result {
-                case .success:
-                    completion(.success)
-                case .failure(let error):
-                    completion(.failure(error))
-                }
-            }
-        }
+        
+        writeBehindQueue.enqueue(dedupeKey: CacheDBWriteBehindQueue.markDownloadedDedupeKey(itemKey: itemKey, variant: variant), operation: { (context) in
+            try CacheDBWriterHelper.markDownloaded(itemKey: itemKey, variant: variant, in: context)
+        }, completion: completion)
     }
     
     func shouldDownloadVariant(itemKey: CacheController.ItemKey, variant: String?) -> Bool {
@@ -120,64 +110,63 @@ final class ImageCacheDBWriter: CacheDBWriting {
 
 private extension ImageCacheDBWriter {
     func cacheImages(groupKey: String, urlRequests: [URLRequest], completion: @escaping (CacheDBWritingResultWithURLRequests) -> Void) {
-        context.perform {
         
-            let dispatchGroup = DispatchGroup()
-            var successRequests: [URLRequest] = []
-            var errorRequests: [URLRequest] = []
+        let dispatchGroup = DispatchGroup()
+        let lock = NSLock()
+        var successRequests: [URLRequest] = []
+        var errorRequests: [URLRequest] = []
+        
+        for urlRequest in urlRequests {
             
-            for urlRequest in urlRequests {
-                
-                dispatchGroup.enter()
-                
-                guard let url = urlRequest.url,
-                    let itemKey = self.imageFetcher.itemKeyForURLRequest(urlRequest) else {
-                        errorRequests.append(urlRequest)
-                        dispatchGroup.leave()
-                        continue
-                }
-                
-                let variant = self.imageFetcher.variantForURLRequest(urlRequest)
-                    
-                guard let group = CacheDBWriterHelper.fetchOrCreateCacheGroup(with: groupKey, in: self.context) else {
+            guard let url = urlRequest.url,
+                let itemKey = imageFetcher.itemKeyForURLRequest(urlRequest) else {
+                    lock.lock()
                     errorRequests.append(urlRequest)
-                    dispatchGroup.leave()
+                    lock.unlock()
                     continue
+            }
+            
+            let variant = imageFetcher.variantForURLRequest(urlRequest)
+            
+            dispatchGroup.enter()
+            writeBehindQueue.enqueue(dedupeKey: CacheDBWriteBehindQueue.addDedupeKey(groupKey: groupKey, itemKey: itemKey, variant: variant), operation: { (context) in
+                
+                guard let group = CacheDBWriterHelper.fetchOrCreateCacheGroup(with: groupKey, in: context) else {
+                    throw CacheDBWritingMarkDownloadedError.cannotFindCacheGroup
                 }
                 
-                guard let item = CacheDBWriterHelper.fetchOrCreateCacheItem(with: url, itemKey: itemKey, variant: variant, in: self.context) else {
-                    errorRequests.append(urlRequest)
-                    dispatchGroup.leave()
-                    continue
+                guard let item = CacheDBWriterHelper.fetchOrCreateCacheItem(with: url, itemKey: itemKey, variant: variant, in: context) else {
+                    throw CacheDBWritingMarkDownloadedError.cannotFindCacheItem
                 }
                 
                 item.variant = variant
                 group.addToCacheItems(item)
                 
-                CacheDBWriterHelper.save(moc: self.context) { (result) in
-                    
-                    defer {
-                        dispatchGroup.leave()
-                    }
-                    
-                    switch result {
-                    case .success:
-                        successRequests.append(urlRequest)
-                    case .failure:
-                        errorRequests.append(urlRequest)
-                    }
+            }, completion: { (result) in
+                
+                defer {
+                    dispatchGroup.leave()
                 }
-            }
-            
-            dispatchGroup.notify(queue: DispatchQueue.global(qos: .userInitiated)) {
-
-                if errorRequests.count > 0 && successRequests.count == 0 {
-                    completion(.failure(ImageCacheDBWriterError.batchURLInsertFailure))
-                    return
+                
+                lock.lock()
+                switch result {
+                case .success:
+                    successRequests.append(urlRequest)
+                case .failure:
+                    errorRequests.append(urlRequest)
                 }
+                lock.unlock()
+            })
+        }
+        
+        dispatchGroup.notify(queue: DispatchQueue.global(qos: .userInitiated)) {
 
-                completion(.success(successRequests))
+            if errorRequests.count > 0 && successRequests.count == 0 {
+                completion(.failure(ImageCacheDBWriterError.batchURLInsertFailure))
+                return
             }
+
+            completion(.success(successRequests))
         }
     }
 }
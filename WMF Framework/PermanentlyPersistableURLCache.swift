@@ -22,9 +22,14 @@ public struct Header {
 
 class PermanentlyPersistableURLCache: URLCache, @unchecked Sendable {
     let cacheManagedObjectContext: NSManagedObjectContext
+    let quota: PermanentlyPersistableURLCacheQuota
     
     init(moc: NSManagedObjectContext) {
         cacheManagedObjectContext = moc
+        quota = PermanentlyPersistableURLCacheQuota(moc: moc, directoryURL: CacheController.cacheURL, fileNamesForItem: { (itemKey, variant) in
+            let fileName = PermanentlyPersistableURLCache.uniqueFileNameForItemKey(itemKey, variant: variant)
+            return [fileName, PermanentlyPersistableURLCache.headerFileName(forFileName: fileName)]
+        })
         super.init(memoryCapacity: URLCache.shared.memoryCapacity, diskCapacity: URLCache.shared.diskCapacity, diskPath: nil)
     }
     
@@ -234,6 +239,10 @@ extension PermanentlyPersistableURLCache {
     func uniqueHeaderFileNameForItemKey(_ itemKey: CacheController.ItemKey, variant: String?) -> String {
         let fileName = uniqueFileNameForItemKey(itemKey, variant: variant)
         
+        return Self.headerFileName(forFileName: fileName)
+    }
+    
+    static func headerFileName(forFileName fileName: String) -> String {
         return fileName + "__Header"
     }
     
@@ -248,6 +257,10 @@ extension PermanentlyPersistableURLCache {
     }
     
     func uniqueFileNameForItemKey(_ itemKey: CacheController.ItemKey, variant: String?) -> String {
+        return Self.uniqueFileNameForItemKey(itemKey, variant: variant)
+    }
+    
+    static func uniqueFileNameForItemKey(_ itemKey: CacheController.ItemKey, variant: String?) -> String {
         
         guard let variant = variant else {
             let fileName = itemKey.precomposedStringWithCanonicalMapping
@@ -395,6 +408,10 @@ extension PermanentlyPersistableURLCache {
                 return
             }
             
+            if let itemKey = self.itemKeyForURL(url, type: type) {
+                self.quota.recordWrite(itemKey: itemKey, variant: self.variantForURL(url, type: type))
+            }
+            
             success()
         }
     }
@@ -605,6 +622,8 @@ private extension PermanentlyPersistableURLCache {
         
         let maybeResponseFileName: String?
         let maybeResponseHeaderFileName: String?
+        let maybeItemKey: String?
+        let variant: String?
         let url: URL
         
         switch request {
@@ -612,10 +631,14 @@ private extension PermanentlyPersistableURLCache {
             url = inURL
             maybeResponseFileName = uniqueFileNameForURL(url, type: type)
             maybeResponseHeaderFileName = uniqueHeaderFileNameForURL(url, type: type)
-        case .fallbackItemKeyAndVariant(let inURL, let itemKey, let variant):
+            maybeItemKey = itemKeyForURL(url, type: type)
+            variant = variantForURL(url, type: type)
+        case .fallbackItemKeyAndVariant(let inURL, let itemKey, let inVariant):
             url = inURL
-            maybeResponseFileName = uniqueFileNameForItemKey(itemKey, variant: variant)
-            maybeResponseHeaderFileName = uniqueHeaderFileNameForItemKey(itemKey, variant: variant)
+            maybeResponseFileName = uniqueFileNameForItemKey(itemKey, variant: inVariant)
+            maybeResponseHeaderFileName = uniqueHeaderFileNameForItemKey(itemKey, variant: inVariant)
+            maybeItemKey = itemKey
+            variant = inVariant
         }
         
         guard let responseFileName = maybeResponseFileName,
@@ -644,6 +667,9 @@ private extension PermanentlyPersistableURLCache {
         }
         
         if let httpResponse = HTTPURLResponse(url: url, statusCode: 200, httpVersion: nil, headerFields: responseHeaders) {
+            if let itemKey = maybeItemKey {
+                quota.recordAccess(itemKey: itemKey, variant: variant)
+            }
             return CachedURLResponse(response: httpResponse, data: responseData)
         }
         
@@ -0,0 +1,245 @@
+import Foundation
+import CocoaLumberjackSwift
+
+/// Keeps the files written by `PermanentlyPersistableURLCache` within a byte budget.
+///
+/// Each `CacheItem` records the size of its content and header files and when it was last read.
+/// When the running total goes over the quota, items that no `CacheGroup` references are evicted,
+/// most expensive first, where cost is the item's size multiplied by the time since it was last read.
+/// Items belonging to a group (saved articles and their resources) are never evicted, even if the group's article is no longer saved, since the cache database doesn't know which articles are saved.
+/// The quota only bounds unreferenced items: if grouped items alone are over the quota, the cache stays over it until their groups are removed.
+final class PermanentlyPersistableURLCacheQuota {
+
+    static let defaultQuotaInBytes: Int64 = 256 * 1024 * 1024
+
+    /// How long reads are collected in memory before their access dates are written to the database
+    static let accessFlushDelay: DispatchTimeInterval = .seconds(10)
+
+    typealias FileNamesForItem = (_ itemKey: CacheController.ItemKey, _ variant: String?) -> [String]
+
+    let quotaInBytes: Int64
+
+    private let moc: NSManagedObjectContext
+    private let directoryURL: URL
+    private let fileNamesForItem: FileNamesForItem
+
+    // Only accessed on moc's queue
+    private var totalByteCount: Int64?
+
+    private let pendingAccessLock = NSLock()
+    private var pendingAccessDates: [CacheController.ItemKeyAndVariant: Date] = [:]
+    private var isAccessFlushScheduled = false
+
+    /// - Parameters:
+    ///   - moc: the cache's managed object context
+    ///   - directoryURL: the directory the cache's files are written to
+    ///   - quotaInBytes: the size the cache is trimmed to when it grows past it
+    ///   - fileNamesForItem: the names of the files stored for an item key and variant
+    init(moc: NSManagedObjectContext, directoryURL: URL, quotaInBytes: Int64 = PermanentlyPersistableURLCacheQuota.defaultQuotaInBytes, fileNamesForItem: @escaping FileNamesForItem) {
+        self.moc = moc
+        self.directoryURL = directoryURL
+        self.quotaInBytes = quotaInBytes
+        self.fileNamesForItem = fileNamesForItem
+    }
+
+    // MARK: - Public
+
+    /// Records the on-disk size of an item's files after they are written and evicts unpinned items if the cache is over quota
+    func recordWrite(itemKey: CacheController.ItemKey, variant: String?, date: Date = Date(), completion: (() -> Void)? = nil) {
+        let byteCount = self.byteCount(itemKey: itemKey, variant: variant)
+        moc.perform {
+            defer {
+                completion?()
+            }
+
+            guard let item = CacheDBWriterHelper.cacheItem(with: itemKey, variant: variant, in: self.moc) else {
+                return
+            }
+
+            var totalByteCount = self.loadTotalByteCount()
+            totalByteCount += byteCount - item.byteCount
+            self.totalByteCount = totalByteCount
+            item.byteCount = byteCount
+            item.lastAccessDate = date
+
+            CacheDBWriterHelper.save(moc: self.moc) { _ in }
+
+            if totalByteCount > self.quotaInBytes {
+                self.evictUnpinnedItems(now: date)
+            }
+        }
+    }
+
+    /// Notes that an item was read from the cache. Cheap enough to call on every read, access dates are written in batches.
+    func recordAccess(itemKey: CacheController.ItemKey, variant: String?, date: Date = Date()) {
+        guard let key = CacheController.ItemKeyAndVariant(itemKey: itemKey, variant: variant) else {
+            return
+        }
+
+        pendingAccessLock.lock()
+        pendingAccessDates[key] = date
+        let shouldScheduleFlush = !isAccessFlushScheduled
+        isAccessFlushScheduled = true
+        pendingAccessLock.unlock()
+
+        guard shouldScheduleFlush else {
+            return
+        }
+
+        DispatchQueue.global(qos: .utility).asyncAfter(deadline: .now() + Self.accessFlushDelay) { [weak self] in
+            self?.flushPendingAccesses()
+        }
+    }
+
+    /// Writes access dates collected by `recordAccess` to the database
+    func flushPendingAccesses(completion: (() -> Void)? = nil) {
+        pendingAccessLock.lock()
+        let accessDates = pendingAccessDates
+        pendingAccessDates.removeAll()
+        isAccessFlushScheduled = false
+        pendingAccessLock.unlock()
+
+        guard !accessDates.isEmpty else {
+            completion?()
+            return
+        }
+
+        moc.perform {
+            for (key, date) in accessDates {
+                guard let item = CacheDBWriterHelper.cacheItem(with: key.itemKey, variant: key.variant, in: self.moc) else {
+                    continue
+                }
+                if let lastAccessDate = item.lastAccessDate, lastAccessDate >= date {
+                    continue
+                }
+                item.lastAccessDate = date
+            }
+            CacheDBWriterHelper.save(moc: self.moc) { _ in }
+            completion?()
+        }
+    }
+
+    /// Evicts unpinned items until the cache is within quota
+    /// - Parameters:
+    ///   - now: the date item ages are measured from
+    ///   - completion: called on the moc's queue with the items that were evicted, in eviction order
+    func enforceQuota(now: Date = Date(), completion: (([CacheController.ItemKeyAndVariant]) -> Void)? = nil) {
+        flushPendingAccesses()
+        moc.perform {
+            let evictedItems = self.loadTotalByteCount() > self.quotaInBytes ? self.evictUnpinnedItems(now: now) : []
+            completion?(evictedItems)
+        }
+    }
+
+    // MARK: - Private (on moc's queue)
+
+    /// Sums the recorded sizes of every item, measuring items cached before sizes were recorded
+    private func loadTotalByteCount() -> Int64 {
+        if let totalByteCount {
+            return totalByteCount
+        }
+
+        let unmeasuredRequest: NSFetchRequest<CacheItem> = CacheItem.fetchRequest()
+        unmeasuredRequest.predicate = NSPredicate(format: "byteCount == 0 && isDownloaded == YES")
+        unmeasuredRequest.fetchBatchSize = 500
+        if let unmeasuredItems = try? moc.fetch(unmeasuredRequest), !unmeasuredItems.isEmpty {
+            for item in unmeasuredItems {
+                guard let itemKey = item.key else {
+                    continue
+                }
+                item.byteCount = byteCount(itemKey: itemKey, variant: item.variant)
+            }
+            CacheDBWriterHelper.save(moc: moc) { _ in }
+        }
+
+        let sumDescription = NSExpressionDescription()
+        sumDescription.name = "totalByteCount"
+        sumDescription.expression = NSExpression(forFunction: "sum:", arguments: [NSExpression(forKeyPath: "byteCount")])
+        sumDescription.expressionResultType = .integer64AttributeType
+
+        let sumRequest = NSFetchRequest<NSDictionary>(entityName: "CacheItem")
+        sumRequest.resultType = .dictionaryResultType
+        sumRequest.propertiesToFetch = [sumDescription]
+
+        let total: Int64
+        do {
+            total = (try moc.fetch(sumRequest).first?["totalByteCount"] as? NSNumber)?.int64Value ?? 0
+        } catch let error {
+            DDLogError("Error summing permanent cache size: \(error)")
+            total = 0
+        }
+        totalByteCount = total
+        return total
+    }
+
+    /// Evicts items no group references until the cache is within quota, or there are none left
+    @discardableResult
+    private func evictUnpinnedItems(now: Date) -> [CacheController.ItemKeyAndVariant] {
+        var totalByteCount = loadTotalByteCount()
+
+        let fetchRequest: NSFetchRequest<CacheItem> = CacheItem.fetchRequest()
+        fetchRequest.predicate = NSPredicate(format: "cacheGroups.@count == 0 && mustHaveCacheGroups.@count == 0")
+        let unpinnedItems: [CacheItem]
+        do {
+            unpinnedItems = try moc.fetch(fetchRequest)
+        } catch let error {
+            DDLogError("Error fetching unpinned permanent cache items: \(error)")
+            return []
+        }
+
+        let itemsByCost = unpinnedItems
+            .map { (item: $0, cost: Self.evictionCost(of: $0, now: now)) }
+            .sorted { $0.cost > $1.cost }
+
+        var evictedItems: [CacheController.ItemKeyAndVariant] = []
+        for (item, _) in itemsByCost {
+            guard totalByteCount > quotaInBytes else {
+                break
+            }
+
+            guard let itemKey = item.key else {
+                continue
+            }
+
+            for fileName in fileNamesForItem(itemKey, item.variant) {
+                do {
+                    try FileManager.default.removeItem(at: directoryURL.appendingPathComponent(fileName, isDirectory: false))
+                } catch let error as NSError where error.domain == NSCocoaErrorDomain && error.code == NSFileNoSuchFileError {
+                    continue
+                } catch let error {
+                    DDLogError("Error evicting permanent cache file: \(error)")
+                }
+            }
+
+            totalByteCount -= item.byteCount
+            if let key = CacheController.ItemKeyAndVariant(itemKey: itemKey, variant: item.variant) {
+                evictedItems.append(key)
+            }
+            moc.delete(item)
+        }
+
+        self.totalByteCount = totalByteCount
+        CacheDBWriterHelper.save(moc: moc) { _ in }
+        return evictedItems
+    }
+
+    /// Size weighted by staleness, so large items nobody reads go first and small recently read ones go last
+    private static func evictionCost(of item: CacheItem, now: Date) -> Double {
+        let lastAccessDate = item.lastAccessDate ?? item.date ?? .distantPast
+        let age = max(1, now.timeIntervalSince(lastAccessDate))
+        return age * Double(max(1, item.byteCount))
+    }
+
+    // MARK: - Private
+
+    private func byteCount(itemKey: CacheController.ItemKey, variant: String?) -> Int64 {
+        var byteCount: Int64 = 0
+        for fileName in fileNamesForItem(itemKey, variant) {
+            let fileURL = directoryURL.appendingPathComponent(fileName, isDirectory: false)
+            if let fileSize = (try? fileURL.resourceValues(forKeys: [.fileSizeKey]))?.fileSize {
+                byteCount += Int64(fileSize)
+            }
+        }
+        return byteCount
+    }
+}
@@ -0,0 +1,271 @@
+import CocoaLumberjackSwift
+
+/// The part of the reading lists API used to upload new entries.
+/// `ReadingListsAPIController` conforms; tests provide a local mock of the batch entries endpoint.
+protocol ReadingListEntryBatchUploading: AnyObject {
+    func addEntriesToList(withListID listID: Int64, entries: [(project: String, title: String)], completion: @escaping (_ entryIDs: [(Int64?, Error?)]?,_ error: Error?) -> Swift.Void)
+}
+
+extension ReadingListsAPIController: ReadingListEntryBatchUploading {
+
+}
+
+struct ReadingListEntryUpload {
+    let listID: Int64
+    let project: String
+    let title: String
+}
+
+enum ReadingListEntryUploadResult {
+    case created(Int64)
+    case failed(Error)
+}
+
+/// Uploads new reading list entries for any number of lists.
+///
+/// Entries are split into per-list sub-batches of at most `batchSize` and a window of
+/// `maxConcurrentRequests` sub-batches is kept in flight, so entries from small lists share the
+/// window instead of each list waiting for the previous one. Sub-batches that fail as a whole, or
+/// entries that fail with a transient error, are retried on their own up to `maxAttempts` times,
+/// waiting `retryDelay` before the first retry and doubling the wait for each one after that.
+/// Server errors that won't change on retry (entry limit, deleted list, etc.) are reported as-is.
+final class ReadingListEntryUploadScheduler {
+
+    typealias BatchResults = [(index: Int, result: ReadingListEntryUploadResult)]
+
+    private struct Batch {
+        let listID: Int64
+        let indexes: [Int]
+        let attempt: Int
+    }
+
+    private let uploader: ReadingListEntryBatchUploading
+    let batchSize: Int
+    let maxConcurrentRequests: Int
+    let maxAttempts: Int
+    let retryDelay: TimeInterval
+
+    private let queue = DispatchQueue(label: "org.wikimedia.readinglists.entryUploadScheduler")
+
+    // Only accessed on queue
+    private var uploads: [ReadingListEntryUpload] = []
+    private var results: [ReadingListEntryUploadResult?] = []
+    private var pendingBatches: [Batch] = []
+    private var nextPendingBatchIndex = 0
+    private var inFlightRequestCount = 0
+    private var scheduledRetryCount = 0
+    private var uploadGeneration = 0
+    private var isCancelled: () -> Bool = { false }
+    private var batchCompletion: ((BatchResults) -> Void)?
+    private var completion: (([ReadingListEntryUploadResult?]) -> Void)?
+
+    init(uploader: ReadingListEntryBatchUploading, batchSize: Int = WMFReadingListBatchSizePerRequestLimit, maxConcurrentRequests: Int = 4, maxAttempts: Int = 3, retryDelay: TimeInterval = 1) {
+        assert(batchSize > 0 && maxConcurrentRequests > 0 && maxAttempts > 0 && retryDelay >= 0)
+        self.uploader = uploader
+        self.batchSize = max(1, batchSize)
+        self.maxConcurrentRequests = max(1, maxConcurrentRequests)
+        self.maxAttempts = max(1, maxAttempts)
+        self.retryDelay = max(0, retryDelay)
+    }
+
+    /**
+     Uploads entries, keeping up to `maxConcurrentRequests` requests in flight
+     - parameters:
+        - uploads: The entries to create, in any list order
+        - isCancelled: Checked before each request is started. Requests already in flight are allowed to finish so their IDs aren't lost.
+        - batchCompletion: Called on a private queue after each request with the results it settled, so callers can persist server IDs as they arrive. Entries that will be retried aren't included.
+        - completion: Called on a private queue once every started request has finished
+        - results: One result per upload, in the same order as `uploads`. `nil` for entries that were never attempted, or were waiting for a retry, because of cancellation.
+     */
+    func upload(_ uploads: [ReadingListEntryUpload], isCancelled: @escaping () -> Bool = { false }, batchCompletion: ((_ results: BatchResults) -> Void)? = nil, completion: @escaping (_ results: [ReadingListEntryUploadResult?]) -> Void) {
+        queue.async {
+            assert(self.completion == nil, "Only one upload may run at a time per scheduler")
+            self.uploads = uploads
+            self.results = Array(repeating: nil, count: uploads.count)
+            self.pendingBatches = self.batches(for: uploads)
+            self.nextPendingBatchIndex = 0
+            self.inFlightRequestCount = 0
+            self.scheduledRetryCount = 0
+            self.uploadGeneration += 1
+            self.isCancelled = isCancelled
+            self.batchCompletion = batchCompletion
+            self.completion = completion
+            self.startPendingBatches()
+            self.finishIfNeeded()
+        }
+    }
+
+    /// Synchronous variant of `upload` for callers that are already on a background context's queue.
+    /// `batchCompletion` is called on the calling thread, so it can save the caller's context.
+    func uploadAndWait(_ uploads: [ReadingListEntryUpload], isCancelled: @escaping () -> Bool = { false }, batchCompletion: ((_ results: BatchResults) -> Void)? = nil) -> [ReadingListEntryUploadResult?] {
+        guard !uploads.isEmpty else {
+            return []
+        }
+        let semaphore = DispatchSemaphore(value: 0)
+        let lock = NSLock()
+        var finishedBatches: [BatchResults] = []
+        var uploadResults: [ReadingListEntryUploadResult?]?
+        upload(uploads, isCancelled: isCancelled, batchCompletion: { results in
+            lock.lock()
+            finishedBatches.append(results)
+            lock.unlock()
+            semaphore.signal()
+        }, completion: { results in
+            lock.lock()
+            uploadResults = results
+            lock.unlock()
+            semaphore.signal()
+        })
+
+        while true {
+            semaphore.wait()
+            lock.lock()
+            let batches = finishedBatches
+            finishedBatches.removeAll()
+            let results = uploadResults
+            lock.unlock()
+            for batch in batches {
+                batchCompletion?(batch)
+            }
+            if let results = results {
+                return results
+            }
+        }
+    }
+
+    // MARK: - Private (on queue)
+
+    private func batches(for uploads: [ReadingListEntryUpload]) -> [Batch] {
+        var listIDs: [Int64] = []
+        var indexesByListID: [Int64: [Int]] = [:]
+        for (index, upload) in uploads.enumerated() {
+            if indexesByListID[upload.listID] == nil {
+                listIDs.append(upload.listID)
+            }
+            indexesByListID[upload.listID, default: []].append(index)
+        }
+        var batches: [Batch] = []
+        for listID in listIDs {
+            guard let indexes = indexesByListID[listID] else {
+                continue
+            }
+            var start = 0
+            while start < indexes.count {
+                let end = min(indexes.count, start + batchSize)
+                batches.append(Batch(listID: listID, indexes: Array(indexes[start..<end]), attempt: 1))
+                start = end
+            }
+        }
+        return batches
+    }
+
+    private func startPendingBatches() {
+        while inFlightRequestCount < maxConcurrentRequests && nextPendingBatchIndex < pendingBatches.count && !isCancelled() {
+            let batch = pendingBatches[nextPendingBatchIndex]
+            nextPendingBatchIndex += 1
+            inFlightRequestCount += 1
+            let entries = batch.indexes.map { (project: uploads[$0].project, title: uploads[$0].title) }
+            uploader.addEntriesToList(withListID: batch.listID, entries: entries) { (entryIDs, error) in
+                self.queue.async {
+                    self.inFlightRequestCount -= 1
+                    self.handle(entryIDs: entryIDs, error: error, for: batch)
+                    self.startPendingBatches()
+                    self.finishIfNeeded()
+                }
+            }
+        }
+    }
+
+    private func handle(entryIDs: [(Int64?, Error?)]?, error: Error?, for batch: Batch) {
+        var settledResults: BatchResults = []
+        defer {
+            if !settledResults.isEmpty {
+                batchCompletion?(settledResults)
+            }
+        }
+
+        guard let entryIDs = entryIDs else {
+            let error = error ?? ReadingListError.unableToAddEntry
+            DDLogError("Error creating reading list entries: \(error)")
+            settledResults = retryOrFail(batch.indexes, of: batch, with: error)
+            return
+        }
+
+        var indexesToRetry: [Int] = []
+        var retryError: Error = ReadingListError.unableToAddEntry
+        for (position, index) in batch.indexes.enumerated() {
+            guard position < entryIDs.count else {
+                // The server returned fewer results than requested, try the rest again
+                indexesToRetry.append(index)
+                continue
+            }
+            let (entryID, entryError) = entryIDs[position]
+            if let entryID = entryID {
+                results[index] = .created(entryID)
+                settledResults.append((index: index, result: .created(entryID)))
+            } else {
+                let entryError = entryError ?? ReadingListError.unableToAddEntry
+                if isRetryable(entryError) {
+                    indexesToRetry.append(index)
+                    retryError = entryError
+                } else {
+                    results[index] = .failed(entryError)
+                    settledResults.append((index: index, result: .failed(entryError)))
+                }
+            }
+        }
+        settledResults.append(contentsOf: retryOrFail(indexesToRetry, of: batch, with: retryError))
+    }
+
+    /// Schedules a retry of `indexes` after the backoff delay for the batch's attempt, or fails them once attempts run out
+    /// - Returns: The results of the entries that failed
+    private func retryOrFail(_ indexes: [Int], of batch: Batch, with error: Error) -> BatchResults {
+        guard !indexes.isEmpty else {
+            return []
+        }
+        guard batch.attempt < maxAttempts, isRetryable(error) else {
+            for index in indexes {
+                results[index] = .failed(error)
+            }
+            return indexes.map { (index: $0, result: .failed(error)) }
+        }
+
+        let retry = Batch(listID: batch.listID, indexes: indexes, attempt: batch.attempt + 1)
+        let delay = retryDelay * pow(2, Double(batch.attempt - 1))
+        let generation = uploadGeneration
+        scheduledRetryCount += 1
+        queue.asyncAfter(deadline: .now() + delay) {
+            // The upload may have finished early because it was cancelled
+            guard generation == self.uploadGeneration, self.completion != nil else {
+                return
+            }
+            self.scheduledRetryCount -= 1
+            self.pendingBatches.append(retry)
+            self.startPendingBatches()
+            self.finishIfNeeded()
+        }
+        return []
+    }
+
+    private func isRetryable(_ error: Error) -> Bool {
+        guard let apiError = error as? APIReadingListError else {
+            return true
+        }
+        return apiError == .generic
+    }
+
+    private func finishIfNeeded() {
+        guard inFlightRequestCount == 0, (nextPendingBatchIndex >= pendingBatches.count && scheduledRetryCount == 0) || isCancelled(), let completion = completion else {
+            return
+        }
+        let results = self.results
+        self.completion = nil
+        self.batchCompletion = nil
+        self.uploads = []
+        self.results = []
+        self.pendingBatches = []
+        self.nextPendingBatchIndex = 0
+        self.scheduledRetryCount = 0
+        completion(results)
+    }
+}
@@ -672,65 +672,53 @@ internal class ReadingListsSyncOperation: ReadingListsOperation, @unchecked Send
             throw ReadingListsOperationError.cancelled
         }
         
+        var entriesToAdd: [ReadingListEntry] = []
+        var entryUploads: [ReadingListEntryUpload] = []
         for (readingListID, entries) in entriesToAddByListID {
-            var start = 0
-            var end = 0
-            while end < entries.count {
-                end = min(entries.count, start + WMFReadingListBatchSizePerRequestLimit)
-                try autoreleasepool {
-                    var createdReadingListEntries: [Int64: ReadingListEntry] = [:]
-                    var failedReadingListEntries: [(ReadingListEntry, APIReadingListError)] = []
-                    requestCount += 1
-                    taskGroup.enter()
-                    let entrySubarray = Array(entries[start..<end])
-                    let entryProjectAndTitles = entrySubarray.map { (project: $0.project, title: $0.title) }
-                    self.apiController.addEntriesToList(withListID: readingListID, entries: entryProjectAndTitles, completion: { (readingListEntryIDs, createError) in
-                        defer {
-                            taskGroup.leave()
-                        }
-                        guard let readingListEntryIDs = readingListEntryIDs else {
-                            DDLogError("Error creating reading list entry: \(String(describing: createError))")
-                            if let apiError = createError as? APIReadingListError {
-                                for entry in entrySubarray {
-                                    failedReadingListEntries.append((entry.entry, apiError))
-                                }
-                            }
-                            return
-                        }
-                        for (index, readingListEntryIDOrError) in readingListEntryIDs.enumerated() {
-                            guard index < entrySubarray.count else {
-                                break
-                            }
-                            let localReadingListEntry = entrySubarray[index].entry
-                            
-                            guard let readingListEntryID = readingListEntryIDOrError.0 else {
-                                if let apiError = readingListEntryIDOrError.1 as? APIReadingListError {
-                                    failedReadingListEntries.append((localReadingListEntry, apiError))
-                                }
-                                continue
-                            }
-                            createdReadingListEntries[readingListEntryID] = localReadingListEntry
-                        }
-                        
-                    })
-                    taskGroup.wait()
-                    for (readingListEntryID, localReadingListEntry) in createdReadingListEntries {
-                        localReadingListEntry.readingListEntryID = NSNumber(value: readingListEntryID)
-                        localReadingListEntry.isUpdatedLocally = false
-                    }
-                    for failed in failedReadingListEntries {
-                        failed.0.errorCode = failed.1.rawValue
-                    }
-                    if moc.hasChanges {
-                        try moc.save()
-                    }
-                    guard !isCancelled  else {
-                        throw ReadingListsOperationError.cancelled
+            for entry in entries {
+                entriesToAdd.append(entry.entry)
+                entryUploads.append(ReadingListEntryUpload(listID: readingListID, project: entry.project, title: entry.title))
+            }
+        }
+        
+        guard !entryUploads.isEmpty else {
+            return
+        }
+        
+        let uploadScheduler = ReadingListEntryUploadScheduler(uploader: apiController)
+        // Apply and save each batch as it finishes, even if cancelled, so that server-assigned IDs aren't lost if the sync is interrupted
+        _ = uploadScheduler.uploadAndWait(entryUploads, isCancelled: { [weak self] in
+            return self?.isCancelled ?? true
+        }, batchCompletion: { batchResults in
+            for (index, uploadResult) in batchResults {
+                guard index < entriesToAdd.count else {
+                    continue
+                }
+                let localReadingListEntry = entriesToAdd[index]
+                switch uploadResult {
+                case .created(let readingListEntryID):
+                    localReadingListEntry.readingListEntryID = NSNumber(value: readingListEntryID)
+                    localReadingListEntry.isUpdatedLocally = false
+                case .failed(let error):
+                    if let apiError = error as? APIReadingListError {
+                        localReadingListEntry.errorCode = apiError.rawValue
                     }
                 }
-                start = end
             }
-            
+            guard moc.hasChanges else {
+                return
+            }
+            do {
+                try moc.save()
+            } catch let error {
+                DDLogError("Error saving uploaded reading list entries: \(error)")
+            }
+        })
+        if moc.hasChanges {
+            try moc.save()
+        }
+        guard !isCancelled  else {
+            throw ReadingListsOperationError.cancelled
         }
     }
     
@@ -6,6 +6,13 @@ public struct PushNotificationsCache: Codable {
     public var notifications: Set<RemoteNotificationsAPIController.NotificationsResult.Notification>
     public var currentUnreadCount: Int = 0
     
+    /// Keys for `SharedContainerCache.updateCache(_:codingKey:to:default:)`
+    public enum CodingKeys: String, CodingKey {
+        case settings
+        case notifications
+        case currentUnreadCount
+    }
+    
     public init(settings: PushNotificationsSettings, notifications: Set<RemoteNotificationsAPIController.NotificationsResult.Notification>, currentUnreadCount: Int = 0) {
         self.settings = settings
         self.notifications = notifications
@@ -317,9 +317,7 @@ public enum RemoteNotificationsControllerError: LocalizedError {
     @objc public func updateCacheWithCurrentUnreadNotificationsCount() throws {
         let currentCount = try numberOfUnreadNotifications().intValue
         let sharedCache = SharedContainerCache(fileName: SharedContainerCacheCommonNames.pushNotificationsCache)
-        var pushCache = sharedCache.loadCache() ?? PushNotificationsCache(settings: .default, notifications: [])
-        pushCache.currentUnreadCount = currentCount
-        sharedCache.saveCache(pushCache)
+        sharedCache.updateCache(\PushNotificationsCache.currentUnreadCount, codingKey: PushNotificationsCache.CodingKeys.currentUnreadCount, to: currentCount, default: PushNotificationsCache(settings: .default, notifications: []))
     }
     
     public var filterPredicate: NSPredicate? {
@@ -4,16 +4,31 @@ import Foundation
     @objc public static let pushNotificationsCache = "Push Notifications Cache"
     @objc public static let talkPageCache = "Talk Page Cache"
     public static let widgetCache = "Widget Cache"
+    @objc public static let significantEventsCache = "Significant Events"
 }
 
+/// Codable cache file in the shared app group container.
+///
+/// Loads are served from a per-process mirror of the last decoded value, which is revalidated against the files' sizes and modification dates only after another process posts a change notification.
+/// `updateCache(_:codingKey:to:default:)` appends the changed property to a journal next to the cache file instead of re-encoding the whole value. The journal is folded back into the cache file in the background once it grows.
+/// Reads and writes are coordinated with `NSFileCoordinator` so the app and its extensions can share a cache safely.
 public final class SharedContainerCache: SharedContainerCacheHousekeepingProtocol {
 
     private let fileName: String
     private let subdirectoryPathComponent: String?
     
+    /// Journal size that triggers a background compaction
+    static let journalCompactionThreshold = 16 * 1024
+    
+    private static let journalPathExtension = "journal"
+    private static let changeNotificationName = "org.wikimedia.wikipedia.sharedContainerCache.didChange"
+    private static let mirror = SharedContainerCacheMirror()
+    private static let compactionQueue = DispatchQueue(label: "org.wikimedia.wikipedia.sharedContainerCache.compaction", qos: .utility)
+    
     public init(fileName: String, subdirectoryPathComponent: String? = nil) {
         self.fileName = fileName
         self.subdirectoryPathComponent = subdirectoryPathComponent
+        Self.startObservingChangesIfNeeded()
     }
     
     private static var cacheDirectoryContainerURL: URL {
@@ -25,6 +40,10 @@ public final class SharedContainerCache: SharedContainerCacheHousekeepingProtoco
         return baseURL.appendingPathComponent(fileName).appendingPathExtension("json")
     }
     
+    private var journalFileURL: URL {
+        return cacheDataFileURL.appendingPathExtension(Self.journalPathExtension)
+    }
+    
     private func subdirectoryURL() -> URL? {
         guard let subdirectoryPathComponent = subdirectoryPathComponent else {
             return nil
@@ -33,10 +52,27 @@ public final class SharedContainerCache: SharedContainerCacheHousekeepingProtoco
     }
 
     public func loadCache<T: Codable>() -> T? {
-        if let data = try? Data(contentsOf: cacheDataFileURL), let decodedCache = try? JSONDecoder().decode(T.self, from: data) {
-            return decodedCache
+        let cacheDataFileURL = cacheDataFileURL
+        let journalFileURL = journalFileURL
+        
+        if let mirroredCache: T = Self.mirror.value(for: cacheDataFileURL, currentStamp: { Self.stamp(cacheDataFileURL: cacheDataFileURL, journalFileURL: journalFileURL) }) {
+            return mirroredCache
+        }
+        
+        var decodedCache: T?
+        var stamp: SharedContainerCacheMirror.Stamp?
+        coordinate(writing: false) {
+            stamp = Self.stamp(cacheDataFileURL: cacheDataFileURL, journalFileURL: journalFileURL)
+            guard let data = Self.mergedCacheData(cacheDataFileURL: cacheDataFileURL, journalFileURL: journalFileURL)?.data else {
+                return
+            }
+            decodedCache = try? JSONDecoder().decode(T.self, from: data)
         }
-        return nil
+        
+        if let decodedCache, let stamp {
+            Self.mirror.set(decodedCache, for: cacheDataFileURL, stamp: stamp)
+        }
+        return decodedCache
     }
 
     public func saveCache<T: Codable>(_ cache: T) {
@@ -45,16 +81,235 @@ public final class SharedContainerCache: SharedContainerCacheHousekeepingProtoco
             return
         }
 
+        createSubdirectoryIfNeeded()
+
+        let cacheDataFileURL = cacheDataFileURL
+        let journalFileURL = journalFileURL
+        coordinate(writing: true) {
+            do {
+                try encodedCache.write(to: cacheDataFileURL, options: .atomic)
+                try? FileManager.default.removeItem(at: journalFileURL)
+                Self.mirror.set(cache, for: cacheDataFileURL, stamp: Self.stamp(cacheDataFileURL: cacheDataFileURL, journalFileURL: journalFileURL))
+            } catch {
+                Self.mirror.removeValue(for: cacheDataFileURL)
+            }
+        }
+        Self.postChangeNotification()
+    }
+    
+    /// Changes a single property of the cache without re-encoding the rest of it.
+    /// - Parameters:
+    ///   - keyPath: the property to change
+    ///   - codingKey: the key the property is encoded under, from the cache's `CodingKeys`
+    ///   - value: the new value
+    ///   - defaultCache: the cache to start from if there's no cache file yet
+    public func updateCache<T: Codable, V: Codable>(_ keyPath: WritableKeyPath<T, V>, codingKey: CodingKey, to value: V, default defaultCache: @autoclosure () -> T) {
+        let cacheDataFileURL = cacheDataFileURL
+        
+        guard FileManager.default.fileExists(atPath: cacheDataFileURL.path) else {
+            var cache: T = loadCache() ?? defaultCache()
+            cache[keyPath: keyPath] = value
+            saveCache(cache)
+            return
+        }
+        
+        guard let encodedRecord = try? JSONEncoder().encode([codingKey.stringValue: value]) else {
+            return
+        }
+        
+        let journalFileURL = journalFileURL
+        var journalSize = 0
+        coordinate(writing: true) {
+            let mirroredCache: T? = Self.mirror.value(for: cacheDataFileURL, currentStamp: { Self.stamp(cacheDataFileURL: cacheDataFileURL, journalFileURL: journalFileURL) })
+            do {
+                journalSize = try Self.appendJournalRecord(encodedRecord, to: journalFileURL)
+            } catch {
+                Self.mirror.removeValue(for: cacheDataFileURL)
+                return
+            }
+            if var mirroredCache {
+                mirroredCache[keyPath: keyPath] = value
+                Self.mirror.set(mirroredCache, for: cacheDataFileURL, stamp: Self.stamp(cacheDataFileURL: cacheDataFileURL, journalFileURL: journalFileURL))
+            } else {
+                Self.mirror.removeValue(for: cacheDataFileURL)
+            }
+        }
+        Self.postChangeNotification()
+        
+        if journalSize > Self.journalCompactionThreshold {
+            compactJournalInBackground()
+        }
+    }
+    
+    public func removeCache() throws {
+        let cacheDataFileURL = cacheDataFileURL
+        let journalFileURL = journalFileURL
+        var removeError: Error?
+        coordinate(writing: true) {
+            Self.mirror.removeValue(for: cacheDataFileURL)
+            try? FileManager.default.removeItem(at: journalFileURL)
+            do {
+                try FileManager.default.removeItem(at: cacheDataFileURL)
+            } catch let error {
+                removeError = error
+            }
+        }
+        Self.postChangeNotification()
+        if let removeError {
+            throw removeError
+        }
+    }
+    
+    /// Folds journal records into the cache file. The journal is kept if its records can't be applied.
+    func compactJournal() {
+        let cacheDataFileURL = cacheDataFileURL
+        let journalFileURL = journalFileURL
+        var didCompact = false
+        coordinate(writing: true) {
+            guard FileManager.default.fileExists(atPath: journalFileURL.path),
+                  let mergedCacheData = Self.mergedCacheData(cacheDataFileURL: cacheDataFileURL, journalFileURL: journalFileURL),
+                  mergedCacheData.includesJournal else {
+                return
+            }
+            let stampBeforeCompaction = Self.stamp(cacheDataFileURL: cacheDataFileURL, journalFileURL: journalFileURL)
+            do {
+                try mergedCacheData.data.write(to: cacheDataFileURL, options: .atomic)
+                try FileManager.default.removeItem(at: journalFileURL)
+                Self.mirror.restamp(for: cacheDataFileURL, from: stampBeforeCompaction, to: Self.stamp(cacheDataFileURL: cacheDataFileURL, journalFileURL: journalFileURL))
+                didCompact = true
+            } catch {
+                Self.mirror.removeValue(for: cacheDataFileURL)
+            }
+        }
+        if didCompact {
+            Self.postChangeNotification()
+        }
+    }
+    
+    private func compactJournalInBackground() {
+        Self.compactionQueue.async {
+            self.compactJournal()
+        }
+    }
+    
+    private func createSubdirectoryIfNeeded() {
         if let subdirectoryURL = subdirectoryURL() {
             try? FileManager.default.createDirectory(at: subdirectoryURL, withIntermediateDirectories: true, attributes: nil)
-
         }
+    }
+    
+    /// Serializes access to the cache file and its journal across processes
+    private func coordinate(writing: Bool, _ accessor: () -> Void) {
+        let coordinator = NSFileCoordinator(filePresenter: nil)
+        var coordinationError: NSError?
+        var didAccess = false
+        if writing {
+            coordinator.coordinate(writingItemAt: cacheDataFileURL, options: .forMerging, error: &coordinationError) { _ in
+                didAccess = true
+                accessor()
+            }
+        } else {
+            coordinator.coordinate(readingItemAt: cacheDataFileURL, options: [], error: &coordinationError) { _ in
+                didAccess = true
+                accessor()
+            }
+        }
+        if !didAccess {
+            // Coordination can fail if the container is unavailable. Fall back to uncoordinated access rather than losing the read or write.
+            accessor()
+        }
+    }
 
-        try? encodedCache.write(to: cacheDataFileURL)
+    // MARK: - Journal
+    
+    /// Appends a record with a 4 byte length prefix and returns the new size of the journal
+    private static func appendJournalRecord(_ record: Data, to journalFileURL: URL) throws -> Int {
+        if !FileManager.default.fileExists(atPath: journalFileURL.path) {
+            FileManager.default.createFile(atPath: journalFileURL.path, contents: nil)
+        }
+        let handle = try FileHandle(forWritingTo: journalFileURL)
+        defer {
+            try? handle.close()
+        }
+        var length = UInt32(record.count).littleEndian
+        var framedRecord = Data(bytes: &length, count: MemoryLayout<UInt32>.size)
+        framedRecord.append(record)
+        let endOffset = try handle.seekToEnd()
+        try handle.write(contentsOf: framedRecord)
+        return Int(endOffset) + framedRecord.count
     }
     
-    public func removeCache() throws {
-        try FileManager.default.removeItem(at: cacheDataFileURL)
+    /// Records in the journal, ignoring a trailing record that was only partially written
+    private static func journalRecords(at journalFileURL: URL) -> [[String: Any]] {
+        guard let data = try? Data(contentsOf: journalFileURL), !data.isEmpty else {
+            return []
+        }
+        var records: [[String: Any]] = []
+        var offset = data.startIndex
+        let lengthSize = MemoryLayout<UInt32>.size
+        while offset + lengthSize <= data.endIndex {
+            var length: UInt32 = 0
+            _ = withUnsafeMutableBytes(of: &length) { data.copyBytes(to: $0, from: offset..<(offset + lengthSize)) }
+            let recordStart = offset + lengthSize
+            let recordEnd = recordStart + Int(UInt32(littleEndian: length))
+            guard recordEnd <= data.endIndex else {
+                break
+            }
+            if let record = try? JSONSerialization.jsonObject(with: data[recordStart..<recordEnd]) as? [String: Any] {
+                records.append(record)
+            }
+            offset = recordEnd
+        }
+        return records
+    }
+    
+    /// Contents of the cache file with any journal records applied.
+    /// `includesJournal` is false if the cache file isn't a JSON object the records can be applied to, in which case `data` is the cache file as is.
+    private static func mergedCacheData(cacheDataFileURL: URL, journalFileURL: URL) -> (data: Data, includesJournal: Bool)? {
+        guard let data = try? Data(contentsOf: cacheDataFileURL) else {
+            return nil
+        }
+        let records = journalRecords(at: journalFileURL)
+        guard !records.isEmpty else {
+            return (data, true)
+        }
+        guard var cache = try? JSONSerialization.jsonObject(with: data) as? [String: Any] else {
+            return (data, false)
+        }
+        for record in records {
+            cache.merge(record, uniquingKeysWith: { $1 })
+        }
+        guard let mergedData = try? JSONSerialization.data(withJSONObject: cache) else {
+            return nil
+        }
+        return (mergedData, true)
+    }
+    
+    // MARK: - Change tracking
+    
+    private static func stamp(cacheDataFileURL: URL, journalFileURL: URL) -> SharedContainerCacheMirror.Stamp {
+        let cacheAttributes = try? FileManager.default.attributesOfItem(atPath: cacheDataFileURL.path)
+        let journalAttributes = try? FileManager.default.attributesOfItem(atPath: journalFileURL.path)
+        return SharedContainerCacheMirror.Stamp(cacheModificationDate: cacheAttributes?[.modificationDate] as? Date,
+                                                cacheSize: (cacheAttributes?[.size] as? NSNumber)?.uint64Value ?? 0,
+                                                journalModificationDate: journalAttributes?[.modificationDate] as? Date,
+                                                journalSize: (journalAttributes?[.size] as? NSNumber)?.uint64Value ?? 0)
+    }
+    
+    private static let startObservingChanges: Void = {
+        let center = CFNotificationCenterGetDarwinNotifyCenter()
+        CFNotificationCenterAddObserver(center, nil, { _, _, _, _, _ in
+            SharedContainerCache.mirror.setNeedsValidation()
+        }, changeNotificationName as CFString, nil, .deliverImmediately)
+    }()
+    
+    private static func startObservingChangesIfNeeded() {
+        _ = startObservingChanges
+    }
+    
+    private static func postChangeNotification() {
+        let center = CFNotificationCenterGetDarwinNotifyCenter()
+        CFNotificationCenterPostNotification(center, CFNotificationName(changeNotificationName as CFString), nil, nil, true)
     }
 
     /// Persist only the last 50 visited talk pages
@@ -65,8 +320,9 @@ public final class SharedContainerCache: SharedContainerCacheHousekeepingProtoco
                                                                        includingPropertiesForKeys: [.contentModificationDateKey],
                                                                        options: .skipsHiddenFiles) {
             let maxCacheSize = cleanupLevel == .high ? 0 : 50
-            if urlArray.count > maxCacheSize {
-                let sortedArray =  urlArray.map { url in
+            let cacheFileURLs = urlArray.filter { $0.pathExtension != journalPathExtension }
+            if cacheFileURLs.count > maxCacheSize {
+                let sortedArray =  cacheFileURLs.map { url in
                     (url, (try? url.resourceValues(forKeys: [.contentModificationDateKey]))?.contentModificationDate ?? Date.distantPast)
                 }.sorted(by: {$0.1 > $1.1 })
                     .map { $0.0 }
@@ -74,6 +330,8 @@ public final class SharedContainerCache: SharedContainerCacheHousekeepingProtoco
                 let itemsToDelete = Array(sortedArray.suffix(from: maxCacheSize))
                 for urlItem in itemsToDelete {
                     try? FileManager.default.removeItem(at: urlItem)
+                    try? FileManager.default.removeItem(at: urlItem.appendingPathExtension(journalPathExtension))
+                    mirror.removeValue(for: urlItem)
                 }
             }
         }
@@ -81,6 +339,79 @@ public final class SharedContainerCache: SharedContainerCacheHousekeepingProtoco
     }
 }
 
+/// Last decoded value of each cache file in this process
+private final class SharedContainerCacheMirror {
+    
+    struct Stamp: Equatable {
+        let cacheModificationDate: Date?
+        let cacheSize: UInt64
+        let journalModificationDate: Date?
+        let journalSize: UInt64
+    }
+    
+    private struct Entry {
+        let value: Any
+        var stamp: Stamp
+        var validationGeneration: Int
+    }
+    
+    private let lock = NSLock()
+    private var entries: [URL: Entry] = [:]
+    
+    // Incremented whenever any process reports a change. Entries validated in an older generation are checked against the files before use.
+    private var generation = 0
+    
+    func value<T>(for url: URL, currentStamp: () -> Stamp) -> T? {
+        lock.lock()
+        defer {
+            lock.unlock()
+        }
+        guard var entry = entries[url], let value = entry.value as? T else {
+            return nil
+        }
+        guard entry.validationGeneration != generation else {
+            return value
+        }
+        guard entry.stamp == currentStamp() else {
+            entries.removeValue(forKey: url)
+            return nil
+        }
+        entry.validationGeneration = generation
+        entries[url] = entry
+        return value
+    }
+    
+    func set(_ value: Any, for url: URL, stamp: Stamp) {
+        lock.lock()
+        entries[url] = Entry(value: value, stamp: stamp, validationGeneration: generation)
+        lock.unlock()
+    }
+    
+    /// Keeps a value whose files were rewritten without changing their contents
+    func restamp(for url: URL, from oldStamp: Stamp, to newStamp: Stamp) {
+        lock.lock()
+        if var entry = entries[url], entry.stamp == oldStamp {
+            entry.stamp = newStamp
+            entries[url] = entry
+        } else {
+            entries.removeValue(forKey: url)
+        }
+        lock.unlock()
+    }
+    
+    func removeValue(for url: URL) {
+        lock.lock()
+        entries.removeValue(forKey: url)
+        lock.unlock()
+    }
+    
+    func setNeedsValidation() {
+        lock.lock()
+        generation += 1
+        lock.unlock()
+    }
+}
+
 @objc public protocol SharedContainerCacheHousekeepingProtocol: AnyObject {
     static func deleteStaleCachedItems(in subdirectoryPathComponent: String, cleanupLevel: WMFCleanupLevel)
 }
@@ -88,8 +419,6 @@ public final class SharedContainerCache: SharedContainerCacheHousekeepingProtoco
 @objc public class SharedContainerCacheClearFeaturedArticleWrapper: NSObject {
     @objc public static func clearOutFeaturedArticleWidgetCache() {
         let sharedCache = SharedContainerCache(fileName: SharedContainerCacheCommonNames.widgetCache)
-        var updatedCache = sharedCache.loadCache() ?? WidgetCache(settings: .default, featuredContent: nil)
-        updatedCache.featuredContent = nil
-        sharedCache.saveCache(updatedCache)
+        sharedCache.updateCache(\WidgetCache.featuredContent, codingKey: WidgetCache.CodingKeys.featuredContent, to: nil, default: WidgetCache(settings: .default, featuredContent: nil))
     }
 }
@@ -11,11 +11,15 @@ public struct ArticleAsLivingDocViewModel {
     public let lastUpdatedTimestamp: String?
     public let summaryText: String?
 
+    /// Events grouped by day, before runs of days with only small events are collapsed into one section. Kept so following pages can be appended without regrouping the whole timeline.
+    private let daySections: [SectionHeader]
+
     private let isoDateFormatter = ISO8601DateFormatter()
 
     public init(nextRvStartId: UInt?, sha: String?, sections: [SectionHeader], summaryText: String?, articleInsertHtmlSnippets: [String], lastUpdatedTimestamp: String?) {
         self.nextRvStartId = nextRvStartId
         self.sha = sha
+        self.daySections = sections
         self.sections = sections
         self.summaryText = summaryText
         self.articleInsertHtmlSnippets = articleInsertHtmlSnippets
@@ -48,6 +52,58 @@ public struct ArticleAsLivingDocViewModel {
         }
         self.summaryText = summaryText
         
+        let daySections = ArticleAsLivingDocViewModel.daySections(from: significantEvents.typedEvents, traitCollection: traitCollection, theme: theme, subtitleDateFormatter: dayMonthNumberYearDateFormatter)
+        let sections = ArticleAsLivingDocViewModel.collapseSmallEvents(from: daySections)
+        self.daySections = daySections
+        self.sections = sections
+
+        let htmlSnippets = ArticleAsLivingDocViewModel.articleInsertHtmlSnippets(from: sections)
+        self.articleInsertHtmlSnippets = htmlSnippets.snippets
+        self.lastUpdatedTimestamp = htmlSnippets.lastUpdatedTimestamp
+    }
+
+    private init(nextRvStartId: UInt?, sha: String?, daySections: [SectionHeader], sections: [SectionHeader], summaryText: String?, articleInsertHtmlSnippets: [String], lastUpdatedTimestamp: String?) {
+        self.nextRvStartId = nextRvStartId
+        self.sha = sha
+        self.daySections = daySections
+        self.sections = sections
+        self.summaryText = summaryText
+        self.articleInsertHtmlSnippets = articleInsertHtmlSnippets
+        self.lastUpdatedTimestamp = lastUpdatedTimestamp
+    }
+
+    /// This timeline followed by `page`, the next page of it. Gives the same sections as a view model built from both pages' events at once.
+    /// Only the last section can change, so the sections before it are kept and only the new page is collapsed.
+    public func appending(_ page: ArticleAsLivingDocViewModel) -> ArticleAsLivingDocViewModel {
+        guard let dayMonthNumberYearDateFormatter = DateFormatter.wmf_monthNameDayOfMonthNumberYear() else {
+            assertionFailure("Unable to generate date formatters for Significant Events View Models")
+            return self
+        }
+
+        // The last section comes from these day sections, either as a run of small events collapsed together or as a day with large events
+        let trailingDaySectionsStartIndex = ArticleAsLivingDocViewModel.trailingDaySectionsStartIndex(of: daySections)
+        let trailingDaySections = Array(daySections[trailingDaySectionsStartIndex...])
+        let mergedDaySections = ArticleAsLivingDocViewModel.mergingDaySections(trailingDaySections, page.daySections, subtitleDateFormatter: dayMonthNumberYearDateFormatter)
+
+        let daySections = Array(self.daySections[..<trailingDaySectionsStartIndex]) + mergedDaySections
+        let sections = Array(self.sections.dropLast(trailingDaySections.isEmpty ? 0 : 1)) + ArticleAsLivingDocViewModel.collapseSmallEvents(from: mergedDaySections)
+
+        // Snippets come from the first large events, which a new page only changes if there were fewer than the maximum
+        var articleInsertHtmlSnippets = self.articleInsertHtmlSnippets
+        var lastUpdatedTimestamp = self.lastUpdatedTimestamp
+        if articleInsertHtmlSnippets.count < ArticleAsLivingDocViewModel.htmlSnippetCountMax || lastUpdatedTimestamp == nil {
+            let htmlSnippets = ArticleAsLivingDocViewModel.articleInsertHtmlSnippets(from: sections)
+            articleInsertHtmlSnippets = htmlSnippets.snippets
+            lastUpdatedTimestamp = htmlSnippets.lastUpdatedTimestamp
+        }
+
+        return ArticleAsLivingDocViewModel(nextRvStartId: page.nextRvStartId, sha: sha, daySections: daySections, sections: sections, summaryText: page.summaryText, articleInsertHtmlSnippets: articleInsertHtmlSnippets, lastUpdatedTimestamp: lastUpdatedTimestamp)
+    }
+
+    /// Events segmented into a section per day, with sibling small events collapsed together
+    private static func daySections(from significantEvents: [SignificantEvents.TypedEvent], traitCollection: UITraitCollection, theme: Theme, subtitleDateFormatter: DateFormatter) -> [SectionHeader] {
+        let isoDateFormatter = ISO8601DateFormatter()
+
         // loop through typed events, turn into view models and segment off into sections
         var currentSectionEvents: [TypedEvent] = []
         var sections: [SectionHeader] = []
@@ -55,7 +111,7 @@ public struct ArticleAsLivingDocViewModel {
         var maybeCurrentTimestamp: Date?
         var maybePreviousTimestamp: Date?
         
-        for originalEvent in significantEvents.typedEvents {
+        for originalEvent in significantEvents {
             
             var maybeEvent: TypedEvent? = nil
             if let smallEventViewModel = Event.Small(typedEvents: [originalEvent]) {
@@ -92,7 +148,7 @@ public struct ArticleAsLivingDocViewModel {
                 let calendar = NSCalendar.current
                 if !calendar.isDate(previousTimestamp, inSameDayAs: currentTimestamp) {
                     // multiple days have passed since last event, package up current sections into new section
-                    let section = SectionHeader(timestamp: previousTimestamp, typedEvents: currentSectionEvents, subtitleDateFormatter: dayMonthNumberYearDateFormatter)
+                    let section = SectionHeader(timestamp: previousTimestamp, typedEvents: currentSectionEvents, subtitleDateFormatter: subtitleDateFormatter)
                     sections.append(section)
                     currentSectionEvents.removeAll()
                     currentSectionEvents.append(event)
@@ -109,50 +165,81 @@ public struct ArticleAsLivingDocViewModel {
     
         // capture any final currentSectionEvents into new section
         if let currentTimestamp = maybeCurrentTimestamp {
-            let section = SectionHeader(timestamp: currentTimestamp, typedEvents: currentSectionEvents, subtitleDateFormatter: dayMonthNumberYearDateFormatter)
+            let section = SectionHeader(timestamp: currentTimestamp, typedEvents: currentSectionEvents, subtitleDateFormatter: subtitleDateFormatter)
             sections.append(section)
             currentSectionEvents.removeAll()
         }
         
-        // collapse sibling small event view models
-        var finalSections: [SectionHeader] = []
-        for section in sections {
-            var collapsedEventViewModels: [TypedEvent] = []
-            var currentSmallChanges: [SignificantEvents.Event.Small] = []
-            for event in section.typedEvents {
-                switch event {
-                case .small(let smallEventViewModel):
-                    currentSmallChanges.append(contentsOf: smallEventViewModel.smallChanges)
-                default:
-                    if currentSmallChanges.count > 0 {
-                        
-                        collapsedEventViewModels.append(.small(Event.Small(smallChanges: currentSmallChanges)))
-                        currentSmallChanges.removeAll()
-                    }
-                    collapsedEventViewModels.append(event)
-                    continue
+        return sections.map { section in
+            SectionHeader(timestamp: section.timestamp, typedEvents: collapsingSiblingSmallEvents(section.typedEvents), subtitleDateFormatter: subtitleDateFormatter)
+        }
+    }
+
+    /// Combines each run of small events into one small event
+    private static func collapsingSiblingSmallEvents(_ typedEvents: [TypedEvent]) -> [TypedEvent] {
+        var collapsedEventViewModels: [TypedEvent] = []
+        var currentSmallChanges: [SignificantEvents.Event.Small] = []
+        for event in typedEvents {
+            switch event {
+            case .small(let smallEventViewModel):
+                currentSmallChanges.append(contentsOf: smallEventViewModel.smallChanges)
+            default:
+                if currentSmallChanges.count > 0 {
+                    
+                    collapsedEventViewModels.append(.small(Event.Small(smallChanges: currentSmallChanges)))
+                    currentSmallChanges.removeAll()
                 }
+                collapsedEventViewModels.append(event)
+                continue
             }
-            
-            // add any final small changes
-            if currentSmallChanges.count > 0 {
-                collapsedEventViewModels.append(.small(Event.Small(smallChanges: currentSmallChanges)))
-                currentSmallChanges.removeAll()
-            }
+        }
+        
+        // add any final small changes
+        if currentSmallChanges.count > 0 {
+            collapsedEventViewModels.append(.small(Event.Small(smallChanges: currentSmallChanges)))
+            currentSmallChanges.removeAll()
+        }
+
+        return collapsedEventViewModels
+    }
 
-            let collapsedSection = SectionHeader(timestamp: section.timestamp, typedEvents: collapsedEventViewModels, subtitleDateFormatter: dayMonthNumberYearDateFormatter)
-            finalSections.append(collapsedSection)
+    /// Day sections of two consecutive pages. When a day spans both pages, its sections are joined into one.
+    private static func mergingDaySections(_ sections: [SectionHeader], _ nextSections: [SectionHeader], subtitleDateFormatter: DateFormatter) -> [SectionHeader] {
+        guard let lastSection = sections.last,
+              let firstNextSection = nextSections.first,
+              NSCalendar.current.isDate(lastSection.timestamp, inSameDayAs: firstNextSection.timestamp) else {
+            return sections + nextSections
         }
 
-        finalSections = ArticleAsLivingDocViewModel.collapseSmallEvents(from: finalSections)
-        self.sections = finalSections
+        let typedEvents = collapsingSiblingSmallEvents(lastSection.typedEvents + firstNextSection.typedEvents)
+        let mergedSection = SectionHeader(timestamp: firstNextSection.timestamp, typedEvents: typedEvents, subtitleDateFormatter: subtitleDateFormatter)
+        return Array(sections.dropLast()) + [mergedSection] + Array(nextSections.dropFirst())
+    }
 
+    /// Index of the first day section that the last collapsed section is made from
+    private static func trailingDaySectionsStartIndex(of daySections: [SectionHeader]) -> Int {
+        guard let lastSection = daySections.last else {
+            return 0
+        }
+
+        var startIndex = daySections.count - 1
+        if lastSection.containsOnlySmallEvents {
+            while startIndex > 0 && daySections[startIndex - 1].containsOnlySmallEvents {
+                startIndex -= 1
+            }
+        }
+        return startIndex
+    }
+
+    private static let htmlSnippetCountMax = 3
+
+    /// Html for the first large events, to insert into the article, and the display timestamp of the latest event
+    private static func articleInsertHtmlSnippets(from sections: [SectionHeader]) -> (snippets: [String], lastUpdatedTimestamp: String?) {
         // grab first 3 large event html snippets
         var articleInsertHtmlSnippets: [String] = []
         var lastUpdatedTimestamp: String?
-        let htmlSnippetCountMax = 3
         
-        outerLoop: for (sectionIndex, section) in finalSections.enumerated() {
+        outerLoop: for (sectionIndex, section) in sections.enumerated() {
             for (itemIndex, event) in section.typedEvents.enumerated() {
                 switch event {
                 case .small(let smallEvent):
@@ -177,8 +264,7 @@ public struct ArticleAsLivingDocViewModel {
             }
         }
         
-        self.articleInsertHtmlSnippets = articleInsertHtmlSnippets
-        self.lastUpdatedTimestamp = lastUpdatedTimestamp
+        return (articleInsertHtmlSnippets, lastUpdatedTimestamp)
     }
 
     /// Collapses sequential sections that contain only small events into one section, including a date range that represents the collected events
@@ -7,6 +7,85 @@ enum SignificantEventsFetcherError: Error {
 
 public class SignificantEventsFetcher: Fetcher {
     
+    /// When set, pages after the first are read from and saved to the store, and each page prefetches the one after it
+    public var timelineStore: SignificantEventsTimelineStore?
+    
+    private let prefetchLock = NSLock()
+    private var prefetchingRvStartIds: Set<UInt> = []
+    
+    /// Fetches a page of the timeline, from `timelineStore` when it has the page. The first page is always fetched, since it has the latest edits.
+    public func fetchSignificantEventsPage(rvStartId: UInt? = nil, title: String, siteURL: URL, completion: @escaping ((Result<SignificantEvents, Error>) -> Void)) {
+        guard let timelineStore = timelineStore else {
+            fetchSignificantEvents(rvStartId: rvStartId, title: title, siteURL: siteURL, completion: completion)
+            return
+        }
+        
+        guard let rvStartId = rvStartId else {
+            fetchAndSaveSignificantEventsPage(rvStartId: nil, title: title, siteURL: siteURL, timelineStore: timelineStore, completion: completion)
+            return
+        }
+        
+        timelineStore.page(startingAt: rvStartId, title: title, siteURL: siteURL) { (page) in
+            guard let page = page else {
+                self.fetchAndSaveSignificantEventsPage(rvStartId: rvStartId, title: title, siteURL: siteURL, timelineStore: timelineStore, completion: completion)
+                return
+            }
+            completion(.success(page))
+            self.prefetchPage(after: page, title: title, siteURL: siteURL, timelineStore: timelineStore)
+        }
+    }
+    
+    private func fetchAndSaveSignificantEventsPage(rvStartId: UInt?, title: String, siteURL: URL, timelineStore: SignificantEventsTimelineStore, completion: @escaping ((Result<SignificantEvents, Error>) -> Void)) {
+        fetchSignificantEvents(rvStartId: rvStartId, title: title, siteURL: siteURL) { [weak self] (result) in
+            if case .success(let page) = result {
+                if let rvStartId = rvStartId {
+                    timelineStore.save(page, startingAt: rvStartId, title: title, siteURL: siteURL)
+                } else {
+                    timelineStore.updateSha(page.sha, title: title, siteURL: siteURL)
+                }
+                self?.prefetchPage(after: page, title: title, siteURL: siteURL, timelineStore: timelineStore)
+            }
+            completion(result)
+        }
+    }
+    
+    private func prefetchPage(after page: SignificantEvents, title: String, siteURL: URL, timelineStore: SignificantEventsTimelineStore) {
+        // 0 means there are no more pages in the endpoint's cache
+        guard let nextRvStartId = page.nextRvStartId,
+              nextRvStartId != 0 else {
+            return
+        }
+        
+        timelineStore.containsPage(startingAt: nextRvStartId, title: title, siteURL: siteURL) { [weak self] (containsPage) in
+            guard !containsPage else {
+                return
+            }
+            self?.prefetchPage(startingAt: nextRvStartId, title: title, siteURL: siteURL, timelineStore: timelineStore)
+        }
+    }
+    
+    private func prefetchPage(startingAt nextRvStartId: UInt, title: String, siteURL: URL, timelineStore: SignificantEventsTimelineStore) {
+        prefetchLock.lock()
+        let isPrefetching = !prefetchingRvStartIds.insert(nextRvStartId).inserted
+        prefetchLock.unlock()
+        guard !isPrefetching else {
+            return
+        }
+        
+        fetchSignificantEvents(rvStartId: nextRvStartId, title: title, siteURL: siteURL) { [weak self] (result) in
+            if case .success(let nextPage) = result {
+                timelineStore.save(nextPage, startingAt: nextRvStartId, title: title, siteURL: siteURL)
+            }
+            
+            guard let self = self else {
+                return
+            }
+            self.prefetchLock.lock()
+            self.prefetchingRvStartIds.remove(nextRvStartId)
+            self.prefetchLock.unlock()
+        }
+    }
+    
     public func fetchSignificantEvents(rvStartId: UInt? = nil, title: String, siteURL: URL, completion: @escaping ((Result<SignificantEvents, Error>) -> Void)) {
        
         guard let url = significantEventsURL(rvStartId: rvStartId, title: title, siteURL: siteURL) else {
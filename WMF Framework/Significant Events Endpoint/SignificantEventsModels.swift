@@ -3,7 +3,7 @@ enum SignificantEventsDecodeError: Error {
     case unableToParseIntoTypedEvents
 }
 
-public struct SignificantEvents: Decodable {
+public struct SignificantEvents: Codable {
     public let nextRvStartId: UInt?
     public let sha: String?
     private let untypedEvents: [UntypedEvent]
@@ -18,7 +18,7 @@ public struct SignificantEvents: Decodable {
         case summary
     }
     
-    public struct Summary: Decodable {
+    public struct Summary: Codable {
         public let earliestTimestampString: String
         public let numChanges: UInt
         public let numUsers: UInt
@@ -32,10 +32,17 @@ public struct SignificantEvents: Decodable {
     
     public init(from decoder: Decoder) throws {
         let container = try decoder.container(keyedBy: CodingKeys.self)
-        nextRvStartId = try? container.decode(UInt.self, forKey: .nextRvStartId)
-        sha = try? container.decode(String.self, forKey: .sha)
-        summary = try container.decode(Summary.self, forKey: .summary)
+        let nextRvStartId = try? container.decode(UInt.self, forKey: .nextRvStartId)
+        let sha = try? container.decode(String.self, forKey: .sha)
+        let summary = try container.decode(Summary.self, forKey: .summary)
         let untypedEvents = try container.decode([UntypedEvent].self, forKey: .untypedEvents)
+        try self.init(nextRvStartId: nextRvStartId, sha: sha, untypedEvents: untypedEvents, summary: summary)
+    }
+    
+    init(nextRvStartId: UInt?, sha: String?, untypedEvents: [UntypedEvent], summary: Summary) throws {
+        self.nextRvStartId = nextRvStartId
+        self.sha = sha
+        self.summary = summary
         
         var typedEvents: [TypedEvent] = []
         
@@ -70,20 +77,29 @@ public struct SignificantEvents: Decodable {
         self.untypedEvents = untypedEvents
     }
     
-    public enum SnippetType: Int, Decodable {
+    // Typed events are derived from the timeline when decoding, so only the timeline is encoded
+    public func encode(to encoder: Encoder) throws {
+        var container = encoder.container(keyedBy: CodingKeys.self)
+        try container.encodeIfPresent(nextRvStartId, forKey: .nextRvStartId)
+        try container.encodeIfPresent(sha, forKey: .sha)
+        try container.encode(summary, forKey: .summary)
+        try container.encode(untypedEvents, forKey: .untypedEvents)
+    }
+    
+    public enum SnippetType: Int, Codable {
         case addedLine = 1
         case addedAndDeletedInLine = 3
         case addedAndDeletedInMovedLine = 5
     }
     
-    public enum EventOutputType: String, Decodable {
+    public enum EventOutputType: String, Codable {
         case large = "large-change"
         case small = "small-change"
         case newTalkPageTopic = "new-talk-page-topic"
         case vandalismRevert = "vandalism-revert"
     }
     
-    public enum ChangeOutputType: String, Decodable {
+    public enum ChangeOutputType: String, Codable {
         case addedText = "added-text"
         case deletedText = "deleted-text"
         case newTemplate = "new-template"
@@ -540,7 +556,7 @@ public extension SignificantEvents {
 // MARK: Untyped
 
 public extension SignificantEvents {
-    struct UntypedEvent: Decodable {
+    struct UntypedEvent: Codable {
         let outputType: EventOutputType
         let revId: UInt?
         let parentId: UInt?
@@ -572,7 +588,7 @@ public extension SignificantEvents {
             }
     }
     
-    struct UntypedChange: Decodable {
+    struct UntypedChange: Codable {
         let outputType: ChangeOutputType
         let sections: [String]
         let snippet: String?
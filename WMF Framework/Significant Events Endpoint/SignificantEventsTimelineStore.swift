@@ -0,0 +1,252 @@
+import Foundation
+import CocoaLumberjackSwift
+
+/// Pages of each article's significant events timeline, saved by the revision ID each page starts at.
+/// Pages stay valid while the article's first page has the same sha. When a first page comes back with a different sha, the article's saved pages are removed.
+/// Keeps an index of each article's last access date so the least recently viewed timelines can be evicted. Disk access happens on the store's queue.
+/// Only the pages of the most recently used article are kept in memory; other articles' pages are read from disk.
+public final class SignificantEventsTimelineStore {
+
+    public static let shared = SignificantEventsTimelineStore()
+
+    /// Number of article timelines kept by `deleteStaleCachedItems` at the low cleanup level
+    public static let maxCachedTimelineCount = 50
+
+    private struct Manifest: Codable {
+        let sha: String?
+    }
+
+    private static let manifestFileName = "Timeline.json"
+    private static let indexFileName = ".SignificantEventsIndex.plist"
+
+    private let directoryURL: URL
+    private let queue = DispatchQueue(label: "org.wikipedia.significantEvents.timelineStore")
+
+    // Only accessed on queue
+    private var cachedArticleKey: String?
+    private var cachedPages: [UInt: SignificantEvents] = [:]
+    private var lastAccessDatesByArticleKey: [String: Date]?
+
+    public init(directoryURL: URL = FileManager.default.wmf_containerURL().appendingPathComponent(SharedContainerCacheCommonNames.significantEventsCache, isDirectory: true)) {
+        self.directoryURL = directoryURL
+    }
+
+    // MARK: - Public
+
+    /// Reads the saved page of the article's timeline that starts at `rvStartId`
+    /// - Parameter completion: called on a background queue with the page, or nil if it isn't saved
+    public func page(startingAt rvStartId: UInt, title: String, siteURL: URL, completion: @escaping (SignificantEvents?) -> Void) {
+        let articleKey = Self.articleKey(title: title, siteURL: siteURL)
+        queue.async {
+            let page = self.loadPage(articleKey: articleKey, rvStartId: rvStartId)
+            DispatchQueue.global(qos: .userInitiated).async {
+                completion(page)
+            }
+        }
+    }
+
+    /// Checks for a saved page without reading it
+    /// - Parameter completion: called on a background queue
+    public func containsPage(startingAt rvStartId: UInt, title: String, siteURL: URL, completion: @escaping (Bool) -> Void) {
+        let articleKey = Self.articleKey(title: title, siteURL: siteURL)
+        queue.async {
+            let containsPage = self.cachedPage(articleKey: articleKey, rvStartId: rvStartId) != nil || FileManager.default.fileExists(atPath: self.pageFileURL(articleKey: articleKey, rvStartId: rvStartId).path)
+            DispatchQueue.global(qos: .userInitiated).async {
+                completion(containsPage)
+            }
+        }
+    }
+
+    public func save(_ page: SignificantEvents, startingAt rvStartId: UInt, title: String, siteURL: URL) {
+        let articleKey = Self.articleKey(title: title, siteURL: siteURL)
+        queue.async {
+            self.cache(page, articleKey: articleKey, rvStartId: rvStartId)
+            do {
+                try FileManager.default.createDirectory(at: self.articleDirectoryURL(articleKey: articleKey), withIntermediateDirectories: true, attributes: nil)
+                let data = try JSONEncoder().encode(page)
+                try data.write(to: self.pageFileURL(articleKey: articleKey, rvStartId: rvStartId), options: .atomic)
+                if self.loadIndex()[articleKey] == nil {
+                    self.touch(articleKey)
+                }
+            } catch let error {
+                DDLogError("Unable to save significant events page: \(error)")
+            }
+        }
+    }
+
+    /// Records the sha of the article's latest first page and marks the article's timeline as accessed. Saved pages from a timeline with a different sha are removed.
+    public func updateSha(_ sha: String?, title: String, siteURL: URL) {
+        let articleKey = Self.articleKey(title: title, siteURL: siteURL)
+        queue.async {
+            self.touch(articleKey)
+
+            let timelineDirectoryURL = self.articleDirectoryURL(articleKey: articleKey)
+            let manifestURL = timelineDirectoryURL.appendingPathComponent(Self.manifestFileName, isDirectory: false)
+            let manifest = (try? Data(contentsOf: manifestURL)).flatMap { try? JSONDecoder().decode(Manifest.self, from: $0) }
+            if let manifest, manifest.sha == sha {
+                return
+            }
+
+            self.removeCachedPages(articleKey: articleKey)
+            do {
+                if FileManager.default.fileExists(atPath: timelineDirectoryURL.path) {
+                    try FileManager.default.removeItem(at: timelineDirectoryURL)
+                }
+                try FileManager.default.createDirectory(at: timelineDirectoryURL, withIntermediateDirectories: true, attributes: nil)
+                try JSONEncoder().encode(Manifest(sha: sha)).write(to: manifestURL, options: .atomic)
+            } catch let error {
+                DDLogError("Unable to reset significant events timeline: \(error)")
+            }
+        }
+    }
+
+    /// Deletes the least recently accessed timelines beyond the limit for the cleanup level
+    /// - Parameter completion: called on a background queue once they're deleted
+    public func deleteStaleCachedItems(cleanupLevel: WMFCleanupLevel, completion: (() -> Void)? = nil) {
+        let maxCount = cleanupLevel == .high ? 0 : Self.maxCachedTimelineCount
+        queue.async {
+            defer {
+                completion?()
+            }
+
+            var index = self.loadIndex()
+            guard index.count > maxCount else {
+                return
+            }
+
+            let articleKeysToDelete = index.sorted(by: { $0.value > $1.value }).suffix(from: maxCount).map { $0.key }
+            for articleKey in articleKeysToDelete {
+                try? FileManager.default.removeItem(at: self.articleDirectoryURL(articleKey: articleKey))
+                self.removeCachedPages(articleKey: articleKey)
+                index.removeValue(forKey: articleKey)
+            }
+            self.saveIndex(index)
+        }
+    }
+
+    public func removeAll() {
+        queue.async {
+            self.cachedArticleKey = nil
+            self.cachedPages.removeAll()
+            self.lastAccessDatesByArticleKey = nil
+            try? FileManager.default.removeItem(at: self.directoryURL)
+        }
+    }
+
+    // MARK: - Private
+
+    private static func articleKey(title: String, siteURL: URL) -> String {
+        let key = "\(siteURL.host ?? "")-\(title)"
+        return key.addingPercentEncoding(withAllowedCharacters: .alphanumerics) ?? key
+    }
+
+    private func articleDirectoryURL(articleKey: String) -> URL {
+        return directoryURL.appendingPathComponent(articleKey, isDirectory: true)
+    }
+
+    private func pageFileURL(articleKey: String, rvStartId: UInt) -> URL {
+        return articleDirectoryURL(articleKey: articleKey).appendingPathComponent("\(rvStartId).json", isDirectory: false)
+    }
+
+    private var indexFileURL: URL {
+        return directoryURL.appendingPathComponent(Self.indexFileName)
+    }
+
+    // MARK: - Private (on queue)
+
+    private func cachedPage(articleKey: String, rvStartId: UInt) -> SignificantEvents? {
+        guard cachedArticleKey == articleKey else {
+            return nil
+        }
+        return cachedPages[rvStartId]
+    }
+
+    /// Caches the page, dropping the cached pages of any other article
+    private func cache(_ page: SignificantEvents, articleKey: String, rvStartId: UInt) {
+        if cachedArticleKey != articleKey {
+            cachedArticleKey = articleKey
+            cachedPages.removeAll()
+        }
+        cachedPages[rvStartId] = page
+    }
+
+    private func removeCachedPages(articleKey: String) {
+        guard cachedArticleKey == articleKey else {
+            return
+        }
+        cachedArticleKey = nil
+        cachedPages.removeAll()
+    }
+
+    private func loadPage(articleKey: String, rvStartId: UInt) -> SignificantEvents? {
+        if let page = cachedPage(articleKey: articleKey, rvStartId: rvStartId) {
+            return page
+        }
+
+        let fileURL = pageFileURL(articleKey: articleKey, rvStartId: rvStartId)
+        guard let data = try? Data(contentsOf: fileURL) else {
+            return nil
+        }
+
+        do {
+            let page = try JSONDecoder().decode(SignificantEvents.self, from: data)
+            cache(page, articleKey: articleKey, rvStartId: rvStartId)
+            return page
+        } catch let error {
+            DDLogError("Unable to read significant events page, removing: \(error)")
+            try? FileManager.default.removeItem(at: fileURL)
+            return nil
+        }
+    }
+
+    private func touch(_ articleKey: String) {
+        var index = loadIndex()
+        index[articleKey] = Date()
+        saveIndex(index)
+    }
+
+    private func loadIndex() -> [String: Date] {
+        if let lastAccessDatesByArticleKey {
+            return lastAccessDatesByArticleKey
+        }
+
+        let index: [String: Date]
+        if let data = try? Data(contentsOf: indexFileURL),
+           let decodedIndex = try? PropertyListDecoder().decode([String: Date].self, from: data) {
+            index = decodedIndex
+        } else {
+            index = rebuildIndex()
+        }
+        lastAccessDatesByArticleKey = index
+        return index
+    }
+
+    private func saveIndex(_ index: [String: Date]) {
+        lastAccessDatesByArticleKey = index
+        do {
+            try FileManager.default.createDirectory(at: directoryURL, withIntermediateDirectories: true, attributes: nil)
+            let encoder = PropertyListEncoder()
+            encoder.outputFormat = .binary
+            try encoder.encode(index).write(to: indexFileURL, options: .atomic)
+        } catch let error {
+            DDLogError("Unable to save significant events index: \(error)")
+        }
+    }
+
+    /// Directory scan for timelines saved before the index existed, or when the index is unreadable
+    private func rebuildIndex() -> [String: Date] {
+        guard let urls = try? FileManager.default.contentsOfDirectory(at: directoryURL, includingPropertiesForKeys: [.contentModificationDateKey, .isDirectoryKey], options: .skipsHiddenFiles) else {
+            return [:]
+        }
+
+        var index: [String: Date] = [:]
+        for url in urls {
+            let resourceValues = try? url.resourceValues(forKeys: [.contentModificationDateKey, .isDirectoryKey])
+            guard resourceValues?.isDirectory == true else {
+                continue
+            }
+            index[url.lastPathComponent] = resourceValues?.contentModificationDate ?? Date.distantPast
+        }
+        return index
+    }
+}
@@ -39,6 +39,9 @@ NS_ASSUME_NONNULL_BEGIN
 
 @property (nullable, nonatomic, copy) NSString *placement;
 
+@property (nonatomic) int16_t articleReferencesVersion;
+@property (nullable, nonatomic, retain) NSSet<NSManagedObject *> *articleReferences;
+
 @end
 
 NS_ASSUME_NONNULL_END
@@ -27,5 +27,7 @@
 @dynamic countOfFullContent;
 @dynamic undoTypeInteger;
 @dynamic placement;
+@dynamic articleReferencesVersion;
+@dynamic articleReferences;
 
 @end
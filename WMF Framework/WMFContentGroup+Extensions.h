@@ -39,6 +39,9 @@ typedef NS_ENUM(int32_t, WMFContentGroupKind) {
     WMFContentGroupKindSuggestedEdits = 16
 };
 
+// Bump when referencedArticleKeys changes so existing groups have their article references rebuilt
+extern const int16_t WMFContentGroupArticleReferencesVersion;
+
 typedef NS_ENUM(int16_t, WMFContentGroupUndoType) {
     WMFContentGroupUndoTypeNone = 0,
     WMFContentGroupUndoTypeContentGroupKind = 1,
@@ -94,10 +97,20 @@ typedef NS_ENUM(int16_t, WMFContentGroupUndoType) {
 - (void)updateVisibilityForUserIsLoggedIn:(BOOL)isLoggedIn;
 - (void)markDismissed;
 
+// Database keys of every article this group shows, from articleURL, contentPreview and fullContent
+@property (nonatomic, readonly) NSSet<NSString *> *referencedArticleKeys;
+
+// Syncs the articleReferences relationship with referencedArticleKeys. Called for changed groups by -[NSManagedObjectContext updateContentGroupArticleReferences].
+- (void)updateArticleReferences;
+- (BOOL)needsArticleReferencesUpdate;
+
 @end
 
 @interface NSManagedObjectContext (WMFContentGroup)
 
+// Updates article references for inserted groups and groups whose content changed. Call before saving, outside of willSave.
+- (void)updateContentGroupArticleReferences;
+
 - (nullable WMFContentGroup *)createGroupOfKind:(WMFContentGroupKind)kind forDate:(NSDate *)date withSiteURL:(nullable NSURL *)siteURL associatedContent:(nullable id<NSCoding>)associatedContent;
 
 - (nullable WMFContentGroup *)fetchOrCreateGroupForURL:(NSURL *)URL ofKind:(WMFContentGroupKind)kind forDate:(NSDate *)date withSiteURL:(nullable NSURL *)siteURL associatedContent:(nullable id<NSCoding>)associatedContent customizationBlock:(nullable void (^)(WMFContentGroup *group))customizationBlock;
@@ -9,6 +9,10 @@
 #import <WMF/WMFLogging.h>
 #import <WMF/NSCharacterSet+WMFLinkParsing.h>
 #import <WMF/MWKLanguageLinkController.h>
+#import <WMF/WMFFeedArticlePreview.h>
+#import <WMF/WMFFeedNewsStory.h>
+
+const int16_t WMFContentGroupArticleReferencesVersion = 1;
 
 @implementation WMFContentGroup (Extensions)
 
@@ -538,6 +542,111 @@
     return [self.midnightUTCDate wmf_UTCDateIsTodayLocal];
 }
 
+#pragma mark - Article References
+
+- (NSSet<NSString *> *)referencedArticleKeys {
+    NSMutableSet<NSString *> *keys = [NSMutableSet set];
+    NSString *articleKey = self.articleURL.wmf_databaseKey;
+    if (articleKey) {
+        [keys addObject:articleKey];
+    }
+
+    id contentPreview = self.contentPreview;
+    if ([contentPreview isKindOfClass:[NSURL class]]) {
+        NSString *previewKey = [(NSURL *)contentPreview wmf_databaseKey];
+        if (previewKey) {
+            [keys addObject:previewKey];
+        }
+    }
+
+    id object = self.fullContent.object;
+    if (![object isKindOfClass:[NSArray class]]) {
+        return keys;
+    }
+
+    WMFContentType contentType = self.contentType;
+    for (id obj in (NSArray *)object) {
+        switch (contentType) {
+            case WMFContentTypeURL: {
+                if (![obj isKindOfClass:[NSURL class]]) {
+                    break;
+                }
+                NSString *key = [(NSURL *)obj wmf_databaseKey];
+                if (key) {
+                    [keys addObject:key];
+                }
+            } break;
+            case WMFContentTypeTopReadPreview: {
+                if (![obj isKindOfClass:[WMFFeedTopReadArticlePreview class]]) {
+                    break;
+                }
+                NSString *key = [(WMFFeedTopReadArticlePreview *)obj articleURL].wmf_databaseKey;
+                if (key) {
+                    [keys addObject:key];
+                }
+            } break;
+            case WMFContentTypeStory: {
+                if (![obj isKindOfClass:[WMFFeedNewsStory class]]) {
+                    break;
+                }
+                for (WMFFeedArticlePreview *preview in [(WMFFeedNewsStory *)obj articlePreviews]) {
+                    NSString *key = preview.articleURL.wmf_databaseKey;
+                    if (key) {
+                        [keys addObject:key];
+                    }
+                }
+            } break;
+            default:
+                break;
+        }
+    }
+    return keys;
+}
+
+- (BOOL)needsArticleReferencesUpdate {
+    if (self.isDeleted) {
+        return NO;
+    }
+    if (self.isInserted || self.articleReferencesVersion < WMFContentGroupArticleReferencesVersion) {
+        return YES;
+    }
+    // Only the keys referencedArticleKeys reads. Changes to fullContent's object are checked on the WMFContent itself.
+    NSDictionary *changedValues = self.changedValues;
+    return changedValues[@"articleURLString"] != nil || changedValues[@"variant"] != nil || changedValues[@"contentPreview"] != nil || changedValues[@"fullContent"] != nil || changedValues[@"contentTypeInteger"] != nil;
+}
+
+- (void)updateArticleReferences {
+    NSManagedObjectContext *moc = self.managedObjectContext;
+    if (!moc) {
+        return;
+    }
+
+    NSMutableSet<NSString *> *keysToAdd = [self.referencedArticleKeys mutableCopy];
+    NSMutableArray<NSManagedObject *> *referencesToDelete = [NSMutableArray array];
+    for (NSManagedObject *reference in self.articleReferences) {
+        NSString *key = [reference valueForKey:@"articleKey"];
+        if (key && [keysToAdd containsObject:key]) {
+            [keysToAdd removeObject:key];
+        } else {
+            [referencesToDelete addObject:reference];
+        }
+    }
+
+    // Only touch the relationship when it's out of date so groups that didn't change stay unchanged
+    for (NSManagedObject *reference in referencesToDelete) {
+        [moc deleteObject:reference];
+    }
+    for (NSString *key in keysToAdd) {
+        NSManagedObject *reference = [NSEntityDescription insertNewObjectForEntityForName:@"WMFContentGroupArticleReference" inManagedObjectContext:moc];
+        [reference setValue:key forKey:@"articleKey"];
+        [reference setValue:self forKey:@"contentGroup"];
+    }
+
+    if (self.articleReferencesVersion != WMFContentGroupArticleReferencesVersion) {
+        self.articleReferencesVersion = WMFContentGroupArticleReferencesVersion;
+    }
+}
+
 - (BOOL)isRTL {
     return [MWKLanguageLinkController isLanguageRTLForContentLanguageCode:self.siteURL.wmf_contentLanguageCode];
 }
@@ -607,6 +716,26 @@
 
 @implementation NSManagedObjectContext (WMFContentGroup)
 
+- (void)updateContentGroupArticleReferences {
+    NSMutableSet<WMFContentGroup *> *groupsToUpdate = [NSMutableSet set];
+    for (NSManagedObject *object in [self.insertedObjects setByAddingObjectsFromSet:self.updatedObjects]) {
+        if ([object isKindOfClass:[WMFContentGroup class]]) {
+            WMFContentGroup *group = (WMFContentGroup *)object;
+            if ([group needsArticleReferencesUpdate]) {
+                [groupsToUpdate addObject:group];
+            }
+        } else if ([object isKindOfClass:[WMFContent class]] && object.changedValues[@"object"] != nil) {
+            WMFContentGroup *group = [(WMFContent *)object contentGroup];
+            if (group && !group.isDeleted) {
+                [groupsToUpdate addObject:group];
+            }
+        }
+    }
+    for (WMFContentGroup *group in groupsToUpdate) {
+        [group updateArticleReferences];
+    }
+}
+
 - (void)enumerateContentGroupsWithBlock:(void (^)(WMFContentGroup *_Nonnull section, BOOL *stop))block {
     if (!block) {
         return;
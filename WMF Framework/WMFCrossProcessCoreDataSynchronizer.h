@@ -8,14 +8,24 @@ NS_ASSUME_NONNULL_BEGIN
 /// Likely should be replaced with Persistent History Tracking introduced in iOS 13:
 /// https://developer.apple.com/videos/play/wwdc2017/210/
 /// https://www.avanderlee.com/swift/persistent-history-tracking-core-data/
+///
+/// Each save's inserted, updated and deleted object IDs are appended to a journal shared by every process using the same identifier.
+/// Other processes are signaled with notify_post and merge everything appended since they last read with a single merge.
 
 @interface WMFCrossProcessCoreDataSynchronizer : NSObject
 
-- (instancetype)initWithIdentifier:(NSString *)identifier storageDirectory:(NSURL *)directoryURL NS_DESIGNATED_INITIALIZER;
+- (instancetype)initWithIdentifier:(NSString *)identifier storageDirectory:(NSURL *)directoryURL;
+
+/// processIdentifier distinguishes this process's journal entries from other processes'. Defaults to a hash of the bundle identifier.
+- (instancetype)initWithIdentifier:(NSString *)identifier storageDirectory:(NSURL *)directoryURL processIdentifier:(uint64_t)processIdentifier NS_DESIGNATED_INITIALIZER;
 
 - (void)startSynchronizingContexts:(NSArray<NSManagedObjectContext *> *)contexts;
 - (void)stop;
 
+/// Merges changes other processes have journaled since the last read into the synchronized contexts.
+/// Called automatically when another process posts a change.
+- (void)readChanges;
+
 @end
 
 NS_ASSUME_NONNULL_END
@@ -1,17 +1,40 @@
 #import <WMF/WMFCrossProcessCoreDataSynchronizer.h>
 #include <notify.h>
+#include <sys/file.h>
 #import <WMF/WMF-Swift.h>
 #import <CoreData/CoreData.h>
 
-@interface WMFCrossProcessCoreDataSynchronizer () {
-    dispatch_semaphore_t _semaphore;
-    int _token;
-}
+// Journal layout, all integers little endian:
+//
+// Header
+//  magic (4 bytes), version (uint32), base offset (uint64), committed offset (uint64)
+//
+// Entries, starting at the base offset
+//  payload length (uint32), payload checksum (uint32), writer process identifier (uint64), payload
+//
+// Offsets are logical: they keep increasing across compactions so read cursors stay valid. An entry at logical offset L is at file position header size + L - base offset.
+// Only entries before the committed offset are read. A crash mid-append leaves bytes past the committed offset that the next append truncates.
+//
+// Payload
+//  For inserted, updated and deleted object IDs in turn: a varint count, then the sorted URI representations,
+//  each as a varint length of the prefix it shares with the previous URI, a varint suffix length and the suffix.
 
-@property (nonatomic, copy) NSString *identifier;
-@property (nonatomic, copy) NSURL *containerURL;
+static const uint32_t WMFCrossProcessJournalMagic = 0x4A464D57; // WMFJ
+static const uint32_t WMFCrossProcessJournalVersion = 1;
+static const off_t WMFCrossProcessJournalHeaderSize = 24;
+static const size_t WMFCrossProcessJournalEntryHeaderSize = 16;
 
-@end
+// Compaction drops entries every process has read once the journal grows past this
+static const uint64_t WMFCrossProcessJournalCompactionThreshold = 512 * 1024;
+// Past this, entries are dropped even if a process hasn't read them
+static const uint64_t WMFCrossProcessJournalMaximumLength = 8 * 1024 * 1024;
+// Cursors that haven't moved in this long belong to processes that aren't running and don't hold back compaction
+static const NSTimeInterval WMFCrossProcessJournalStaleCursorInterval = 7 * 24 * 60 * 60;
+
+typedef struct {
+    uint64_t baseOffset;
+    uint64_t committedOffset;
+} WMFCrossProcessJournalHeader;
 
 static uint64_t bundleHash(void) {
     static dispatch_once_t onceToken;
@@ -22,14 +45,129 @@ static uint64_t bundleHash(void) {
     return bundleHash;
 }
 
+#pragma mark - Encoding Utilities
+
+static uint32_t WMFCrossProcessJournalChecksum(const uint8_t *bytes, size_t length) {
+    // FNV-1a
+    uint32_t hash = 2166136261u;
+    for (size_t i = 0; i < length; i++) {
+        hash ^= bytes[i];
+        hash *= 16777619u;
+    }
+    return hash;
+}
+
+static void WMFCrossProcessJournalAppendVarint(NSMutableData *data, uint64_t value) {
+    uint8_t bytes[10];
+    size_t count = 0;
+    do {
+        uint8_t byte = value & 0x7F;
+        value >>= 7;
+        if (value) {
+            byte |= 0x80;
+        }
+        bytes[count++] = byte;
+    } while (value);
+    [data appendBytes:bytes length:count];
+}
+
+static BOOL WMFCrossProcessJournalReadVarint(const uint8_t *bytes, size_t length, size_t *position, uint64_t *value) {
+    uint64_t result = 0;
+    for (unsigned shift = 0; shift < 64; shift += 7) {
+        if (*position >= length) {
+            return NO;
+        }
+        uint8_t byte = bytes[(*position)++];
+        result |= (uint64_t)(byte & 0x7F) << shift;
+        if (!(byte & 0x80)) {
+            *value = result;
+            return YES;
+        }
+    }
+    return NO;
+}
+
+static void WMFCrossProcessJournalWriteUInt32(uint8_t *bytes, uint32_t value) {
+    uint32_t littleEndian = CFSwapInt32HostToLittle(value);
+    memcpy(bytes, &littleEndian, sizeof(littleEndian));
+}
+
+static void WMFCrossProcessJournalWriteUInt64(uint8_t *bytes, uint64_t value) {
+    uint64_t littleEndian = CFSwapInt64HostToLittle(value);
+    memcpy(bytes, &littleEndian, sizeof(littleEndian));
+}
+
+static uint32_t WMFCrossProcessJournalReadUInt32(const uint8_t *bytes) {
+    uint32_t littleEndian;
+    memcpy(&littleEndian, bytes, sizeof(littleEndian));
+    return CFSwapInt32LittleToHost(littleEndian);
+}
+
+static uint64_t WMFCrossProcessJournalReadUInt64(const uint8_t *bytes) {
+    uint64_t littleEndian;
+    memcpy(&littleEndian, bytes, sizeof(littleEndian));
+    return CFSwapInt64LittleToHost(littleEndian);
+}
+
+static BOOL WMFCrossProcessJournalWriteAll(int fd, const void *bytes, size_t length, off_t offset) {
+    size_t written = 0;
+    while (written < length) {
+        ssize_t result = pwrite(fd, (const uint8_t *)bytes + written, length - written, offset + (off_t)written);
+        if (result < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return NO;
+        }
+        written += (size_t)result;
+    }
+    return YES;
+}
+
+static NSData *WMFCrossProcessJournalReadAll(int fd, size_t length, off_t offset) {
+    NSMutableData *data = [NSMutableData dataWithLength:length];
+    size_t read = 0;
+    while (read < length) {
+        ssize_t result = pread(fd, (uint8_t *)data.mutableBytes + read, length - read, offset + (off_t)read);
+        if (result < 0 && errno == EINTR) {
+            continue;
+        }
+        if (result <= 0) {
+            return nil;
+        }
+        read += (size_t)result;
+    }
+    return data;
+}
+
+static NSArray<NSString *> *WMFCrossProcessJournalChangeKeys(void) {
+    return @[NSInsertedObjectsKey, NSUpdatedObjectsKey, NSDeletedObjectsKey];
+}
+
+@interface WMFCrossProcessCoreDataSynchronizer () {
+    int _token;
+    uint64_t _processIdentifier;
+    uint64_t _readCursor;
+}
+
+@property (nonatomic, copy) NSString *identifier;
+@property (nonatomic, copy) NSURL *containerURL;
+@property (nonatomic, copy) NSArray<NSManagedObjectContext *> *contexts;
+
+@end
+
 @implementation WMFCrossProcessCoreDataSynchronizer
 
 - (instancetype)initWithIdentifier:(NSString *)identifier storageDirectory:(NSURL *)directoryURL {
+    return [self initWithIdentifier:identifier storageDirectory:directoryURL processIdentifier:bundleHash()];
+}
+
+- (instancetype)initWithIdentifier:(NSString *)identifier storageDirectory:(NSURL *)directoryURL processIdentifier:(uint64_t)processIdentifier {
     self = [super init];
     if (self) {
-        _semaphore = dispatch_semaphore_create(1);
         self.containerURL = directoryURL;
         self.identifier = identifier;
+        _processIdentifier = processIdentifier;
     }
     return self;
 }
@@ -43,6 +181,17 @@ static uint64_t bundleHash(void) {
         DDLogError(@"missing channel name");
         return;
     }
+    self.contexts = contexts;
+    [self removeLegacyArchivedChanges];
+
+    // Changes journaled before this process started are already in the store
+    [self withJournalLock:^(int journalFD) {
+        WMFCrossProcessJournalHeader header;
+        if ([self readHeader:&header journalFD:journalFD]) {
+            [self updateReadCursor:header.committedOffset];
+        }
+    }];
+
     const char *name = [self.identifier UTF8String];
     for (NSManagedObjectContext *context in contexts) {
         [[NSNotificationCenter defaultCenter] addObserver:self selector:@selector(contextDidSave:) name:NSManagedObjectContextDidSaveNotification object:context];
@@ -52,9 +201,9 @@ static uint64_t bundleHash(void) {
         @strongify(self)
         uint64_t state;
         notify_get_state(token, &state);
-        BOOL isExternal = state != bundleHash();
+        BOOL isExternal = state != self->_processIdentifier;
         if (isExternal) {
-            [self readCrossProcessCoreDataNotificationWithState:state intoContexts:contexts];
+            [self readChanges];
         }
     });
 }
@@ -62,6 +211,7 @@ static uint64_t bundleHash(void) {
 - (void)stop {
     if (_token != 0) {
         notify_cancel(_token);
+        _token = 0;
     }
     [[NSNotificationCenter defaultCenter] removeObserver:self];
 }
@@ -73,90 +223,403 @@ static uint64_t bundleHash(void) {
 }
 
 - (void)writeCrossProcessCoreDataNotification:(NSNotification *)note {
-    dispatch_semaphore_wait(_semaphore, DISPATCH_TIME_FOREVER);
     NSDictionary *userInfo = note.userInfo;
     if (!userInfo) {
         return;
     }
 
-    uint64_t state = bundleHash();
+    NSData *payload = [self journalPayloadForUserInfo:userInfo];
+    if (!payload) {
+        return;
+    }
 
-    NSDictionary *archiveableUserInfo = [self archivableNotificationUserInfoForUserInfo:userInfo];
-    
-    NSError *archiveError = nil;
-    NSData *data = [NSKeyedArchiver archivedDataWithRootObject:archiveableUserInfo requiringSecureCoding:NO error:&archiveError];
-    if (archiveError) {
-        DDLogError(@"Error archiving cross process changes: %@", archiveError);
+    __block BOOL didAppend = NO;
+    [self withJournalLock:^(int journalFD) {
+        didAppend = [self appendPayload:payload journalFD:journalFD];
+    }];
+
+    if (!didAppend) {
         return;
     }
-    
-    NSURL *fileURL = [self archivedChangesFileURLWithState:state];
-    [data writeToURL:fileURL atomically:YES];
 
     const char *name = [self.identifier UTF8String];
-    notify_set_state(_token, state);
+    notify_set_state(_token, _processIdentifier);
     notify_post(name);
-    dispatch_semaphore_signal(_semaphore);
+}
+
+- (BOOL)appendPayload:(NSData *)payload journalFD:(int)journalFD {
+    WMFCrossProcessJournalHeader header;
+    if (![self readHeader:&header journalFD:journalFD]) {
+        return NO;
+    }
+
+    // Drop anything a crashed append left past the committed offset
+    off_t entryPosition = [self filePositionForOffset:header.committedOffset header:header];
+    if (ftruncate(journalFD, entryPosition) != 0) {
+        DDLogError(@"Error truncating cross process journal: %d", errno);
+        return NO;
+    }
+
+    NSMutableData *entry = [NSMutableData dataWithLength:WMFCrossProcessJournalEntryHeaderSize];
+    uint8_t *entryHeader = entry.mutableBytes;
+    WMFCrossProcessJournalWriteUInt32(entryHeader, (uint32_t)payload.length);
+    WMFCrossProcessJournalWriteUInt32(entryHeader + 4, WMFCrossProcessJournalChecksum(payload.bytes, payload.length));
+    WMFCrossProcessJournalWriteUInt64(entryHeader + 8, _processIdentifier);
+    [entry appendData:payload];
+
+    if (!WMFCrossProcessJournalWriteAll(journalFD, entry.bytes, entry.length, entryPosition)) {
+        DDLogError(@"Error appending to cross process journal: %d", errno);
+        return NO;
+    }
+
+    uint64_t previousCommittedOffset = header.committedOffset;
+    header.committedOffset += entry.length;
+    if (![self writeHeader:header journalFD:journalFD]) {
+        return NO;
+    }
+
+    // Nothing from other processes is waiting to be read, so this process is caught up through its own entry
+    @synchronized(self) {
+        if (_readCursor == previousCommittedOffset) {
+            [self updateReadCursor:header.committedOffset];
+        }
+    }
+
+    if (header.committedOffset - header.baseOffset > WMFCrossProcessJournalCompactionThreshold) {
+        [self compactWithHeader:header journalFD:journalFD];
+    }
+    return YES;
 }
 
 #pragma mark - Reading changes from other processes
 
-- (void)readCrossProcessCoreDataNotificationWithState:(uint64_t)state intoContexts:(NSArray<NSManagedObjectContext *> *)contexts {
-    NSURL *fileURL = [self archivedChangesFileURLWithState:state];
-    NSError *unarchiveError = nil;
-    NSDictionary *userInfo = [self unarchivedDictionaryFromFileURL:fileURL error:&unarchiveError];
-    if (unarchiveError) {
-        DDLogError(@"Error unarchiving cross process core data notification: %@", unarchiveError);
+- (void)readChanges {
+    NSArray<NSManagedObjectContext *> *contexts = self.contexts;
+    if (contexts.count == 0) {
+        return;
+    }
+
+    __block NSData *entries = nil;
+    [self withJournalLock:^(int journalFD) {
+        WMFCrossProcessJournalHeader header;
+        if (![self readHeader:&header journalFD:journalFD]) {
+            return;
+        }
+        @synchronized(self) {
+            uint64_t startOffset = self->_readCursor;
+            if (startOffset < header.baseOffset) {
+                DDLogError(@"Cross process journal was compacted past unread changes");
+                startOffset = header.baseOffset;
+            }
+            if (header.committedOffset <= startOffset) {
+                return;
+            }
+            entries = WMFCrossProcessJournalReadAll(journalFD, (size_t)(header.committedOffset - startOffset), [self filePositionForOffset:startOffset header:header]);
+            if (entries) {
+                [self updateReadCursor:header.committedOffset];
+            }
+        }
+    }];
+
+    if (!entries) {
         return;
     }
-    [NSManagedObjectContext mergeChangesFromRemoteContextSave:userInfo intoContexts:contexts];
+
+    NSDictionary *changes = [self changesFromEntries:entries];
+    if (!changes) {
+        return;
+    }
+    [NSManagedObjectContext mergeChangesFromRemoteContextSave:changes intoContexts:contexts];
 }
 
-#pragma mark - Notification Archive Utitlities
+/// Combines every other process's entries into one set of changes. Objects deleted by a later entry are only merged as deleted.
+- (nullable NSDictionary *)changesFromEntries:(NSData *)entries {
+    NSMutableSet<NSURL *> *inserted = [NSMutableSet set];
+    NSMutableSet<NSURL *> *updated = [NSMutableSet set];
+    NSMutableSet<NSURL *> *deleted = [NSMutableSet set];
+    NSArray<NSMutableSet<NSURL *> *> *changeSets = @[inserted, updated, deleted];
+
+    const uint8_t *bytes = entries.bytes;
+    size_t length = entries.length;
+    size_t position = 0;
+    while (position + WMFCrossProcessJournalEntryHeaderSize <= length) {
+        uint32_t payloadLength = WMFCrossProcessJournalReadUInt32(bytes + position);
+        uint32_t checksum = WMFCrossProcessJournalReadUInt32(bytes + position + 4);
+        uint64_t writer = WMFCrossProcessJournalReadUInt64(bytes + position + 8);
+        position += WMFCrossProcessJournalEntryHeaderSize;
+        if (payloadLength > length - position || WMFCrossProcessJournalChecksum(bytes + position, payloadLength) != checksum) {
+            DDLogError(@"Corrupt cross process journal entry");
+            break;
+        }
+        if (writer != _processIdentifier) {
+            NSArray<NSArray<NSURL *> *> *entryChanges = [self changesFromPayloadBytes:bytes + position length:payloadLength];
+            if (!entryChanges) {
+                DDLogError(@"Unreadable cross process journal entry");
+            }
+            [entryChanges enumerateObjectsUsingBlock:^(NSArray<NSURL *> *URIs, NSUInteger idx, BOOL *stop) {
+                [changeSets[idx] addObjectsFromArray:URIs];
+            }];
+            for (NSURL *URI in entryChanges.lastObject) {
+                [inserted removeObject:URI];
+                [updated removeObject:URI];
+            }
+        }
+        position += payloadLength;
+    }
 
-- (NSDictionary *)unarchivedDictionaryFromFileURL:(NSURL *)fileURL error:(NSError **)error {
-    NSData *data = [NSData dataWithContentsOfURL:fileURL];
-    NSSet *allowedClasses = [NSSet setWithArray:[NSSecureUnarchiveFromDataTransformer allowedTopLevelClasses]];
-    return [NSKeyedUnarchiver unarchivedObjectOfClasses:allowedClasses fromData:data error:error];
+    if (inserted.count == 0 && updated.count == 0 && deleted.count == 0) {
+        return nil;
+    }
+    return @{NSInsertedObjectsKey: inserted, NSUpdatedObjectsKey: updated, NSDeletedObjectsKey: deleted};
 }
 
-- (NSURL *)archivedChangesFileURLWithState:(uint64_t)state {
-    NSString *fileName = [NSString stringWithFormat:@"%llu.%@.changes", state, self.identifier];
-    return [self.containerURL URLByAppendingPathComponent:fileName isDirectory:NO];
+#pragma mark - Payload Encoding
+
+- (nullable NSData *)journalPayloadForUserInfo:(NSDictionary *)userInfo {
+    NSMutableData *payload = [NSMutableData data];
+    BOOL hasChanges = NO;
+    for (NSString *key in WMFCrossProcessJournalChangeKeys()) {
+        NSMutableArray<NSString *> *URIs = [NSMutableArray array];
+        for (id value in userInfo[key]) {
+            NSString *URI = [self URIRepresentationForValue:value].absoluteString;
+            if (URI) {
+                [URIs addObject:URI];
+            }
+        }
+        // Sorted so IDs of the same entity share the longest prefix with their neighbor
+        [URIs sortUsingSelector:@selector(compare:)];
+        hasChanges = hasChanges || URIs.count > 0;
+
+        WMFCrossProcessJournalAppendVarint(payload, URIs.count);
+        NSData *previous = nil;
+        for (NSString *URI in URIs) {
+            NSData *current = [URI dataUsingEncoding:NSUTF8StringEncoding];
+            size_t sharedLength = 0;
+            size_t maximumSharedLength = MIN(previous.length, current.length);
+            const uint8_t *previousBytes = previous.bytes;
+            const uint8_t *currentBytes = current.bytes;
+            while (sharedLength < maximumSharedLength && previousBytes[sharedLength] == currentBytes[sharedLength]) {
+                sharedLength++;
+            }
+            WMFCrossProcessJournalAppendVarint(payload, sharedLength);
+            WMFCrossProcessJournalAppendVarint(payload, current.length - sharedLength);
+            [payload appendBytes:currentBytes + sharedLength length:current.length - sharedLength];
+            previous = current;
+        }
+    }
+    return hasChanges ? payload : nil;
+}
+
+- (nullable NSArray<NSArray<NSURL *> *> *)changesFromPayloadBytes:(const uint8_t *)bytes length:(size_t)length {
+    NSMutableArray<NSArray<NSURL *> *> *changes = [NSMutableArray arrayWithCapacity:3];
+    size_t position = 0;
+    for (NSUInteger i = 0; i < WMFCrossProcessJournalChangeKeys().count; i++) {
+        uint64_t count = 0;
+        if (!WMFCrossProcessJournalReadVarint(bytes, length, &position, &count)) {
+            return nil;
+        }
+        NSMutableArray<NSURL *> *URIs = [NSMutableArray array];
+        NSMutableData *previous = [NSMutableData data];
+        for (uint64_t j = 0; j < count; j++) {
+            uint64_t sharedLength = 0;
+            uint64_t suffixLength = 0;
+            if (!WMFCrossProcessJournalReadVarint(bytes, length, &position, &sharedLength) || !WMFCrossProcessJournalReadVarint(bytes, length, &position, &suffixLength) || sharedLength > previous.length || suffixLength > length - position) {
+                return nil;
+            }
+            previous.length = (NSUInteger)sharedLength;
+            [previous appendBytes:bytes + position length:(NSUInteger)suffixLength];
+            position += suffixLength;
+
+            NSString *URIString = [[NSString alloc] initWithData:previous encoding:NSUTF8StringEncoding];
+            NSURL *URI = URIString ? [NSURL URLWithString:URIString] : nil;
+            if (URI) {
+                [URIs addObject:URI];
+            }
+        }
+        [changes addObject:URIs];
+    }
+    return changes;
 }
 
-- (nullable id)archiveableNotificationValueForValue:(id)value {
+- (nullable NSURL *)URIRepresentationForValue:(id)value {
     if ([value isKindOfClass:[NSManagedObject class]]) {
         return [[value objectID] URIRepresentation];
     } else if ([value isKindOfClass:[NSManagedObjectID class]]) {
         return [value URIRepresentation];
-    } else if ([value isKindOfClass:[NSSet class]] || [value isKindOfClass:[NSArray class]]) {
-        return [value wmf_map:^id(id obj) {
-            return [self archiveableNotificationValueForValue:obj];
-        }];
-    } else if ([value conformsToProtocol:@protocol(NSCoding)]) {
-        return value;
     } else {
         return nil;
     }
 }
 
-- (NSDictionary *)archivableNotificationUserInfoForUserInfo:(NSDictionary *)userInfo {
-    NSMutableDictionary *archiveableUserInfo = [NSMutableDictionary dictionaryWithCapacity:userInfo.count];
-    NSArray *allKeys = userInfo.allKeys;
-    for (NSString *key in allKeys) {
-        id value = userInfo[key];
-        if ([value isKindOfClass:[NSDictionary class]]) {
-            value = [self archivableNotificationUserInfoForUserInfo:value];
-        } else {
-            value = [self archiveableNotificationValueForValue:value];
+#pragma mark - Journal File
+
+- (NSURL *)journalFileURL {
+    NSString *fileName = [NSString stringWithFormat:@"%@.journal", self.identifier];
+    return [self.containerURL URLByAppendingPathComponent:fileName isDirectory:NO];
+}
+
+- (NSURL *)readCursorFileURLForProcessIdentifier:(uint64_t)processIdentifier {
+    NSString *fileName = [NSString stringWithFormat:@"%@.%llu.cursor", self.identifier, processIdentifier];
+    return [self.containerURL URLByAppendingPathComponent:fileName isDirectory:NO];
+}
+
+/// Opens the journal while holding an exclusive lock shared across processes. The journal is reopened every time because compaction replaces the file.
+- (void)withJournalLock:(void (^)(int journalFD))block {
+    NSString *lockPath = [[self journalFileURL].path stringByAppendingString:@".lock"];
+    int lockFD = open(lockPath.fileSystemRepresentation, O_RDWR | O_CREAT | O_CLOEXEC, 0644);
+    if (lockFD < 0) {
+        DDLogError(@"Error opening cross process journal lock: %d", errno);
+        return;
+    }
+    while (flock(lockFD, LOCK_EX) != 0) {
+        if (errno != EINTR) {
+            DDLogError(@"Error locking cross process journal: %d", errno);
+            close(lockFD);
+            return;
         }
-        if (value) {
-            archiveableUserInfo[key] = value;
+    }
+
+    int journalFD = open([self journalFileURL].path.fileSystemRepresentation, O_RDWR | O_CREAT | O_CLOEXEC, 0644);
+    if (journalFD < 0) {
+        DDLogError(@"Error opening cross process journal: %d", errno);
+    } else {
+        block(journalFD);
+        close(journalFD);
+    }
+
+    flock(lockFD, LOCK_UN);
+    close(lockFD);
+}
+
+/// Reads the header, writing an empty one to a new or unrecognized journal
+- (BOOL)readHeader:(WMFCrossProcessJournalHeader *)header journalFD:(int)journalFD {
+    NSData *data = WMFCrossProcessJournalReadAll(journalFD, WMFCrossProcessJournalHeaderSize, 0);
+    const uint8_t *bytes = data.bytes;
+    if (bytes && WMFCrossProcessJournalReadUInt32(bytes) == WMFCrossProcessJournalMagic && WMFCrossProcessJournalReadUInt32(bytes + 4) == WMFCrossProcessJournalVersion) {
+        header->baseOffset = WMFCrossProcessJournalReadUInt64(bytes + 8);
+        header->committedOffset = WMFCrossProcessJournalReadUInt64(bytes + 16);
+        if (header->committedOffset >= header->baseOffset) {
+            return YES;
+        }
+    }
+
+    header->baseOffset = 0;
+    header->committedOffset = 0;
+    if (ftruncate(journalFD, 0) != 0) {
+        DDLogError(@"Error resetting cross process journal: %d", errno);
+        return NO;
+    }
+    return [self writeHeader:*header journalFD:journalFD];
+}
+
+- (BOOL)writeHeader:(WMFCrossProcessJournalHeader)header journalFD:(int)journalFD {
+    uint8_t bytes[WMFCrossProcessJournalHeaderSize];
+    WMFCrossProcessJournalWriteUInt32(bytes, WMFCrossProcessJournalMagic);
+    WMFCrossProcessJournalWriteUInt32(bytes + 4, WMFCrossProcessJournalVersion);
+    WMFCrossProcessJournalWriteUInt64(bytes + 8, header.baseOffset);
+    WMFCrossProcessJournalWriteUInt64(bytes + 16, header.committedOffset);
+    if (!WMFCrossProcessJournalWriteAll(journalFD, bytes, sizeof(bytes), 0)) {
+        DDLogError(@"Error writing cross process journal header: %d", errno);
+        return NO;
+    }
+    return YES;
+}
+
+- (off_t)filePositionForOffset:(uint64_t)offset header:(WMFCrossProcessJournalHeader)header {
+    return WMFCrossProcessJournalHeaderSize + (off_t)(offset - header.baseOffset);
+}
+
+#pragma mark - Read Cursors
+
+// Called holding the journal lock, with self synchronized once synchronizing has started
+- (void)updateReadCursor:(uint64_t)offset {
+    _readCursor = offset;
+
+    uint8_t bytes[8];
+    WMFCrossProcessJournalWriteUInt64(bytes, offset);
+    NSString *path = [self readCursorFileURLForProcessIdentifier:_processIdentifier].path;
+    int fd = open(path.fileSystemRepresentation, O_WRONLY | O_CREAT | O_CLOEXEC, 0644);
+    if (fd < 0) {
+        DDLogError(@"Error opening cross process journal cursor: %d", errno);
+        return;
+    }
+    WMFCrossProcessJournalWriteAll(fd, bytes, sizeof(bytes), 0);
+    close(fd);
+}
+
+/// The lowest offset a running process still needs to read from
+- (uint64_t)minimumReadCursorWithCommittedOffset:(uint64_t)committedOffset {
+    uint64_t minimumCursor = committedOffset;
+    NSString *prefix = [self.identifier stringByAppendingString:@"."];
+    NSArray<NSURL *> *fileURLs = [[NSFileManager defaultManager] contentsOfDirectoryAtURL:self.containerURL includingPropertiesForKeys:@[NSURLContentModificationDateKey] options:NSDirectoryEnumerationSkipsHiddenFiles error:nil];
+    NSDate *staleDate = [NSDate dateWithTimeIntervalSinceNow:0 - WMFCrossProcessJournalStaleCursorInterval];
+    for (NSURL *fileURL in fileURLs) {
+        NSString *fileName = fileURL.lastPathComponent;
+        if (![fileName hasPrefix:prefix] || ![fileName.pathExtension isEqualToString:@"cursor"]) {
+            continue;
+        }
+        NSDate *modificationDate = nil;
+        [fileURL getResourceValue:&modificationDate forKey:NSURLContentModificationDateKey error:nil];
+        if (modificationDate && [modificationDate compare:staleDate] == NSOrderedAscending) {
+            [[NSFileManager defaultManager] removeItemAtURL:fileURL error:nil];
+            continue;
         }
+        NSData *data = [NSData dataWithContentsOfURL:fileURL];
+        if (data.length < 8) {
+            continue;
+        }
+        minimumCursor = MIN(minimumCursor, WMFCrossProcessJournalReadUInt64(data.bytes));
     }
-    return archiveableUserInfo;
+    return minimumCursor;
 }
 
+#pragma mark - Compaction
+
+/// Replaces the journal with one holding only entries that running processes haven't read. Called while holding the journal lock.
+- (void)compactWithHeader:(WMFCrossProcessJournalHeader)header journalFD:(int)journalFD {
+    uint64_t newBaseOffset = MAX(header.baseOffset, [self minimumReadCursorWithCommittedOffset:header.committedOffset]);
+    if (header.committedOffset - newBaseOffset > WMFCrossProcessJournalMaximumLength) {
+        newBaseOffset = header.committedOffset;
+    }
+    if (newBaseOffset == header.baseOffset) {
+        return;
+    }
+
+    NSData *unreadEntries = WMFCrossProcessJournalReadAll(journalFD, (size_t)(header.committedOffset - newBaseOffset), [self filePositionForOffset:newBaseOffset header:header]);
+    if (!unreadEntries) {
+        DDLogError(@"Error reading cross process journal for compaction: %d", errno);
+        return;
+    }
+
+    WMFCrossProcessJournalHeader compactedHeader = {.baseOffset = newBaseOffset, .committedOffset = header.committedOffset};
+    NSString *journalPath = [self journalFileURL].path;
+    NSString *temporaryPath = [journalPath stringByAppendingString:@".compacting"];
+    int temporaryFD = open(temporaryPath.fileSystemRepresentation, O_RDWR | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (temporaryFD < 0) {
+        DDLogError(@"Error creating compacted cross process journal: %d", errno);
+        return;
+    }
+    BOOL success = [self writeHeader:compactedHeader journalFD:temporaryFD] && WMFCrossProcessJournalWriteAll(temporaryFD, unreadEntries.bytes, unreadEntries.length, WMFCrossProcessJournalHeaderSize) && fsync(temporaryFD) == 0;
+    close(temporaryFD);
+
+    // rename is atomic, a crash leaves either the old or the compacted journal
+    if (!success || rename(temporaryPath.fileSystemRepresentation, journalPath.fileSystemRepresentation) != 0) {
+        DDLogError(@"Error replacing cross process journal: %d", errno);
+        unlink(temporaryPath.fileSystemRepresentation);
+    }
+}
+
+#pragma mark - Legacy Archives
+
+/// Removes the per-save archives written before changes were journaled
+- (void)removeLegacyArchivedChanges {
+    NSString *suffix = [NSString stringWithFormat:@".%@.changes", self.identifier];
+    NSArray<NSURL *> *fileURLs = [[NSFileManager defaultManager] contentsOfDirectoryAtURL:self.containerURL includingPropertiesForKeys:nil options:NSDirectoryEnumerationSkipsHiddenFiles error:nil];
+    for (NSURL *fileURL in fileURLs) {
+        if ([fileURL.lastPathComponent hasSuffix:suffix]) {
+            [[NSFileManager defaultManager] removeItemAtURL:fileURL error:nil];
+        }
+    }
+}
 
 @end
@@ -7,6 +7,12 @@ public struct WidgetCache: Codable {
 	public var settings: WidgetSettings
 	public var featuredContent: WidgetFeaturedContent?
 
+	/// Keys for `SharedContainerCache.updateCache(_:codingKey:to:default:)`
+	public enum CodingKeys: String, CodingKey {
+		case settings
+		case featuredContent
+	}
+
 	// MARK: - Public
 
 	public init(settings: WidgetSettings, featuredContent: WidgetFeaturedContent?) {
@@ -214,15 +214,11 @@ public extension WidgetController {
 
     /// This is currently unused. It will be useful when we update the main app to also update the widget's cache when it performs any updates to the featured content in the explore feed.
     func updateCacheWith(featuredContent: WidgetFeaturedContent) {
-        var updatedCache = widgetCache
-        updatedCache.featuredContent = featuredContent
-        sharedCache.saveCache(updatedCache)
+        sharedCache.updateCache(\WidgetCache.featuredContent, codingKey: WidgetCache.CodingKeys.featuredContent, to: featuredContent, default: WidgetCache(settings: .default, featuredContent: nil))
     }
 
     func updateCacheWith(settings: WidgetSettings) {
-        var updatedCache = widgetCache
-        updatedCache.settings = settings
-        sharedCache.saveCache(updatedCache)
+        sharedCache.updateCache(\WidgetCache.settings, codingKey: WidgetCache.CodingKeys.settings, to: settings, default: WidgetCache(settings: .default, featuredContent: nil))
     }
 
     /// Returns cached content if it's available for the current date in the current app selected language
@@ -33,6 +33,7 @@ let package = Package(
         .testTarget(
             name: "WMFComponentsTests",
             dependencies: ["WMFComponents",
-                           .product(name: "WMFDataMocks", package: "WMFData")])
+                           .product(name: "WMFDataMocks", package: "WMFData")],
+            resources: [.process("Resources")])
     ]
 )
@@ -35,37 +35,6 @@ public struct HtmlUtils {
         case unordered
     }
     
-    private struct StyleData {
-        var openNSRanges: [NSRange] = []
-        var completeNSRanges: [NSRange] = []
-        var targetAttributeValues: [String] = []
-    }
-    
-    private struct AllStyleData {
-        let bold: StyleData
-        let italics: StyleData
-        let link: StyleData
-        let `subscript`: StyleData
-        let superscript: StyleData
-        let strikethorugh: StyleData
-        let underline: StyleData
-        let strong: StyleData
-    }
-    
-    private struct ListInsertData {
-        let text: String
-        let index: Int
-        let stringIndex: String.Index
-    }
-    
-    private struct TagRemoveData {
-        let range: NSRange
-    }
-    
-    private struct TagAndContentRemoveData {
-        let range: NSRange
-    }
-    
     private struct ElementReplaceData {
         let range: NSRange
         let replaceText: String
@@ -78,7 +47,7 @@ public struct HtmlUtils {
     // MARK: - NSAttributedString - Public
     
     public static func nsAttributedStringFromHtml(_ html: String, styles: Styles) throws -> NSAttributedString {
-        let attributedString = NSMutableAttributedString(string: html)
+        let compiledHtml = CompiledHtml(html: html, listIndent: styles.listIndent)
         let paragraphStyle = NSMutableParagraphStyle()
         paragraphStyle.lineSpacing = styles.lineSpacing
         let attributes: [NSAttributedString.Key : Any] = [
@@ -86,547 +55,645 @@ public struct HtmlUtils {
             .foregroundColor: styles.color,
             .paragraphStyle: paragraphStyle
         ]
-        attributedString.setAttributes(attributes, range: html.fullNSRange)
-        
-        let listInsertData = try listInsertData(html: html, styles: styles)
-        insertListData(into: attributedString, listInsertData: listInsertData, styles: styles)
-        
-        let allStyleData = try allStyleData(html: attributedString.string)
-        addStyling(to: attributedString, allStyleData: allStyleData, styles: styles)
-        
-        let tagAndContentRemoveData = try tagAndContentRemoveData(html: attributedString.string)
-        removeHtmlTagAndContent(from: attributedString, tagAndContentRemoveData: tagAndContentRemoveData)
-        
-        let lineBreakReplaceData = try lineBreakReplaceData(html: attributedString.string)
-        replaceLineBreaks(from: attributedString, lineBreakReplaceData: lineBreakReplaceData)
-        
-        let tagRemoveData = try tagRemoveData(html: attributedString.string)
-        removeHtmlTags(from: attributedString, tagRemoveData: tagRemoveData)
+        let attributedString = NSMutableAttributedString(string: compiledHtml.string, attributes: attributes)
         
-        let entityReplaceData = try entityReplaceData(html: attributedString.string)
-        replaceEntities(from: attributedString, entityReplaceData: entityReplaceData)
-        
-        return attributedString
-    }
-    
-    // MARK: - NSAttributedString - Private
-    
-    private static func insertListData(into nsAttributedString: NSMutableAttributedString, listInsertData: [ListInsertData], styles: Styles) {
-        for insertData in listInsertData.reversed() {
-            let insertAttString = NSAttributedString(string: insertData.text, attributes: [
-                .foregroundColor: styles.color,
-                .font: styles.font
-            ])
-            nsAttributedString.insert(insertAttString, at: insertData.index)
-        }
-    }
-    
-    private static func addStyling(to nsAttributedString: NSMutableAttributedString, allStyleData: AllStyleData, styles: Styles) {
-
-        // Style Bold
-        for boldRange in allStyleData.bold.completeNSRanges {
-            nsAttributedString.addAttribute(.font, value: styles.boldFont, range: boldRange)
+        // List markers only have a font and color
+        for listMarkerRange in compiledHtml.listMarkerRanges {
+            attributedString.removeAttribute(.paragraphStyle, range: listMarkerRange)
         }
         
-        // Style Italic
-        for italicRange in allStyleData.italics.completeNSRanges {
-            nsAttributedString.addAttribute(.font, value: styles.italicsFont, range: italicRange)
+        // Later styles take precedence over earlier ones for the same attribute
+        for boldRange in compiledHtml.ranges(of: .bold) {
+            attributedString.addAttribute(.font, value: styles.boldFont, range: boldRange)
         }
         
-        // Style Bold and Italic, needs extra nested looping handling
-        
-        for italicRange in allStyleData.italics.completeNSRanges {
-            
-            for boldRange in allStyleData.bold.completeNSRanges {
-                if NSIntersectionRange(boldRange, italicRange) == boldRange {
-                    nsAttributedString.addAttribute(.font, value: styles.boldItalicsFont, range: boldRange)
-                }
-            }
+        for italicRange in compiledHtml.ranges(of: .italics) {
+            attributedString.addAttribute(.font, value: styles.italicsFont, range: italicRange)
         }
         
-        for boldRange in allStyleData.bold.completeNSRanges {
-            
-            for italicRange in allStyleData.italics.completeNSRanges {
-                if NSIntersectionRange(italicRange, boldRange) == italicRange {
-                    nsAttributedString.addAttribute(.font, value: styles.boldItalicsFont, range: italicRange)
-                }
-            }
+        for boldItalicRange in compiledHtml.boldItalicsRanges {
+            attributedString.addAttribute(.font, value: styles.boldItalicsFont, range: boldItalicRange)
         }
         
-        // Style Link
         if let linkColor = styles.linkColor {
-            for (linkRange, linkHref) in zip(allStyleData.link.completeNSRanges, allStyleData.link.targetAttributeValues) {
-                nsAttributedString.addAttribute(.foregroundColor, value: linkColor, range: linkRange)
-                nsAttributedString.addAttribute(.link, value: linkHref, range: linkRange)
+            for link in compiledHtml.links {
+                attributedString.addAttribute(.foregroundColor, value: linkColor, range: link.range)
+                attributedString.addAttribute(.link, value: link.href, range: link.range)
             }
         }
         
-        // Style Subscript
-        for subRange in allStyleData.subscript.completeNSRanges {
-            nsAttributedString.addAttribute(.font, value: UIFont.systemFont(ofSize: subscriptPointSize(styles: styles)), range: subRange)
-            nsAttributedString.addAttribute(.baselineOffset, value: subscriptOffset(styles: styles), range: subRange)
+        for subRange in compiledHtml.ranges(of: .subscript) {
+            attributedString.addAttribute(.font, value: UIFont.systemFont(ofSize: subscriptPointSize(styles: styles)), range: subRange)
+            attributedString.addAttribute(.baselineOffset, value: subscriptOffset(styles: styles), range: subRange)
         }
         
-        // Style Superscript
-        for supRange in allStyleData.superscript.completeNSRanges {
-            nsAttributedString.addAttribute(.font, value: UIFont.systemFont(ofSize: superscriptPointSize(styles: styles)), range: supRange)
-            nsAttributedString.addAttribute(.baselineOffset, value: superscriptOffset(styles: styles), range: supRange)
+        for supRange in compiledHtml.ranges(of: .superscript) {
+            attributedString.addAttribute(.font, value: UIFont.systemFont(ofSize: superscriptPointSize(styles: styles)), range: supRange)
+            attributedString.addAttribute(.baselineOffset, value: superscriptOffset(styles: styles), range: supRange)
         }
         
-        // Style Strikethrough
-        for strikethroughRange in allStyleData.strikethorugh.completeNSRanges {
-            nsAttributedString.addAttribute(.strikethroughStyle, value: NSUnderlineStyle.single.rawValue, range: strikethroughRange)
+        for strikethroughRange in compiledHtml.ranges(of: .strikethrough) {
+            attributedString.addAttribute(.strikethroughStyle, value: NSUnderlineStyle.single.rawValue, range: strikethroughRange)
         }
         
-        // Style Underline
-        for underlineRange in allStyleData.underline.completeNSRanges {
-            nsAttributedString.addAttribute(.underlineStyle, value: NSUnderlineStyle.single.rawValue, range: underlineRange)
+        for underlineRange in compiledHtml.ranges(of: .underline) {
+            attributedString.addAttribute(.underlineStyle, value: NSUnderlineStyle.single.rawValue, range: underlineRange)
         }
         
-        // Style Strong
         if let strongColor = styles.strongColor {
-            for strongRange in allStyleData.strong.completeNSRanges {
-                nsAttributedString.addAttribute(.foregroundColor, value: strongColor, range: strongRange)
+            for strongRange in compiledHtml.ranges(of: .strong) {
+                attributedString.addAttribute(.foregroundColor, value: strongColor, range: strongRange)
             }
         }
+        
+        return attributedString
     }
     
-    private static func removeHtmlTagAndContent(from nsAttributedString: NSMutableAttributedString, tagAndContentRemoveData: [TagAndContentRemoveData]) {
-        for removeData in tagAndContentRemoveData.reversed() {
-            nsAttributedString.replaceCharacters(in: removeData.range, with: "")
-        }
-    }
+    // MARK: - AttributedString - Public
     
-    private static func removeHtmlTags(from nsAttributedString: NSMutableAttributedString, tagRemoveData: [TagRemoveData]) {
-        for removeData in tagRemoveData.reversed() {
-            nsAttributedString.replaceCharacters(in: removeData.range, with: "")
+    public static func attributedStringFromHtml(_ html: String, styles: Styles) throws -> AttributedString {
+        let compiledHtml = CompiledHtml(html: html, listIndent: styles.listIndent)
+        let links = compiledHtml.links
+        
+        // Sweep through the style ranges, appending a run each time the styles change
+        var boundaries: [(location: Int, isLowerBound: Bool, style: RunStyle)] = []
+        func addBoundaries(of ranges: [NSRange], style: RunStyle) {
+            for range in ranges {
+                boundaries.append((range.location, true, style))
+                boundaries.append((NSMaxRange(range), false, style))
+            }
         }
-    }
-    
-    private static func replaceLineBreaks(from nsAttributedString: NSMutableAttributedString, lineBreakReplaceData: [ElementReplaceData]) {
-        for data in lineBreakReplaceData.reversed() {
-            nsAttributedString.replaceCharacters(in: data.range, with: data.replaceText)
+        addBoundaries(of: compiledHtml.ranges(of: .bold), style: .bold)
+        addBoundaries(of: compiledHtml.ranges(of: .italics), style: .italics)
+        addBoundaries(of: compiledHtml.boldItalicsRanges, style: .boldItalics)
+        addBoundaries(of: compiledHtml.ranges(of: .subscript), style: .subscript)
+        addBoundaries(of: compiledHtml.ranges(of: .superscript), style: .superscript)
+        addBoundaries(of: compiledHtml.ranges(of: .strikethrough), style: .strikethrough)
+        addBoundaries(of: compiledHtml.ranges(of: .underline), style: .underline)
+        addBoundaries(of: compiledHtml.ranges(of: .strong), style: .strong)
+        addBoundaries(of: compiledHtml.replacementRanges, style: .replacement)
+        if styles.linkColor != nil {
+            for (index, link) in links.enumerated() {
+                boundaries.append((link.range.location, true, .link(index)))
+                boundaries.append((NSMaxRange(link.range), false, .link(index)))
+            }
         }
-    }
-    
-    private static func replaceEntities(from nsAttributedString: NSMutableAttributedString, entityReplaceData: [ElementReplaceData]) {
-        for data in entityReplaceData.reversed() {
-            nsAttributedString.replaceCharacters(in: data.range, with: data.replaceText)
+        boundaries.sort { $0.location < $1.location }
+        
+        var styleCounts: [RunStyle: Int] = [:]
+        var activeLinkIndexes: [Int: Int] = [:]
+        var attributedString = AttributedString()
+        var location = 0
+        var boundaryIndex = 0
+        let length = compiledHtml.text.count
+        while location < length {
+            while boundaryIndex < boundaries.count && boundaries[boundaryIndex].location <= location {
+                let boundary = boundaries[boundaryIndex]
+                let change = boundary.isLowerBound ? 1 : -1
+                if case .link(let index) = boundary.style {
+                    activeLinkIndexes[index, default: 0] += change
+                    if activeLinkIndexes[index] == 0 {
+                        activeLinkIndexes[index] = nil
+                    }
+                } else {
+                    styleCounts[boundary.style, default: 0] += change
+                }
+                boundaryIndex += 1
+            }
+            let endLocation = boundaryIndex < boundaries.count ? min(boundaries[boundaryIndex].location, length) : length
+            var run = AttributedString(String(decoding: compiledHtml.text[location..<endLocation], as: UTF16.self))
+            
+            // Replaced line breaks and entities are unstyled, as they've always been on this path
+            if styleCounts[.replacement, default: 0] == 0 {
+                let isStyled: (RunStyle) -> Bool = { styleCounts[$0, default: 0] > 0 }
+                run.font = styles.font
+                run.foregroundColor = styles.color
+                if isStyled(.superscript) {
+                    run.font = UIFont.systemFont(ofSize: superscriptPointSize(styles: styles))
+                    run.baselineOffset = superscriptOffset(styles: styles)
+                } else if isStyled(.subscript) {
+                    run.font = UIFont.systemFont(ofSize: subscriptPointSize(styles: styles))
+                    run.baselineOffset = subscriptOffset(styles: styles)
+                } else if isStyled(.boldItalics) {
+                    run.font = styles.boldItalicsFont
+                } else if isStyled(.italics) {
+                    run.font = styles.italicsFont
+                } else if isStyled(.bold) {
+                    run.font = styles.boldFont
+                }
+                if let linkColor = styles.linkColor,
+                   let linkIndex = activeLinkIndexes.keys.max() {
+                    run.foregroundColor = linkColor
+                    run.link = URL(string: links[linkIndex].href)
+                }
+                if isStyled(.strikethrough) {
+                    run.strikethroughStyle = .single
+                }
+                if isStyled(.underline) {
+                    run.underlineStyle = .single
+                }
+                if let strongColor = styles.strongColor,
+                   isStyled(.strong) {
+                    run.foregroundColor = strongColor
+                }
+            }
+            
+            attributedString.append(run)
+            location = endLocation
         }
-    }
-    
-    // MARK: - AttributedString - Public
-    
-    public static func attributedStringFromHtml(_ html: String, styles: Styles) throws -> AttributedString {
-        
-        var attributedString = AttributedString(html)
-        attributedString.font = styles.font
-        attributedString.foregroundColor = styles.color
-        
-        let listInsertData = try listInsertData(html: html, styles: styles)
-        insertListData(into: &attributedString, listInsertData: listInsertData, styles: styles)
-        
-        let allStyleData = try allStyleData(html: String(attributedString.characters))
-        addStyling(to: &attributedString, allStyleData: allStyleData, styles: styles)
-
-        let tagAndContentRemoveData = try tagAndContentRemoveData(html: String(attributedString.characters))
-        removeHtmlTagAndContent(from: &attributedString, tagAndContentRemoveData: tagAndContentRemoveData)
-        
-        let lineBreakReplaceData = try lineBreakReplaceData(html: String(attributedString.characters))
-        replaceLineBreaks(from: &attributedString, lineBreakReplaceData: lineBreakReplaceData)
-        
-        let tagRemoveData = try tagRemoveData(html: String(attributedString.characters))
-        removeHtmlTags(from: &attributedString, tagRemoveData: tagRemoveData)
-        
-        let entityReplaceData = try entityReplaceData(html: String(attributedString.characters))
-        replaceEntities(from: &attributedString, entityReplaceData: entityReplaceData)
         
         return attributedString
     }
     
-    // MARK: - AttributedString - Private
-    
-    private static func insertListData(into attributedString: inout AttributedString, listInsertData: [ListInsertData], styles: Styles) {
-        for insertData in listInsertData.reversed() {
+    public static func stringFromHTML(_ string: String) throws -> String {
+        let regex = try htmlTagRegex()
+        let cleanString = regex.stringByReplacingMatches(in: string, options: [], range: string.fullNSRange, withTemplate: "")
+        let entityReplaceData = try entityReplaceData(html: cleanString)
+            let mutableCleanString = NSMutableString(string: cleanString)
+            for data in entityReplaceData.reversed() {
+                mutableCleanString.replaceCharacters(in: data.range, with: data.replaceText)
+            }
+            return mutableCleanString as String
+    }
+
+    // MARK: - Shared - Compiling
+    
+    private enum Style: Int, CaseIterable {
+        case bold
+        case italics
+        case link
+        case `subscript`
+        case superscript
+        case strikethrough
+        case underline
+        case strong
+        
+        init?(tagName: ArraySlice<UInt16>) {
+            guard tagName.count <= 6 else {
+                return nil
+            }
             
-            if let attStringIndex = AttributedString.Index(insertData.stringIndex, within: attributedString) {
-                var insertAttString = AttributedString(insertData.text)
-                insertAttString.foregroundColor = styles.color
-                insertAttString.font = styles.font
-                attributedString.insert(insertAttString, at: attStringIndex)
+            switch String(decoding: tagName, as: UTF16.self) {
+            case "b": self = .bold
+            case "i": self = .italics
+            case "a": self = .link
+            case "sub": self = .subscript
+            case "sup": self = .superscript
+            case "s": self = .strikethrough
+            case "u": self = .underline
+            case "strong": self = .strong
+            default: return nil
             }
         }
     }
     
-    private static func addStyling(to attributedString: inout AttributedString, allStyleData: AllStyleData, styles: Styles) {
+    private enum RunStyle: Hashable {
+        case bold
+        case italics
+        case boldItalics
+        case `subscript`
+        case superscript
+        case strikethrough
+        case underline
+        case strong
+        case replacement
+        case link(Int)
+    }
+    
+    /// The text of some HTML and the ranges to style it with, found in one walk through the HTML. Ranges are in UTF-16 offsets of the text.
+    private struct CompiledHtml {
         
-        // Style Bold
-        for boldNSRange in allStyleData.bold.completeNSRanges {
-            if let boldRange = Range(boldNSRange, in: attributedString) {
-                attributedString[boldRange].font = styles.boldFont
-            }
+        private struct OpenTag {
+            var location: Int
+            let htmlLocation: Int
         }
         
-        // Style Italic
-        for italicNSRange in allStyleData.italics.completeNSRanges {
-            if let italicRange = Range(italicNSRange, in: attributedString) {
-                attributedString[italicRange].font = styles.italicsFont
+        private struct StyleRange {
+            var location: Int
+            var endLocation: Int
+            // Where the opening tag starts and the closing tag ends in the HTML, to tell whether styles are nested
+            let htmlLocation: Int
+            let htmlEndLocation: Int
+            
+            var range: NSRange {
+                return NSRange(location: location, length: endLocation - location)
             }
         }
         
-        // Style Bold and Italic, needs extra nested looping handling
-        for italicNSRange in allStyleData.italics.completeNSRanges {
-            
-            for boldNSRange in allStyleData.bold.completeNSRanges {
+        private(set) var text: [UInt16] = []
+        private(set) var listMarkerRanges: [NSRange] = []
+        /// Line breaks and entities
+        private(set) var replacementRanges: [NSRange] = []
+        private var openTags: [[OpenTag]] = Array(repeating: [], count: Style.allCases.count)
+        private var styleRanges: [[StyleRange]] = Array(repeating: [], count: Style.allCases.count)
+        private var hrefs: [String] = []
+        private var lastStyleBoundaryLocation = 0
+        private var entityLocation: Int?
+        private var listTypes: [ListType] = []
+        private var orderedListCounts: [Int] = []
+        
+        init(html: String, listIndent: String) {
+            let html = Array(html.utf16)
+            text.reserveCapacity(html.count)
+            var hasTags = true
+            var index = 0
+            while index < html.count {
+                guard hasTags,
+                      html[index] == UTF16Unit.lessThan else {
+                    append(html[index])
+                    index += 1
+                    continue
+                }
                 
-                if let boldRange = Range(boldNSRange, in: attributedString),
-                   let italicRange = Range(italicNSRange, in: attributedString) {
-                    
-                    if boldRange.clamped(to: italicRange) == boldRange {
-                        attributedString[boldRange].font = styles.boldItalicsFont
-                    }
+                guard let tagEndIndex = html[(index + 1)...].firstIndex(of: UTF16Unit.greaterThan) else {
+                    // Without a closing bracket, this and every later opening bracket is text
+                    hasTags = false
+                    continue
+                }
+                
+                if let elementEndIndex = removedElementEndIndex(in: html, at: index) {
+                    index = elementEndIndex
+                    continue
                 }
-            }
-        }
-        
-        for boldNSRange in allStyleData.bold.completeNSRanges {
-            
-            for italicNSRange in allStyleData.italics.completeNSRanges {
                 
-                if let boldRange = Range(boldNSRange, in: attributedString),
-                   let italicRange = Range(italicNSRange, in: attributedString) {
-                    
-                    if italicRange.clamped(to: boldRange) == italicRange {
-                        attributedString[italicRange].font = styles.boldItalicsFont
+                updateLists(html: html, tagIndex: index, tagEndIndex: tagEndIndex, listIndent: listIndent)
+                
+                var tagNameEndIndex = index + 1
+                while tagNameEndIndex < tagEndIndex && UTF16Unit.isTagName(html[tagNameEndIndex]) {
+                    tagNameEndIndex += 1
+                }
+                let tagName = html[(index + 1)..<tagNameEndIndex]
+                
+                if UTF16Unit.isLineBreakTag(html[index...tagEndIndex]) {
+                    let location = text.count
+                    append(UTF16Unit.newline)
+                    replacementRanges.append(NSRange(location: location, length: 1))
+                } else if tagName.first == UTF16Unit.slash,
+                          let style = Style(tagName: tagName.dropFirst()) {
+                    close(style, htmlEndLocation: tagEndIndex + 1)
+                } else if let style = Style(tagName: tagName) {
+                    open(style, htmlLocation: index)
+                    if style == .link,
+                       let href = href(in: html[index...tagEndIndex]) {
+                        hrefs.append(href)
                     }
-                    
                 }
+                
+                index = tagEndIndex + 1
             }
         }
         
-        // Style Link
-        if let linkColor = styles.linkColor {
-            for (linkNSRange, hrefString) in zip(allStyleData.link.completeNSRanges, allStyleData.link.targetAttributeValues) {
-                if let linkRange = Range(linkNSRange, in: attributedString) {
-                    attributedString[linkRange].foregroundColor = linkColor
-                    attributedString[linkRange].link = URL(string:hrefString)
-                }
-            }
+        var string: String {
+            return String(decoding: text, as: UTF16.self)
         }
         
-        // Style Subscript
-        for subNSRange in allStyleData.subscript.completeNSRanges {
-            if let subRange = Range(subNSRange, in: attributedString) {
-                attributedString[subRange].font = UIFont.systemFont(ofSize: subscriptPointSize(styles: styles))
-                attributedString[subRange].baselineOffset = subscriptOffset(styles: styles)
-            }
+        func ranges(of style: Style) -> [NSRange] {
+            return styleRanges[style.rawValue].map { $0.range }
         }
         
-        // Style Superscript
-        for supNSRange in allStyleData.superscript.completeNSRanges {
-            if let supRange = Range(supNSRange, in: attributedString) {
-                attributedString[supRange].font = UIFont.systemFont(ofSize: superscriptPointSize(styles: styles))
-                attributedString[supRange].baselineOffset = superscriptOffset(styles: styles)
-            }
+        /// Bold ranges nested in an italic range and italic ranges nested in a bold range
+        var boldItalicsRanges: [NSRange] {
+            let boldRanges = styleRanges[Style.bold.rawValue]
+            let italicsRanges = styleRanges[Style.italics.rawValue]
+            return Self.ranges(boldRanges, nestedIn: italicsRanges) + Self.ranges(italicsRanges, nestedIn: boldRanges)
         }
         
-        // Style Strikethrough
-        for strikethroughNSRange in allStyleData.strikethorugh.completeNSRanges {
-            if let strikethroughRange = Range(strikethroughNSRange, in: attributedString) {
-                attributedString[strikethroughRange].strikethroughStyle = .single
-            }
+        /// Links are paired with the `href`s of opening tags in order, so a link without an `href` takes the next one's
+        var links: [(range: NSRange, href: String)] {
+            return zip(styleRanges[Style.link.rawValue], hrefs).map { ($0.range, $1) }
         }
         
-        // Style Underline
-        for underlineNSRange in allStyleData.underline.completeNSRanges {
-            if let underlineRange = Range(underlineNSRange, in: attributedString) {
-                attributedString[underlineRange].underlineStyle = .single
+        private static func ranges(_ innerRanges: [StyleRange], nestedIn outerRanges: [StyleRange]) -> [NSRange] {
+            guard !innerRanges.isEmpty && !outerRanges.isEmpty else {
+                return []
             }
-        }
-
-        // Style Strong
-        if let strongColor = styles.strongColor {
-            for strongNSRange in allStyleData.strong.completeNSRanges {
-                if let strongRange  = Range(strongNSRange, in: attributedString) {
-                    attributedString[strongRange].foregroundColor = strongColor
+            
+            // For each outer range sorted by start, the furthest end of it and the ranges before it
+            let sortedOuterRanges = outerRanges.sorted { $0.htmlLocation < $1.htmlLocation }
+            var furthestEndLocations: [Int] = []
+            furthestEndLocations.reserveCapacity(sortedOuterRanges.count)
+            for outerRange in sortedOuterRanges {
+                furthestEndLocations.append(max(furthestEndLocations.last ?? 0, outerRange.htmlEndLocation))
+            }
+            
+            return innerRanges.compactMap { innerRange in
+                // Find the outer ranges starting at or before the inner range
+                var lowerIndex = 0
+                var upperIndex = sortedOuterRanges.count
+                while lowerIndex < upperIndex {
+                    let middleIndex = (lowerIndex + upperIndex) / 2
+                    if sortedOuterRanges[middleIndex].htmlLocation <= innerRange.htmlLocation {
+                        lowerIndex = middleIndex + 1
+                    } else {
+                        upperIndex = middleIndex
+                    }
+                }
+                guard lowerIndex > 0,
+                      furthestEndLocations[lowerIndex - 1] >= innerRange.htmlEndLocation else {
+                    return nil
                 }
+                return innerRange.range
             }
         }
-    }
-    
-    private static func removeHtmlTagAndContent(from attributedString: inout AttributedString, tagAndContentRemoveData: [TagAndContentRemoveData]) {
         
-        for removeData in tagAndContentRemoveData.reversed() {
-            
-            guard let tagRange = Range(removeData.range, in: attributedString) else {
-                continue
+        // MARK: Text
+        
+        /// Appends a unit of text, replacing entities as they're completed
+        private mutating func append(_ unit: UInt16) {
+            if let entityLocation {
+                if unit == UTF16Unit.semicolon {
+                    self.entityLocation = nil
+                    if text.count - entityLocation > 1,
+                       replaceEntity(at: entityLocation) {
+                        return
+                    }
+                } else if UTF16Unit.isWhitespace(unit) {
+                    self.entityLocation = nil
+                }
+            } else if unit == UTF16Unit.ampersand {
+                entityLocation = text.count
             }
-            
-            attributedString.removeSubrange(tagRange)
+            text.append(unit)
         }
-    }
-    
-    private static func removeHtmlTags(from attributedString: inout AttributedString, tagRemoveData: [TagRemoveData]) {
         
-        for removeData in tagRemoveData.reversed() {
-            
-            guard let tagRange = Range(removeData.range, in: attributedString) else {
-                continue
+        private mutating func append(_ string: String) {
+            for unit in string.utf16 {
+                append(unit)
             }
-            
-            attributedString.removeSubrange(tagRange)
         }
-    }
-    
-    private static func replaceLineBreaks(from attributedString: inout AttributedString, lineBreakReplaceData: [ElementReplaceData]) {
         
-        for data in lineBreakReplaceData.reversed() {
+        private mutating func replaceEntity(at location: Int) -> Bool {
+            guard text.count - location < 7 else {
+                return false
+            }
             
-            guard let range = Range(data.range, in: attributedString) else {
-                continue
+            let entity = String(decoding: text[location...], as: UTF16.self) + ";"
+            guard let replacement = HtmlUtils.entityReplacements[entity] else {
+                return false
             }
             
-            attributedString.replaceSubrange(range, with: AttributedString(data.replaceText))
+            text.removeSubrange(location...)
+            text.append(contentsOf: replacement.utf16)
+            replacementRanges.append(NSRange(location: location, length: text.count - location))
+            
+            // Tags inside an entity were removed before it was replaced, styles starting after its first character don't include it
+            if lastStyleBoundaryLocation > location {
+                let replacementEndLocation = text.count
+                let adjustedLocation: (Int) -> Int = { $0 > location ? replacementEndLocation : $0 }
+                for styleIndex in openTags.indices {
+                    for tagIndex in openTags[styleIndex].indices {
+                        openTags[styleIndex][tagIndex].location = adjustedLocation(openTags[styleIndex][tagIndex].location)
+                    }
+                    for rangeIndex in styleRanges[styleIndex].indices {
+                        styleRanges[styleIndex][rangeIndex].location = adjustedLocation(styleRanges[styleIndex][rangeIndex].location)
+                        styleRanges[styleIndex][rangeIndex].endLocation = adjustedLocation(styleRanges[styleIndex][rangeIndex].endLocation)
+                    }
+                }
+                lastStyleBoundaryLocation = replacementEndLocation
+            }
+            return true
         }
-    }
-    
-    private static func replaceEntities(from attributedString: inout AttributedString, entityReplaceData: [ElementReplaceData]) {
         
-        for data in entityReplaceData.reversed() {
-            
-            guard let range = Range(data.range, in: attributedString) else {
-                continue
+        // MARK: Tags
+        
+        private mutating func open(_ style: Style, htmlLocation: Int) {
+            openTags[style.rawValue].append(OpenTag(location: text.count, htmlLocation: htmlLocation))
+            lastStyleBoundaryLocation = text.count
+        }
+        
+        private mutating func close(_ style: Style, htmlEndLocation: Int) {
+            guard let openTag = openTags[style.rawValue].popLast() else {
+                return
             }
             
-            attributedString.replaceSubrange(range, with: AttributedString(data.replaceText))
+            styleRanges[style.rawValue].append(StyleRange(location: openTag.location, endLocation: text.count, htmlLocation: openTag.htmlLocation, htmlEndLocation: htmlEndLocation))
+            lastStyleBoundaryLocation = text.count
         }
-    }
-
-    public static func stringFromHTML(_ string: String) throws -> String {
-        let regex = try htmlTagRegex()
-        let cleanString = regex.stringByReplacingMatches(in: string, options: [], range: string.fullNSRange, withTemplate: "")
-        let entityReplaceData = try entityReplaceData(html: cleanString)
-            let mutableCleanString = NSMutableString(string: cleanString)
-            for data in entityReplaceData.reversed() {
-                mutableCleanString.replaceCharacters(in: data.range, with: data.replaceText)
+        
+        private func href(in tag: ArraySlice<UInt16>) -> String? {
+            guard let hrefRegex = HtmlUtils.hrefRegex else {
+                return nil
             }
-            return mutableCleanString as String
-    }
-
-    // MARK: - Shared - Private
-    
-    private static func htmlTagRegex() throws -> NSRegularExpression {
-        return try NSRegularExpression(pattern: "(?:<)([\\/a-z0-9]*)(?:\\s?)([^>]*)(?:>)")
-    }
-    
-    private static func lineBreakRegex() throws -> NSRegularExpression {
-        return try NSRegularExpression(pattern: "<br(?: ?\\/?)?>")
-    }
-    
-    private static func entityRegex() throws -> NSRegularExpression {
-        return try NSRegularExpression(pattern: "&([^\\s;]+);")
-    }
-    
-    private static func subscriptPointSize(styles: Styles) -> CGFloat {
-        return styles.font.pointSize * 0.75
-    }
-    
-    private static func subscriptOffset(styles: Styles) -> CGFloat {
-        return -(styles.font.pointSize * 0.15)
-    }
-    
-    private static func superscriptPointSize(styles: Styles) -> CGFloat {
-        return styles.font.pointSize * 0.75
-    }
-    
-    private static func superscriptOffset(styles: Styles) -> CGFloat {
-        return styles.font.pointSize * 0.35
-    }
-    
-    private static func listInsertData(html: String, styles: Styles) throws -> [ListInsertData] {
-        
-        // First enumerate through all list tags and capture insert data
-        let listTagRegex = try NSRegularExpression(pattern: "(?:<)((?:\\/?)(?:ol|ul|li))(?:\\s?)([^>]*)(?:>)")
-        var types: [ListType] = []
-        var indent: Int = 0
-        var orderedListCounts: [Int] = []
-        var inserts: [ListInsertData] = []
-        listTagRegex.enumerateMatches(in: html, range: html.fullNSRange) { match, flags, stop in
             
-            guard let tagNSRange = match?.range(at: 0),
-                  let tagRange = Range(tagNSRange, in: html),
-                  let tagNameNSRange = match?.range(at: 1),
-                  let tagNameRange = Range(tagNameNSRange, in: html) else {
-                return
+            let tagString = String(decoding: tag, as: UTF16.self)
+            guard let match = hrefRegex.firstMatch(in: tagString, range: tagString.fullNSRange),
+                  let hrefRange = Range(match.range(at: 1), in: tagString) else {
+                return nil
             }
             
-            let tagNameString = html[tagNameRange]
-            if tagNameString == "ol" {
-                types.append(.ordered)
-                indent = indent + 1
-                orderedListCounts.append(0)
-            } else if tagNameString == "ul" {
-                types.append(.unordered)
-                indent = indent + 1
+            return String(tagString[hrefRange])
+        }
+        
+        /// Tags starting with `ol`, `ul` or `li` nest lists, and list items are prefixed with a number or bullet
+        private mutating func updateLists(html: [UInt16], tagIndex: Int, tagEndIndex: Int, listIndent: String) {
+            var nameIndex = tagIndex + 1
+            let isClosingTag = html[nameIndex] == UTF16Unit.slash
+            if isClosingTag {
+                nameIndex += 1
             }
-            
-            if tagNameString == "/ol" {
-                types.removeLast()
-                indent = indent - 1
-                orderedListCounts.removeLast()
-            } else if tagNameString == "/ul" {
-                types.removeLast()
-                indent = indent - 1
+            guard nameIndex + 2 <= tagEndIndex else {
+                return
             }
             
-            if tagNameString == "li" {
-                
-                guard let currentListType = types.last else {
-                    return
-                }
-                
-                if case .ordered = currentListType {
-                    if let lastOrderedListCount = orderedListCounts.popLast() {
-                        orderedListCounts.append(lastOrderedListCount + 1)
+            switch (html[nameIndex], html[nameIndex + 1]) {
+            case (UTF16Unit.o, UTF16Unit.l):
+                if isClosingTag {
+                    guard !listTypes.isEmpty else {
+                        return
                     }
+                    listTypes.removeLast()
+                    _ = orderedListCounts.popLast()
+                } else {
+                    listTypes.append(.ordered)
+                    orderedListCounts.append(0)
                 }
-                
-                let spaces = String(repeating: styles.listIndent, count: indent)
-                
-                var lineBreakPrefix = ""
-                if tagRange.lowerBound > html.startIndex {
-                    let previousIndex = html.index(before: tagRange.lowerBound)
-                    if html[previousIndex] != "\n" {
-                        lineBreakPrefix = "\n"
+            case (UTF16Unit.u, UTF16Unit.l):
+                if isClosingTag {
+                    guard !listTypes.isEmpty else {
+                        return
                     }
+                    listTypes.removeLast()
+                } else {
+                    listTypes.append(.unordered)
+                }
+            case (UTF16Unit.l, UTF16Unit.i):
+                guard !isClosingTag,
+                      let listType = listTypes.last else {
+                    return
                 }
                 
-                switch currentListType {
+                // Start a new line unless the item is already on one. A carriage return and line feed is not a line feed on its own.
+                let isAtLineStart = tagIndex > 0 && html[tagIndex - 1] == UTF16Unit.newline && !(tagIndex > 1 && html[tagIndex - 2] == UTF16Unit.carriageReturn)
+                let lineBreakPrefix = tagIndex > 0 && !isAtLineStart ? "\n" : ""
+                let spaces = String(repeating: listIndent, count: listTypes.count)
+                let marker: String
+                switch listType {
                 case .ordered:
-                    if let count = orderedListCounts.last {
-                        inserts.append(ListInsertData(text: "\(lineBreakPrefix)\(spaces)\(count). ", index: tagNSRange.upperBound, stringIndex: tagRange.upperBound))
+                    guard let count = orderedListCounts.popLast() else {
+                        return
                     }
+                    orderedListCounts.append(count + 1)
+                    marker = "\(lineBreakPrefix)\(spaces)\(count + 1). "
                 case .unordered:
-                    inserts.append(ListInsertData(text: "\(lineBreakPrefix)\(spaces)• ", index: tagNSRange.upperBound, stringIndex: tagRange.upperBound))
+                    marker = "\(lineBreakPrefix)\(spaces)• "
                 }
+                
+                let location = text.count
+                append(marker)
+                listMarkerRanges.append(NSRange(location: location, length: text.count - location))
+            default:
+                break
             }
         }
         
-        return inserts
-    }
-    
-    private static func allStyleData(html: String) throws -> AllStyleData {
-        
-        let htmlTagRegex = try htmlTagRegex()
-        
-        var boldStyleData = StyleData()
-        var italicsStyleData = StyleData()
-        var linkStyleData = StyleData()
-        var subscriptStyleData = StyleData()
-        var superscriptStyleData = StyleData()
-        var strikethroughStyleData = StyleData()
-        var underlineStyleData = StyleData()
-        var strongStyleData = StyleData()
-
-        htmlTagRegex.enumerateMatches(in: html, range: html.fullNSRange) { match, flags, stop in
-            
-            guard let tagNSRange = match?.range(at: 0),
-                  let tagNameNSRange = match?.range(at: 1) else {
-                return
+        /// `script` and `style` elements on a single line are removed with their content
+        private func removedElementEndIndex(in html: [UInt16], at index: Int) -> Int? {
+            let closingTag: [UInt16]
+            let nameEndIndex: Int
+            if UTF16Unit.hasPrefix(UTF16Unit.script, in: html, at: index + 1) {
+                closingTag = UTF16Unit.scriptClosingTag
+                nameEndIndex = index + 1 + UTF16Unit.script.count
+            } else if UTF16Unit.hasPrefix(UTF16Unit.style, in: html, at: index + 1) {
+                closingTag = UTF16Unit.styleClosingTag
+                nameEndIndex = index + 1 + UTF16Unit.style.count
+            } else {
+                return nil
             }
             
-            updateStyleData(styleData: &boldStyleData, html: html, tagNSRange: tagNSRange, tagNameNSRange: tagNameNSRange, targetTagName: "b", targetAttributeName: nil)
-            updateStyleData(styleData: &italicsStyleData, html: html, tagNSRange: tagNSRange, tagNameNSRange: tagNameNSRange, targetTagName: "i", targetAttributeName: nil)
-            updateStyleData(styleData: &linkStyleData, html: html, tagNSRange: tagNSRange, tagNameNSRange: tagNameNSRange, targetTagName: "a", targetAttributeName: "href")
-            updateStyleData(styleData: &subscriptStyleData, html: html, tagNSRange: tagNSRange, tagNameNSRange: tagNameNSRange, targetTagName: "sub", targetAttributeName: nil)
-            updateStyleData(styleData: &superscriptStyleData, html: html, tagNSRange: tagNSRange, tagNameNSRange: tagNameNSRange, targetTagName: "sup", targetAttributeName: nil)
-            updateStyleData(styleData: &strikethroughStyleData, html: html, tagNSRange: tagNSRange, tagNameNSRange: tagNameNSRange, targetTagName: "s", targetAttributeName: nil)
-            updateStyleData(styleData: &underlineStyleData, html: html, tagNSRange: tagNSRange, tagNameNSRange: tagNameNSRange, targetTagName: "u", targetAttributeName: nil)
-            updateStyleData(styleData: &strongStyleData, html: html, tagNSRange: tagNSRange, tagNameNSRange: tagNameNSRange, targetTagName: "strong", targetAttributeName: nil)
+            var searchIndex = nameEndIndex
+            while searchIndex < html.count && html[searchIndex] != UTF16Unit.greaterThan {
+                guard !UTF16Unit.isLineTerminator(html[searchIndex]) else {
+                    return nil
+                }
+                searchIndex += 1
+            }
+            searchIndex += 1
+            while searchIndex + closingTag.count <= html.count {
+                if UTF16Unit.hasPrefix(closingTag, in: html, at: searchIndex) {
+                    return searchIndex + closingTag.count
+                }
+                guard !UTF16Unit.isLineTerminator(html[searchIndex]) else {
+                    return nil
+                }
+                searchIndex += 1
+            }
+            return nil
+        }
+    }
+    
+    private enum UTF16Unit {
+        static let lessThan = UInt16(ascii: "<")
+        static let greaterThan = UInt16(ascii: ">")
+        static let slash = UInt16(ascii: "/")
+        static let ampersand = UInt16(ascii: "&")
+        static let semicolon = UInt16(ascii: ";")
+        static let space = UInt16(ascii: " ")
+        static let newline = UInt16(ascii: "\n")
+        static let carriageReturn = UInt16(ascii: "\r")
+        static let l = UInt16(ascii: "l")
+        static let i = UInt16(ascii: "i")
+        static let o = UInt16(ascii: "o")
+        static let u = UInt16(ascii: "u")
+        static let script = Array("script".utf16)
+        static let style = Array("style".utf16)
+        static let scriptClosingTag = Array("</script>".utf16)
+        static let styleClosingTag = Array("</style>".utf16)
+        static let lineBreakTags = ["<br>", "<br/>", "<br >", "<br />"].map { Array($0.utf16) }
+        
+        static func isTagName(_ unit: UInt16) -> Bool {
+            switch unit {
+            case UInt16(ascii: "a")...UInt16(ascii: "z"), UInt16(ascii: "0")...UInt16(ascii: "9"), slash:
+                return true
+            default:
+                return false
+            }
         }
         
-        return AllStyleData(bold: boldStyleData, italics: italicsStyleData, link: linkStyleData, subscript: subscriptStyleData, superscript: superscriptStyleData, strikethorugh: strikethroughStyleData, underline: underlineStyleData, strong: strongStyleData)
-    }
-    
-    private static func updateStyleData(styleData: inout StyleData, html: String, tagNSRange: NSRange, tagNameNSRange: NSRange, targetTagName: String, targetAttributeName: String?) {
+        static func isLineBreakTag(_ tag: ArraySlice<UInt16>) -> Bool {
+            return tag.count <= 6 && lineBreakTags.contains { $0.elementsEqual(tag) }
+        }
         
-        guard let tagNameRange = Range(tagNameNSRange, in: html),
-        let tagRange = Range(tagNSRange, in: html) else {
-            return
+        /// Matches `\s` in regular expressions
+        static func isWhitespace(_ unit: UInt16) -> Bool {
+            switch unit {
+            case 0x09, 0x0A, 0x0C, 0x0D, space:
+                return true
+            case 0..<0x80:
+                return false
+            default:
+                guard let scalar = Unicode.Scalar(unit) else {
+                    return false
+                }
+                switch scalar.properties.generalCategory {
+                case .spaceSeparator, .lineSeparator, .paragraphSeparator:
+                    return true
+                default:
+                    return false
+                }
+            }
         }
         
-        let tagNameString = html[tagNameRange]
-        let tagString = String(html[tagRange])
+        /// Characters `.` doesn't match in regular expressions
+        static func isLineTerminator(_ unit: UInt16) -> Bool {
+            switch unit {
+            case 0x0A...0x0D, 0x85, 0x2028, 0x2029:
+                return true
+            default:
+                return false
+            }
+        }
         
-        // Check for open tag, append to open tag ranges
-        if tagNameString == targetTagName {
-            styleData.openNSRanges.append(tagNSRange)
+        static func hasPrefix(_ prefix: [UInt16], in units: [UInt16], at index: Int) -> Bool {
+            guard index + prefix.count <= units.count else {
+                return false
+            }
             
-            // If needed, determine and append target attribute value
-            updateStyleAttributeDataIfNeeded(styleData: &styleData, tagString: tagString, targetAttributeName: targetAttributeName)
-        
-        // Check for close tag, then grab associated open tag range and create completed range with open and close ranges. Append to ranges.
-        } else if tagNameString == "/\(targetTagName)",
-                  let lastOpenNSRange = styleData.openNSRanges.popLast() {
-            let completeNSRange = NSRange(location: lastOpenNSRange.location, length: (tagNSRange.location + tagNSRange.length) - lastOpenNSRange.location)
-            styleData.completeNSRanges.append(completeNSRange)
+            for (offset, unit) in prefix.enumerated() where units[index + offset] != unit {
+                return false
+            }
+            return true
         }
     }
     
-    private static func updateStyleAttributeDataIfNeeded(styleData: inout StyleData, tagString: String, targetAttributeName: String?) {
-        
-        guard let targetAttributeName,
-              let attributeValueRegex = try? NSRegularExpression(pattern: "\(targetAttributeName)[\\s]*=[\\s]*[\"']?[\\s]*((?:.(?![\"']?\\s+(?:\\S+)=|[>\"']))+.)[\\s]*[\"']?") else {
-            return
-        }
-        
-        let attrMatch = attributeValueRegex.firstMatch(in: tagString, range: tagString.fullNSRange)
-       if let attrMatchNSRange = attrMatch?.range(at: 1),
-          let attrMatchRange = Range(attrMatchNSRange, in: tagString) {
-           let attrMatchValue = String(tagString[attrMatchRange])
-           styleData.targetAttributeValues.append(attrMatchValue)
-       }
+    // MARK: - Shared - Private
+    
+    private static let entityReplacements = [
+        "&amp;": "&",
+        "&nbsp;": " ",
+        "&gt;": ">",
+        "&lt;": "<",
+        "&apos;": "'",
+        "&#039;": "'",
+        "&quot;": "\"",
+        "&ndash;": "\u{2013}",
+        "&mdash;": "\u{2014}",
+        "&#8722;": "\u{2212}"
+    ]
+    
+    private static let hrefRegex = try? NSRegularExpression(pattern: "href[\\s]*=[\\s]*[\"']?[\\s]*((?:.(?![\"']?\\s+(?:\\S+)=|[>\"']))+.)[\\s]*[\"']?")
+    
+    private static func htmlTagRegex() throws -> NSRegularExpression {
+        return try NSRegularExpression(pattern: "(?:<)([\\/a-z0-9]*)(?:\\s?)([^>]*)(?:>)")
     }
     
-    private static func tagAndContentRemoveData(html: String) throws -> [TagAndContentRemoveData] {
-        let regexScript = try NSRegularExpression(pattern: "<script.*?>.*?<\\/script>")
-        let regexStyle = try NSRegularExpression(pattern: "<style.*?>.*?<\\/style>")
-        
-        var data: [TagAndContentRemoveData] = []
-        
-        let scriptMatches = regexScript.matches(in: html, range: html.fullNSRange)
-        let styleMatches = regexStyle.matches(in: html, range: html.fullNSRange)
-        for match in scriptMatches {
-            data.append(TagAndContentRemoveData(range: match.range(at: 0)))
-        }
-        
-        for match in styleMatches {
-            data.append(TagAndContentRemoveData(range: match.range(at: 0)))
-        }
-        
-        return data
+    private static func entityRegex() throws -> NSRegularExpression {
+        return try NSRegularExpression(pattern: "&([^\\s;]+);")
     }
     
-    private static func tagRemoveData(html: String) throws -> [TagRemoveData] {
-        let htmlRegex = try htmlTagRegex()
-        
-        var data: [TagRemoveData] = []
-        let matches = htmlRegex.matches(in: html, range: html.fullNSRange)
-        for match in matches {
-            data.append(TagRemoveData(range: match.range(at: 0)))
-        }
-        
-        return data
+    private static func subscriptPointSize(styles: Styles) -> CGFloat {
+        return styles.font.pointSize * 0.75
     }
     
-    private static func lineBreakReplaceData(html: String) throws -> [ElementReplaceData] {
-        let lineBreakRegex = try lineBreakRegex()
-        var data: [ElementReplaceData] = []
-        let matches = lineBreakRegex.matches(in: html, range: html.fullNSRange)
-        for match in matches {
-            data.append(ElementReplaceData(range: match.range(at: 0), replaceText: "\n"))
-        }
-        return data
+    private static func subscriptOffset(styles: Styles) -> CGFloat {
+        return -(styles.font.pointSize * 0.15)
+    }
+    
+    private static func superscriptPointSize(styles: Styles) -> CGFloat {
+        return styles.font.pointSize * 0.75
+    }
+    
+    private static func superscriptOffset(styles: Styles) -> CGFloat {
+        return styles.font.pointSize * 0.35
     }
     
     private static func entityReplaceData(html: String) throws -> [ElementReplaceData] {
@@ -637,30 +704,7 @@ public struct HtmlUtils {
             
             let range = match.range(at: 0)
             let text = (html as NSString).substring(with: range)
-            let replaceText: String?
-            
-            switch text {
-            case "&amp;":
-                replaceText = "&"
-            case "&nbsp;":
-                replaceText = " "
-            case "&gt;":
-                replaceText = ">"
-            case "&lt;":
-                replaceText = "<"
-            case "&apos;", "&#039;":
-                replaceText = "'"
-            case "&quot;":
-                replaceText = "\""
-            case "&ndash;":
-                replaceText = "\u{2013}"
-            case "&mdash;":
-                replaceText = "\u{2014}"
-            case "&#8722;":
-                replaceText = "\u{2212}"
-            default:
-                replaceText = nil
-            }
+            let replaceText = entityReplacements[text]
             
             if let replaceText {
                 data.append(ElementReplaceData(range: range, replaceText: replaceText))
@@ -23,8 +23,9 @@ import Foundation
     var sharedCacheStore: WMFKeyValueStore?
     var mediaWikiService: WMFService?
     
-    private var activeCountryConfigs: [WMFFundraisingCampaignConfig] = []
+    private var eligibilityIndex: WMFFundraisingCampaignEligibilityIndex?
     private var promptState: WMFFundraisingCampaignPromptState?
+    private var hasLoadedPromptState = false
     private var preferencesBannerOptIns: SafeDictionary<WMFProject, Bool> = SafeDictionary<WMFProject, Bool>()
     
     private let cacheDirectoryName = WMFSharedCacheDirectoryNames.donorExperience.rawValue
@@ -60,6 +61,7 @@ import Foundation
         let promptState = WMFFundraisingCampaignPromptState(campaignID: asset.id, isHidden: false, maybeLaterDate: nextDayMidnight)
         try? sharedCacheStore?.save(key: cacheDirectoryName, cachePromptStateFileName, value: promptState)
         self.promptState = promptState
+        self.hasLoadedPromptState = true
     }
 
     
@@ -83,6 +85,7 @@ import Foundation
         let promptState = WMFFundraisingCampaignPromptState(campaignID: asset.id, isHidden: true, maybeLaterDate: nil)
         try? sharedCacheStore?.save(key: cacheDirectoryName, cachePromptStateFileName, value: promptState)
         self.promptState = promptState
+        self.hasLoadedPromptState = true
     }
     
     /// Load actively running campaign text. This method automatically filters out campaigns that:
@@ -98,24 +101,21 @@ import Foundation
     /// - Returns: WMFAsset containing information to display in campaign modal.
     public func loadActiveCampaignAsset(countryCode: String, wmfProject: WMFProject, currentDate: Date) -> WMFFundraisingCampaignConfig.WMFAsset? {
         
-        guard activeCountryConfigs.isEmpty else {
+        if eligibilityIndex == nil {
             
-            // re-filter activeCountryConfigs in case campaigns have ended
-            self.activeCountryConfigs = activeCountryConfigs(from: activeCountryConfigs, currentDate: currentDate)
+            // Compile old response from cache
+            let cachedResult: WMFFundraisingCampaignConfigResponse? = try? sharedCacheStore?.load(key: cacheDirectoryName, cacheConfigFileName)
             
-            return queuedActiveLanguageSpecificAsset(languageCode: wmfProject.languageCode, languageVariantCode: wmfProject.languageVariantCode, currentDate: currentDate)
+            if let cachedResult {
+                eligibilityIndex = WMFFundraisingCampaignEligibilityIndex(response: cachedResult)
+            }
         }
         
-        // Load old response from cache and return first asset with matching country code, valid date, and matching language assets.
-        let cachedResult: WMFFundraisingCampaignConfigResponse? = try? sharedCacheStore?.load(key: cacheDirectoryName, cacheConfigFileName)
-        
-        if let cachedResult {
-            activeCountryConfigs = activeCountryConfigs(from: cachedResult, countryCode: countryCode, currentDate: currentDate)
-
-            return queuedActiveLanguageSpecificAsset(languageCode: wmfProject.languageCode, languageVariantCode: wmfProject.languageVariantCode, currentDate: currentDate)
+        guard let asset = eligibilityIndex?.asset(countryCode: countryCode, languageCode: wmfProject.languageCode, languageVariantCode: wmfProject.languageVariantCode, date: currentDate) else {
+            return nil
         }
         
-        return nil
+        return validatedAsset(asset, currentDate: currentDate)
     }
     
     @objc public func fetchConfig(countryCode: String, currentDate: Date) {
@@ -153,7 +153,7 @@ import Foundation
 
             switch result {
             case .success(let response):
-                activeCountryConfigs = self.activeCountryConfigs(from: response, countryCode: countryCode, currentDate: currentDate)
+                eligibilityIndex = WMFFundraisingCampaignEligibilityIndex(response: response)
 
                 try? sharedCacheStore?.save(key: cacheDirectoryName, cacheConfigFileName, value: response)
                 
@@ -222,134 +222,47 @@ import Foundation
     // MARK: - Internal
     
     func reset() {
-        activeCountryConfigs = []
+        eligibilityIndex = nil
         promptState = nil
+        hasLoadedPromptState = false
     }
     
     // MARK: - Private
     
-    private func queuedActiveLanguageSpecificAsset(languageCode: String?, languageVariantCode: String?, currentDate: Date) -> WMFFundraisingCampaignConfig.WMFAsset? {
+    /// Filters out assets whose campaign was flagged as permanently hidden, or as "maybe later" and the "maybe later" date has not come to pass
+    private func validatedAsset(_ asset: WMFFundraisingCampaignConfig.WMFAsset, currentDate: Date) -> WMFFundraisingCampaignConfig.WMFAsset? {
         
-        guard let asset = activeLanguageSpecificAsset(languageCode: languageCode, languageVariantCode: languageVariantCode) else {
-            return nil
+        if !hasLoadedPromptState {
+            promptState = try? sharedCacheStore?.load(key: cacheDirectoryName, cachePromptStateFileName)
+            hasLoadedPromptState = true
         }
         
-        let validateAsset: ((WMFFundraisingCampaignConfig.WMFAsset, WMFFundraisingCampaignPromptState) -> WMFFundraisingCampaignConfig.WMFAsset?) = { asset, promptState in
-            guard promptState.campaignID == asset.id else {
-                return asset
-            }
-            
-            // We have saved some state on the campaign ID. Check to confirm it hasn't been permanently hidden and maybe later date has passed
-            
-            guard promptState.isHidden == false else {
-                return nil
-            }
-            
-            guard let maybeLaterDate = promptState.maybeLaterDate else {
-                return asset
-            }
-            
-            guard maybeLaterDate <= currentDate else {
-                return nil
-            }
-            
+        guard let promptState,
+              promptState.campaignID == asset.id else {
             return asset
         }
-         
-        if let promptState {
-            return validateAsset(asset, promptState)
-        } else if let promptState: WMFFundraisingCampaignPromptState = try? sharedCacheStore?.load(key: cacheDirectoryName, cachePromptStateFileName) {
-            return validateAsset(asset, promptState)
-        } else {
-            return asset
-        }
-    }
-    
-    private func activeLanguageSpecificAsset(languageCode: String?, languageVariantCode: String?) -> WMFFundraisingCampaignConfig.WMFAsset? {
         
-        guard let languageCode else {
+        // We have saved some state on the campaign ID. Check to confirm it hasn't been permanently hidden and maybe later date has passed
+        
+        guard promptState.isHidden == false else {
             return nil
         }
         
-        for config in activeCountryConfigs {
-            if let languageCodeAsset = config.assets[languageCode] {
-                return languageCodeAsset
-            } else if let languageVariantCode,
-                let languageVariantCodeAsset = config.assets[languageVariantCode] {
-                return languageVariantCodeAsset
-            }
+        guard let maybeLaterDate = promptState.maybeLaterDate else {
+            return asset
         }
         
-        return nil
-    }
-    
-    private func activeCountryConfigs(from currentConfigs: [WMFFundraisingCampaignConfig], currentDate: Date) -> [WMFFundraisingCampaignConfig] {
-        
-        var configs: [WMFFundraisingCampaignConfig] = []
-        currentConfigs.forEach { config in
-            
-            guard let firstAsset = config.assets.values.first else {
-                return
-            }
-            
-            
-            guard (firstAsset.startDate...firstAsset.endDate).contains(currentDate) else {
-                return
-            }
-            
-            configs.append(config)
+        guard maybeLaterDate <= currentDate else {
+            return nil
         }
         
-        return configs
-    }
-    
-    private func activeCountryConfigs(from response: WMFFundraisingCampaignConfigResponse, countryCode: String, currentDate: Date) -> [WMFFundraisingCampaignConfig] {
-        
-        var configs: [WMFFundraisingCampaignConfig] = []
-        
-        response.configs.forEach({ config in
-            
-            guard config.countryCodes.contains(countryCode) else {
-                return
-            }
-            
-            let dateFormatter = DateFormatter.mediaWikiAPIDateFormatter
-            guard let startDate = dateFormatter.date(from: config.startTimeString),
-                  let endDate = dateFormatter.date(from: config.endTimeString) else {
-                return
-            }
-            
-            guard (startDate...endDate).contains(currentDate) else {
-                return
-            }
-            
-            var assets: [String: WMFFundraisingCampaignConfig.WMFAsset] = [:]
-            for (key, value) in config.assets {
-                
-                let actions: [WMFFundraisingCampaignConfig.WMFAsset.WMFAction] = value.actions.map { action in
-                    
-                    guard let urlString = action.urlString?.replacingOccurrences(of: "$platform;", with: "iOS"),
-                       let url = URL(string: urlString) else {
-                        return WMFFundraisingCampaignConfig.WMFAsset.WMFAction(title: action.title, url: nil)
-                    }
-                    
-                    return WMFFundraisingCampaignConfig.WMFAsset.WMFAction(title: action.title, url: url)
-                }
-
-                let asset = WMFFundraisingCampaignConfig.WMFAsset(id: config.id, textHtml: value.text, footerHtml: value.footer, actions: actions, countryCode: countryCode, currencyCode: value.currencyCode, startDate: startDate, endDate: endDate, languageCode: key)
-                assets[key] = asset
-            }
-            
-            configs.append(WMFFundraisingCampaignConfig(id: config.id, assets: assets))
-        })
-        
-        return configs
+        return asset
     }
 }
 
-// MARK: - Private Models
+// MARK: - Models
 
-private struct WMFFundraisingCampaignConfigResponse: Codable {
+struct WMFFundraisingCampaignConfigResponse: Codable {
     
     struct FundraisingCampaignConfig: Codable {
         
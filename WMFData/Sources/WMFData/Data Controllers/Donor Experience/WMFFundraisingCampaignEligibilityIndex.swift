@@ -0,0 +1,177 @@
+import Foundation
+
+/// Campaign configs compiled for lookups by country, language and date. Built once per fetched or cached config response, so dates are parsed and action URLs are built only once.
+/// Each country and language pair has an interval tree of the campaign windows that apply to it, so a lookup is O(log n) in the number of campaigns, plus the number of campaigns running at once.
+struct WMFFundraisingCampaignEligibilityIndex {
+
+    private struct Campaign {
+        let id: String
+        let startDate: Date
+        let endDate: Date
+        let assets: [String: Asset]
+    }
+
+    private struct Asset {
+        let textHtml: String
+        let footerHtml: String
+        let actions: [WMFFundraisingCampaignConfig.WMFAsset.WMFAction]
+        let currencyCode: String
+    }
+
+    private struct Key: Hashable {
+        let countryCode: String
+        let languageCode: String
+    }
+
+    /// Campaigns in response order. Earlier campaigns take precedence when several are running.
+    private let campaigns: [Campaign]
+    private let treesByKey: [Key: WMFCampaignIntervalTree]
+
+    init(response: WMFFundraisingCampaignConfigResponse) {
+        let dateFormatter = DateFormatter.mediaWikiAPIDateFormatter
+
+        var campaigns: [Campaign] = []
+        var intervalsByKey: [Key: [WMFCampaignIntervalTree.Interval]] = [:]
+
+        for config in response.configs {
+            guard let startDate = dateFormatter.date(from: config.startTimeString),
+                  let endDate = dateFormatter.date(from: config.endTimeString),
+                  startDate <= endDate else {
+                continue
+            }
+
+            var assets: [String: Asset] = [:]
+            for (languageCode, asset) in config.assets {
+                let actions: [WMFFundraisingCampaignConfig.WMFAsset.WMFAction] = asset.actions.map { action in
+                    guard let urlString = action.urlString?.replacingOccurrences(of: "$platform;", with: "iOS"),
+                          let url = URL(string: urlString) else {
+                        return WMFFundraisingCampaignConfig.WMFAsset.WMFAction(title: action.title, url: nil)
+                    }
+
+                    return WMFFundraisingCampaignConfig.WMFAsset.WMFAction(title: action.title, url: url)
+                }
+                assets[languageCode] = Asset(textHtml: asset.text, footerHtml: asset.footer, actions: actions, currencyCode: asset.currencyCode)
+            }
+
+            let interval = WMFCampaignIntervalTree.Interval(startDate: startDate, endDate: endDate, campaignIndex: campaigns.count)
+            for countryCode in Set(config.countryCodes) {
+                for languageCode in assets.keys {
+                    intervalsByKey[Key(countryCode: countryCode, languageCode: languageCode), default: []].append(interval)
+                }
+            }
+
+            campaigns.append(Campaign(id: config.id, startDate: startDate, endDate: endDate, assets: assets))
+        }
+
+        self.campaigns = campaigns
+        self.treesByKey = intervalsByKey.mapValues { WMFCampaignIntervalTree(intervals: $0) }
+    }
+
+    /// The asset of the first campaign running on the date in the country, that has text for the language code or, failing that, the language variant code
+    func asset(countryCode: String, languageCode: String?, languageVariantCode: String?, date: Date) -> WMFFundraisingCampaignConfig.WMFAsset? {
+        guard let languageCode else {
+            return nil
+        }
+
+        let languageCampaignIndex = treesByKey[Key(countryCode: countryCode, languageCode: languageCode)]?.firstCampaignIndex(containing: date)
+        let variantCampaignIndex = languageVariantCode.flatMap { treesByKey[Key(countryCode: countryCode, languageCode: $0)]?.firstCampaignIndex(containing: date) }
+
+        let assetLanguageCode: String
+        let campaignIndex: Int
+        switch (languageCampaignIndex, variantCampaignIndex) {
+        case (let languageCampaignIndex?, let variantCampaignIndex?) where variantCampaignIndex < languageCampaignIndex:
+            assetLanguageCode = languageVariantCode ?? languageCode
+            campaignIndex = variantCampaignIndex
+        case (let languageCampaignIndex?, _):
+            assetLanguageCode = languageCode
+            campaignIndex = languageCampaignIndex
+        case (nil, let variantCampaignIndex?):
+            assetLanguageCode = languageVariantCode ?? languageCode
+            campaignIndex = variantCampaignIndex
+        case (nil, nil):
+            return nil
+        }
+
+        let campaign = campaigns[campaignIndex]
+        guard let asset = campaign.assets[assetLanguageCode] else {
+            return nil
+        }
+
+        return WMFFundraisingCampaignConfig.WMFAsset(id: campaign.id, textHtml: asset.textHtml, footerHtml: asset.footerHtml, actions: asset.actions, countryCode: countryCode, currencyCode: asset.currencyCode, startDate: campaign.startDate, endDate: campaign.endDate, languageCode: assetLanguageCode)
+    }
+}
+
+/// Static interval tree, stored as an array of intervals sorted by start date. The middle of each range is the root of that range's subtree.
+struct WMFCampaignIntervalTree {
+
+    struct Interval {
+        let startDate: Date
+        let endDate: Date
+        let campaignIndex: Int
+    }
+
+    private let intervals: [Interval]
+
+    // Latest end date in the subtree rooted at each index
+    private let maxEndDates: [Date]
+
+    init(intervals: [Interval]) {
+        let intervals = intervals.sorted { $0.startDate < $1.startDate }
+        var maxEndDates = intervals.map { $0.endDate }
+        Self.computeMaxEndDates(&maxEndDates, lower: 0, upper: intervals.count)
+
+        self.intervals = intervals
+        self.maxEndDates = maxEndDates
+    }
+
+    @discardableResult
+    private static func computeMaxEndDates(_ maxEndDates: inout [Date], lower: Int, upper: Int) -> Date? {
+        guard lower < upper else {
+            return nil
+        }
+
+        let middle = (lower + upper) / 2
+        if let leftMaxEndDate = computeMaxEndDates(&maxEndDates, lower: lower, upper: middle) {
+            maxEndDates[middle] = max(maxEndDates[middle], leftMaxEndDate)
+        }
+        if let rightMaxEndDate = computeMaxEndDates(&maxEndDates, lower: middle + 1, upper: upper) {
+            maxEndDates[middle] = max(maxEndDates[middle], rightMaxEndDate)
+        }
+        return maxEndDates[middle]
+    }
+
+    /// Lowest campaign index of the intervals containing the date, inclusive of their start and end dates
+    func firstCampaignIndex(containing date: Date) -> Int? {
+        var campaignIndex: Int?
+        search(date: date, lower: 0, upper: intervals.count, campaignIndex: &campaignIndex)
+        return campaignIndex
+    }
+
+    private func search(date: Date, lower: Int, upper: Int, campaignIndex: inout Int?) {
+        guard lower < upper else {
+            return
+        }
+
+        let middle = (lower + upper) / 2
+
+        // Every interval in this subtree ended before the date
+        guard maxEndDates[middle] >= date else {
+            return
+        }
+
+        search(date: date, lower: lower, upper: middle, campaignIndex: &campaignIndex)
+
+        let interval = intervals[middle]
+
+        // This interval and everything to its right start after the date
+        guard interval.startDate <= date else {
+            return
+        }
+
+        if interval.endDate >= date {
+            campaignIndex = min(campaignIndex ?? interval.campaignIndex, interval.campaignIndex)
+        }
+
+        search(date: date, lower: middle + 1, upper: upper, campaignIndex: &campaignIndex)
+    }
+}
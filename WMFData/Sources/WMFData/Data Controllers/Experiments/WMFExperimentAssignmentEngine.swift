@@ -0,0 +1,95 @@
+import Foundation
+import CryptoKit
+
+/// Assigns experiment arms from a stable hash of the install ID and experiment key, so an install's assignments can be recomputed offline from its ID alone.
+/// Arms take consecutive slots from the start of the hash range, so growing the first arm's weight only moves installs into it from later arms.
+struct WMFExperimentAssignmentEngine {
+
+    enum AssignmentError: Error {
+        case invalidWeights
+    }
+
+    /// Resolution of the hash. Weights are in slots, so a weight of 1 is 0.01% of installs.
+    static let slotCount = 10_000
+
+    struct Arm: Equatable {
+        let name: String
+        let weight: Int
+    }
+
+    /// Experiments in a layer are mutually exclusive. Each experiment has a share of the layer's slots, and installs outside of an experiment's share are not enrolled in it.
+    struct Layer: Equatable {
+
+        struct Share: Equatable {
+            let experimentKey: String
+            let weight: Int
+        }
+
+        let key: String
+        let shares: [Share]
+    }
+
+    struct Experiment: Equatable {
+        let key: String
+        let arms: [Arm]
+        let layer: Layer?
+
+        /// Identifies the split, so saved assignments can be recomputed when it changes
+        var fingerprint: String {
+            var fingerprint = arms.map { "\($0.name):\($0.weight)" }.joined(separator: ",")
+            if let layer {
+                let shares = layer.shares.map { "\($0.experimentKey):\($0.weight)" }.joined(separator: ",")
+                fingerprint += "|\(layer.key)[\(shares)]"
+            }
+            return fingerprint
+        }
+    }
+
+    /// The slot of the install in `0..<slotCount` for the salt, which is an experiment or layer key
+    static func slot(installID: String, salt: String) -> Int {
+        let digest = SHA256.hash(data: Data("\(salt):\(installID)".utf8))
+        let value = digest.prefix(8).reduce(UInt64(0)) { ($0 << 8) | UInt64($1) }
+        return Int(value % UInt64(slotCount))
+    }
+
+    /// The name of the arm the install is in, or nil if its layer gives the install to another experiment
+    static func arm(installID: String, experiment: Experiment) throws -> String? {
+        guard experiment.arms.allSatisfy({ $0.weight >= 0 }),
+              experiment.arms.reduce(0, { $0 + $1.weight }) == slotCount else {
+            throw AssignmentError.invalidWeights
+        }
+
+        if let layer = experiment.layer {
+            guard layer.shares.allSatisfy({ $0.weight >= 0 }),
+                  layer.shares.reduce(0, { $0 + $1.weight }) <= slotCount else {
+                throw AssignmentError.invalidWeights
+            }
+
+            let layerSlot = slot(installID: installID, salt: layer.key)
+            var shareEnd = 0
+            var isInShare = false
+            for share in layer.shares {
+                shareEnd += share.weight
+                if layerSlot < shareEnd {
+                    isInShare = share.experimentKey == experiment.key
+                    break
+                }
+            }
+
+            guard isInShare else {
+                return nil
+            }
+        }
+
+        let experimentSlot = slot(installID: installID, salt: experiment.key)
+        var armEnd = 0
+        for arm in experiment.arms {
+            armEnd += arm.weight
+            if experimentSlot < armEnd {
+                return arm.name
+            }
+        }
+
+        return nil
+    }
+}
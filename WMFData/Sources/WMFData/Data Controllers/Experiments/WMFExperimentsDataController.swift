@@ -6,17 +6,19 @@ final class WMFExperimentsDataController {
     
     enum ExperimentError: Error {
         case invalidPercentage
+        case unexpectedArm
     }
     
     struct ExperimentConfig {
         let experiment: Experiment
+        let key: String
         let percentageFileName: PercentageFileName
         let bucketFileName: BucketFileName
         let bucketValueControl: BucketValue
         let bucketValueTest: BucketValue
     }
     
-    public enum Experiment {
+    public enum Experiment: CaseIterable {
         case articleAsLivingDoc
         case altTextImageRecommendations
         case altTextArticleEditor
@@ -54,27 +56,48 @@ final class WMFExperimentsDataController {
         case altTextArticleEditorControl = "AltTextArticleEditor_Control"
     }
     
+    /// Every assignment of the install, saved together so they are written in one store operation
+    private struct AssignmentRecord: Codable {
+        
+        struct Assignment: Codable, Equatable {
+            /// Nil when a layer gave the install to another experiment
+            let arm: String?
+            /// Fingerprint of the split the arm was assigned from
+            let split: String
+            /// Whether the arm was carried over from the per-experiment bucket files rather than hashed
+            let isMigrated: Bool
+        }
+        
+        /// The install ID that assignments are hashed from. Kept with the assignments so they can be recomputed offline.
+        let installID: String
+        var assignments: [String: Assignment]
+    }
+    
     // MARK: Properties
     
     private let cacheDirectoryName = WMFSharedCacheDirectoryNames.experiments.rawValue
+    private let assignmentsFileName = "Assignments"
     
-    private static let articleAsLivingDocConfig = ExperimentConfig(experiment: .articleAsLivingDoc, percentageFileName: .articleAsLivingDocPercent, bucketFileName: .articleAsLivingDocBucket, bucketValueControl: .articleAsLivingDocControl, bucketValueTest: .articleAsLivingDocTest)
+    private static let articleAsLivingDocConfig = ExperimentConfig(experiment: .articleAsLivingDoc, key: "articleAsLivingDoc", percentageFileName: .articleAsLivingDocPercent, bucketFileName: .articleAsLivingDocBucket, bucketValueControl: .articleAsLivingDocControl, bucketValueTest: .articleAsLivingDocTest)
     
-    private static let altTextImageRecommendationsConfig = ExperimentConfig(experiment: .altTextImageRecommendations, percentageFileName: .altTextImageRecommendationsPercent, bucketFileName: .altTextImageRecommendationsBucket, bucketValueControl: .altTextImageRecommendationsControl, bucketValueTest: .altTextImageRecommendationsTest)
+    private static let altTextImageRecommendationsConfig = ExperimentConfig(experiment: .altTextImageRecommendations, key: "altTextImageRecommendations", percentageFileName: .altTextImageRecommendationsPercent, bucketFileName: .altTextImageRecommendationsBucket, bucketValueControl: .altTextImageRecommendationsControl, bucketValueTest: .altTextImageRecommendationsTest)
     
-    private static let altTextArticleEditorConfig = ExperimentConfig(experiment: .altTextArticleEditor, percentageFileName: .altTextArticleEditorPercent, bucketFileName: .altTextArticleEditorBucket, bucketValueControl: .altTextArticleEditorControl, bucketValueTest: .altTextArticleEditorTest)
+    private static let altTextArticleEditorConfig = ExperimentConfig(experiment: .altTextArticleEditor, key: "altTextArticleEditor", percentageFileName: .altTextArticleEditorPercent, bucketFileName: .altTextArticleEditorBucket, bucketValueControl: .altTextArticleEditorControl, bucketValueTest: .altTextArticleEditorTest)
     
     private let store: WMFKeyValueStore
+    private let installID: String?
     
     // MARK: Lifecycle
     
-    public init(store: WMFKeyValueStore) {
+    public init(store: WMFKeyValueStore, installID: String? = WMFDataEnvironment.current.appInstallIDUtility?()) {
         self.store = store
+        self.installID = installID
     }
     
     // MARK: Public
     
-    // this will only generate a new bucket as needed (i.e. if the percentage is different than the last time bucket was generated)
+    // this will only assign a new bucket as needed (i.e. if the percentage is different than the last time bucket was assigned)
+    // buckets come from a hash of the install ID, so raising the percentage only moves installs from control to test
     @discardableResult
     func determineBucketForExperiment(_ experiment: Experiment, withPercentage percentage: Int) throws -> BucketValue {
         
@@ -82,68 +105,114 @@ final class WMFExperimentsDataController {
             throw ExperimentError.invalidPercentage
         }
         
-        // if we have previously generated a bucket with the same percentage, return that value
-        let maybeOldPercentage = percentageForExperiment(experiment)
-        let maybeOldBucket = bucketForExperiment(experiment)
-        
-        if let oldPercentage = maybeOldPercentage,
-           let oldBucket = maybeOldBucket,
-           oldPercentage == percentage {
-            return oldBucket
+        guard let arm = try determineArm(for: assignmentExperiment(experiment, percentage: percentage)),
+              let bucket = BucketValue(rawValue: arm) else {
+            throw ExperimentError.unexpectedArm
         }
         
-        // otherwise generate new bucket
-        let randomInt = Int.random(in: 1...100)
-        let isInTest = randomInt <= percentage
-        let bucket: BucketValue
-        
-        switch experiment {
-        case .articleAsLivingDoc:
-            bucket = isInTest ? .articleAsLivingDocTest : .articleAsLivingDocControl
-        case .altTextImageRecommendations:
-            bucket = isInTest ? .altTextImageRecommendationsTest : .altTextImageRecommendationsControl
-        case .altTextArticleEditor:
-            bucket = isInTest ? .altTextArticleEditorTest : .altTextArticleEditorControl
+        return bucket
+    }
+    
+    /// Assigns the install to one of the experiment's arms, or to none if its layer gives the install to another experiment. Saved assignments are kept until the experiment's split changes.
+    @discardableResult
+    func determineArm(for experiment: WMFExperimentAssignmentEngine.Experiment) throws -> String? {
+        
+        var record = loadAssignmentRecord()
+        let split = experiment.fingerprint
+        
+        if let assignment = record.assignments[experiment.key],
+           assignment.split == split {
+            return assignment.arm
         }
         
-        try setBucket(bucket, forExperiment: experiment)
-        try setPercentage(percentage, forExperiment: experiment)
+        let arm = try WMFExperimentAssignmentEngine.arm(installID: record.installID, experiment: experiment)
+        record.assignments[experiment.key] = AssignmentRecord.Assignment(arm: arm, split: split, isMigrated: false)
+        try store.save(key: cacheDirectoryName, assignmentsFileName, value: record)
         
-        return bucket
+        return arm
     }
     
     func bucketForExperiment(_ experiment: Experiment) -> BucketValue? {
         
-        let key = experiment.config.bucketFileName.rawValue
-        guard let rawValue: String = try? store.load(key: cacheDirectoryName, key) else {
+        guard let arm = loadAssignmentRecord().assignments[experiment.config.key]?.arm else {
             return nil
         }
         
-        return BucketValue(rawValue: rawValue)
+        return BucketValue(rawValue: arm)
     }
     
     // MARK: Private
     
-    private func percentageForExperiment(_ experiment: Experiment) -> Int? {
+    /// Two arms, test then control, with test taking `percentage` of installs
+    private func assignmentExperiment(_ experiment: Experiment, percentage: Int) -> WMFExperimentAssignmentEngine.Experiment {
         
-        let key = experiment.config.percentageFileName.rawValue
-        let percentage: Int? = try? store.load(key: cacheDirectoryName, key)
-        return percentage
+        let config = experiment.config
+        let testWeight = percentage * WMFExperimentAssignmentEngine.slotCount / 100
+        let arms = [
+            WMFExperimentAssignmentEngine.Arm(name: config.bucketValueTest.rawValue, weight: testWeight),
+            WMFExperimentAssignmentEngine.Arm(name: config.bucketValueControl.rawValue, weight: WMFExperimentAssignmentEngine.slotCount - testWeight)
+        ]
+        return WMFExperimentAssignmentEngine.Experiment(key: config.key, arms: arms, layer: nil)
     }
     
-    private func setPercentage(_ percentage: Int, forExperiment experiment: Experiment) throws {
+    /// The saved assignments. The first time, buckets saved per experiment by earlier versions are carried over, and keep their meaning until their percentage changes. The files they were saved in are then removed.
+    private func loadAssignmentRecord() -> AssignmentRecord {
         
-        guard percentage >= 0 && percentage <= 100 else {
-            throw ExperimentError.invalidPercentage
+        if let record: AssignmentRecord = try? store.load(key: cacheDirectoryName, assignmentsFileName) {
+            return record
         }
         
+        var assignments: [String: AssignmentRecord.Assignment] = [:]
+        var migratedExperiments: [Experiment] = []
+        for experiment in Experiment.allCases {
+            guard let percentage = legacyPercentageForExperiment(experiment),
+                  let bucket = legacyBucketForExperiment(experiment) else {
+                continue
+            }
+            
+            let split = assignmentExperiment(experiment, percentage: percentage).fingerprint
+            assignments[experiment.config.key] = AssignmentRecord.Assignment(arm: bucket.rawValue, split: split, isMigrated: true)
+            migratedExperiments.append(experiment)
+        }
+        
+        let record = AssignmentRecord(installID: installID ?? UUID().uuidString, assignments: assignments)
+        do {
+            try store.save(key: cacheDirectoryName, assignmentsFileName, value: record)
+        } catch {
+            // The legacy files are kept to migrate from next time
+            return record
+        }
+        
+        for experiment in migratedExperiments {
+            removeLegacyFilesForExperiment(experiment)
+        }
+        return record
+    }
+    
+    private func legacyPercentageForExperiment(_ experiment: Experiment) -> Int? {
+        
         let key = experiment.config.percentageFileName.rawValue
-        try store.save(key: cacheDirectoryName, key, value: percentage)
+        let percentage: Int? = try? store.load(key: cacheDirectoryName, key)
+        guard let percentage,
+              percentage >= 0 && percentage <= 100 else {
+            return nil
+        }
+        return percentage
+    }
+    
+    private func removeLegacyFilesForExperiment(_ experiment: Experiment) {
+        
+        try? store.remove(key: cacheDirectoryName, experiment.config.percentageFileName.rawValue)
+        try? store.remove(key: cacheDirectoryName, experiment.config.bucketFileName.rawValue)
     }
     
-    private func setBucket(_ bucket: BucketValue, forExperiment experiment: Experiment) throws {
+    private func legacyBucketForExperiment(_ experiment: Experiment) -> BucketValue? {
         
         let key = experiment.config.bucketFileName.rawValue
-        try store.save(key: cacheDirectoryName, key, value: bucket.rawValue)
+        guard let rawValue: String = try? store.load(key: cacheDirectoryName, key) else {
+            return nil
+        }
+        
+        return BucketValue(rawValue: rawValue)
     }
 }
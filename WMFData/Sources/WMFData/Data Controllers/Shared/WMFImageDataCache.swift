@@ -0,0 +1,346 @@
+import Foundation
+import CryptoKit
+
+/// Caches image data in memory up to a byte limit, and optionally on disk up to a size quota. Both tiers evict the least recently used images first.
+/// Thumbnails are indexed by the image they were scaled from, so a cached thumbnail can satisfy a request for a smaller width of the same image.
+public final class WMFImageDataCache {
+
+    public static let shared = WMFImageDataCache(directoryURL: WMFDataEnvironment.current.appContainerURL?.appendingPathComponent("Library/Caches/WMFImageData", isDirectory: true))
+
+    struct Key: Hashable {
+        /// The image a thumbnail was scaled from, otherwise the full URL
+        let imageID: String
+        /// The thumbnail width in pixels, nil for anything that isn't a sized thumbnail
+        let width: Int?
+
+        init(imageID: String, width: Int?) {
+            self.imageID = imageID
+            self.width = width
+        }
+
+        /// Thumbnail URLs look like `.../thumb/a/ab/Name.jpg/640px-Name.jpg`
+        init(url: URL) {
+            if url.query == nil,
+               url.pathComponents.contains("thumb"),
+               let range = url.lastPathComponent.range(of: "px-"),
+               let width = Int(url.lastPathComponent[..<range.lowerBound]) {
+                self.init(imageID: url.deletingLastPathComponent().absoluteString, width: width)
+            } else {
+                self.init(imageID: url.absoluteString, width: nil)
+            }
+        }
+
+        /// The cached widths that can be used for this key, the best one first
+        func usableWidths(from cachedWidths: [Int]) -> [Int] {
+            guard let width else {
+                return []
+            }
+            return cachedWidths.filter { $0 >= width }.sorted()
+        }
+    }
+
+    // MARK: - Memory
+
+    private final class Node {
+        let key: Key
+        let data: Data
+        weak var previous: Node?
+        var next: Node?
+
+        init(key: Key, data: Data) {
+            self.key = key
+            self.data = data
+        }
+    }
+
+    private let lock = NSLock()
+    private let memoryCapacity: Int
+    private var memoryCost = 0
+    private var nodes: [Key: Node] = [:]
+    private var memoryWidthsByImageID: [String: [Int]] = [:]
+
+    // Most recently used first
+    private var head: Node?
+    private var tail: Node?
+
+    // MARK: - Disk
+
+    private struct DiskEntry {
+        let width: Int?
+        let fileURL: URL
+        let size: Int
+        var accessDate: Date
+    }
+
+    private let directoryURL: URL?
+    private let diskCapacity: Int
+    private let diskQueue = DispatchQueue(label: "org.wikimedia.WMFImageDataCache.disk", qos: .utility)
+
+    // Loaded from the directory on first use, only accessed on the disk queue
+    private var diskEntriesByImageHash: [String: [DiskEntry]]?
+    private var diskCost = 0
+
+    /// - Parameters:
+    ///   - memoryCapacity: Maximum bytes of image data kept in memory
+    ///   - directoryURL: Directory for the disk tier, nil to only cache in memory
+    ///   - diskCapacity: Maximum bytes of image data kept on disk
+    public init(memoryCapacity: Int = 50 * 1024 * 1024, directoryURL: URL? = nil, diskCapacity: Int = 200 * 1024 * 1024) {
+        self.memoryCapacity = memoryCapacity
+        self.directoryURL = directoryURL
+        self.diskCapacity = diskCapacity
+    }
+
+    /// Data for the URL in memory, or a larger thumbnail of the same image
+    func memoryData(for url: URL) -> Data? {
+        let key = Key(url: url)
+
+        lock.lock()
+        defer { lock.unlock() }
+
+        if let node = nodes[key] {
+            moveToFront(node)
+            return node.data
+        }
+
+        for width in key.usableWidths(from: memoryWidthsByImageID[key.imageID] ?? []) {
+            if let node = nodes[Key(imageID: key.imageID, width: width)] {
+                moveToFront(node)
+                return node.data
+            }
+        }
+
+        return nil
+    }
+
+    /// Looks for the URL's data, or a larger thumbnail of the same image, on disk. Found data is added to the memory tier. Completes on the disk queue.
+    func diskData(for url: URL, completion: @escaping (Data?) -> Void) {
+        guard directoryURL != nil else {
+            completion(nil)
+            return
+        }
+
+        diskQueue.async {
+            let key = Key(url: url)
+            let imageHash = Self.hash(key.imageID)
+            var entries = self.loadDiskEntries()[imageHash] ?? []
+
+            let exactIndex = entries.firstIndex { $0.width == key.width }
+            let index = exactIndex ?? key.usableWidths(from: entries.compactMap { $0.width }).lazy.compactMap { width in entries.firstIndex { $0.width == width } }.first
+
+            guard let index,
+                  let data = try? Data(contentsOf: entries[index].fileURL) else {
+                completion(nil)
+                return
+            }
+
+            let now = Date()
+            entries[index].accessDate = now
+            try? FileManager.default.setAttributes([.modificationDate: now], ofItemAtPath: entries[index].fileURL.path)
+            self.diskEntriesByImageHash?[imageHash] = entries
+
+            self.storeInMemory(data, for: Key(imageID: key.imageID, width: entries[index].width))
+            completion(data)
+        }
+    }
+
+    /// Adds data to memory right away and to disk in the background
+    func store(_ data: Data, for url: URL) {
+        let key = Key(url: url)
+        storeInMemory(data, for: key)
+
+        guard directoryURL != nil else {
+            return
+        }
+
+        diskQueue.async {
+            self.storeOnDisk(data, for: key)
+        }
+    }
+
+    public func removeAll() {
+        lock.lock()
+        nodes.removeAll()
+        memoryWidthsByImageID.removeAll()
+        head = nil
+        tail = nil
+        memoryCost = 0
+        lock.unlock()
+
+        guard let directoryURL else {
+            return
+        }
+
+        diskQueue.async {
+            try? FileManager.default.removeItem(at: directoryURL)
+            self.diskEntriesByImageHash = [:]
+            self.diskCost = 0
+        }
+    }
+
+    /// Waits for pending disk reads and writes
+    func waitForDiskQueue() {
+        diskQueue.sync { }
+    }
+
+    // MARK: - Memory
+
+    private func storeInMemory(_ data: Data, for key: Key) {
+        guard data.count <= memoryCapacity else {
+            return
+        }
+
+        lock.lock()
+        defer { lock.unlock() }
+
+        if let existingNode = nodes[key] {
+            removeNode(existingNode)
+        }
+
+        let node = Node(key: key, data: data)
+        nodes[key] = node
+        if let width = key.width {
+            memoryWidthsByImageID[key.imageID, default: []].append(width)
+        }
+        memoryCost += data.count
+        insertAtFront(node)
+
+        while memoryCost > memoryCapacity, let tail {
+            removeNode(tail)
+        }
+    }
+
+    private func insertAtFront(_ node: Node) {
+        node.previous = nil
+        node.next = head
+        head?.previous = node
+        head = node
+        if tail == nil {
+            tail = node
+        }
+    }
+
+    private func unlink(_ node: Node) {
+        let previous = node.previous
+        let next = node.next
+        previous?.next = next
+        next?.previous = previous
+        if head === node {
+            head = next
+        }
+        if tail === node {
+            tail = previous
+        }
+        node.previous = nil
+        node.next = nil
+    }
+
+    private func moveToFront(_ node: Node) {
+        guard head !== node else {
+            return
+        }
+        unlink(node)
+        insertAtFront(node)
+    }
+
+    private func removeNode(_ node: Node) {
+        unlink(node)
+        nodes[node.key] = nil
+        memoryCost -= node.data.count
+        if let width = node.key.width {
+            memoryWidthsByImageID[node.key.imageID]?.removeAll { $0 == width }
+            if memoryWidthsByImageID[node.key.imageID]?.isEmpty == true {
+                memoryWidthsByImageID[node.key.imageID] = nil
+            }
+        }
+    }
+
+    // MARK: - Disk
+
+    private static func hash(_ imageID: String) -> String {
+        return SHA256.hash(data: Data(imageID.utf8)).map { String(format: "%02x", $0) }.joined()
+    }
+
+    /// File names are the hashed image ID, followed by the thumbnail width for sized thumbnails
+    private static func fileName(imageHash: String, width: Int?) -> String {
+        guard let width else {
+            return imageHash
+        }
+        return "\(imageHash)-\(width)"
+    }
+
+    private func loadDiskEntries() -> [String: [DiskEntry]] {
+        if let diskEntriesByImageHash {
+            return diskEntriesByImageHash
+        }
+
+        var entriesByImageHash: [String: [DiskEntry]] = [:]
+        diskCost = 0
+
+        if let directoryURL,
+           let fileURLs = try? FileManager.default.contentsOfDirectory(at: directoryURL, includingPropertiesForKeys: [.fileSizeKey, .contentModificationDateKey]) {
+            for fileURL in fileURLs {
+                let nameComponents = fileURL.lastPathComponent.split(separator: "-")
+                guard let imageHash = nameComponents.first,
+                      nameComponents.count <= 2,
+                      let resourceValues = try? fileURL.resourceValues(forKeys: [.fileSizeKey, .contentModificationDateKey]),
+                      let size = resourceValues.fileSize else {
+                    continue
+                }
+                let width = nameComponents.count == 2 ? Int(nameComponents[1]) : nil
+                if nameComponents.count == 2 && width == nil {
+                    continue
+                }
+                entriesByImageHash[String(imageHash), default: []].append(DiskEntry(width: width, fileURL: fileURL, size: size, accessDate: resourceValues.contentModificationDate ?? .distantPast))
+                diskCost += size
+            }
+        }
+
+        diskEntriesByImageHash = entriesByImageHash
+        return entriesByImageHash
+    }
+
+    private func storeOnDisk(_ data: Data, for key: Key) {
+        guard let directoryURL,
+              data.count <= diskCapacity else {
+            return
+        }
+
+        let imageHash = Self.hash(key.imageID)
+        let fileURL = directoryURL.appendingPathComponent(Self.fileName(imageHash: imageHash, width: key.width), isDirectory: false)
+
+        do {
+            try FileManager.default.createDirectory(at: directoryURL, withIntermediateDirectories: true)
+            try data.write(to: fileURL, options: .atomic)
+        } catch {
+            return
+        }
+
+        var entries = loadDiskEntries()[imageHash] ?? []
+        if let existingIndex = entries.firstIndex(where: { $0.width == key.width }) {
+            diskCost -= entries[existingIndex].size
+            entries.remove(at: existingIndex)
+        }
+        entries.append(DiskEntry(width: key.width, fileURL: fileURL, size: data.count, accessDate: Date()))
+        diskEntriesByImageHash?[imageHash] = entries
+        diskCost += data.count
+
+        guard diskCost > diskCapacity,
+              let diskEntriesByImageHash else {
+            return
+        }
+
+        // Over quota, remove the least recently used files
+        let entriesByAccessDate = diskEntriesByImageHash.flatMap { imageHash, entries in entries.map { (imageHash, $0) } }.sorted { $0.1.accessDate < $1.1.accessDate }
+        for (imageHash, entry) in entriesByAccessDate {
+            guard diskCost > diskCapacity else {
+                break
+            }
+            try? FileManager.default.removeItem(at: entry.fileURL)
+            self.diskEntriesByImageHash?[imageHash]?.removeAll { $0.width == entry.width }
+            if self.diskEntriesByImageHash?[imageHash]?.isEmpty == true {
+                self.diskEntriesByImageHash?[imageHash] = nil
+            }
+            diskCost -= entry.size
+        }
+    }
+}
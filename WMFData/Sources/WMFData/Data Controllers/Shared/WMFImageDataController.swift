@@ -3,17 +3,22 @@ import Foundation
 public final class WMFImageDataController {
     private var basicService: WMFService?
     private var mediaWikiService: WMFService?
-    private let imageCache = NSCache<NSURL, NSData>()
+    private let imageCache: WMFImageDataCache
     
-    public init(basicService: WMFService? = WMFDataEnvironment.current.basicService, mediaWikiService: WMFService? = WMFDataEnvironment.current.mediaWikiService) {
+    private let lock = NSLock()
+    private var inFlightCompletions: [URL: [(Result<Data, Error>) -> Void]] = [:]
+    
+    public init(basicService: WMFService? = WMFDataEnvironment.current.basicService, mediaWikiService: WMFService? = WMFDataEnvironment.current.mediaWikiService, imageCache: WMFImageDataCache = .shared) {
         self.basicService = basicService
         self.mediaWikiService = mediaWikiService
+        self.imageCache = imageCache
     }
     
+    /// Fetches image data from the cache, or from the network. Callers asking for a URL that is already being fetched wait for that request instead of starting their own.
     public func fetchImageData(url: URL, completion: @escaping (Result<Data, Error>) -> Void) {
         
-        if let cachedData = imageCache.object(forKey: url as NSURL) {
-            completion(.success(cachedData as Data))
+        if let cachedData = imageCache.memoryData(for: url) {
+            completion(.success(cachedData))
             return
         }
         
@@ -21,17 +26,52 @@ public final class WMFImageDataController {
             completion(.failure(WMFDataControllerError.basicServiceUnavailable))
             return
         }
-
-        let request = WMFBasicServiceRequest(url: url, method: .GET, acceptType: .none)
-
-        basicService.perform(request: request) { [weak self] result in
-            switch result {
-            case .success(let data):
-                self?.imageCache.setObject(data as NSData, forKey: url as NSURL)
-            default:
-                break
+        
+        lock.lock()
+        
+        if inFlightCompletions[url] != nil {
+            inFlightCompletions[url]?.append(completion)
+            lock.unlock()
+            return
+        }
+        
+        // A request may have finished since the first check. Its data is cached before it's removed from the in-flight requests.
+        if let cachedData = imageCache.memoryData(for: url) {
+            lock.unlock()
+            completion(.success(cachedData))
+            return
+        }
+        
+        inFlightCompletions[url] = [completion]
+        lock.unlock()
+        
+        imageCache.diskData(for: url) { data in
+            if let data {
+                self.completeRequests(url: url, result: .success(data))
+                return
             }
             
+            let request = WMFBasicServiceRequest(url: url, method: .GET, acceptType: .none)
+            
+            basicService.perform(request: request) { result in
+                switch result {
+                case .success(let data):
+                    self.imageCache.store(data, for: url)
+                default:
+                    break
+                }
+                
+                self.completeRequests(url: url, result: result)
+            }
+        }
+    }
+    
+    private func completeRequests(url: URL, result: Result<Data, Error>) {
+        lock.lock()
+        let completions = inFlightCompletions.removeValue(forKey: url) ?? []
+        lock.unlock()
+        
+        for completion in completions {
             completion(result)
         }
     }
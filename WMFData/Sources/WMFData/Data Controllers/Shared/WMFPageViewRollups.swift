@@ -0,0 +1,239 @@
+import Foundation
+import CoreData
+
+/// Per page, per day page view totals stored alongside `CDPageView`, so date range queries read aggregates instead of every view.
+///
+/// Days, weekdays and hours are in the time zone the rollups were built in. While that differs from the current time zone, `isCurrent` is false,
+/// queries scan views instead, and the next write rebuilds the rollups.
+struct WMFPageViewRollups {
+
+    // Bump to rebuild existing rollups after changing how they're computed
+    static let version: Int16 = 1
+
+    private static let hoursPerDay = 24
+
+    let calendar: Calendar
+
+    init(calendar: Calendar = .current) {
+        self.calendar = calendar
+    }
+
+    // MARK: - State
+
+    func isCurrent(in moc: NSManagedObjectContext) throws -> Bool {
+        guard let state = try fetchState(in: moc) else {
+            return false
+        }
+        return state.version == Self.version && state.timeZoneIdentifier == calendar.timeZone.identifier
+    }
+
+    private func fetchState(in moc: NSManagedObjectContext) throws -> CDPageViewRollupState? {
+        let fetchRequest = NSFetchRequest<CDPageViewRollupState>(entityName: "CDPageViewRollupState")
+        fetchRequest.fetchLimit = 1
+        return try moc.fetch(fetchRequest).first
+    }
+
+    // MARK: - Updating
+
+    private struct Key: Hashable {
+        let page: CDPage
+        let day: Date
+    }
+
+    private struct Delta {
+        let weekday: Int
+        var viewCount = 0
+        var hourlyViewCounts = [Int](repeating: 0, count: WMFPageViewRollups.hoursPerDay)
+    }
+
+    /// Adds newly inserted views to their pages' rollups. Only valid while `isCurrent` is true.
+    func add(views: [(page: CDPage, timestamp: Date)], in moc: NSManagedObjectContext) throws {
+        guard !views.isEmpty else {
+            return
+        }
+
+        var deltas: [Key: Delta] = [:]
+        var dayLookup = DayLookup(calendar: calendar)
+        for view in views {
+            let day = dayLookup.day(containing: view.timestamp)
+            let key = Key(page: view.page, day: day.start)
+            var delta = deltas[key] ?? Delta(weekday: day.weekday)
+            delta.viewCount += 1
+            delta.hourlyViewCounts[calendar.component(.hour, from: view.timestamp)] += 1
+            deltas[key] = delta
+        }
+
+        let days = deltas.keys.map { $0.day }
+        guard let firstDay = days.min(), let lastDay = days.max() else {
+            return
+        }
+
+        var existingRollups: [Key: CDPageViewDailyRollup] = [:]
+        let pages = Array(Set(deltas.keys.map { $0.page }))
+        for chunkStart in stride(from: 0, to: pages.count, by: 500) {
+            let chunk = Array(pages[chunkStart..<min(chunkStart + 500, pages.count)])
+            let fetchRequest = NSFetchRequest<CDPageViewDailyRollup>(entityName: "CDPageViewDailyRollup")
+            fetchRequest.predicate = NSPredicate(format: "page IN %@ && day >= %@ && day <= %@", chunk, firstDay as NSDate, lastDay as NSDate)
+            for rollup in try moc.fetch(fetchRequest) {
+                guard let page = rollup.page, let day = rollup.day else {
+                    continue
+                }
+                existingRollups[Key(page: page, day: day)] = rollup
+            }
+        }
+
+        for (key, delta) in deltas {
+            let rollup = try existingRollups[key] ?? insertRollup(page: key.page, day: key.day, weekday: delta.weekday, in: moc)
+            rollup.viewCount += Int64(delta.viewCount)
+            rollup.hourlyViewCounts = Self.adding(delta.hourlyViewCounts, to: rollup.hourlyViewCounts)
+        }
+    }
+
+    /// Replaces every rollup with totals computed from saved views, in the current time zone
+    func rebuild(in moc: NSManagedObjectContext) throws {
+        let deleteRequest = NSBatchDeleteRequest(fetchRequest: NSFetchRequest<NSFetchRequestResult>(entityName: "CDPageViewDailyRollup"))
+        deleteRequest.resultType = .resultTypeObjectIDs
+        if let deleteResult = try moc.execute(deleteRequest) as? NSBatchDeleteResult,
+           let deletedObjectIDs = deleteResult.result as? [NSManagedObjectID] {
+            NSManagedObjectContext.mergeChanges(fromRemoteContextSave: [NSDeletedObjectsKey: deletedObjectIDs], into: [moc])
+        }
+
+        let viewsRequest = NSFetchRequest<NSDictionary>(entityName: "CDPageView")
+        viewsRequest.resultType = .dictionaryResultType
+        viewsRequest.propertiesToFetch = ["page", "timestamp"]
+        // Sorted so consecutive views mostly fall on the same day
+        viewsRequest.sortDescriptors = [NSSortDescriptor(key: "timestamp", ascending: true)]
+        viewsRequest.fetchBatchSize = 1000
+
+        var deltas: [NSManagedObjectID: [Date: Delta]] = [:]
+        var dayLookup = DayLookup(calendar: calendar)
+        for view in try moc.fetch(viewsRequest) {
+            guard let pageID = view["page"] as? NSManagedObjectID,
+                  let timestamp = view["timestamp"] as? Date else {
+                continue
+            }
+            let day = dayLookup.day(containing: timestamp)
+            var delta = deltas[pageID, default: [:]][day.start] ?? Delta(weekday: day.weekday)
+            delta.viewCount += 1
+            delta.hourlyViewCounts[calendar.component(.hour, from: timestamp)] += 1
+            deltas[pageID, default: [:]][day.start] = delta
+        }
+
+        for (pageID, pageDeltas) in deltas {
+            guard let page = try? moc.existingObject(with: pageID) as? CDPage else {
+                continue
+            }
+            for (day, delta) in pageDeltas {
+                let rollup = try insertRollup(page: page, day: day, weekday: delta.weekday, in: moc)
+                rollup.viewCount = Int64(delta.viewCount)
+                rollup.hourlyViewCounts = Self.adding(delta.hourlyViewCounts, to: nil)
+            }
+        }
+
+        let state = try fetchState(in: moc) ?? NSEntityDescription.insertNewObject(forEntityName: "CDPageViewRollupState", into: moc) as? CDPageViewRollupState
+        state?.timeZoneIdentifier = calendar.timeZone.identifier
+        state?.version = Self.version
+    }
+
+    /// Removes a page's rollups, for when all of its views are deleted
+    func deleteRollups(for page: CDPage, in moc: NSManagedObjectContext) {
+        guard let rollups = page.dailyRollups as? Set<CDPageViewDailyRollup> else {
+            return
+        }
+        for rollup in rollups {
+            moc.delete(rollup)
+        }
+    }
+
+    private func insertRollup(page: CDPage, day: Date, weekday: Int, in moc: NSManagedObjectContext) throws -> CDPageViewDailyRollup {
+        guard let rollup = NSEntityDescription.insertNewObject(forEntityName: "CDPageViewDailyRollup", into: moc) as? CDPageViewDailyRollup else {
+            throw WMFCoreDataStoreError.missingEntity
+        }
+        rollup.page = page
+        rollup.projectID = page.projectID
+        rollup.day = day
+        rollup.weekday = Int16(weekday)
+        return rollup
+    }
+
+    // MARK: - Querying
+
+    /// A date range split into whole days, read from rollups, and the partial days at either end, read from views
+    struct RangeSplit {
+        /// Rollups with `day` in this range cover only views within the queried range
+        let rollupDays: Range<Date>?
+        /// Views outside the whole days that are within the queried range
+        let viewsPredicate: NSPredicate
+    }
+
+    func split(startDate: Date, endDate: Date) -> RangeSplit {
+        let wholeRangePredicate = NSPredicate(format: "timestamp >= %@ && timestamp <= %@", startDate as NSDate, endDate as NSDate)
+        guard startDate <= endDate,
+              let startDay = calendar.dateInterval(of: .day, for: startDate) else {
+            return RangeSplit(rollupDays: nil, viewsPredicate: wholeRangePredicate)
+        }
+
+        // A day is whole if it starts within the range and ends before the range does
+        let firstWholeDay = startDay.start == startDate ? startDate : startDay.end
+        let lastPartialDay = calendar.startOfDay(for: endDate)
+        guard firstWholeDay < lastPartialDay else {
+            return RangeSplit(rollupDays: nil, viewsPredicate: wholeRangePredicate)
+        }
+
+        let trailingPredicate = NSPredicate(format: "timestamp >= %@ && timestamp <= %@", lastPartialDay as NSDate, endDate as NSDate)
+        let leadingPredicate = NSPredicate(format: "timestamp >= %@ && timestamp < %@", startDate as NSDate, firstWholeDay as NSDate)
+        return RangeSplit(rollupDays: firstWholeDay..<lastPartialDay, viewsPredicate: NSCompoundPredicate(orPredicateWithSubpredicates: [leadingPredicate, trailingPredicate]))
+    }
+
+    func rollupsPredicate(days: Range<Date>) -> NSPredicate {
+        return NSPredicate(format: "day >= %@ && day < %@", days.lowerBound as NSDate, days.upperBound as NSDate)
+    }
+
+    // MARK: - Hourly counts
+
+    /// 24 little endian UInt32 counts, one for each hour of the day
+    static func hourlyViewCounts(from data: Data?) -> [Int] {
+        var counts = [Int](repeating: 0, count: hoursPerDay)
+        guard let data, data.count == hoursPerDay * MemoryLayout<UInt32>.size else {
+            return counts
+        }
+        let bytes = [UInt8](data)
+        for hour in 0..<hoursPerDay {
+            let offset = hour * MemoryLayout<UInt32>.size
+            counts[hour] = Int(UInt32(bytes[offset]) | UInt32(bytes[offset + 1]) << 8 | UInt32(bytes[offset + 2]) << 16 | UInt32(bytes[offset + 3]) << 24)
+        }
+        return counts
+    }
+
+    private static func adding(_ counts: [Int], to data: Data?) -> Data {
+        let existingCounts = hourlyViewCounts(from: data)
+        var data = Data(capacity: hoursPerDay * MemoryLayout<UInt32>.size)
+        for hour in 0..<hoursPerDay {
+            var count = UInt32(clamping: existingCounts[hour] + counts[hour]).littleEndian
+            withUnsafeBytes(of: &count) { data.append(contentsOf: $0) }
+        }
+        return data
+    }
+}
+
+// MARK: - Day lookup
+
+/// Finds the day containing a date, reusing the last day found, so looking up dates in order is cheap
+struct DayLookup {
+    let calendar: Calendar
+    private var lastDay: (interval: DateInterval, weekday: Int)?
+
+    init(calendar: Calendar) {
+        self.calendar = calendar
+    }
+
+    mutating func day(containing date: Date) -> (start: Date, weekday: Int) {
+        if let lastDay, lastDay.interval.start <= date, date < lastDay.interval.end {
+            return (lastDay.interval.start, lastDay.weekday)
+        }
+        let interval = calendar.dateInterval(of: .day, for: date) ?? DateInterval(start: calendar.startOfDay(for: date), duration: 86_400)
+        let weekday = calendar.component(.weekday, from: interval.start)
+        lastDay = (interval, weekday)
+        return (interval.start, weekday)
+    }
+}
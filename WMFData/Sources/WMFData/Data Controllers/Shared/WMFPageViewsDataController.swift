@@ -46,6 +46,22 @@ public final class WMFPageViewDay: Decodable, Encodable {
     }
 }
 
+/// Page view totals for a date range that are computed together, from one scan of the range's views
+public final class WMFPageViewSummary {
+    /// Most viewed first
+    public let pageViewCounts: [WMFPageViewCount]
+    /// Views by day of the week, Sunday = 1 through Saturday = 7. Days without views are omitted.
+    public let pageViewDays: [WMFPageViewDay]
+    /// The start of each day with a view, in order
+    public let viewedDays: [Date]
+    
+    init(pageViewCounts: [WMFPageViewCount], pageViewDays: [WMFPageViewDay], viewedDays: [Date]) {
+        self.pageViewCounts = pageViewCounts
+        self.pageViewDays = pageViewDays
+        self.viewedDays = viewedDays
+    }
+}
+
 public final class WMFPageViewImportRequest {
     let title: String
     let project: WMFProject
@@ -84,17 +100,19 @@ public final class WMFPageViewsDataController {
             
             let currentDate = Date()
             let predicate = NSPredicate(format: "projectID == %@ && namespaceID == %@ && title == %@", argumentArray: [project.coreDataIdentifier, namespaceID, coreDataTitle])
-            let page = try self.coreDataStore.fetchOrCreate(entityType: CDPage.self, predicate: predicate, in: backgroundContext)
-            page?.title = coreDataTitle
-            page?.namespaceID = namespaceID
-            page?.projectID = project.coreDataIdentifier
-            page?.timestamp = currentDate
+            guard let page = try self.coreDataStore.fetchOrCreate(entityType: CDPage.self, predicate: predicate, in: backgroundContext) else {
+                return
+            }
+            page.title = coreDataTitle
+            page.namespaceID = namespaceID
+            page.projectID = project.coreDataIdentifier
+            page.timestamp = currentDate
             
             let viewedPage = try self.coreDataStore.create(entityType: CDPageView.self, in: backgroundContext)
             viewedPage.page = page
             viewedPage.timestamp = currentDate
             
-            try self.coreDataStore.saveIfNeeded(moc: backgroundContext)
+            try self.saveUpdatingRollups(addedViews: [(page, currentDate)], in: backgroundContext)
         }
     }
     
@@ -122,6 +140,8 @@ public final class WMFPageViewsDataController {
                 backgroundContext.delete(pageView)
             }
             
+            WMFPageViewRollups().deleteRollups(for: page, in: backgroundContext)
+            
             try coreDataStore.saveIfNeeded(moc: backgroundContext)
         }
     }
@@ -135,30 +155,144 @@ public final class WMFPageViewsDataController {
             batchPageViewDeleteRequest.resultType = .resultTypeObjectIDs
             _ = try backgroundContext.execute(batchPageViewDeleteRequest) as? NSBatchDeleteResult
             
+            let rollupFetchRequest = NSFetchRequest<NSFetchRequestResult>(entityName: "CDPageViewDailyRollup")
+            
+            let batchRollupDeleteRequest = NSBatchDeleteRequest(fetchRequest: rollupFetchRequest)
+            batchRollupDeleteRequest.resultType = .resultTypeObjectIDs
+            _ = try backgroundContext.execute(batchRollupDeleteRequest) as? NSBatchDeleteResult
+            
             backgroundContext.refreshAllObjects()
         }
     }
     
+    /// Number of import requests upserted and saved together. The context is reset between chunks to bound memory use.
+    static let importChunkSize = 2000
+    
+    /// Imports legacy history in chunks. Existing pages are reused, and views already recorded for a page at the same time are skipped, so importing the same history twice doesn't duplicate it.
     public func importPageViews(requests: [WMFPageViewImportRequest]) async throws {
         
         let backgroundContext = try coreDataStore.newBackgroundContext
         try await backgroundContext.perform {
-            for request in requests {
-                
-                let coreDataTitle = request.title.normalizedForCoreData
-                let predicate = NSPredicate(format: "projectID == %@ && namespaceID == %@ && title == %@", argumentArray: [request.project.coreDataIdentifier, 0, coreDataTitle])
-                
-                let page = try self.coreDataStore.fetchOrCreate(entityType: CDPage.self, predicate: predicate, in: backgroundContext)
-                page?.title = coreDataTitle
-                page?.namespaceID = 0
-                page?.projectID = request.project.coreDataIdentifier
-                page?.timestamp = request.viewedDate
-                
-                let viewedPage = try self.coreDataStore.create(entityType: CDPageView.self, in: backgroundContext)
-                viewedPage.page = page
-                viewedPage.timestamp = request.viewedDate
+            for chunkStart in stride(from: 0, to: requests.count, by: Self.importChunkSize) {
+                let chunk = requests[chunkStart..<min(chunkStart + Self.importChunkSize, requests.count)]
+                try autoreleasepool {
+                    try self.importPageViewsChunk(chunk, in: backgroundContext)
+                    backgroundContext.reset()
+                }
             }
+        }
+    }
+    
+    private struct ImportPageKey: Hashable {
+        let projectID: String
+        let title: String
+    }
+    
+    private struct ImportViewKey: Hashable {
+        let pageID: NSManagedObjectID
+        let timestamp: Date
+    }
+    
+    private func importPageViewsChunk(_ requests: ArraySlice<WMFPageViewImportRequest>, in backgroundContext: NSManagedObjectContext) throws {
+        
+        var latestViewedDates: [ImportPageKey: Date] = [:]
+        let keyedRequests: [(key: ImportPageKey, viewedDate: Date)] = requests.map { request in
+            let key = ImportPageKey(projectID: request.project.coreDataIdentifier, title: request.title.normalizedForCoreData)
+            latestViewedDates[key] = max(latestViewedDates[key] ?? request.viewedDate, request.viewedDate)
+            return (key, request.viewedDate)
+        }
+        
+        guard !keyedRequests.isEmpty else {
+            return
+        }
+        
+        // Fetch every existing page for the chunk at once. Titles and projects are matched separately by the predicate, then together here.
+        var pages: [ImportPageKey: CDPage] = [:]
+        let titles = Set(latestViewedDates.keys.map { $0.title })
+        let projectIDs = Set(latestViewedDates.keys.map { $0.projectID })
+        let pagePredicate = NSPredicate(format: "namespaceID == %@ && projectID IN %@ && title IN %@", argumentArray: [0, projectIDs, titles])
+        for page in try coreDataStore.fetch(entityType: CDPage.self, predicate: pagePredicate, fetchLimit: nil, in: backgroundContext) ?? [] {
+            guard let projectID = page.projectID, let title = page.title else {
+                continue
+            }
+            let key = ImportPageKey(projectID: projectID, title: title)
+            guard let latestViewedDate = latestViewedDates[key], pages[key] == nil else {
+                continue
+            }
+            pages[key] = page
+            if let timestamp = page.timestamp, timestamp >= latestViewedDate {
+                continue
+            }
+            page.timestamp = latestViewedDate
+        }
+        
+        // Create the missing pages without instantiating them
+        let missingPages = latestViewedDates.filter { pages[$0.key] == nil }
+        if !missingPages.isEmpty {
+            let pageObjects: [[String: Any]] = missingPages.map { key, latestViewedDate in
+                ["projectID": key.projectID, "title": key.title, "namespaceID": 0, "timestamp": latestViewedDate]
+            }
+            let insertRequest = NSBatchInsertRequest(entityName: "CDPage", objects: pageObjects)
+            insertRequest.resultType = .objectIDs
+            let insertResult = try backgroundContext.execute(insertRequest) as? NSBatchInsertResult
+            let insertedObjectIDs = insertResult?.result as? [NSManagedObjectID] ?? []
             
+            let insertedPagesPredicate = NSPredicate(format: "self IN %@", insertedObjectIDs)
+            for page in try coreDataStore.fetch(entityType: CDPage.self, predicate: insertedPagesPredicate, fetchLimit: nil, in: backgroundContext) ?? [] {
+                guard let projectID = page.projectID, let title = page.title else {
+                    continue
+                }
+                pages[ImportPageKey(projectID: projectID, title: title)] = page
+            }
+        }
+        
+        // Skip views already recorded, from an earlier chunk or an earlier import
+        let viewedDates = keyedRequests.map { $0.viewedDate }
+        var existingViews: Set<ImportViewKey> = []
+        if let firstViewedDate = viewedDates.min(), let lastViewedDate = viewedDates.max() {
+            let viewsRequest = NSFetchRequest<NSDictionary>(entityName: "CDPageView")
+            viewsRequest.resultType = .dictionaryResultType
+            viewsRequest.propertiesToFetch = ["page", "timestamp"]
+            viewsRequest.predicate = NSPredicate(format: "page IN %@ && timestamp >= %@ && timestamp <= %@", argumentArray: [Array(pages.values), firstViewedDate, lastViewedDate])
+            for view in try backgroundContext.fetch(viewsRequest) {
+                guard let pageID = view["page"] as? NSManagedObjectID,
+                      let timestamp = view["timestamp"] as? Date else {
+                    continue
+                }
+                existingViews.insert(ImportViewKey(pageID: pageID, timestamp: timestamp))
+            }
+        }
+        
+        var addedViews: [(page: CDPage, timestamp: Date)] = []
+        addedViews.reserveCapacity(keyedRequests.count)
+        for (key, viewedDate) in keyedRequests {
+            guard let page = pages[key] else {
+                continue
+            }
+            
+            guard existingViews.insert(ImportViewKey(pageID: page.objectID, timestamp: viewedDate)).inserted else {
+                continue
+            }
+            
+            let viewedPage = try coreDataStore.create(entityType: CDPageView.self, in: backgroundContext)
+            viewedPage.page = page
+            viewedPage.timestamp = viewedDate
+            addedViews.append((page, viewedDate))
+        }
+        
+        try saveUpdatingRollups(addedViews: addedViews, in: backgroundContext)
+    }
+    
+    /// Rebuilds page view rollups if they were built in a different time zone, or before this version of the app.
+    /// Until then, queries scan every page view in the requested range.
+    public func rebuildRollupsIfNeeded() async throws {
+        let backgroundContext = try coreDataStore.newBackgroundContext
+        try await backgroundContext.perform {
+            let rollups = WMFPageViewRollups()
+            guard try !rollups.isCurrent(in: backgroundContext) else {
+                return
+            }
+            try rollups.rebuild(in: backgroundContext)
             try self.coreDataStore.saveIfNeeded(moc: backgroundContext)
         }
     }
@@ -172,15 +306,34 @@ public final class WMFPageViewsDataController {
             context = try coreDataStore.viewContext
         }
         let results: [WMFPageViewCount] = try context.performAndWait {
-            let predicate = NSPredicate(format: "timestamp >= %@ && timestamp <= %@", startDate as CVarArg, endDate as CVarArg)
+            let rollups = WMFPageViewRollups()
+            let split = try rollups.isCurrent(in: context) ? rollups.split(startDate: startDate, endDate: endDate) : nil
+            
+            var countsByPageID: [NSManagedObjectID: Int] = [:]
+            
+            if let rollupDays = split?.rollupDays {
+                let rollupCounts = try self.coreDataStore.fetchGroupedSum(entityType: CDPageViewDailyRollup.self, predicate: rollups.rollupsPredicate(days: rollupDays), propertyToSum: "viewCount", propertiesToGroupBy: ["page"], in: context)
+                for dict in rollupCounts {
+                    guard let objectID = dict["page"] as? NSManagedObjectID,
+                          let count = dict["sum"] as? Int else {
+                        continue
+                    }
+                    countsByPageID[objectID, default: 0] += count
+                }
+            }
+            
+            let predicate = split?.viewsPredicate ?? NSPredicate(format: "timestamp >= %@ && timestamp <= %@", startDate as CVarArg, endDate as CVarArg)
             let pageViewsDict = try self.coreDataStore.fetchGrouped(entityType: CDPageView.self, predicate: predicate, propertyToCount: "page", propertiesToGroupBy: ["page"], propertiesToFetch: ["page"], in: context)
-            var pageViewCounts: [WMFPageViewCount] = []
             for dict in pageViewsDict {
-                
                 guard let objectID = dict["page"] as? NSManagedObjectID,
                       let count = dict["count"] as? Int else {
                     continue
                 }
+                countsByPageID[objectID, default: 0] += count
+            }
+            
+            var pageViewCounts: [WMFPageViewCount] = []
+            for (objectID, count) in countsByPageID where count > 0 {
                 
                 guard let page = context.object(with: objectID) as? CDPage,
                       let projectID = page.projectID, let title = page.title else {
@@ -191,7 +344,14 @@ public final class WMFPageViewsDataController {
                 
                 pageViewCounts.append(WMFPageViewCount(page: WMFPage(namespaceID: Int(namespaceID), projectID: projectID, title: title), count: count))
             }
-            return pageViewCounts
+            
+            // Most viewed first
+            return pageViewCounts.sorted { lhs, rhs in
+                if lhs.count != rhs.count {
+                    return lhs.count > rhs.count
+                }
+                return lhs.id < rhs.id
+            }
         }
         
         return results
@@ -206,31 +366,187 @@ public final class WMFPageViewsDataController {
         }
         
         let results: [WMFPageViewDay] = try context.performAndWait {
-            let predicate = NSPredicate(format: "timestamp >= %@ && timestamp <= %@", startDate as CVarArg, endDate as CVarArg)
-            let cdPageViews = try self.coreDataStore.fetch(entityType: CDPageView.self, predicate: predicate, fetchLimit: nil, in: context)
+            let rollups = WMFPageViewRollups()
+            let split = try rollups.isCurrent(in: context) ? rollups.split(startDate: startDate, endDate: endDate) : nil
             
-            guard let cdPageViews = cdPageViews else {
-                return []
+            var countsDictionary: [Int: Int] = [:]
+            
+            if let rollupDays = split?.rollupDays {
+                let rollupCounts = try self.coreDataStore.fetchGroupedSum(entityType: CDPageViewDailyRollup.self, predicate: rollups.rollupsPredicate(days: rollupDays), propertyToSum: "viewCount", propertiesToGroupBy: ["weekday"], in: context)
+                for dict in rollupCounts {
+                    guard let dayOfWeek = dict["weekday"] as? Int,
+                          let count = dict["sum"] as? Int else {
+                        continue
+                    }
+                    countsDictionary[dayOfWeek, default: 0] += count
+                }
             }
             
-            var countsDictionary: [Int: Int] = [:]
+            let predicate = split?.viewsPredicate ?? NSPredicate(format: "timestamp >= %@ && timestamp <= %@", startDate as CVarArg, endDate as CVarArg)
+            let cdPageViews = try self.coreDataStore.fetch(entityType: CDPageView.self, predicate: predicate, fetchLimit: nil, in: context) ?? []
             
             for cdPageView in cdPageViews {
                 if let timestamp = cdPageView.timestamp {
-                    let calendar = Calendar.current
+                    let calendar = rollups.calendar
                     let dayOfWeek = calendar.component(.weekday, from: timestamp) // Sunday = 1, Monday = 2, ..., Saturday = 7
                     
                     countsDictionary[dayOfWeek, default: 0] += 1
                 }
             }
             
-            return countsDictionary.sorted(by: { $0.key < $1.key }).map { dayOfWeek, count in
+            return countsDictionary.filter { $0.value > 0 }.sorted(by: { $0.key < $1.key }).map { dayOfWeek, count in
                 WMFPageViewDay(day: dayOfWeek, viewCount: count)
             }
         }
         
         return results
     }
-
-
+    
+    /// Page view counts by hour of the day in the current time zone, 0 through 23. Hours without views are omitted.
+    public func fetchPageViewHourCounts(startDate: Date, endDate: Date, moc: NSManagedObjectContext? = nil) throws -> [Int: Int] {
+        let context: NSManagedObjectContext
+        if let moc {
+            context = moc
+        } else {
+            context = try coreDataStore.viewContext
+        }
+        
+        return try context.performAndWait {
+            let rollups = WMFPageViewRollups()
+            let split = try rollups.isCurrent(in: context) ? rollups.split(startDate: startDate, endDate: endDate) : nil
+            
+            var countsDictionary: [Int: Int] = [:]
+            
+            if let rollupDays = split?.rollupDays {
+                let dayRollups = try self.coreDataStore.fetch(entityType: CDPageViewDailyRollup.self, predicate: rollups.rollupsPredicate(days: rollupDays), fetchLimit: nil, in: context) ?? []
+                for dayRollup in dayRollups {
+                    for (hour, count) in WMFPageViewRollups.hourlyViewCounts(from: dayRollup.hourlyViewCounts).enumerated() where count > 0 {
+                        countsDictionary[hour, default: 0] += count
+                    }
+                }
+            }
+            
+            let predicate = split?.viewsPredicate ?? NSPredicate(format: "timestamp >= %@ && timestamp <= %@", startDate as CVarArg, endDate as CVarArg)
+            let cdPageViews = try self.coreDataStore.fetch(entityType: CDPageView.self, predicate: predicate, fetchLimit: nil, in: context) ?? []
+            for cdPageView in cdPageViews {
+                if let timestamp = cdPageView.timestamp {
+                    countsDictionary[rollups.calendar.component(.hour, from: timestamp), default: 0] += 1
+                }
+            }
+            
+            return countsDictionary
+        }
+    }
+    
+    /// Computes the page view counts, weekday counts and viewed days for a range at once. Each of the range's rollups and views is read once, instead of once per total as the separate fetch methods do.
+    public func fetchPageViewSummary(startDate: Date, endDate: Date, moc: NSManagedObjectContext? = nil) throws -> WMFPageViewSummary {
+        let context: NSManagedObjectContext
+        if let moc {
+            context = moc
+        } else {
+            context = try coreDataStore.viewContext
+        }
+        
+        return try context.performAndWait {
+            let rollups = WMFPageViewRollups()
+            let split = try rollups.isCurrent(in: context) ? rollups.split(startDate: startDate, endDate: endDate) : nil
+            
+            var countsByPageID: [NSManagedObjectID: Int] = [:]
+            var countsByWeekday: [Int: Int] = [:]
+            var viewedDays: Set<Date> = []
+            
+            if let rollupDays = split?.rollupDays {
+                let rollupsRequest = NSFetchRequest<NSDictionary>(entityName: "CDPageViewDailyRollup")
+                rollupsRequest.resultType = .dictionaryResultType
+                rollupsRequest.propertiesToFetch = ["page", "day", "weekday", "viewCount"]
+                rollupsRequest.predicate = rollups.rollupsPredicate(days: rollupDays)
+                for rollup in try context.fetch(rollupsRequest) {
+                    guard let pageID = rollup["page"] as? NSManagedObjectID,
+                          let day = rollup["day"] as? Date,
+                          let weekday = rollup["weekday"] as? Int,
+                          let count = rollup["viewCount"] as? Int,
+                          count > 0 else {
+                        continue
+                    }
+                    countsByPageID[pageID, default: 0] += count
+                    countsByWeekday[weekday, default: 0] += count
+                    viewedDays.insert(day)
+                }
+            }
+            
+            let viewsRequest = NSFetchRequest<NSDictionary>(entityName: "CDPageView")
+            viewsRequest.resultType = .dictionaryResultType
+            viewsRequest.propertiesToFetch = ["page", "timestamp"]
+            viewsRequest.predicate = split?.viewsPredicate ?? NSPredicate(format: "timestamp >= %@ && timestamp <= %@", startDate as CVarArg, endDate as CVarArg)
+            // Sorted so consecutive views mostly fall on the same day
+            viewsRequest.sortDescriptors = [NSSortDescriptor(key: "timestamp", ascending: true)]
+            var dayLookup = DayLookup(calendar: rollups.calendar)
+            for view in try context.fetch(viewsRequest) {
+                guard let pageID = view["page"] as? NSManagedObjectID,
+                      let timestamp = view["timestamp"] as? Date else {
+                    continue
+                }
+                let day = dayLookup.day(containing: timestamp)
+                countsByPageID[pageID, default: 0] += 1
+                countsByWeekday[day.weekday, default: 0] += 1
+                viewedDays.insert(day.start)
+            }
+            
+            // Fetch the viewed pages together rather than firing a fault for each
+            var pageViewCounts: [WMFPageViewCount] = []
+            pageViewCounts.reserveCapacity(countsByPageID.count)
+            let pagesPredicate = NSPredicate(format: "self IN %@", Array(countsByPageID.keys))
+            for page in try self.coreDataStore.fetch(entityType: CDPage.self, predicate: pagesPredicate, fetchLimit: nil, in: context) ?? [] {
+                guard let count = countsByPageID[page.objectID],
+                      let projectID = page.projectID, let title = page.title else {
+                    continue
+                }
+                pageViewCounts.append(WMFPageViewCount(page: WMFPage(namespaceID: Int(page.namespaceID), projectID: projectID, title: title), count: count))
+            }
+            
+            pageViewCounts.sort { lhs, rhs in
+                if lhs.count != rhs.count {
+                    return lhs.count > rhs.count
+                }
+                return lhs.id < rhs.id
+            }
+            
+            let pageViewDays = countsByWeekday.sorted(by: { $0.key < $1.key }).map { dayOfWeek, count in
+                WMFPageViewDay(day: dayOfWeek, viewCount: count)
+            }
+            
+            return WMFPageViewSummary(pageViewCounts: pageViewCounts, pageViewDays: pageViewDays, viewedDays: viewedDays.sorted())
+        }
+    }
+    
+    // MARK: - Rollups
+    
+    /// Saves newly inserted views along with their rollups, rebuilding the rollups if they're out of date
+    private func saveUpdatingRollups(addedViews: [(page: CDPage, timestamp: Date)], in moc: NSManagedObjectContext) throws {
+        let rollups = WMFPageViewRollups()
+        
+        guard try rollups.isCurrent(in: moc) else {
+            // Rebuilding reads saved views, so save the new ones first
+            try coreDataStore.saveIfNeeded(moc: moc)
+            try rollups.rebuild(in: moc)
+            try coreDataStore.saveIfNeeded(moc: moc)
+            return
+        }
+        
+        // Another context may update the same rollups first. Their changes are discarded and the new views are added on top of the saved totals.
+        for attempt in 1...3 {
+            try rollups.add(views: addedViews, in: moc)
+            do {
+                try coreDataStore.saveIfNeeded(moc: moc)
+                return
+            } catch let error as NSError where error.domain == NSCocoaErrorDomain && error.code == NSManagedObjectMergeError && attempt < 3 {
+                for case let rollup as CDPageViewDailyRollup in moc.insertedObjects {
+                    moc.delete(rollup)
+                }
+                for case let rollup as CDPageViewDailyRollup in moc.updatedObjects {
+                    moc.refresh(rollup, mergeChanges: false)
+                }
+            }
+        }
+    }
 }
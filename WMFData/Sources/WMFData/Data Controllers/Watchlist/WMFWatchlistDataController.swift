@@ -3,8 +3,19 @@ import UIKit
 
 public class WMFWatchlistDataController {
     
-    var service = WMFDataEnvironment.current.mediaWikiService
+    var service = WMFDataEnvironment.current.mediaWikiService {
+        didSet {
+            syncEngine = nil
+        }
+    }
+    /// The date cached changes are aged from
+    var currentDate: () -> Date = { Date() } {
+        didSet {
+            syncEngine = nil
+        }
+    }
     private let sharedCacheStore = WMFDataEnvironment.current.sharedCacheStore
+    private var syncEngine: WMFWatchlistSyncEngine?
     private let userDefaultsStore = WMFDataEnvironment.current.userDefaultsStore
 
     public init() { }
@@ -109,6 +120,7 @@ public class WMFWatchlistDataController {
         }
         
         let filterSettings = loadFilterSettings()
+        let username = WMFDataEnvironment.current.usernameUtility?()
         
         var parameters = [
                     "action": "query",
@@ -123,118 +135,35 @@ public class WMFWatchlistDataController {
         
         apply(filterSettings: filterSettings, to: &parameters)
         
-        let group = DispatchGroup()
-        var items: [WMFWatchlist.Item] = []
-        var errors: [WMFProject: [WMFDataControllerError]] = [:]
-        projects.forEach { project in
-            errors[project] = []
-        }
+        let syncEngine = self.syncEngine ?? WMFWatchlistSyncEngine(service: service, cacheStore: sharedCacheStore, currentDate: currentDate)
+        self.syncEngine = syncEngine
+        let replacesOlderRevisions = filterSettings.latestRevisions == .latestRevision
         
-        for project in projects {
+        Task {
+            let result = await syncEngine.sync(projects: projects, username: username, parameters: parameters, replacesOlderRevisions: replacesOlderRevisions)
             
-            guard let url = URL.mediaWikiAPIURL(project: project) else {
-                return
-            }
-            
-            parameters["variant"] = project.languageVariantCode
-            
-            group.enter()
-            let request = WMFMediaWikiServiceRequest(url: url, method: .GET, backend: .mediaWiki, parameters: parameters)
-            service.performDecodableGET(request: request) { [weak self] (result: Result<WatchlistAPIResponse, Error>) in
+            await MainActor.run {
+                let successProjects = result.errors.filter { $0.value.isEmpty }
+                let failureProjects = result.errors.filter { !$0.value.isEmpty }
                 
-                guard let self else {
+                if !successProjects.isEmpty {
+                    completion(.success(WMFWatchlist(items: result.items, activeFilterCount: activeFilterCount)))
                     return
                 }
                 
-                defer {
-                    group.leave()
+                if let error = failureProjects.first?.value.first {
+                    completion(.failure(error))
+                    return
                 }
                 
-                switch result {
-                case .success(let apiResponse):
-                    
-                    if let apiResponseErrors = apiResponse.errors,
-                       !apiResponseErrors.isEmpty {
-                        
-                        let mediaWikiResponseErrors = apiResponseErrors.map { WMFDataControllerError.mediaWikiResponseError($0) }
-                        errors[project, default: []].append(contentsOf: mediaWikiResponseErrors)
-                        return
-                    }
-                    
-                    guard let query = apiResponse.query else {
-                        errors[project, default: []].append(WMFDataControllerError.unexpectedResponse)
-                        return
-                    }
-                    
-                    items.append(contentsOf: self.watchlistItems(from: query, project: project))
-                    
-                    try? sharedCacheStore?.save(key: WMFSharedCacheDirectoryNames.watchlists.rawValue, project.id, value: apiResponse)
-                    
-                case .failure(let error):
-                    var usedCache = false
-                    
-                    if (error as NSError).isInternetConnectionError {
-                        
-                        let cachedResult: WatchlistAPIResponse? = try? sharedCacheStore?.load(key: WMFSharedCacheDirectoryNames.watchlists.rawValue, project.id)
-                        
-                        if let query = cachedResult?.query {
-                            items.append(contentsOf: self.watchlistItems(from: query, project: project))
-                            usedCache = true
-                        }
-                    }
-                    
-                    if !usedCache {
-                        errors[project, default: []].append(WMFDataControllerError.serviceError(error))
-                    }
-                }
+                completion(.success(WMFWatchlist(items: result.items, activeFilterCount: activeFilterCount)))
             }
         }
-        
-        group.notify(queue: .main) {
-        
-            let successProjects = errors.filter { $0.value.isEmpty }
-            let failureProjects = errors.filter { !$0.value.isEmpty }
-            
-            if !successProjects.isEmpty {
-                completion(.success(WMFWatchlist(items: items, activeFilterCount: activeFilterCount)))
-                return
-            }
-            
-            if let error = failureProjects.first?.value.first {
-                completion(.failure(error))
-                return
-            }
-            
-            completion(.success(WMFWatchlist(items: items, activeFilterCount: activeFilterCount)))
-        }
     }
     
-    private func watchlistItems(from apiResponseQuery: WatchlistAPIResponse.Query, project: WMFProject) -> [WMFWatchlist.Item] {
-        
-        var items: [WMFWatchlist.Item] = []
-        for item in apiResponseQuery.watchlist {
-            
-            guard let timestamp = DateFormatter.mediaWikiAPIDateFormatter.date(from: item.timestampString) else {
-                continue
-            }
-            
-            let item = WMFWatchlist.Item(
-                title: item.title,
-                revisionID: item.revisionID,
-                oldRevisionID: item.oldRevisionID,
-                username: item.username,
-                isAnon: item.isAnon,
-                isBot: item.isBot,
-                timestamp: timestamp,
-                commentWikitext: item.commentWikitext ?? "",
-                commentHtml: item.commentHtml ?? "",
-                byteLength: item.byteLength,
-                oldByteLength: item.oldByteLength,
-                project: project)
-            items.append(item)
-        }
-        
-        return items
+    /// Removes cached watchlist changes of every account, for when the user logs out
+    public func removeCachedWatchlists() {
+        WMFWatchlistSyncEngine.removeAllCaches(cacheStore: sharedCacheStore)
     }
     
     private func apply(filterSettings: WMFWatchlistFilterSettings, to parameters: inout [String: String]) {
@@ -342,6 +271,8 @@ public class WMFWatchlistDataController {
                      return
                  }
 
+                 WMFWatchlistSyncEngine.removeCaches(project: project, cacheStore: self.sharedCacheStore)
+
                  completion(.success(()))
              case .failure(let error):
                  completion(.failure(WMFDataControllerError.serviceError(error)))
@@ -383,6 +314,8 @@ public class WMFWatchlistDataController {
                      return
                  }
 
+                 WMFWatchlistSyncEngine.removeCaches(project: project, cacheStore: self.sharedCacheStore)
+
                  completion(.success(()))
              case .failure(let error):
                  completion(.failure(WMFDataControllerError.serviceError(error)))
@@ -592,45 +525,6 @@ public class WMFWatchlistDataController {
 // MARK: - Private Models
 
 private extension WMFWatchlistDataController {
-    struct WatchlistAPIResponse: Codable {
-        
-        struct Query: Codable {
-            
-            struct Item: Codable {
-                let title: String
-                let revisionID: UInt
-                let oldRevisionID: UInt
-                let username: String
-                let isAnon: Bool
-                let isBot: Bool
-                let timestampString: String
-                let commentWikitext: String?
-                let commentHtml: String?
-                let byteLength: UInt
-                let oldByteLength: UInt
-                
-                enum CodingKeys: String, CodingKey {
-                    case title
-                    case revisionID = "revid"
-                    case oldRevisionID = "old_revid"
-                    case username = "user"
-                    case isAnon = "anon"
-                    case isBot = "bot"
-                    case timestampString = "timestamp"
-                    case commentWikitext = "comment"
-                    case commentHtml = "parsedcomment"
-                    case byteLength = "newlen"
-                    case oldByteLength = "oldlen"
-                }
-            }
-            
-            let watchlist: [Item]
-        }
-        
-        let query: Query?
-        let errors: [WMFMediaWikiError]?
-    }
-
     struct PageWatchStatusAndRollbackResponse: Codable {
 
         struct Query: Codable {
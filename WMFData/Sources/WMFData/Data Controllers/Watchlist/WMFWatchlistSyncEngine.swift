@@ -0,0 +1,527 @@
+import Foundation
+
+/// Fetches watchlist changes for several projects and keeps a cache of them per account and project.
+///
+/// Each project is paged through with `wlcontinue`, a few projects at a time. Items are cached by revision ID, so a refresh only requests changes newer than the newest cached one. Syncs run one after another, and a sync requested while an identical one is running shares its result.
+///
+/// Refreshes can't tell when pages are watched or unwatched, so caches are removed when that happens in the app, and a project is fetched in full again once its cache is older than `fullFetchInterval`. Cached changes older than the server's retention window are dropped.
+actor WMFWatchlistSyncEngine {
+
+    struct Result {
+        let items: [WMFWatchlist.Item]
+        let errors: [WMFProject: [WMFDataControllerError]]
+    }
+
+    private struct SyncRequest: Equatable {
+        let projects: [WMFProject]
+        let username: String?
+        let parameters: [String: String]
+        let replacesOlderRevisions: Bool
+    }
+
+    private let service: WMFService
+    private let cacheStore: WMFKeyValueStore?
+    private let maxConcurrentProjects: Int
+    private let maxPagesPerProject: Int
+    private let retentionInterval: TimeInterval
+    private let fullFetchInterval: TimeInterval
+    private let currentDate: () -> Date
+
+    private var currentSync: (request: SyncRequest, task: Task<Result, Never>)?
+
+    /// - Parameters:
+    ///   - retentionInterval: How long the server keeps recent changes, `$wgRCMaxAge`. Cached changes older than this are dropped.
+    ///   - fullFetchInterval: How long a project is refreshed from its cache before it's fetched in full again, to pick up pages watched or unwatched elsewhere
+    ///   - currentDate: The date retention and full fetches are measured from
+    init(service: WMFService, cacheStore: WMFKeyValueStore?, maxConcurrentProjects: Int = 4, maxPagesPerProject: Int = 10, retentionInterval: TimeInterval = 30 * 24 * 60 * 60, fullFetchInterval: TimeInterval = 60 * 60, currentDate: @escaping () -> Date = { Date() }) {
+        self.service = service
+        self.cacheStore = cacheStore
+        self.maxConcurrentProjects = max(maxConcurrentProjects, 1)
+        self.maxPagesPerProject = max(maxPagesPerProject, 1)
+        self.retentionInterval = retentionInterval
+        self.fullFetchInterval = fullFetchInterval
+        self.currentDate = currentDate
+    }
+
+    // MARK: Sync
+
+    /// Fetches new changes for each project and returns every cached change, newest first.
+    /// - Parameters:
+    ///   - projects: Projects to sync. Items from projects earlier in the list come first when timestamps are equal.
+    ///   - username: The logged in account the watchlist belongs to. Nothing is cached without one.
+    ///   - parameters: `list=watchlist` query parameters, without `variant` or continuation parameters. Cached items are only used for the same parameters.
+    ///   - replacesOlderRevisions: Whether a new change to a page replaces the cached changes to that page, as when only the latest revision of each page is listed.
+    func sync(projects: [WMFProject], username: String?, parameters: [String: String], replacesOlderRevisions: Bool) async -> Result {
+        let request = SyncRequest(projects: projects, username: username, parameters: parameters, replacesOlderRevisions: replacesOlderRevisions)
+
+        if let currentSync,
+           currentSync.request == request {
+            return await currentSync.task.value
+        }
+
+        let previousTask = currentSync?.task
+        let task = Task {
+            _ = await previousTask?.value
+            return await self.performSync(request)
+        }
+        currentSync = (request, task)
+        let result = await task.value
+        if currentSync?.task == task {
+            currentSync = nil
+        }
+        return result
+    }
+
+    private func performSync(_ request: SyncRequest) async -> Result {
+        var itemsByProject: [[WMFWatchlist.Item]] = Array(repeating: [], count: request.projects.count)
+        var errors: [WMFProject: [WMFDataControllerError]] = [:]
+        request.projects.forEach { project in
+            errors[project] = []
+        }
+
+        await withTaskGroup(of: (Int, Swift.Result<[WMFWatchlist.Item], WMFDataControllerError>).self) { group in
+            var nextIndex = 0
+
+            func addNextProject() {
+                guard nextIndex < request.projects.count else {
+                    return
+                }
+                let index = nextIndex
+                let project = request.projects[index]
+                nextIndex += 1
+                group.addTask {
+                    return (index, await self.syncProject(project, request: request))
+                }
+            }
+
+            for _ in 0..<maxConcurrentProjects {
+                addNextProject()
+            }
+
+            while let (index, result) = await group.next() {
+                switch result {
+                case .success(let items):
+                    itemsByProject[index] = items
+                case .failure(let error):
+                    errors[request.projects[index], default: []].append(error)
+                }
+                addNextProject()
+            }
+        }
+
+        return Result(items: Self.mergedItems(itemsByProject), errors: errors)
+    }
+
+    private func syncProject(_ project: WMFProject, request: SyncRequest) async -> Swift.Result<[WMFWatchlist.Item], WMFDataControllerError> {
+        guard let url = URL.mediaWikiAPIURL(project: project) else {
+            return .failure(.failureCreatingRequestURL)
+        }
+
+        let now = currentDate()
+        let retentionStartString = DateFormatter.mediaWikiAPIDateFormatter.string(from: now.addingTimeInterval(-retentionInterval))
+        let generation = Self.cacheGeneration(project: project, cacheStore: cacheStore)
+
+        var cache = request.username.flatMap { loadCache(project: project, username: $0) }
+        if let existingCache = cache {
+            if existingCache.parameters != request.parameters || existingCache.generation != generation {
+                cache = nil
+            } else {
+                cache = existingCache.trimmed(before: retentionStartString)
+            }
+        }
+
+        // Pages watched or unwatched since the last full fetch would be missed by only asking for newer changes
+        var refreshedCache = cache
+        if let fullFetchDate = cache?.fullFetchDate,
+           now.timeIntervalSince(fullFetchDate) >= fullFetchInterval || fullFetchDate > now {
+            refreshedCache = nil
+        }
+
+        var parameters = request.parameters
+        parameters["variant"] = project.languageVariantCode
+        if let newestTimestampString = refreshedCache?.items.first?.timestampString {
+            // wlend is inclusive, changes made in the same second as the newest cached change are deduplicated below
+            parameters["wlend"] = newestTimestampString
+        }
+
+        var fetchedItems: [APIResponse.Query.Item] = []
+        var isComplete = false
+        do {
+            var continueParameters: [String: String] = [:]
+            for _ in 0..<maxPagesPerProject {
+                let pageRequest = WMFMediaWikiServiceRequest(url: url, method: .GET, backend: .mediaWiki, parameters: parameters.merging(continueParameters) { $1 })
+                let response = try await fetchPage(request: pageRequest)
+
+                if let apiResponseErrors = response.errors,
+                   let apiResponseError = apiResponseErrors.first {
+                    return .failure(.mediaWikiResponseError(apiResponseError))
+                }
+
+                guard let query = response.query else {
+                    return .failure(.unexpectedResponse)
+                }
+
+                fetchedItems.append(contentsOf: query.watchlist)
+
+                guard let nextContinueParameters = response.continueParameters,
+                      !nextContinueParameters.isEmpty else {
+                    isComplete = true
+                    break
+                }
+                continueParameters = nextContinueParameters
+            }
+        } catch let error {
+            if (error as NSError).isInternetConnectionError,
+               let cache {
+                return .success(Self.watchlistItems(from: cache.items, project: project))
+            }
+            return .failure(.serviceError(error))
+        }
+
+        var items: [APIResponse.Query.Item]
+        var fullFetchDate = now
+        if let refreshedCache, isComplete {
+            items = Self.merging(fetchedItems, into: refreshedCache.items, replacesOlderRevisions: request.replacesOlderRevisions)
+            fullFetchDate = refreshedCache.fullFetchDate
+        } else {
+            // Either nothing was cached, the cache is due a full fetch, or more changes were made since the last sync than fit in the pages fetched. In that case older cached changes can't be joined to the fetched ones without a gap.
+            items = Self.merging(fetchedItems, into: [], replacesOlderRevisions: request.replacesOlderRevisions)
+        }
+
+        items = Array(items.prefix(maxPagesPerProject * (Int(request.parameters["wllimit"] ?? "") ?? 500)))
+        if let username = request.username {
+            let cache = Cache(parameters: request.parameters, items: items, generation: generation, fullFetchDate: fullFetchDate).trimmed(before: retentionStartString)
+            saveCache(cache, project: project, username: username)
+        }
+
+        return .success(Self.watchlistItems(from: items, project: project))
+    }
+
+    private func fetchPage(request: WMFMediaWikiServiceRequest) async throws -> APIResponse {
+        return try await withCheckedThrowingContinuation { continuation in
+            service.performDecodableGET(request: request) { (result: Swift.Result<APIResponse, Error>) in
+                continuation.resume(with: result)
+            }
+        }
+    }
+
+    // MARK: Merging
+
+    /// Adds fetched changes to cached ones, keyed by revision ID, newest first
+    private static func merging(_ fetchedItems: [APIResponse.Query.Item], into cachedItems: [APIResponse.Query.Item], replacesOlderRevisions: Bool) -> [APIResponse.Query.Item] {
+        var keys: Set<APIResponse.Query.Item.Key> = []
+        var titles: Set<String> = []
+        var items: [APIResponse.Query.Item] = []
+        items.reserveCapacity(fetchedItems.count + cachedItems.count)
+
+        for item in fetchedItems where keys.insert(item.key).inserted {
+            if replacesOlderRevisions {
+                guard titles.insert(item.title).inserted else {
+                    continue
+                }
+            }
+            items.append(item)
+        }
+
+        for item in cachedItems where keys.insert(item.key).inserted {
+            if replacesOlderRevisions && titles.contains(item.title) {
+                continue
+            }
+            items.append(item)
+        }
+
+        // MediaWiki timestamps sort chronologically as strings
+        items.sort { lhs, rhs in
+            if lhs.timestampString != rhs.timestampString {
+                return lhs.timestampString > rhs.timestampString
+            }
+            if lhs.revisionID != rhs.revisionID {
+                return lhs.revisionID > rhs.revisionID
+            }
+            return (lhs.logID ?? 0) > (rhs.logID ?? 0)
+        }
+        return items
+    }
+
+    /// Merges lists of items that are each sorted newest first into one list sorted newest first. Items with equal timestamps are ordered by list, then by their order within the list.
+    static func mergedItems(_ itemLists: [[WMFWatchlist.Item]]) -> [WMFWatchlist.Item] {
+        var heap = MergeHeap(itemLists: itemLists)
+        var items: [WMFWatchlist.Item] = []
+        items.reserveCapacity(itemLists.reduce(0) { $0 + $1.count })
+        while let item = heap.popNext() {
+            items.append(item)
+        }
+        return items
+    }
+
+    /// A binary min-heap of the next unmerged item in each list
+    private struct MergeHeap {
+
+        private struct Cursor {
+            let listIndex: Int
+            var itemIndex: Int
+        }
+
+        private let itemLists: [[WMFWatchlist.Item]]
+        private var cursors: [Cursor]
+
+        init(itemLists: [[WMFWatchlist.Item]]) {
+            self.itemLists = itemLists
+            self.cursors = []
+            for (listIndex, items) in itemLists.enumerated() where !items.isEmpty {
+                push(Cursor(listIndex: listIndex, itemIndex: 0))
+            }
+        }
+
+        mutating func popNext() -> WMFWatchlist.Item? {
+            guard var cursor = cursors.first else {
+                return nil
+            }
+
+            let item = itemLists[cursor.listIndex][cursor.itemIndex]
+            cursor.itemIndex += 1
+            if cursor.itemIndex < itemLists[cursor.listIndex].count {
+                cursors[0] = cursor
+                siftDown(from: 0)
+            } else {
+                let last = cursors.removeLast()
+                if !cursors.isEmpty {
+                    cursors[0] = last
+                    siftDown(from: 0)
+                }
+            }
+            return item
+        }
+
+        private func precedes(_ lhs: Cursor, _ rhs: Cursor) -> Bool {
+            let lhsTimestamp = itemLists[lhs.listIndex][lhs.itemIndex].timestamp
+            let rhsTimestamp = itemLists[rhs.listIndex][rhs.itemIndex].timestamp
+            if lhsTimestamp != rhsTimestamp {
+                return lhsTimestamp > rhsTimestamp
+            }
+            return lhs.listIndex < rhs.listIndex
+        }
+
+        private mutating func push(_ cursor: Cursor) {
+            cursors.append(cursor)
+            var index = cursors.count - 1
+            while index > 0 {
+                let parentIndex = (index - 1) / 2
+                guard precedes(cursors[index], cursors[parentIndex]) else {
+                    break
+                }
+                cursors.swapAt(index, parentIndex)
+                index = parentIndex
+            }
+        }
+
+        private mutating func siftDown(from index: Int) {
+            var index = index
+            while true {
+                let leftIndex = 2 * index + 1
+                let rightIndex = leftIndex + 1
+                var firstIndex = index
+                if leftIndex < cursors.count && precedes(cursors[leftIndex], cursors[firstIndex]) {
+                    firstIndex = leftIndex
+                }
+                if rightIndex < cursors.count && precedes(cursors[rightIndex], cursors[firstIndex]) {
+                    firstIndex = rightIndex
+                }
+                guard firstIndex != index else {
+                    return
+                }
+                cursors.swapAt(index, firstIndex)
+                index = firstIndex
+            }
+        }
+    }
+
+    // MARK: Cache
+
+    private static let cacheIndexKey = "Index"
+    private static let cacheIndexLock = NSLock()
+
+    private static func cacheKey(project: WMFProject, username: String) -> String {
+        let accountKey = username.addingPercentEncoding(withAllowedCharacters: .alphanumerics) ?? username
+        return "\(accountKey)-\(project.id)"
+    }
+
+    private func loadCache(project: WMFProject, username: String) -> Cache? {
+        return try? cacheStore?.load(key: WMFSharedCacheDirectoryNames.watchlists.rawValue, Self.cacheKey(project: project, username: username))
+    }
+
+    private func saveCache(_ cache: Cache, project: WMFProject, username: String) {
+        guard let cacheStore else {
+            return
+        }
+
+        let cacheKey = Self.cacheKey(project: project, username: username)
+        Self.cacheIndexLock.lock()
+        defer { Self.cacheIndexLock.unlock() }
+
+        var index = Self.loadCacheIndex(cacheStore: cacheStore)
+        if index.cacheKeysByProjectID[project.id, default: []].insert(cacheKey).inserted {
+            try? cacheStore.save(key: WMFSharedCacheDirectoryNames.watchlists.rawValue, Self.cacheIndexKey, value: index)
+        }
+        try? cacheStore.save(key: WMFSharedCacheDirectoryNames.watchlists.rawValue, cacheKey, value: cache)
+    }
+
+    private static func loadCacheIndex(cacheStore: WMFKeyValueStore) -> CacheIndex {
+        let index: CacheIndex? = try? cacheStore.load(key: WMFSharedCacheDirectoryNames.watchlists.rawValue, cacheIndexKey)
+        return index ?? CacheIndex()
+    }
+
+    private static func cacheGeneration(project: WMFProject, cacheStore: WMFKeyValueStore?) -> Int {
+        guard let cacheStore else {
+            return 0
+        }
+
+        cacheIndexLock.lock()
+        defer { cacheIndexLock.unlock() }
+        return loadCacheIndex(cacheStore: cacheStore).generationsByProjectID[project.id] ?? 0
+    }
+
+    /// Removes every account's cache of the project, for when pages on it are watched or unwatched. Caches saved by syncs that started before are ignored.
+    static func removeCaches(project: WMFProject, cacheStore: WMFKeyValueStore?) {
+        removeCaches(cacheStore: cacheStore) { $0 == project.id }
+    }
+
+    /// Removes every account's cache of every project, for when the user logs out
+    static func removeAllCaches(cacheStore: WMFKeyValueStore?) {
+        removeCaches(cacheStore: cacheStore) { _ in true }
+    }
+
+    private static func removeCaches(cacheStore: WMFKeyValueStore?, projectIDs isIncluded: (String) -> Bool) {
+        guard let cacheStore else {
+            return
+        }
+
+        cacheIndexLock.lock()
+        defer { cacheIndexLock.unlock() }
+
+        var index = loadCacheIndex(cacheStore: cacheStore)
+        for (projectID, cacheKeys) in index.cacheKeysByProjectID where isIncluded(projectID) {
+            for cacheKey in cacheKeys {
+                try? cacheStore.remove(key: WMFSharedCacheDirectoryNames.watchlists.rawValue, cacheKey)
+            }
+            index.cacheKeysByProjectID[projectID] = nil
+            index.generationsByProjectID[projectID, default: 0] += 1
+        }
+        try? cacheStore.save(key: WMFSharedCacheDirectoryNames.watchlists.rawValue, cacheIndexKey, value: index)
+    }
+
+    private static func watchlistItems(from apiResponseItems: [APIResponse.Query.Item], project: WMFProject) -> [WMFWatchlist.Item] {
+
+        var items: [WMFWatchlist.Item] = []
+        items.reserveCapacity(apiResponseItems.count)
+        for item in apiResponseItems {
+
+            guard let timestamp = DateFormatter.mediaWikiAPIDateFormatter.date(from: item.timestampString) else {
+                continue
+            }
+
+            let item = WMFWatchlist.Item(
+                title: item.title,
+                revisionID: item.revisionID,
+                oldRevisionID: item.oldRevisionID,
+                username: item.username,
+                isAnon: item.isAnon,
+                isBot: item.isBot,
+                timestamp: timestamp,
+                commentWikitext: item.commentWikitext ?? "",
+                commentHtml: item.commentHtml ?? "",
+                byteLength: item.byteLength,
+                oldByteLength: item.oldByteLength,
+                project: project)
+            items.append(item)
+        }
+
+        return items
+    }
+}
+
+// MARK: - Private Models
+
+private extension WMFWatchlistSyncEngine {
+
+    struct Cache: Codable {
+        let parameters: [String: String]
+        let items: [APIResponse.Query.Item]
+        /// The project's generation in the cache index when the items were fetched
+        let generation: Int
+        /// When the project was last fetched in full rather than refreshed from the cache
+        let fullFetchDate: Date
+
+        func trimmed(before timestampString: String) -> Cache {
+            // Items are newest first, and MediaWiki timestamps sort chronologically as strings
+            let retainedCount = items.firstIndex { $0.timestampString < timestampString } ?? items.count
+            return Cache(parameters: parameters, items: Array(items.prefix(retainedCount)), generation: generation, fullFetchDate: fullFetchDate)
+        }
+    }
+
+    /// The caches saved for each project, so they can be removed without knowing which accounts they belong to
+    struct CacheIndex: Codable {
+        var cacheKeysByProjectID: [String: Set<String>] = [:]
+        /// Incremented each time a project's caches are removed, so a sync that started before doesn't save a stale cache over the removal
+        var generationsByProjectID: [String: Int] = [:]
+    }
+
+    struct APIResponse: Codable {
+
+        struct Query: Codable {
+
+            struct Item: Codable {
+
+                /// Log entries have no revision, so they're told apart by log ID
+                struct Key: Hashable {
+                    let revisionID: UInt
+                    let logID: UInt?
+                }
+
+                let title: String
+                let revisionID: UInt
+                let oldRevisionID: UInt
+                let username: String
+                let isAnon: Bool
+                let isBot: Bool
+                let timestampString: String
+                let commentWikitext: String?
+                let commentHtml: String?
+                let byteLength: UInt
+                let oldByteLength: UInt
+                let logID: UInt?
+
+                var key: Key {
+                    return Key(revisionID: revisionID, logID: revisionID == 0 ? logID : nil)
+                }
+
+                enum CodingKeys: String, CodingKey {
+                    case title
+                    case revisionID = "revid"
+                    case oldRevisionID = "old_revid"
+                    case username = "user"
+                    case isAnon = "anon"
+                    case isBot = "bot"
+                    case timestampString = "timestamp"
+                    case commentWikitext = "comment"
+                    case commentHtml = "parsedcomment"
+                    case byteLength = "newlen"
+                    case oldByteLength = "oldlen"
+                    case logID = "logid"
+                }
+            }
+
+            let watchlist: [Item]
+        }
+
+        let query: Query?
+        let errors: [WMFMediaWikiError]?
+        let continueParameters: [String: String]?
+
+        enum CodingKeys: String, CodingKey {
+            case query
+            case errors
+            case continueParameters = "continue"
+        }
+    }
+}
@@ -283,10 +283,15 @@ import CoreData
             return nil
         }
         
+        guard let iosFeatureConfig = developerSettingsDataController.loadFeatureConfig()?.ios.first,
+              let yirConfig = iosFeatureConfig.yir(yearID: targetConfigYearID) else {
+            return nil
+        }
+        
         let backgroundContext = try coreDataStore.newBackgroundContext
         
         let result: (report: CDYearInReviewReport, needsReadingPopulation: Bool, needsEditingPopulation: Bool, needsDonatingPopulation: Bool, needsDayPopulation: Bool)? = try await backgroundContext.perform { [weak self] in
-            return try self?.getYearInReviewReportAndDataPopulationFlags(year: year, backgroundContext: backgroundContext, project: primaryAppLanguageProject, username: username)
+            return try self?.getYearInReviewReportAndDataPopulationFlags(year: year, yirConfig: yirConfig, backgroundContext: backgroundContext, username: username)
         }
         
         guard let result else {
@@ -295,37 +300,59 @@ import CoreData
         
         let report = result.report
         
-        if result.needsReadingPopulation == true {
-            try await backgroundContext.perform { [weak self] in
-                try self?.populateReadingSlide(report: report, backgroundContext: backgroundContext)
-            }
+        // The edit count is fetched while page views are aggregated
+        async let edits = fetchEditCountIfNeeded(result.needsEditingPopulation, username: username, project: primaryAppLanguageProject, yirConfig: yirConfig)
+        
+        let dataPopulationDates: (startDate: Date, endDate: Date)?
+        if let startDate = yirConfig.dataPopulationStartDate,
+           let endDate = yirConfig.dataPopulationEndDate {
+            dataPopulationDates = (startDate, endDate)
+        } else {
+            dataPopulationDates = nil
         }
         
-        if result.needsEditingPopulation == true {
-            if let username {
-                let edits = try await fetchEditCount(username: username, project: primaryAppLanguageProject)
-                try await backgroundContext.perform { [weak self] in
-                    try self?.populateEditingSlide(edits: edits, report: report, backgroundContext: backgroundContext)
-                }
+        var pageViewSummary: WMFPageViewSummary?
+        if result.needsReadingPopulation || result.needsDayPopulation,
+           let dataPopulationDates {
+            let pageViewsDataController = try WMFPageViewsDataController(coreDataStore: coreDataStore)
+            pageViewSummary = try await backgroundContext.perform {
+                try pageViewsDataController.fetchPageViewSummary(startDate: dataPopulationDates.startDate, endDate: dataPopulationDates.endDate, moc: backgroundContext)
             }
         }
         
-        if result.needsDonatingPopulation == true {
-            try await backgroundContext.perform { [weak self] in
-                try self?.populateDonatingSlide(report: report, backgroundContext: backgroundContext)
-            }
+        var donateCount: Int?
+        if result.needsDonatingPopulation,
+           let dataPopulationDates {
+            let donateHistory = WMFDonateDataController.shared.loadLocalDonationHistory(startDate: dataPopulationDates.startDate, endDate: dataPopulationDates.endDate)
+            donateCount = donateHistory?.count ?? 0
         }
         
-        if result.needsDayPopulation == true {
-            try await backgroundContext.perform { [weak self] in
-                try self?.populateDaySlide(report: report, backgroundContext: backgroundContext)
-            }
+        // Other slides are still saved if the edit count can't be fetched
+        var editCount: Int?
+        var editCountError: Error?
+        do {
+            editCount = try await edits
+        } catch let error {
+            editCountError = error
+        }
+        
+        let slideData = SlideData(readCount: result.needsReadingPopulation ? pageViewSummary?.pageViewCounts.count : nil,
+                                  mostReadDay: result.needsDayPopulation ? pageViewSummary?.pageViewDays.max(by: { $0.viewCount < $1.viewCount }) : nil,
+                                  editCount: editCount,
+                                  donateCount: donateCount)
+        
+        try await backgroundContext.perform { [weak self] in
+            try self?.populateSlides(report: report, with: slideData, backgroundContext: backgroundContext)
+        }
+        
+        if let editCountError {
+            throw editCountError
         }
         
         return WMFYearInReviewReport(cdReport: report)
     }
     
-    private func getYearInReviewReportAndDataPopulationFlags(year: Int, backgroundContext: NSManagedObjectContext, project: WMFProject?, username: String?) throws -> (report: CDYearInReviewReport, needsReadingPopulation: Bool, needsEditingPopulation: Bool, needsDonatingPopulation: Bool, needsDayPopulation: Bool)? {
+    private func getYearInReviewReportAndDataPopulationFlags(year: Int, yirConfig: WMFFeatureConfigResponse.IOS.YearInReview, backgroundContext: NSManagedObjectContext, username: String?) throws -> (report: CDYearInReviewReport, needsReadingPopulation: Bool, needsEditingPopulation: Bool, needsDonatingPopulation: Bool, needsDayPopulation: Bool)? {
         let predicate = NSPredicate(format: "year == %d", year)
         let cdReport = try self.coreDataStore.fetchOrCreate(entityType: CDYearInReviewReport.self, predicate: predicate, in: backgroundContext)
         
@@ -339,11 +366,6 @@ import CoreData
         }
         
         try self.coreDataStore.saveIfNeeded(moc: backgroundContext)
-        
-        guard let iosFeatureConfig = developerSettingsDataController.loadFeatureConfig()?.ios.first,
-              let yirConfig = iosFeatureConfig.yir(yearID: targetConfigYearID) else {
-            return nil
-        }
 
         guard let cdSlides = cdReport.slides as? Set<CDYearInReviewSlide> else {
             return nil
@@ -421,55 +443,25 @@ import CoreData
         return results
     }
     
-    private func populateReadingSlide(report: CDYearInReviewReport, backgroundContext: NSManagedObjectContext) throws {
-        
-        guard let iosFeatureConfig = developerSettingsDataController.loadFeatureConfig()?.ios.first,
-              let yirConfig = iosFeatureConfig.yir(yearID: targetConfigYearID) else {
-            return
-        }
-        
-        guard let dataPopulationStartDate = yirConfig.dataPopulationStartDate,
-              let dataPopulationEndDate = yirConfig.dataPopulationEndDate else {
-            return
-        }
-        
-        let pageViewsDataController = try WMFPageViewsDataController(coreDataStore: coreDataStore)
-        let pageViewCounts = try pageViewsDataController.fetchPageViewCounts(startDate: dataPopulationStartDate, endDate: dataPopulationEndDate, moc: backgroundContext)
-        
-        guard let slides = report.slides as? Set<CDYearInReviewSlide> else {
-            return
-        }
+    /// Values for the personalized slides that need population, nil values leave their slide unevaluated
+    private struct SlideData {
+        let readCount: Int?
+        let mostReadDay: WMFPageViewDay?
+        let editCount: Int?
+        let donateCount: Int?
+    }
+    
+    private func fetchEditCountIfNeeded(_ needsEditingPopulation: Bool, username: String?, project: WMFProject?, yirConfig: WMFFeatureConfigResponse.IOS.YearInReview) async throws -> Int? {
         
-        for slide in slides {
-            
-            guard let slideID = slide.id else {
-                continue
-            }
-            
-            switch slideID {
-            case WMFYearInReviewPersonalizedSlideID.readCount.rawValue:
-                let encoder = JSONEncoder()
-                slide.data = try encoder.encode(pageViewCounts.count)
-                
-                if pageViewCounts.count > 5 {
-                    slide.display = true
-                }
-                
-                slide.evaluated = true
-            default:
-                break
-            }
+        guard needsEditingPopulation,
+              let username else {
+            return nil
         }
         
-        try coreDataStore.saveIfNeeded(moc: backgroundContext)
+        return try await fetchEditCount(username: username, project: project, yirConfig: yirConfig)
     }
     
-    private func fetchEditCount(username: String, project: WMFProject?) async throws -> Int {
-        
-        guard let iosFeatureConfig = developerSettingsDataController.loadFeatureConfig()?.ios.first,
-              let yirConfig = iosFeatureConfig.yir(yearID: targetConfigYearID) else {
-            throw WMFYearInReviewDataControllerError.missingRemoteConfig
-        }
+    private func fetchEditCount(username: String, project: WMFProject?, yirConfig: WMFFeatureConfigResponse.IOS.YearInReview) async throws -> Int {
         
         let dataPopulationStartDateString = yirConfig.dataPopulationStartDateString
         let dataPopulationEndDateString = yirConfig.dataPopulationEndDateString
@@ -479,12 +471,14 @@ import CoreData
         return edits
     }
     
-    private func populateEditingSlide(edits: Int, report: CDYearInReviewReport, backgroundContext: NSManagedObjectContext) throws {
+    private func populateSlides(report: CDYearInReviewReport, with slideData: SlideData, backgroundContext: NSManagedObjectContext) throws {
         
         guard let slides = report.slides as? Set<CDYearInReviewSlide> else {
             return
         }
-
+        
+        let encoder = JSONEncoder()
+        
         for slide in slides {
             
             guard let slideID = slide.id else {
@@ -492,102 +486,53 @@ import CoreData
             }
             
             switch slideID {
-            case WMFYearInReviewPersonalizedSlideID.editCount.rawValue:
-                let encoder = JSONEncoder()
-                slide.data = try encoder.encode(edits)
+            case WMFYearInReviewPersonalizedSlideID.readCount.rawValue:
+                guard let readCount = slideData.readCount else {
+                    continue
+                }
                 
-                if edits > 0 {
+                slide.data = try encoder.encode(readCount)
+                
+                if readCount > 5 {
                     slide.display = true
                 }
                 
                 slide.evaluated = true
-            default:
-                break
-            }
-        }
-        
-        try coreDataStore.saveIfNeeded(moc: backgroundContext)
-    }
-    
-    private func populateDaySlide(report: CDYearInReviewReport, backgroundContext: NSManagedObjectContext) throws {
-        guard let iosFeatureConfig = developerSettingsDataController.loadFeatureConfig()?.ios.first,
-              let yirConfig = iosFeatureConfig.yir(yearID: targetConfigYearID) else {
-            return
-        }
-        
-        guard let dataPopulationStartDate = yirConfig.dataPopulationStartDate,
-              let dataPopulationEndDate = yirConfig.dataPopulationEndDate else {
-            return
-        }
-        
-        let pageViewsDataController = try WMFPageViewsDataController(coreDataStore: coreDataStore)
-        let pageViews = try pageViewsDataController.fetchPageViewDates(startDate: dataPopulationStartDate, endDate: dataPopulationEndDate)
-        
-        guard let mostPopularDay = pageViews.max(by: { $0.viewCount < $1.viewCount }) else {
-            return
-        }
-
-        guard let slides = report.slides as? Set<CDYearInReviewSlide> else {
-            return
-        }
-        
-        for slide in slides {
-            guard let slideID = slide.id else {
-                continue
-            }
-            
-            switch slideID {
-            case WMFYearInReviewPersonalizedSlideID.mostReadDay.rawValue:
-                let encoder = JSONEncoder()
-                slide.data = try encoder.encode(mostPopularDay)
+            case WMFYearInReviewPersonalizedSlideID.editCount.rawValue:
+                guard let editCount = slideData.editCount else {
+                    continue
+                }
+                
+                slide.data = try encoder.encode(editCount)
                 
-                if mostPopularDay.viewCount > 0 {
+                if editCount > 0 {
                     slide.display = true
                 }
                 
                 slide.evaluated = true
-            default:
-                break
-            }
-        }
-        
-        try coreDataStore.saveIfNeeded(moc: backgroundContext)
-    }
-
-    private func populateDonatingSlide(report: CDYearInReviewReport, backgroundContext: NSManagedObjectContext) throws {
-        
-        guard let iosFeatureConfig = developerSettingsDataController.loadFeatureConfig()?.ios.first,
-              let yirConfig = iosFeatureConfig.yir(yearID: targetConfigYearID) else {
-            return
-        }
-        
-        guard let dataPopulationStartDate = yirConfig.dataPopulationStartDate,
-              let dataPopulationEndDate = yirConfig.dataPopulationEndDate else {
-            return
-        }
-        
-        let donateHistory = WMFDonateDataController.shared.loadLocalDonationHistory(startDate: dataPopulationStartDate, endDate: dataPopulationEndDate)
-        let donateCount = donateHistory?.count ?? 0
-        
-        guard let slides = report.slides as? Set<CDYearInReviewSlide> else {
-            return
-        }
-        
-        for slide in slides {
-            
-            guard let slideID = slide.id else {
-                continue
-            }
-            
-            switch slideID {
             case WMFYearInReviewPersonalizedSlideID.donateCount.rawValue:
-                let encoder = JSONEncoder()
+                guard let donateCount = slideData.donateCount else {
+                    continue
+                }
+                
                 slide.data = try encoder.encode(donateCount)
                 
                 if donateCount > 0 {
                     slide.display = true
                 }
                 
+                slide.evaluated = true
+            case WMFYearInReviewPersonalizedSlideID.mostReadDay.rawValue:
+                guard let mostReadDay = slideData.mostReadDay else {
+                    continue
+                }
+                
+                slide.data = try encoder.encode(mostReadDay)
+                
+                if mostReadDay.viewCount > 0 {
+                    slide.display = true
+                }
+                
                 slide.evaluated = true
             default:
                 break
@@ -22,6 +22,7 @@ public final class WMFDataEnvironment: ObservableObject {
     
     public var userAgentUtility: (() -> String)?
     public var appInstallIDUtility: (() -> String?)?
+    public var usernameUtility: (() -> String?)?
     public var acceptLanguageUtility: (() -> String)?
     
     public internal(set) var userDefaultsStore: WMFKeyValueStore? = WMFUserDefaultsStore()
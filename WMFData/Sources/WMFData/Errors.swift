@@ -19,6 +19,8 @@ public enum WMFServiceError: Error, Equatable {
     case missingData
     case invalidResponseVersion
     case unexpectedResponse
+    case unexpectedContentType(String?)
+    case responseTooLarge(Int)
 }
 
 public enum WMFUserDefaultsStoreError: Error {
@@ -27,6 +29,13 @@ public enum WMFUserDefaultsStoreError: Error {
     case failureEncodingJSON(Error)
 }
 
+public enum WMFLogStructuredKeyValueStoreError: Error {
+    case missingKey
+    case failureOpeningFile
+    case failureEncodingJSON(Error)
+    case failureDecodingJSON(Error)
+}
+
 enum WMFCoreDataStoreError: Error {
     case setupMissingAppContainerURL
     case setupMissingDataModelFileURL
@@ -2,18 +2,146 @@ import Foundation
 
 public protocol WMFURLSession {
     func wmfDataTask(with request: URLRequest, completionHandler: @escaping @Sendable (Data?, URLResponse?, Error?) -> Void) -> WMFURLSessionDataTask
+    
+    /// A data task that checks the response with `validateResponse` as soon as its headers arrive, and fails once the body exceeds `maximumResponseSize` bytes, instead of after the whole body is buffered.
+    func wmfDataTask(with request: URLRequest, maximumResponseSize: Int?, validateResponse: @escaping @Sendable (URLResponse) -> Error?, completionHandler: @escaping @Sendable (Data?, URLResponse?, Error?) -> Void) -> WMFURLSessionDataTask
 }
 
 public protocol WMFURLSessionDataTask {
     func resume()
 }
 
+public extension WMFURLSession {
+    
+    /// Validates after the whole response is received, for sessions that can't stream
+    func wmfDataTask(with request: URLRequest, maximumResponseSize: Int?, validateResponse: @escaping @Sendable (URLResponse) -> Error?, completionHandler: @escaping @Sendable (Data?, URLResponse?, Error?) -> Void) -> WMFURLSessionDataTask {
+        return wmfDataTask(with: request) { data, response, error in
+            if let error {
+                completionHandler(nil, response, error)
+                return
+            }
+            
+            guard let response else {
+                completionHandler(nil, nil, WMFServiceError.invalidHttpResponse(nil))
+                return
+            }
+            
+            if let validationError = validateResponse(response) {
+                completionHandler(nil, response, validationError)
+                return
+            }
+            
+            if let maximumResponseSize,
+               let data,
+               data.count > maximumResponseSize {
+                completionHandler(nil, response, WMFServiceError.responseTooLarge(maximumResponseSize))
+                return
+            }
+            
+            completionHandler(data, response, nil)
+        }
+    }
+}
+
 extension URLSession: WMFURLSession {
     public func wmfDataTask(with request: URLRequest, completionHandler: @escaping @Sendable (Data?, URLResponse?, Error?) -> Void) -> WMFURLSessionDataTask {
         return self.dataTask(with: request, completionHandler: completionHandler)
     }
+    
+    public func wmfDataTask(with request: URLRequest, maximumResponseSize: Int?, validateResponse: @escaping @Sendable (URLResponse) -> Error?, completionHandler: @escaping @Sendable (Data?, URLResponse?, Error?) -> Void) -> WMFURLSessionDataTask {
+        let task = self.dataTask(with: request)
+        task.delegate = WMFStreamingDataTaskDelegate(buffer: WMFResponseBuffer(maximumResponseSize: maximumResponseSize, validateResponse: validateResponse), completionHandler: completionHandler)
+        return task
+    }
 }
 
 extension URLSessionDataTask: WMFURLSessionDataTask {
 
 }
+
+/// Collects a response body as it streams in. The buffer is sized from the expected content length up front, so large bodies aren't copied as they grow.
+struct WMFResponseBuffer {
+    let maximumResponseSize: Int?
+    let validateResponse: (URLResponse) -> Error?
+    
+    private(set) var data = Data()
+    private(set) var response: URLResponse?
+    
+    init(maximumResponseSize: Int?, validateResponse: @escaping (URLResponse) -> Error?) {
+        self.maximumResponseSize = maximumResponseSize
+        self.validateResponse = validateResponse
+    }
+    
+    mutating func receive(_ response: URLResponse) throws {
+        self.response = response
+        
+        if let error = validateResponse(response) {
+            throw error
+        }
+        
+        let expectedContentLength = response.expectedContentLength
+        if let maximumResponseSize,
+           expectedContentLength > maximumResponseSize {
+            throw WMFServiceError.responseTooLarge(maximumResponseSize)
+        }
+        
+        if expectedContentLength > 0 {
+            data.reserveCapacity(Int(expectedContentLength))
+        }
+    }
+    
+    mutating func append(_ chunk: Data) throws {
+        if let maximumResponseSize,
+           data.count + chunk.count > maximumResponseSize {
+            data = Data()
+            throw WMFServiceError.responseTooLarge(maximumResponseSize)
+        }
+        
+        data.append(chunk)
+    }
+}
+
+private final class WMFStreamingDataTaskDelegate: NSObject, URLSessionDataDelegate {
+    
+    private var buffer: WMFResponseBuffer
+    private var error: Error?
+    private let completionHandler: @Sendable (Data?, URLResponse?, Error?) -> Void
+    
+    init(buffer: WMFResponseBuffer, completionHandler: @escaping @Sendable (Data?, URLResponse?, Error?) -> Void) {
+        self.buffer = buffer
+        self.completionHandler = completionHandler
+    }
+    
+    func urlSession(_ session: URLSession, dataTask: URLSessionDataTask, didReceive response: URLResponse, completionHandler: @escaping (URLSession.ResponseDisposition) -> Void) {
+        do {
+            try buffer.receive(response)
+            completionHandler(.allow)
+        } catch let error {
+            self.error = error
+            completionHandler(.cancel)
+        }
+    }
+    
+    func urlSession(_ session: URLSession, dataTask: URLSessionDataTask, didReceive data: Data) {
+        guard error == nil else {
+            return
+        }
+        
+        do {
+            try buffer.append(data)
+        } catch let error {
+            self.error = error
+            dataTask.cancel()
+        }
+    }
+    
+    func urlSession(_ session: URLSession, task: URLSessionTask, didCompleteWithError error: Error?) {
+        // Errors from validation take precedence over the cancellation they cause
+        if let validationError = self.error ?? error {
+            completionHandler(nil, buffer.response, validationError)
+            return
+        }
+        
+        completionHandler(buffer.data, buffer.response, nil)
+    }
+}
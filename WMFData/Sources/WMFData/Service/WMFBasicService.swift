@@ -3,10 +3,43 @@ import Foundation
 /// Use this service for the most basic networking service calls. It does not handle authentication.
 public final class WMFBasicService: WMFService {
     
+    /// Retries GET requests after transient failures. Between attempts it waits a random delay up to an exponentially growing cap, so clients that failed together don't retry together.
+    struct RetryPolicy {
+        let maximumAttempts: Int
+        let baseDelay: TimeInterval
+        let maximumDelay: TimeInterval
+        
+        static let `default` = RetryPolicy(maximumAttempts: 3, baseDelay: 0.5, maximumDelay: 8)
+        
+        func delay(afterAttempt attempt: Int) -> TimeInterval {
+            let cap = min(maximumDelay, baseDelay * pow(2, Double(attempt - 1)))
+            return cap > 0 ? TimeInterval.random(in: 0...cap) : 0
+        }
+        
+        func shouldRetry(error: Error) -> Bool {
+            switch error {
+            case WMFServiceError.invalidHttpResponse(let statusCode?):
+                return [408, 429, 502, 503, 504].contains(statusCode)
+            case let urlError as URLError:
+                return [.timedOut, .networkConnectionLost, .cannotConnectToHost, .cannotFindHost, .dnsLookupFailed].contains(urlError.code)
+            default:
+                return false
+            }
+        }
+    }
+    
+    /// Maximum bytes buffered for a JSON response when its request doesn't set a limit
+    static let defaultMaximumJSONResponseSize = 25 * 1024 * 1024
+    
     private let urlSession: WMFURLSession
+    private let retryPolicy: RetryPolicy
     
-    init(urlSession: WMFURLSession = URLSession.shared) {
+    // Reused for every decodable request
+    private let decoder = JSONDecoder()
+    
+    init(urlSession: WMFURLSession = URLSession.shared, retryPolicy: RetryPolicy = .default) {
         self.urlSession = urlSession
+        self.retryPolicy = retryPolicy
     }
     
     public func perform<R: WMFServiceRequest>(request: R, completion: @escaping (Result<Data, Error>) -> Void) {
@@ -106,31 +139,7 @@ public final class WMFBasicService: WMFService {
             }
         }
         
-        let task = urlSession.wmfDataTask(with: urlRequest) { data, response, error in
-            
-            if let error {
-                completion(nil, nil, error)
-                return
-            }
-
-            guard let httpResponse = response as? HTTPURLResponse else {
-                completion(nil, nil, WMFServiceError.invalidHttpResponse(nil))
-                return
-            }
-            
-            guard httpResponse.isSuccessStatusCode else {
-                completion(nil, nil, WMFServiceError.invalidHttpResponse(httpResponse.statusCode))
-                return
-            }
-            
-            guard let data = data else {
-                completion(nil, nil, WMFServiceError.missingData)
-                return
-            }
-            
-            completion(data, response, error)
-        }
-        task.resume()
+        performDataTask(urlRequest: urlRequest, request: basicRequest, completion: completion)
     }
     
     private func performGET<R: WMFServiceRequest>(request: R, completion: @escaping (Data?, URLResponse?, Error?) -> Void) {
@@ -167,33 +176,65 @@ public final class WMFBasicService: WMFService {
         urlRequest.httpMethod = request.method.rawValue
         urlRequest.populateCommonHeaders(request: basicRequest)
         
-        let task = urlSession.wmfDataTask(with: urlRequest) { data, response, error in
+        performDataTask(urlRequest: urlRequest, request: basicRequest, completion: completion)
+    }
+    
+    /// Runs the data task, retrying GET requests after transient failures
+    private func performDataTask(urlRequest: URLRequest, request: WMFBasicServiceRequest, attempt: Int = 1, completion: @escaping (Data?, URLResponse?, Error?) -> Void) {
+        
+        let maximumResponseSize = request.maximumResponseSize ?? (request.acceptType == .json ? Self.defaultMaximumJSONResponseSize : nil)
+        let acceptType = request.acceptType
+        
+        let task = urlSession.wmfDataTask(with: urlRequest, maximumResponseSize: maximumResponseSize, validateResponse: { response in
+            return Self.validate(response: response, acceptType: acceptType)
+        }) { [retryPolicy] data, response, error in
             
             if let error {
+                
+                if request.method == .GET,
+                   attempt < retryPolicy.maximumAttempts,
+                   retryPolicy.shouldRetry(error: error) {
+                    DispatchQueue.global(qos: .utility).asyncAfter(deadline: .now() + retryPolicy.delay(afterAttempt: attempt)) {
+                        self.performDataTask(urlRequest: urlRequest, request: request, attempt: attempt + 1, completion: completion)
+                    }
+                    return
+                }
+                
                 completion(nil, nil, error)
                 return
             }
-
-            guard let httpResponse = response as? HTTPURLResponse else {
-                completion(nil, nil, WMFServiceError.invalidHttpResponse(nil))
-                return
-            }
-            
-            guard httpResponse.isSuccessStatusCode else {
-                completion(nil, nil, WMFServiceError.invalidHttpResponse(httpResponse.statusCode))
-                return
-            }
             
             guard let data = data else {
                 completion(nil, nil, WMFServiceError.missingData)
                 return
             }
             
-            completion(data, response, error)
+            completion(data, response, nil)
         }
         task.resume()
     }
     
+    /// Checked when the response headers arrive, before the body is buffered
+    private static func validate(response: URLResponse, acceptType: WMFBasicServiceRequest.AcceptType) -> Error? {
+        
+        guard let httpResponse = response as? HTTPURLResponse else {
+            return WMFServiceError.invalidHttpResponse(nil)
+        }
+        
+        guard httpResponse.isSuccessStatusCode else {
+            return WMFServiceError.invalidHttpResponse(httpResponse.statusCode)
+        }
+        
+        // Raw wiki pages holding JSON can be served as text/x-wiki, so only reject types that are never JSON, like error and captive portal pages
+        if acceptType == .json,
+           let mimeType = httpResponse.mimeType?.lowercased(),
+           mimeType == "text/html" || mimeType.hasPrefix("image/") || mimeType.hasPrefix("audio/") || mimeType.hasPrefix("video/") {
+            return WMFServiceError.unexpectedContentType(mimeType)
+        }
+        
+        return nil
+    }
+    
     public func performDecodableGET<R: WMFServiceRequest, T: Decodable>(request: R, completion: @escaping (Result<T, Error>) -> Void) {
         
         performGET(request: request) { data, response, error in
@@ -209,8 +250,7 @@ public final class WMFBasicService: WMFService {
             }
             
             do {
-                let decoder = JSONDecoder()
-                let result: T = try decoder.decode(T.self, from: data)
+                let result: T = try self.decoder.decode(T.self, from: data)
                 completion(.success(result))
             } catch let error {
                 completion(.failure(error))
@@ -233,8 +273,7 @@ public final class WMFBasicService: WMFService {
             }
             
             do {
-                let decoder = JSONDecoder()
-                let result: T = try decoder.decode(T.self, from: data)
+                let result: T = try self.decoder.decode(T.self, from: data)
                 completion(.success(result))
             } catch let error {
                 completion(.failure(error))
@@ -18,13 +18,16 @@ public struct WMFBasicServiceRequest: WMFServiceRequest {
     public let parameters: [String: Any]?
     public var contentType: ContentType?
     public var acceptType: AcceptType
+    /// Maximum bytes of response body to buffer. When nil, JSON responses use the service's default limit and other responses aren't limited.
+    public var maximumResponseSize: Int?
 
-    internal init(url: URL? = nil, method: WMFServiceRequestMethod, languageVariantCode: String? = nil, parameters: [String : Any]? = nil, contentType: ContentType? = nil, acceptType: AcceptType) {
+    internal init(url: URL? = nil, method: WMFServiceRequestMethod, languageVariantCode: String? = nil, parameters: [String : Any]? = nil, contentType: ContentType? = nil, acceptType: AcceptType, maximumResponseSize: Int? = nil) {
         self.url = url
         self.method = method
         self.languageVariantCode = languageVariantCode
         self.parameters = parameters
         self.contentType = contentType
         self.acceptType = acceptType
+        self.maximumResponseSize = maximumResponseSize
     }
 }
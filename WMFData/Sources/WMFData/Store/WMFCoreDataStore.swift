@@ -137,6 +137,28 @@ public final class WMFCoreDataStore {
         return result
     }
     
+    func fetchGroupedSum<T: NSManagedObject>(entityType: T.Type, predicate: NSPredicate?, propertyToSum: String, propertiesToGroupBy: [String], in moc: NSManagedObjectContext) throws -> [[String: Any]] {
+        
+        let keypathExp = NSExpression(forKeyPath: propertyToSum)
+        let expression = NSExpression(forFunction: "sum:", arguments: [keypathExp])
+
+        let sumDesc = NSExpressionDescription()
+        sumDesc.expression = expression
+        sumDesc.name = "sum"
+        sumDesc.expressionResultType = .integer64AttributeType
+        
+        let entityName = NSStringFromClass(entityType)
+        let fetchRequest = NSFetchRequest<NSFetchRequestResult>(entityName: entityName)
+        fetchRequest.predicate = predicate
+        fetchRequest.propertiesToGroupBy = propertiesToGroupBy
+        fetchRequest.propertiesToFetch = propertiesToGroupBy + [sumDesc]
+        fetchRequest.resultType = .dictionaryResultType
+        guard let result = try moc.fetch(fetchRequest) as? [[String: Any]] else {
+            throw WMFCoreDataStoreError.unexpectedFetchGroupResult
+        }
+        return result
+    }
+    
     func create<T: NSManagedObject>(entityType: T.Type, in moc: NSManagedObjectContext) throws -> T {
         
         let entityName = NSStringFromClass(entityType)
@@ -184,6 +206,14 @@ public final class WMFCoreDataStore {
             batchPageViewDeleteRequest.resultType = .resultTypeObjectIDs
             _ = try backgroundContext.execute(batchPageViewDeleteRequest) as? NSBatchDeleteResult
             
+            // Delete page view rollups for days > one year ago
+            let rollupFetchRequest = NSFetchRequest<NSFetchRequestResult>(entityName: "CDPageViewDailyRollup")
+            rollupFetchRequest.predicate = NSPredicate(format: "day < %@", argumentArray: [oneYearAgoDate])
+            
+            let batchRollupDeleteRequest = NSBatchDeleteRequest(fetchRequest: rollupFetchRequest)
+            batchRollupDeleteRequest.resultType = .resultTypeObjectIDs
+            _ = try backgroundContext.execute(batchRollupDeleteRequest) as? NSBatchDeleteResult
+            
             // Delete WMFPages that were added > one year ago
             let pageFetchRequest = NSFetchRequest<NSFetchRequestResult>(entityName: "CDPage")
             pageFetchRequest.predicate = predicate
@@ -0,0 +1,452 @@
+import Foundation
+#if canImport(Darwin)
+import Darwin
+#elseif canImport(Glibc)
+import Glibc
+#endif
+
+/// Key-value store backed by a single append-only log file.
+///
+/// Saves append a record with the value's compact JSON and a CRC-32 checksum, and removals append a tombstone. The file is memory mapped and indexed by key, and values are decoded on first load and kept.
+/// Once most of the file is overwritten records, it's compacted in the background by rewriting the live records to a new file.
+/// Writers in other processes, like app extensions, are coordinated with a lock file. Their appends and compactions are picked up before each operation.
+/// The log is only read under a shared lock and only written or replaced under an exclusive one, so it's never truncated while it's being read.
+public final class WMFLogStructuredKeyValueStore: WMFKeyValueStore {
+
+    private enum RecordKind: UInt8 {
+        case value = 1
+        case removal = 2
+    }
+
+    private struct RecordLocation {
+        let recordOffset: Int
+        let recordLength: Int
+        let payloadOffset: Int
+        let payloadLength: Int
+    }
+
+    private static let magic = Data("WMFKVLOG".utf8)
+    private static let version: UInt32 = 1
+    private static let fileHeaderLength = magic.count + 4
+
+    // Kind, key length, payload length, checksum
+    private static let recordHeaderLength = 1 + 4 + 4 + 4
+
+    /// File size below which the log isn't compacted
+    static let compactionThreshold = 64 * 1024
+
+    private static let keySeparator = "\u{1F}"
+
+    private let fileURL: URL
+    private let legacyStore: WMFKeyValueStore?
+    private let queue = DispatchQueue(label: "org.wikimedia.WMFLogStructuredKeyValueStore", qos: .utility)
+    private let lockFileDescriptor: Int32
+
+    private let encoder = JSONEncoder()
+    private let decoder = JSONDecoder()
+
+    // Only accessed on the queue
+    private var index: [String: RecordLocation] = [:]
+    private var decodedValues: [String: Any] = [:]
+    private var mappedData = Data()
+    private var indexedLength = 0
+    private var liveLength = 0
+    private var fileNumber: Int?
+    private var isCompactionScheduled = false
+    /// Keys already looked up in the legacy store, whether or not a value was migrated, so misses aren't looked up again
+    private var checkedLegacyKeys: Set<String> = []
+
+    /// - Parameters:
+    ///   - fileURL: Location of the log. A lock file is kept next to it.
+    ///   - legacyStore: Store to read values from the first time they're loaded, and to remove them from, while migrating to this store
+    public init(fileURL: URL, legacyStore: WMFKeyValueStore? = nil) throws {
+        self.fileURL = fileURL
+        self.legacyStore = legacyStore
+
+        try FileManager.default.createDirectory(at: fileURL.deletingLastPathComponent(), withIntermediateDirectories: true)
+
+        let lockFileDescriptor = open(fileURL.appendingPathExtension("lock").path, O_RDWR | O_CREAT, 0o644)
+        guard lockFileDescriptor >= 0 else {
+            throw WMFLogStructuredKeyValueStoreError.failureOpeningFile
+        }
+        self.lockFileDescriptor = lockFileDescriptor
+
+        try queue.sync {
+            try withFileLock {
+                if !FileManager.default.fileExists(atPath: fileURL.path) {
+                    try Self.emptyLog().write(to: fileURL)
+                }
+                try refresh()
+            }
+        }
+    }
+
+    deinit {
+        close(lockFileDescriptor)
+    }
+
+    // MARK: - WMFKeyValueStore
+
+    public func load<T: Codable>(key: String...) throws -> T? {
+        let key = try storeKey(key)
+
+        let value: T? = try queue.sync {
+            try refreshWithSharedLock()
+
+            guard let location = index[key] else {
+                return nil
+            }
+
+            if let decodedValue = decodedValues[key] as? T {
+                return decodedValue
+            }
+
+            let payload = try withFileLock(shared: true) {
+                try payload(at: location)
+            }
+            do {
+                let decodedValue = try decoder.decode(T.self, from: payload)
+                decodedValues[key] = decodedValue
+                return decodedValue
+            } catch let error {
+                throw WMFLogStructuredKeyValueStoreError.failureDecodingJSON(error)
+            }
+        }
+
+        if let value {
+            return value
+        }
+
+        return try migratedValue(key: key)
+    }
+
+    public func save<T: Codable>(key: String..., value: T) throws {
+        let key = try storeKey(key)
+
+        let payload: Data
+        do {
+            payload = try encoder.encode(value)
+        } catch let error {
+            throw WMFLogStructuredKeyValueStoreError.failureEncodingJSON(error)
+        }
+
+        try queue.sync {
+            try append(kind: .value, key: key, payload: payload)
+            decodedValues[key] = value
+        }
+    }
+
+    public func remove(key: String...) throws {
+        let keyComponents = key
+        let key = try storeKey(key)
+
+        try queue.sync {
+            try append(kind: .removal, key: key, payload: Data())
+        }
+
+        try removeLegacyValue(keyComponents: keyComponents)
+        queue.sync {
+            _ = checkedLegacyKeys.insert(key)
+        }
+    }
+
+    // MARK: - Migration
+
+    private func migratedValue<T: Codable>(key: String) throws -> T? {
+        guard let legacyStore,
+              !queue.sync(execute: { checkedLegacyKeys.contains(key) }) else {
+            return nil
+        }
+
+        let keyComponents = key.components(separatedBy: Self.keySeparator)
+        let value: T? = try? legacyStore.load(keyComponents: keyComponents)
+
+        try queue.sync {
+            checkedLegacyKeys.insert(key)
+
+            // Another caller may have saved a newer value meanwhile
+            guard let value,
+                  index[key] == nil else {
+                return
+            }
+            try append(kind: .value, key: key, payload: encoder.encode(value))
+            decodedValues[key] = value
+        }
+        return value
+    }
+
+    private func removeLegacyValue(keyComponents: [String]) throws {
+        try legacyStore?.remove(keyComponents: keyComponents)
+    }
+
+    // MARK: - Log
+
+    private func storeKey(_ components: [String]) throws -> String {
+        guard !components.isEmpty else {
+            throw WMFLogStructuredKeyValueStoreError.missingKey
+        }
+        return components.joined(separator: Self.keySeparator)
+    }
+
+    private static func emptyLog() -> Data {
+        var data = magic
+        appendInteger(version, to: &data)
+        return data
+    }
+
+    private static func appendInteger(_ value: UInt32, to data: inout Data) {
+        withUnsafeBytes(of: value.littleEndian) { data.append(contentsOf: $0) }
+    }
+
+    private static func readInteger(in data: Data, at offset: Int) -> UInt32 {
+        return data.withUnsafeBytes { bytes in
+            UInt32(littleEndian: bytes.loadUnaligned(fromByteOffset: offset - data.startIndex, as: UInt32.self))
+        }
+    }
+
+    private func withFileLock<T>(shared: Bool = false, _ body: () throws -> T) rethrows -> T {
+        flock(lockFileDescriptor, shared ? LOCK_SH : LOCK_EX)
+        defer { flock(lockFileDescriptor, LOCK_UN) }
+        return try body()
+    }
+
+    private func payload(at location: RecordLocation) throws -> Data {
+        if location.payloadOffset + location.payloadLength > mappedData.count {
+            mappedData = try Data(contentsOf: fileURL, options: .alwaysMapped)
+        }
+        return mappedData.subdata(in: location.payloadOffset..<location.payloadOffset + location.payloadLength)
+    }
+
+    /// Refreshes under a shared lock, taking the exclusive lock only if the log is unreadable and has to be replaced
+    private func refreshWithSharedLock() throws {
+        let isReadable = try withFileLock(shared: true) {
+            try refresh(replacesUnreadableLog: false)
+        }
+        if !isReadable {
+            try withFileLock {
+                _ = try refresh()
+            }
+        }
+    }
+
+    /// Indexes records appended or compacted by other stores since the last refresh. Must be called with the file locked, exclusively if `replacesUnreadableLog` is true.
+    /// - Returns: False if the log is unreadable and wasn't replaced
+    @discardableResult
+    private func refresh(replacesUnreadableLog: Bool = true) throws -> Bool {
+        let attributes = try FileManager.default.attributesOfItem(atPath: fileURL.path)
+        let currentFileNumber = (attributes[.systemFileNumber] as? NSNumber)?.intValue
+        let size = (attributes[.size] as? NSNumber)?.intValue ?? 0
+
+        if currentFileNumber != fileNumber || size < indexedLength {
+            // Replaced by a compaction, start over
+            index.removeAll()
+            decodedValues.removeAll()
+            indexedLength = 0
+            liveLength = 0
+            fileNumber = currentFileNumber
+        } else if size == indexedLength {
+            return true
+        }
+
+        mappedData = try Data(contentsOf: fileURL, options: .alwaysMapped)
+
+        if indexedLength == 0 {
+            guard mappedData.count >= Self.fileHeaderLength,
+                  mappedData.prefix(Self.magic.count) == Self.magic,
+                  Self.readInteger(in: mappedData, at: Self.magic.count) == Self.version else {
+                // Start over next time, under the exclusive lock
+                fileNumber = nil
+                guard replacesUnreadableLog else {
+                    return false
+                }
+
+                // Unreadable, it's a cache so start a new log
+                try Self.emptyLog().write(to: fileURL, options: .atomic)
+                indexedLength = 0
+                return try refresh()
+            }
+            indexedLength = Self.fileHeaderLength
+        }
+
+        scanRecords()
+        return true
+    }
+
+    /// Indexes complete records after `indexedLength`. Scanning stops at a record that's truncated or fails its checksum, such as one another process is still writing.
+    private func scanRecords() {
+        let data = mappedData
+        var offset = indexedLength
+
+        while offset + Self.recordHeaderLength <= data.count {
+            guard let kind = RecordKind(rawValue: data[offset]) else {
+                break
+            }
+
+            let keyLength = Int(Self.readInteger(in: data, at: offset + 1))
+            let payloadLength = Int(Self.readInteger(in: data, at: offset + 5))
+            let checksum = Self.readInteger(in: data, at: offset + 9)
+            let keyOffset = offset + Self.recordHeaderLength
+            let payloadOffset = keyOffset + keyLength
+            let recordLength = Self.recordHeaderLength + keyLength + payloadLength
+
+            guard offset + recordLength <= data.count,
+                  WMFCRC32.checksum(data[offset..<offset + 1], data[keyOffset..<payloadOffset + payloadLength]) == checksum,
+                  let key = String(data: data[keyOffset..<payloadOffset], encoding: .utf8) else {
+                break
+            }
+
+            indexRecord(kind: kind, key: key, location: RecordLocation(recordOffset: offset, recordLength: recordLength, payloadOffset: payloadOffset, payloadLength: payloadLength))
+            offset += recordLength
+        }
+
+        indexedLength = offset
+    }
+
+    private func indexRecord(kind: RecordKind, key: String, location: RecordLocation) {
+        if let previousLocation = index[key] {
+            liveLength -= previousLocation.recordLength
+        }
+        decodedValues[key] = nil
+
+        switch kind {
+        case .value:
+            index[key] = location
+            liveLength += location.recordLength
+        case .removal:
+            index[key] = nil
+        }
+    }
+
+    private func append(kind: RecordKind, key: String, payload: Data) throws {
+        try withFileLock {
+            try refresh()
+
+            let keyData = Data(key.utf8)
+            var record = Data(capacity: Self.recordHeaderLength + keyData.count + payload.count)
+            record.append(kind.rawValue)
+            Self.appendInteger(UInt32(keyData.count), to: &record)
+            Self.appendInteger(UInt32(payload.count), to: &record)
+            Self.appendInteger(WMFCRC32.checksum(Data([kind.rawValue]), keyData + payload), to: &record)
+            record.append(keyData)
+            record.append(payload)
+
+            let fileHandle = try FileHandle(forWritingTo: fileURL)
+            defer { try? fileHandle.close() }
+
+            // Drop a partial record left by a writer that didn't finish
+            try fileHandle.truncate(atOffset: UInt64(indexedLength))
+            try fileHandle.seek(toOffset: UInt64(indexedLength))
+            try fileHandle.write(contentsOf: record)
+
+            let payloadOffset = indexedLength + Self.recordHeaderLength + keyData.count
+            indexRecord(kind: kind, key: key, location: RecordLocation(recordOffset: indexedLength, recordLength: record.count, payloadOffset: payloadOffset, payloadLength: payload.count))
+            indexedLength += record.count
+        }
+
+        scheduleCompactionIfNeeded()
+    }
+
+    // MARK: - Compaction
+
+    private func scheduleCompactionIfNeeded() {
+        guard !isCompactionScheduled,
+              indexedLength > Self.compactionThreshold,
+              liveLength < indexedLength / 2 else {
+            return
+        }
+
+        isCompactionScheduled = true
+        queue.async {
+            self.isCompactionScheduled = false
+            try? self.compact()
+        }
+    }
+
+    /// Rewrites the live records to a new file and moves it into place
+    func compact() throws {
+        dispatchPrecondition(condition: .onQueue(queue))
+
+        try withFileLock {
+            try refresh()
+
+            if mappedData.count < indexedLength {
+                mappedData = try Data(contentsOf: fileURL, options: .alwaysMapped)
+            }
+
+            var compactedData = Self.emptyLog()
+            compactedData.reserveCapacity(Self.fileHeaderLength + liveLength)
+            for location in index.values.sorted(by: { $0.recordOffset < $1.recordOffset }) {
+                compactedData.append(mappedData[location.recordOffset..<location.recordOffset + location.recordLength])
+            }
+
+            let temporaryURL = fileURL.appendingPathExtension("compacting")
+            try compactedData.write(to: temporaryURL)
+            guard rename(temporaryURL.path, fileURL.path) == 0 else {
+                try? FileManager.default.removeItem(at: temporaryURL)
+                return
+            }
+
+            // Values already decoded stay valid, only their locations change
+            let decodedValues = self.decodedValues
+            fileNumber = nil
+            try refresh()
+            self.decodedValues = decodedValues.filter { index[$0.key] != nil }
+        }
+    }
+
+    /// Compacts right away, for tests
+    func compactNow() throws {
+        try queue.sync {
+            try compact()
+        }
+    }
+
+    var fileLength: Int {
+        return queue.sync { indexedLength }
+    }
+}
+
+private extension WMFKeyValueStore {
+    func load<T: Codable>(keyComponents: [String]) throws -> T? {
+        switch keyComponents.count {
+        case 1:
+            return try load(key: keyComponents[0])
+        case 2:
+            return try load(key: keyComponents[0], keyComponents[1])
+        default:
+            return nil
+        }
+    }
+
+    func remove(keyComponents: [String]) throws {
+        switch keyComponents.count {
+        case 1:
+            try remove(key: keyComponents[0])
+        case 2:
+            try remove(key: keyComponents[0], keyComponents[1])
+        default:
+            break
+        }
+    }
+}
+
+/// CRC-32 as used by zip and PNG
+enum WMFCRC32 {
+    private static let table: [UInt32] = (0..<256).map { index in
+        var value = UInt32(index)
+        for _ in 0..<8 {
+            value = value & 1 == 1 ? 0xEDB88320 ^ (value >> 1) : value >> 1
+        }
+        return value
+    }
+
+    static func checksum(_ parts: Data...) -> UInt32 {
+        var crc: UInt32 = 0xFFFFFFFF
+        for part in parts {
+            for byte in part {
+                crc = table[Int((crc ^ UInt32(byte)) & 0xFF)] ^ (crc >> 8)
+            }
+        }
+        return crc ^ 0xFFFFFFFF
+    }
+}
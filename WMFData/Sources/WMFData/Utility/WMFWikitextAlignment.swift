@@ -0,0 +1,606 @@
+import Foundation
+
+/// Text with wikitext markup stripped, normalized for matching against text selected in rendered HTML.
+///
+/// Letters are lowercased and runs of whitespace and punctuation collapse into a single space, so rendered text and wikitext compare equal
+/// wherever the markup between words differs. Each unit keeps the UTF-16 range of the source text it came from.
+struct WMFWikitextPlainText {
+
+    static let separator: UInt16 = 0x20
+
+    private(set) var units: [UInt16] = []
+    private(set) var sourceStarts: [Int] = []
+    private(set) var sourceEnds: [Int] = []
+
+    var count: Int {
+        return units.count
+    }
+
+    /// Strips wikitext markup in a single pass: comments, templates, refs and other tags are dropped, links keep only their labels,
+    /// bold and italic quotes are dropped and character references are decoded.
+    init(wikitext: String) {
+        let source = Array(wikitext.utf16)
+        var index = 0
+        var openExternalLinkCount = 0
+
+        reserveCapacity(source.count)
+
+        while index < source.count {
+            let unit = source[index]
+            switch unit {
+            case Self.lessThan:
+                if let end = Self.endOfComment(in: source, at: index) ?? Self.endOfRef(in: source, at: index) ?? Self.endOfTag(in: source, at: index) {
+                    index = end
+                    continue
+                }
+            case Self.openBrace:
+                if let end = Self.endOfTemplate(in: source, at: index) {
+                    index = end
+                    continue
+                }
+            case Self.openBracket:
+                if let end = Self.endOfLinkTarget(in: source, at: index) {
+                    index = end
+                    continue
+                }
+                if let end = Self.endOfExternalLinkTarget(in: source, at: index) {
+                    openExternalLinkCount += 1
+                    index = end
+                    continue
+                }
+            case Self.closeBracket:
+                if Self.hasPrefix(Self.closeLink, in: source, at: index) {
+                    index += Self.closeLink.count
+                    continue
+                }
+                if openExternalLinkCount > 0 {
+                    openExternalLinkCount -= 1
+                    index += 1
+                    continue
+                }
+            case Self.apostrophe:
+                var end = index
+                while end < source.count && source[end] == Self.apostrophe {
+                    end += 1
+                }
+                if end - index >= 2 {
+                    index = end
+                    continue
+                }
+            case Self.ampersand:
+                if let reference = Self.characterReference(in: source, at: index) {
+                    for decodedUnit in reference.decoded {
+                        append(decodedUnit, sourceStart: index, sourceEnd: reference.end)
+                    }
+                    index = reference.end
+                    continue
+                }
+            default:
+                break
+            }
+
+            append(unit, sourceStart: index, sourceEnd: index + 1)
+            index += 1
+        }
+    }
+
+    /// Normalizes rendered text the same way, dropping footnote markers like `[1]`
+    init(renderedText: String) {
+        let source = Array(renderedText.utf16)
+        var index = 0
+
+        reserveCapacity(source.count)
+
+        while index < source.count {
+            if source[index] == Self.openBracket, let end = Self.endOfFootnoteMarker(in: source, at: index) {
+                index = end
+                continue
+            }
+            append(source[index], sourceStart: index, sourceEnd: index + 1)
+            index += 1
+        }
+    }
+
+    private mutating func reserveCapacity(_ capacity: Int) {
+        units.reserveCapacity(capacity)
+        sourceStarts.reserveCapacity(capacity)
+        sourceEnds.reserveCapacity(capacity)
+    }
+
+    private mutating func append(_ unit: UInt16, sourceStart: Int, sourceEnd: Int) {
+        guard let normalizedUnit = Self.normalized(unit) else {
+            if units.last == Self.separator {
+                sourceEnds[sourceEnds.count - 1] = sourceEnd
+                return
+            }
+            units.append(Self.separator)
+            sourceStarts.append(sourceStart)
+            sourceEnds.append(sourceEnd)
+            return
+        }
+        units.append(normalizedUnit)
+        sourceStarts.append(sourceStart)
+        sourceEnds.append(sourceEnd)
+    }
+
+    /// Range of `units` without leading and trailing separators
+    var trimmedRange: Range<Int> {
+        var lowerBound = 0
+        var upperBound = units.count
+        while lowerBound < upperBound && units[lowerBound] == Self.separator {
+            lowerBound += 1
+        }
+        while upperBound > lowerBound && units[upperBound - 1] == Self.separator {
+            upperBound -= 1
+        }
+        return lowerBound..<upperBound
+    }
+
+    /// Source range covered by a range of units
+    func sourceRange(of range: Range<Int>) -> NSRange {
+        guard !range.isEmpty else {
+            return NSRange(location: NSNotFound, length: 0)
+        }
+        let location = sourceStarts[range.lowerBound]
+        return NSRange(location: location, length: sourceEnds[range.upperBound - 1] - location)
+    }
+
+    /// Words before or after a position, nearest first
+    func words(before position: Int, count: Int) -> [String] {
+        return words(in: stride(from: position - 1, through: 0, by: -1), count: count).map { String(decoding: $0.reversed(), as: UTF16.self) }
+    }
+
+    func words(after position: Int, count: Int) -> [String] {
+        return words(in: stride(from: position, to: units.count, by: 1), count: count).map { String(decoding: $0, as: UTF16.self) }
+    }
+
+    private func words<S: Sequence>(in positions: S, count: Int) -> [[UInt16]] where S.Element == Int {
+        var words: [[UInt16]] = []
+        var word: [UInt16] = []
+        for position in positions {
+            if units[position] != Self.separator {
+                word.append(units[position])
+                continue
+            }
+            if !word.isEmpty {
+                words.append(word)
+                word = []
+                if words.count == count {
+                    return words
+                }
+            }
+        }
+        if !word.isEmpty && words.count < count {
+            words.append(word)
+        }
+        return words
+    }
+
+    // MARK: - Normalizing
+
+    /// Lowercased unit, or nil for whitespace and punctuation. Surrogates are kept as is so emoji and other astral characters still match.
+    private static func normalized(_ unit: UInt16) -> UInt16? {
+        switch unit {
+        case 0x41...0x5A:
+            return unit + 0x20
+        case 0x61...0x7A, 0x30...0x39:
+            return unit
+        case 0xD800...0xDFFF:
+            return unit
+        default:
+            break
+        }
+
+        guard let scalar = Unicode.Scalar(unit) else {
+            return unit
+        }
+
+        let properties = scalar.properties
+        if properties.isWhitespace {
+            return nil
+        }
+        switch properties.generalCategory {
+        case .connectorPunctuation, .dashPunctuation, .openPunctuation, .closePunctuation, .initialPunctuation, .finalPunctuation, .otherPunctuation, .control:
+            return nil
+        default:
+            break
+        }
+
+        if properties.changesWhenLowercased {
+            let lowercased = Array(properties.lowercaseMapping.utf16)
+            if lowercased.count == 1 {
+                return lowercased[0]
+            }
+        }
+        return unit
+    }
+
+    // MARK: - Markup
+
+    private static let lessThan = UInt16(UInt8(ascii: "<"))
+    private static let greaterThan = UInt16(UInt8(ascii: ">"))
+    private static let slash = UInt16(UInt8(ascii: "/"))
+    private static let openBrace = UInt16(UInt8(ascii: "{"))
+    private static let openBracket = UInt16(UInt8(ascii: "["))
+    private static let closeBracket = UInt16(UInt8(ascii: "]"))
+    private static let pipe = UInt16(UInt8(ascii: "|"))
+    private static let apostrophe = UInt16(UInt8(ascii: "'"))
+    private static let ampersand = UInt16(UInt8(ascii: "&"))
+    private static let semicolon = UInt16(UInt8(ascii: ";"))
+    private static let numberSign = UInt16(UInt8(ascii: "#"))
+    private static let space = UInt16(UInt8(ascii: " "))
+
+    private static let openComment = Array("<!--".utf16)
+    private static let closeComment = Array("-->".utf16)
+    private static let openRef = Array("<ref".utf16)
+    private static let closeRef = Array("</ref>".utf16)
+    private static let openTemplate = Array("{{".utf16)
+    private static let closeTemplate = Array("}}".utf16)
+    private static let openLink = Array("[[".utf16)
+    private static let closeLink = Array("]]".utf16)
+    private static let urlSchemes = ["http://", "https://", "//", "ftp://", "mailto:"].map { Array($0.utf16) }
+
+    private static let namedCharacterReferences: [String: String] = [
+        "nbsp": "\u{00A0}",
+        "amp": "&",
+        "lt": "<",
+        "gt": ">",
+        "quot": "\"",
+        "apos": "'",
+        "ndash": "\u{2013}",
+        "mdash": "\u{2014}",
+        "minus": "\u{2212}",
+        "thinsp": "\u{2009}",
+        "shy": ""
+    ]
+
+    private static func hasPrefix(_ prefix: [UInt16], in source: [UInt16], at index: Int, caseInsensitive: Bool = false) -> Bool {
+        guard index + prefix.count <= source.count else {
+            return false
+        }
+        for offset in 0..<prefix.count {
+            var unit = source[index + offset]
+            if caseInsensitive && unit >= 0x41 && unit <= 0x5A {
+                unit += 0x20
+            }
+            if unit != prefix[offset] {
+                return false
+            }
+        }
+        return true
+    }
+
+    private static func firstIndex(of target: [UInt16], in source: [UInt16], from index: Int, caseInsensitive: Bool = false) -> Int? {
+        var index = index
+        while index + target.count <= source.count {
+            if hasPrefix(target, in: source, at: index, caseInsensitive: caseInsensitive) {
+                return index
+            }
+            index += 1
+        }
+        return nil
+    }
+
+    private static func isASCIILetter(_ unit: UInt16) -> Bool {
+        return (0x41...0x5A).contains(unit) || (0x61...0x7A).contains(unit)
+    }
+
+    private static func endOfComment(in source: [UInt16], at index: Int) -> Int? {
+        guard hasPrefix(openComment, in: source, at: index) else {
+            return nil
+        }
+        // An unclosed comment hides the rest of the page
+        guard let closeIndex = firstIndex(of: closeComment, in: source, from: index + openComment.count) else {
+            return source.count
+        }
+        return closeIndex + closeComment.count
+    }
+
+    /// Skips a ref and its contents, which render as a footnote marker
+    private static func endOfRef(in source: [UInt16], at index: Int) -> Int? {
+        guard hasPrefix(openRef, in: source, at: index, caseInsensitive: true) else {
+            return nil
+        }
+        let nameEnd = index + openRef.count
+        guard nameEnd < source.count,
+              source[nameEnd] == greaterThan || source[nameEnd] == slash || source[nameEnd] == space,
+              let openTagEnd = firstIndex(of: [greaterThan], in: source, from: nameEnd) else {
+            return nil
+        }
+        if source[openTagEnd - 1] == slash {
+            return openTagEnd + 1
+        }
+        guard let closeIndex = firstIndex(of: closeRef, in: source, from: openTagEnd + 1, caseInsensitive: true) else {
+            return nil
+        }
+        return closeIndex + closeRef.count
+    }
+
+    /// Skips an HTML tag, keeping its contents
+    private static func endOfTag(in source: [UInt16], at index: Int) -> Int? {
+        var nameStart = index + 1
+        if nameStart < source.count && source[nameStart] == slash {
+            nameStart += 1
+        }
+        guard nameStart < source.count, isASCIILetter(source[nameStart]) else {
+            return nil
+        }
+        var end = nameStart
+        while end < source.count && source[end] != greaterThan {
+            // Not a tag if another one starts before this one ends
+            if source[end] == lessThan || source[end] == 0x0A {
+                return nil
+            }
+            end += 1
+        }
+        return end < source.count ? end + 1 : nil
+    }
+
+    /// Skips a template including nested templates. Unclosed braces are left as text.
+    private static func endOfTemplate(in source: [UInt16], at index: Int) -> Int? {
+        guard hasPrefix(openTemplate, in: source, at: index) else {
+            return nil
+        }
+        var depth = 0
+        var end = index
+        while end < source.count {
+            if hasPrefix(openTemplate, in: source, at: end) {
+                depth += 1
+                end += openTemplate.count
+            } else if hasPrefix(closeTemplate, in: source, at: end) {
+                depth -= 1
+                end += closeTemplate.count
+                if depth == 0 {
+                    return end
+                }
+            } else {
+                end += 1
+            }
+        }
+        return nil
+    }
+
+    /// Skips the opening brackets of an internal link, and its target when it has a label. The label is kept, and the closing brackets are skipped on their own.
+    private static func endOfLinkTarget(in source: [UInt16], at index: Int) -> Int? {
+        guard hasPrefix(openLink, in: source, at: index) else {
+            return nil
+        }
+        var end = index + openLink.count
+        while end < source.count {
+            if source[end] == pipe {
+                return end + 1
+            }
+            if hasPrefix(openLink, in: source, at: end) || hasPrefix(closeLink, in: source, at: end) || source[end] == 0x0A {
+                break
+            }
+            end += 1
+        }
+        return index + openLink.count
+    }
+
+    /// Skips the opening bracket and URL of a labeled external link
+    private static func endOfExternalLinkTarget(in source: [UInt16], at index: Int) -> Int? {
+        guard urlSchemes.contains(where: { hasPrefix($0, in: source, at: index + 1, caseInsensitive: true) }) else {
+            return nil
+        }
+        var end = index + 1
+        while end < source.count && source[end] != space && source[end] != closeBracket && source[end] != 0x0A {
+            end += 1
+        }
+        guard end < source.count, source[end] != 0x0A else {
+            return nil
+        }
+        return source[end] == space ? end + 1 : end
+    }
+
+    private static func characterReference(in source: [UInt16], at index: Int) -> (decoded: [UInt16], end: Int)? {
+        var end = index + 1
+        while end < source.count && end - index <= 10 && source[end] != semicolon {
+            end += 1
+        }
+        guard end < source.count, source[end] == semicolon, end > index + 1 else {
+            return nil
+        }
+        let name = String(decoding: source[(index + 1)..<end], as: UTF16.self)
+        if name.utf16.first == numberSign {
+            let digits = name.dropFirst()
+            let value = digits.lowercased().hasPrefix("x") ? UInt32(digits.dropFirst(), radix: 16) : UInt32(digits, radix: 10)
+            guard let value, let scalar = Unicode.Scalar(value) else {
+                return nil
+            }
+            return (Array(String(Character(scalar)).utf16), end + 1)
+        }
+        guard let decoded = namedCharacterReferences[name] else {
+            return nil
+        }
+        return (Array(decoded.utf16), end + 1)
+    }
+
+    /// Footnote markers like `[1]` or `[a]` that render in place of refs and notes
+    private static func endOfFootnoteMarker(in source: [UInt16], at index: Int) -> Int? {
+        var end = index + 1
+        while end < source.count && end - index <= 4 && (0x30...0x39).contains(source[end]) {
+            end += 1
+        }
+        if end == index + 1 && end < source.count && isASCIILetter(source[end]) {
+            end += 1
+        }
+        guard end > index + 1, end < source.count, source[end] == closeBracket else {
+            return nil
+        }
+        return end + 1
+    }
+}
+
+/// Finds rendered text within wikitext stripped of markup
+///
+/// Disjoint n-grams of the target anchor candidate positions. If the target and the wikitext differ by at most `maxErrors` edits,
+/// at least one of `maxErrors + 1` disjoint n-grams appears unchanged, so every acceptable match has an anchor.
+/// Each candidate is then verified with an edit distance limited to a band `maxErrors` wide.
+struct WMFWikitextAligner {
+
+    struct Match {
+        let range: Range<Int>
+        let distance: Int
+    }
+
+    private static let maxAnchorLength = 8
+
+    let text: WMFWikitextPlainText
+
+    init(text: WMFWikitextPlainText) {
+        self.text = text
+    }
+
+    func matches(of target: ArraySlice<UInt16>) -> [Match] {
+        let target = Array(target)
+        guard !target.isEmpty, !text.units.isEmpty else {
+            return []
+        }
+
+        // Allow about one edit for every ten units, like a rendered template or entity that differs from its wikitext
+        let maxErrors = target.count / 10
+        let anchorLength = max(1, min(Self.maxAnchorLength, target.count / (maxErrors + 1)))
+
+        var anchorOffsets: [UInt64: [Int]] = [:]
+        for anchorIndex in 0...maxErrors {
+            let offset = anchorIndex * anchorLength
+            guard offset + anchorLength <= target.count else {
+                break
+            }
+            anchorOffsets[Self.hash(target[offset..<(offset + anchorLength)]), default: []].append(offset)
+        }
+
+        // Rolling hash over every window of the text, verifying hash hits unit by unit
+        var candidateStarts = Set<Int>()
+        let units = text.units
+        if units.count >= anchorLength {
+            let highestPower = (1..<anchorLength).reduce(UInt64(1)) { (power, _) in power &* Self.hashBase }
+            var windowHash = Self.hash(units[0..<anchorLength])
+            for position in 0...(units.count - anchorLength) {
+                if position > 0 {
+                    windowHash = (windowHash &- UInt64(units[position - 1]) &* highestPower) &* Self.hashBase &+ UInt64(units[position + anchorLength - 1])
+                }
+                guard let offsets = anchorOffsets[windowHash] else {
+                    continue
+                }
+                for offset in offsets where units[position..<(position + anchorLength)].elementsEqual(target[offset..<(offset + anchorLength)]) {
+                    candidateStarts.insert(position - offset)
+                }
+            }
+        }
+
+        var matches: [Range<Int>: Match] = [:]
+        for start in candidateStarts.sorted() {
+            guard let match = bandedMatch(of: target, near: start, maxErrors: maxErrors),
+                  !match.range.isEmpty,
+                  matches[match.range].map({ match.distance < $0.distance }) ?? true else {
+                continue
+            }
+            matches[match.range] = match
+        }
+        return Array(matches.values)
+    }
+
+    private static let hashBase: UInt64 = 1_000_003
+
+    private static func hash(_ units: ArraySlice<UInt16>) -> UInt64 {
+        return units.reduce(UInt64(0)) { (hash, unit) in hash &* hashBase &+ UInt64(unit) }
+    }
+
+    /// Semi-global edit distance of the target against text starting within `maxErrors` of `start`, computed only along the band of diagonals
+    /// where a match with at most `maxErrors` edits can lie.
+    private func bandedMatch(of target: [UInt16], near start: Int, maxErrors: Int) -> Match? {
+        let units = text.units
+        let windowStart = max(0, start - maxErrors)
+        let windowEnd = min(units.count, start + target.count + maxErrors)
+        guard windowStart < windowEnd else {
+            return nil
+        }
+        let width = windowEnd - windowStart
+        let diagonal = start - windowStart
+        guard diagonal + maxErrors >= 0 else {
+            return nil
+        }
+        let unreachable = Int.max / 2
+
+        // Costs and the window column each alignment started at, for the previous and current rows
+        var previousCosts = [Int](repeating: unreachable, count: width + 1)
+        var previousStarts = [Int](repeating: 0, count: width + 1)
+        var costs = previousCosts
+        var starts = previousStarts
+
+        for column in max(0, diagonal - maxErrors)...min(width, diagonal + maxErrors) {
+            previousCosts[column] = 0
+            previousStarts[column] = column
+        }
+
+        for row in 1...target.count {
+            let bandStart = max(0, row + diagonal - maxErrors)
+            let bandEnd = min(width, row + diagonal + maxErrors)
+            guard bandStart <= bandEnd else {
+                return nil
+            }
+            // Cells just outside the band are read by the next row
+            if bandStart > 0 {
+                costs[bandStart - 1] = unreachable
+            }
+            if bandEnd < width {
+                costs[bandEnd + 1] = unreachable
+            }
+
+            for column in bandStart...bandEnd {
+                guard column > 0 else {
+                    costs[column] = previousCosts[column] + 1
+                    starts[column] = previousStarts[column]
+                    continue
+                }
+                let substitutionCost = previousCosts[column - 1] + (target[row - 1] == units[windowStart + column - 1] ? 0 : 1)
+                let deletionCost = previousCosts[column] + 1
+                let insertionCost = column > bandStart ? costs[column - 1] + 1 : unreachable
+                if substitutionCost <= deletionCost && substitutionCost <= insertionCost {
+                    costs[column] = substitutionCost
+                    starts[column] = previousStarts[column - 1]
+                } else if deletionCost <= insertionCost {
+                    costs[column] = deletionCost
+                    starts[column] = previousStarts[column]
+                } else {
+                    costs[column] = insertionCost
+                    starts[column] = starts[column - 1]
+                }
+            }
+            swap(&costs, &previousCosts)
+            swap(&starts, &previousStarts)
+        }
+
+        var best: Match?
+        let lastBandStart = max(0, target.count + diagonal - maxErrors)
+        let lastBandEnd = min(width, target.count + diagonal + maxErrors)
+        guard lastBandStart <= lastBandEnd else {
+            return nil
+        }
+        for column in lastBandStart...lastBandEnd where previousCosts[column] <= maxErrors {
+            let range = (windowStart + previousStarts[column])..<(windowStart + column)
+            if best.map({ previousCosts[column] < $0.distance }) ?? true {
+                best = Match(range: range, distance: previousCosts[column])
+            }
+        }
+
+        guard let best else {
+            return nil
+        }
+        return Match(range: trimmed(best.range), distance: best.distance)
+    }
+
+    private func trimmed(_ range: Range<Int>) -> Range<Int> {
+        var lowerBound = range.lowerBound
+        var upperBound = range.upperBound
+        while lowerBound < upperBound && text.units[lowerBound] == WMFWikitextPlainText.separator {
+            lowerBound += 1
+        }
+        while upperBound > lowerBound && text.units[upperBound - 1] == WMFWikitextPlainText.separator {
+            upperBound -= 1
+        }
+        return lowerBound..<upperBound
+    }
+}
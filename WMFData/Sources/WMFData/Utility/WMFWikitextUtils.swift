@@ -17,89 +17,55 @@ public struct WMFWikitextUtils {
     }
     
     private static let adjacentWordCount = 6
-    private static let adjacentCharacterCount = 200
     
     /// Helper method to detect the range of selected text within a blob of wikitext.
-    /// Essentially uses adjacent text next to selected text and seeks out the best range in wikitext, while ignoring wikitext markup.
+    /// Strips wikitext markup once, keeping a map back to wikitext offsets, then looks for the selected text allowing for small differences
+    /// like rendered templates. Adjacent text next to selected text picks the best match when there are several.
     /// - Parameters:
     ///   - selectedInfo: Selected Info struct. See `wmf_getSelectedTextEditInfo` in the client app for assistance in pulling this data from a web view.
     ///   - wikitext: Wikitext to search through
-    /// - Returns: NSRange of the selected text in wikitext.
+    /// - Returns: NSRange of the selected text in wikitext, in UTF-16 code units.
     public static func rangeOf(htmlInfo: HtmlInfo, inWikitext wikitext: String) -> NSRange {
         
-        guard !htmlInfo.targetText.isEmpty else {
-            return NSRange(location: NSNotFound, length: 0)
-        }
+        let notFound = NSRange(location: NSNotFound, length: 0)
         
-        let htmlWordsBeforeTargetText = lastWordsOfText(text: htmlInfo.textBeforeTargetText, wordCount: adjacentWordCount)
-        let htmlWordsAfterTargetText = firstWordsOfText(text: htmlInfo.textAfterTargetText, wordCount: adjacentWordCount)
+        let targetText = WMFWikitextPlainText(renderedText: htmlInfo.targetText)
+        let targetRange = targetText.trimmedRange
+        guard !targetRange.isEmpty else {
+            return notFound
+        }
         
-        let regex = looseTargetTextRegex(htmlTargetText: htmlInfo.targetText)
-        guard let matches = regex?.matches(in: wikitext, range: NSRange(location: 0, length: wikitext.count)) else {
-            return NSRange(location: NSNotFound, length: 0)
+        let plainWikitext = WMFWikitextPlainText(wikitext: wikitext)
+        let matches = WMFWikitextAligner(text: plainWikitext).matches(of: targetText.units[targetRange])
+        guard !matches.isEmpty else {
+            return notFound
         }
         
-        var bestScoredMatch: NSTextCheckingResult?
+        let textBeforeTargetText = WMFWikitextPlainText(renderedText: htmlInfo.textBeforeTargetText)
+        let htmlWordsBeforeTargetText = textBeforeTargetText.words(before: textBeforeTargetText.count, count: adjacentWordCount)
+        let htmlWordsAfterTargetText = WMFWikitextPlainText(renderedText: htmlInfo.textAfterTargetText).words(after: 0, count: adjacentWordCount)
+        
+        var bestMatch: WMFWikitextAligner.Match?
         var bestScore: Int?
-        for match in matches {
-            let score = scoreForMatch(match: match, wikitext: wikitext, htmlWordsBeforeTargetText: htmlWordsBeforeTargetText, htmlWordsAfterTargetText: htmlWordsAfterTargetText)
+        for match in matches.sorted(by: { $0.range.lowerBound < $1.range.lowerBound }) {
+            let wordsBeforeScore = calculateScore(htmlWords: htmlWordsBeforeTargetText, wikitextWords: plainWikitext.words(before: match.range.lowerBound, count: adjacentWordCount))
+            let wordsAfterScore = calculateScore(htmlWords: htmlWordsAfterTargetText, wikitextWords: plainWikitext.words(after: match.range.upperBound, count: adjacentWordCount))
+            let score = wordsBeforeScore + wordsAfterScore - match.distance
             
-            if var bestScore,
-               score > bestScore {
-                bestScore = score
-                bestScoredMatch = match
-            } else if bestScoredMatch == nil {
-                bestScore = score
-                bestScoredMatch = match
+            if let bestScore,
+               score <= bestScore {
+                continue
             }
+            bestScore = score
+            bestMatch = match
         }
         
-        return bestScoredMatch?.range ?? NSRange(location: NSNotFound, length: 0)
-    }
-    
-    private static func lastWordsOfText(text: String, wordCount: Int) -> [String] {
-        return text.split(separator: " ").suffix(wordCount).map {String($0)}
-    }
-    
-    private static func firstWordsOfText(text: String, wordCount: Int) -> [String] {
-        return text.split(separator: " ").prefix(wordCount).map {String($0)}
-    }
-    
-    private static func looseTargetTextRegex(htmlTargetText: String) -> NSRegularExpression? {
-        
-        // Regex pattern is built up here
-        
-        // We replace all spaces in the htmlTargetText with additional regex that allows for square brackets, templates, html tags, etc.
-        let spaceRegexPattern = "\\s+"
-        let spaceReplaceRegexPattern = "(?:(?:\\[\\[[^\\]\\|]+\\|)|\\{\\{[^\\}]*\\}\\}|<[^>]*>|\\W)+"
-        let spaceRegex = try? NSRegularExpression(pattern: spaceRegexPattern)
-        var looseRegexPattern = htmlTargetText
-        if let matches = spaceRegex?.matches(in: htmlTargetText, range: NSRange(location: 0, length: htmlTargetText.count)) {
-            for match in matches.reversed() {
-                looseRegexPattern = (looseRegexPattern as NSString).replacingCharacters(in: match.range, with: spaceReplaceRegexPattern)
-            }
+        guard let bestMatch else {
+            return notFound
         }
         
-        return try? NSRegularExpression(pattern: looseRegexPattern)
-    }
-    
-    private static func scoreForMatch(match: NSTextCheckingResult, wikitext: String, htmlWordsBeforeTargetText: [String], htmlWordsAfterTargetText: [String]) -> Int {
-        let wikitextRangeBeforeMatchLocation = max(0, match.range.location - adjacentCharacterCount)
-        let wikitextRangeBeforeMatch = NSRange(location: wikitextRangeBeforeMatchLocation, length: match.range.location - wikitextRangeBeforeMatchLocation)
-        
-        let wikitextBeforeMatch = (wikitext as NSString).substring(with: wikitextRangeBeforeMatch).wordsOnly()
-        let wikitextWordsBeforeMatch = lastWordsOfText(text: wikitextBeforeMatch, wordCount: adjacentWordCount)
-        
-        let wikitextRangeAfterMatchLocation = match.range.location + match.range.length
-        let wikitextRangeAfterMatch = NSRange(location: wikitextRangeAfterMatchLocation, length: min(adjacentCharacterCount, wikitext.count - wikitextRangeAfterMatchLocation))
-        
-        let wikitextAfterMatch = (wikitext as NSString).substring(with: wikitextRangeAfterMatch).wordsOnly()
-        let wikitextWordsAfterMatch = firstWordsOfText(text: wikitextAfterMatch, wordCount: adjacentWordCount)
-        
-        let wordsBeforeScore = calculateScore(htmlWords: htmlWordsBeforeTargetText.reversed(), wikitextWords: wikitextWordsBeforeMatch.reversed())
-        let wordsAfterScore = calculateScore(htmlWords: htmlWordsAfterTargetText, wikitextWords: wikitextWordsAfterMatch)
-        
-        return wordsBeforeScore + wordsAfterScore
+        // Don't split surrogate pairs or grapheme clusters like emoji with modifiers
+        return (wikitext as NSString).rangeOfComposedCharacterSequences(for: plainWikitext.sourceRange(of: bestMatch.range))
     }
     
     private static func calculateScore(htmlWords: [String], wikitextWords: [String]) -> Int {
@@ -227,37 +193,3 @@ public struct WMFWikitextUtils {
         return insertedArticleWikitext
     }
 }
-
-fileprivate extension String {
-    /// Replaces parenthesis and characters within with empty string
-    /// Replaces templates and characters within with empty string
-    /// Replaces any non-word character with empty space
-    /// Trims whitespace off final output
-    func wordsOnly() -> String {
-        let parenthesisRegexPattern = "\\(.*?\\)"
-        let templateRegexPattern = "\\{\\{.*\\}\\}"
-        let nonWordRegexPattern = "\\W+"
-        
-        var finalText = self
-        
-        if let parenthesisMatches = try? NSRegularExpression(pattern: parenthesisRegexPattern).matches(in: finalText, range: NSRange(location: 0, length: finalText.count)) {
-            for match in parenthesisMatches.reversed() {
-                finalText = (finalText as NSString).replacingCharacters(in: match.range, with: "")
-            }
-        }
-        
-        if let templateMatches = try? NSRegularExpression(pattern: templateRegexPattern).matches(in: finalText, range: NSRange(location: 0, length: finalText.count)) {
-            for match in templateMatches.reversed() {
-                finalText = (finalText as NSString).replacingCharacters(in: match.range, with: "")
-            }
-        }
-        
-        if let nonWordMatches = try? NSRegularExpression(pattern: nonWordRegexPattern).matches(in: finalText, range: NSRange(location: 0, length: finalText.count)) {
-            for match in nonWordMatches.reversed() {
-                finalText = (finalText as NSString).replacingCharacters(in: match.range, with: " ")
-            }
-        }
-        
-        return finalText.trimmingCharacters(in: .whitespaces)
-    }
-}
@@ -0,0 +1,78 @@
+import Foundation
+import WMFData
+
+#if DEBUG
+
+/// Serves image data for any URL after a short delay, and counts the requests made for each URL
+public final class WMFMockImageService: WMFService {
+
+    private let lock = NSLock()
+    private var requestCountsByURL: [URL: Int] = [:]
+    private var failingURLs: Set<URL> = []
+
+    /// Bytes returned for each URL
+    public var dataSize = 1_000
+
+    public init() {
+
+    }
+
+    public var requestCount: Int {
+        lock.lock()
+        defer { lock.unlock() }
+        return requestCountsByURL.values.reduce(0, +)
+    }
+
+    public func requestCount(url: URL) -> Int {
+        lock.lock()
+        defer { lock.unlock() }
+        return requestCountsByURL[url] ?? 0
+    }
+
+    public func setFailing(_ isFailing: Bool, url: URL) {
+        lock.lock()
+        if isFailing {
+            failingURLs.insert(url)
+        } else {
+            failingURLs.remove(url)
+        }
+        lock.unlock()
+    }
+
+    /// The data served for a URL
+    public func data(url: URL) -> Data {
+        let urlData = Data(url.absoluteString.utf8)
+        return Data((0..<dataSize).map { urlData.isEmpty ? 0 : urlData[$0 % urlData.count] })
+    }
+
+    public func perform<R: WMFServiceRequest>(request: R, completion: @escaping (Result<Data, any Error>) -> Void) {
+        guard let url = request.url else {
+            completion(.failure(WMFMockError.unableToPullData))
+            return
+        }
+
+        lock.lock()
+        requestCountsByURL[url, default: 0] += 1
+        let isFailing = failingURLs.contains(url)
+        lock.unlock()
+
+        let data = data(url: url)
+        DispatchQueue.global().asyncAfter(deadline: .now() + .milliseconds(20)) {
+            completion(isFailing ? .failure(WMFMockError.unableToPullData) : .success(data))
+        }
+    }
+
+    public func perform<R: WMFServiceRequest>(request: R, completion: @escaping (Result<[String: Any]?, Error>) -> Void) {
+        completion(.failure(WMFMockError.unableToPullData))
+    }
+
+    public func performDecodableGET<R: WMFServiceRequest, T: Decodable>(request: R, completion: @escaping (Result<T, Error>) -> Void) {
+        completion(.failure(WMFMockError.unableToPullData))
+    }
+
+    public func performDecodablePOST<R: WMFServiceRequest, T: Decodable>(request: R, completion: @escaping (Result<T, Error>) -> Void) {
+        completion(.failure(WMFMockError.unableToPullData))
+    }
+}
+
+#endif
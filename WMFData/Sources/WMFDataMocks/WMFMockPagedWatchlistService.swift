@@ -0,0 +1,189 @@
+import Foundation
+import WMFData
+
+#if DEBUG
+
+/// Serves generated watchlist changes a page at a time, following `wllimit`, `wlcontinue` and `wlend`. Responses are delivered asynchronously, and failures can be injected per host and page.
+public final class WMFMockPagedWatchlistService: WMFService {
+
+    public struct Change {
+        public let title: String
+        public let revisionID: UInt
+        public let logID: UInt?
+        public let timestamp: String
+
+        public init(title: String, revisionID: UInt, logID: UInt? = nil, timestamp: String) {
+            self.title = title
+            self.revisionID = revisionID
+            self.logID = logID
+            self.timestamp = timestamp
+        }
+    }
+
+    private struct Failure {
+        let error: Error
+        let pageOffset: Int
+        var remainingCount: Int
+    }
+
+    public struct Request {
+        public let host: String
+        public let parameters: [String: String]
+    }
+
+    private let lock = NSLock()
+    private var changesByHost: [String: [Change]] = [:]
+    private var failuresByHost: [String: Failure] = [:]
+    private var _requests: [Request] = []
+    private var inFlightCount = 0
+    private var _maxInFlightCount = 0
+
+    public init() {
+
+    }
+
+    public var requests: [Request] {
+        lock.lock()
+        defer { lock.unlock() }
+        return _requests
+    }
+
+    public var maxInFlightCount: Int {
+        lock.lock()
+        defer { lock.unlock() }
+        return _maxInFlightCount
+    }
+
+    /// Sets the changes for a host, newest first
+    public func setChanges(_ changes: [Change], host: String) {
+        lock.lock()
+        changesByHost[host] = changes
+        lock.unlock()
+    }
+
+    public func changes(host: String) -> [Change] {
+        lock.lock()
+        defer { lock.unlock() }
+        return changesByHost[host] ?? []
+    }
+
+    /// Fails requests to a host for the page starting at `pageOffset`, `count` times
+    public func injectFailure(_ error: Error, host: String, pageOffset: Int = 0, count: Int = .max) {
+        lock.lock()
+        failuresByHost[host] = Failure(error: error, pageOffset: pageOffset, remainingCount: count)
+        lock.unlock()
+    }
+
+    public func removeFailures() {
+        lock.lock()
+        failuresByHost.removeAll()
+        lock.unlock()
+    }
+
+    public func removeRequests() {
+        lock.lock()
+        _requests.removeAll()
+        _maxInFlightCount = 0
+        lock.unlock()
+    }
+
+    public func perform<R: WMFServiceRequest>(request: R, completion: @escaping (Result<Data, any Error>) -> Void) {
+        completion(.failure(WMFMockError.unableToPullData))
+    }
+
+    public func perform<R: WMFServiceRequest>(request: R, completion: @escaping (Result<[String: Any]?, Error>) -> Void) {
+        completion(.failure(WMFMockError.unableToPullData))
+    }
+
+    public func performDecodablePOST<R: WMFServiceRequest, T: Decodable>(request: R, completion: @escaping (Result<T, Error>) -> Void) {
+        completion(.failure(WMFMockError.unableToPullData))
+    }
+
+    public func performDecodableGET<R: WMFServiceRequest, T: Decodable>(request: R, completion: @escaping (Result<T, Error>) -> Void) {
+        guard let host = request.url?.host,
+              let parameters = request.parameters as? [String: String],
+              parameters["list"] == "watchlist" else {
+            completion(.failure(WMFMockError.unableToPullData))
+            return
+        }
+
+        let pageOffset = Int(parameters["wlcontinue"] ?? "") ?? 0
+
+        lock.lock()
+        _requests.append(Request(host: host, parameters: parameters))
+        inFlightCount += 1
+        _maxInFlightCount = max(_maxInFlightCount, inFlightCount)
+        var failure = failuresByHost[host]
+        if let currentFailure = failure,
+           currentFailure.pageOffset == pageOffset,
+           currentFailure.remainingCount > 0 {
+            failuresByHost[host]?.remainingCount -= 1
+        } else {
+            failure = nil
+        }
+        let changes = changesByHost[host] ?? []
+        lock.unlock()
+
+        DispatchQueue.global().asyncAfter(deadline: .now() + .milliseconds(2)) {
+            let result: Result<T, Error>
+            if let failure {
+                result = .failure(failure.error)
+            } else {
+                do {
+                    let data = try self.responseData(changes: changes, parameters: parameters, pageOffset: pageOffset)
+                    result = .success(try JSONDecoder().decode(T.self, from: data))
+                } catch {
+                    result = .failure(WMFMockError.unableToDeserialize)
+                }
+            }
+
+            self.lock.lock()
+            self.inFlightCount -= 1
+            self.lock.unlock()
+
+            completion(result)
+        }
+    }
+
+    private func responseData(changes: [Change], parameters: [String: String], pageOffset: Int) throws -> Data {
+        var changes = changes
+        if let end = parameters["wlend"] {
+            changes = changes.filter { $0.timestamp >= end }
+        }
+
+        let limit = Int(parameters["wllimit"] ?? "") ?? 10
+        let page = changes.dropFirst(pageOffset).prefix(limit)
+
+        var json: [String: Any] = [
+            "batchcomplete": true,
+            "query": [
+                "watchlist": page.map { change -> [String: Any] in
+                    var item: [String: Any] = [
+                        "type": change.logID == nil ? "edit" : "log",
+                        "title": change.title,
+                        "revid": change.revisionID,
+                        "old_revid": change.revisionID == 0 ? 0 : change.revisionID - 1,
+                        "user": "Editor",
+                        "anon": false,
+                        "bot": false,
+                        "oldlen": 100,
+                        "newlen": 120,
+                        "timestamp": change.timestamp,
+                        "comment": "Edit to \(change.title)",
+                        "parsedcomment": "Edit to \(change.title)"
+                    ]
+                    item["logid"] = change.logID
+                    return item
+                }
+            ]
+        ]
+
+        if pageOffset + limit < changes.count {
+            json["continue"] = ["wlcontinue": String(pageOffset + limit), "continue": "-||"]
+        }
+
+        return try JSONSerialization.data(withJSONObject: json)
+    }
+}
+
+#endif
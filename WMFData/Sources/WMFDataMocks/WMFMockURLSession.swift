@@ -57,3 +57,46 @@ final class WMFMockMissingDataSession: WMFURLSession {
         return WMFMockURLSessionDataTask()
     }
 }
+
+/// Responds to each task with the next status code, returning mock data for successful ones. The last status code is repeated once the sequence runs out.
+final class WMFMockSequenceURLSession: WMFURLSession {
+    
+    private let lock = NSLock()
+    private let statusCodes: [Int]
+    private var _requestCount = 0
+    
+    init(statusCodes: [Int]) {
+        self.statusCodes = statusCodes
+    }
+    
+    var requestCount: Int {
+        lock.lock()
+        defer { lock.unlock() }
+        return _requestCount
+    }
+    
+    func wmfDataTask(with request: URLRequest, completionHandler: @escaping @Sendable (Data?, URLResponse?, Error?) -> Void) -> WMFData.WMFURLSessionDataTask {
+        
+        lock.lock()
+        let statusCode = statusCodes[min(_requestCount, statusCodes.count - 1)]
+        _requestCount += 1
+        lock.unlock()
+        
+        let data = statusCode == 200 ? try? JSONEncoder().encode(WMFMockData(oneInt: 1, twoString: "two")) : nil
+        let response = HTTPURLResponse(url: URL(string: "http://wikipedia.org")!, statusCode: statusCode, httpVersion: nil, headerFields: ["Content-Type": "application/json; charset=utf-8"])
+        
+        completionHandler(data, response, nil)
+        return WMFMockURLSessionDataTask()
+    }
+}
+
+/// Responds with an HTML page, like a captive portal
+final class WMFMockHTMLURLSession: WMFURLSession {
+    func wmfDataTask(with request: URLRequest, completionHandler: @escaping @Sendable (Data?, URLResponse?, Error?) -> Void) -> WMFData.WMFURLSessionDataTask {
+        
+        let response = HTTPURLResponse(url: URL(string: "http://wikipedia.org")!, statusCode: 200, httpVersion: nil, headerFields: ["Content-Type": "text/html; charset=utf-8"])
+        
+        completionHandler(Data("<html><body>Sign in to continue</body></html>".utf8), response, nil)
+        return WMFMockURLSessionDataTask()
+    }
+}
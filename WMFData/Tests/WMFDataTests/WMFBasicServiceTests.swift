@@ -324,4 +324,233 @@ final class WMFBasicServiceTests: XCTestCase {
 
         service.perform(request: request, completion: completion)
     }
+    
+    // MARK: - Retry Tests
+    
+    private let fastRetryPolicy = WMFBasicService.RetryPolicy(maximumAttempts: 3, baseDelay: 0.001, maximumDelay: 0.01)
+    
+    private func performDecodable(service: WMFBasicService, method: WMFServiceRequestMethod) -> Result<WMFMockData, Error> {
+        let request = WMFBasicServiceRequest(url: URL(string: "http://wikipedia.org")!, method: method, acceptType: .json)
+        let expectation = expectation(description: "Request completed")
+        var result: Result<WMFMockData, Error>?
+        
+        let completion: (Result<WMFMockData, Error>) -> Void = {
+            result = $0
+            expectation.fulfill()
+        }
+        
+        if method == .GET {
+            service.performDecodableGET(request: request, completion: completion)
+        } else {
+            service.performDecodablePOST(request: request, completion: completion)
+        }
+        
+        wait(for: [expectation], timeout: 5)
+        return result ?? .failure(WMFServiceError.missingData)
+    }
+    
+    func testTransientFailureGetIsRetried() throws {
+        
+        let session = WMFMockSequenceURLSession(statusCodes: [503, 502, 200])
+        let service = WMFBasicService(urlSession: session, retryPolicy: fastRetryPolicy)
+        
+        let response = try performDecodable(service: service, method: .GET).get()
+        XCTAssertEqual(response.oneInt, 1)
+        XCTAssertEqual(session.requestCount, 3)
+    }
+    
+    func testRetriesStopAfterMaximumAttempts() {
+        
+        let session = WMFMockSequenceURLSession(statusCodes: [503])
+        let service = WMFBasicService(urlSession: session, retryPolicy: fastRetryPolicy)
+        
+        let result = performDecodable(service: service, method: .GET)
+        XCTAssertThrowsError(try result.get()) { error in
+            XCTAssertEqual(error as? WMFServiceError, WMFServiceError.invalidHttpResponse(503))
+        }
+        XCTAssertEqual(session.requestCount, 3)
+    }
+    
+    func testClientErrorGetIsNotRetried() {
+        
+        let session = WMFMockSequenceURLSession(statusCodes: [404, 200])
+        let service = WMFBasicService(urlSession: session, retryPolicy: fastRetryPolicy)
+        
+        XCTAssertThrowsError(try performDecodable(service: service, method: .GET).get())
+        XCTAssertEqual(session.requestCount, 1)
+    }
+    
+    func testTransientFailurePostIsNotRetried() {
+        
+        let session = WMFMockSequenceURLSession(statusCodes: [503, 200])
+        let service = WMFBasicService(urlSession: session, retryPolicy: fastRetryPolicy)
+        
+        XCTAssertThrowsError(try performDecodable(service: service, method: .POST).get())
+        XCTAssertEqual(session.requestCount, 1)
+    }
+    
+    func testRetryDelaysAreJitteredAndCapped() {
+        
+        let policy = WMFBasicService.RetryPolicy(maximumAttempts: 10, baseDelay: 0.5, maximumDelay: 8)
+        for attempt in 1...10 {
+            let cap = min(8, 0.5 * pow(2, Double(attempt - 1)))
+            let delays = (0..<200).map { _ in policy.delay(afterAttempt: attempt) }
+            XCTAssertTrue(delays.allSatisfy { $0 >= 0 && $0 <= cap }, "Attempt \(attempt)")
+            XCTAssertGreaterThan(Set(delays).count, 1, "Delays should vary")
+        }
+    }
+    
+    // MARK: - Response Validation Tests
+    
+    func testHTMLResponseIsRejectedForJSONRequest() {
+        
+        let service = WMFBasicService(urlSession: WMFMockHTMLURLSession())
+        
+        XCTAssertThrowsError(try performDecodable(service: service, method: .GET).get()) { error in
+            XCTAssertEqual(error as? WMFServiceError, .unexpectedContentType("text/html"))
+        }
+    }
+    
+    func testResponseLargerThanMaximumSizeFails() {
+        
+        let service = WMFBasicService(urlSession: mockSuccessSession)
+        var request = WMFBasicServiceRequest(url: URL(string: "http://wikipedia.org")!, method: .GET, acceptType: .json)
+        request.maximumResponseSize = 8
+        
+        let expectation = expectation(description: "Request completed")
+        service.performDecodableGET(request: request) { (result: Result<WMFMockData, Error>) in
+            XCTAssertThrowsError(try result.get()) { error in
+                XCTAssertEqual(error as? WMFServiceError, .responseTooLarge(8))
+            }
+            expectation.fulfill()
+        }
+        wait(for: [expectation], timeout: 5)
+    }
+    
+    // MARK: - Response Buffer Tests
+    
+    private func httpResponse(contentType: String = "application/json; charset=utf-8", contentLength: Int?) -> HTTPURLResponse {
+        var headerFields = ["Content-Type": contentType]
+        if let contentLength {
+            headerFields["Content-Length"] = String(contentLength)
+        }
+        return HTTPURLResponse(url: URL(string: "http://wikipedia.org")!, statusCode: 200, httpVersion: nil, headerFields: headerFields)!
+    }
+    
+    /// A watchlist-like response with the given number of items
+    private func largePayload(itemCount: Int) throws -> Data {
+        let items = (0..<itemCount).map { index in
+            [
+                "title": "Page \(index)",
+                "revid": index,
+                "user": "Editor \(index % 50)",
+                "timestamp": "2024-05-\(10 + index % 20)T12:00:00Z",
+                "comment": String(repeating: "Edit summary \(index). ", count: 4)
+            ] as [String: Any]
+        }
+        return try JSONSerialization.data(withJSONObject: ["query": ["watchlist": items]])
+    }
+    
+    private struct LargePayloadResponse: Decodable {
+        struct Query: Decodable {
+            struct Item: Decodable {
+                let title: String
+                let revid: Int
+                let user: String
+                let timestamp: String
+                let comment: String
+            }
+            let watchlist: [Item]
+        }
+        let query: Query
+    }
+    
+    private func chunks(of data: Data, size: Int) -> [Data] {
+        return stride(from: 0, to: data.count, by: size).map { data.subdata(in: $0..<min($0 + size, data.count)) }
+    }
+    
+    func testResponseBufferCollectsChunks() throws {
+        
+        let payload = try largePayload(itemCount: 2_000)
+        
+        for contentLength in [payload.count, nil] {
+            var buffer = WMFResponseBuffer(maximumResponseSize: nil, validateResponse: { _ in nil })
+            try buffer.receive(httpResponse(contentLength: contentLength))
+            for chunk in chunks(of: payload, size: 16 * 1024) {
+                try buffer.append(chunk)
+            }
+            XCTAssertEqual(buffer.data, payload)
+        }
+    }
+    
+    func testResponseBufferEnforcesMaximumSize() throws {
+        
+        let payload = try largePayload(itemCount: 2_000)
+        let maximumResponseSize = payload.count / 2
+        
+        // A declared length over the limit fails before any of the body is buffered
+        var declaredBuffer = WMFResponseBuffer(maximumResponseSize: maximumResponseSize, validateResponse: { _ in nil })
+        XCTAssertThrowsError(try declaredBuffer.receive(httpResponse(contentLength: payload.count))) { error in
+            XCTAssertEqual(error as? WMFServiceError, .responseTooLarge(maximumResponseSize))
+        }
+        
+        // Without a declared length it fails once the limit is passed
+        var undeclaredBuffer = WMFResponseBuffer(maximumResponseSize: maximumResponseSize, validateResponse: { _ in nil })
+        try undeclaredBuffer.receive(httpResponse(contentLength: nil))
+        var bufferedCount = 0
+        var thrownError: Error?
+        do {
+            for chunk in chunks(of: payload, size: 16 * 1024) {
+                try undeclaredBuffer.append(chunk)
+                bufferedCount += chunk.count
+            }
+        } catch let error {
+            thrownError = error
+        }
+        XCTAssertEqual(thrownError as? WMFServiceError, .responseTooLarge(maximumResponseSize))
+        XCTAssertLessThanOrEqual(bufferedCount, maximumResponseSize)
+        XCTAssertTrue(undeclaredBuffer.data.isEmpty, "The partial body should be released")
+    }
+    
+    func testResponseBufferValidatesBeforeBuffering() {
+        
+        var buffer = WMFResponseBuffer(maximumResponseSize: nil, validateResponse: { response in
+            return (response as? HTTPURLResponse)?.mimeType == "text/html" ? WMFServiceError.unexpectedContentType("text/html") : nil
+        })
+        XCTAssertThrowsError(try buffer.receive(httpResponse(contentType: "text/html", contentLength: 100)))
+    }
+    
+    /// Appends chunks to a buffer that grows as it goes, as data task completion handlers do, then decodes
+    func testPerformanceLegacyBufferingAndDecoding() throws {
+        
+        let payload = try largePayload(itemCount: 50_000)
+        let payloadChunks = chunks(of: payload, size: 16 * 1024)
+        
+        measure(metrics: [XCTClockMetric(), XCTMemoryMetric()]) {
+            var data = Data()
+            for chunk in payloadChunks {
+                data.append(chunk)
+            }
+            let response = try? JSONDecoder().decode(LargePayloadResponse.self, from: data)
+            XCTAssertEqual(response?.query.watchlist.count, 50_000)
+        }
+    }
+    
+    func testPerformanceStreamedBufferingAndDecoding() throws {
+        
+        let payload = try largePayload(itemCount: 50_000)
+        let payloadChunks = chunks(of: payload, size: 16 * 1024)
+        let response = httpResponse(contentLength: payload.count)
+        let decoder = JSONDecoder()
+        
+        measure(metrics: [XCTClockMetric(), XCTMemoryMetric()]) {
+            var buffer = WMFResponseBuffer(maximumResponseSize: WMFBasicService.defaultMaximumJSONResponseSize, validateResponse: { _ in nil })
+            try? buffer.receive(response)
+            for chunk in payloadChunks {
+                try? buffer.append(chunk)
+            }
+            let decodedResponse = try? decoder.decode(LargePayloadResponse.self, from: buffer.data)
+            XCTAssertEqual(decodedResponse?.query.watchlist.count, 50_000)
+        }
+    }
 }
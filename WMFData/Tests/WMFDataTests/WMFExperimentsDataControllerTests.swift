@@ -0,0 +1,178 @@
+import XCTest
+@testable import WMFData
+@testable import WMFDataMocks
+
+final class WMFExperimentsDataControllerTests: XCTestCase {
+
+    private let installID = "6A2F1C3E-8B4D-4E5F-9A0B-1C2D3E4F5A6B"
+
+    private typealias Engine = WMFExperimentAssignmentEngine
+
+    /// Install IDs formatted like UUIDs, from a seeded generator so every run simulates the same installs
+    private func syntheticInstallIDs(count: Int, seed: UInt64) -> [String] {
+        var generator = WMFSeededRandomNumberGenerator(seed: seed)
+        return (0..<count).map { _ in
+            let high = generator.next()
+            let low = generator.next()
+            return String(format: "%08X-%04X-%04X-%04X-%012llX", UInt32(high >> 32), UInt16((high >> 16) & 0xFFFF), UInt16(high & 0xFFFF), UInt16(low >> 48), low & 0xFFFF_FFFF_FFFF)
+        }
+    }
+
+    // MARK: - Engine
+
+    func testSlotIsStable() {
+        let slot = Engine.slot(installID: installID, salt: "articleAsLivingDoc")
+        XCTAssertEqual(Engine.slot(installID: installID, salt: "articleAsLivingDoc"), slot)
+        XCTAssertTrue((0..<Engine.slotCount).contains(slot))
+    }
+
+    func testInvalidWeightsThrow() {
+        let experiment = Engine.Experiment(key: "Experiment", arms: [Engine.Arm(name: "A", weight: 5_000), Engine.Arm(name: "B", weight: 4_000)], layer: nil)
+        XCTAssertThrowsError(try Engine.arm(installID: installID, experiment: experiment))
+    }
+
+    func testRaisingWeightOnlyMovesInstallsIntoFirstArm() throws {
+        for installID in syntheticInstallIDs(count: 1_000, seed: 1) {
+            let small = Engine.Experiment(key: "Experiment", arms: [Engine.Arm(name: "Test", weight: 1_000), Engine.Arm(name: "Control", weight: 9_000)], layer: nil)
+            let large = Engine.Experiment(key: "Experiment", arms: [Engine.Arm(name: "Test", weight: 5_000), Engine.Arm(name: "Control", weight: 5_000)], layer: nil)
+            if try Engine.arm(installID: installID, experiment: small) == "Test" {
+                XCTAssertEqual(try Engine.arm(installID: installID, experiment: large), "Test")
+            }
+        }
+    }
+
+    /// Assigns 20,000 synthetic installs and checks every split is within 2% of its weight
+    func testSimulatedSplitsMatchWeights() throws {
+        try simulateSplits(installCount: 20_000, tolerance: 0.02)
+    }
+
+    /// The full simulation: 1,000,000 synthetic installs, every split within 0.2% of its weight. Takes a while, so it only runs when `WMF_RUN_LONG_SIMULATIONS` is set in the test environment.
+    func testMillionInstallSimulatedSplitsMatchWeights() throws {
+        try XCTSkipUnless(ProcessInfo.processInfo.environment["WMF_RUN_LONG_SIMULATIONS"] != nil, "Set WMF_RUN_LONG_SIMULATIONS to run the full split simulation")
+        try simulateSplits(installCount: 1_000_000, tolerance: 0.002)
+    }
+
+    private func simulateSplits(installCount: Int, tolerance: Double, file: StaticString = #filePath, line: UInt = #line) throws {
+        let multiArm = Engine.Experiment(key: "Multi Arm", arms: [Engine.Arm(name: "A", weight: 2_000), Engine.Arm(name: "B", weight: 3_000), Engine.Arm(name: "C", weight: 5_000)], layer: nil)
+        let independent = Engine.Experiment(key: "Independent", arms: [Engine.Arm(name: "Test", weight: 5_000), Engine.Arm(name: "Control", weight: 5_000)], layer: nil)
+        let layer = Engine.Layer(key: "Layer", shares: [Engine.Layer.Share(experimentKey: "First", weight: 3_000), Engine.Layer.Share(experimentKey: "Second", weight: 6_000)])
+        let first = Engine.Experiment(key: "First", arms: [Engine.Arm(name: "Test", weight: 5_000), Engine.Arm(name: "Control", weight: 5_000)], layer: layer)
+        let second = Engine.Experiment(key: "Second", arms: [Engine.Arm(name: "Test", weight: 10_000)], layer: layer)
+
+        var multiArmCounts: [String: Int] = [:]
+        var independentTestCount = 0
+        var bothTestCount = 0
+        var firstCounts: [String: Int] = [:]
+        var secondEnrolledCount = 0
+        var unenrolledCount = 0
+
+        for installID in syntheticInstallIDs(count: installCount, seed: 49) {
+            let multiArmArm = try XCTUnwrap(Engine.arm(installID: installID, experiment: multiArm))
+            multiArmCounts[multiArmArm, default: 0] += 1
+
+            if try Engine.arm(installID: installID, experiment: independent) == "Test" {
+                independentTestCount += 1
+                if multiArmArm == "C" {
+                    bothTestCount += 1
+                }
+            }
+
+            let firstArm = try Engine.arm(installID: installID, experiment: first)
+            let secondArm = try Engine.arm(installID: installID, experiment: second)
+            XCTAssertFalse(firstArm != nil && secondArm != nil, "Experiments in a layer should not share installs")
+            if let firstArm {
+                firstCounts[firstArm, default: 0] += 1
+            } else if secondArm != nil {
+                secondEnrolledCount += 1
+            } else {
+                unenrolledCount += 1
+            }
+        }
+
+        func assertShare(_ count: Int?, _ expectedShare: Double, _ message: String) {
+            let share = Double(count ?? 0) / Double(installCount)
+            XCTAssertEqual(share, expectedShare, accuracy: tolerance, message, file: file, line: line)
+        }
+
+        assertShare(multiArmCounts["A"], 0.2, "Arm A")
+        assertShare(multiArmCounts["B"], 0.3, "Arm B")
+        assertShare(multiArmCounts["C"], 0.5, "Arm C")
+        assertShare(independentTestCount, 0.5, "Independent test arm")
+        assertShare(bothTestCount, 0.25, "Experiments with different keys should split independently")
+        assertShare((firstCounts["Test"] ?? 0) + (firstCounts["Control"] ?? 0), 0.3, "First experiment share of layer")
+        assertShare(firstCounts["Test"], 0.15, "First experiment test arm")
+        assertShare(secondEnrolledCount, 0.6, "Second experiment share of layer")
+        assertShare(unenrolledCount, 0.1, "Unallocated share of layer")
+    }
+
+    // MARK: - Data controller
+
+    func testBucketIsDeterministicAcrossStores() throws {
+        let bucket = try WMFExperimentsDataController(store: WMFMockKeyValueStore(), installID: installID).determineBucketForExperiment(.altTextArticleEditor, withPercentage: 50)
+        let otherBucket = try WMFExperimentsDataController(store: WMFMockKeyValueStore(), installID: installID).determineBucketForExperiment(.altTextArticleEditor, withPercentage: 50)
+        XCTAssertEqual(bucket, otherBucket)
+    }
+
+    func testPercentageBounds() throws {
+        let controller = WMFExperimentsDataController(store: WMFMockKeyValueStore(), installID: installID)
+        XCTAssertEqual(try controller.determineBucketForExperiment(.altTextImageRecommendations, withPercentage: 100), .altTextImageRecommendationsTest)
+        XCTAssertEqual(try controller.determineBucketForExperiment(.altTextImageRecommendations, withPercentage: 0), .altTextImageRecommendationsControl)
+        XCTAssertEqual(controller.bucketForExperiment(.altTextImageRecommendations), .altTextImageRecommendationsControl)
+        XCTAssertThrowsError(try controller.determineBucketForExperiment(.altTextImageRecommendations, withPercentage: 101))
+        XCTAssertNil(controller.bucketForExperiment(.altTextArticleEditor))
+    }
+
+    func testAssignmentsAreSavedAsOneRecord() throws {
+        let store = WMFMockKeyValueStore()
+        let controller = WMFExperimentsDataController(store: store, installID: installID)
+        try controller.determineBucketForExperiment(.altTextImageRecommendations, withPercentage: 100)
+        try controller.determineBucketForExperiment(.altTextArticleEditor, withPercentage: 100)
+
+        let legacyBucket: String? = try store.load(key: WMFSharedCacheDirectoryNames.experiments.rawValue, WMFExperimentsDataController.BucketFileName.altTextArticleEditorBucket.rawValue)
+        XCTAssertNil(legacyBucket)
+
+        // A new install ID does not change saved assignments
+        let reopenedController = WMFExperimentsDataController(store: store, installID: "Other")
+        XCTAssertEqual(reopenedController.bucketForExperiment(.altTextImageRecommendations), .altTextImageRecommendationsTest)
+        XCTAssertEqual(reopenedController.bucketForExperiment(.altTextArticleEditor), .altTextArticleEditorTest)
+    }
+
+    func testMultiArmExperimentInLayer() throws {
+        let layer = Engine.Layer(key: "Layer", shares: [Engine.Layer.Share(experimentKey: "First", weight: 5_000), Engine.Layer.Share(experimentKey: "Second", weight: 5_000)])
+        let arms = [Engine.Arm(name: "A", weight: 3_334), Engine.Arm(name: "B", weight: 3_333), Engine.Arm(name: "C", weight: 3_333)]
+        let controller = WMFExperimentsDataController(store: WMFMockKeyValueStore(), installID: installID)
+
+        let firstArm = try controller.determineArm(for: Engine.Experiment(key: "First", arms: arms, layer: layer))
+        let secondArm = try controller.determineArm(for: Engine.Experiment(key: "Second", arms: arms, layer: layer))
+        XCTAssertTrue((firstArm == nil) != (secondArm == nil), "The install should be in exactly one experiment of the layer")
+        XCTAssertEqual(firstArm ?? secondArm, try Engine.arm(installID: installID, experiment: Engine.Experiment(key: firstArm != nil ? "First" : "Second", arms: arms, layer: nil)))
+    }
+
+    func testLegacyBucketsAreMigrated() throws {
+        let store = WMFMockKeyValueStore()
+        let cacheDirectoryName = WMFSharedCacheDirectoryNames.experiments.rawValue
+        try store.save(key: cacheDirectoryName, WMFExperimentsDataController.BucketFileName.articleAsLivingDocBucket.rawValue, value: WMFExperimentsDataController.BucketValue.articleAsLivingDocControl.rawValue)
+        try store.save(key: cacheDirectoryName, WMFExperimentsDataController.PercentageFileName.articleAsLivingDocPercent.rawValue, value: 100)
+        try store.save(key: cacheDirectoryName, WMFExperimentsDataController.BucketFileName.altTextImageRecommendationsBucket.rawValue, value: WMFExperimentsDataController.BucketValue.altTextImageRecommendationsTest.rawValue)
+        try store.save(key: cacheDirectoryName, WMFExperimentsDataController.PercentageFileName.altTextImageRecommendationsPercent.rawValue, value: 0)
+
+        let controller = WMFExperimentsDataController(store: store, installID: installID)
+        XCTAssertEqual(controller.bucketForExperiment(.articleAsLivingDoc), .articleAsLivingDocControl)
+        XCTAssertEqual(controller.bucketForExperiment(.altTextImageRecommendations), .altTextImageRecommendationsTest)
+        XCTAssertNil(controller.bucketForExperiment(.altTextArticleEditor))
+
+        let legacyBucket: String? = try store.load(key: cacheDirectoryName, WMFExperimentsDataController.BucketFileName.articleAsLivingDocBucket.rawValue)
+        let legacyPercentage: Int? = try store.load(key: cacheDirectoryName, WMFExperimentsDataController.PercentageFileName.altTextImageRecommendationsPercent.rawValue)
+        XCTAssertNil(legacyBucket, "Legacy files should be removed once migrated")
+        XCTAssertNil(legacyPercentage)
+
+        // Migrated buckets keep their meaning at the same percentage, even where hashing would disagree
+        XCTAssertEqual(try controller.determineBucketForExperiment(.articleAsLivingDoc, withPercentage: 100), .articleAsLivingDocControl)
+        XCTAssertEqual(try controller.determineBucketForExperiment(.altTextImageRecommendations, withPercentage: 0), .altTextImageRecommendationsTest)
+
+        // A new percentage reassigns from the hash
+        XCTAssertEqual(try controller.determineBucketForExperiment(.articleAsLivingDoc, withPercentage: 0), .articleAsLivingDocControl)
+        XCTAssertEqual(try controller.determineBucketForExperiment(.altTextImageRecommendations, withPercentage: 100), .altTextImageRecommendationsTest)
+        XCTAssertEqual(try controller.determineBucketForExperiment(.articleAsLivingDoc, withPercentage: 100), .articleAsLivingDocTest)
+    }
+}
@@ -403,4 +403,125 @@ final class WMFFundraisingCampaignDataControllerTests: XCTestCase {
         
         XCTAssertNil(nlWikiAssetThirtyHoursLater, "NL asset marked as maybe later, then loaded after last day of campaign should be nil")
     }
+
+    // MARK: - Eligibility Index
+
+    func testEligibilityIndexMatchesConfigScan() throws {
+        var generator = WMFSeededRandomNumberGenerator(seed: 2023)
+        let countryCodes = ["NL", "US", "DE", "FR", "IN", "BR", "JP", "ZA"]
+        let languageCodes = ["en", "nl", "de", "fr", "es", "pt", "ja", "zh", "zh-hans", "zh-hant", "sr", "sr-ec"]
+        let baseDate = validFirstDayDate()
+        let dateFormatter = DateFormatter.mediaWikiAPIDateFormatter
+
+        for round in 0..<5 {
+            let configCount = [1, 10, 100, 1_000, 3_000][round]
+
+            var configs: [[String: Any]] = []
+            var boundaryDates: [Date] = []
+            for index in 0..<configCount {
+                let startDate = baseDate.addingTimeInterval(TimeInterval(Int.random(in: 0..<(365 * 24), using: &generator) * 3_600))
+                let endDate = startDate.addingTimeInterval(TimeInterval(Int.random(in: 0..<(60 * 24 * 60), using: &generator) * 60))
+                boundaryDates.append(contentsOf: [startDate, endDate])
+
+                let assets: [String: Any] = Dictionary(uniqueKeysWithValues: languageCodes.filter { _ in Bool.random(using: &generator) }.map { languageCode in
+                    (languageCode, [
+                        "text": "Text \(index) \(languageCode)",
+                        "footer": "Footer \(index)",
+                        "actions": [["title": "Donate", "url": "https://donate.wikimedia.org/?utm_campaign=$platform;&c=\(index)"], ["title": "Maybe later"]],
+                        "currency_code": "EUR"
+                    ] as [String: Any])
+                })
+
+                configs.append([
+                    "version": 1,
+                    "id": "Campaign \(index)",
+                    "start_time": dateFormatter.string(from: startDate),
+                    "end_time": dateFormatter.string(from: endDate),
+                    "platforms": ["iOS": [String: String]()],
+                    "countries": countryCodes.filter { _ in Int.random(in: 0..<4, using: &generator) == 0 },
+                    "assets": assets
+                ])
+            }
+
+            let data = try JSONSerialization.data(withJSONObject: configs)
+            let response = try JSONDecoder().decode(WMFFundraisingCampaignConfigResponse.self, from: data)
+            XCTAssertEqual(response.configs.count, configCount)
+
+            let index = WMFFundraisingCampaignEligibilityIndex(response: response)
+
+            for _ in 0..<2_000 {
+                let date: Date
+                if Bool.random(using: &generator) {
+                    date = boundaryDates.randomElement(using: &generator)!.addingTimeInterval(TimeInterval(Int.random(in: -1...1, using: &generator)))
+                } else {
+                    date = baseDate.addingTimeInterval(TimeInterval(Int.random(in: (-30 * 86_400)..<(450 * 86_400), using: &generator)))
+                }
+                let countryCode = (countryCodes + ["GB"]).randomElement(using: &generator)!
+                let languageCode = (languageCodes + ["it"]).randomElement(using: &generator)!
+                let languageVariantCode = Bool.random(using: &generator) ? nil : languageCodes.randomElement(using: &generator)
+
+                let expectedAsset = scannedAsset(response: response, countryCode: countryCode, languageCode: languageCode, languageVariantCode: languageVariantCode, date: date)
+                let asset = index.asset(countryCode: countryCode, languageCode: languageCode, languageVariantCode: languageVariantCode, date: date)
+
+                let description = "\(configCount) configs, \(countryCode) \(languageCode) \(languageVariantCode ?? "-") \(date)"
+                XCTAssertEqual(asset?.id, expectedAsset?.id, description)
+                XCTAssertEqual(asset?.languageCode, expectedAsset?.languageCode, description)
+                XCTAssertEqual(asset?.textHtml, expectedAsset?.textHtml, description)
+                XCTAssertEqual(asset?.countryCode, expectedAsset?.countryCode, description)
+                XCTAssertEqual(asset?.startDate, expectedAsset?.startDate, description)
+                XCTAssertEqual(asset?.endDate, expectedAsset?.endDate, description)
+                XCTAssertEqual(asset?.actions.map { $0.url }, expectedAsset?.actions.map { $0.url }, description)
+            }
+        }
+    }
+
+    func testIntervalTreeMatchesLinearSearch() {
+        var generator = WMFSeededRandomNumberGenerator(seed: 1_000)
+
+        for count in [0, 1, 2, 3, 7, 64, 1_000] {
+            let intervals: [WMFCampaignIntervalTree.Interval] = (0..<count).map { campaignIndex in
+                let start = Int.random(in: 0..<1_000, using: &generator)
+                let end = start + Int.random(in: 0..<100, using: &generator)
+                return WMFCampaignIntervalTree.Interval(startDate: Date(timeIntervalSince1970: TimeInterval(start)), endDate: Date(timeIntervalSince1970: TimeInterval(end)), campaignIndex: campaignIndex)
+            }
+            let tree = WMFCampaignIntervalTree(intervals: intervals.shuffled(using: &generator))
+
+            for time in -1...1_101 {
+                let date = Date(timeIntervalSince1970: TimeInterval(time))
+                let expectedCampaignIndex = intervals.first { $0.startDate <= date && date <= $0.endDate }?.campaignIndex
+                XCTAssertEqual(tree.firstCampaignIndex(containing: date), expectedCampaignIndex, "\(count) intervals at \(time)")
+            }
+        }
+    }
+
+    /// The linear scan the eligibility index replaced: filter configs by country and date, then take the first with language or language variant text
+    private func scannedAsset(response: WMFFundraisingCampaignConfigResponse, countryCode: String, languageCode: String, languageVariantCode: String?, date: Date) -> WMFFundraisingCampaignConfig.WMFAsset? {
+        let dateFormatter = DateFormatter.mediaWikiAPIDateFormatter
+
+        for config in response.configs {
+            guard config.countryCodes.contains(countryCode),
+                  let startDate = dateFormatter.date(from: config.startTimeString),
+                  let endDate = dateFormatter.date(from: config.endTimeString),
+                  (startDate...endDate).contains(date) else {
+                continue
+            }
+
+            let assetLanguageCode: String
+            if config.assets[languageCode] != nil {
+                assetLanguageCode = languageCode
+            } else if let languageVariantCode, config.assets[languageVariantCode] != nil {
+                assetLanguageCode = languageVariantCode
+            } else {
+                continue
+            }
+
+            let asset = config.assets[assetLanguageCode]!
+            let actions = asset.actions.map { action in
+                WMFFundraisingCampaignConfig.WMFAsset.WMFAction(title: action.title, url: action.urlString.flatMap { URL(string: $0.replacingOccurrences(of: "$platform;", with: "iOS")) })
+            }
+            return WMFFundraisingCampaignConfig.WMFAsset(id: config.id, textHtml: asset.text, footerHtml: asset.footer, actions: actions, countryCode: countryCode, currencyCode: asset.currencyCode, startDate: startDate, endDate: endDate, languageCode: assetLanguageCode)
+        }
+
+        return nil
+    }
 }
@@ -0,0 +1,203 @@
+import XCTest
+@testable import WMFData
+@testable import WMFDataMocks
+
+final class WMFImageDataControllerTests: XCTestCase {
+
+    private var service: WMFMockImageService!
+    private var temporaryDirectory: URL!
+
+    override func setUp() async throws {
+        service = WMFMockImageService()
+        temporaryDirectory = FileManager.default.temporaryDirectory.appendingPathComponent(UUID().uuidString)
+        try await super.setUp()
+    }
+
+    override func tearDown() async throws {
+        try? FileManager.default.removeItem(at: temporaryDirectory)
+        try await super.tearDown()
+    }
+
+    private func thumbnailURL(name: String, width: Int) -> URL {
+        return URL(string: "https://upload.wikimedia.org/wikipedia/commons/thumb/a/ab/\(name).jpg/\(width)px-\(name).jpg")!
+    }
+
+    private func fetch(_ url: URL, controller: WMFImageDataController) async -> Result<Data, Error> {
+        return await withCheckedContinuation { continuation in
+            controller.fetchImageData(url: url) { result in
+                continuation.resume(returning: result)
+            }
+        }
+    }
+
+    /// Calls `fetchImageData` for each URL from many threads at once
+    private func fetchConcurrently(_ urls: [URL], controller: WMFImageDataController) -> [URL: [Result<Data, Error>]] {
+        let lock = NSLock()
+        var results: [URL: [Result<Data, Error>]] = [:]
+        let expectation = expectation(description: "Fetched image data")
+        expectation.expectedFulfillmentCount = urls.count
+
+        DispatchQueue.concurrentPerform(iterations: urls.count) { index in
+            let url = urls[index]
+            controller.fetchImageData(url: url) { result in
+                lock.lock()
+                results[url, default: []].append(result)
+                lock.unlock()
+                expectation.fulfill()
+            }
+        }
+
+        wait(for: [expectation], timeout: 10)
+        return results
+    }
+
+    func testConcurrentCallersShareOneRequest() throws {
+        let controller = WMFImageDataController(basicService: service, imageCache: WMFImageDataCache())
+        let url = thumbnailURL(name: "Cat", width: 120)
+
+        let results = fetchConcurrently(Array(repeating: url, count: 1_000), controller: controller)
+
+        XCTAssertEqual(service.requestCount(url: url), 1)
+        XCTAssertEqual(results[url]?.count, 1_000)
+        for result in results[url] ?? [] {
+            XCTAssertEqual(try result.get(), service.data(url: url))
+        }
+    }
+
+    func testConcurrentCallersForManyImages() throws {
+        let controller = WMFImageDataController(basicService: service, imageCache: WMFImageDataCache())
+        let urls = (0..<20).map { thumbnailURL(name: "Image_\($0)", width: 120) }
+
+        let results = fetchConcurrently((0..<1_000).map { urls[$0 % urls.count] }, controller: controller)
+
+        XCTAssertEqual(service.requestCount, urls.count)
+        for url in urls {
+            XCTAssertEqual(results[url]?.count, 50)
+            XCTAssertEqual(try results[url]?.first?.get(), service.data(url: url))
+        }
+    }
+
+    func testFailedRequestsAreNotCached() throws {
+        let controller = WMFImageDataController(basicService: service, imageCache: WMFImageDataCache())
+        let url = thumbnailURL(name: "Dog", width: 120)
+        service.setFailing(true, url: url)
+
+        let results = fetchConcurrently(Array(repeating: url, count: 100), controller: controller)
+        XCTAssertEqual(service.requestCount(url: url), 1)
+        XCTAssertEqual(results[url]?.filter { (try? $0.get()) == nil }.count, 100)
+
+        service.setFailing(false, url: url)
+        let retryResults = fetchConcurrently([url], controller: controller)
+        XCTAssertEqual(try retryResults[url]?.first?.get(), service.data(url: url))
+        XCTAssertEqual(service.requestCount(url: url), 2)
+    }
+
+    func testMemoryCacheEvictsLeastRecentlyUsedImages() async throws {
+        let controller = WMFImageDataController(basicService: service, imageCache: WMFImageDataCache(memoryCapacity: 3_500))
+        let urls = (0..<4).map { thumbnailURL(name: "Image_\($0)", width: 120) }
+
+        for url in urls.prefix(3) {
+            _ = await fetch(url, controller: controller)
+        }
+
+        // Use the first image so the second is the least recently used
+        _ = await fetch(urls[0], controller: controller)
+        XCTAssertEqual(service.requestCount, 3)
+
+        _ = await fetch(urls[3], controller: controller)
+        XCTAssertEqual(service.requestCount, 4)
+
+        _ = await fetch(urls[0], controller: controller)
+        _ = await fetch(urls[2], controller: controller)
+        XCTAssertEqual(service.requestCount, 4, "The most recently used images should still be cached")
+
+        _ = await fetch(urls[1], controller: controller)
+        XCTAssertEqual(service.requestCount(url: urls[1]), 2, "The least recently used image should have been evicted")
+    }
+
+    func testImagesLargerThanMemoryCapacityAreNotCached() async throws {
+        let controller = WMFImageDataController(basicService: service, imageCache: WMFImageDataCache(memoryCapacity: 500))
+        let url = thumbnailURL(name: "Large", width: 120)
+
+        _ = await fetch(url, controller: controller)
+        let result = await fetch(url, controller: controller)
+
+        XCTAssertEqual(try result.get(), service.data(url: url))
+        XCTAssertEqual(service.requestCount(url: url), 2)
+    }
+
+    func testLargerThumbnailSatisfiesSmallerWidth() async throws {
+        let controller = WMFImageDataController(basicService: service, imageCache: WMFImageDataCache())
+        let largeURL = thumbnailURL(name: "Bird", width: 640)
+
+        _ = await fetch(largeURL, controller: controller)
+
+        let smallResult = await fetch(thumbnailURL(name: "Bird", width: 120), controller: controller)
+        XCTAssertEqual(try smallResult.get(), service.data(url: largeURL))
+        XCTAssertEqual(service.requestCount, 1)
+
+        _ = await fetch(thumbnailURL(name: "Bird", width: 1280), controller: controller)
+        _ = await fetch(thumbnailURL(name: "Fish", width: 120), controller: controller)
+        XCTAssertEqual(service.requestCount, 3, "Larger widths and other images should be requested")
+
+        // Original files aren't thumbnails, so they're only used for their own URL
+        let originalURL = URL(string: "https://upload.wikimedia.org/wikipedia/commons/a/ab/Bird.jpg")!
+        _ = await fetch(originalURL, controller: controller)
+        XCTAssertEqual(service.requestCount(url: originalURL), 1)
+    }
+
+    func testThumbnailKeys() {
+        let thumbnailKey = WMFImageDataCache.Key(url: thumbnailURL(name: "Bird", width: 640))
+        XCTAssertEqual(thumbnailKey.imageID, "https://upload.wikimedia.org/wikipedia/commons/thumb/a/ab/Bird.jpg/")
+        XCTAssertEqual(thumbnailKey.width, 640)
+        XCTAssertEqual(thumbnailKey.usableWidths(from: [120, 1280, 640, 960]), [640, 960, 1280])
+
+        let pageKey = WMFImageDataCache.Key(url: URL(string: "https://upload.wikimedia.org/wikipedia/commons/thumb/a/ab/Book.pdf/page2-640px-Book.pdf.jpg")!)
+        XCTAssertNil(pageKey.width, "Thumbnails of other pages aren't interchangeable")
+
+        let originalKey = WMFImageDataCache.Key(url: URL(string: "https://upload.wikimedia.org/wikipedia/commons/a/ab/Bird.jpg")!)
+        XCTAssertNil(originalKey.width)
+        XCTAssertEqual(originalKey.usableWidths(from: [640]), [])
+    }
+
+    func testDiskCacheIsSharedBetweenLaunches() async throws {
+        let url = thumbnailURL(name: "Horse", width: 640)
+        let cache = WMFImageDataCache(directoryURL: temporaryDirectory)
+        _ = await fetch(url, controller: WMFImageDataController(basicService: service, imageCache: cache))
+        cache.waitForDiskQueue()
+
+        let relaunchedController = WMFImageDataController(basicService: service, imageCache: WMFImageDataCache(directoryURL: temporaryDirectory))
+        let result = await fetch(url, controller: relaunchedController)
+        XCTAssertEqual(try result.get(), service.data(url: url))
+
+        let smallResult = await fetch(thumbnailURL(name: "Horse", width: 320), controller: relaunchedController)
+        XCTAssertEqual(try smallResult.get(), service.data(url: url))
+        XCTAssertEqual(service.requestCount, 1)
+
+        let fileNames = try FileManager.default.contentsOfDirectory(atPath: temporaryDirectory.path)
+        XCTAssertEqual(fileNames.count, 1)
+        XCTAssertFalse(fileNames[0].contains("Horse"), "File names should be hashed")
+    }
+
+    func testDiskCacheStaysWithinQuota() async throws {
+        let cache = WMFImageDataCache(memoryCapacity: 0, directoryURL: temporaryDirectory, diskCapacity: 2_500)
+        let controller = WMFImageDataController(basicService: service, imageCache: cache)
+        let urls = (0..<3).map { thumbnailURL(name: "Image_\($0)", width: 120) }
+
+        for url in urls {
+            _ = await fetch(url, controller: controller)
+            cache.waitForDiskQueue()
+            // Distinct access dates
+            try await Task.sleep(nanoseconds: 10_000_000)
+        }
+
+        XCTAssertEqual(try FileManager.default.contentsOfDirectory(atPath: temporaryDirectory.path).count, 2)
+
+        // The oldest image was removed
+        _ = await fetch(urls[1], controller: controller)
+        _ = await fetch(urls[2], controller: controller)
+        XCTAssertEqual(service.requestCount, 3)
+        _ = await fetch(urls[0], controller: controller)
+        XCTAssertEqual(service.requestCount(url: urls[0]), 2)
+    }
+}
@@ -0,0 +1,83 @@
+import XCTest
+@testable import WMFData
+
+/// Behavior expected of every `WMFKeyValueStore`. Subclass and override `makeStore()` to run these tests against a store.
+class WMFKeyValueStoreConformanceTests: XCTestCase {
+
+    struct Fixture: Codable, Equatable {
+        let id: Int
+        let title: String
+        let tags: [String]
+        let date: Date?
+    }
+
+    /// Returns a new, empty store. Tests are skipped when this returns nil.
+    func makeStore() throws -> WMFKeyValueStore? {
+        return nil
+    }
+
+    private func store() throws -> WMFKeyValueStore {
+        guard let store = try makeStore() else {
+            throw XCTSkip("No store to test")
+        }
+        return store
+    }
+
+    func testMissingKeyLoadsNil() throws {
+        let store = try store()
+        let value: String? = try store.load(key: "Missing")
+        XCTAssertNil(value)
+    }
+
+    func testRoundTrips() throws {
+        let store = try store()
+        let fixture = Fixture(id: 1, title: "Earth", tags: ["planet", "home"], date: Date(timeIntervalSince1970: 1_700_000_000))
+
+        try store.save(key: "String", value: "Moon")
+        try store.save(key: "Int", value: 42)
+        try store.save(key: "Fixture", value: fixture)
+        try store.save(key: "Array", value: [fixture, fixture])
+
+        XCTAssertEqual(try store.load(key: "String"), "Moon")
+        XCTAssertEqual(try store.load(key: "Int"), 42)
+        XCTAssertEqual(try store.load(key: "Fixture"), fixture)
+        XCTAssertEqual(try store.load(key: "Array"), [fixture, fixture])
+    }
+
+    func testOverwrite() throws {
+        let store = try store()
+        try store.save(key: "Title", value: "Earth")
+        try store.save(key: "Title", value: "Mars")
+        XCTAssertEqual(try store.load(key: "Title"), "Mars")
+    }
+
+    func testRemove() throws {
+        let store = try store()
+        try store.save(key: "Title", value: "Earth")
+        try store.remove(key: "Title")
+
+        let value: String? = try store.load(key: "Title")
+        XCTAssertNil(value)
+
+        try store.save(key: "Title", value: "Venus")
+        XCTAssertEqual(try store.load(key: "Title"), "Venus", "Keys should be reusable after removal")
+    }
+
+    func testTwoComponentKeys() throws {
+        let store = try store()
+        try store.save(key: "Watchlists", "en", value: 1)
+        try store.save(key: "Watchlists", "es", value: 2)
+
+        XCTAssertEqual(try store.load(key: "Watchlists", "en"), 1)
+        XCTAssertEqual(try store.load(key: "Watchlists", "es"), 2)
+    }
+
+    func testMismatchedTypeDoesNotLoad() throws {
+        let store = try store()
+        try store.save(key: "Count", value: 42)
+
+        let value: Fixture? = try? store.load(key: "Count")
+        XCTAssertNil(value)
+        XCTAssertEqual(try store.load(key: "Count"), 42, "A mismatched load shouldn't affect the stored value")
+    }
+}
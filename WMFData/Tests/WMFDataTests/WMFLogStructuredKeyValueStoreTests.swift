@@ -0,0 +1,180 @@
+import XCTest
+@testable import WMFData
+@testable import WMFDataMocks
+
+final class WMFLogStructuredKeyValueStoreTests: WMFKeyValueStoreConformanceTests {
+
+    private var temporaryDirectory: URL!
+
+    private var fileURL: URL {
+        return temporaryDirectory.appendingPathComponent("Store.log")
+    }
+
+    override func setUp() async throws {
+        temporaryDirectory = FileManager.default.temporaryDirectory.appendingPathComponent(UUID().uuidString)
+        try await super.setUp()
+    }
+
+    override func tearDown() async throws {
+        try? FileManager.default.removeItem(at: temporaryDirectory)
+        try await super.tearDown()
+    }
+
+    override func makeStore() throws -> WMFKeyValueStore? {
+        return try WMFLogStructuredKeyValueStore(fileURL: fileURL)
+    }
+
+    func testValuesPersistAcrossInstances() throws {
+        let store = try WMFLogStructuredKeyValueStore(fileURL: fileURL)
+        try store.save(key: "Donor Experience", "Config", value: ["A", "B"])
+        try store.save(key: "Title", value: "Earth")
+        try store.remove(key: "Title")
+
+        let reopenedStore = try WMFLogStructuredKeyValueStore(fileURL: fileURL)
+        XCTAssertEqual(try reopenedStore.load(key: "Donor Experience", "Config"), ["A", "B"])
+        let title: String? = try reopenedStore.load(key: "Title")
+        XCTAssertNil(title)
+    }
+
+    func testTornRecordIsIgnoredAndOverwritten() throws {
+        let store = try WMFLogStructuredKeyValueStore(fileURL: fileURL)
+        try store.save(key: "Title", value: "Earth")
+        let length = store.fileLength
+
+        // A writer that stopped partway through a record
+        let fileHandle = try FileHandle(forWritingTo: fileURL)
+        try fileHandle.seekToEnd()
+        try fileHandle.write(contentsOf: Data([1, 5, 0, 0, 0, 200, 0]))
+        try fileHandle.close()
+
+        let reopenedStore = try WMFLogStructuredKeyValueStore(fileURL: fileURL)
+        XCTAssertEqual(try reopenedStore.load(key: "Title"), "Earth")
+        XCTAssertEqual(reopenedStore.fileLength, length)
+
+        try reopenedStore.save(key: "Count", value: 1)
+        XCTAssertEqual(try WMFLogStructuredKeyValueStore(fileURL: fileURL).load(key: "Count"), 1)
+        XCTAssertEqual(try WMFLogStructuredKeyValueStore(fileURL: fileURL).load(key: "Title"), "Earth")
+    }
+
+    func testRecordFailingChecksumIsIgnored() throws {
+        let store = try WMFLogStructuredKeyValueStore(fileURL: fileURL)
+        try store.save(key: "Title", value: "Earth")
+        try store.save(key: "Title", value: "Mars")
+
+        var data = try Data(contentsOf: fileURL)
+        data[data.count - 2] ^= 0xFF
+        try data.write(to: fileURL)
+
+        let reopenedStore = try WMFLogStructuredKeyValueStore(fileURL: fileURL)
+        XCTAssertEqual(try reopenedStore.load(key: "Title"), "Earth")
+    }
+
+    func testUnreadableFileStartsEmpty() throws {
+        try FileManager.default.createDirectory(at: temporaryDirectory, withIntermediateDirectories: true)
+        try Data("Not a log".utf8).write(to: fileURL)
+
+        let store = try WMFLogStructuredKeyValueStore(fileURL: fileURL)
+        let title: String? = try store.load(key: "Title")
+        XCTAssertNil(title)
+
+        try store.save(key: "Title", value: "Earth")
+        XCTAssertEqual(try WMFLogStructuredKeyValueStore(fileURL: fileURL).load(key: "Title"), "Earth")
+    }
+
+    func testCompactionKeepsLiveValues() throws {
+        let store = try WMFLogStructuredKeyValueStore(fileURL: fileURL)
+        let otherStore = try WMFLogStructuredKeyValueStore(fileURL: fileURL)
+
+        for index in 0..<1_000 {
+            try store.save(key: "Counter", value: index)
+            try store.save(key: "Keys", "\(index % 10)", value: String(repeating: "x", count: index))
+        }
+        try store.save(key: "Removed", value: true)
+        try store.remove(key: "Removed")
+
+        try store.compactNow()
+
+        // Only the latest record of each of the 11 live keys remains
+        XCTAssertLessThan(store.fileLength, 12_000)
+
+        XCTAssertEqual(try store.load(key: "Counter"), 999)
+        XCTAssertEqual(try store.load(key: "Keys", "3"), String(repeating: "x", count: 993))
+        let removed: Bool? = try store.load(key: "Removed")
+        XCTAssertNil(removed)
+
+        // Other instances pick up the compacted file
+        XCTAssertEqual(try otherStore.load(key: "Counter"), 999)
+        XCTAssertEqual(try otherStore.load(key: "Keys", "9"), String(repeating: "x", count: 999))
+        try otherStore.save(key: "Counter", value: 1_000)
+        XCTAssertEqual(try store.load(key: "Counter"), 1_000)
+    }
+
+    func testInstancesSeeEachOthersWrites() throws {
+        let store = try WMFLogStructuredKeyValueStore(fileURL: fileURL)
+        let otherStore = try WMFLogStructuredKeyValueStore(fileURL: fileURL)
+
+        try store.save(key: "Title", value: "Earth")
+        XCTAssertEqual(try otherStore.load(key: "Title"), "Earth")
+
+        try otherStore.save(key: "Title", value: "Mars")
+        XCTAssertEqual(try store.load(key: "Title"), "Mars", "Cached values should be replaced by newer records")
+
+        try otherStore.remove(key: "Title")
+        let title: String? = try store.load(key: "Title")
+        XCTAssertNil(title)
+    }
+
+    func testConcurrentWritersDoNotLoseRecords() throws {
+        let stores = try (0..<4).map { _ in try WMFLogStructuredKeyValueStore(fileURL: fileURL) }
+
+        DispatchQueue.concurrentPerform(iterations: 400) { index in
+            try? stores[index % stores.count].save(key: "Key \(index)", value: index)
+        }
+
+        let reopenedStore = try WMFLogStructuredKeyValueStore(fileURL: fileURL)
+        for index in 0..<400 {
+            XCTAssertEqual(try reopenedStore.load(key: "Key \(index)"), index)
+        }
+    }
+
+    func testValuesMigrateFromLegacyStore() throws {
+        let legacyStore = WMFMockKeyValueStore()
+        try legacyStore.save(key: "Watchlists", "en", value: ["Earth"])
+
+        let store = try WMFLogStructuredKeyValueStore(fileURL: fileURL, legacyStore: legacyStore)
+        XCTAssertEqual(try store.load(key: "Watchlists", "en"), ["Earth"])
+
+        // Migrated values no longer need the legacy store
+        let reopenedStore = try WMFLogStructuredKeyValueStore(fileURL: fileURL)
+        XCTAssertEqual(try reopenedStore.load(key: "Watchlists", "en"), ["Earth"])
+
+        try store.remove(key: "Watchlists", "en")
+        let legacyValue: [String]? = try legacyStore.load(key: "Watchlists", "en")
+        XCTAssertNil(legacyValue, "Removals should also apply to the legacy store")
+    }
+
+    func testLegacyStoreIsCheckedOncePerKey() throws {
+        let legacyStore = WMFMockKeyValueStore()
+        let store = try WMFLogStructuredKeyValueStore(fileURL: fileURL, legacyStore: legacyStore)
+        let missingValue: String? = try store.load(key: "Title")
+        XCTAssertNil(missingValue)
+
+        // Later misses don't fall through to the legacy store
+        try legacyStore.save(key: "Title", value: "Earth")
+        let value: String? = try store.load(key: "Title")
+        XCTAssertNil(value)
+    }
+
+    func testUnreadableLogIsReplacedOnLoad() throws {
+        let store = try WMFLogStructuredKeyValueStore(fileURL: fileURL)
+        try store.save(key: "Title", value: "Earth")
+
+        try Data("Not a log".utf8).write(to: fileURL, options: .atomic)
+        let title: String? = try store.load(key: "Title")
+        XCTAssertNil(title)
+
+        try store.save(key: "Title", value: "Mars")
+        let reopenedStore = try WMFLogStructuredKeyValueStore(fileURL: fileURL)
+        XCTAssertEqual(try reopenedStore.load(key: "Title"), "Mars")
+    }
+}
@@ -32,6 +32,8 @@ final class WMFPageViewsDataControllerTests: XCTestCase {
         return todayDate.addingTimeInterval(-dayInSeconds)
     }()
     
+    let originalTimeZone = NSTimeZone.default
+    
     override func setUp() async throws {
         
         let temporaryDirectory = FileManager.default.temporaryDirectory.appendingPathComponent(UUID().uuidString)
@@ -43,6 +45,11 @@ final class WMFPageViewsDataControllerTests: XCTestCase {
         try await super.setUp()
     }
     
+    override func tearDown() async throws {
+        NSTimeZone.default = originalTimeZone
+        try await super.tearDown()
+    }
+    
     func testAddPageView() async throws {
         
         guard let store else {
@@ -150,6 +157,60 @@ final class WMFPageViewsDataControllerTests: XCTestCase {
         XCTAssertEqual(pages!.count, 2)
     }
     
+    func testBulkImportPageViewsDeduplicates() async throws {
+        
+        guard let store else {
+            throw TestsError.missingStore
+        }
+        
+        guard let dataController else {
+            throw TestsError.missingDataController
+        }
+        
+        // Viewed before the import, so the import should reuse its page
+        try await dataController.addPageView(title: "Page 1", namespaceID: 0, project: enProject)
+        
+        // 50k entries across 10k pages in two projects, where every tenth entry repeats the one before it
+        var importRequests: [WMFPageViewImportRequest] = []
+        var uniqueViews = Set<String>()
+        var uniquePages = Set<String>(["wikipedia~en~Page_1"])
+        for index in 0..<50_000 {
+            if index % 10 == 9, let previous = importRequests.last {
+                importRequests.append(WMFPageViewImportRequest(title: previous.title, project: previous.project, viewedDate: previous.viewedDate))
+                continue
+            }
+            let pageIndex = (index * 7919) % 10_000
+            let project = pageIndex % 2 == 0 ? enProject : esProject
+            let viewedDate = todayDate.addingTimeInterval(TimeInterval(-index * 60))
+            importRequests.append(WMFPageViewImportRequest(title: "Page \(pageIndex)", project: project, viewedDate: viewedDate))
+            uniqueViews.insert("\(project.coreDataIdentifier)~Page_\(pageIndex)~\(viewedDate.timeIntervalSince1970)")
+            uniquePages.insert("\(project.coreDataIdentifier)~Page_\(pageIndex)")
+        }
+        
+        try await dataController.importPageViews(requests: importRequests)
+        
+        let context = try store.newBackgroundContext
+        let counts: () throws -> (pages: Int, pageViews: Int) = {
+            try context.performAndWait {
+                (try context.count(for: NSFetchRequest<CDPage>(entityName: "CDPage")), try context.count(for: NSFetchRequest<CDPageView>(entityName: "CDPageView")))
+            }
+        }
+        
+        let importedCounts = try counts()
+        XCTAssertEqual(importedCounts.pages, uniquePages.count)
+        XCTAssertEqual(importedCounts.pageViews, uniqueViews.count + 1)
+        
+        // Importing the same history again adds nothing
+        try await dataController.importPageViews(requests: importRequests)
+        let reimportedCounts = try counts()
+        XCTAssertEqual(reimportedCounts.pages, importedCounts.pages)
+        XCTAssertEqual(reimportedCounts.pageViews, importedCounts.pageViews)
+        
+        let pageViewCounts = try dataController.fetchPageViewCounts(startDate: .distantPast, endDate: .distantFuture)
+        XCTAssertEqual(pageViewCounts.reduce(0) { $0 + $1.count }, importedCounts.pageViews)
+        XCTAssertEqual(pageViewCounts.first(where: { $0.page.title == "Page_1" && $0.page.projectID == "wikipedia~en" })?.count, 1)
+    }
+    
     func testFetchPageViewCounts() async throws {
         
         guard let dataController else {
@@ -169,4 +230,236 @@ final class WMFPageViewsDataControllerTests: XCTestCase {
         XCTAssertEqual(results[1].page.title, "Felis_silvestris_catus")
         XCTAssertEqual(results[1].count, 1)
     }
+    
+    // MARK: - Rollups
+    
+    /// Linear congruential generator so failures are reproducible
+    private struct Generator {
+        var state: UInt64
+        
+        mutating func next(_ upperBound: Int) -> Int {
+            state = state &* 6364136223846793005 &+ 1442695040888963407
+            return Int((state >> 33) % UInt64(upperBound))
+        }
+    }
+    
+    private let historyStartDate = Date(timeIntervalSince1970: 1_704_067_200) // 2024-01-01 UTC
+    private let historyDuration = 366 * 86_400
+    
+    private func randomViews(count: Int, generator: inout Generator) -> [WMFPageViewImportRequest] {
+        return (0..<count).map { _ in
+            let project = generator.next(3) == 0 ? esProject : enProject
+            let viewedDate = historyStartDate.addingTimeInterval(TimeInterval(generator.next(historyDuration)))
+            return WMFPageViewImportRequest(title: "Page \(generator.next(2000))", project: project, viewedDate: viewedDate)
+        }
+    }
+    
+    /// Inserts views without going through the data controller, like a store from before rollups existed
+    private func insertViewsDirectly(_ requests: [WMFPageViewImportRequest], store: WMFCoreDataStore) async throws {
+        let backgroundContext = try store.newBackgroundContext
+        try await backgroundContext.perform {
+            var pages: [String: CDPage] = [:]
+            for (index, request) in requests.enumerated() {
+                let title = request.title.normalizedForCoreData
+                let key = "\(request.project.coreDataIdentifier)~\(title)"
+                let page: CDPage
+                if let existingPage = pages[key] {
+                    page = existingPage
+                } else {
+                    page = try store.create(entityType: CDPage.self, in: backgroundContext)
+                    page.title = title
+                    page.namespaceID = 0
+                    page.projectID = request.project.coreDataIdentifier
+                    page.timestamp = request.viewedDate
+                    pages[key] = page
+                }
+                let pageView = try store.create(entityType: CDPageView.self, in: backgroundContext)
+                pageView.page = page
+                pageView.timestamp = request.viewedDate
+                
+                if index % 10_000 == 9_999 {
+                    try store.saveIfNeeded(moc: backgroundContext)
+                }
+            }
+            try store.saveIfNeeded(moc: backgroundContext)
+        }
+    }
+    
+    private func rollupsAreCurrent(store: WMFCoreDataStore) throws -> Bool {
+        let context = try store.newBackgroundContext
+        return try context.performAndWait {
+            try WMFPageViewRollups().isCurrent(in: context)
+        }
+    }
+    
+    private struct RawView {
+        let pageID: String
+        let timestamp: Date
+    }
+    
+    private func fetchRawViews(store: WMFCoreDataStore) throws -> [RawView] {
+        let context = try store.newBackgroundContext
+        return try context.performAndWait {
+            let pageViews = try store.fetch(entityType: CDPageView.self, predicate: nil, fetchLimit: nil, in: context) ?? []
+            return pageViews.compactMap { pageView in
+                guard let page = pageView.page, let projectID = page.projectID, let title = page.title, let timestamp = pageView.timestamp else {
+                    return nil
+                }
+                return RawView(pageID: "\(projectID)~\(page.namespaceID)~\(title)", timestamp: timestamp)
+            }
+        }
+    }
+    
+    private func dateRanges(generator: inout Generator) -> [(Date, Date)] {
+        let calendar = Calendar.current
+        var ranges: [(Date, Date)] = [
+            (historyStartDate.addingTimeInterval(-86_400), historyStartDate.addingTimeInterval(TimeInterval(historyDuration + 86_400))),
+            (calendar.startOfDay(for: historyStartDate.addingTimeInterval(86_400 * 40)), calendar.startOfDay(for: historyStartDate.addingTimeInterval(86_400 * 70))),
+            (historyStartDate.addingTimeInterval(86_400 * 100 + 3_600 * 5), historyStartDate.addingTimeInterval(86_400 * 100 + 3_600 * 20))
+        ]
+        for _ in 0..<5 {
+            let start = historyStartDate.addingTimeInterval(TimeInterval(generator.next(historyDuration)))
+            ranges.append((start, start.addingTimeInterval(TimeInterval(generator.next(120 * 86_400)))))
+        }
+        return ranges
+    }
+    
+    /// Compares every aggregate query with counts computed from the raw views
+    private func assertQueriesMatchRawViews(dataController: WMFPageViewsDataController, store: WMFCoreDataStore, generator: inout Generator, file: StaticString = #filePath, line: UInt = #line) throws {
+        let rawViews = try fetchRawViews(store: store)
+        let calendar = Calendar.current
+        
+        for (startDate, endDate) in dateRanges(generator: &generator) {
+            let viewsInRange = rawViews.filter { $0.timestamp >= startDate && $0.timestamp <= endDate }
+            
+            var expectedPageCounts: [String: Int] = [:]
+            var expectedWeekdayCounts: [Int: Int] = [:]
+            var expectedHourCounts: [Int: Int] = [:]
+            for view in viewsInRange {
+                expectedPageCounts[view.pageID, default: 0] += 1
+                expectedWeekdayCounts[calendar.component(.weekday, from: view.timestamp), default: 0] += 1
+                expectedHourCounts[calendar.component(.hour, from: view.timestamp), default: 0] += 1
+            }
+            
+            let pageCounts = try dataController.fetchPageViewCounts(startDate: startDate, endDate: endDate)
+            XCTAssertEqual(Dictionary(uniqueKeysWithValues: pageCounts.map { ($0.id, $0.count) }), expectedPageCounts, "Page counts from \(startDate) to \(endDate)", file: file, line: line)
+            XCTAssertEqual(pageCounts.map { $0.count }, pageCounts.map { $0.count }.sorted(by: >), "Most viewed pages should be first", file: file, line: line)
+            
+            let weekdayCounts = try dataController.fetchPageViewDates(startDate: startDate, endDate: endDate)
+            XCTAssertEqual(Dictionary(uniqueKeysWithValues: weekdayCounts.map { ($0.day, $0.viewCount) }), expectedWeekdayCounts, "Weekday counts from \(startDate) to \(endDate)", file: file, line: line)
+            
+            let hourCounts = try dataController.fetchPageViewHourCounts(startDate: startDate, endDate: endDate)
+            XCTAssertEqual(hourCounts, expectedHourCounts, "Hour counts from \(startDate) to \(endDate)", file: file, line: line)
+        }
+    }
+    
+    func testRollupsMatchRawViewsAcrossTimeZoneChanges() async throws {
+        
+        guard let store else {
+            throw TestsError.missingStore
+        }
+        
+        guard let dataController else {
+            throw TestsError.missingDataController
+        }
+        
+        var generator = Generator(state: 0x5EED)
+        NSTimeZone.default = try XCTUnwrap(TimeZone(identifier: "America/Los_Angeles"))
+        
+        // A store with history from before rollups existed
+        try await insertViewsDirectly(randomViews(count: 90_000, generator: &generator), store: store)
+        XCTAssertFalse(try rollupsAreCurrent(store: store))
+        try assertQueriesMatchRawViews(dataController: dataController, store: store, generator: &generator)
+        
+        try await dataController.rebuildRollupsIfNeeded()
+        XCTAssertTrue(try rollupsAreCurrent(store: store))
+        try assertQueriesMatchRawViews(dataController: dataController, store: store, generator: &generator)
+        
+        // Imports are added to the rollups incrementally
+        try await dataController.importPageViews(requests: randomViews(count: 4_000, generator: &generator))
+        XCTAssertTrue(try rollupsAreCurrent(store: store))
+        try assertQueriesMatchRawViews(dataController: dataController, store: store, generator: &generator)
+        
+        // Rollups built in another time zone aren't used until they're rebuilt
+        NSTimeZone.default = try XCTUnwrap(TimeZone(identifier: "Asia/Kathmandu"))
+        XCTAssertFalse(try rollupsAreCurrent(store: store))
+        try assertQueriesMatchRawViews(dataController: dataController, store: store, generator: &generator)
+        
+        try await dataController.addPageView(title: "Cat", namespaceID: 0, project: enProject)
+        XCTAssertTrue(try rollupsAreCurrent(store: store))
+        try await dataController.importPageViews(requests: randomViews(count: 3_000, generator: &generator))
+        try assertQueriesMatchRawViews(dataController: dataController, store: store, generator: &generator)
+        
+        NSTimeZone.default = try XCTUnwrap(TimeZone(identifier: "Pacific/Chatham"))
+        try await dataController.importPageViews(requests: randomViews(count: 3_000, generator: &generator))
+        XCTAssertTrue(try rollupsAreCurrent(store: store))
+        try assertQueriesMatchRawViews(dataController: dataController, store: store, generator: &generator)
+        
+        try await dataController.deletePageView(title: "Page 7", namespaceID: 0, project: enProject)
+        try assertQueriesMatchRawViews(dataController: dataController, store: store, generator: &generator)
+    }
+    
+    /// Counts the fetch requests executed in the context
+    private final class FetchCountingContext: NSManagedObjectContext {
+        var fetchCount = 0
+        
+        override func fetch(_ request: NSFetchRequest<NSFetchRequestResult>) throws -> [Any] {
+            fetchCount += 1
+            return try super.fetch(request)
+        }
+    }
+    
+    /// Compares the summary with the separate page count and weekday queries, and the number of fetches each needs
+    private func assertSummaryMatchesSeparateQueries(dataController: WMFPageViewsDataController, store: WMFCoreDataStore, generator: inout Generator, file: StaticString = #filePath, line: UInt = #line) throws {
+        let rawViews = try fetchRawViews(store: store)
+        let calendar = Calendar.current
+        
+        for (startDate, endDate) in dateRanges(generator: &generator) {
+            let separateContext = FetchCountingContext(concurrencyType: .privateQueueConcurrencyType)
+            separateContext.persistentStoreCoordinator = try store.viewContext.persistentStoreCoordinator
+            let pageCounts = try dataController.fetchPageViewCounts(startDate: startDate, endDate: endDate, moc: separateContext)
+            let weekdayCounts = try dataController.fetchPageViewDates(startDate: startDate, endDate: endDate, moc: separateContext)
+            
+            let summaryContext = FetchCountingContext(concurrencyType: .privateQueueConcurrencyType)
+            summaryContext.persistentStoreCoordinator = try store.viewContext.persistentStoreCoordinator
+            let summary = try dataController.fetchPageViewSummary(startDate: startDate, endDate: endDate, moc: summaryContext)
+            
+            XCTAssertEqual(summary.pageViewCounts.map { $0.id }, pageCounts.map { $0.id }, "Pages from \(startDate) to \(endDate)", file: file, line: line)
+            XCTAssertEqual(summary.pageViewCounts.map { $0.count }, pageCounts.map { $0.count }, "Page counts from \(startDate) to \(endDate)", file: file, line: line)
+            XCTAssertEqual(summary.pageViewDays.map { $0.day }, weekdayCounts.map { $0.day }, "Weekdays from \(startDate) to \(endDate)", file: file, line: line)
+            XCTAssertEqual(summary.pageViewDays.map { $0.viewCount }, weekdayCounts.map { $0.viewCount }, "Weekday counts from \(startDate) to \(endDate)", file: file, line: line)
+            
+            let expectedViewedDays = Set(rawViews.filter { $0.timestamp >= startDate && $0.timestamp <= endDate }.map { calendar.startOfDay(for: $0.timestamp) })
+            XCTAssertEqual(summary.viewedDays, expectedViewedDays.sorted(), "Viewed days from \(startDate) to \(endDate)", file: file, line: line)
+            
+            XCTAssertLessThan(summaryContext.fetchCount, separateContext.fetchCount, "Fetches from \(startDate) to \(endDate)", file: file, line: line)
+        }
+    }
+    
+    func testPageViewSummaryMatchesSeparateQueries() async throws {
+        
+        guard let store else {
+            throw TestsError.missingStore
+        }
+        
+        guard let dataController else {
+            throw TestsError.missingDataController
+        }
+        
+        var generator = Generator(state: 0x5A11)
+        NSTimeZone.default = try XCTUnwrap(TimeZone(identifier: "Europe/Berlin"))
+        
+        try await insertViewsDirectly(randomViews(count: 30_000, generator: &generator), store: store)
+        XCTAssertFalse(try rollupsAreCurrent(store: store))
+        try assertSummaryMatchesSeparateQueries(dataController: dataController, store: store, generator: &generator)
+        
+        try await dataController.rebuildRollupsIfNeeded()
+        try await dataController.importPageViews(requests: randomViews(count: 3_000, generator: &generator))
+        XCTAssertTrue(try rollupsAreCurrent(store: store))
+        try assertSummaryMatchesSeparateQueries(dataController: dataController, store: store, generator: &generator)
+        
+        NSTimeZone.default = try XCTUnwrap(TimeZone(identifier: "Australia/Adelaide"))
+        XCTAssertFalse(try rollupsAreCurrent(store: store))
+        try assertSummaryMatchesSeparateQueries(dataController: dataController, store: store, generator: &generator)
+    }
 }
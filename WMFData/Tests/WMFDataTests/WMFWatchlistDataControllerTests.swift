@@ -15,6 +15,7 @@ final class WMFWatchlistDataControllerTests: XCTestCase {
         WMFDataEnvironment.current.mediaWikiService = WMFMockWatchlistMediaWikiService()
         WMFDataEnvironment.current.userDefaultsStore = WMFMockKeyValueStore()
         WMFDataEnvironment.current.sharedCacheStore = WMFMockKeyValueStore()
+        WMFDataEnvironment.current.usernameUtility = { "Test" }
     }
     
     func testAllWatchlistProjects() {
@@ -107,7 +108,10 @@ final class WMFWatchlistDataControllerTests: XCTestCase {
         XCTAssertEqual(wikidataItems.count, 28, "Incorrect number of wikidata watchlist items returned")
         XCTAssertEqual(commonsItems.count, 3, "Incorrect number of commons watchlist items returned")
         
-        let first = watchlistToTest.items.first!
+        XCTAssertEqual(watchlistToTest.items.first?.project, .wikidata, "Items should be sorted newest first across projects")
+        XCTAssertEqual(watchlistToTest.items.map { $0.timestamp }, watchlistToTest.items.map { $0.timestamp }.sorted(by: >), "Items should be sorted newest first across projects")
+        
+        let first = enItems.first!
         XCTAssertEqual(first.title, "Talk:Cat", "Unexpected watchlist item title property")
         XCTAssertEqual(first.username, "CatLover 1137", "Unexpected watchlist item username property")
         XCTAssertEqual(first.revisionID, 1157699533, "Unexpected watchlist item revisionID property")
@@ -274,6 +278,8 @@ final class WMFWatchlistDataControllerTests: XCTestCase {
         
         // First fetch successfully to populate cache
         let controller = WMFWatchlistDataController()
+        // Close enough to the mock changes that none are past the retention window
+        controller.currentDate = { DateFormatter.mediaWikiAPIDateFormatter.date(from: "2023-05-03T00:00:00Z")! }
         
         let expectation1 = XCTestExpectation(description: "Fetch Watchlist with Internet Connection")
         let expectation2 = XCTestExpectation(description: "Fetch Watchlist without Internet Connection")
@@ -0,0 +1,333 @@
+import XCTest
+@testable import WMFData
+@testable import WMFDataMocks
+
+final class WMFWatchlistSyncEngineTests: XCTestCase {
+
+    private let projects: [WMFProject] = ["en", "es", "de", "fr", "ja", "zh", "ru", "it"].map { .wikipedia(WMFLanguage(languageCode: $0, languageVariantCode: nil)) } + [.commons, .wikidata]
+
+    private let parameters = [
+        "action": "query",
+        "list": "watchlist",
+        "wllimit": "25",
+        "wlprop": "ids|title|flags|comment|parsedcomment|timestamp|sizes|user|loginfo",
+        "format": "json",
+        "formatversion": "2"
+    ]
+
+    private var service: WMFMockPagedWatchlistService!
+    private var cacheStore: WMFMockKeyValueStore!
+
+    private let baseDate = Date(timeIntervalSince1970: 1_700_000_000)
+    private let username = "Test User"
+
+    override func setUp() {
+        service = WMFMockPagedWatchlistService()
+        cacheStore = WMFMockKeyValueStore()
+
+        // Projects have different numbers of changes, made in pairs a minute apart, so timestamps are shared within and across projects
+        for (projectIndex, project) in projects.enumerated() {
+            let changeCount = 40 + projectIndex * 23
+            let changes = (0..<changeCount).map { changeIndex in
+                change(project: project, projectIndex: projectIndex, changeIndex: changeIndex, minutesAgo: changeIndex / 2 + projectIndex % 3)
+            }
+            service.setChanges(changes, host: host(for: project))
+        }
+    }
+
+    private func host(for project: WMFProject) -> String {
+        return URL.mediaWikiAPIURL(project: project)?.host ?? ""
+    }
+
+    private func change(project: WMFProject, projectIndex: Int, changeIndex: Int, minutesAgo: Int) -> WMFMockPagedWatchlistService.Change {
+        let timestamp = DateFormatter.mediaWikiAPIDateFormatter.string(from: baseDate.addingTimeInterval(TimeInterval(-60 * minutesAgo)))
+        let revisionID = UInt(1_000_000 * (projectIndex + 1) - changeIndex)
+        // Every tenth change is a log entry, which has no revision ID
+        if changeIndex % 10 == 9 {
+            return WMFMockPagedWatchlistService.Change(title: "\(project.id) Log \(revisionID)", revisionID: 0, logID: revisionID, timestamp: timestamp)
+        }
+        return WMFMockPagedWatchlistService.Change(title: "\(project.id) Page \(revisionID)", revisionID: revisionID, timestamp: timestamp)
+    }
+
+    /// Every change the mock serves, newest first. Changes with the same timestamp are ordered by project, then by the order the project lists them.
+    private func expectedTitles() -> [String] {
+        var changes: [(timestamp: String, projectIndex: Int, changeIndex: Int, title: String)] = []
+        for (projectIndex, project) in projects.enumerated() {
+            for (changeIndex, change) in service.changes(host: host(for: project)).enumerated() {
+                changes.append((change.timestamp, projectIndex, changeIndex, change.title))
+            }
+        }
+        changes.sort { lhs, rhs in
+            if lhs.timestamp != rhs.timestamp {
+                return lhs.timestamp > rhs.timestamp
+            }
+            if lhs.projectIndex != rhs.projectIndex {
+                return lhs.projectIndex < rhs.projectIndex
+            }
+            return lhs.changeIndex < rhs.changeIndex
+        }
+        return changes.map { $0.title }
+    }
+
+    private func makeEngine(cacheStore: WMFKeyValueStore?, maxConcurrentProjects: Int = 4, maxPagesPerProject: Int = 10, retentionInterval: TimeInterval = 30 * 24 * 60 * 60, fullFetchInterval: TimeInterval = 60 * 60) -> WMFWatchlistSyncEngine {
+        let baseDate = self.baseDate
+        return WMFWatchlistSyncEngine(service: service, cacheStore: cacheStore, maxConcurrentProjects: maxConcurrentProjects, maxPagesPerProject: maxPagesPerProject, retentionInterval: retentionInterval, fullFetchInterval: fullFetchInterval, currentDate: { baseDate })
+    }
+
+    /// The projects that were refreshed from their cache, rather than fetched in full
+    private func refreshedProjects() -> [WMFProject] {
+        let requests = service.requests
+        return projects.filter { project in
+            requests.contains { $0.host == host(for: project) && $0.parameters["wlend"] != nil }
+        }
+    }
+
+    private func sync(_ engine: WMFWatchlistSyncEngine) async -> WMFWatchlistSyncEngine.Result {
+        return await engine.sync(projects: projects, username: username, parameters: parameters, replacesOlderRevisions: false)
+    }
+
+    private func assertNoErrors(_ result: WMFWatchlistSyncEngine.Result, file: StaticString = #filePath, line: UInt = #line) {
+        for project in projects {
+            XCTAssertEqual(result.errors[project]?.count, 0, "Unexpected errors for \(project.id)", file: file, line: line)
+        }
+    }
+
+    // MARK: - Tests
+
+    func testSyncPagesEveryProjectAndMergesByTimestamp() async {
+        let engine = makeEngine(cacheStore: cacheStore, maxConcurrentProjects: 3, maxPagesPerProject: 100)
+        let result = await sync(engine)
+
+        assertNoErrors(result)
+        XCTAssertEqual(result.items.map { $0.title }, expectedTitles())
+        XCTAssertEqual(result.items.map { $0.timestamp }, result.items.map { $0.timestamp }.sorted(by: >))
+
+        let expectedRequestCount = projects.reduce(0) { count, project in
+            count + (service.changes(host: host(for: project)).count + 24) / 25
+        }
+        XCTAssertEqual(service.requests.count, expectedRequestCount, "Every page should be requested once")
+        XCTAssertLessThanOrEqual(service.maxInFlightCount, 3, "No more than 3 projects should be fetched at once")
+    }
+
+    func testSyncIsDeterministic() async {
+        let first = await sync(makeEngine(cacheStore: WMFMockKeyValueStore(), maxConcurrentProjects: 10, maxPagesPerProject: 100))
+        let second = await sync(makeEngine(cacheStore: WMFMockKeyValueStore(), maxConcurrentProjects: 1, maxPagesPerProject: 100))
+        XCTAssertEqual(first.items.map { $0.title }, second.items.map { $0.title })
+        XCTAssertEqual(first.items.map { $0.project }, second.items.map { $0.project })
+    }
+
+    func testRefreshRequestsOnlyNewerChanges() async {
+        let engine = makeEngine(cacheStore: cacheStore, maxConcurrentProjects: 4, maxPagesPerProject: 100)
+        _ = await sync(engine)
+
+        // 30 new changes to two projects, a second apart, newest first
+        for projectIndex in [1, 8] {
+            let project = projects[projectIndex]
+            let newChanges = (0..<30).map { index in
+                let timestamp = DateFormatter.mediaWikiAPIDateFormatter.string(from: baseDate.addingTimeInterval(TimeInterval(60 + 30 - index)))
+                return WMFMockPagedWatchlistService.Change(title: "\(project.id) New \(index)", revisionID: UInt(5_000_000 + 100 * projectIndex + 30 - index), timestamp: timestamp)
+            }
+            service.setChanges(newChanges + service.changes(host: host(for: project)), host: host(for: project))
+        }
+        service.removeRequests()
+
+        let result = await sync(engine)
+
+        assertNoErrors(result)
+        XCTAssertEqual(result.items.map { $0.title }, expectedTitles())
+
+        let requests = service.requests
+        XCTAssertEqual(requests.count, projects.count + 2, "Only projects with more than a page of new changes should need more than one request")
+        for project in projects {
+            let projectRequests = requests.filter { $0.host == host(for: project) }
+            XCTAssertFalse(projectRequests.isEmpty)
+            for request in projectRequests {
+                XCTAssertNotNil(request.parameters["wlend"], "Refreshes should only request changes newer than the cached ones")
+            }
+        }
+    }
+
+    func testRefreshWithMoreNewChangesThanPagesDropsOlderCachedChanges() async {
+        let engine = makeEngine(cacheStore: cacheStore, maxConcurrentProjects: 4, maxPagesPerProject: 2)
+        let project = projects[0]
+        service.setChanges(Array(service.changes(host: host(for: project)).prefix(40)), host: host(for: project))
+        let firstResult = await engine.sync(projects: [project], username: username, parameters: parameters, replacesOlderRevisions: false)
+        XCTAssertEqual(firstResult.items.count, 40)
+
+        let newChanges = (0..<60).map { index in
+            let timestamp = DateFormatter.mediaWikiAPIDateFormatter.string(from: baseDate.addingTimeInterval(TimeInterval(120 - index)))
+            return WMFMockPagedWatchlistService.Change(title: "New \(index)", revisionID: UInt(5_000_000 - index), timestamp: timestamp)
+        }
+        service.setChanges(newChanges + service.changes(host: host(for: project)), host: host(for: project))
+
+        let result = await engine.sync(projects: [project], username: username, parameters: parameters, replacesOlderRevisions: false)
+        XCTAssertEqual(result.items.map { $0.title }, newChanges.prefix(50).map { $0.title }, "Cached changes shouldn't be shown after a gap")
+    }
+
+    func testLatestRevisionRefreshReplacesOlderRevisionsOfAPage() async {
+        let engine = makeEngine(cacheStore: cacheStore)
+        let project = projects[0]
+        let olderTimestamp = DateFormatter.mediaWikiAPIDateFormatter.string(from: baseDate)
+        let newerTimestamp = DateFormatter.mediaWikiAPIDateFormatter.string(from: baseDate.addingTimeInterval(60))
+        service.setChanges([
+            WMFMockPagedWatchlistService.Change(title: "Cat", revisionID: 10, timestamp: olderTimestamp),
+            WMFMockPagedWatchlistService.Change(title: "Dog", revisionID: 9, timestamp: olderTimestamp)
+        ], host: host(for: project))
+        _ = await engine.sync(projects: [project], username: username, parameters: parameters, replacesOlderRevisions: true)
+
+        service.setChanges([
+            WMFMockPagedWatchlistService.Change(title: "Cat", revisionID: 11, timestamp: newerTimestamp),
+            WMFMockPagedWatchlistService.Change(title: "Dog", revisionID: 9, timestamp: olderTimestamp)
+        ], host: host(for: project))
+        let result = await engine.sync(projects: [project], username: username, parameters: parameters, replacesOlderRevisions: true)
+
+        XCTAssertEqual(result.items.map { $0.revisionID }, [11, 9])
+    }
+
+    func testCachesAreKeptPerAccount() async {
+        let engine = makeEngine(cacheStore: cacheStore, maxPagesPerProject: 100)
+        _ = await sync(engine)
+        service.removeRequests()
+
+        let otherAccountResult = await engine.sync(projects: projects, username: "Other User", parameters: parameters, replacesOlderRevisions: false)
+        XCTAssertEqual(otherAccountResult.items.map { $0.title }, expectedTitles())
+        XCTAssertEqual(refreshedProjects(), [], "Another account's cache shouldn't be used")
+        service.removeRequests()
+
+        _ = await engine.sync(projects: projects, username: nil, parameters: parameters, replacesOlderRevisions: false)
+        _ = await engine.sync(projects: projects, username: nil, parameters: parameters, replacesOlderRevisions: false)
+        XCTAssertEqual(refreshedProjects(), [], "Nothing should be cached without an account")
+        service.removeRequests()
+
+        _ = await sync(engine)
+        XCTAssertEqual(refreshedProjects(), projects, "Each account's cache should be kept")
+    }
+
+    func testRemovingCachesFetchesInFull() async {
+        let engine = makeEngine(cacheStore: cacheStore, maxPagesPerProject: 100)
+        _ = await sync(engine)
+        service.removeRequests()
+
+        WMFWatchlistSyncEngine.removeCaches(project: projects[2], cacheStore: cacheStore)
+        let result = await sync(engine)
+        assertNoErrors(result)
+        XCTAssertEqual(result.items.map { $0.title }, expectedTitles())
+        XCTAssertEqual(refreshedProjects(), projects.filter { $0 != projects[2] }, "Only the project with watched or unwatched pages should be fetched in full")
+        service.removeRequests()
+
+        WMFWatchlistSyncEngine.removeAllCaches(cacheStore: cacheStore)
+        _ = await sync(engine)
+        XCTAssertEqual(refreshedProjects(), [], "Logging out should remove every cache")
+    }
+
+    func testOldCachesAreFetchedInFull() async {
+        let engine = makeEngine(cacheStore: cacheStore, maxPagesPerProject: 100, fullFetchInterval: 0)
+        _ = await sync(engine)
+        service.removeRequests()
+
+        let result = await sync(engine)
+        assertNoErrors(result)
+        XCTAssertEqual(result.items.map { $0.title }, expectedTitles())
+        XCTAssertEqual(refreshedProjects(), [], "Pages watched or unwatched elsewhere should be picked up by a full fetch")
+    }
+
+    func testChangesPastRetentionAreNotCached() async {
+        let retentionInterval: TimeInterval = 10 * 60
+        let engine = makeEngine(cacheStore: cacheStore, maxPagesPerProject: 100, retentionInterval: retentionInterval)
+        _ = await sync(engine)
+
+        for project in projects {
+            service.injectFailure(NSError(domain: NSURLErrorDomain, code: NSURLErrorNotConnectedToInternet), host: host(for: project))
+        }
+        let cachedResult = await sync(engine)
+
+        let retentionStartString = DateFormatter.mediaWikiAPIDateFormatter.string(from: baseDate.addingTimeInterval(-retentionInterval))
+        let retainedTitles = Set(projects.flatMap { service.changes(host: host(for: $0)) }.filter { $0.timestamp >= retentionStartString }.map { $0.title })
+        XCTAssertFalse(retainedTitles.isEmpty)
+        XCTAssertEqual(cachedResult.items.map { $0.title }, expectedTitles().filter { retainedTitles.contains($0) })
+    }
+
+    func testInjectedFailures() async {
+        let engine = makeEngine(cacheStore: cacheStore, maxConcurrentProjects: 4, maxPagesPerProject: 100)
+        let serverErrorProject = projects[3]
+        let noConnectionProject = projects[5]
+        service.injectFailure(WMFServiceError.invalidHttpResponse(500), host: host(for: serverErrorProject), pageOffset: 50)
+        service.injectFailure(NSError(domain: NSURLErrorDomain, code: NSURLErrorNotConnectedToInternet), host: host(for: noConnectionProject))
+
+        let failedResult = await sync(engine)
+
+        XCTAssertEqual(failedResult.errors[serverErrorProject]?.count, 1)
+        XCTAssertEqual(failedResult.errors[noConnectionProject]?.count, 1, "Projects without a cache should fail without a connection")
+        let failedProjects = [serverErrorProject, noConnectionProject]
+        let failedProjectTitlePrefixes = failedProjects.map { $0.id + " " }
+        let remainingTitles = expectedTitles().filter { title in !failedProjectTitlePrefixes.contains { title.hasPrefix($0) } }
+        XCTAssertEqual(failedResult.items.map { $0.title }, remainingTitles, "Failures shouldn't lose or reorder items from other projects")
+        XCTAssertFalse(failedResult.items.contains { failedProjects.contains($0.project) }, "Partly fetched projects shouldn't return items")
+
+        service.removeFailures()
+        let recoveredResult = await sync(engine)
+        assertNoErrors(recoveredResult)
+        XCTAssertEqual(recoveredResult.items.map { $0.title }, expectedTitles())
+
+        service.injectFailure(NSError(domain: NSURLErrorDomain, code: NSURLErrorNotConnectedToInternet), host: host(for: noConnectionProject))
+        let cachedResult = await sync(engine)
+        assertNoErrors(cachedResult)
+        XCTAssertEqual(cachedResult.items.map { $0.title }, expectedTitles(), "Cached items should be used without a connection")
+    }
+
+    func testConcurrentSyncsDoNotLoseItems() async {
+        let engine = makeEngine(cacheStore: cacheStore, maxConcurrentProjects: 4, maxPagesPerProject: 100)
+        let expectedTitles = self.expectedTitles()
+        let parameters = self.parameters
+        let projects = self.projects
+        let username = self.username
+
+        let results = await withTaskGroup(of: [String].self) { group in
+            for index in 0..<8 {
+                group.addTask {
+                    // Alternate between the same and different parameters, so syncs are both shared and queued
+                    var syncParameters = parameters
+                    syncParameters["wlprop"] = index % 2 == 0 ? parameters["wlprop"] : "ids|title|timestamp"
+                    return await engine.sync(projects: projects, username: username, parameters: syncParameters, replacesOlderRevisions: false).items.map { $0.title }
+                }
+            }
+
+            var results: [[String]] = []
+            for await result in group {
+                results.append(result)
+            }
+            return results
+        }
+
+        XCTAssertEqual(results.count, 8)
+        for result in results {
+            XCTAssertEqual(result, expectedTitles)
+        }
+    }
+
+    func testMergedItemsMatchSortedItems() {
+        let project = projects[0]
+        var itemLists: [[WMFWatchlist.Item]] = []
+        var revisionID: UInt = 1
+        for listIndex in 0..<7 {
+            let itemCount = (listIndex * 37) % 50
+            let list = (0..<itemCount).map { itemIndex -> WMFWatchlist.Item in
+                revisionID += 1
+                let timestamp = baseDate.addingTimeInterval(TimeInterval(-((itemIndex * (listIndex + 3)) / 4)))
+                return WMFWatchlist.Item(title: "\(listIndex)", revisionID: revisionID, oldRevisionID: 0, username: "", isAnon: false, isBot: false, timestamp: timestamp, commentWikitext: "", commentHtml: "", byteLength: 0, oldByteLength: 0, project: project)
+            }
+            itemLists.append(list)
+        }
+
+        let expectedItems = itemLists.joined().enumerated().sorted { lhs, rhs in
+            if lhs.element.timestamp != rhs.element.timestamp {
+                return lhs.element.timestamp > rhs.element.timestamp
+            }
+            return lhs.offset < rhs.offset
+        }.map { $0.element }
+
+        let mergedItems = WMFWatchlistSyncEngine.mergedItems(itemLists)
+        XCTAssertEqual(mergedItems.map { $0.revisionID }, expectedItems.map { $0.revisionID })
+        XCTAssertEqual(WMFWatchlistSyncEngine.mergedItems([]).count, 0)
+    }
+}
@@ -706,4 +706,134 @@ final class WMFWikitextUtilsTests: XCTestCase {
         let result = try WMFWikitextUtils.missingAltTextLinks(text: wikitext, language: "de", targetNamespaces: ["Datei"], targetAltParams: ["alternativtext", "alt"])
         XCTAssertEqual(result.count, 0)
     }
+
+    // MARK: - Range Of Tests
+
+    private struct RangeOfCase {
+        let name: String
+        let textBeforeTargetText: String
+        let targetText: String
+        let textAfterTargetText: String
+        /// Wikitext with the expected range between ⟪ and ⟫
+        let markedWikitext: String
+
+        var htmlInfo: WMFWikitextUtils.HtmlInfo {
+            return WMFWikitextUtils.HtmlInfo(textBeforeTargetText: textBeforeTargetText, targetText: targetText, textAfterTargetText: textAfterTargetText)
+        }
+
+        var wikitext: String {
+            return markedWikitext.replacingOccurrences(of: "⟪", with: "").replacingOccurrences(of: "⟫", with: "")
+        }
+
+        var expectedRange: NSRange {
+            let markedWikitext = markedWikitext as NSString
+            let openRange = markedWikitext.range(of: "⟪")
+            let closeRange = markedWikitext.range(of: "⟫")
+            return NSRange(location: openRange.location, length: closeRange.location - openRange.location - openRange.length)
+        }
+    }
+
+    private let rangeOfCorpus: [RangeOfCase] = [
+        RangeOfCase(name: "links",
+                    textBeforeTargetText: "The cat is the only",
+                    targetText: "domesticated species in the family Felidae",
+                    textAfterTargetText: ". Recent advances in archaeology",
+                    markedWikitext: "The '''cat''' is the only [[Domestication of animals|⟪domesticated]] species in the family [[Felidae⟫]]. Recent advances in [[archaeology]]."),
+        RangeOfCase(name: "bold and italic",
+                    textBeforeTargetText: "The cat (",
+                    targetText: "Felis catus), commonly referred to as the domestic cat",
+                    textAfterTargetText: "or house cat",
+                    markedWikitext: "The '''cat''' ('''''⟪Felis catus'''''), commonly referred to as the '''domestic cat⟫''' or '''house cat'''."),
+        RangeOfCase(name: "template inside selection",
+                    textBeforeTargetText: "Adult cats sleep",
+                    targetText: "12 to 16 hours a day",
+                    textAfterTargetText: ", often in short naps.",
+                    markedWikitext: "Adult cats sleep ⟪12 to 16 hours{{sfn|Smith|2001|p=4}} a day⟫, often in short naps."),
+        RangeOfCase(name: "rendered template",
+                    textBeforeTargetText: "The cat has been",
+                    targetText: "known in Latin as felis since antiquity, and by many other names in the languages of Europe",
+                    textAfterTargetText: ".",
+                    markedWikitext: "The cat has been ⟪known in Latin as {{lang|la|felis}} since antiquity, and by many other names in the languages of Europe⟫."),
+        RangeOfCase(name: "ref",
+                    textBeforeTargetText: "It was domesticated in the Near East",
+                    targetText: "around 7500 BC.[1] Cats are social",
+                    textAfterTargetText: " animals.",
+                    markedWikitext: "It was domesticated in the [[Near East]] ⟪around 7500 [[Before Christ|BC]].<ref name=\"Driscoll\">{{cite journal |last=Driscoll |title=The Near Eastern origin of cat domestication |year=2007}}</ref> Cats are social⟫ animals."),
+        RangeOfCase(name: "self closing ref",
+                    textBeforeTargetText: "The species",
+                    targetText: "catus[2] was described by Linnaeus",
+                    textAfterTargetText: " in 1758.",
+                    markedWikitext: "The species ⟪catus<ref name=\"Linnaeus1758\" /> was described by [[Carl Linnaeus|Linnaeus⟫]] in 1758."),
+        RangeOfCase(name: "comment",
+                    textBeforeTargetText: "",
+                    targetText: "Cats purr loudly when content",
+                    textAfterTargetText: ".",
+                    markedWikitext: "⟪Cats<!-- see talk page before changing --> purr loudly when content⟫."),
+        RangeOfCase(name: "entities",
+                    textBeforeTargetText: "The planet has a mass of",
+                    targetText: "5.9736 kg and a density of 5.515 g",
+                    textAfterTargetText: "/cm3.",
+                    markedWikitext: "The planet has a mass of ⟪5.9736&nbsp;kg and a density of 5.515&nbsp;g⟫/cm<sup>3</sup>."),
+        RangeOfCase(name: "external link",
+                    textBeforeTargetText: "Data is available from the",
+                    targetText: "UCS Satellite Database for researchers",
+                    textAfterTargetText: ".",
+                    markedWikitext: "Data is available from the [https://www.ucsusa.org/resources/satellite-database ⟪UCS Satellite Database] for researchers⟫."),
+        RangeOfCase(name: "repeated text uses context",
+                    textBeforeTargetText: "Finally the",
+                    targetText: "cat sat on the mat",
+                    textAfterTargetText: "again.",
+                    markedWikitext: "The cat sat on the mat. Later, the dog sat on the mat. Finally the ⟪cat sat on the mat⟫ again."),
+        RangeOfCase(name: "emoji before selection",
+                    textBeforeTargetText: "Emoji such as 🐱 and 🐈 are common. The",
+                    targetText: "🐈‍⬛ black cat",
+                    textAfterTargetText: "is another.",
+                    markedWikitext: "Emoji such as 🐱 and 🐈 are common. The ⟪🐈‍⬛ black cat⟫ is another."),
+        RangeOfCase(name: "emoji in link",
+                    textBeforeTargetText: "Fans use",
+                    targetText: "🐈 cat emoji on social media",
+                    textAfterTargetText: " every day.",
+                    markedWikitext: "Fans use [[Emoji|⟪🐈]] cat emoji on [[social media⟫]] every day."),
+        RangeOfCase(name: "arabic",
+                    textBeforeTargetText: "",
+                    targetText: "الأرض هي الكوكب الثالث",
+                    textAfterTargetText: " من حيث البعد عن الشمس",
+                    markedWikitext: "'''⟪الأرض''' هي [[كوكب|الكوكب]] الثالث⟫ من حيث البعد عن [[الشمس]]"),
+        RangeOfCase(name: "chinese",
+                    textBeforeTargetText: "",
+                    targetText: "貓是一種小型食肉哺乳動物",
+                    textAfterTargetText: "。",
+                    markedWikitext: "'''⟪貓'''是一種小型[[食肉目|食肉]]哺乳動物⟫<ref>{{cite web|title=Cat}}</ref>。")
+    ]
+
+    func testRangeOfCorpus() {
+        for rangeOfCase in rangeOfCorpus {
+            let range = WMFWikitextUtils.rangeOf(htmlInfo: rangeOfCase.htmlInfo, inWikitext: rangeOfCase.wikitext)
+            XCTAssertEqual(range, rangeOfCase.expectedRange, "Unexpected range for \(rangeOfCase.name)")
+        }
+    }
+
+    func testRangeOfMissingText() {
+        let htmlInfo = WMFWikitextUtils.HtmlInfo(textBeforeTargetText: "The cat", targetText: "barks at the moon", textAfterTargetText: "")
+        let range = WMFWikitextUtils.rangeOf(htmlInfo: htmlInfo, inWikitext: "The '''cat''' ('''''Felis catus''''') is a small mammal.")
+        XCTAssertEqual(range.location, NSNotFound)
+
+        let emptyHtmlInfo = WMFWikitextUtils.HtmlInfo(textBeforeTargetText: "The cat", targetText: "", textAfterTargetText: "is a small mammal")
+        XCTAssertEqual(WMFWikitextUtils.rangeOf(htmlInfo: emptyHtmlInfo, inWikitext: "The '''cat''' is a small mammal.").location, NSNotFound)
+    }
+
+    func testRangeOfInLongArticle() {
+        // A long article with one case's wikitext in the middle, so most of the text is near misses
+        let filler = "The '''cat''' ('''''Felis catus''''') is the only [[Domestication of animals|domesticated]] species in the family [[Felidae]].<ref name=\"Felidae\">{{Cite book |last=Wozencraft |title=Mammal Species of the World}}</ref> It is valued by humans for companionship and its ability to kill [[vermin]]. "
+        var articleWikitext = ""
+        for _ in 0..<20 {
+            articleWikitext += String(repeating: filler, count: 10) + "\n\n"
+        }
+
+        let rangeOfCase = rangeOfCorpus[2]
+        let wikitext = articleWikitext + rangeOfCase.wikitext + "\n\n" + articleWikitext
+        let expectedRange = NSRange(location: (articleWikitext as NSString).length + rangeOfCase.expectedRange.location, length: rangeOfCase.expectedRange.length)
+
+        XCTAssertEqual(WMFWikitextUtils.rangeOf(htmlInfo: rangeOfCase.htmlInfo, inWikitext: wikitext), expectedRange)
+    }
 }
@@ -3,6 +3,18 @@ import XCTest
 @testable import WMFDataMocks
 import CoreData
 
+fileprivate class WMFMockPopulatingYearInReviewDataController: WMFYearInReviewDataController {
+    var editCountResult: Result<Int, Error> = .success(27)
+    
+    override func shouldPopulateYearInReviewReportData(countryCode: String?, primaryAppLanguageProject: WMFProject?) -> Bool {
+        return true
+    }
+    
+    override func fetchUserContributionsCount(username: String, project: WMFProject?, startDate: String, endDate: String) async throws -> (Int, Bool) {
+        return (try editCountResult.get(), false)
+    }
+}
+
 final class WMFYearInReviewDataControllerTests: XCTestCase {
     
     enum TestError: Error {
@@ -355,4 +367,116 @@ final class WMFYearInReviewDataControllerTests: XCTestCase {
             XCTAssertTrue(shouldShowEntryPoint, "Should show entry point when one personalized slide is enabled.")
         }
     }
+    
+    // MARK: - Population
+    
+    private func populatingDataController(store: WMFCoreDataStore) throws -> WMFMockPopulatingYearInReviewDataController {
+        let slideSettings = WMFFeatureConfigResponse.IOS.YearInReview.SlideSettings(isEnabled: true)
+        let personalizedSlides = WMFFeatureConfigResponse.IOS.YearInReview.PersonalizedSlides(readCount: slideSettings, editCount: slideSettings, donateCount: slideSettings, mostReadDay: slideSettings)
+        let yearInReview = WMFFeatureConfigResponse.IOS.YearInReview(yearID: "2024.2", isEnabled: true, countryCodes: ["FR", "IT"], primaryAppLanguageCodes: ["fr", "it"], dataPopulationStartDateString: "2024-01-01T00:00:00Z", dataPopulationEndDateString: "2024-11-01T00:00:00Z", personalizedSlides: personalizedSlides)
+        let ios = WMFFeatureConfigResponse.IOS(version: 1, yir: [yearInReview])
+        let config = WMFFeatureConfigResponse(ios: [ios])
+        let developerSettingsDataController = WMFMockDeveloperSettingsDataController(featureConfig: config)
+        
+        return try WMFMockPopulatingYearInReviewDataController(coreDataStore: store, developerSettingsDataController: developerSettingsDataController)
+    }
+    
+    /// A year of views over a few hundred pages, the same every run
+    private func importYearOfPageViews(store: WMFCoreDataStore) async throws {
+        var state: UInt64 = 0x2024
+        func next(_ upperBound: Int) -> Int {
+            state = state &* 6364136223846793005 &+ 1442695040888963407
+            return Int((state >> 33) % UInt64(upperBound))
+        }
+        
+        let startDate = Date(timeIntervalSince1970: 1_704_067_200) // 2024-01-01 UTC
+        let requests = (0..<8_000).map { _ in
+            WMFPageViewImportRequest(title: "Page \(next(400))", project: next(4) == 0 ? frProject : enProject, viewedDate: startDate.addingTimeInterval(TimeInterval(next(366 * 86_400))))
+        }
+        
+        try await WMFPageViewsDataController(coreDataStore: store).importPageViews(requests: requests)
+    }
+    
+    private func slide(_ id: WMFYearInReviewPersonalizedSlideID, in report: WMFYearInReviewReport?) throws -> WMFYearInReviewSlide {
+        return try XCTUnwrap(report?.slides.first { $0.id == id }, "Missing \(id) slide")
+    }
+    
+    func testPopulateYearInReviewReportMatchesPageViewQueries() async throws {
+        
+        guard let store else {
+            throw TestError.missingStore
+        }
+        
+        try await importYearOfPageViews(store: store)
+        
+        let pageViewsDataController = try WMFPageViewsDataController(coreDataStore: store)
+        let startDate = try XCTUnwrap(DateFormatter.mediaWikiAPIDateFormatter.date(from: "2024-01-01T00:00:00Z"))
+        let endDate = try XCTUnwrap(DateFormatter.mediaWikiAPIDateFormatter.date(from: "2024-11-01T00:00:00Z"))
+        let expectedReadCount = try pageViewsDataController.fetchPageViewCounts(startDate: startDate, endDate: endDate).count
+        let expectedMostReadDay = try XCTUnwrap(pageViewsDataController.fetchPageViewDates(startDate: startDate, endDate: endDate).max(by: { $0.viewCount < $1.viewCount }))
+        
+        let yearInReviewDataController = try populatingDataController(store: store)
+        let report = try await yearInReviewDataController.populateYearInReviewReportData(for: 2024, countryCode: "FR", primaryAppLanguageProject: frProject, username: "user")
+        
+        let decoder = JSONDecoder()
+        
+        let readCountSlide = try slide(.readCount, in: report)
+        XCTAssertTrue(readCountSlide.evaluated)
+        XCTAssertTrue(readCountSlide.display)
+        XCTAssertEqual(try decoder.decode(Int.self, from: XCTUnwrap(readCountSlide.data)), expectedReadCount)
+        
+        let mostReadDaySlide = try slide(.mostReadDay, in: report)
+        XCTAssertTrue(mostReadDaySlide.evaluated)
+        XCTAssertTrue(mostReadDaySlide.display)
+        let mostReadDay = try decoder.decode(WMFPageViewDay.self, from: XCTUnwrap(mostReadDaySlide.data))
+        XCTAssertEqual(mostReadDay.getDay(), expectedMostReadDay.getDay())
+        XCTAssertEqual(mostReadDay.getViewCount(), expectedMostReadDay.getViewCount())
+        
+        let editCountSlide = try slide(.editCount, in: report)
+        XCTAssertTrue(editCountSlide.evaluated)
+        XCTAssertTrue(editCountSlide.display)
+        XCTAssertEqual(try decoder.decode(Int.self, from: XCTUnwrap(editCountSlide.data)), 27)
+        
+        XCTAssertTrue(try slide(.donateCount, in: report).evaluated)
+        
+        // Evaluated slides aren't populated again
+        let savedReport = try await MainActor.run {
+            try yearInReviewDataController.fetchYearInReviewReport(forYear: 2024)
+        }
+        XCTAssertEqual(try slide(.readCount, in: savedReport).data, readCountSlide.data)
+        XCTAssertEqual(try slide(.mostReadDay, in: savedReport).data, mostReadDaySlide.data)
+    }
+    
+    func testPopulateYearInReviewReportSavesOtherSlidesWhenEditCountFails() async throws {
+        
+        guard let store else {
+            throw TestError.missingStore
+        }
+        
+        try await importYearOfPageViews(store: store)
+        
+        let yearInReviewDataController = try populatingDataController(store: store)
+        yearInReviewDataController.editCountResult = .failure(WMFMockError.unableToPullData)
+        
+        do {
+            try await yearInReviewDataController.populateYearInReviewReportData(for: 2024, countryCode: "FR", primaryAppLanguageProject: frProject, username: "user")
+            XCTFail("Expected the edit count error to be thrown")
+        } catch {
+            XCTAssertEqual(error as? WMFMockError, .unableToPullData)
+        }
+        
+        let savedReport = try await MainActor.run {
+            try yearInReviewDataController.fetchYearInReviewReport(forYear: 2024)
+        }
+        XCTAssertTrue(try slide(.readCount, in: savedReport).evaluated)
+        XCTAssertTrue(try slide(.mostReadDay, in: savedReport).evaluated)
+        XCTAssertTrue(try slide(.donateCount, in: savedReport).evaluated)
+        XCTAssertFalse(try slide(.editCount, in: savedReport).evaluated)
+        
+        // The edit count slide is populated on the next attempt
+        yearInReviewDataController.editCountResult = .success(3)
+        let report = try await yearInReviewDataController.populateYearInReviewReportData(for: 2024, countryCode: "FR", primaryAppLanguageProject: frProject, username: "user")
+        XCTAssertTrue(try slide(.editCount, in: report).evaluated)
+        XCTAssertEqual(try JSONDecoder().decode(Int.self, from: XCTUnwrap(slide(.editCount, in: report).data)), 3)
+    }
 }
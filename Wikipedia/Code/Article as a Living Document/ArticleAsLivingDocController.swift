@@ -49,13 +49,12 @@ class ArticleAsLivingDocController: NSObject {
             
             if let oldModel = _articleAsLivingDocViewModel {
                 // should only be triggered via paging.
-                // update everything except sha and htmlInsert and
-                // append sections instead of replace sections
-                let appendedSections = oldModel.sections + newValue.sections
-                let oldHtmlSnippets = oldModel.articleInsertHtmlSnippets
-                let oldLastUpdatedTimestamp = oldModel.lastUpdatedTimestamp
-                _articleAsLivingDocViewModel = ArticleAsLivingDocViewModel(nextRvStartId: newValue.nextRvStartId, sha: oldModel.sha, sections: appendedSections, summaryText: newValue.summaryText, articleInsertHtmlSnippets: oldHtmlSnippets, lastUpdatedTimestamp: oldLastUpdatedTimestamp)
-                articleAsLivingDocViewController?.appendSections(newValue.sections)
+                // the new page is merged into the last section, which is replaced, and the sections after it are appended
+                let appendedModel = oldModel.appending(newValue)
+                _articleAsLivingDocViewModel = appendedModel
+                let replacesLastSection = !oldModel.sections.isEmpty
+                let changedSections = Array(appendedModel.sections[(replacesLastSection ? oldModel.sections.count - 1 : 0)...])
+                articleAsLivingDocViewController?.appendSections(changedSections, replacingLastSection: replacesLastSection)
             } else {
                 // should only be triggered via pull to refresh or fresh load. update everything
                 _articleAsLivingDocViewModel = newValue
@@ -426,9 +425,13 @@ class ArticleAsLivingDocController: NSObject {
     }
     
     // MARK: Fetcher Methods
-    private let fetcher = SignificantEventsFetcher()
+    private lazy var fetcher: SignificantEventsFetcher = {
+        let fetcher = SignificantEventsFetcher()
+        fetcher.timelineStore = SignificantEventsTimelineStore.shared
+        return fetcher
+    }()
     func fetchArticleAsLivingDocViewModel(rvStartId: UInt? = nil, title: String, siteURL: URL, traitCollection: UITraitCollection, theme: Theme, completion: @escaping ((Result<ArticleAsLivingDocViewModel, Error>) -> Void)) {
-        fetcher.fetchSignificantEvents(rvStartId: rvStartId, title: title, siteURL: siteURL) { (result) in
+        fetcher.fetchSignificantEventsPage(rvStartId: rvStartId, title: title, siteURL: siteURL) { (result) in
             switch result {
             case .failure(let error):
                 DispatchQueue.main.async {
@@ -459,7 +462,8 @@ class ArticleAsLivingDocController: NSObject {
     func fetchNextPage(nextRvStartId: UInt, traitCollection: UITraitCollection, theme: Theme) {
 
         guard let articleTitleAndSiteURL = self.articleTitleAndSiteURL(),
-              shouldAttemptToShowArticleAsLivingDoc else {
+              shouldAttemptToShowArticleAsLivingDoc,
+              !currentFetchRvStartIds.contains(nextRvStartId) else {
             return
         }
 
@@ -17,6 +17,7 @@ final class ArticleCacheDBWriter: ArticleCacheResourceDBWriting {
     
     let articleFetcher: ArticleFetcher
     let context: NSManagedObjectContext
+    let writeBehindQueue: CacheDBWriteBehindQueue
     let imageController: ImageCacheController
     let imageInfoFetcher: MWKImageInfoFetcher
     
@@ -31,6 +32,7 @@ final class ArticleCacheDBWriter: ArticleCacheResourceDBWriting {
         
         self.articleFetcher = articleFetcher
         self.context = cacheBackgroundContext
+        self.writeBehindQueue = CacheDBWriteBehindQueue(context: cacheBackgroundContext)
         self.imageController = imageController
         self.imageInfoFetcher = imageInfoFetcher
    }
@@ -124,29 +126,21 @@ final class ArticleCacheDBWriter: ArticleCacheResourceDBWriting {
         }
         
         let variant = fetcher.variantForURLRequest(urlRequest)
-    
-        context.perform {
-            guard let cacheItem = CacheDBWriterHelper.cacheItem(with: itemKey, variant: nil, in: self.context) else {
-                completion(.failure(CacheDBWritingMarkDownloadedError.cannotFindCacheItem))
-                return
+        let varyHeaderValue = response?.allHeaderFields[HTTPURLResponse.varyHeaderKey] as? String ?? nil
+        let variesOnLanguage = varyHeaderValue?.contains(HTTPURLResponse.acceptLanguageHeaderValue) ?? false
+        
+        writeBehindQueue.enqueue(dedupeKey: CacheDBWriteBehindQueue.markDownloadedDedupeKey(itemKey: itemKey, variant: variant), operation: { (context) in
+            // Items are added without a variant. It's set below the first time a response varies on language.
+            let variantCacheItem = variant.flatMap { CacheDBWriterHelper.cacheItem(with: itemKey, variant: $0, in: context) }
+            guard let cacheItem = variantCacheItem ?? CacheDBWriterHelper.cacheItem(with: itemKey, variant: nil, in: context) else {
+                throw CacheDBWritingMarkDownloadedError.cannotFindCacheItem
             }
             cacheItem.isDownloaded = true
-                        
-            let varyHeaderValue = response?.allHeaderFields[HTTPURLResponse.varyHeaderKey] as? String ?? nil
-            let variesOnLanguage = varyHeaderValue?.contains(HTTPURLResponse.acceptLanguageHeaderValue) ?? false
+            
             if variesOnLanguage {
                 cacheItem.variant = variant
             }
-            
-            CacheDBWriterHelper.save(moc: self.context) { (result) in
-                switch result {
-                case .success:
-                    completion(.success)
-                case .failure(let error):
-                    completion(.failure(error))
-                }
-            }
-        }
+        }, completion: completion)
     }
     
     func shouldDownloadVariant(itemKey: CacheController.ItemKey, variant: String?) -> Bool {
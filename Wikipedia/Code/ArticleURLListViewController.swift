@@ -7,7 +7,7 @@ class ArticleURLListViewController: ArticleCollectionViewController {
 
     required init(articleURLs: [URL], dataStore: MWKDataStore, contentGroup: WMFContentGroup? = nil, theme: Theme) {
         self.articleURLs = articleURLs
-        self.articleKeys = Set<String>(articleURLs.compactMap { $0.wmf_databaseKey })
+        self.articleKeys = Set<String>(NSURL.wmf_databaseKeys(for: articleURLs))
         super.init()
         self.contentGroup = contentGroup
         self.contentGroupIDURIString = contentGroup?.objectID.uriRepresentation().absoluteString
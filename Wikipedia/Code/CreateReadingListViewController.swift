@@ -369,7 +369,7 @@ private extension CreateReadingListViewController {
             return
         }
 
-        let keys = articleURLs.compactMap { $0.wmf_inMemoryKey }
+        let keys = NSURL.wmf_inMemoryKeys(for: articleURLs)
 
         let articleFetcher = ArticleFetcher()
         articleFetcher.fetchArticleSummaryResponsesForArticles(withKeys: keys) { result in
@@ -35,6 +35,9 @@ class DiffController {
     let type: DiffContainerViewModel.DiffType
     private weak var revisionRetrievingDelegate: DiffRevisionRetrieving?
     let transformer: DiffTransformer
+    
+    // Diffs of long articles can take a while to transform. Keep it off the main thread and off the network callback queue.
+    private let transformQueue = DispatchQueue(label: "org.wikipedia.diff.transform", qos: .userInitiated)
 
     init(siteURL: URL, diffFetcher: DiffFetcher = DiffFetcher(), pageHistoryFetcher: PageHistoryFetcher?, revisionRetrievingDelegate: DiffRevisionRetrieving?, type: DiffContainerViewModel.DiffType, articleSummaryController: ArticleSummaryController, authenticationManager: WMFAuthenticationManager) {
 
@@ -285,12 +288,12 @@ class DiffController {
             switch result {
             case .success(let diffResponse):
 
-                do {
-                    let viewModels = try self.transformer.viewModels(from: diffResponse, theme: theme, traitCollection: traitCollection)
+                self.transformQueue.async {
+                    let transformer = self.transformer
+                    let groups = DiffTransformer.groups(from: diffResponse, type: transformer.type)
+                    let viewModels = transformer.viewModels(from: groups, theme: theme, traitCollection: traitCollection)
 
                     completion(.success(viewModels))
-                } catch let error {
-                    completion(.failure(error))
                 }
             case .failure(let error):
                 completion(.failure(error))
@@ -14,20 +14,35 @@ final class DiffListChangeItemViewModel {
     private(set) var hasShadedBackgroundView: Bool
     private(set) var inBetweenSpacing: CGFloat?
 
-    var theme: Theme {
-        didSet {
-            textAttributedString = DiffListChangeItemViewModel.calculateAttributedString(with: text, highlightedRanges: highlightedRanges, traitCollection: traitCollection, theme: theme, type: type, diffItemType: diffItemType, moveInfo: moveInfo, semanticContentAttribute: semanticContentAttribute)
-        }
+    var theme: Theme
+    var traitCollection: UITraitCollection
+    
+    private struct AttributedStringKey: Hashable {
+        let themeName: String
+        let contentSizeCategory: UIContentSizeCategory
     }
     
-    var traitCollection: UITraitCollection {
-        didSet {
-            textAttributedString = DiffListChangeItemViewModel.calculateAttributedString(with: text, highlightedRanges: highlightedRanges, traitCollection: traitCollection, theme: theme, type: type, diffItemType: diffItemType, moveInfo: moveInfo, semanticContentAttribute: semanticContentAttribute)
+    // Built the first time each theme and text size is shown, so switching back and forth doesn't rebuild them.
+    // Heights are calculated off the main thread while cells read the same strings, hence the lock.
+    private var attributedStrings: [AttributedStringKey: NSAttributedString?] = [:]
+    private let attributedStringsLock = NSLock()
+    
+    var textAttributedString: NSAttributedString? {
+        attributedStringsLock.lock()
+        defer {
+            attributedStringsLock.unlock()
         }
+        
+        let key = AttributedStringKey(themeName: theme.name, contentSizeCategory: traitCollection.preferredContentSizeCategory)
+        if let attributedString = attributedStrings[key] {
+            return attributedString
+        }
+        
+        let attributedString = DiffListChangeItemViewModel.calculateAttributedString(with: text, highlightedRanges: highlightedRanges, traitCollection: traitCollection, theme: theme, type: type, diffItemType: diffItemType, moveInfo: moveInfo, semanticContentAttribute: semanticContentAttribute)
+        attributedStrings[key] = attributedString
+        return attributedString
     }
     
-    private(set) var textAttributedString: NSAttributedString?
-    
     init(firstRevisionText: String, traitCollection: UITraitCollection, theme: Theme, semanticContentAttribute: UISemanticContentAttribute) {
         let text = firstRevisionText
         let theme = theme
@@ -49,7 +64,6 @@ final class DiffListChangeItemViewModel {
         self.textPadding =  textPaddingAndInBetweenSpacing.0
         self.inBetweenSpacing = nil
         self.hasShadedBackgroundView = false
-        self.textAttributedString = DiffListChangeItemViewModel.calculateAttributedString(with: text, highlightedRanges: highlightedRanges, traitCollection: traitCollection, theme: theme, type: type, diffItemType: diffItemType, moveInfo: nil, semanticContentAttribute: semanticContentAttribute)
         self.accessibilityLabelText = DiffListChangeItemViewModel.constructAccessibilityLabel(with: text, highlightedRanges: highlightedRanges, diffItemType: diffItemType, moveInfo: nil)
     }
     
@@ -91,7 +105,6 @@ final class DiffListChangeItemViewModel {
         
         hasShadedBackgroundView = (diffItemType == .moveSource || diffItemType == .moveDestination)
 
-        self.textAttributedString = DiffListChangeItemViewModel.calculateAttributedString(with: text, highlightedRanges: highlightedRanges, traitCollection: traitCollection, theme: theme, type: type, diffItemType: diffItemType, moveInfo: item.moveInfo, semanticContentAttribute: semanticContentAttribute)
         self.accessibilityLabelText = DiffListChangeItemViewModel.constructAccessibilityLabel(with: text, highlightedRanges: highlightedRanges, diffItemType: diffItemType, moveInfo: item.moveInfo)
     }
     
@@ -75,7 +75,10 @@ final class DiffListChangeViewModel: DiffListGroupViewModel {
         headingAttributedString = DiffListChangeViewModel.calculateHeadingAttributedString(headingColor: headingColor, text: heading, traitCollection: traitCollection)
         stackViewPadding = DiffListChangeViewModel.calculateStackViewPadding(type: type, items: items)
         
-        height = DiffListChangeViewModel.calculateHeight(items: items, availableWidth: availableWidth, innerPadding: innerPadding, headingAttributedString: headingAttributedString, headingPadding: headingPadding, stackViewPadding: stackViewPadding)
+        // Transformers build view models at zero width. Height is calculated once the list sets the real width.
+        if width > 0 {
+            height = DiffListChangeViewModel.calculateHeight(items: items, availableWidth: availableWidth, innerPadding: innerPadding, headingAttributedString: headingAttributedString, headingPadding: headingPadding, stackViewPadding: stackViewPadding)
+        }
     }
     
     init(type: DiffListChangeType, diffItems: [TransformDiffItem], theme: Theme, width: CGFloat, traitCollection: UITraitCollection, semanticContentAttribute: UISemanticContentAttribute) {
@@ -113,7 +116,10 @@ final class DiffListChangeViewModel: DiffListGroupViewModel {
         headingAttributedString = DiffListChangeViewModel.calculateHeadingAttributedString(headingColor: headingColor, text: heading, traitCollection: traitCollection)
         stackViewPadding = DiffListChangeViewModel.calculateStackViewPadding(type: type, items: items)
         
-        height = DiffListChangeViewModel.calculateHeight(items: items, availableWidth: availableWidth, innerPadding: innerPadding, headingAttributedString: headingAttributedString, headingPadding: headingPadding, stackViewPadding: stackViewPadding)
+        // Transformers build view models at zero width. Height is calculated once the list sets the real width.
+        if width > 0 {
+            height = DiffListChangeViewModel.calculateHeight(items: items, availableWidth: availableWidth, innerPadding: innerPadding, headingAttributedString: headingAttributedString, headingPadding: headingPadding, stackViewPadding: stackViewPadding)
+        }
     }
     
     private static func calculateHeadingsFromSectionTitles(diffItems: [TransformDiffItem]) -> String? {
@@ -6,24 +6,45 @@ final class DiffListContextItemViewModel {
     private let semanticContentAttribute: UISemanticContentAttribute
     var theme: Theme {
         didSet {
-            self.textAttributedString = DiffListContextItemViewModel.calculateAttributedString(with: text, semanticContentAttribute: semanticContentAttribute, theme: theme, contextFont: contextFont)
+            resetTextAttributedString()
         }
     }
     var contextFont: UIFont {
            didSet {
-               self.textAttributedString = DiffListContextItemViewModel.calculateAttributedString(with: text, semanticContentAttribute: semanticContentAttribute, theme: theme, contextFont: contextFont)
+               resetTextAttributedString()
            }
     }
     
-    private(set) var textAttributedString: NSAttributedString
+    // Built when first needed after a theme or font change, so cells that are never shown don't build it
+    private var _textAttributedString: NSAttributedString?
+    private let textAttributedStringLock = NSLock()
+    
+    var textAttributedString: NSAttributedString {
+        textAttributedStringLock.lock()
+        defer {
+            textAttributedStringLock.unlock()
+        }
+        
+        if let textAttributedString = _textAttributedString {
+            return textAttributedString
+        }
+        
+        let textAttributedString = DiffListContextItemViewModel.calculateAttributedString(with: text, semanticContentAttribute: semanticContentAttribute, theme: theme, contextFont: contextFont)
+        _textAttributedString = textAttributedString
+        return textAttributedString
+    }
+    
+    private func resetTextAttributedString() {
+        textAttributedStringLock.lock()
+        _textAttributedString = nil
+        textAttributedStringLock.unlock()
+    }
     
     init(text: String, semanticContentAttribute: UISemanticContentAttribute, theme: Theme, contextFont: UIFont) {
         self.text = text
         self.semanticContentAttribute = semanticContentAttribute
         self.theme = theme
         self.contextFont = contextFont
-        
-        self.textAttributedString = DiffListContextItemViewModel.calculateAttributedString(with: text, semanticContentAttribute: semanticContentAttribute, theme: theme, contextFont: contextFont)
 
         let diffContextualLine = WMFLocalizedString("diff-unchanged-contextual-line", value: "Contextual line, unchanged: %1$@", comment: "Text read by VoiceOver in diffs that indicates information about the forthcoming content. %1$@ will be replaced with that content.")
         self.accessibilityLabelText = String.localizedStringWithFormat(diffContextualLine, text) 
@@ -36,12 +36,20 @@ struct TransformSectionInfo {
     let toIsIntro: Bool
 }
 
+/// Consecutive diff items shown in one list cell. Built without UIKit, so groups can be computed on any queue.
+enum DiffTransformGroup {
+    case change(items: [TransformDiffItem])
+    case context(items: [TransformDiffItem])
+    case unedited(numberOfLines: Int)
+}
+
 enum DiffTransformerError: Error {
     case failureTransformingNetworkModels
     case failureParsingFirstRevisionWikitext
 }
 
 // takes a DiffResponse and turns it into  [DiffListGroupViewModel]
+// Stage one (groups(from:type:)) only uses Foundation and runs off the main thread. Stage two (viewModels(from:theme:traitCollection:)) builds view models, which create their themed text when it's first needed.
 class DiffTransformer {
     
     let type: DiffContainerViewModel.DiffType
@@ -74,311 +82,216 @@ class DiffTransformer {
     }
     
     func viewModels(from response: DiffResponse, theme: Theme, traitCollection: UITraitCollection) throws -> [DiffListGroupViewModel] {
-        
-        let groupedMoveIndexes = self.groupedIndexesOfMoveItems(from: response)
-        let transformSectionInfo = self.transformSectionInfosOfItems(from: response)
-        let transformDiffItems = self.transformDiffItemsWithPopulatedLineNumbers(from: response)
-        
-        guard let populatedTransformDiffItems = self.populateAdditionalSectionAndMoveInfo(transformSectionInfo: transformSectionInfo, transformDiffItems: transformDiffItems, groupedMoveIndexes: groupedMoveIndexes) else {
-            
-            throw DiffTransformerError.failureTransformingNetworkModels
-        }
-        
-        switch self.type {
-        case .single:
-            let viewModels: [DiffListGroupViewModel] = self.viewModelsForSingle(from: populatedTransformDiffItems, theme: theme, traitCollection: traitCollection)
-
-            return viewModels
-        case .compare:
-            let viewModels: [DiffListGroupViewModel] = self.viewModelsForCompare(from: populatedTransformDiffItems, theme: theme, traitCollection: traitCollection)
-            return viewModels
-        }
+        let groups = DiffTransformer.groups(from: response, type: type)
+        return viewModels(from: groups, theme: theme, traitCollection: traitCollection)
     }
     
-    private func populateAdditionalSectionAndMoveInfo(transformSectionInfo: [TransformSectionInfo], transformDiffItems: [TransformDiffItem], groupedMoveIndexes: [String: Int]) -> [TransformDiffItem]? {
-        
-        guard transformDiffItems.count == transformSectionInfo.count,
-            transformDiffItems.count == transformDiffItems.count else {
-            assertionFailure("Expecting section info count to equal number of diff items")
-            return nil
-        }
-        
-        var newItems: [TransformDiffItem] = []
-        let zipped = zip(transformDiffItems, transformSectionInfo)
-        
-        var correspondingMoveItems: [String: (linkItem: TransformDiffItem, linkSectionInfo: TransformSectionInfo)] = [:]
-        for zippedItem in zipped {
-            guard zippedItem.0.type == .moveDestination ||
-                zippedItem.0.type == .moveSource else {
-                continue
-            }
-            
-            if let linkId = zippedItem.0.moveInfo?.linkId {
-                correspondingMoveItems[linkId] = (zippedItem.0, zippedItem.1)
-            }
-        }
+    // MARK: - Stage one
+    
+    /// Items with line numbers, section titles and move links, grouped the way the list shows them
+    static func groups(from response: DiffResponse, type: DiffContainerViewModel.DiffType) -> [DiffTransformGroup] {
+        let items = transformDiffItems(from: response)
         
-        for var zippedItem in zipped {
-            
-            var isToIntro = zippedItem.1.toIsIntro
-            var isFromIntro = zippedItem.1.fromIsIntro
-            
-            zippedItem.0.sectionTitle = zippedItem.1.to?.title ?? zippedItem.1.from?.title
-            
-            if let moveInfo = zippedItem.0.moveInfo {
-                
-                let groupedIndex = groupedMoveIndexes[moveInfo.id]
-                
-                var moveDistance: TransformMoveDistance? = nil
-                
-                if let correspondingMoveItem = correspondingMoveItems[moveInfo.id] {
-                    
-                    let fromSectionTitle = zippedItem.0.type == .moveSource ? zippedItem.1.from?.title : correspondingMoveItem.linkSectionInfo.from?.title
-                    let toSectionTitle = zippedItem.0.type == .moveSource ? correspondingMoveItem.linkSectionInfo.to?.title : zippedItem.1.to?.title
-                    let fromSectionOrder = zippedItem.0.type == .moveSource ? zippedItem.1.from?.order : correspondingMoveItem.linkSectionInfo.from?.order
-                    let toSectionOrder = zippedItem.0.type == .moveSource ? correspondingMoveItem.linkSectionInfo.to?.order : zippedItem.1.to?.order
-                    isToIntro = zippedItem.0.type == .moveSource ? correspondingMoveItem.linkSectionInfo.toIsIntro : zippedItem.1.toIsIntro
-                    isFromIntro = zippedItem.0.type == .moveSource ? zippedItem.1.fromIsIntro : correspondingMoveItem.linkSectionInfo.fromIsIntro
-                    
-                    if let fromSectionTitle = fromSectionTitle,
-                        let toSectionTitle = toSectionTitle,
-                        let fromSectionOrder = fromSectionOrder,
-                        let toSectionOrder = toSectionOrder {
-                            
-                        switch (fromSectionTitle == toSectionTitle, fromSectionOrder == toSectionOrder) {                            
-                        case (false, false):
-                            moveDistance = .section(amount: abs(fromSectionOrder - toSectionOrder))
-                        default:
-                            break
-                        }
-                    }
-                    
-                    if moveDistance == nil {
-                        // fallback to line numbers
-                        if let firstLineNumber = zippedItem.0.lineNumber,
-                            let nextLineNumber = correspondingMoveItem.linkItem.lineNumber {
-                            moveDistance = .line(amount: abs(firstLineNumber - nextLineNumber))
-                        }
-                    }
-                }
-                
-                let transformMoveInfo = TransformMoveInfo(id: moveInfo.id, linkId: moveInfo.linkId, linkDirection: moveInfo.linkDirection, groupedIndex: groupedIndex, moveDistance: moveDistance)
-                zippedItem.0.moveInfo = transformMoveInfo
-            }
-            
-            if zippedItem.0.sectionTitle == nil {
-                if isToIntro && isFromIntro {
-                    zippedItem.0.sectionTitle = WMFLocalizedString("diff-single-intro-title", value:"Intro", comment:"Section heading on revision changes diff screen that indicates the following highlighted changes occurred in the intro section.")
-                }
-            }
-            
-            newItems.append(zippedItem.0)
+        switch type {
+        case .single:
+            return groupsForSingle(from: items)
+        case .compare:
+            return groupsForCompare(from: items)
         }
-        
-        return newItems
     }
     
-    private func transformSectionInfosOfItems(from response: DiffResponse) -> [TransformSectionInfo] {
+    /// One pass over the diff fills in line numbers, sections and move group indexes. A second pass over only the moved paragraphs links each to its other end.
+    static func transformDiffItems(from response: DiffResponse) -> [TransformDiffItem] {
         
-        var result: [TransformSectionInfo] = []
+        let introTitle = WMFLocalizedString("diff-single-intro-title", value:"Intro", comment:"Section heading on revision changes diff screen that indicates the following highlighted changes occurred in the intro section.")
         
-        var fromSections = response.from.sections
-        var toSections = response.to.sections
+        let fromSections = response.from.sections
+        let toSections = response.to.sections
+        let firstFromOffset = fromSections.first?.offset
+        let firstToOffset = toSections.first?.offset
         
-        let firstFrom = fromSections.first
-        let firstTo = toSections.first
+        // Index of the next section to start on each side
+        var nextFromSectionIndex = 0
+        var nextToSectionIndex = 0
         
-        var lastFrom: DiffSection? = nil
-        var lastTo: DiffSection? = nil
+        var fromIsIntro = false
+        var toIsIntro = false
+        var lastLineNumber: Int?
         
-        var lastFromIndex = -1
-        var lastToIndex = -1
+        var items: [TransformDiffItem] = []
+        var sectionInfos: [TransformSectionInfo] = []
+        items.reserveCapacity(response.diff.count)
+        sectionInfos.reserveCapacity(response.diff.count)
         
-        var currentFrom = fromSections.first
-        var currentTo = toSections.first
+        var groupedMoveIndexes: [String: Int] = [:]
+        var groupedMoveIndexCounter = 0
+        var moveItemIndexesByLinkId: [String: Int] = [:]
+        var indexesOfItemsWithMoveInfo: [Int] = []
         
-        var fromIsIntro = false
-        var toIsIntro = false
         for item in response.diff {
             
             // from side
             var fromSide: TransformSectionInfo.Side?
             
             if let itemFromOffset = item.offset.from {
-                while currentFrom != nil &&
-                currentFrom!.offset <= itemFromOffset {
-                    
-                        lastFrom = fromSections.removeFirst()
-                        lastFromIndex = lastFromIndex + 1
-                        currentFrom = fromSections.first
-                }
-                
-                if let lastFrom = lastFrom {
-                    fromSide = TransformSectionInfo.Side(title: lastFrom.heading, order: lastFromIndex)
+                while nextFromSectionIndex < fromSections.count,
+                      fromSections[nextFromSectionIndex].offset <= itemFromOffset {
+                    nextFromSectionIndex += 1
                 }
                 
-                if let firstFromOffset = firstFrom?.offset,
-                    fromSide == nil {
+                if nextFromSectionIndex > 0 {
+                    fromSide = TransformSectionInfo.Side(title: fromSections[nextFromSectionIndex - 1].heading, order: nextFromSectionIndex - 1)
+                } else if let firstFromOffset {
                     fromIsIntro = itemFromOffset < firstFromOffset
                 }
             }
             
-            
             // to side
             var toSide: TransformSectionInfo.Side?
             
             if let itemToOffset = item.offset.to {
-                while currentTo != nil &&
-                currentTo!.offset <= itemToOffset {
-                    
-                        lastTo = toSections.removeFirst()
-                        lastToIndex = lastToIndex + 1
-                        currentTo = toSections.first
-                }
-                
-                if let lastTo = lastTo {
-                    toSide = TransformSectionInfo.Side(title: lastTo.heading, order: lastToIndex)
+                while nextToSectionIndex < toSections.count,
+                      toSections[nextToSectionIndex].offset <= itemToOffset {
+                    nextToSectionIndex += 1
                 }
                 
-                if let firstToOffset = firstTo?.offset,
-                    toSide == nil {
+                if nextToSectionIndex > 0 {
+                    toSide = TransformSectionInfo.Side(title: toSections[nextToSectionIndex - 1].heading, order: nextToSectionIndex - 1)
+                } else if let firstToOffset {
                     toIsIntro = itemToOffset < firstToOffset
                 }
             }
             
-            result.append(TransformSectionInfo(from: fromSide, to: toSide, fromIsIntro: fromIsIntro, toIsIntro: toIsIntro))
-        }
-        
-        return result
-    }
-    
-    private func groupedIndexesOfMoveItems(from response: DiffResponse) -> [String: Int] {
-        let movedItems = response.diff.filter { $0.type == .moveSource || $0.type == .moveDestination }
-        
-        var indexCounter = 0
-        var result: [String: Int] = [:]
-        
-        for item in movedItems {
+            let sectionInfo = TransformSectionInfo(from: fromSide, to: toSide, fromIsIntro: fromIsIntro, toIsIntro: toIsIntro)
             
-            if let id = item.moveInfo?.id,
-                let linkId = item.moveInfo?.linkId {
-
-                if result[id] == nil {
-                    if let existingIndex = result[linkId] {
-                        result[id] = existingIndex
-                    } else {
-                        result[id] = indexCounter
-                        indexCounter += 1
+            if let lineNumber = item.lineNumber {
+                lastLineNumber = lineNumber
+            }
+            
+            var transformMoveInfo: TransformMoveInfo?
+            if let moveInfo = item.moveInfo {
+                transformMoveInfo = TransformMoveInfo(id: moveInfo.id, linkId: moveInfo.linkId, linkDirection: moveInfo.linkDirection, groupedIndex: nil, moveDistance: nil)
+                indexesOfItemsWithMoveInfo.append(items.count)
+                
+                if item.type.isMoveBased {
+                    if groupedMoveIndexes[moveInfo.id] == nil {
+                        if let existingIndex = groupedMoveIndexes[moveInfo.linkId] {
+                            groupedMoveIndexes[moveInfo.id] = existingIndex
+                        } else {
+                            groupedMoveIndexes[moveInfo.id] = groupedMoveIndexCounter
+                            groupedMoveIndexCounter += 1
+                        }
                     }
+                    moveItemIndexesByLinkId[moveInfo.linkId] = items.count
                 }
             }
+            
+            var sectionTitle = toSide?.title ?? fromSide?.title
+            if sectionTitle == nil && transformMoveInfo == nil && toIsIntro && fromIsIntro {
+                sectionTitle = introTitle
+            }
+            
+            items.append(TransformDiffItem(type: item.type, text: item.text, highlightRanges: item.highlightRanges, offset: item.offset, sectionTitle: sectionTitle, lineNumber: lastLineNumber, moveInfo: transformMoveInfo))
+            sectionInfos.append(sectionInfo)
         }
         
-        return result
-    }
-    
-    private func transformDiffItemsWithPopulatedLineNumbers(from response: DiffResponse) -> [TransformDiffItem] {
-        
-        var items: [TransformDiffItem] = []
-        
-        var lastLineNumber: Int?
-        for item in response.diff {
+        for index in indexesOfItemsWithMoveInfo {
             
-            var transformMoveInfo: TransformMoveInfo?
-            if let moveInfo = item.moveInfo {
-                transformMoveInfo = TransformMoveInfo(id: moveInfo.id, linkId: moveInfo.linkId, linkDirection: moveInfo.linkDirection, groupedIndex: nil, moveDistance: nil)
+            var item = items[index]
+            let sectionInfo = sectionInfos[index]
+            
+            guard let moveInfo = item.moveInfo else {
+                continue
             }
             
-            let transformDiffItem: TransformDiffItem
+            var isToIntro = sectionInfo.toIsIntro
+            var isFromIntro = sectionInfo.fromIsIntro
+            var moveDistance: TransformMoveDistance? = nil
             
-            if let lineNumber = item.lineNumber {
-                lastLineNumber = lineNumber
-                transformDiffItem = TransformDiffItem(type: item.type, text: item.text, highlightRanges: item.highlightRanges, offset: item.offset, sectionTitle: nil, lineNumber: lineNumber, moveInfo: transformMoveInfo)
-            } else {
-                transformDiffItem = TransformDiffItem(type: item.type, text: item.text, highlightRanges: item.highlightRanges, offset: item.offset, sectionTitle: nil, lineNumber: lastLineNumber, moveInfo: transformMoveInfo)
+            if let linkIndex = moveItemIndexesByLinkId[moveInfo.id] {
+                
+                let linkItem = items[linkIndex]
+                let linkSectionInfo = sectionInfos[linkIndex]
+                let isMoveSource = item.type == .moveSource
+                
+                let fromSection = isMoveSource ? sectionInfo.from : linkSectionInfo.from
+                let toSection = isMoveSource ? linkSectionInfo.to : sectionInfo.to
+                isToIntro = isMoveSource ? linkSectionInfo.toIsIntro : sectionInfo.toIsIntro
+                isFromIntro = isMoveSource ? sectionInfo.fromIsIntro : linkSectionInfo.fromIsIntro
+                
+                if let fromSection,
+                   let toSection,
+                   fromSection.title != toSection.title,
+                   fromSection.order != toSection.order {
+                    moveDistance = .section(amount: abs(fromSection.order - toSection.order))
+                }
+                
+                if moveDistance == nil {
+                    // fallback to line numbers
+                    if let firstLineNumber = item.lineNumber,
+                       let nextLineNumber = linkItem.lineNumber {
+                        moveDistance = .line(amount: abs(firstLineNumber - nextLineNumber))
+                    }
+                }
+            }
+            
+            item.moveInfo = TransformMoveInfo(id: moveInfo.id, linkId: moveInfo.linkId, linkDirection: moveInfo.linkDirection, groupedIndex: groupedMoveIndexes[moveInfo.id], moveDistance: moveDistance)
+            
+            if item.sectionTitle == nil && isToIntro && isFromIntro {
+                item.sectionTitle = introTitle
             }
             
-            items.append(transformDiffItem)
+            items[index] = item
         }
         
         return items
     }
     
-    private func viewModelsForSingle(from transformDiffItems: [TransformDiffItem], theme: Theme, traitCollection: UITraitCollection) -> [DiffListGroupViewModel] {
+    private static func groupsForSingle(from transformDiffItems: [TransformDiffItem]) -> [DiffTransformGroup] {
         
-        var result: [DiffListGroupViewModel] = []
+        var result: [DiffTransformGroup] = []
         
         var sectionItems: [TransformDiffItem] = []
         var lastItem: TransformDiffItem?
-
-        let packageUpSectionItemsIfNeeded = {
-            
-            if sectionItems.count > 0 {
-                // package contexts up into change view model, append to result
-
-                let changeViewModel = DiffListChangeViewModel(type: .singleRevison, diffItems: sectionItems, theme: theme, width: 0, traitCollection: traitCollection, semanticContentAttribute: self.semanticContentAttribute)
-
-                result.append(changeViewModel)
-                sectionItems.removeAll()
-            }
-            
-        }
         
-        for item in transformDiffItems {
-
+        for item in transformDiffItems where item.type != .context {
             
-            if item.type == .context {
-                
-                continue
-                
-            } else {
-                
-                if item.sectionTitle != lastItem?.sectionTitle {
-                    packageUpSectionItemsIfNeeded()
-                }
-                
-                sectionItems.append(item)
+            if item.sectionTitle != lastItem?.sectionTitle && !sectionItems.isEmpty {
+                result.append(.change(items: sectionItems))
+                sectionItems.removeAll()
             }
             
+            sectionItems.append(item)
             lastItem = item
-            
-            continue
         }
         
-        packageUpSectionItemsIfNeeded()
+        if !sectionItems.isEmpty {
+            result.append(.change(items: sectionItems))
+        }
         
         return result
     }
+    
+    private static func groupsForCompare(from transformDiffItems: [TransformDiffItem]) -> [DiffTransformGroup] {
         
-    private func viewModelsForCompare(from transformDiffItems: [TransformDiffItem], theme: Theme, traitCollection: UITraitCollection) -> [DiffListGroupViewModel] {
-        
-        var result: [DiffListGroupViewModel] = []
+        var result: [DiffTransformGroup] = []
         
         var contextItems: [TransformDiffItem] = []
         var changeItems: [TransformDiffItem] = []
         var lastItem: TransformDiffItem?
         
         let packageUpContextItemsIfNeeded = {
-            
-            if contextItems.count > 0 {
-                // package contexts up into context view model, append to result
-                let contextViewModel = DiffListContextViewModel(diffItems: contextItems, isExpanded: UIAccessibility.isVoiceOverRunning, theme: theme, width: 0, traitCollection: traitCollection, semanticContentAttribute: self.semanticContentAttribute)
-                result.append(contextViewModel)
+            if !contextItems.isEmpty {
+                result.append(.context(items: contextItems))
                 contextItems.removeAll()
             }
         }
         
         let packageUpChangeItemsIfNeeded = {
-            
-            if changeItems.count > 0 {
-                // package contexts up into change view model, append to result
-
-                let changeViewModel = DiffListChangeViewModel(type: .compareRevision, diffItems: changeItems, theme: theme, width: 0, traitCollection: traitCollection, semanticContentAttribute: self.semanticContentAttribute)
-
-                result.append(changeViewModel)
+            if !changeItems.isEmpty {
+                result.append(.change(items: changeItems))
                 changeItems.removeAll()
             }
-            
         }
         
         for item in transformDiffItems {
@@ -391,28 +304,20 @@ class DiffTransformer {
                     packageUpContextItemsIfNeeded()
                     packageUpChangeItemsIfNeeded()
                     
-                    // insert unedited lines view model
-                    let uneditedViewModel = DiffListUneditedViewModel(numberOfUneditedLines: delta, theme: theme, width: 0, traitCollection: traitCollection)
-                    result.append(uneditedViewModel)
+                    // unedited lines between the groups
+                    result.append(.unedited(numberOfLines: delta))
                 }
             }
             
             if item.type == .context {
-                
                 packageUpChangeItemsIfNeeded()
-                
                 contextItems.append(item)
-                
             } else {
-                
                 packageUpContextItemsIfNeeded()
-                
                 changeItems.append(item)
             }
             
             lastItem = item
-            
-            continue
         }
         
         packageUpContextItemsIfNeeded()
@@ -420,4 +325,25 @@ class DiffTransformer {
         
         return result
     }
+    
+    // MARK: - Stage two
+    
+    /// View models for the groups. Their attributed strings are built when they're first used, and kept for each theme and text size.
+    func viewModels(from groups: [DiffTransformGroup], theme: Theme, traitCollection: UITraitCollection) -> [DiffListGroupViewModel] {
+        
+        let semanticContentAttribute = self.semanticContentAttribute
+        let changeType: DiffListChangeType = type == .single ? .singleRevison : .compareRevision
+        let isContextExpanded = UIAccessibility.isVoiceOverRunning
+        
+        return groups.map { group -> DiffListGroupViewModel in
+            switch group {
+            case .change(let items):
+                return DiffListChangeViewModel(type: changeType, diffItems: items, theme: theme, width: 0, traitCollection: traitCollection, semanticContentAttribute: semanticContentAttribute)
+            case .context(let items):
+                return DiffListContextViewModel(diffItems: items, isExpanded: isContextExpanded, theme: theme, width: 0, traitCollection: traitCollection, semanticContentAttribute: semanticContentAttribute)
+            case .unedited(let numberOfLines):
+                return DiffListUneditedViewModel(numberOfUneditedLines: numberOfLines, theme: theme, width: 0, traitCollection: traitCollection)
+            }
+        }
+    }
 }
@@ -230,6 +230,7 @@ NSString *const WMFCacheContextCrossProcessNotificiationChannelNamePrefix = @"or
             self.viewContext = container.viewContext;
             self.viewContext.mergePolicy = NSMergeByPropertyStoreTrumpMergePolicy;
             self.viewContext.automaticallyMergesChangesFromParent = YES;
+            [[NSNotificationCenter defaultCenter] addObserver:self selector:@selector(managedObjectContextWillSave:) name:NSManagedObjectContextWillSaveNotification object:self.viewContext];
             [[NSNotificationCenter defaultCenter] addObserver:self selector:@selector(managedObjectContextDidSave:) name:NSManagedObjectContextDidSaveNotification object:self.viewContext];
             [[NSNotificationCenter defaultCenter] addObserver:self selector:@selector(viewContextDidChange:) name:NSManagedObjectContextObjectsDidChangeNotification object:self.viewContext];
 
@@ -272,6 +273,12 @@ NSString *const WMFCacheContextCrossProcessNotificiationChannelNamePrefix = @"or
 
 #pragma mark - Background Contexts
 
+- (void)managedObjectContextWillSave:(NSNotification *)note {
+    // Pre-save pass rather than WMFContentGroup's willSave, so article references aren't inserted or deleted while the save is in progress
+    NSManagedObjectContext *moc = note.object;
+    [moc updateContentGroupArticleReferences];
+}
+
 - (void)managedObjectContextDidSave:(NSNotification *)note {
     NSManagedObjectContext *moc = note.object;
     NSNotificationName notificationName;
@@ -291,9 +298,11 @@ NSString *const WMFCacheContextCrossProcessNotificiationChannelNamePrefix = @"or
     backgroundContext.automaticallyMergesChangesFromParent = YES;
     backgroundContext.mergePolicy = NSMergeByPropertyStoreTrumpMergePolicy;
     NSNotificationCenter *nc = [NSNotificationCenter defaultCenter];
+    [nc addObserver:self selector:@selector(managedObjectContextWillSave:) name:NSManagedObjectContextWillSaveNotification object:backgroundContext];
     [nc addObserver:self selector:@selector(managedObjectContextDidSave:) name:NSManagedObjectContextDidSaveNotification object:backgroundContext];
     [backgroundContext performBlock:^{
         mocBlock(backgroundContext);
+        [nc removeObserver:self name:NSManagedObjectContextWillSaveNotification object:backgroundContext];
         [nc removeObserver:self name:NSManagedObjectContextDidSaveNotification object:backgroundContext];
     }];
 }
@@ -304,6 +313,7 @@ NSString *const WMFCacheContextCrossProcessNotificiationChannelNamePrefix = @"or
         _feedImportContext = self.persistentContainer.newBackgroundContext;
         _feedImportContext.automaticallyMergesChangesFromParent = YES;
         _feedImportContext.mergePolicy = NSMergeByPropertyStoreTrumpMergePolicy;
+        [[NSNotificationCenter defaultCenter] addObserver:self selector:@selector(managedObjectContextWillSave:) name:NSManagedObjectContextWillSaveNotification object:_feedImportContext];
         [[NSNotificationCenter defaultCenter] addObserver:self selector:@selector(managedObjectContextDidSave:) name:NSManagedObjectContextDidSaveNotification object:_feedImportContext];
     }
     return _feedImportContext;
@@ -312,6 +322,7 @@ NSString *const WMFCacheContextCrossProcessNotificiationChannelNamePrefix = @"or
 - (void)teardownFeedImportContext {
     WMFAssertMainThread(@"feedImportContext must be torn down on the main thread");
     if (_feedImportContext) {
+        [[NSNotificationCenter defaultCenter] removeObserver:self name:NSManagedObjectContextWillSaveNotification object:_feedImportContext];
         [[NSNotificationCenter defaultCenter] removeObserver:self name:NSManagedObjectContextDidSaveNotification object:_feedImportContext];
         _feedImportContext = nil;
     }
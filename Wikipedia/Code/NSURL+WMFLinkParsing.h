@@ -180,7 +180,13 @@ extern NSString *const WMFEditPencil;
 
 @property (nonatomic, copy, readonly, nullable) NSURL *wmf_canonicalURL; // canonical URL
 
-@property (nonatomic, copy, readonly, nullable) NSString *wmf_databaseKey; // string suitable for using as a unique key for any wiki page
+@property (nonatomic, copy, readonly, nullable) NSString *wmf_databaseKey; // string suitable for using as a unique key for any wiki page. Memoized, and equal keys share the same string instance.
+
+/**
+ *  Return the database keys of @c URLs in order, skipping URLs without one.
+ *  Faster than getting @c wmf_databaseKey of each URL when the list repeats URLs.
+ */
++ (NSArray<NSString *> *)wmf_databaseKeysForURLs:(NSArray<NSURL *> *)URLs NS_SWIFT_NAME(wmf_databaseKeys(for:));
 
 /**
  *  Returns @c wmf_languageVariantCode if non-nil and non-empty string, @c wmf_languageCode otherwise
@@ -244,6 +250,11 @@ extern NSString *const WMFEditPencil;
 
 @interface NSURL (WMFInMemoryURLKeyExtensions)
 @property (readonly, nonatomic, copy, nullable) WMFInMemoryURLKey *wmf_inMemoryKey;
+
+/**
+ *  Return the in-memory keys of @c URLs in order, skipping URLs without a database key.
+ */
++ (NSArray<WMFInMemoryURLKey *> *)wmf_inMemoryKeysForURLs:(NSArray<NSURL *> *)URLs NS_SWIFT_NAME(wmf_inMemoryKeys(for:));
 @end
 
 NS_ASSUME_NONNULL_END
@@ -3,11 +3,117 @@
 #import <WMF/NSURL+WMFExtras.h>
 #import <WMF/WMF-Swift.h>
 #import <objc/runtime.h>
+#import <os/lock.h>
 
 NSString *const WMFMediaWikiDomain = @"mediawiki.org";
 NSString *const WMFAPIPath = @"/w/api.php";
 NSString *const WMFEditPencil = @"WMFEditPencil";
 
+#pragma mark - Database key memo
+
+static const NSUInteger WMFDatabaseKeyStripeCount = 16;
+static const NSUInteger WMFDatabaseKeyStripeGenerationCapacity = 512;
+
+/**
+ * One of the independently locked shards of the database key memo and intern table.
+ * Memoized keys are kept in two generations: when the recent generation fills up it replaces the older one,
+ * and keys found in the older generation are moved back to the recent one. This evicts the least recently used keys
+ * without tracking the order of every lookup.
+ */
+@interface WMFDatabaseKeyStripe : NSObject {
+    os_unfair_lock _lock;
+    NSMutableDictionary<NSString *, NSString *> *_recentDatabaseKeysByURLString;
+    NSMutableDictionary<NSString *, NSString *> *_olderDatabaseKeysByURLString;
+    NSHashTable<NSString *> *_internedDatabaseKeys;
+}
+- (nullable NSString *)databaseKeyForURLString:(NSString *)URLString;
+- (void)setDatabaseKey:(NSString *)databaseKey forURLString:(NSString *)URLString;
+- (NSString *)internedDatabaseKey:(NSString *)databaseKey; // Returns an equal key that's already in use if there is one, so equal keys share storage and usually compare equal by pointer
+@end
+
+@implementation WMFDatabaseKeyStripe
+
+- (instancetype)init {
+    if (self = [super init]) {
+        _lock = OS_UNFAIR_LOCK_INIT;
+        _recentDatabaseKeysByURLString = [NSMutableDictionary dictionaryWithCapacity:WMFDatabaseKeyStripeGenerationCapacity];
+        _olderDatabaseKeysByURLString = [NSMutableDictionary dictionary];
+        _internedDatabaseKeys = [NSHashTable weakObjectsHashTable];
+    }
+    return self;
+}
+
+- (void)unlockedSetDatabaseKey:(NSString *)databaseKey forURLString:(NSString *)URLString {
+    if (_recentDatabaseKeysByURLString.count >= WMFDatabaseKeyStripeGenerationCapacity) {
+        _olderDatabaseKeysByURLString = _recentDatabaseKeysByURLString;
+        _recentDatabaseKeysByURLString = [NSMutableDictionary dictionaryWithCapacity:WMFDatabaseKeyStripeGenerationCapacity];
+    }
+    _recentDatabaseKeysByURLString[URLString] = databaseKey;
+}
+
+- (nullable NSString *)databaseKeyForURLString:(NSString *)URLString {
+    os_unfair_lock_lock(&_lock);
+    NSString *databaseKey = _recentDatabaseKeysByURLString[URLString];
+    if (!databaseKey) {
+        databaseKey = _olderDatabaseKeysByURLString[URLString];
+        if (databaseKey) {
+            [_olderDatabaseKeysByURLString removeObjectForKey:URLString];
+            [self unlockedSetDatabaseKey:databaseKey forURLString:URLString];
+        }
+    }
+    os_unfair_lock_unlock(&_lock);
+    return databaseKey;
+}
+
+- (void)setDatabaseKey:(NSString *)databaseKey forURLString:(NSString *)URLString {
+    os_unfair_lock_lock(&_lock);
+    [self unlockedSetDatabaseKey:databaseKey forURLString:URLString];
+    os_unfair_lock_unlock(&_lock);
+}
+
+- (NSString *)internedDatabaseKey:(NSString *)databaseKey {
+    os_unfair_lock_lock(&_lock);
+    NSString *internedDatabaseKey = [_internedDatabaseKeys member:databaseKey];
+    if (!internedDatabaseKey) {
+        internedDatabaseKey = [databaseKey copy];
+        [_internedDatabaseKeys addObject:internedDatabaseKey];
+    }
+    os_unfair_lock_unlock(&_lock);
+    return internedDatabaseKey;
+}
+
+@end
+
+static WMFDatabaseKeyStripe *WMFDatabaseKeyStripeForString(NSString *string) {
+    static WMFDatabaseKeyStripe *stripes[WMFDatabaseKeyStripeCount];
+    static dispatch_once_t onceToken;
+    dispatch_once(&onceToken, ^{
+        for (NSUInteger i = 0; i < WMFDatabaseKeyStripeCount; i++) {
+            stripes[i] = [[WMFDatabaseKeyStripe alloc] init];
+        }
+    });
+    return stripes[string.hash % WMFDatabaseKeyStripeCount];
+}
+
+// Calls block with each URL that has a database key, in order. Lists often repeat a URL, so repeats are looked up locally instead of in the shared memo.
+static void WMFEnumerateDatabaseKeys(NSArray<NSURL *> *URLs, void (^block)(NSURL *URL, NSString *databaseKey)) {
+    NSMutableDictionary<NSString *, NSString *> *databaseKeysByURLString = [NSMutableDictionary dictionaryWithCapacity:URLs.count];
+    for (NSURL *URL in URLs) {
+        NSString *URLString = URL.baseURL ? nil : URL.absoluteString;
+        NSString *databaseKey = URLString ? databaseKeysByURLString[URLString] : nil;
+        if (!databaseKey) {
+            databaseKey = URL.wmf_databaseKey;
+            if (!databaseKey) {
+                continue;
+            }
+            if (URLString) {
+                databaseKeysByURLString[URLString] = databaseKey;
+            }
+        }
+        block(URL, databaseKey);
+    }
+}
+
 @implementation NSURL (WMFLinkParsing)
 
 #pragma mark - Constructors
@@ -247,8 +353,36 @@ NSString *const WMFEditPencil = @"WMFEditPencil";
     return [components wmf_URLWithLanguageVariantCode:self.wmf_languageVariantCode];
 }
 
+static id wmf_databaseKeyAssociatedObjectKey;
 - (NSString *)wmf_databaseKey {
-    return self.wmf_databaseURL.absoluteString.precomposedStringWithCanonicalMapping;
+    // NSURL is immutable and the key doesn't depend on the language variant, so it's computed once per instance
+    NSString *databaseKey = objc_getAssociatedObject(self, &wmf_databaseKeyAssociatedObjectKey);
+    if (databaseKey) {
+        return databaseKey;
+    }
+    // URLs bridged from Swift are often new instances, so keys are also memoized by URL string.
+    // Relative URLs are skipped because their key depends on how they're split from their base URL.
+    NSString *URLString = self.baseURL ? nil : self.absoluteString;
+    WMFDatabaseKeyStripe *stripe = URLString ? WMFDatabaseKeyStripeForString(URLString) : nil;
+    databaseKey = [stripe databaseKeyForURLString:URLString];
+    if (!databaseKey) {
+        databaseKey = self.wmf_databaseURL.absoluteString.precomposedStringWithCanonicalMapping;
+        if (!databaseKey) {
+            return nil;
+        }
+        databaseKey = [WMFDatabaseKeyStripeForString(databaseKey) internedDatabaseKey:databaseKey];
+        [stripe setDatabaseKey:databaseKey forURLString:URLString];
+    }
+    objc_setAssociatedObject(self, &wmf_databaseKeyAssociatedObjectKey, databaseKey, OBJC_ASSOCIATION_RETAIN);
+    return databaseKey;
+}
+
++ (NSArray<NSString *> *)wmf_databaseKeysForURLs:(NSArray<NSURL *> *)URLs {
+    NSMutableArray<NSString *> *databaseKeys = [NSMutableArray arrayWithCapacity:URLs.count];
+    WMFEnumerateDatabaseKeys(URLs, ^(NSURL *URL, NSString *databaseKey) {
+        [databaseKeys addObject:databaseKey];
+    });
+    return databaseKeys;
 }
 
 - (NSString *)wmf_title {
@@ -297,11 +431,15 @@ static id wmf_languageVariantAssociatedObjectKey;
 @property (nonatomic, copy, nullable) NSString *languageVariantCode;
 @end
 
-@implementation WMFInMemoryURLKey: NSObject
+@implementation WMFInMemoryURLKey: NSObject {
+    NSUInteger _hash;
+}
 -(instancetype) initWithDatabaseKey:(NSString *)databaseKey languageVariantCode:(nullable NSString *)languageVariantCode {
     if (self = [super init]) {
         self.databaseKey = databaseKey;
         self.languageVariantCode = languageVariantCode;
+        // Keys are immutable and often used in sets and dictionaries, so the hash is only computed once
+        _hash = self.databaseKey.hash ^ flipBitsWithAdditionalRotation(self.languageVariantCode.hash, 1); // When languageVariantCode is nil, the XOR flips the bits
     }
     return self;
 }
@@ -321,11 +459,17 @@ static id wmf_languageVariantAssociatedObjectKey;
 WMF_SYNTHESIZE_IS_EQUAL(WMFInMemoryURLKey, isEqualToInMemoryURLKey:)
 
 - (BOOL)isEqualToInMemoryURLKey:(WMFInMemoryURLKey *)rhs {
+    if (self == rhs) {
+        return YES;
+    }
+    if (!rhs || _hash != rhs->_hash) {
+        return NO;
+    }
     return WMF_RHS_PROP_EQUAL(databaseKey, isEqualToString:) && WMF_RHS_PROP_EQUAL(languageVariantCode, isEqualToString:);
 }
 
 - (NSUInteger)hash {
-    return self.databaseKey.hash ^ flipBitsWithAdditionalRotation(self.languageVariantCode.hash, 1); // When languageVariantCode is nil, the XOR flips the bits
+    return _hash;
 }
 
 - (NSString *)description {
@@ -342,5 +486,13 @@ WMF_SYNTHESIZE_IS_EQUAL(WMFInMemoryURLKey, isEqualToInMemoryURLKey:)
 - (nullable WMFInMemoryURLKey *)wmf_inMemoryKey {
     return [[WMFInMemoryURLKey alloc] initWithURL:self];
 }
+
++ (NSArray<WMFInMemoryURLKey *> *)wmf_inMemoryKeysForURLs:(NSArray<NSURL *> *)URLs {
+    NSMutableArray<WMFInMemoryURLKey *> *inMemoryKeys = [NSMutableArray arrayWithCapacity:URLs.count];
+    WMFEnumerateDatabaseKeys(URLs, ^(NSURL *URL, NSString *databaseKey) {
+        [inMemoryKeys addObject:[[WMFInMemoryURLKey alloc] initWithDatabaseKey:databaseKey languageVariantCode:URL.wmf_languageVariantCode]];
+    });
+    return inMemoryKeys;
+}
 @end
 
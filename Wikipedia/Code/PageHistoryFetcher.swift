@@ -51,11 +51,11 @@ public final class PageHistoryFetcher: WMFLegacyFetcher {
                 return nil
             }
             
-            revisionsByDay = parse(revisions: revisions, existingRevisions: revisionsByDay)
+            parse(revisions: revisions, existingRevisions: &revisionsByDay)
             
             if let earliestRevision = revisions.last, earliestRevision.parentID == 0 {
                 earliestRevision.revisionSize = earliestRevision.articleSizeAtRevision
-                HistoryFetchResults.update(revisionsByDay: &revisionsByDay, revision: earliestRevision)
+                revisionsByDay.append(earliestRevision)
             } else {
                 lastRevision = revisions.last
             }
@@ -76,16 +76,12 @@ public final class PageHistoryFetcher: WMFLegacyFetcher {
         return (continueKey, rvContinueKey, batchComplete)
     }
     
-    private typealias RevisionCurrentPrevious = (current: WMFPageHistoryRevision, previous: WMFPageHistoryRevision)
-    private func parse(revisions: [WMFPageHistoryRevision], existingRevisions: RevisionsByDay) -> RevisionsByDay {
-        return zip(revisions, revisions.dropFirst()).reduce(existingRevisions, { (revisionsByDay, itemPair: RevisionCurrentPrevious) -> RevisionsByDay in
-            var revisionsByDay = revisionsByDay
-            
-            itemPair.current.revisionSize = itemPair.current.articleSizeAtRevision - itemPair.previous.articleSizeAtRevision
-            HistoryFetchResults.update(revisionsByDay:&revisionsByDay, revision: itemPair.current)
-            
-            return revisionsByDay
-        })
+    // each revision's size comes from the revision after it, so the last revision waits for the next page
+    private func parse(revisions: [WMFPageHistoryRevision], existingRevisions revisionsByDay: inout RevisionsByDay) {
+        for (current, previous) in zip(revisions, revisions.dropFirst()) {
+            current.revisionSize = current.articleSizeAtRevision - previous.articleSizeAtRevision
+            revisionsByDay.append(current)
+        }
     }
 
     // MARK: Creation date
@@ -254,19 +250,56 @@ public final class PageHistoryFetcher: WMFLegacyFetcher {
 
 }
 
-private typealias RevisionsByDay = [Int: PageHistorySection]
+/// Revisions grouped by their distance in days from today. Revisions arrive newest first, so each one usually joins the last day or starts the next one.
+private struct RevisionsByDay {
+    private var days: [Int] = []
+    private var sectionTitles: [String] = []
+    private var items: [[WMFPageHistoryRevision]] = []
+    private var indexesByDay: [Int: Int] = [:]
+    
+    mutating func append(_ revision: WMFPageHistoryRevision) {
+        guard revision.user != nil else {
+            return
+        }
+        
+        let distanceToToday = revision.daysFromToday()
+        if days.last == distanceToToday {
+            items[items.count - 1].append(revision)
+            return
+        }
+        
+        if let index = indexesByDay[distanceToToday] {
+            items[index].append(revision)
+            return
+        }
+        
+        guard let revisionDate = revision.revisionDate else {
+            return
+        }
+        indexesByDay[distanceToToday] = days.count
+        days.append(distanceToToday)
+        sectionTitles.append(DateFormatter.wmf_long().string(from: revisionDate))
+        items.append([revision])
+    }
+    
+    /// Sections from today back
+    var sections: [PageHistorySection] {
+        return days.indices.sorted { days[$0] < days[$1] }.map { PageHistorySection(sectionTitle: sectionTitles[$0], items: items[$0]) }
+    }
+}
+
 private typealias PagingInfo = (continueKey: String?, rvContinueKey: String?, batchComplete: Bool)
 open class HistoryFetchResults: NSObject {
     fileprivate let pagingInfo: PagingInfo
     let lastRevision: WMFPageHistoryRevision?
-    fileprivate var revisionsByDay: RevisionsByDay
+    private let sections: [PageHistorySection]
     
     @objc open func getPageHistoryRequestParameters(_ articleURL: URL) -> PageHistoryRequestParameters {
         return PageHistoryRequestParameters(title: articleURL.wmf_title ?? "", pagingInfo: pagingInfo, lastRevisionFromPreviousCall: lastRevision)
     }
     
     @objc open func items() -> [PageHistorySection] {
-        return self.revisionsByDay.keys.sorted(by: <).compactMap { self.revisionsByDay[$0] }
+        return sections
     }
     
     @objc open func batchComplete() -> Bool {
@@ -280,7 +313,7 @@ open class HistoryFetchResults: NSObject {
     
     fileprivate init(pagingInfo: PagingInfo, revisionsByDay: RevisionsByDay, lastRevision: WMFPageHistoryRevision?) {
         self.pagingInfo = pagingInfo
-        self.revisionsByDay = revisionsByDay
+        self.sections = revisionsByDay.sections
         self.lastRevision = lastRevision
     }
 }
@@ -303,27 +336,3 @@ open class PageHistoryRequestParameters: NSObject {
         lastRevisionFromPreviousCall = nil
     }
 }
-
-extension HistoryFetchResults {
-    fileprivate static func update(revisionsByDay: inout RevisionsByDay, revision: WMFPageHistoryRevision) {
-        let distanceToToday = revision.daysFromToday()
-        
-        guard revision.user != nil else {
-            return
-        }
-        
-        guard let existingRevisionsOnCurrentDay = revisionsByDay[distanceToToday] else {
-            guard let revisionDate = revision.revisionDate else {
-                return
-            }
-            let sectionTitle = DateFormatter.wmf_long().string(from: revisionDate)
-            let newSection = PageHistorySection(sectionTitle: sectionTitle, items: [revision])
-            revisionsByDay[distanceToToday] = newSection
-            return
-        }
-        
-        let sectionTitle = existingRevisionsOnCurrentDay.sectionTitle
-        let items = existingRevisionsOnCurrentDay.items + [revision]
-        revisionsByDay[distanceToToday] = PageHistorySection(sectionTitle: sectionTitle, items: items)
-    }
-}
@@ -0,0 +1,70 @@
+import Foundation
+
+/// The revisions of a page's history loaded so far, newest first, and the day sections they are shown in.
+/// Revisions are kept in one array with an index from revision ID to position, so neighboring revisions are found without scanning the sections.
+struct PageHistoryTimeline {
+
+    /// Where a page's revisions went
+    struct Update {
+        /// Revisions added to the end of the last section, when the page starts on that section's day
+        let insertedItems: [IndexPath]
+        let insertedSections: IndexSet
+    }
+
+    private(set) var sections: [PageHistorySection] = []
+    private var revisions: [WMFPageHistoryRevision] = []
+    private var positionsByRevisionID: [Int: Int] = [:]
+
+    var revisionCount: Int {
+        return revisions.count
+    }
+
+    /// Appends the sections of the next page. A first section on the same day as the last section is merged into it.
+    mutating func append(_ pageSections: [PageHistorySection]) -> Update {
+        var pageSections = pageSections[...]
+        var insertedItems: [IndexPath] = []
+
+        if let lastSection = sections.last,
+           let firstPageSection = pageSections.first,
+           firstPageSection.sectionTitle == lastSection.sectionTitle {
+            let sectionIndex = sections.count - 1
+            insertedItems = (lastSection.items.count..<lastSection.items.count + firstPageSection.items.count).map { IndexPath(item: $0, section: sectionIndex) }
+            sections[sectionIndex] = PageHistorySection(sectionTitle: lastSection.sectionTitle, items: lastSection.items + firstPageSection.items)
+            appendRevisions(firstPageSection.items)
+            pageSections = pageSections.dropFirst()
+        }
+
+        let firstInsertedSection = sections.count
+        for section in pageSections {
+            sections.append(section)
+            appendRevisions(section.items)
+        }
+
+        return Update(insertedItems: insertedItems, insertedSections: IndexSet(integersIn: firstInsertedSection..<sections.count))
+    }
+
+    /// The revision made before the revision with `revisionID`, which is the next one down the timeline
+    func revision(before revisionID: Int) -> WMFPageHistoryRevision? {
+        guard let position = positionsByRevisionID[revisionID] else {
+            return nil
+        }
+        return revisions[safeIndex: position + 1]
+    }
+
+    /// The revision made after the revision with `revisionID`, which is the next one up the timeline
+    func revision(after revisionID: Int) -> WMFPageHistoryRevision? {
+        guard let position = positionsByRevisionID[revisionID] else {
+            return nil
+        }
+        return revisions[safeIndex: position - 1]
+    }
+
+    private mutating func appendRevisions(_ items: [WMFPageHistoryRevision]) {
+        for revision in items {
+            if positionsByRevisionID[revision.revisionID] == nil {
+                positionsByRevisionID[revision.revisionID] = revisions.count
+            }
+            revisions.append(revision)
+        }
+    }
+}
@@ -28,12 +28,18 @@ class PageHistoryViewController: ColumnarCollectionViewController {
 
     private var batchComplete = false
     private var isLoadingData = false
+    /// Set when the visible range reached the end of the timeline, so the page being fetched is shown as soon as it loads
+    private var isWaitingForPage = false
+    /// The page after the timeline, fetched ahead of scrolling to it
+    private var prefetchedResults: HistoryFetchResults?
+    /// Incremented by a refresh, so pages requested before it are dropped
+    private var fetchGeneration = 0
 
     private var cellLayoutEstimate: ColumnarCollectionViewLayoutHeightEstimate?
     private var firstRevision: WMFPageHistoryRevision?
 
     var shouldLoadNewData: Bool {
-        if batchComplete || isLoadingData {
+        if isWaitingForPage || (batchComplete && prefetchedResults == nil) {
             return false
         }
         let maxY = collectionView.contentOffset.y + collectionView.frame.size.height + 200.0
@@ -63,7 +69,7 @@ class PageHistoryViewController: ColumnarCollectionViewController {
         fatalError("init(coder:) has not been implemented")
     }
 
-    private var pageHistorySections: [PageHistorySection] = []
+    private var timeline = PageHistoryTimeline()
 
     override var headerStyle: ColumnarCollectionViewController.HeaderStyle {
         return .sections
@@ -263,43 +269,68 @@ class PageHistoryViewController: ColumnarCollectionViewController {
     
     private func appendSections(from results: HistoryFetchResults) {
         assert(Thread.isMainThread)
-        var items = results.items()
-        guard
-            let last = self.pageHistorySections.last,
-            let first = items.first,
-            first.sectionTitle == last.sectionTitle // maybe not the best metric
-        else {
-            self.pageHistorySections.append(contentsOf: items)
+        let pageSections = results.items()
+        collectionView.performBatchUpdates({
+            let update = self.timeline.append(pageSections)
+            self.collectionView.insertItems(at: update.insertedItems)
+            self.collectionView.insertSections(update.insertedSections)
+        })
+    }
+    
+    // Shows the prefetched page if there is one, otherwise the next page once it loads
+    private func getPageHistory() {
+        if let prefetchedResults = prefetchedResults {
+            self.prefetchedResults = nil
+            appendSections(from: prefetchedResults)
+            fetchNextPage()
+            return
+        }
+
+        guard !batchComplete else {
             return
         }
-        var lastItems = last.items
-        let firstItems = first.items
-        lastItems.append(contentsOf: firstItems)
-        let combinedSection = PageHistorySection(sectionTitle: first.sectionTitle, items: lastItems)
-        self.pageHistorySections.removeLast()
-        self.pageHistorySections.append(combinedSection)
-        items.removeFirst()
-        self.pageHistorySections.append(contentsOf: items)
+
+        isWaitingForPage = true
+        fetchNextPage()
     }
     
-    private func getPageHistory() {
+    // Keeps one page ahead of the timeline: a page nobody is waiting for is kept until scrolling reaches it
+    private func fetchNextPage() {
+        guard !isLoadingData, !batchComplete else {
+            return
+        }
+        
         isLoadingData = true
-
+        let fetchGeneration = self.fetchGeneration
+        
         pageHistoryFetcher.fetchRevisionInfo(pageURL, requestParams: pageHistoryFetcherParams, failure: { [weak self] error in
             DispatchQueue.main.async {
-                guard let self = self else {
+                guard let self = self,
+                      self.fetchGeneration == fetchGeneration else {
                     return
                 }
                 self.isLoadingData = false
-                self.showNoInternetConnectionAlertOrOtherWarning(from: error)
+                if self.isWaitingForPage {
+                    self.isWaitingForPage = false
+                    self.showNoInternetConnectionAlertOrOtherWarning(from: error)
+                }
             }
-        }) { results in
+        }) { [weak self] results in
             DispatchQueue.main.async {
-                self.appendSections(from: results)
+                guard let self = self,
+                      self.fetchGeneration == fetchGeneration else {
+                    return
+                }
                 self.pageHistoryFetcherParams = results.getPageHistoryRequestParameters(self.pageURL)
                 self.batchComplete = results.batchComplete()
                 self.isLoadingData = false
-                self.collectionView.reloadData()
+                if self.isWaitingForPage {
+                    self.isWaitingForPage = false
+                    self.appendSections(from: results)
+                    self.fetchNextPage()
+                } else {
+                    self.prefetchedResults = results
+                }
             }
         }
     }
@@ -358,11 +389,11 @@ class PageHistoryViewController: ColumnarCollectionViewController {
     // MARK: UICollectionViewDataSource
 
     override func numberOfSections(in collectionView: UICollectionView) -> Int {
-        return pageHistorySections.count
+        return timeline.sections.count
     }
 
     override func collectionView(_ collectionView: UICollectionView, numberOfItemsInSection section: Int) -> Int {
-        return pageHistorySections[section].items.count
+        return timeline.sections[section].items.count
     }
 
     override func collectionView(_ collectionView: UICollectionView, cellForItemAt indexPath: IndexPath) -> UICollectionViewCell {
@@ -374,7 +405,7 @@ class PageHistoryViewController: ColumnarCollectionViewController {
     }
 
     override func configure(header: CollectionViewHeader, forSectionAt sectionIndex: Int, layoutOnly: Bool) {
-        let section = pageHistorySections[sectionIndex]
+        let section = timeline.sections[sectionIndex]
         let sectionTitle: String?
 
         if sectionIndex == 0, let date = section.items.first?.revisionDate {
@@ -418,7 +449,7 @@ class PageHistoryViewController: ColumnarCollectionViewController {
     }
 
     private func configure(cell: PageHistoryCollectionViewCell, for item: WMFPageHistoryRevision? = nil, at indexPath: IndexPath) {
-        let item = item ?? pageHistorySections[indexPath.section].items[indexPath.item]
+        let item = item ?? timeline.sections[indexPath.section].items[indexPath.item]
         let revisionID = NSNumber(value: item.revisionID)
         let isSelected = indexPathsSelectedForComparison.contains(indexPath)
         defer {
@@ -488,7 +519,7 @@ class PageHistoryViewController: ColumnarCollectionViewController {
     }
 
     private func revisionID(forItemAtIndexPath indexPath: IndexPath) -> NSNumber {
-        let item = pageHistorySections[indexPath.section].items[indexPath.item]
+        let item = timeline.sections[indexPath.section].items[indexPath.item]
         return NSNumber(value: item.revisionID)
     }
 
@@ -566,7 +597,7 @@ class PageHistoryViewController: ColumnarCollectionViewController {
 
     override func collectionView(_ collectionView: UICollectionView, estimatedHeightForItemAt indexPath: IndexPath, forColumnWidth columnWidth: CGFloat) -> ColumnarCollectionViewLayoutHeightEstimate {
         let identifier = PageHistoryCollectionViewCell.identifier
-        let item = pageHistorySections[indexPath.section].items[indexPath.item]
+        let item = timeline.sections[indexPath.section].items[indexPath.item]
         let userInfo = "phc-cell-\(item.revisionID)"
         if let cachedHeight = layoutCache.cachedHeightForCellWithIdentifier(identifier, columnWidth: columnWidth, userInfo: userInfo) {
             return ColumnarCollectionViewLayoutHeightEstimate(precalculated: true, height: cachedHeight)
@@ -609,29 +640,17 @@ class PageHistoryViewController: ColumnarCollectionViewController {
     
     private func pushToSingleRevisionDiff(indexPath: IndexPath) {
         
-        guard let section = pageHistorySections[safeIndex: indexPath.section] else {
+        guard let toRevision = timeline.sections[safeIndex: indexPath.section]?.items[safeIndex: indexPath.item] else {
             return
         }
         
-        if let toRevision = section.items[safeIndex: indexPath.item] {
-
-            var sectionOffset = 0
-            var fromItemIndex = indexPath.item + 1
-            // if last revision in section, go to next section for selecting second
-            let isLastInSection = indexPath.item == section.items.count - 1
-            
-            if isLastInSection {
-                sectionOffset = 1
-                fromItemIndex = 0
-            }
-            
-            let fromRevision = pageHistorySections[safeIndex: indexPath.section + sectionOffset]?.items[safeIndex: fromItemIndex]
+        // the revision below, which may be first in the next section
+        let fromRevision = timeline.revision(before: toRevision.revisionID)
 
-            if fromRevision == nil {
-                showDiff(from: fromRevision, to: toRevision, type: .single)
-            } else {
-                showDiff(from: fromRevision, to: toRevision, type: .compare)
-            }
+        if fromRevision == nil {
+            showDiff(from: fromRevision, to: toRevision, type: .single)
+        } else {
+            showDiff(from: fromRevision, to: toRevision, type: .compare)
         }
     }
 
@@ -769,8 +788,8 @@ extension PageHistoryViewController: PageHistoryComparisonSelectionViewControlle
         guard let firstIndexPath = indexPathsSelectedForComparisonGroupedByButtonTags[SelectionOrder.first.rawValue], let secondIndexPath = indexPathsSelectedForComparisonGroupedByButtonTags[SelectionOrder.second.rawValue] else {
             return
         }
-        let revision1 = pageHistorySections[firstIndexPath.section].items[firstIndexPath.item]
-        let revision2 = pageHistorySections[secondIndexPath.section].items[secondIndexPath.item]
+        let revision1 = timeline.sections[firstIndexPath.section].items[firstIndexPath.item]
+        let revision2 = timeline.sections[secondIndexPath.section].items[secondIndexPath.item]
 
         guard let date1 = revision1.revisionDate,
             let date2 = revision2.revisionDate else {
@@ -794,64 +813,23 @@ extension PageHistoryViewController: PageHistoryComparisonSelectionViewControlle
 
 extension PageHistoryViewController: DiffRevisionRetrieving {
     func retrievePreviousRevision(with sourceRevision: WMFPageHistoryRevision) -> WMFPageHistoryRevision? {
-        
-        for (sectionIndex, section) in pageHistorySections.enumerated() {
-            for (itemIndex, item) in section.items.enumerated() {
-                
-                if item.revisionID == sourceRevision.revisionID {
-                    if itemIndex == (section.items.count - 1) {
-                        return pageHistorySections[safeIndex: sectionIndex + 1]?.items.first
-                    } else {
-                        return section.items[safeIndex: itemIndex + 1]
-                    }
-                }
-            }
-        }
-        
-        return nil
+        return timeline.revision(before: sourceRevision.revisionID)
     }
     
     func retrieveNextRevision(with sourceRevision: WMFPageHistoryRevision) -> WMFPageHistoryRevision? {
-        
-        var previousSection: PageHistorySection?
-        var previousItem: WMFPageHistoryRevision?
-        
-        for section in pageHistorySections {
-            for item in section.items {
-        
-                if item.revisionID == sourceRevision.revisionID {
-                    
-                    guard let previousItem = previousItem else {
-                        
-                        guard let previousSection = previousSection else {
-                            
-                            // user tapped latest revision, no later revision available.
-                            return nil
-                        }
-                        
-                        return previousSection.items.last
-                        
-                    }
-                        
-                    return previousItem
-                    
-                }
-                
-                previousItem = item
-            }
-            
-            previousSection = section
-            previousItem = nil
-        }
-        
-        return nil
-        
+        return timeline.revision(after: sourceRevision.revisionID)
     }
     
     func refreshRevisions() {
-        self.pageHistorySections.removeAll()
-        self.collectionView.reloadData()
-        self.getPageHistory()
+        fetchGeneration += 1
+        timeline = PageHistoryTimeline()
+        pageHistoryFetcherParams = PageHistoryRequestParameters(title: pageTitle)
+        batchComplete = false
+        isLoadingData = false
+        isWaitingForPage = false
+        prefetchedResults = nil
+        collectionView.reloadData()
+        getPageHistory()
     }
     
 }
@@ -3,6 +3,16 @@ import WMF
 
 @objc public class SharedContainerCacheHousekeeping: NSObject, SharedContainerCacheHousekeepingProtocol {
     public static func deleteStaleCachedItems(in subdirectoryPathComponent: String, cleanupLevel: WMFCleanupLevel) {
+        guard subdirectoryPathComponent != SharedContainerCacheCommonNames.talkPageCache else {
+            // Talk pages keep an index of access dates instead of relying on file modification dates
+            TalkPageCacheStore.shared.deleteStaleCachedItems(cleanupLevel: cleanupLevel)
+            return
+        }
+        guard subdirectoryPathComponent != SharedContainerCacheCommonNames.significantEventsCache else {
+            // Significant events timelines are kept in a directory per article
+            SignificantEventsTimelineStore.shared.deleteStaleCachedItems(cleanupLevel: cleanupLevel)
+            return
+        }
         SharedContainerCache.deleteStaleCachedItems(in: subdirectoryPathComponent, cleanupLevel: cleanupLevel)
     }
 }
@@ -1,10 +1,266 @@
 import Foundation
 
+/// Legacy JSON representation of a cached talk page. Only read to migrate caches written before `TalkPageCacheFile`.
 struct TalkPageCache: Codable {
-    
+
     var talkPageItems: [TalkPageItem]
-    
+
     init(talkPages: [TalkPageItem]) {
         self.talkPageItems = talkPages
     }
 }
+
+enum TalkPageCacheFileError: Error {
+    case invalidHeader
+    case unsupportedVersion
+    case truncated
+    case invalidString
+    case invalidItemType
+}
+
+/// Binary, length-prefixed representation of a cached talk page.
+///
+/// Layout (all integers little endian):
+/// ```
+/// magic "WTPC" | version UInt16 | topic count UInt32
+/// topic count × (offset UInt64, length UInt32)   -- offsets are relative to the start of the file
+/// topic records
+/// ```
+/// Each topic record is a `TalkPageItem` with its replies nested inside it, so topics can be decoded independently of one another.
+enum TalkPageCacheFile {
+
+    static let magic: [UInt8] = Array("WTPC".utf8)
+    static let version: UInt16 = 1
+
+    private static let headerLength = magic.count + MemoryLayout<UInt16>.size + MemoryLayout<UInt32>.size
+    private static let offsetTableEntryLength = MemoryLayout<UInt64>.size + MemoryLayout<UInt32>.size
+
+    static func encode(_ topics: [TalkPageItem]) -> Data {
+        var records: [Data] = []
+        records.reserveCapacity(topics.count)
+        for topic in topics {
+            var writer = ByteWriter()
+            writer.write(topic)
+            records.append(writer.data)
+        }
+
+        var writer = ByteWriter()
+        writer.write(bytes: magic)
+        writer.write(version)
+        writer.write(UInt32(topics.count))
+
+        var offset = UInt64(headerLength + (offsetTableEntryLength * topics.count))
+        for record in records {
+            writer.write(offset)
+            writer.write(UInt32(record.count))
+            offset += UInt64(record.count)
+        }
+
+        for record in records {
+            writer.write(data: record)
+        }
+
+        return writer.data
+    }
+
+    /// Decodes topics from a cache file on demand. Only the header and offset table are read up front.
+    final class Reader {
+
+        private let data: Data
+        private let topicRanges: [Range<Int>]
+        private var decodedTopics: [Int: TalkPageItem] = [:]
+        private let lock = NSLock()
+
+        var topicCount: Int {
+            return topicRanges.count
+        }
+
+        /// - Parameter data: the contents of a cache file. Pass mapped data to avoid reading topics that are never decoded.
+        init(data: Data) throws {
+            self.data = data
+            var reader = ByteReader(data: data)
+            guard try reader.readBytes(count: TalkPageCacheFile.magic.count) == TalkPageCacheFile.magic else {
+                throw TalkPageCacheFileError.invalidHeader
+            }
+            guard try reader.read(UInt16.self) == TalkPageCacheFile.version else {
+                throw TalkPageCacheFileError.unsupportedVersion
+            }
+
+            let count = Int(try reader.read(UInt32.self))
+            guard count <= (data.count - TalkPageCacheFile.headerLength) / TalkPageCacheFile.offsetTableEntryLength else {
+                throw TalkPageCacheFileError.truncated
+            }
+
+            var topicRanges: [Range<Int>] = []
+            topicRanges.reserveCapacity(count)
+            for _ in 0..<count {
+                let offset = Int(try reader.read(UInt64.self))
+                let length = Int(try reader.read(UInt32.self))
+                guard offset >= 0, length >= 0, offset + length <= data.count else {
+                    throw TalkPageCacheFileError.truncated
+                }
+                topicRanges.append(offset..<(offset + length))
+            }
+            self.topicRanges = topicRanges
+        }
+
+        func topic(at index: Int) throws -> TalkPageItem {
+            lock.lock()
+            defer {
+                lock.unlock()
+            }
+
+            if let topic = decodedTopics[index] {
+                return topic
+            }
+
+            let range = topicRanges[index]
+            var reader = ByteReader(data: data, range: range)
+            let topic = try reader.readItem()
+            decodedTopics[index] = topic
+            return topic
+        }
+
+        func topics(in range: Range<Int>) throws -> [TalkPageItem] {
+            let clampedRange = range.clamped(to: 0..<topicCount)
+            return try clampedRange.map { try topic(at: $0) }
+        }
+
+        func allTopics() throws -> [TalkPageItem] {
+            return try topics(in: 0..<topicCount)
+        }
+    }
+}
+
+// MARK: - Byte coding
+
+private struct ByteWriter {
+    private(set) var data = Data()
+
+    mutating func write(bytes: [UInt8]) {
+        data.append(contentsOf: bytes)
+    }
+
+    mutating func write(data other: Data) {
+        data.append(other)
+    }
+
+    mutating func write<T: FixedWidthInteger>(_ value: T) {
+        withUnsafeBytes(of: value.littleEndian) { data.append(contentsOf: $0) }
+    }
+
+    mutating func write(_ value: String) {
+        let utf8 = Array(value.utf8)
+        write(UInt32(utf8.count))
+        write(bytes: utf8)
+    }
+
+    mutating func write(_ value: TalkPageItem) {
+        var flags: UInt8 = 0
+        flags |= value.type == .heading ? 1 : 0
+        flags |= value.level != nil ? 1 << 1 : 0
+        flags |= value.html != nil ? 1 << 2 : 0
+        flags |= value.name != nil ? 1 << 3 : 0
+        flags |= value.headingLevel != nil ? 1 << 4 : 0
+        flags |= value.otherContent != nil ? 1 << 5 : 0
+        flags |= value.author != nil ? 1 << 6 : 0
+        flags |= value.timestamp != nil ? 1 << 7 : 0
+        write(flags)
+        write(value.id)
+        if let level = value.level {
+            write(Int64(level))
+        }
+        if let html = value.html {
+            write(html)
+        }
+        if let name = value.name {
+            write(name)
+        }
+        if let headingLevel = value.headingLevel {
+            write(Int64(headingLevel))
+        }
+        if let otherContent = value.otherContent {
+            write(otherContent)
+        }
+        if let author = value.author {
+            write(author)
+        }
+        if let timestamp = value.timestamp {
+            write(timestamp.timeIntervalSinceReferenceDate.bitPattern)
+        }
+        write(UInt32(value.replies.count))
+        for reply in value.replies {
+            write(reply)
+        }
+    }
+}
+
+private struct ByteReader {
+    private let data: Data
+    private var offset: Int
+    private let endOffset: Int
+
+    init(data: Data, range: Range<Int>? = nil) {
+        self.data = data
+        let range = range ?? 0..<data.count
+        self.offset = data.startIndex + range.lowerBound
+        self.endOffset = data.startIndex + range.upperBound
+    }
+
+    mutating func readBytes(count: Int) throws -> [UInt8] {
+        guard count >= 0, offset + count <= endOffset else {
+            throw TalkPageCacheFileError.truncated
+        }
+        let bytes = [UInt8](data[offset..<(offset + count)])
+        offset += count
+        return bytes
+    }
+
+    mutating func read<T: FixedWidthInteger>(_ type: T.Type) throws -> T {
+        let size = MemoryLayout<T>.size
+        guard offset + size <= endOffset else {
+            throw TalkPageCacheFileError.truncated
+        }
+        var value: T = 0
+        _ = withUnsafeMutableBytes(of: &value) { data.copyBytes(to: $0, from: offset..<(offset + size)) }
+        offset += size
+        return T(littleEndian: value)
+    }
+
+    mutating func readString() throws -> String {
+        let length = Int(try read(UInt32.self))
+        guard offset + length <= endOffset else {
+            throw TalkPageCacheFileError.truncated
+        }
+        guard let string = String(data: data[offset..<(offset + length)], encoding: .utf8) else {
+            throw TalkPageCacheFileError.invalidString
+        }
+        offset += length
+        return string
+    }
+
+    mutating func readItem() throws -> TalkPageItem {
+        let flags = try read(UInt8.self)
+        let id = try readString()
+        let level = flags & (1 << 1) != 0 ? Int(try read(Int64.self)) : nil
+        let html = flags & (1 << 2) != 0 ? try readString() : nil
+        let name = flags & (1 << 3) != 0 ? try readString() : nil
+        let headingLevel = flags & (1 << 4) != 0 ? Int(try read(Int64.self)) : nil
+        let otherContent = flags & (1 << 5) != 0 ? try readString() : nil
+        let author = flags & (1 << 6) != 0 ? try readString() : nil
+        let timestamp = flags & (1 << 7) != 0 ? Date(timeIntervalSinceReferenceDate: Double(bitPattern: try read(UInt64.self))) : nil
+
+        let replyCount = Int(try read(UInt32.self))
+        // Every reply takes at least a flags byte, a string length and a reply count
+        guard replyCount <= (endOffset - offset) / 9 else {
+            throw TalkPageCacheFileError.truncated
+        }
+        var replies: [TalkPageItem] = []
+        replies.reserveCapacity(replyCount)
+        for _ in 0..<replyCount {
+            replies.append(try readItem())
+        }
+
+        return TalkPageItem(type: flags & 1 != 0 ? .heading : .comment, level: level, id: id, html: html, name: name, headingLevel: headingLevel, replies: replies, otherContent: otherContent, author: author, timestamp: timestamp)
+    }
+}
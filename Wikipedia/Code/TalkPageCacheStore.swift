@@ -0,0 +1,172 @@
+import Foundation
+import WMF
+import CocoaLumberjackSwift
+
+/// Reads and writes `TalkPageCacheFile`s in the shared container's talk page cache directory.
+/// Keeps an index of last access dates so stale pages can be evicted without listing and statting the directory.
+final class TalkPageCacheStore {
+
+    static let shared = TalkPageCacheStore()
+
+    /// Number of talk pages kept by `deleteStaleCachedItems` at the low cleanup level
+    static let maxCachedTalkPageCount = 50
+
+    private static let fileExtension = "talkpage"
+    private static let legacyFileExtension = "json"
+    private static let indexFileName = ".TalkPageCacheIndex.plist"
+
+    private let directoryURL: URL
+    private let queue = DispatchQueue(label: "org.wikipedia.talkpage.cacheStore")
+
+    // Only accessed on queue
+    private var lastAccessDatesByFileName: [String: Date]?
+
+    init(directoryURL: URL = FileManager.default.wmf_containerURL().appendingPathComponent(SharedContainerCacheCommonNames.talkPageCache, isDirectory: true)) {
+        self.directoryURL = directoryURL
+    }
+
+    // MARK: - Public
+
+    /// Returns a reader for the cached talk page, migrating a legacy JSON cache if needed. Only the file's offset table is read.
+    func reader(for fileName: String) -> TalkPageCacheFile.Reader? {
+        return queue.sync {
+            let fileURL = self.fileURL(for: fileName)
+            if let data = try? Data(contentsOf: fileURL, options: .alwaysMapped) {
+                do {
+                    let reader = try TalkPageCacheFile.Reader(data: data)
+                    touch(fileName)
+                    return reader
+                } catch let error {
+                    DDLogError("Unable to read talk page cache, removing: \(error)")
+                    try? FileManager.default.removeItem(at: fileURL)
+                    removeFromIndex(fileName)
+                    return nil
+                }
+            }
+
+            return migrateLegacyCache(for: fileName)
+        }
+    }
+
+    func save(_ topics: [TalkPageItem], for fileName: String) {
+        let data = TalkPageCacheFile.encode(topics)
+        queue.async {
+            do {
+                try FileManager.default.createDirectory(at: self.directoryURL, withIntermediateDirectories: true, attributes: nil)
+                try data.write(to: self.fileURL(for: fileName), options: .atomic)
+                self.touch(fileName)
+            } catch let error {
+                DDLogError("Unable to save talk page cache: \(error)")
+            }
+        }
+    }
+
+    /// Deletes the least recently accessed talk pages beyond the limit for the cleanup level
+    func deleteStaleCachedItems(cleanupLevel: WMFCleanupLevel) {
+        let maxCount = cleanupLevel == .high ? 0 : Self.maxCachedTalkPageCount
+        queue.sync {
+            var index = loadIndex()
+            guard index.count > maxCount else {
+                return
+            }
+
+            let fileNamesToDelete = index.sorted(by: { $0.value > $1.value }).suffix(from: maxCount).map { $0.key }
+            for fileName in fileNamesToDelete {
+                try? FileManager.default.removeItem(at: fileURL(for: fileName))
+                try? FileManager.default.removeItem(at: legacyFileURL(for: fileName))
+                index.removeValue(forKey: fileName)
+            }
+            saveIndex(index)
+        }
+    }
+
+    // MARK: - Private (on queue)
+
+    private func fileURL(for fileName: String) -> URL {
+        return directoryURL.appendingPathComponent(fileName).appendingPathExtension(Self.fileExtension)
+    }
+
+    private func legacyFileURL(for fileName: String) -> URL {
+        return directoryURL.appendingPathComponent(fileName).appendingPathExtension(Self.legacyFileExtension)
+    }
+
+    private var indexFileURL: URL {
+        return directoryURL.appendingPathComponent(Self.indexFileName)
+    }
+
+    private func migrateLegacyCache(for fileName: String) -> TalkPageCacheFile.Reader? {
+        let legacyFileURL = legacyFileURL(for: fileName)
+        guard let legacyData = try? Data(contentsOf: legacyFileURL) else {
+            return nil
+        }
+
+        try? FileManager.default.removeItem(at: legacyFileURL)
+
+        guard let legacyCache = try? JSONDecoder().decode(TalkPageCache.self, from: legacyData) else {
+            removeFromIndex(fileName)
+            return nil
+        }
+
+        let data = TalkPageCacheFile.encode(legacyCache.talkPageItems)
+        try? data.write(to: fileURL(for: fileName), options: .atomic)
+        touch(fileName)
+        return try? TalkPageCacheFile.Reader(data: data)
+    }
+
+    private func touch(_ fileName: String) {
+        var index = loadIndex()
+        index[fileName] = Date()
+        saveIndex(index)
+    }
+
+    private func removeFromIndex(_ fileName: String) {
+        var index = loadIndex()
+        guard index.removeValue(forKey: fileName) != nil else {
+            return
+        }
+        saveIndex(index)
+    }
+
+    private func loadIndex() -> [String: Date] {
+        if let lastAccessDatesByFileName {
+            return lastAccessDatesByFileName
+        }
+
+        let index: [String: Date]
+        if let data = try? Data(contentsOf: indexFileURL),
+           let decodedIndex = try? PropertyListDecoder().decode([String: Date].self, from: data) {
+            index = decodedIndex
+        } else {
+            index = rebuildIndex()
+        }
+        lastAccessDatesByFileName = index
+        return index
+    }
+
+    private func saveIndex(_ index: [String: Date]) {
+        lastAccessDatesByFileName = index
+        do {
+            try FileManager.default.createDirectory(at: directoryURL, withIntermediateDirectories: true, attributes: nil)
+            let encoder = PropertyListEncoder()
+            encoder.outputFormat = .binary
+            try encoder.encode(index).write(to: indexFileURL, options: .atomic)
+        } catch let error {
+            DDLogError("Unable to save talk page cache index: \(error)")
+        }
+    }
+
+    /// One-time directory scan for caches written before the index existed
+    private func rebuildIndex() -> [String: Date] {
+        guard let urls = try? FileManager.default.contentsOfDirectory(at: directoryURL, includingPropertiesForKeys: [.contentModificationDateKey], options: .skipsHiddenFiles) else {
+            return [:]
+        }
+
+        var index: [String: Date] = [:]
+        for url in urls where url.pathExtension == Self.fileExtension || url.pathExtension == Self.legacyFileExtension {
+            let fileName = url.deletingPathExtension().lastPathComponent
+            let modificationDate = (try? url.resourceValues(forKeys: [.contentModificationDateKey]))?.contentModificationDate ?? Date.distantPast
+            index[fileName] = max(index[fileName] ?? Date.distantPast, modificationDate)
+        }
+        return index
+    }
+}
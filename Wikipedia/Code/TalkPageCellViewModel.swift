@@ -64,17 +64,13 @@ final class TalkPageCellViewModel: Identifiable {
     }
 
     func topicTitleAttributedString(traitCollection: UITraitCollection, theme: Theme = .light) -> NSAttributedString {
-        let styles = HtmlUtils.Styles(font: WMFFont.for(.headline, compatibleWith: traitCollection), boldFont: WMFFont.for(.boldHeadline, compatibleWith: traitCollection), italicsFont: WMFFont.for(.headline, compatibleWith: traitCollection), boldItalicsFont: WMFFont.for(.boldHeadline, compatibleWith: traitCollection), color: theme.colors.primaryText, linkColor: theme.colors.link, lineSpacing: 1)
-        return NSAttributedString.attributedStringFromHtml(topicTitleHtml, styles: styles)
+        return Self.topicTitleAttributedString(html: topicTitleHtml, styles: Self.topicTitleStyles(traitCollection: traitCollection, theme: theme))
     }
     
     func leadCommentAttributedString(traitCollection: UITraitCollection, theme: Theme) -> NSAttributedString? {
         if let leadComment = leadComment {
             let commentColor = isThreadExpanded ? theme.colors.primaryText : theme.colors.secondaryText
-            let styles = HtmlUtils.Styles(font: WMFFont.for(.callout, compatibleWith: traitCollection), boldFont: WMFFont.for(.boldCallout, compatibleWith: traitCollection), italicsFont: WMFFont.for(.italicCallout, compatibleWith: traitCollection), boldItalicsFont: WMFFont.for(.boldItalicCallout, compatibleWith: traitCollection), color: commentColor, linkColor: theme.colors.link, lineSpacing: 1)
-            let leadCommentFormatted = NSMutableAttributedString.mutableAttributedStringFromHtml(leadComment.html, styles: styles).removingInitialNewlineCharacters()
-
-            return leadCommentFormatted
+            return Self.commentAttributedString(html: leadComment.html, styles: Self.commentStyles(traitCollection: traitCollection, theme: theme, color: commentColor))
         }
         
         return nil
@@ -82,13 +78,32 @@ final class TalkPageCellViewModel: Identifiable {
     
     func otherContentAttributedString(traitCollection: UITraitCollection, theme: Theme) -> NSAttributedString? {
         if let otherContentHtml = otherContentHtml {
-            let styles = HtmlUtils.Styles(font: WMFFont.for(.callout, compatibleWith: traitCollection), boldFont: WMFFont.for(.boldCallout, compatibleWith: traitCollection), italicsFont: WMFFont.for(.italicCallout, compatibleWith: traitCollection), boldItalicsFont: WMFFont.for(.boldItalicCallout, compatibleWith: traitCollection), color: theme.colors.primaryText, linkColor: theme.colors.link, lineSpacing: 1)
-            return NSMutableAttributedString.mutableAttributedStringFromHtml(otherContentHtml, styles: styles).removingInitialNewlineCharacters()
-
+            return Self.commentAttributedString(html: otherContentHtml, styles: Self.commentStyles(traitCollection: traitCollection, theme: theme))
         }
         
         return nil
     }
+    
+    // MARK: - Rendering
+    
+    // Styles are created on the main thread. Rendering with them is safe on any thread.
+    
+    static func topicTitleStyles(traitCollection: UITraitCollection, theme: Theme) -> HtmlUtils.Styles {
+        return HtmlUtils.Styles(font: WMFFont.for(.headline, compatibleWith: traitCollection), boldFont: WMFFont.for(.boldHeadline, compatibleWith: traitCollection), italicsFont: WMFFont.for(.headline, compatibleWith: traitCollection), boldItalicsFont: WMFFont.for(.boldHeadline, compatibleWith: traitCollection), color: theme.colors.primaryText, linkColor: theme.colors.link, lineSpacing: 1)
+    }
+    
+    /// Styles for lead comments, replies and other content
+    static func commentStyles(traitCollection: UITraitCollection, theme: Theme, color: UIColor? = nil) -> HtmlUtils.Styles {
+        return HtmlUtils.Styles(font: WMFFont.for(.callout, compatibleWith: traitCollection), boldFont: WMFFont.for(.boldCallout, compatibleWith: traitCollection), italicsFont: WMFFont.for(.italicCallout, compatibleWith: traitCollection), boldItalicsFont: WMFFont.for(.boldItalicCallout, compatibleWith: traitCollection), color: color ?? theme.colors.primaryText, linkColor: theme.colors.link, lineSpacing: 1)
+    }
+    
+    static func topicTitleAttributedString(html: String, styles: HtmlUtils.Styles) -> NSAttributedString {
+        return NSAttributedString.attributedStringFromHtml(html, styles: styles)
+    }
+    
+    static func commentAttributedString(html: String, styles: HtmlUtils.Styles) -> NSAttributedString {
+        return NSMutableAttributedString.mutableAttributedStringFromHtml(html, styles: styles).removingInitialNewlineCharacters()
+    }
 }
 
 extension TalkPageCellViewModel: Hashable {
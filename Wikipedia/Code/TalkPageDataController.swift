@@ -143,8 +143,8 @@ class TalkPageDataController {
 
     private func fetchTalkPageItems(dispatchGroup group: DispatchGroup, completion: @escaping ([TalkPageItem], [Error]) -> Void) {
         
-        let sharedCache = SharedContainerCache.init(fileName: cachedFileName(), subdirectoryPathComponent: SharedContainerCacheCommonNames.talkPageCache)
-        var cache = sharedCache.loadCache() ?? TalkPageCache(talkPages: [])
+        let cacheStore = TalkPageCacheStore.shared
+        let fileName = cachedFileName()
         
         group.enter()
         talkPageFetcher.fetchTalkPageContent(talkPageTitle: pageTitle, siteURL: siteURL) { result in
@@ -156,11 +156,18 @@ class TalkPageDataController {
                 
                 switch result {
                 case .success(let items):
-                    cache.talkPageItems = items
-                    sharedCache.saveCache(cache)
+                    cacheStore.save(items, for: fileName)
                     completion(items, [])
                 case .failure(let error):
-                    completion(cache.talkPageItems, [error])
+                    // The cache is only a fallback for failed fetches, so it isn't opened until one fails
+                    let cachedItems: [TalkPageItem]
+                    do {
+                        cachedItems = try cacheStore.reader(for: fileName)?.allTopics() ?? []
+                    } catch let cacheError {
+                        DDLogError("Error decoding cached talk page: \(cacheError)")
+                        cachedItems = []
+                    }
+                    completion(cachedItems, [error])
                 }
             }
         }
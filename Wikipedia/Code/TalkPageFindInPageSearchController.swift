@@ -33,72 +33,63 @@ final class TalkPageFindInPageSearchController {
 
     }
 
+    // MARK: - Properties
+
+    private let indexQueue = DispatchQueue(label: "org.wikipedia.talkpage.findInPageIndex", qos: .userInitiated)
+
+    // Topics of the most recently requested index, only accessed on the main thread
+    private var indexedTopicIdentifiers: [ObjectIdentifier]?
+
+    // Only accessed on indexQueue
+    private var index: TalkPageFindInPageSearchIndex?
+    private var lastQuery: TalkPageFindInPageSearchIndex.Query?
+
     // MARK: - Public
 
-    /// Search for occurrences of a text term in `[TalkPageCellViewModel]` hierarchy
+    /// Builds the search index for a freshly fetched set of topics on a background queue, replacing any existing index. Call on the main thread.
+    /// Searches requested before the build finishes wait for it.
+    /// - Parameters:
+    ///   - topics: an ordered array of topics
+    func prepareIndex(for topics: [TalkPageCellViewModel], traitCollection: UITraitCollection, theme: Theme) {
+        enqueueIndexBuild(for: topics, traitCollection: traitCollection, theme: theme)
+    }
+
+    /// Search for occurrences of a text term in `[TalkPageCellViewModel]` hierarchy. Call on the main thread.
+    /// Runs on the index queue after any index build in progress. The index is only rebuilt, also on the index queue, if it was prepared for other topics. When the term extends the previous term, only the previous results are searched.
     /// - Parameters:
     ///   - searchTerm: the term to locate, case insensitive
     ///   - topics: an ordered array of topics
-    /// - Returns: An ordered array of SearchResult's indicating occurrences where the term was located
-    func search(term searchTerm: String, in topics: [TalkPageCellViewModel], traitCollection: UITraitCollection, theme: Theme) -> [SearchResult] {
-        var results: [SearchResult] = []
-
-        for (topicIndex, topic) in topics.enumerated() {
-            let topicTitleAttributedString = topic.topicTitleAttributedString(traitCollection: traitCollection, theme: theme)
-            let textToSearch = topicTitleAttributedString.string
-            if textToSearch.localizedCaseInsensitiveContains(searchTerm) {
-                let bridgedText = NSString(string: textToSearch)
-                let rangesOfTerm = bridgedText.ranges(of: searchTerm)
-                for range in rangesOfTerm {
-                    let result = SearchResult(term: searchTerm, location: .topicTitle(topicIndex: topicIndex, topicIdentifier: topic.id), range: range)
-                    results.append(result)
-                }
-            }
-            
-            if let leadComment = topic.leadComment,
-               let leadCommentAttributedString = topic.leadCommentAttributedString(traitCollection: traitCollection, theme: theme) {
-                let textToSearch = leadCommentAttributedString.string
-                
-                if textToSearch.localizedCaseInsensitiveContains(searchTerm) {
-                    let bridgedText = NSString(string: textToSearch)
-                    let rangesOfTerm = bridgedText.ranges(of: searchTerm)
-                    
-                    for range in rangesOfTerm {
-                        let result = SearchResult(term: searchTerm, location: .topicLeadComment(topicIndex: topicIndex, replyIdentifier: leadComment.id), range: range)
-                        results.append(result)
-                    }
-                }
-                
-            } else if topic.otherContentHtml != nil,
-                      let otherContentAttributedString = topic.otherContentAttributedString(traitCollection: traitCollection, theme: theme) {
-                let textToSearch = otherContentAttributedString.string
-                
-                if textToSearch.localizedCaseInsensitiveContains(searchTerm) {
-                    let bridgedText = NSString(string: textToSearch)
-                    let rangesOfTerm = bridgedText.ranges(of: searchTerm)
-                    
-                    for range in rangesOfTerm {
-                        let result = SearchResult(term: searchTerm, location: .topicOtherContent(topicIndex: topicIndex), range: range)
-                        results.append(result)
-                    }
-                }
-            }
+    ///   - completion: called on the main thread with an ordered array of SearchResult's indicating occurrences where the term was located
+    func search(term searchTerm: String, in topics: [TalkPageCellViewModel], traitCollection: UITraitCollection, theme: Theme, completion: @escaping ([SearchResult]) -> Void) {
+        if indexedTopicIdentifiers != topics.map({ ObjectIdentifier($0) }) {
+            enqueueIndexBuild(for: topics, traitCollection: traitCollection, theme: theme)
+        }
 
-            for (replyIndex, reply) in topic.replies.enumerated() {
-                let replyAttributedString = reply.commentAttributedString(traitCollection: traitCollection, theme: theme)
-                let textToSearch = replyAttributedString.string
-                if textToSearch.localizedCaseInsensitiveContains(searchTerm) {
-                    let bridgedText = NSString(string: textToSearch)
-                    let rangesOfTerm = bridgedText.ranges(of: searchTerm)
-                    for range in rangesOfTerm {
-                        let result = SearchResult(term: searchTerm, location: .reply(topicIndex: topicIndex, topicIdentifier: topic.id, replyIndex: replyIndex, replyIdentifier: reply.id), range: range)
-                        results.append(result)
-                    }
-                }
+        indexQueue.async {
+            let query = self.index?.search(term: searchTerm, narrowing: self.lastQuery)
+            self.lastQuery = query
+            DispatchQueue.main.async {
+                completion(query?.results ?? [])
             }
         }
+    }
+
+    /// Forgets the previous query so the next search scans the whole index
+    func resetQuery() {
+        indexQueue.async {
+            self.lastQuery = nil
+        }
+    }
 
-        return results
+    // MARK: - Private
+
+    private func enqueueIndexBuild(for topics: [TalkPageCellViewModel], traitCollection: UITraitCollection, theme: Theme) {
+        indexedTopicIdentifiers = topics.map { ObjectIdentifier($0) }
+        let source = TalkPageFindInPageSearchIndex.Source(topics: topics, traitCollection: traitCollection, theme: theme)
+        indexQueue.async {
+            self.index = TalkPageFindInPageSearchIndex.build(from: source)
+            self.lastQuery = nil
+        }
     }
 
 }
@@ -0,0 +1,264 @@
+import WMFComponents
+
+/// Case-folded plain text of every searchable element of a `[TalkPageCellViewModel]` hierarchy.
+/// Built once per talk page fetch so find in page doesn't need to re-render HTML on every keystroke.
+final class TalkPageFindInPageSearchIndex {
+
+    // MARK: - Nested Types
+
+    /// The HTML of a `[TalkPageCellViewModel]` hierarchy and the styles to render it with, copied on the main thread so the index can be built without touching the view models
+    struct Source {
+        struct Comment {
+            let identifier: ObjectIdentifier
+            let html: String
+        }
+
+        struct Topic {
+            let identifier: ObjectIdentifier
+            let titleHtml: String
+            let leadComment: Comment?
+            let otherContentHtml: String?
+            let replies: [Comment]
+        }
+
+        let topics: [Topic]
+        let titleStyles: HtmlUtils.Styles
+        let commentStyles: HtmlUtils.Styles
+
+        /// Call on the main thread
+        init(topics: [TalkPageCellViewModel], traitCollection: UITraitCollection, theme: Theme) {
+            self.topics = topics.map { topic in
+                Topic(identifier: ObjectIdentifier(topic),
+                      titleHtml: topic.topicTitleHtml,
+                      leadComment: topic.leadComment.map { Comment(identifier: ObjectIdentifier($0), html: $0.html) },
+                      otherContentHtml: topic.otherContentHtml,
+                      replies: topic.replies.map { Comment(identifier: ObjectIdentifier($0), html: $0.html) })
+            }
+            titleStyles = TalkPageCellViewModel.topicTitleStyles(traitCollection: traitCollection, theme: theme)
+            commentStyles = TalkPageCellViewModel.commentStyles(traitCollection: traitCollection, theme: theme)
+        }
+    }
+
+    struct Entry {
+        // Location of the element in topic/reply hierarchy
+        let location: TalkPageFindInPageSearchController.SearchResult.Location
+
+        // Lowercased UTF-16 text of the element's attributed string
+        let foldedText: [UInt16]
+
+        // For each unit in `foldedText`, the UTF-16 offset in the attributed string of the character it came from. Has one trailing element for the end of the string.
+        let sourceOffsets: [Int]
+    }
+
+    /// Matches for a term, kept so that a longer term can be searched within them instead of the whole index
+    struct Query {
+        let foldedTerm: [UInt16]
+        let matchOffsetsByEntryIndex: [(entryIndex: Int, foldedOffsets: [Int])]
+        let results: [TalkPageFindInPageSearchController.SearchResult]
+    }
+
+    // MARK: - Properties
+
+    let entries: [Entry]
+    private let topicIdentifiers: [ObjectIdentifier]
+
+    // MARK: - Lifecycle
+
+    private init(entries: [Entry], topicIdentifiers: [ObjectIdentifier]) {
+        self.entries = entries
+        self.topicIdentifiers = topicIdentifiers
+    }
+
+    /// Renders every topic title, lead comment or other content, and reply to plain text. Safe to call off the main thread.
+    static func build(from source: Source) -> TalkPageFindInPageSearchIndex {
+        var entries: [Entry] = []
+
+        for (topicIndex, topic) in source.topics.enumerated() {
+            let topicTitleText = TalkPageCellViewModel.topicTitleAttributedString(html: topic.titleHtml, styles: source.titleStyles).string
+            entries.append(entry(for: topicTitleText, location: .topicTitle(topicIndex: topicIndex, topicIdentifier: topic.identifier)))
+
+            if let leadComment = topic.leadComment {
+                let leadCommentText = TalkPageCellViewModel.commentAttributedString(html: leadComment.html, styles: source.commentStyles).string
+                entries.append(entry(for: leadCommentText, location: .topicLeadComment(topicIndex: topicIndex, replyIdentifier: leadComment.identifier)))
+            } else if let otherContentHtml = topic.otherContentHtml {
+                let otherContentText = TalkPageCellViewModel.commentAttributedString(html: otherContentHtml, styles: source.commentStyles).string
+                entries.append(entry(for: otherContentText, location: .topicOtherContent(topicIndex: topicIndex)))
+            }
+
+            for (replyIndex, reply) in topic.replies.enumerated() {
+                let replyText = TalkPageCellViewModel.commentAttributedString(html: reply.html, styles: source.commentStyles).string
+                entries.append(entry(for: replyText, location: .reply(topicIndex: topicIndex, topicIdentifier: topic.identifier, replyIndex: replyIndex, replyIdentifier: reply.identifier)))
+            }
+        }
+
+        return TalkPageFindInPageSearchIndex(entries: entries, topicIdentifiers: source.topics.map { $0.identifier })
+    }
+
+    // MARK: - Public
+
+    /// Whether the index was built from these exact topic view models
+    func isCurrent(for topics: [TalkPageCellViewModel]) -> Bool {
+        guard topics.count == topicIdentifiers.count else {
+            return false
+        }
+
+        for (topic, identifier) in zip(topics, topicIdentifiers) where ObjectIdentifier(topic) != identifier {
+            return false
+        }
+
+        return true
+    }
+
+    /// Search for occurrences of a term, case insensitive
+    /// - Parameters:
+    ///   - searchTerm: the term to locate
+    ///   - previousQuery: the last query run against this index. If its term is contained in `searchTerm`, only its matches are searched.
+    /// - Returns: A query whose results are ordered by location in the topic/reply hierarchy
+    func search(term searchTerm: String, narrowing previousQuery: Query? = nil) -> Query {
+        let foldedTerm = Self.fold(searchTerm).units
+
+        guard !foldedTerm.isEmpty else {
+            return Query(foldedTerm: foldedTerm, matchOffsetsByEntryIndex: [], results: [])
+        }
+
+        var matchOffsetsByEntryIndex: [(entryIndex: Int, foldedOffsets: [Int])] = []
+
+        if let previousQuery, !previousQuery.foldedTerm.isEmpty, foldedTerm.starts(with: previousQuery.foldedTerm) {
+            // Every match of the longer term starts where a match of the shorter one did
+            for previousMatch in previousQuery.matchOffsetsByEntryIndex {
+                let foldedText = entries[previousMatch.entryIndex].foldedText
+                let offsets = previousMatch.foldedOffsets.filter { Self.foldedText(foldedText, hasTerm: foldedTerm, at: $0) }
+                if !offsets.isEmpty {
+                    matchOffsetsByEntryIndex.append((entryIndex: previousMatch.entryIndex, foldedOffsets: offsets))
+                }
+            }
+        } else {
+            let entryIndexes: [Int]
+            if let previousQuery, !previousQuery.foldedTerm.isEmpty, Self.foldedText(foldedTerm, contains: previousQuery.foldedTerm) {
+                // Only elements containing the shorter term can contain the longer one
+                entryIndexes = previousQuery.matchOffsetsByEntryIndex.map { $0.entryIndex }
+            } else {
+                entryIndexes = Array(entries.indices)
+            }
+
+            for entryIndex in entryIndexes {
+                let offsets = Self.offsets(of: foldedTerm, in: entries[entryIndex].foldedText)
+                if !offsets.isEmpty {
+                    matchOffsetsByEntryIndex.append((entryIndex: entryIndex, foldedOffsets: offsets))
+                }
+            }
+        }
+
+        var results: [TalkPageFindInPageSearchController.SearchResult] = []
+        for match in matchOffsetsByEntryIndex {
+            let entry = entries[match.entryIndex]
+            // Occurrences are kept overlapping so longer terms can be narrowed from them, but results don't overlap
+            var endOfPreviousResult = 0
+            for foldedOffset in match.foldedOffsets where foldedOffset >= endOfPreviousResult {
+                endOfPreviousResult = foldedOffset + foldedTerm.count
+                guard let range = Self.sourceRange(of: foldedOffset..<(foldedOffset + foldedTerm.count), in: entry) else {
+                    continue
+                }
+                results.append(TalkPageFindInPageSearchController.SearchResult(term: searchTerm, location: entry.location, range: range))
+            }
+        }
+
+        return Query(foldedTerm: foldedTerm, matchOffsetsByEntryIndex: matchOffsetsByEntryIndex, results: results)
+    }
+
+    // MARK: - Private
+
+    private static func entry(for text: String, location: TalkPageFindInPageSearchController.SearchResult.Location) -> Entry {
+        let folded = fold(text)
+        return Entry(location: location, foldedText: folded.units, sourceOffsets: folded.sourceOffsets)
+    }
+
+    /// Lowercases text one character at a time, recording where each folded unit came from since lowercasing can change a character's length
+    private static func fold(_ text: String) -> (units: [UInt16], sourceOffsets: [Int]) {
+        var units: [UInt16] = []
+        var sourceOffsets: [Int] = []
+        units.reserveCapacity(text.utf16.count)
+        sourceOffsets.reserveCapacity(text.utf16.count + 1)
+
+        var sourceOffset = 0
+        for character in text {
+            let characterLength = character.utf16.count
+            if character.isASCII, let asciiValue = character.asciiValue {
+                let lowercased = (asciiValue >= 65 && asciiValue <= 90) ? asciiValue + 32 : asciiValue
+                units.append(UInt16(lowercased))
+                sourceOffsets.append(sourceOffset)
+                // "\r\n" is a single ASCII character of two units
+                for _ in 1..<max(1, characterLength) {
+                    units.append(UInt16(asciiValue))
+                    sourceOffsets.append(sourceOffset)
+                }
+            } else {
+                for unit in String(character).lowercased().utf16 {
+                    units.append(unit)
+                    sourceOffsets.append(sourceOffset)
+                }
+            }
+            sourceOffset += characterLength
+        }
+        sourceOffsets.append(sourceOffset)
+
+        return (units, sourceOffsets)
+    }
+
+    private static func sourceRange(of foldedRange: Range<Int>, in entry: Entry) -> NSRange? {
+        let sourceOffsets = entry.sourceOffsets
+
+        // Skip matches starting in the middle of a character
+        if foldedRange.lowerBound > 0 && sourceOffsets[foldedRange.lowerBound] == sourceOffsets[foldedRange.lowerBound - 1] {
+            return nil
+        }
+
+        // Extend matches ending in the middle of a character to the end of that character
+        var upperBound = foldedRange.upperBound
+        while upperBound < entry.foldedText.count && sourceOffsets[upperBound] == sourceOffsets[upperBound - 1] {
+            upperBound += 1
+        }
+
+        let location = sourceOffsets[foldedRange.lowerBound]
+        return NSRange(location: location, length: sourceOffsets[upperBound] - location)
+    }
+
+    private static func foldedText(_ text: [UInt16], hasTerm term: [UInt16], at offset: Int) -> Bool {
+        guard offset >= 0, offset + term.count <= text.count else {
+            return false
+        }
+
+        for termIndex in 0..<term.count where text[offset + termIndex] != term[termIndex] {
+            return false
+        }
+
+        return true
+    }
+
+    private static func foldedText(_ text: [UInt16], contains term: [UInt16]) -> Bool {
+        return !offsets(of: term, in: text, limit: 1).isEmpty
+    }
+
+    /// Offsets of every occurrence of `term` in `text`, including overlapping ones
+    private static func offsets(of term: [UInt16], in text: [UInt16], limit: Int = .max) -> [Int] {
+        guard !term.isEmpty, term.count <= text.count else {
+            return []
+        }
+
+        var offsets: [Int] = []
+        let firstUnit = term[0]
+        var offset = 0
+        let lastStart = text.count - term.count
+        while offset <= lastStart {
+            if text[offset] == firstUnit && foldedText(text, hasTerm: term, at: offset) {
+                offsets.append(offset)
+                if offsets.count >= limit {
+                    break
+                }
+            }
+            offset += 1
+        }
+
+        return offsets
+    }
+}
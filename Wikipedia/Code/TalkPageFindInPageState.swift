@@ -7,6 +7,16 @@ final class TalkPageFindInPageState {
     let searchController = TalkPageFindInPageSearchController()
     var keyboardBar: FindAndReplaceKeyboardBar?
 
+    /// Delay between the last keystroke and running the search
+    private let searchDebounceInterval: TimeInterval = 0.1
+    private var pendingSearch: DispatchWorkItem?
+    private var pendingSearchAction: (() -> Void)?
+
+    /// Incremented for each search and reset, so results of superseded searches are dropped
+    private var searchGeneration = 0
+    private var completedSearchGeneration = 0
+    private var actionsAfterSearch: [() -> Void] = []
+
     var selectedIndex: Int = -1 {
         didSet {
             updateView()
@@ -58,6 +68,13 @@ final class TalkPageFindInPageState {
     }
 
     func reset(_ topics: [TalkPageCellViewModel]) {
+        pendingSearch?.cancel()
+        pendingSearch = nil
+        pendingSearchAction = nil
+        searchGeneration += 1
+        completedSearchGeneration = searchGeneration
+        actionsAfterSearch.removeAll()
+        searchController.resetQuery()
         matches = []
         selectedIndex = -1
         keyboardBar?.reset()
@@ -68,12 +85,60 @@ final class TalkPageFindInPageState {
 
     }
 
-    func search(term: String, in topics: [TalkPageCellViewModel], traitCollection: UITraitCollection, theme: Theme) {
-        selectedIndex = -1
-        matches = searchController.search(term: term, in: topics, traitCollection: traitCollection, theme: theme)
-        topics.forEach {
-            $0.highlightText = matches.isEmpty ? nil : term
-            $0.activeHighlightResult = nil
+    /// Rebuilds the search index off the main thread. Call whenever topics are refetched.
+    func prepareSearchIndex(for topics: [TalkPageCellViewModel], traitCollection: UITraitCollection, theme: Theme) {
+        searchController.prepareIndex(for: topics, traitCollection: traitCollection, theme: theme)
+    }
+
+    /// Searches once the term has stopped changing for `searchDebounceInterval`
+    func debouncedSearch(term: String, in topics: [TalkPageCellViewModel], traitCollection: UITraitCollection, theme: Theme, completion: @escaping () -> Void) {
+        pendingSearch?.cancel()
+        let action = { [weak self] in
+            self?.search(term: term, in: topics, traitCollection: traitCollection, theme: theme, completion: completion)
+        }
+        pendingSearchAction = action
+        let search = DispatchWorkItem(block: action)
+        pendingSearch = search
+        DispatchQueue.main.asyncAfter(deadline: .now() + searchDebounceInterval, execute: search)
+    }
+
+    /// Runs a debounced search immediately, e.g. before moving between matches
+    /// - Parameter completion: called on the main thread once `matches` reflects the latest term
+    func performPendingSearch(completion: @escaping () -> Void) {
+        pendingSearchAction?()
+
+        guard completedSearchGeneration == searchGeneration else {
+            actionsAfterSearch.append(completion)
+            return
+        }
+
+        completion()
+    }
+
+    /// Searches off the main thread. `matches` is updated on the main thread when the search completes, unless another search or a reset happened in the meantime.
+    func search(term: String, in topics: [TalkPageCellViewModel], traitCollection: UITraitCollection, theme: Theme, completion: (() -> Void)? = nil) {
+        pendingSearch?.cancel()
+        pendingSearch = nil
+        pendingSearchAction = nil
+        searchGeneration += 1
+        let generation = searchGeneration
+        searchController.search(term: term, in: topics, traitCollection: traitCollection, theme: theme) { [weak self] results in
+            guard let self, self.searchGeneration == generation else {
+                return
+            }
+
+            self.completedSearchGeneration = generation
+            self.selectedIndex = -1
+            self.matches = results
+            topics.forEach {
+                $0.highlightText = results.isEmpty ? nil : term
+                $0.activeHighlightResult = nil
+            }
+            completion?()
+
+            let actions = self.actionsAfterSearch
+            self.actionsAfterSearch.removeAll()
+            actions.forEach { $0() }
         }
     }
 
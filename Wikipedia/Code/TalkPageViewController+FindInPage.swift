@@ -39,6 +39,10 @@ extension TalkPageViewController {
         }
     }
     
+    func prepareFindInPageIndex() {
+        findInPageState.prepareSearchIndex(for: viewModel.topics, traitCollection: traitCollection, theme: theme)
+    }
+
     var isShowingFindInPage: Bool {
         return findInPageState.keyboardBar?.isVisible ?? false
     }
@@ -133,8 +137,9 @@ extension TalkPageViewController: FindAndReplaceKeyboardBarDelegate {
             return
         }
 
-        findInPageState.search(term: searchTerm, in: viewModel.topics, traitCollection: traitCollection, theme: theme)
-        rethemeVisibleCells()
+        findInPageState.debouncedSearch(term: searchTerm, in: viewModel.topics, traitCollection: traitCollection, theme: theme) { [weak self] in
+            self?.rethemeVisibleCells()
+        }
     }
 
     func keyboardBarDidTapClose(_ keyboardBar: FindAndReplaceKeyboardBar) {
@@ -147,15 +152,25 @@ extension TalkPageViewController: FindAndReplaceKeyboardBarDelegate {
     }
 
     func keyboardBarDidTapPrevious(_ keyboardBar: FindAndReplaceKeyboardBar) {
-        findInPageState.previous()
-        viewModel.topics.forEach { $0.activeHighlightResult = findInPageState.selectedMatch }
-        scrollToFindInPageResult(findInPageState.selectedMatch)
+        findInPageState.performPendingSearch { [weak self] in
+            guard let self else {
+                return
+            }
+            self.findInPageState.previous()
+            self.viewModel.topics.forEach { $0.activeHighlightResult = self.findInPageState.selectedMatch }
+            self.scrollToFindInPageResult(self.findInPageState.selectedMatch)
+        }
     }
 
     func keyboardBarDidTapNext(_ keyboardBar: FindAndReplaceKeyboardBar?) {
-        findInPageState.next()
-        viewModel.topics.forEach { $0.activeHighlightResult = findInPageState.selectedMatch }
-        scrollToFindInPageResult(findInPageState.selectedMatch)
+        findInPageState.performPendingSearch { [weak self] in
+            guard let self else {
+                return
+            }
+            self.findInPageState.next()
+            self.viewModel.topics.forEach { $0.activeHighlightResult = self.findInPageState.selectedMatch }
+            self.scrollToFindInPageResult(self.findInPageState.selectedMatch)
+        }
     }
 
     func keyboardBarDidTapReturn(_ keyboardBar: FindAndReplaceKeyboardBar) {
@@ -193,6 +193,7 @@ class TalkPageViewController: ViewController {
             self.fakeProgressController.stop()
             switch result {
             case .success:
+                self.prepareFindInPageIndex()
                 self.setupHeaderView()
                 self.talkPageView.configure(viewModel: self.viewModel)
                 self.talkPageView.emptyView.actionButton.addTarget(self, action: #selector(self.userDidTapAddTopicButton), for: .primaryActionTriggered)
@@ -991,6 +992,7 @@ extension TalkPageViewController: TalkPageReplyComposeDelegate {
                     self?.fakeProgressController.stop()
                     switch result {
                     case .success(let revID):
+                        self?.prepareFindInPageIndex()
                         self?.updateEmptyStateVisibility()
                         self?.talkPageView.collectionView.reloadData()
                         self?.handleNewTopicOrCommentAlert(isNewTopic: false)
@@ -1065,6 +1067,7 @@ extension TalkPageViewController: TalkPageTopicComposeViewControllerDelegate {
                     
                     switch result {
                     case .success:
+                        self?.prepareFindInPageIndex()
                         self?.updateEmptyStateVisibility()
                         self?.talkPageView.collectionView.reloadData()
                         self?.scrollToLastTopic()
@@ -1269,6 +1272,7 @@ extension TalkPageViewController: EditorViewControllerDelegate {
                     
                     switch result {
                     case .success:
+                        self?.prepareFindInPageIndex()
                         self?.updateEmptyStateVisibility()
                         self?.talkPageView.collectionView.reloadData()
                     case .failure:
@@ -581,11 +581,17 @@ extension WMFAppViewController {
             return UserDefaults.standard.wmf_appInstallId
         }
         
+        let authenticationManager = dataStore.authenticationManager
+        WMFDataEnvironment.current.usernameUtility = {
+            return authenticationManager.authStatePermanentUsername
+        }
+        
         WMFDataEnvironment.current.acceptLanguageUtility = {
             return Locale.acceptLanguageHeaderForPreferredLanguages
         }
         
-        WMFDataEnvironment.current.sharedCacheStore = SharedContainerCacheStore()
+        let keyValueStoreURL = FileManager.default.wmf_containerURL().appendingPathComponent("Key Value Store", isDirectory: true).appendingPathComponent("Shared.log", isDirectory: false)
+        WMFDataEnvironment.current.sharedCacheStore = (try? WMFLogStructuredKeyValueStore(fileURL: keyValueStoreURL, legacyStore: SharedContainerCacheStore())) ?? SharedContainerCacheStore()
         
         let languages = dataStore.languageLinkController.preferredLanguages.map { WMFLanguage(languageCode: $0.languageCode, languageVariantCode: $0.languageVariantCode) }
         WMFDataEnvironment.current.appData = WMFAppData(appLanguages: languages)
@@ -604,6 +610,12 @@ extension WMFAppViewController {
             } catch {
                 DDLogError("Error pruning WMFData database: \(error)")
             }
+            
+            do {
+                try await WMFPageViewsDataController(coreDataStore: coreDataStore).rebuildRollupsIfNeeded()
+            } catch {
+                DDLogError("Error rebuilding page view rollups: \(error)")
+            }
         }
     }
 
@@ -628,6 +640,10 @@ extension WMFAppViewController {
         }
     }
     
+    @objc func deleteCachedWatchlists() {
+        WMFWatchlistDataController().removeCachedWatchlists()
+    }
+    
     @objc func deleteYearInReviewPersonalizedEditingData() {
         Task {
             do {
@@ -656,6 +656,9 @@ NSString *const WMFLanguageVariantAlertsLibraryVersion = @"WMFLanguageVariantAle
 
     /// Housekeeping for the new talk page cache
     [SharedContainerCacheHousekeeping deleteStaleCachedItemsIn:SharedContainerCacheCommonNames.talkPageCache cleanupLevel:WMFCleanupLevelLow];
+
+    /// Housekeeping for significant events timelines
+    [SharedContainerCacheHousekeeping deleteStaleCachedItemsIn:SharedContainerCacheCommonNames.significantEventsCache cleanupLevel:WMFCleanupLevelLow];
     
     /// Housekeeping for WMFData
     [self performWMFDataHousekeeping];
@@ -2214,6 +2217,7 @@ static NSString *const WMFDidShowOnboarding = @"DidShowOnboarding5.3";
     });
     
     [self deleteYearInReviewPersonalizedEditingData];
+    [self deleteCachedWatchlists];
 }
 
 - (void)userWasLoggedIn:(NSNotification *)note {
@@ -37,11 +37,13 @@ import WMF
         }
     }
 
+    private static let deletionBatchSize = 500
+
     private func deleteStaleUnreferencedArticles(_ moc: NSManagedObjectContext, navigationStateController: NavigationStateController, cleanupLevel: WMFCleanupLevel = .low) throws -> [URL] {
         
         /**
  
-        Find `WMFContentGroup`s more than WMFExploreFeedMaximumNumberOfDays days old.
+        Delete `WMFContentGroup`s more than WMFExploreFeedMaximumNumberOfDays days old. Their article references are deleted with them.
  
         */
         
@@ -52,80 +54,26 @@ import WMF
             return []
         }
         
-        let allContentGroupFetchRequest = WMFContentGroup.fetchRequest()
-        
-        let allContentGroups = try moc.fetch(allContentGroupFetchRequest)
-        var referencedArticleKeys = Set<String>(minimumCapacity: allContentGroups.count * 5 + 1)
+        let staleContentGroupFetchRequest = WMFContentGroup.fetchRequest()
+        staleContentGroupFetchRequest.predicate = cleanupLevel == .high ? NSPredicate(format: "midnightUTCDate <= %@", oldestFeedDateMidnightUTC as NSDate) : NSPredicate(format: "midnightUTCDate < %@", oldestFeedDateMidnightUTC as NSDate)
+        staleContentGroupFetchRequest.includesPropertyValues = false
+        for group in try moc.fetch(staleContentGroupFetchRequest) {
+            moc.delete(group)
+        }
         
-        for group in allContentGroups {
-            if cleanupLevel == .high && (group.midnightUTCDate?.compare(oldestFeedDateMidnightUTC) == .orderedAscending ||
-                                  group.midnightUTCDate?.compare(oldestFeedDateMidnightUTC) == .orderedSame) {
-                moc.delete(group)
-                continue
-            } else if group.midnightUTCDate?.compare(oldestFeedDateMidnightUTC) == .orderedAscending {
-                moc.delete(group)
-                continue
-            }
-            
-            if let articleURLDatabaseKey = group.articleURL?.wmf_databaseKey {
-                referencedArticleKeys.insert(articleURLDatabaseKey)
-            }
-
-            if let previewURL = group.contentPreview as? NSURL, let key = previewURL.wmf_databaseKey {
-                referencedArticleKeys.insert(key)
-            }
-            
-            guard let fullContent = group.fullContent else {
-                continue
-            }
-
-            guard let content = fullContent.object as? [Any] else {
-                assertionFailure("Unknown Content Type")
-                continue
-            }
-            
-            for obj in content {
-                
-                switch (group.contentType, obj) {
-                    
-                case (.URL, let url as NSURL):
-                    guard let key = url.wmf_databaseKey else {
-                        continue
-                    }
-                    referencedArticleKeys.insert(key)
-                    
-                case (.topReadPreview, let preview as WMFFeedTopReadArticlePreview):
-                    guard let key = (preview.articleURL as NSURL).wmf_databaseKey else {
-                        continue
-                    }
-                    referencedArticleKeys.insert(key)
-                    
-                case (.story, let story as WMFFeedNewsStory):
-                    guard let articlePreviews = story.articlePreviews else {
-                        continue
-                    }
-                    for preview in articlePreviews {
-                        guard let key = (preview.articleURL as NSURL).wmf_databaseKey else {
-                            continue
-                        }
-                        referencedArticleKeys.insert(key)
-                    }
-                    
-                case (.URL, _),
-                     (.topReadPreview, _),
-                     (.story, _),
-                     (.image, _),
-                     (.notification, _),
-                     (.announcement, _),
-                     (.onThisDayEvent, _),
-                     (.theme, _):
-                    break
-                    
-                default:
-                    assertionFailure("Unknown Content Type")
-                }
-            }
+        if moc.hasChanges {
+            try moc.save()
         }
+        
+        try updateOutdatedArticleReferences(moc)
+        
+        /**
+ 
+        Collect the article keys the remaining groups reference from the index kept by `WMFContentGroup.updateArticleReferences()`, instead of decoding every group's content.
+ 
+        */
+        
+        var referencedArticleKeys = try fetchReferencedArticleKeys(moc)
       
         /** 
   
@@ -151,6 +99,7 @@ import WMF
         let articlesToDelete = try moc.fetch(articlesToDeleteFetchRequest)
         
         var urls: [URL] = []
+        var pendingDeletionCount = 0
         for obj in articlesToDelete {
             guard cleanupLevel != .high && obj.isFault else { // only delete articles that are faults. prevents deletion of articles that are being actively viewed. repro steps: open disambiguation pages view -> exit app -> re-enter app
                 continue
@@ -159,14 +108,20 @@ import WMF
             guard let key = obj.key, !referencedArticleKeys.contains(key) else {
                 continue
             }
+            let url = obj.url
             moc.delete(obj)
-            guard let url = obj.url else {
-                continue
+            if let url {
+                urls.append(url)
+            }
+            
+            // Save in chunks so a large cleanup doesn't hold every deleted article in memory until the end
+            pendingDeletionCount += 1
+            if pendingDeletionCount >= WMFDatabaseHousekeeper.deletionBatchSize {
+                try moc.save()
+                pendingDeletionCount = 0
             }
-            urls.append(url)
         }
         
-        
         if moc.hasChanges {
             try moc.save()
         }
@@ -175,4 +130,39 @@ import WMF
         
         return urls
     }
+    
+    /// Rebuilds article references for groups saved before the index existed, or before `WMFContentGroupArticleReferencesVersion` was last bumped
+    private func updateOutdatedArticleReferences(_ moc: NSManagedObjectContext) throws {
+        let outdatedContentGroupFetchRequest = WMFContentGroup.fetchRequest()
+        outdatedContentGroupFetchRequest.predicate = NSPredicate(format: "articleReferencesVersion < %d", WMFContentGroupArticleReferencesVersion)
+        outdatedContentGroupFetchRequest.fetchBatchSize = WMFDatabaseHousekeeper.deletionBatchSize
+        
+        let outdatedContentGroups = try moc.fetch(outdatedContentGroupFetchRequest)
+        for (index, group) in outdatedContentGroups.enumerated() {
+            group.updateArticleReferences()
+            if (index + 1) % WMFDatabaseHousekeeper.deletionBatchSize == 0 {
+                try moc.save()
+            }
+        }
+        
+        if moc.hasChanges {
+            try moc.save()
+        }
+    }
+    
+    private func fetchReferencedArticleKeys(_ moc: NSManagedObjectContext) throws -> Set<String> {
+        let referencedArticleKeysFetchRequest = NSFetchRequest<NSDictionary>(entityName: "WMFContentGroupArticleReference")
+        referencedArticleKeysFetchRequest.resultType = .dictionaryResultType
+        referencedArticleKeysFetchRequest.propertiesToFetch = ["articleKey"]
+        referencedArticleKeysFetchRequest.returnsDistinctResults = true
+        
+        let results = try moc.fetch(referencedArticleKeysFetchRequest)
+        var referencedArticleKeys = Set<String>(minimumCapacity: results.count + 1)
+        for result in results {
+            if let key = result["articleKey"] as? String {
+                referencedArticleKeys.insert(key)
+            }
+        }
+        return referencedArticleKeys
+    }
 }
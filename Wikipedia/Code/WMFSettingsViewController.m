@@ -435,6 +435,7 @@ static NSString *const WMFSettingsURLDonation = @"https://donate.wikimedia.org/?
     }];
 
     [SharedContainerCacheHousekeeping deleteStaleCachedItemsIn:SharedContainerCacheCommonNames.talkPageCache cleanupLevel:WMFCleanupLevelHigh];
+    [SharedContainerCacheHousekeeping deleteStaleCachedItemsIn:SharedContainerCacheCommonNames.significantEventsCache cleanupLevel:WMFCleanupLevelHigh];
 }
 
 - (void)showClearCacheInProgressBanner {
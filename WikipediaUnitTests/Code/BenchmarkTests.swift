@@ -0,0 +1,81 @@
+import XCTest
+
+class BenchmarkTests: XCTestCase {
+
+    var directoryURL: URL!
+
+    override func setUpWithError() throws {
+        directoryURL = FileManager.default.temporaryDirectory.appendingPathComponent(UUID().uuidString, isDirectory: true)
+        try FileManager.default.createDirectory(at: directoryURL, withIntermediateDirectories: true)
+    }
+
+    override func tearDownWithError() throws {
+        try? FileManager.default.removeItem(at: directoryURL)
+    }
+
+    func testSeededGeneratorIsDeterministic() {
+        var first = SeededRandomNumberGenerator(seed: 42)
+        var second = SeededRandomNumberGenerator(seed: 42)
+        var other = SeededRandomNumberGenerator(seed: 43)
+        let firstValues = (0..<100).map { _ in first.next() }
+        XCTAssertEqual(firstValues, (0..<100).map { _ in second.next() })
+        XCTAssertNotEqual(firstValues, (0..<100).map { _ in other.next() })
+
+        var titleGenerator = SeededRandomNumberGenerator(seed: 7)
+        var repeatedTitleGenerator = SeededRandomNumberGenerator(seed: 7)
+        XCTAssertEqual((0..<20).map { _ in titleGenerator.title() }, (0..<20).map { _ in repeatedTitleGenerator.title() })
+    }
+
+    func testResultStatistics() {
+        let result = BenchmarkResult(name: "statistics", seed: 1, samples: [4, 1, 3, 2])
+        XCTAssertEqual(result.median, 2.5)
+        XCTAssertEqual(result.mean, 2.5)
+        XCTAssertEqual(result.min, 1)
+        XCTAssertEqual(result.max, 4)
+        XCTAssertEqual(result.standardDeviation, sqrt(5.0 / 3.0), accuracy: 0.000001)
+        XCTAssertEqual(BenchmarkResult(name: "odd", seed: 1, samples: [5, 1, 3]).median, 3)
+    }
+
+    func testRegressionsAreMeasuredAgainstBaseline() throws {
+        let baselineURL = directoryURL.appendingPathComponent("baseline.json")
+        try BenchmarkReport(results: [BenchmarkResult(name: "scenario", seed: 1, samples: [0.010])]).write(to: baselineURL)
+
+        let resultsURL = directoryURL.appendingPathComponent("results.json")
+        let runner = BenchmarkRunner(configuration: BenchmarkConfiguration(warmupIterations: 2, iterations: 3, regressionThreshold: 0.1), baselineURL: baselineURL, resultsURL: resultsURL)
+        var setUpCount = 0
+        var seeds: [UInt64] = []
+        let result = try runner.measure("scenario", seed: 1, setUp: { (generator) -> UInt64 in
+            setUpCount += 1
+            return generator.next()
+        }, run: { (value) in
+            seeds.append(value)
+            Thread.sleep(forTimeInterval: 0.02)
+        })
+
+        XCTAssertEqual(setUpCount, 5, "Warm up iterations should run but not be recorded")
+        XCTAssertEqual(result.samples.count, 3)
+        XCTAssertEqual(Set(seeds).count, 1, "Every iteration should get the same data")
+        XCTAssertEqual(result.baselineMedian, 0.010)
+        XCTAssertTrue(result.isRegression)
+
+        let unmeasured = try runner.measure("new-scenario", seed: 2, setUp: { _ in }, run: { _ in })
+        XCTAssertNil(unmeasured.baselineMedian)
+        XCTAssertFalse(unmeasured.isRegression)
+
+        try runner.writeReport()
+        let report = try BenchmarkReport.load(from: resultsURL)
+        XCTAssertEqual(report.results.map { $0.name }, ["scenario", "new-scenario"])
+        XCTAssertEqual(report.results.first, result)
+    }
+
+    func testConfigurationEnvironmentOverrides() {
+        let configuration = BenchmarkConfiguration().overridden(by: ["WMF_BENCHMARK_ITERATIONS": "12", "WMF_BENCHMARK_WARMUP_ITERATIONS": "0", "WMF_BENCHMARK_REGRESSION_THRESHOLD": "0.25"])
+        XCTAssertEqual(configuration.iterations, 12)
+        XCTAssertEqual(configuration.warmupIterations, 0)
+        XCTAssertEqual(configuration.regressionThreshold, 0.25)
+
+        let invalid = BenchmarkConfiguration().overridden(by: ["WMF_BENCHMARK_ITERATIONS": "0", "WMF_BENCHMARK_REGRESSION_THRESHOLD": "fast"])
+        XCTAssertEqual(invalid.iterations, BenchmarkConfiguration().iterations)
+        XCTAssertEqual(invalid.regressionThreshold, BenchmarkConfiguration().regressionThreshold)
+    }
+}
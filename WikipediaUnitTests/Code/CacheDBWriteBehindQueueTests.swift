@@ -0,0 +1,224 @@
+import XCTest
+@testable import WMF
+
+class CacheDBWriteBehindQueueTests: XCTestCase {
+
+    /// Database writes made while saving an article with 80 images, in the order `ImageCacheDBWriter` made them.
+    /// Images are added to the article's group, then marked downloaded as their responses arrive. A few downloads are retried and marked twice.
+    enum RecordedWrite {
+        case add(itemKey: String, variant: String)
+        case markDownloaded(itemKey: String, variant: String)
+    }
+
+    static let groupKey = "en.wikipedia.org/wiki/Dog"
+    static let imageCount = 80
+
+    /// Also replayed by `DataStoreBenchmarkTests` to time batched and unbatched saves
+    static let recordedArticleSave: [RecordedWrite] = {
+        var writes: [RecordedWrite] = []
+        for index in 0..<imageCount {
+            writes.append(.add(itemKey: "upload.wikimedia.org__Dog_\(index).jpg", variant: "640"))
+        }
+        // Responses arrive out of order
+        for index in (0..<imageCount).map({ ($0 * 37) % imageCount }) {
+            writes.append(.markDownloaded(itemKey: "upload.wikimedia.org__Dog_\(index).jpg", variant: "640"))
+            if index % 10 == 0 {
+                writes.append(.markDownloaded(itemKey: "upload.wikimedia.org__Dog_\(index).jpg", variant: "640"))
+            }
+        }
+        return writes
+    }()
+
+    var directoryURLs: [URL] = []
+
+    override func tearDownWithError() throws {
+        for directoryURL in directoryURLs {
+            try? FileManager.default.removeItem(at: directoryURL)
+        }
+    }
+
+    private func makeContext() throws -> NSManagedObjectContext {
+        let directoryURL = FileManager.default.temporaryDirectory.appendingPathComponent(UUID().uuidString, isDirectory: true)
+        directoryURLs.append(directoryURL)
+        return try XCTUnwrap(CacheController.createCacheContext(cacheURL: directoryURL))
+    }
+
+    static func enqueue(_ write: RecordedWrite, on queue: CacheDBWriteBehindQueue, completion: @escaping (CacheDBWritingResult) -> Void) {
+        switch write {
+        case .add(let itemKey, let variant):
+            queue.enqueue(dedupeKey: CacheDBWriteBehindQueue.addDedupeKey(groupKey: Self.groupKey, itemKey: itemKey, variant: variant), operation: { (context) in
+                guard let group = CacheDBWriterHelper.fetchOrCreateCacheGroup(with: Self.groupKey, in: context),
+                      let item = CacheDBWriterHelper.fetchOrCreateCacheItem(with: URL(string: "https://upload.wikimedia.org/\(itemKey)")!, itemKey: itemKey, variant: variant, in: context) else {
+                    throw CacheDBWritingMarkDownloadedError.cannotFindCacheItem
+                }
+                group.addToCacheItems(item)
+            }, completion: completion)
+        case .markDownloaded(let itemKey, let variant):
+            queue.enqueue(dedupeKey: CacheDBWriteBehindQueue.markDownloadedDedupeKey(itemKey: itemKey, variant: variant), operation: { (context) in
+                try CacheDBWriterHelper.markDownloaded(itemKey: itemKey, variant: variant, in: context)
+            }, completion: completion)
+        }
+    }
+
+    /// Replays the recorded writes and returns how many times the context saved
+    private func replay(on queue: CacheDBWriteBehindQueue) -> Int {
+        let context = queue.context
+        var saveCount = 0
+        let observer = NotificationCenter.default.addObserver(forName: .NSManagedObjectContextDidSave, object: context, queue: nil) { _ in
+            saveCount += 1
+        }
+        defer {
+            NotificationCenter.default.removeObserver(observer)
+        }
+
+        let writes = Self.recordedArticleSave
+        let expectation = self.expectation(description: "Replayed writes")
+        expectation.expectedFulfillmentCount = writes.count
+
+        for write in writes {
+            Self.enqueue(write, on: queue) { (result) in
+                if case .failure(let error) = result {
+                    XCTFail("Unexpected failure \(error)")
+                }
+                if case .markDownloaded(let itemKey, let variant) = write {
+                    let item = CacheDBWriterHelper.cacheItem(with: itemKey, variant: variant, in: context)
+                    XCTAssertEqual(item?.isDownloaded, true)
+                    XCTAssertFalse(context.hasChanges, "Completions should be called after the covering save")
+                }
+                expectation.fulfill()
+            }
+        }
+        wait(for: [expectation], timeout: 30)
+
+        context.performAndWait {
+            let fetchRequest: NSFetchRequest<CacheItem> = CacheItem.fetchRequest()
+            fetchRequest.predicate = NSPredicate(format: "isDownloaded == YES")
+            XCTAssertEqual(try? context.count(for: fetchRequest), Self.imageCount)
+        }
+
+        return saveCount
+    }
+
+    func testReplayingArticleSaveBatchesSaves() throws {
+        let writeCount = Self.recordedArticleSave.count
+
+        // One save per write, as before the queue. Retried downloads may not change anything.
+        let unbatchedSaveCount = replay(on: CacheDBWriteBehindQueue(context: try makeContext(), maxBatchSize: 1))
+        XCTAssertGreaterThanOrEqual(unbatchedSaveCount, Self.imageCount * 2)
+
+        let batchedSaveCount = replay(on: CacheDBWriteBehindQueue(context: try makeContext()))
+        XCTAssertLessThanOrEqual(batchedSaveCount, Int(ceil(Double(writeCount) / Double(CacheDBWriteBehindQueue.defaultMaxBatchSize))) + 1)
+    }
+
+    func testRepeatedWritesAreAppliedOnce() throws {
+        let queue = CacheDBWriteBehindQueue(context: try makeContext(), maxBatchSize: 10, flushDelay: .seconds(10))
+        var applyCount = 0
+        var results: [String] = []
+
+        for value in ["first", "second", "third"] {
+            queue.enqueue(dedupeKey: "key", operation: { _ in
+                applyCount += 1
+                results.append(value)
+            }, completion: { _ in })
+        }
+
+        let expectation = self.expectation(description: "Flushed")
+        queue.flush {
+            expectation.fulfill()
+        }
+        wait(for: [expectation], timeout: 5)
+
+        XCTAssertEqual(applyCount, 1)
+        XCTAssertEqual(results, ["third"], "The latest write should win")
+    }
+
+    func testWritesAreNotDedupedAcrossRemovals() throws {
+        let context = try makeContext()
+        context.performAndWait {
+            _ = CacheDBWriterHelper.createCacheItem(with: URL(string: "https://upload.wikimedia.org/Cat.jpg")!, itemKey: "Cat.jpg", variant: nil, in: context)
+            CacheDBWriterHelper.save(moc: context) { _ in }
+        }
+
+        let queue = CacheDBWriteBehindQueue(context: context, maxBatchSize: 10, flushDelay: .seconds(10))
+        let markDownloadedKey = CacheDBWriteBehindQueue.markDownloadedDedupeKey(itemKey: "Cat.jpg", variant: nil)
+        var results: [Bool] = []
+        let record: (CacheDBWritingResult) -> Void = { (result) in
+            if case .success = result {
+                results.append(true)
+            } else {
+                results.append(false)
+            }
+        }
+
+        queue.enqueue(dedupeKey: markDownloadedKey, operation: { (context) in
+            try CacheDBWriterHelper.markDownloaded(itemKey: "Cat.jpg", variant: nil, in: context)
+        }, completion: record)
+        queue.enqueue(operation: { (context) in
+            guard let item = CacheDBWriterHelper.cacheItem(with: "Cat.jpg", variant: nil, in: context) else {
+                throw CacheDBWritingRemoveError.cannotFindCacheItem
+            }
+            context.delete(item)
+        }, completion: record)
+        queue.enqueue(dedupeKey: markDownloadedKey, operation: { (context) in
+            try CacheDBWriterHelper.markDownloaded(itemKey: "Cat.jpg", variant: nil, in: context)
+        }, completion: record)
+
+        let expectation = self.expectation(description: "Flushed")
+        queue.flush {
+            expectation.fulfill()
+        }
+        wait(for: [expectation], timeout: 5)
+
+        XCTAssertEqual(results, [true, true, false], "Marking downloaded after the removal shouldn't be merged into the write before it")
+    }
+
+    func testFailedWriteIsRolledBackWithoutLosingBatch() throws {
+        let context = try makeContext()
+        let queue = CacheDBWriteBehindQueue(context: context, maxBatchSize: 10, flushDelay: .seconds(10))
+        var results: [Bool] = []
+
+        for itemKey in ["Cat.jpg", "Dog.jpg", "Fish.jpg"] {
+            queue.enqueue(dedupeKey: itemKey, operation: { (context) in
+                _ = CacheDBWriterHelper.createCacheItem(with: URL(string: "https://upload.wikimedia.org/\(itemKey)")!, itemKey: itemKey, variant: nil, in: context)
+                if itemKey == "Dog.jpg" {
+                    throw CacheDBWritingMarkDownloadedError.cannotFindCacheItem
+                }
+            }, completion: { (result) in
+                if case .success = result {
+                    results.append(true)
+                } else {
+                    results.append(false)
+                }
+            })
+        }
+
+        let expectation = self.expectation(description: "Flushed")
+        queue.flush {
+            expectation.fulfill()
+        }
+        wait(for: [expectation], timeout: 5)
+
+        XCTAssertEqual(results, [true, false, true])
+        context.performAndWait {
+            XCTAssertNotNil(CacheDBWriterHelper.cacheItem(with: "Cat.jpg", variant: nil, in: context))
+            XCTAssertNil(CacheDBWriterHelper.cacheItem(with: "Dog.jpg", variant: nil, in: context), "Changes made by a failed write shouldn't be saved")
+            XCTAssertNotNil(CacheDBWriterHelper.cacheItem(with: "Fish.jpg", variant: nil, in: context))
+        }
+    }
+
+    func testFullBatchFlushesWithoutWaitingForDelay() throws {
+        let queue = CacheDBWriteBehindQueue(context: try makeContext(), maxBatchSize: 3, flushDelay: .seconds(60))
+        let expectation = self.expectation(description: "Flushed at batch size")
+        expectation.expectedFulfillmentCount = 3
+
+        for index in 0..<3 {
+            queue.enqueue(dedupeKey: "\(index)", operation: { _ in }, completion: { (result) in
+                if case .success = result {
+                    expectation.fulfill()
+                }
+            })
+        }
+
+        wait(for: [expectation], timeout: 5)
+    }
+}
@@ -0,0 +1,337 @@
+import XCTest
+@testable import Wikipedia
+
+/// Generated diff responses like those of long, heavily edited articles
+enum DiffTransformerTestCorpus {
+
+    /// A diff of `itemCount` lines with sections on both sides, moved paragraphs, context lines and gaps of unedited lines
+    static func response(itemCount: Int, seed: UInt64) -> DiffResponse {
+        var generator = SeededRandomNumberGenerator(seed: seed)
+
+        var items: [DiffItem] = []
+        var fromSections: [DiffSection] = []
+        var toSections: [DiffSection] = []
+        var fromOffset = Int.random(in: 0...200, using: &generator)
+        var toOffset = fromOffset
+        var lineNumber = 1
+        var pendingMoveIds: [Int] = []
+        var moveCount = 0
+
+        // Sections start partway in, so early items fall in the intro
+        let firstSectionItemIndex = Int.random(in: 0...min(20, itemCount), using: &generator)
+
+        for index in 0..<itemCount {
+
+            if index >= firstSectionItemIndex && Int.random(in: 0..<12, using: &generator) == 0 {
+                let heading = generator.title()
+                if Int.random(in: 0..<4, using: &generator) != 0 {
+                    fromSections.append(DiffSection(level: 2, heading: heading, offset: fromOffset))
+                }
+                if Int.random(in: 0..<4, using: &generator) != 0 {
+                    toSections.append(DiffSection(level: 2, heading: Bool.random(using: &generator) ? heading : generator.title(), offset: toOffset))
+                }
+            }
+
+            if Int.random(in: 0..<10, using: &generator) == 0 {
+                lineNumber += Int.random(in: 2...30, using: &generator)
+            } else {
+                lineNumber += 1
+            }
+
+            let text = (0..<Int.random(in: 1...12, using: &generator)).map { _ in generator.title(maxWordCount: 1) }.joined(separator: " ")
+            let length = text.utf8.count
+
+            let type: DiffItemType
+            var moveInfo: DiffMoveInfo?
+            switch Int.random(in: 0..<20, using: &generator) {
+            case 0..<7:
+                type = .context
+            case 7..<11:
+                type = .addLine
+            case 11..<14:
+                type = .deleteLine
+            case 14..<17:
+                type = .change
+            case 17..<19:
+                type = .moveSource
+                moveInfo = DiffMoveInfo(id: "move-\(moveCount)-source", linkId: "move-\(moveCount)-destination", linkDirection: .down)
+                pendingMoveIds.append(moveCount)
+                moveCount += 1
+            default:
+                if pendingMoveIds.isEmpty {
+                    type = .change
+                } else {
+                    type = .moveDestination
+                    let moveId = pendingMoveIds.remove(at: Int.random(in: 0..<pendingMoveIds.count, using: &generator))
+                    moveInfo = DiffMoveInfo(id: "move-\(moveId)-destination", linkId: "move-\(moveId)-source", linkDirection: .up)
+                }
+            }
+
+            let from: Int? = type == .addLine ? nil : fromOffset
+            let to: Int? = type == .deleteLine ? nil : toOffset
+            let highlightRanges: [DiffHighlightRange]? = type == .change ? [DiffHighlightRange(start: 0, length: min(length, 5), type: .add)] : nil
+            let itemLineNumber: Int? = type == .deleteLine && Bool.random(using: &generator) ? nil : lineNumber
+
+            items.append(DiffItem(type: type, text: text, highlightRanges: highlightRanges, moveInfo: moveInfo, offset: DiffItemOffset(from: from, to: to), lineNumber: itemLineNumber))
+
+            if from != nil {
+                fromOffset += length + 1
+            }
+            if to != nil {
+                toOffset += length + 1
+            }
+        }
+
+        return DiffResponse(diff: items, from: DiffSideMetaData(sections: fromSections), to: DiffSideMetaData(sections: toSections))
+    }
+
+    /// The items as the transformer built them before it was split into stages, with a removeFirst section walk and a map of linked moves built in a separate pass
+    static func legacyTransformDiffItems(from response: DiffResponse) -> [TransformDiffItem] {
+        return LegacyDiffTransformer.transformDiffItems(from: response)
+    }
+}
+
+private enum LegacyDiffTransformer {
+
+    static func transformDiffItems(from response: DiffResponse) -> [TransformDiffItem] {
+        let groupedMoveIndexes = groupedIndexesOfMoveItems(from: response)
+        let transformSectionInfo = transformSectionInfosOfItems(from: response)
+        let transformDiffItems = transformDiffItemsWithPopulatedLineNumbers(from: response)
+
+        var newItems: [TransformDiffItem] = []
+        let zipped = zip(transformDiffItems, transformSectionInfo)
+
+        var correspondingMoveItems: [String: (linkItem: TransformDiffItem, linkSectionInfo: TransformSectionInfo)] = [:]
+        for zippedItem in zipped where zippedItem.0.type.isMoveBased {
+            if let linkId = zippedItem.0.moveInfo?.linkId {
+                correspondingMoveItems[linkId] = (zippedItem.0, zippedItem.1)
+            }
+        }
+
+        for var zippedItem in zipped {
+            var isToIntro = zippedItem.1.toIsIntro
+            var isFromIntro = zippedItem.1.fromIsIntro
+
+            zippedItem.0.sectionTitle = zippedItem.1.to?.title ?? zippedItem.1.from?.title
+
+            if let moveInfo = zippedItem.0.moveInfo {
+                var moveDistance: TransformMoveDistance? = nil
+
+                if let correspondingMoveItem = correspondingMoveItems[moveInfo.id] {
+                    let isMoveSource = zippedItem.0.type == .moveSource
+                    let fromSection = isMoveSource ? zippedItem.1.from : correspondingMoveItem.linkSectionInfo.from
+                    let toSection = isMoveSource ? correspondingMoveItem.linkSectionInfo.to : zippedItem.1.to
+                    isToIntro = isMoveSource ? correspondingMoveItem.linkSectionInfo.toIsIntro : zippedItem.1.toIsIntro
+                    isFromIntro = isMoveSource ? zippedItem.1.fromIsIntro : correspondingMoveItem.linkSectionInfo.fromIsIntro
+
+                    if let fromSection, let toSection, fromSection.title != toSection.title, fromSection.order != toSection.order {
+                        moveDistance = .section(amount: abs(fromSection.order - toSection.order))
+                    }
+
+                    if moveDistance == nil,
+                       let firstLineNumber = zippedItem.0.lineNumber,
+                       let nextLineNumber = correspondingMoveItem.linkItem.lineNumber {
+                        moveDistance = .line(amount: abs(firstLineNumber - nextLineNumber))
+                    }
+                }
+
+                zippedItem.0.moveInfo = TransformMoveInfo(id: moveInfo.id, linkId: moveInfo.linkId, linkDirection: moveInfo.linkDirection, groupedIndex: groupedMoveIndexes[moveInfo.id], moveDistance: moveDistance)
+            }
+
+            if zippedItem.0.sectionTitle == nil && isToIntro && isFromIntro {
+                zippedItem.0.sectionTitle = WMFLocalizedString("diff-single-intro-title", value:"Intro", comment:"Section heading on revision changes diff screen that indicates the following highlighted changes occurred in the intro section.")
+            }
+
+            newItems.append(zippedItem.0)
+        }
+
+        return newItems
+    }
+
+    private static func transformSectionInfosOfItems(from response: DiffResponse) -> [TransformSectionInfo] {
+        var result: [TransformSectionInfo] = []
+
+        var fromSections = response.from.sections
+        var toSections = response.to.sections
+        let firstFrom = fromSections.first
+        let firstTo = toSections.first
+        var lastFrom: DiffSection? = nil
+        var lastTo: DiffSection? = nil
+        var lastFromIndex = -1
+        var lastToIndex = -1
+        var fromIsIntro = false
+        var toIsIntro = false
+
+        for item in response.diff {
+            var fromSide: TransformSectionInfo.Side?
+            if let itemFromOffset = item.offset.from {
+                while let currentFrom = fromSections.first, currentFrom.offset <= itemFromOffset {
+                    lastFrom = fromSections.removeFirst()
+                    lastFromIndex += 1
+                }
+                if let lastFrom {
+                    fromSide = TransformSectionInfo.Side(title: lastFrom.heading, order: lastFromIndex)
+                }
+                if let firstFromOffset = firstFrom?.offset, fromSide == nil {
+                    fromIsIntro = itemFromOffset < firstFromOffset
+                }
+            }
+
+            var toSide: TransformSectionInfo.Side?
+            if let itemToOffset = item.offset.to {
+                while let currentTo = toSections.first, currentTo.offset <= itemToOffset {
+                    lastTo = toSections.removeFirst()
+                    lastToIndex += 1
+                }
+                if let lastTo {
+                    toSide = TransformSectionInfo.Side(title: lastTo.heading, order: lastToIndex)
+                }
+                if let firstToOffset = firstTo?.offset, toSide == nil {
+                    toIsIntro = itemToOffset < firstToOffset
+                }
+            }
+
+            result.append(TransformSectionInfo(from: fromSide, to: toSide, fromIsIntro: fromIsIntro, toIsIntro: toIsIntro))
+        }
+
+        return result
+    }
+
+    private static func groupedIndexesOfMoveItems(from response: DiffResponse) -> [String: Int] {
+        var indexCounter = 0
+        var result: [String: Int] = [:]
+
+        for item in response.diff where item.type.isMoveBased {
+            if let id = item.moveInfo?.id, let linkId = item.moveInfo?.linkId, result[id] == nil {
+                if let existingIndex = result[linkId] {
+                    result[id] = existingIndex
+                } else {
+                    result[id] = indexCounter
+                    indexCounter += 1
+                }
+            }
+        }
+
+        return result
+    }
+
+    private static func transformDiffItemsWithPopulatedLineNumbers(from response: DiffResponse) -> [TransformDiffItem] {
+        var lastLineNumber: Int?
+        return response.diff.map { item in
+            let moveInfo = item.moveInfo.map { TransformMoveInfo(id: $0.id, linkId: $0.linkId, linkDirection: $0.linkDirection, groupedIndex: nil, moveDistance: nil) }
+            if let lineNumber = item.lineNumber {
+                lastLineNumber = lineNumber
+            }
+            return TransformDiffItem(type: item.type, text: item.text, highlightRanges: item.highlightRanges, offset: item.offset, sectionTitle: nil, lineNumber: lastLineNumber, moveInfo: moveInfo)
+        }
+    }
+}
+
+class DiffTransformerTests: XCTestCase {
+
+    private func assertEqual(_ items: [TransformDiffItem], _ expectedItems: [TransformDiffItem], file: StaticString = #filePath, line: UInt = #line) {
+        XCTAssertEqual(items.count, expectedItems.count, file: file, line: line)
+        for (index, (item, expectedItem)) in zip(items, expectedItems).enumerated() {
+            XCTAssertEqual(item.type, expectedItem.type, "Item \(index)", file: file, line: line)
+            XCTAssertEqual(item.text, expectedItem.text, "Item \(index)", file: file, line: line)
+            XCTAssertEqual(item.offset, expectedItem.offset, "Item \(index)", file: file, line: line)
+            XCTAssertEqual(item.lineNumber, expectedItem.lineNumber, "Item \(index)", file: file, line: line)
+            XCTAssertEqual(item.sectionTitle, expectedItem.sectionTitle, "Item \(index)", file: file, line: line)
+            XCTAssertEqual(item.moveInfo?.id, expectedItem.moveInfo?.id, "Item \(index)", file: file, line: line)
+            XCTAssertEqual(item.moveInfo?.groupedIndex, expectedItem.moveInfo?.groupedIndex, "Item \(index)", file: file, line: line)
+            XCTAssertEqual(item.moveInfo?.moveDistance.map { String(describing: $0) }, expectedItem.moveInfo?.moveDistance.map { String(describing: $0) }, "Item \(index)", file: file, line: line)
+        }
+    }
+
+    private func describe(_ groups: [DiffTransformGroup]) -> [String] {
+        return groups.map { group in
+            switch group {
+            case .change(let items):
+                return "change \(items.count) \(items.first?.sectionTitle ?? "-")"
+            case .context(let items):
+                return "context \(items.count)"
+            case .unedited(let numberOfLines):
+                return "unedited \(numberOfLines)"
+            }
+        }
+    }
+
+    func testItemsMatchLegacyTransform() {
+        for seed in UInt64(1)...20 {
+            let response = DiffTransformerTestCorpus.response(itemCount: 600, seed: seed)
+            assertEqual(DiffTransformer.transformDiffItems(from: response), DiffTransformerTestCorpus.legacyTransformDiffItems(from: response))
+        }
+    }
+
+    func testEmptyResponse() {
+        let response = DiffResponse(diff: [], from: DiffSideMetaData(sections: []), to: DiffSideMetaData(sections: []))
+        XCTAssertTrue(DiffTransformer.groups(from: response, type: .single).isEmpty)
+        XCTAssertTrue(DiffTransformer.groups(from: response, type: .compare).isEmpty)
+    }
+
+    func testSingleGroupsSkipContextAndSplitBySection() {
+        let sections = [DiffSection(level: 2, heading: "History", offset: 10), DiffSection(level: 2, heading: "Geography", offset: 30)]
+        let items = [
+            DiffItem(type: .change, text: "Intro", highlightRanges: [], moveInfo: nil, offset: DiffItemOffset(from: 0, to: 0), lineNumber: 1),
+            DiffItem(type: .context, text: "History", highlightRanges: nil, moveInfo: nil, offset: DiffItemOffset(from: 10, to: 10), lineNumber: 2),
+            DiffItem(type: .change, text: "Founded", highlightRanges: [], moveInfo: nil, offset: DiffItemOffset(from: 20, to: 20), lineNumber: 3),
+            DiffItem(type: .deleteLine, text: "Settled", highlightRanges: nil, moveInfo: nil, offset: DiffItemOffset(from: 25, to: nil), lineNumber: nil),
+            DiffItem(type: .addLine, text: "Rivers", highlightRanges: nil, moveInfo: nil, offset: DiffItemOffset(from: nil, to: 40), lineNumber: 10)
+        ]
+        let response = DiffResponse(diff: items, from: DiffSideMetaData(sections: sections), to: DiffSideMetaData(sections: sections))
+
+        let intro = WMFLocalizedString("diff-single-intro-title", value:"Intro", comment:"Section heading on revision changes diff screen that indicates the following highlighted changes occurred in the intro section.")
+        XCTAssertEqual(describe(DiffTransformer.groups(from: response, type: .single)), ["change 1 \(intro)", "change 2 History", "change 1 Geography"])
+        XCTAssertEqual(describe(DiffTransformer.groups(from: response, type: .compare)), ["change 1 \(intro)", "context 1", "change 2 History", "unedited 7", "change 1 Geography"])
+    }
+
+    func testMovesLinkAcrossSections() throws {
+        let sections = [DiffSection(level: 2, heading: "History", offset: 10), DiffSection(level: 2, heading: "Geography", offset: 30)]
+        let items = [
+            DiffItem(type: .moveSource, text: "Moved", highlightRanges: nil, moveInfo: DiffMoveInfo(id: "a", linkId: "b", linkDirection: .down), offset: DiffItemOffset(from: 15, to: nil), lineNumber: 2),
+            DiffItem(type: .moveDestination, text: "Moved", highlightRanges: nil, moveInfo: DiffMoveInfo(id: "b", linkId: "a", linkDirection: .up), offset: DiffItemOffset(from: nil, to: 35), lineNumber: 9)
+        ]
+        let response = DiffResponse(diff: items, from: DiffSideMetaData(sections: sections), to: DiffSideMetaData(sections: sections))
+
+        let transformedItems = DiffTransformer.transformDiffItems(from: response)
+        XCTAssertEqual(transformedItems.map { $0.moveInfo?.groupedIndex }, [0, 0])
+        XCTAssertEqual(transformedItems.map { $0.moveInfo?.moveDistance.map { String(describing: $0) } }, [String(describing: TransformMoveDistance.section(amount: 1)), String(describing: TransformMoveDistance.section(amount: 1))])
+        assertEqual(transformedItems, DiffTransformerTestCorpus.legacyTransformDiffItems(from: response))
+    }
+
+    func testViewModelsMatchGroups() {
+        let response = DiffTransformerTestCorpus.response(itemCount: 300, seed: 47)
+        let transformer = DiffTransformer(type: .compare, siteURL: URL(string: "https://en.wikipedia.org")!)
+        let groups = DiffTransformer.groups(from: response, type: .compare)
+        let viewModels = transformer.viewModels(from: groups, theme: .standard, traitCollection: UITraitCollection(preferredContentSizeCategory: .large))
+
+        XCTAssertEqual(viewModels.count, groups.count)
+        for (viewModel, group) in zip(viewModels, groups) {
+            switch group {
+            case .change(let items):
+                XCTAssertEqual((viewModel as? DiffListChangeViewModel)?.items.count, items.count)
+            case .context:
+                XCTAssertTrue(viewModel is DiffListContextViewModel)
+            case .unedited:
+                XCTAssertTrue(viewModel is DiffListUneditedViewModel)
+            }
+        }
+    }
+
+    func testChangeItemAttributedStringsFollowTheme() throws {
+        let response = DiffTransformerTestCorpus.response(itemCount: 50, seed: 48)
+        let item = try XCTUnwrap(DiffTransformer.transformDiffItems(from: response).first { $0.type == .addLine })
+        let viewModel = DiffListChangeItemViewModel(item: item, traitCollection: UITraitCollection(preferredContentSizeCategory: .large), theme: .standard, type: .compareRevision, diffItemType: item.type, nextMiddleItem: nil, semanticContentAttribute: .forceLeftToRight)
+
+        let standardString = try XCTUnwrap(viewModel.textAttributedString)
+        XCTAssertTrue(viewModel.textAttributedString === standardString, "Attributed strings should be built once per theme")
+
+        viewModel.theme = .dark
+        let darkString = try XCTUnwrap(viewModel.textAttributedString)
+        XCTAssertFalse(darkString === standardString)
+        XCTAssertEqual(darkString.string, standardString.string)
+
+        viewModel.theme = .standard
+        XCTAssertTrue(viewModel.textAttributedString === standardString, "Switching back should reuse the first theme's string")
+    }
+}
@@ -0,0 +1,14 @@
+#import "NSURL+WMFLinkParsing.h"
+
+NS_ASSUME_NONNULL_BEGIN
+
+@interface NSURL (WMFLinkParsingTesting)
+
+/**
+ * The URL that @c wmf_databaseKey is derived from. Not memoized.
+ */
+@property (nonatomic, copy, readonly, nullable) NSURL *wmf_databaseURL;
+
+@end
+
+NS_ASSUME_NONNULL_END
@@ -0,0 +1,146 @@
+import XCTest
+
+/// URLs used to check that memoized database keys match keys computed from `wmf_databaseURL`
+enum DatabaseKeyTestCorpus {
+    // The URLs from NSURL+WMFLinkParsingTests and variations of them
+    static let urlStrings = [
+        "https://en.wikipedia.org/wiki/Foo",
+        "https://en.wikipedia.org/wiki/Foo?query=&string=value#fragment",
+        "https://www.foo.com/bar",
+        "https://en.wikipedia.org/api/rest_v1/page/talk/Username",
+        "https://es.wikipedia.org/api/rest_v1/page/talk/Username",
+        "https://sr.wikipedia.org",
+        "https://zh.wikipedia.org",
+        "#cite_note-0",
+        "/Foo",
+        "/wiki/",
+        "/wiki/Foo",
+        "/wiki/Foo#bar",
+        "https://en.m.wikipedia.org/wiki/Foo",
+        "http://en.wikipedia.org/wiki/Foo#bar",
+        "https://en.wikipedia.org/wiki/Talk:India",
+        "https://en.wikipedia.org/wiki/Caf%C3%A9",
+        "https://en.wikipedia.org/wiki/Cafe%CC%81",
+        "https://en.m.wikipedia.org/wiki/Caf%C3%A9#History",
+        "https://de.wikipedia.org/wiki/%C3%84rger",
+        "https://zh.wikipedia.org/wiki/%E4%B8%AD%E5%9B%BD?variant=zh-hans",
+        "https://commons.wikimedia.org/wiki/File:Foo.jpg",
+        "https://www.mediawiki.org/wiki/API:Main_page",
+        "https://en.wikipedia.org/w/index.php?title=Foo&action=edit"
+    ]
+
+    private static let languageCodes = ["en", "de", "fr", "zh", "sr", "ja", "ru", "es"]
+    private static let titleCharacters: [String] = ["é", "e\u{301}", "ß", "中", "й", "_", "(", ")", "'", "-", ",", ":", "%", "&", "!", "+"]
+
+    /// Random article URLs with mobile hosts, fragments and characters that need escaping or normalization
+    static func fuzzedURLStrings(count: Int, seed: UInt64) -> [String] {
+        var generator = SeededRandomNumberGenerator(seed: seed)
+        return (0..<count).map { _ in
+            var title = generator.title()
+            for _ in 0..<Int.random(in: 0...3, using: &generator) {
+                let index = title.index(title.startIndex, offsetBy: Int.random(in: 0...title.count, using: &generator))
+                title.insert(contentsOf: titleCharacters.randomElement(using: &generator) ?? "", at: index)
+            }
+            let languageCode = languageCodes.randomElement(using: &generator) ?? "en"
+            let host = Bool.random(using: &generator) ? "\(languageCode).m.wikipedia.org" : "\(languageCode).wikipedia.org"
+            let path = title.replacingOccurrences(of: " ", with: "_").addingPercentEncoding(withAllowedCharacters: .urlPathAllowed) ?? title
+            let fragment = Int.random(in: 0..<4, using: &generator) == 0 ? "#Section_\(generator.next() % 10)" : ""
+            return "https://\(host)/wiki/\(path)\(fragment)"
+        }
+    }
+
+    static func uncachedDatabaseKey(for url: NSURL) -> String? {
+        return url.wmf_databaseURL?.absoluteString.precomposedStringWithCanonicalMapping
+    }
+}
+
+class NSURLDatabaseKeyTests: XCTestCase {
+
+    private var urlStrings: [String] {
+        return DatabaseKeyTestCorpus.urlStrings + DatabaseKeyTestCorpus.fuzzedURLStrings(count: 2000, seed: 39)
+    }
+
+    func testDatabaseKeysMatchUncachedKeys() throws {
+        for urlString in urlStrings {
+            let url = try XCTUnwrap(NSURL(string: urlString), urlString)
+            let expectedKey = DatabaseKeyTestCorpus.uncachedDatabaseKey(for: url)
+            XCTAssertEqual(url.wmf_databaseKey, expectedKey, urlString)
+            XCTAssertEqual(url.wmf_databaseKey, expectedKey, "The memoized key should match for \(urlString)")
+            XCTAssertEqual(NSURL(string: urlString)?.wmf_databaseKey, expectedKey, "A new URL with the same string should have the same key for \(urlString)")
+        }
+    }
+
+    func testRelativeURLKeysDependOnTheirBase() throws {
+        let baseURLs = ["https://en.wikipedia.org", "https://de.m.wikipedia.org/wiki/", "https://fr.wikipedia.org/w/"].compactMap { URL(string: $0) }
+        for baseURL in baseURLs {
+            for path in ["/wiki/Foo", "Foo", "Caf%C3%A9#bar"] {
+                let url = try XCTUnwrap(NSURL(string: path, relativeTo: baseURL))
+                XCTAssertEqual(url.wmf_databaseKey, DatabaseKeyTestCorpus.uncachedDatabaseKey(for: url), "\(path) relative to \(baseURL)")
+            }
+        }
+        let absoluteURL = try XCTUnwrap(NSURL(string: "https://en.wikipedia.org/wiki/Foo"))
+        XCTAssertEqual(absoluteURL.wmf_databaseKey, DatabaseKeyTestCorpus.uncachedDatabaseKey(for: absoluteURL))
+    }
+
+    /// The key object itself, bridging it to a Swift String can copy it
+    private func databaseKeyObject(for url: NSURL) -> AnyObject? {
+        return url.perform(#selector(getter: NSURL.wmf_databaseKey))?.takeUnretainedValue()
+    }
+
+    func testEqualKeysAreInterned() throws {
+        let desktopURL = try XCTUnwrap(NSURL(string: "https://en.wikipedia.org/wiki/Interned_Title"))
+        let mobileURL = try XCTUnwrap(NSURL(string: "https://en.m.wikipedia.org/wiki/Interned_Title#Section"))
+        XCTAssertEqual(desktopURL.wmf_databaseKey, mobileURL.wmf_databaseKey)
+        let desktopKey = try XCTUnwrap(databaseKeyObject(for: desktopURL))
+        let mobileKey = try XCTUnwrap(databaseKeyObject(for: mobileURL))
+        XCTAssertTrue(desktopKey === mobileKey, "Equal keys should share the same string")
+        XCTAssertTrue(databaseKeyObject(for: desktopURL) === desktopKey, "The key should be memoized")
+    }
+
+    func testLanguageVariantsDoNotChangeDatabaseKeys() throws {
+        let url = try XCTUnwrap(NSURL(string: "https://zh.wikipedia.org/wiki/%E4%B8%AD%E5%9B%BD"))
+        let key = try XCTUnwrap(url.wmf_databaseKey)
+        let inMemoryKey = try XCTUnwrap(url.wmf_inMemoryKey)
+        url.wmf_languageVariantCode = "zh-hant"
+        XCTAssertEqual(url.wmf_databaseKey, key)
+        XCTAssertEqual(url.wmf_databaseKey, DatabaseKeyTestCorpus.uncachedDatabaseKey(for: url))
+        let variantInMemoryKey = try XCTUnwrap(url.wmf_inMemoryKey)
+        XCTAssertEqual(variantInMemoryKey.languageVariantCode, "zh-hant")
+        XCTAssertNotEqual(variantInMemoryKey, inMemoryKey)
+        XCTAssertEqual(variantInMemoryKey, WMFInMemoryURLKey(databaseKey: key, languageVariantCode: "zh-hant"))
+        XCTAssertEqual(variantInMemoryKey.hash, WMFInMemoryURLKey(databaseKey: key, languageVariantCode: "zh-hant").hash)
+        XCTAssertEqual(inMemoryKey, WMFInMemoryURLKey(databaseKey: key, languageVariantCode: nil))
+    }
+
+    func testBatchKeysMatchIndividualKeys() throws {
+        var urls = urlStrings.compactMap { URL(string: $0) }
+        urls += urls.prefix(100) // Repeated URLs
+        let variantURL = try XCTUnwrap(NSURL(string: "https://sr.wikipedia.org/wiki/Foo"))
+        variantURL.wmf_languageVariantCode = "sr-el"
+        urls.append(variantURL as URL)
+
+        XCTAssertEqual(NSURL.wmf_databaseKeys(for: urls), urls.compactMap { ($0 as NSURL).wmf_databaseKey })
+        let inMemoryKeys = NSURL.wmf_inMemoryKeys(for: urls)
+        XCTAssertEqual(inMemoryKeys, urls.compactMap { ($0 as NSURL).wmf_inMemoryKey })
+        XCTAssertEqual(inMemoryKeys.last?.languageVariantCode, "sr-el")
+    }
+
+    func testConcurrentLookups() {
+        let urlStrings = DatabaseKeyTestCorpus.fuzzedURLStrings(count: 5000, seed: 40)
+        let expectedKeys = urlStrings.map { NSURL(string: $0).flatMap { DatabaseKeyTestCorpus.uncachedDatabaseKey(for: $0) } }
+        let lock = NSLock()
+        var mismatchCount = 0
+        DispatchQueue.concurrentPerform(iterations: 8) { iteration in
+            var iterationMismatchCount = 0
+            for (index, urlString) in urlStrings.enumerated().reversed() where index % 8 != iteration {
+                if NSURL(string: urlString)?.wmf_databaseKey != expectedKeys[index] {
+                    iterationMismatchCount += 1
+                }
+            }
+            lock.lock()
+            mismatchCount += iterationMismatchCount
+            lock.unlock()
+        }
+        XCTAssertEqual(mismatchCount, 0)
+    }
+}
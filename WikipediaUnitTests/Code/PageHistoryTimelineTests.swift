@@ -0,0 +1,109 @@
+import XCTest
+@testable import Wikipedia
+
+class PageHistoryTimelineTests: XCTestCase {
+
+    private static let revisionCount = 50_000
+
+    /// Revisions newest first, a few minutes to a few hours apart, so days have anywhere from one to dozens of revisions
+    private lazy var revisions: [WMFPageHistoryRevision] = {
+        var date = Date(timeIntervalSince1970: 1_700_000_000)
+        return (0..<Self.revisionCount).compactMap { index in
+            date.addTimeInterval(-TimeInterval(60 + (index * 7_919) % (4 * 3_600)))
+            let revisionID = Self.revisionCount - index
+            return try? WMFPageHistoryRevision(dictionary: [
+                "revisionID": revisionID,
+                "parentID": revisionID - 1,
+                "user": "User \(index % 100)",
+                "revisionDate": date,
+                "articleSizeAtRevision": 1_000 + index
+            ])
+        }
+    }()
+
+    private let dateFormatter = DateFormatter.wmf_long()
+
+    /// Sections for consecutive revisions, one per day, as `PageHistoryFetcher` groups a page
+    private func sections(for revisions: ArraySlice<WMFPageHistoryRevision>) -> [PageHistorySection] {
+        var sections: [PageHistorySection] = []
+        var sectionTitle: String?
+        var items: [WMFPageHistoryRevision] = []
+        for revision in revisions {
+            let title = dateFormatter.string(from: revision.revisionDate!)
+            if title != sectionTitle, let sectionTitle {
+                sections.append(PageHistorySection(sectionTitle: sectionTitle, items: items))
+                items.removeAll()
+            }
+            sectionTitle = title
+            items.append(revision)
+        }
+        if let sectionTitle {
+            sections.append(PageHistorySection(sectionTitle: sectionTitle, items: items))
+        }
+        return sections
+    }
+
+    private func timeline(pageSize: Int) -> PageHistoryTimeline {
+        var timeline = PageHistoryTimeline()
+        for start in stride(from: 0, to: revisions.count, by: pageSize) {
+            _ = timeline.append(sections(for: revisions[start..<min(start + pageSize, revisions.count)]))
+        }
+        return timeline
+    }
+
+    func testRevisionsAreLoaded() {
+        XCTAssertEqual(revisions.count, Self.revisionCount)
+    }
+
+    func testAppendingPagesMatchesOneGrouping() {
+        let expectedSections = sections(for: revisions[...])
+
+        for pageSize in [1, 50, 137, 1_000] {
+            let timeline = self.timeline(pageSize: pageSize)
+            XCTAssertEqual(timeline.revisionCount, revisions.count)
+            XCTAssertEqual(timeline.sections.count, expectedSections.count, "Page size \(pageSize)")
+            for (section, expectedSection) in zip(timeline.sections, expectedSections) {
+                XCTAssertEqual(section.sectionTitle, expectedSection.sectionTitle)
+                XCTAssertEqual(section.items.map { $0.revisionID }, expectedSection.items.map { $0.revisionID })
+            }
+        }
+    }
+
+    func testUpdatesDescribeOnlyNewRevisions() {
+        var timeline = PageHistoryTimeline()
+        var sectionItemCounts: [Int] = []
+
+        for start in stride(from: 0, to: 5_000, by: 50) {
+            let update = timeline.append(sections(for: revisions[start..<start + 50]))
+
+            // Applying the update to the previous counts gives the new counts, like a collection view batch update
+            for indexPath in update.insertedItems {
+                XCTAssertEqual(indexPath.section, sectionItemCounts.count - 1, "Only the last section should gain items")
+                XCTAssertEqual(indexPath.item, sectionItemCounts[indexPath.section])
+                sectionItemCounts[indexPath.section] += 1
+            }
+            if let firstInsertedSection = update.insertedSections.first {
+                XCTAssertEqual(firstInsertedSection, sectionItemCounts.count)
+            }
+            sectionItemCounts.append(contentsOf: update.insertedSections.map { timeline.sections[$0].items.count })
+            XCTAssertEqual(sectionItemCounts, timeline.sections.map { $0.items.count })
+        }
+    }
+
+    func testNeighborLookups() {
+        let timeline = self.timeline(pageSize: 50)
+
+        XCTAssertNil(timeline.revision(after: revisions[0].revisionID), "The latest revision has nothing after it")
+        XCTAssertNil(timeline.revision(before: revisions[revisions.count - 1].revisionID), "The first revision has nothing before it")
+        XCTAssertNil(timeline.revision(before: -1))
+
+        for (index, revision) in revisions.enumerated() {
+            if index + 1 < revisions.count {
+                XCTAssertEqual(timeline.revision(before: revision.revisionID)?.revisionID, revisions[index + 1].revisionID)
+            }
+            if index > 0 {
+                XCTAssertEqual(timeline.revision(after: revision.revisionID)?.revisionID, revisions[index - 1].revisionID)
+            }
+        }
+    }
+}
@@ -0,0 +1,151 @@
+import XCTest
+@testable import WMF
+
+class PermanentlyPersistableURLCacheQuotaTests: XCTestCase {
+
+    var directoryURL: URL!
+    var moc: NSManagedObjectContext!
+    let now = Date(timeIntervalSinceReferenceDate: 700_000_000)
+
+    override func setUpWithError() throws {
+        directoryURL = FileManager.default.temporaryDirectory.appendingPathComponent(UUID().uuidString, isDirectory: true)
+        moc = try XCTUnwrap(CacheController.createCacheContext(cacheURL: directoryURL))
+    }
+
+    override func tearDownWithError() throws {
+        moc = nil
+        try? FileManager.default.removeItem(at: directoryURL)
+    }
+
+    private func quota(quotaInBytes: Int64) -> PermanentlyPersistableURLCacheQuota {
+        return PermanentlyPersistableURLCacheQuota(moc: moc, directoryURL: directoryURL, quotaInBytes: quotaInBytes, fileNamesForItem: { (itemKey, _) in
+            return [itemKey, itemKey + "__Header"]
+        })
+    }
+
+    /// Writes a content file of `byteCount` bytes and an empty header file, then records them with a quota large enough not to evict anything
+    private func addItem(key: String, byteCount: Int, lastAccessDate: Date, groupKey: String? = nil, isMustHave: Bool = false) throws {
+        try Data(repeating: 0, count: byteCount).write(to: directoryURL.appendingPathComponent(key))
+        try Data().write(to: directoryURL.appendingPathComponent(key + "__Header"))
+
+        moc.performAndWait {
+            let item = CacheDBWriterHelper.createCacheItem(with: URL(string: "https://upload.wikimedia.org/\(key)")!, itemKey: key, variant: nil, in: moc)
+            item?.isDownloaded = true
+            if let groupKey, let group = CacheDBWriterHelper.fetchOrCreateCacheGroup(with: groupKey, in: moc), let item {
+                if isMustHave {
+                    group.addToMustHaveCacheItems(item)
+                } else {
+                    group.addToCacheItems(item)
+                }
+            }
+            CacheDBWriterHelper.save(moc: moc) { _ in }
+        }
+
+        let expectation = self.expectation(description: "Recorded \(key)")
+        quota(quotaInBytes: .max).recordWrite(itemKey: key, variant: nil, date: lastAccessDate) {
+            expectation.fulfill()
+        }
+        wait(for: [expectation], timeout: 5)
+    }
+
+    private func enforce(_ quota: PermanentlyPersistableURLCacheQuota) -> [String] {
+        var evictedKeys: [String] = []
+        let expectation = self.expectation(description: "Enforced quota")
+        quota.enforceQuota(now: now) { evictedItems in
+            evictedKeys = evictedItems.map { $0.itemKey }
+            expectation.fulfill()
+        }
+        wait(for: [expectation], timeout: 5)
+        return evictedKeys
+    }
+
+    private func isCached(_ key: String) -> Bool {
+        var hasItem = false
+        moc.performAndWait {
+            hasItem = CacheDBWriterHelper.cacheItem(with: key, variant: nil, in: moc) != nil
+        }
+        let hasFile = FileManager.default.fileExists(atPath: directoryURL.appendingPathComponent(key).path)
+        XCTAssertEqual(hasItem, hasFile, "\(key) should be removed from the database and the disk together")
+        return hasItem && hasFile
+    }
+
+    private func fillPastQuota() throws {
+        try addItem(key: "saved", byteCount: 5000, lastAccessDate: now.addingTimeInterval(-86_400 * 1000), groupKey: "en.wikipedia.org/wiki/Saved")
+        try addItem(key: "savedResource", byteCount: 1000, lastAccessDate: now.addingTimeInterval(-86_400 * 1000), groupKey: "en.wikipedia.org/wiki/Saved", isMustHave: true)
+        try addItem(key: "A", byteCount: 2000, lastAccessDate: now.addingTimeInterval(-100)) // cost 200,000
+        try addItem(key: "B", byteCount: 500, lastAccessDate: now.addingTimeInterval(-1000)) // cost 500,000
+        try addItem(key: "C", byteCount: 3000, lastAccessDate: now.addingTimeInterval(-500)) // cost 1,500,000
+        try addItem(key: "D", byteCount: 1000, lastAccessDate: now.addingTimeInterval(-10)) // cost 10,000
+    }
+
+    func testEvictsUnpinnedItemsInCostWeightedLRUOrder() throws {
+        try fillPastQuota()
+
+        // 12,500 bytes cached, evicting C, B and A gets under 8,000
+        XCTAssertEqual(enforce(quota(quotaInBytes: 8000)), ["C", "B", "A"])
+
+        XCTAssertTrue(isCached("D"))
+        XCTAssertTrue(isCached("saved"), "Items in a cache group should never be evicted")
+        XCTAssertTrue(isCached("savedResource"), "Items a cache group must have should never be evicted")
+        for key in ["A", "B", "C"] {
+            XCTAssertFalse(isCached(key), "\(key) should have been evicted")
+            XCTAssertFalse(FileManager.default.fileExists(atPath: directoryURL.appendingPathComponent(key + "__Header").path))
+        }
+
+        XCTAssertEqual(enforce(quota(quotaInBytes: 8000)), [], "Cache should already be within quota")
+    }
+
+    func testReadsMakeItemsCheaperToKeep() throws {
+        try fillPastQuota()
+
+        let quota = self.quota(quotaInBytes: 9500)
+        quota.recordAccess(itemKey: "C", variant: nil, date: now)
+
+        // C's cost drops to 3,000, below everything else
+        XCTAssertEqual(enforce(quota), ["B", "A", "D"])
+        XCTAssertTrue(isCached("C"))
+        XCTAssertTrue(isCached("saved"))
+        XCTAssertTrue(isCached("savedResource"))
+    }
+
+    func testOnlyPinnedItemsLeftStaysOverQuota() throws {
+        try addItem(key: "saved", byteCount: 5000, lastAccessDate: now.addingTimeInterval(-86_400), groupKey: "en.wikipedia.org/wiki/Saved")
+        try addItem(key: "A", byteCount: 2000, lastAccessDate: now)
+
+        XCTAssertEqual(enforce(quota(quotaInBytes: 1000)), ["A"])
+        XCTAssertTrue(isCached("saved"))
+    }
+    func testFirstVersionStoreMigratesToCurrentModel() throws {
+        let cacheURL = FileManager.default.temporaryDirectory.appendingPathComponent(UUID().uuidString, isDirectory: true)
+        defer {
+            try? FileManager.default.removeItem(at: cacheURL)
+        }
+        try FileManager.default.createDirectory(at: cacheURL, withIntermediateDirectories: true)
+
+        // Save an item with the first model, where variant is an integer
+        let modelURL = try XCTUnwrap(Bundle.wmf.url(forResource: "Cache", withExtension: "momd"))
+        let firstModel = try XCTUnwrap(NSManagedObjectModel(contentsOf: modelURL.appendingPathComponent("Cache.mom")))
+        let firstCoordinator = NSPersistentStoreCoordinator(managedObjectModel: firstModel)
+        let dbURL = cacheURL.appendingPathComponent("Cache.sqlite")
+        let firstStore = try firstCoordinator.addPersistentStore(ofType: NSSQLiteStoreType, configurationName: nil, at: dbURL, options: nil)
+        let firstContext = NSManagedObjectContext(concurrencyType: .privateQueueConcurrencyType)
+        firstContext.persistentStoreCoordinator = firstCoordinator
+        try firstContext.performAndWait {
+            let entity = try XCTUnwrap(firstModel.entitiesByName["CacheItem"])
+            let item = NSManagedObject(entity: entity, insertInto: firstContext)
+            item.setValue("upload.wikimedia.org__Cat.jpg", forKey: "key")
+            item.setValue(640, forKey: "variant")
+            item.setValue(now, forKey: "date")
+            try firstContext.save()
+        }
+        try firstCoordinator.remove(firstStore)
+
+        let moc = try XCTUnwrap(CacheController.createCacheContext(cacheURL: cacheURL))
+        moc.performAndWait {
+            let item = CacheDBWriterHelper.cacheItem(with: "upload.wikimedia.org__Cat.jpg", variant: "640", in: moc)
+            XCTAssertNotNil(item, "Items should survive migrating through every model version")
+            XCTAssertEqual(item?.byteCount, 0)
+            XCTAssertNil(item?.lastAccessDate)
+        }
+    }
+}
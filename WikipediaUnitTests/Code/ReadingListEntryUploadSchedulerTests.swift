@@ -0,0 +1,220 @@
+import XCTest
+@testable import WMF
+
+/// Local stand-in for the `POST /lists/{id}/entries/batch` endpoint.
+/// Assigns sequential entry IDs, enforces a per-list entry limit and can fail requests on demand.
+fileprivate class MockReadingListEntriesEndpoint: ReadingListEntryBatchUploading {
+
+    private let lock = NSLock()
+    private let responseQueue = DispatchQueue(label: "MockReadingListEntriesEndpoint", attributes: .concurrent)
+
+    private var nextEntryID: Int64 = 1
+    private(set) var entriesByListID: [Int64: [(id: Int64, project: String, title: String)]] = [:]
+    private(set) var requestCount = 0
+    private(set) var requestSizes: [Int] = []
+    private(set) var requestDates: [Date] = []
+    private(set) var maxInFlightRequestCount = 0
+    private var inFlightRequestCount = 0
+
+    var entryLimitPerList = Int.max
+    var deletedListIDs: Set<Int64> = []
+    /// Number of upcoming requests to fail with a transport error before the server sees them
+    var requestsToFail = 0
+    /// Titles that get a per-entry generic error the first time they are sent
+    var titlesToFailOnce: Set<String> = []
+
+    func addEntriesToList(withListID listID: Int64, entries: [(project: String, title: String)], completion: @escaping ([(Int64?, Error?)]?, Error?) -> Void) {
+        lock.lock()
+        requestCount += 1
+        requestSizes.append(entries.count)
+        requestDates.append(Date())
+        inFlightRequestCount += 1
+        maxInFlightRequestCount = max(maxInFlightRequestCount, inFlightRequestCount)
+        lock.unlock()
+
+        responseQueue.asyncAfter(deadline: .now() + .milliseconds(5)) {
+            self.lock.lock()
+            defer {
+                self.inFlightRequestCount -= 1
+                self.lock.unlock()
+            }
+
+            if self.requestsToFail > 0 {
+                self.requestsToFail -= 1
+                completion(nil, URLError(.timedOut))
+                return
+            }
+
+            guard !self.deletedListIDs.contains(listID) else {
+                completion(nil, APIReadingListError.listDeleted)
+                return
+            }
+
+            var results: [(Int64?, Error?)] = []
+            for entry in entries {
+                if self.titlesToFailOnce.contains(entry.title) {
+                    self.titlesToFailOnce.remove(entry.title)
+                    results.append((nil, APIReadingListError.generic))
+                    continue
+                }
+                if let existing = self.entriesByListID[listID]?.first(where: { $0.project == entry.project && $0.title == entry.title }) {
+                    results.append((existing.id, nil))
+                    continue
+                }
+                guard self.entriesByListID[listID, default: []].count < self.entryLimitPerList else {
+                    results.append((nil, APIReadingListError.entryLimit))
+                    continue
+                }
+                let id = self.nextEntryID
+                self.nextEntryID += 1
+                self.entriesByListID[listID, default: []].append((id: id, project: entry.project, title: entry.title))
+                results.append((id, nil))
+            }
+            completion(results, nil)
+        }
+    }
+}
+
+class ReadingListEntryUploadSchedulerTests: XCTestCase {
+
+    fileprivate var endpoint: MockReadingListEntriesEndpoint!
+
+    override func setUp() {
+        super.setUp()
+        endpoint = MockReadingListEntriesEndpoint()
+    }
+
+    private func uploads(listCount: Int, entriesPerList: Int) -> [ReadingListEntryUpload] {
+        var uploads: [ReadingListEntryUpload] = []
+        for entryIndex in 0..<entriesPerList {
+            for listIndex in 0..<listCount {
+                uploads.append(ReadingListEntryUpload(listID: Int64(listIndex + 1), project: "https://en.wikipedia.org", title: "Title_\(listIndex)_\(entryIndex)"))
+            }
+        }
+        return uploads
+    }
+
+    private func createdIDs(from results: [ReadingListEntryUploadResult?]) -> [Int64] {
+        return results.compactMap {
+            guard case .created(let id)? = $0 else {
+                return nil
+            }
+            return id
+        }
+    }
+
+    func testUploadsBatchAcrossListsAndMapsIDsBackInOrder() {
+        let uploads = uploads(listCount: 30, entriesPerList: 7)
+        let scheduler = ReadingListEntryUploadScheduler(uploader: endpoint, batchSize: 5, maxConcurrentRequests: 4)
+        let results = scheduler.uploadAndWait(uploads)
+
+        XCTAssertEqual(results.count, uploads.count)
+        let ids = createdIDs(from: results)
+        XCTAssertEqual(ids.count, uploads.count)
+        XCTAssertEqual(Set(ids).count, uploads.count, "Each entry should get its own server ID")
+
+        for (upload, result) in zip(uploads, results) {
+            guard case .created(let id)? = result else {
+                XCTFail("Expected \(upload.title) to be created")
+                continue
+            }
+            let serverEntry = endpoint.entriesByListID[upload.listID]?.first(where: { $0.id == id })
+            XCTAssertEqual(serverEntry?.title, upload.title, "IDs should map back to the entry that was sent")
+        }
+
+        XCTAssertEqual(endpoint.requestCount, 30 * 2, "Each list of 7 should be sent as batches of 5 and 2")
+        XCTAssertLessThanOrEqual(endpoint.maxInFlightRequestCount, 4)
+        XCTAssertGreaterThan(endpoint.maxInFlightRequestCount, 1, "Requests should be pipelined")
+    }
+
+    func testFailedRequestsAreRetriedOnTheirOwn() {
+        endpoint.requestsToFail = 2
+        let uploads = uploads(listCount: 3, entriesPerList: 4)
+        let scheduler = ReadingListEntryUploadScheduler(uploader: endpoint, batchSize: 4, maxConcurrentRequests: 1, maxAttempts: 3, retryDelay: 0)
+        let results = scheduler.uploadAndWait(uploads)
+
+        XCTAssertEqual(createdIDs(from: results).count, uploads.count)
+        XCTAssertEqual(endpoint.requestCount, 3 + 2, "Only the two failed sub-batches should be sent again")
+    }
+
+    func testOnlyFailedEntriesAreRetried() {
+        endpoint.titlesToFailOnce = ["Title_0_1", "Title_1_3"]
+        let uploads = uploads(listCount: 2, entriesPerList: 5)
+        let scheduler = ReadingListEntryUploadScheduler(uploader: endpoint, batchSize: 5, maxConcurrentRequests: 2, retryDelay: 0)
+        let results = scheduler.uploadAndWait(uploads)
+
+        XCTAssertEqual(createdIDs(from: results).count, uploads.count)
+        XCTAssertEqual(endpoint.requestSizes.sorted(), [1, 1, 5, 5])
+    }
+
+    func testRetriesBackOffExponentially() {
+        endpoint.requestsToFail = 2
+        let scheduler = ReadingListEntryUploadScheduler(uploader: endpoint, batchSize: 1, maxConcurrentRequests: 1, maxAttempts: 3, retryDelay: 0.05)
+        let results = scheduler.uploadAndWait(uploads(listCount: 1, entriesPerList: 1))
+
+        XCTAssertEqual(createdIDs(from: results).count, 1)
+        XCTAssertEqual(endpoint.requestDates.count, 3)
+        XCTAssertGreaterThanOrEqual(endpoint.requestDates[1].timeIntervalSince(endpoint.requestDates[0]), 0.05)
+        XCTAssertGreaterThanOrEqual(endpoint.requestDates[2].timeIntervalSince(endpoint.requestDates[1]), 0.1, "The second retry should wait twice as long")
+    }
+
+    func testBatchResultsAreReportedOnTheCallingThreadAsTheyFinish() {
+        endpoint.titlesToFailOnce = ["Title_1_2"]
+        let uploads = uploads(listCount: 3, entriesPerList: 4)
+        let scheduler = ReadingListEntryUploadScheduler(uploader: endpoint, batchSize: 4, maxConcurrentRequests: 2, retryDelay: 0)
+        let callingThread = Thread.current
+        var reportedBatches: [ReadingListEntryUploadScheduler.BatchResults] = []
+        let results = scheduler.uploadAndWait(uploads, batchCompletion: { batchResults in
+            XCTAssertEqual(Thread.current, callingThread)
+            reportedBatches.append(batchResults)
+        })
+
+        XCTAssertEqual(reportedBatches.count, endpoint.requestCount)
+        XCTAssertEqual(reportedBatches.map { $0.count }.sorted(), [1, 3, 4, 4], "The entry being retried should only be reported once it's created")
+        XCTAssertEqual(reportedBatches.flatMap { $0.map { $0.index } }.sorted(), Array(0..<uploads.count))
+        XCTAssertEqual(createdIDs(from: reportedBatches.flatMap { $0.map { $0.result } }).sorted(), createdIDs(from: results).sorted())
+    }
+
+    func testPermanentErrorsAreNotRetried() {
+        endpoint.entryLimitPerList = 3
+        endpoint.deletedListIDs = [2]
+        let uploads = uploads(listCount: 2, entriesPerList: 5)
+        let scheduler = ReadingListEntryUploadScheduler(uploader: endpoint, batchSize: 10, maxConcurrentRequests: 2)
+        let results = scheduler.uploadAndWait(uploads)
+
+        XCTAssertEqual(endpoint.requestCount, 2)
+        var entryLimitCount = 0
+        var listDeletedCount = 0
+        for result in results {
+            guard case .failed(let error)? = result else {
+                continue
+            }
+            switch error as? APIReadingListError {
+            case .entryLimit?:
+                entryLimitCount += 1
+            case .listDeleted?:
+                listDeletedCount += 1
+            default:
+                XCTFail("Unexpected error \(error)")
+            }
+        }
+        XCTAssertEqual(createdIDs(from: results).count, 3)
+        XCTAssertEqual(entryLimitCount, 2)
+        XCTAssertEqual(listDeletedCount, 5)
+    }
+
+    func testCancellationStopsStartingNewRequests() {
+        let uploads = uploads(listCount: 10, entriesPerList: 1)
+        let scheduler = ReadingListEntryUploadScheduler(uploader: endpoint, batchSize: 1, maxConcurrentRequests: 1)
+        var checks = 0
+        let results = scheduler.uploadAndWait(uploads, isCancelled: {
+            checks += 1
+            return checks > 3
+        })
+
+        XCTAssertEqual(results.count, uploads.count)
+        XCTAssertLessThan(endpoint.requestCount, uploads.count)
+        XCTAssertEqual(createdIDs(from: results).count, endpoint.requestCount, "Requests that were in flight should still map their IDs")
+        XCTAssertTrue(results.contains(where: { $0 == nil }))
+    }
+}
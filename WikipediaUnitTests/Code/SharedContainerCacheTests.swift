@@ -0,0 +1,106 @@
+import XCTest
+@testable import WMF
+
+class SharedContainerCacheTests: XCTestCase {
+
+    private struct TestCache: Codable, Equatable {
+        var title: String
+        var count: Int
+
+        enum CodingKeys: String, CodingKey {
+            case title
+            case count
+        }
+    }
+
+    private var subdirectoryPathComponent: String!
+    private var cache: SharedContainerCache!
+
+    private var subdirectoryURL: URL {
+        return FileManager.default.wmf_containerURL().appendingPathComponent(subdirectoryPathComponent, isDirectory: true)
+    }
+
+    private var cacheDataFileURL: URL {
+        return subdirectoryURL.appendingPathComponent("Test Cache").appendingPathExtension("json")
+    }
+
+    private var journalFileURL: URL {
+        return cacheDataFileURL.appendingPathExtension("journal")
+    }
+
+    override func setUpWithError() throws {
+        subdirectoryPathComponent = UUID().uuidString
+        cache = SharedContainerCache(fileName: "Test Cache", subdirectoryPathComponent: subdirectoryPathComponent)
+        try FileManager.default.createDirectory(at: subdirectoryURL, withIntermediateDirectories: true)
+    }
+
+    override func tearDownWithError() throws {
+        try? cache.removeCache()
+        try? FileManager.default.removeItem(at: subdirectoryURL)
+    }
+
+    /// Writes the cache file directly, so the value isn't mirrored and the next load reads the files
+    private func writeCacheFile(_ data: Data) throws {
+        try data.write(to: cacheDataFileURL)
+    }
+
+    func testUpdateAppendsToJournal() throws {
+        cache.saveCache(TestCache(title: "Earth", count: 0))
+        let cacheData = try Data(contentsOf: cacheDataFileURL)
+
+        cache.updateCache(\TestCache.count, codingKey: TestCache.CodingKeys.count, to: 1, default: TestCache(title: "", count: 0))
+
+        XCTAssertEqual(try Data(contentsOf: cacheDataFileURL), cacheData, "Updates shouldn't rewrite the cache file")
+        XCTAssertTrue(FileManager.default.fileExists(atPath: journalFileURL.path))
+        XCTAssertEqual(cache.loadCache(), TestCache(title: "Earth", count: 1))
+    }
+
+    func testJournalIsMergedOnLoad() throws {
+        try writeCacheFile(JSONEncoder().encode(TestCache(title: "Earth", count: 0)))
+        cache.updateCache(\TestCache.count, codingKey: TestCache.CodingKeys.count, to: 1, default: TestCache(title: "", count: 0))
+        cache.updateCache(\TestCache.title, codingKey: TestCache.CodingKeys.title, to: "Mars", default: TestCache(title: "", count: 0))
+
+        // A record that was only partially written is ignored
+        let handle = try FileHandle(forWritingTo: journalFileURL)
+        try handle.seekToEnd()
+        try handle.write(contentsOf: Data([0xFF, 0x00, 0x00, 0x00, 0x7B]))
+        try handle.close()
+
+        XCTAssertEqual(cache.loadCache(), TestCache(title: "Mars", count: 1))
+    }
+
+    func testCompactionFoldsJournalIntoCacheFile() throws {
+        try writeCacheFile(JSONEncoder().encode(TestCache(title: "Earth", count: 0)))
+        cache.updateCache(\TestCache.count, codingKey: TestCache.CodingKeys.count, to: 2, default: TestCache(title: "", count: 0))
+
+        cache.compactJournal()
+
+        XCTAssertFalse(FileManager.default.fileExists(atPath: journalFileURL.path))
+        XCTAssertEqual(try JSONDecoder().decode(TestCache.self, from: Data(contentsOf: cacheDataFileURL)), TestCache(title: "Earth", count: 2))
+        XCTAssertEqual(cache.loadCache(), TestCache(title: "Earth", count: 2))
+    }
+
+    func testJournalIsKeptIfCacheFileIsNotAnObject() throws {
+        try writeCacheFile(Data("[1, 2]".utf8))
+        cache.updateCache(\TestCache.count, codingKey: TestCache.CodingKeys.count, to: 1, default: TestCache(title: "", count: 0))
+
+        cache.compactJournal()
+
+        XCTAssertTrue(FileManager.default.fileExists(atPath: journalFileURL.path), "Records that couldn't be applied shouldn't be dropped")
+        XCTAssertEqual(try Data(contentsOf: cacheDataFileURL), Data("[1, 2]".utf8))
+        let loadedCache: TestCache? = cache.loadCache()
+        XCTAssertNil(loadedCache)
+    }
+
+    func testCorruptCacheFileIsReplacedBySave() throws {
+        try writeCacheFile(Data("Not JSON".utf8))
+        cache.updateCache(\TestCache.count, codingKey: TestCache.CodingKeys.count, to: 1, default: TestCache(title: "", count: 0))
+        let loadedCache: TestCache? = cache.loadCache()
+        XCTAssertNil(loadedCache)
+
+        cache.saveCache(TestCache(title: "Earth", count: 3))
+
+        XCTAssertFalse(FileManager.default.fileExists(atPath: journalFileURL.path))
+        XCTAssertEqual(cache.loadCache(), TestCache(title: "Earth", count: 3))
+    }
+}
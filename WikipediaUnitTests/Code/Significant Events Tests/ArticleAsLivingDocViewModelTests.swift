@@ -99,4 +99,86 @@ class ArticleAsLivingDocViewModelTests: XCTestCase {
         wait(for: [fetchExpectation], timeout: 10)
     }
 
+    // MARK: - Paging
+
+    private let traitCollection = UITraitCollection(preferredContentSizeCategory: .large)
+
+    private func fixtureJSON(_ name: String) throws -> [String: Any] {
+        let data = try XCTUnwrap(wmf_bundle().wmf_data(fromContentsOfFile: name, ofType: "json"))
+        return try XCTUnwrap(try JSONSerialization.jsonObject(with: data) as? [String: Any])
+    }
+
+    private func significantEvents(json: [String: Any]) throws -> SignificantEvents {
+        return try JSONDecoder().decode(SignificantEvents.self, from: JSONSerialization.data(withJSONObject: json))
+    }
+
+    /// The fixture's timeline split into two pages at `index`
+    private func pages(of json: [String: Any], splitAt index: Int) throws -> (SignificantEvents, SignificantEvents) {
+        let timeline = try XCTUnwrap(json["timeline"] as? [Any])
+        var firstPage = json
+        firstPage["timeline"] = Array(timeline[..<index])
+        var secondPage = json
+        secondPage["timeline"] = Array(timeline[index...])
+        secondPage["sha"] = nil
+        return (try significantEvents(json: firstPage), try significantEvents(json: secondPage))
+    }
+
+    private func assertEqual(_ viewModel: ArticleAsLivingDocViewModel, _ expectedViewModel: ArticleAsLivingDocViewModel, file: StaticString = #filePath, line: UInt = #line) {
+        XCTAssertEqual(viewModel.nextRvStartId, expectedViewModel.nextRvStartId, file: file, line: line)
+        XCTAssertEqual(viewModel.sha, expectedViewModel.sha, file: file, line: line)
+        XCTAssertEqual(viewModel.summaryText, expectedViewModel.summaryText, file: file, line: line)
+        XCTAssertEqual(viewModel.articleInsertHtmlSnippets, expectedViewModel.articleInsertHtmlSnippets, file: file, line: line)
+        XCTAssertEqual(viewModel.lastUpdatedTimestamp, expectedViewModel.lastUpdatedTimestamp, file: file, line: line)
+        XCTAssertEqual(viewModel.sections.count, expectedViewModel.sections.count, file: file, line: line)
+        for (section, expectedSection) in zip(viewModel.sections, expectedViewModel.sections) {
+            XCTAssertEqual(section.title, expectedSection.title, file: file, line: line)
+            XCTAssertEqual(section.subtitleTimestampDisplay, expectedSection.subtitleTimestampDisplay, file: file, line: line)
+            XCTAssertEqual(section.timestamp, expectedSection.timestamp, file: file, line: line)
+            XCTAssertEqual(section.dateRange, expectedSection.dateRange, file: file, line: line)
+            XCTAssertEqual(section.typedEvents, expectedSection.typedEvents, file: file, line: line)
+        }
+    }
+
+    func testAppendingSubsequentPageMatchesFullTimeline() throws {
+        let firstPage = try significantEvents(json: fixtureJSON("SignificantEvents-FirstPage"))
+        let subsequentPage = try significantEvents(json: fixtureJSON("SignificantEvents-SubsequentPage"))
+
+        let firstViewModel = try XCTUnwrap(ArticleAsLivingDocViewModel(significantEvents: firstPage, traitCollection: traitCollection, theme: .light))
+        let subsequentViewModel = try XCTUnwrap(ArticleAsLivingDocViewModel(significantEvents: subsequentPage, traitCollection: traitCollection, theme: .light))
+        let fullViewModel = try XCTUnwrap(ArticleAsLivingDocViewModel(significantEvents: try firstPage.appending(subsequentPage), traitCollection: traitCollection, theme: .light))
+
+        let appendedViewModel = firstViewModel.appending(subsequentViewModel)
+        assertEqual(appendedViewModel, fullViewModel)
+        XCTAssertEqual(appendedViewModel.nextRvStartId, subsequentPage.nextRvStartId)
+        XCTAssertEqual(appendedViewModel.sha, firstPage.sha)
+    }
+
+    func testAppendingAtEverySplitMatchesFullTimeline() throws {
+        for fixtureName in ["SignificantEvents-FirstPage", "SignificantEvents-SubsequentPage", "SignificantEvents-ViewModelVariations"] {
+            let json = try fixtureJSON(fixtureName)
+            let fullViewModel = try XCTUnwrap(ArticleAsLivingDocViewModel(significantEvents: significantEvents(json: json), traitCollection: traitCollection, theme: .light))
+            let eventCount = try XCTUnwrap(json["timeline"] as? [Any]).count
+
+            for index in 1..<eventCount {
+                let (firstPage, secondPage) = try pages(of: json, splitAt: index)
+                let firstViewModel = try XCTUnwrap(ArticleAsLivingDocViewModel(significantEvents: firstPage, traitCollection: traitCollection, theme: .light))
+                let secondViewModel = try XCTUnwrap(ArticleAsLivingDocViewModel(significantEvents: secondPage, traitCollection: traitCollection, theme: .light))
+                assertEqual(firstViewModel.appending(secondViewModel), fullViewModel)
+            }
+        }
+    }
+
+}
+
+extension SignificantEvents {
+
+    /// The events of both pages, continuing from `nextRvStartId` of `page`. Keeps the first page's sha.
+    func appending(_ page: SignificantEvents) throws -> SignificantEvents {
+        var json = try XCTUnwrap(JSONSerialization.jsonObject(with: JSONEncoder().encode(self)) as? [String: Any])
+        let pageJSON = try XCTUnwrap(JSONSerialization.jsonObject(with: JSONEncoder().encode(page)) as? [String: Any])
+        json["timeline"] = try XCTUnwrap(json["timeline"] as? [Any]) + XCTUnwrap(pageJSON["timeline"] as? [Any])
+        json["nextRvStartId"] = pageJSON["nextRvStartId"]
+        json["summary"] = pageJSON["summary"]
+        return try JSONDecoder().decode(SignificantEvents.self, from: JSONSerialization.data(withJSONObject: json))
+    }
 }
@@ -0,0 +1,121 @@
+import XCTest
+@testable import WMF
+
+class SignificantEventsTimelineStoreTests: XCTestCase {
+
+    private let siteURL = URL(string: "https://en.wikipedia.org")!
+    private let title = "United_States"
+
+    private var directoryURL: URL!
+    private var firstPage: SignificantEvents!
+    private var subsequentPage: SignificantEvents!
+
+    override func setUpWithError() throws {
+        directoryURL = FileManager.default.temporaryDirectory.appendingPathComponent(UUID().uuidString, isDirectory: true)
+        let firstPageData = try XCTUnwrap(wmf_bundle().wmf_data(fromContentsOfFile: "SignificantEvents-FirstPage", ofType: "json"))
+        let subsequentPageData = try XCTUnwrap(wmf_bundle().wmf_data(fromContentsOfFile: "SignificantEvents-SubsequentPage", ofType: "json"))
+        firstPage = try JSONDecoder().decode(SignificantEvents.self, from: firstPageData)
+        subsequentPage = try JSONDecoder().decode(SignificantEvents.self, from: subsequentPageData)
+    }
+
+    override func tearDownWithError() throws {
+        try? FileManager.default.removeItem(at: directoryURL)
+    }
+
+    private func page(startingAt rvStartId: UInt, title: String? = nil, siteURL: URL? = nil, in store: SignificantEventsTimelineStore) -> SignificantEvents? {
+        let expectation = self.expectation(description: "Read page")
+        var page: SignificantEvents?
+        store.page(startingAt: rvStartId, title: title ?? self.title, siteURL: siteURL ?? self.siteURL) { (savedPage) in
+            page = savedPage
+            expectation.fulfill()
+        }
+        wait(for: [expectation], timeout: 5)
+        return page
+    }
+
+    private func deleteStaleCachedItems(cleanupLevel: WMFCleanupLevel, in store: SignificantEventsTimelineStore) {
+        let expectation = self.expectation(description: "Deleted stale timelines")
+        store.deleteStaleCachedItems(cleanupLevel: cleanupLevel) {
+            expectation.fulfill()
+        }
+        wait(for: [expectation], timeout: 5)
+    }
+
+    func testPagesPersistAcrossInstances() throws {
+        let rvStartId = try XCTUnwrap(firstPage.nextRvStartId)
+        let store = SignificantEventsTimelineStore(directoryURL: directoryURL)
+        store.updateSha(firstPage.sha, title: title, siteURL: siteURL)
+        store.save(subsequentPage, startingAt: rvStartId, title: title, siteURL: siteURL)
+        XCTAssertNotNil(page(startingAt: rvStartId, in: store))
+
+        let reopenedStore = SignificantEventsTimelineStore(directoryURL: directoryURL)
+        let savedPage = try XCTUnwrap(page(startingAt: rvStartId, in: reopenedStore))
+        XCTAssertEqual(savedPage.nextRvStartId, subsequentPage.nextRvStartId)
+        XCTAssertEqual(savedPage.typedEvents.count, subsequentPage.typedEvents.count)
+        XCTAssertEqual(savedPage.summary.numChanges, subsequentPage.summary.numChanges)
+
+        XCTAssertNil(page(startingAt: rvStartId, title: "Canada", in: reopenedStore))
+        XCTAssertNil(page(startingAt: rvStartId, siteURL: URL(string: "https://de.wikipedia.org")!, in: reopenedStore))
+    }
+
+    func testChangedShaRemovesPages() throws {
+        let rvStartId = try XCTUnwrap(firstPage.nextRvStartId)
+        let store = SignificantEventsTimelineStore(directoryURL: directoryURL)
+        store.updateSha(firstPage.sha, title: title, siteURL: siteURL)
+        store.save(subsequentPage, startingAt: rvStartId, title: title, siteURL: siteURL)
+
+        store.updateSha(firstPage.sha, title: title, siteURL: siteURL)
+        XCTAssertNotNil(page(startingAt: rvStartId, in: store), "The same sha should keep saved pages")
+
+        store.updateSha("newer", title: title, siteURL: siteURL)
+        XCTAssertNil(page(startingAt: rvStartId, in: store))
+        XCTAssertNil(page(startingAt: rvStartId, in: SignificantEventsTimelineStore(directoryURL: directoryURL)))
+    }
+
+    func testOnlyMostRecentArticlePagesAreKeptInMemory() throws {
+        let rvStartId = try XCTUnwrap(firstPage.nextRvStartId)
+        let store = SignificantEventsTimelineStore(directoryURL: directoryURL)
+        store.save(subsequentPage, startingAt: rvStartId, title: title, siteURL: siteURL)
+        store.save(subsequentPage, startingAt: rvStartId, title: "Canada", siteURL: siteURL)
+        XCTAssertNotNil(page(startingAt: rvStartId, title: "Canada", in: store))
+
+        try FileManager.default.removeItem(at: directoryURL)
+        XCTAssertNil(page(startingAt: rvStartId, in: store), "Pages of other articles should be read from disk")
+        XCTAssertNotNil(page(startingAt: rvStartId, title: "Canada", in: store))
+    }
+
+    func testUnreadablePageIsIgnored() throws {
+        let rvStartId = try XCTUnwrap(firstPage.nextRvStartId)
+        let store = SignificantEventsTimelineStore(directoryURL: directoryURL)
+        store.save(subsequentPage, startingAt: rvStartId, title: title, siteURL: siteURL)
+        XCTAssertNotNil(page(startingAt: rvStartId, in: store))
+
+        let pageFileURL = try XCTUnwrap(FileManager.default.enumerator(at: directoryURL, includingPropertiesForKeys: nil)?.compactMap { $0 as? URL }.first { $0.lastPathComponent == "\(rvStartId).json" })
+        try Data("Not a page".utf8).write(to: pageFileURL)
+
+        XCTAssertNil(page(startingAt: rvStartId, in: SignificantEventsTimelineStore(directoryURL: directoryURL)))
+    }
+
+    func testEvictionKeepsMostRecentlyViewedTimelines() throws {
+        let rvStartId = try XCTUnwrap(firstPage.nextRvStartId)
+        let store = SignificantEventsTimelineStore(directoryURL: directoryURL)
+        let articleCount = SignificantEventsTimelineStore.maxCachedTimelineCount + 5
+        for index in 0..<articleCount {
+            store.updateSha(firstPage.sha, title: "Article_\(index)", siteURL: siteURL)
+            store.save(subsequentPage, startingAt: rvStartId, title: "Article_\(index)", siteURL: siteURL)
+        }
+        // Viewing the oldest timeline again makes it the most recently viewed
+        store.updateSha(firstPage.sha, title: "Article_0", siteURL: siteURL)
+
+        deleteStaleCachedItems(cleanupLevel: .low, in: store)
+
+        XCTAssertNotNil(page(startingAt: rvStartId, title: "Article_0", in: store))
+        for index in 1...5 {
+            XCTAssertNil(page(startingAt: rvStartId, title: "Article_\(index)", in: store), "Article_\(index) should have been evicted")
+        }
+        XCTAssertNotNil(page(startingAt: rvStartId, title: "Article_\(articleCount - 1)", in: SignificantEventsTimelineStore(directoryURL: directoryURL)))
+
+        deleteStaleCachedItems(cleanupLevel: .high, in: store)
+        XCTAssertNil(page(startingAt: rvStartId, title: "Article_0", in: store))
+    }
+}
@@ -0,0 +1,107 @@
+import XCTest
+@testable import Wikipedia
+@testable import WMF
+
+class TalkPageCacheFileTests: XCTestCase {
+
+    var directoryURL: URL!
+
+    override func setUpWithError() throws {
+        directoryURL = FileManager.default.temporaryDirectory.appendingPathComponent(UUID().uuidString, isDirectory: true)
+        try FileManager.default.createDirectory(at: directoryURL, withIntermediateDirectories: true)
+    }
+
+    override func tearDownWithError() throws {
+        try? FileManager.default.removeItem(at: directoryURL)
+    }
+
+    private func comment(id: String, depth: Int, replies: [TalkPageItem] = []) -> TalkPageItem {
+        return TalkPageItem(type: .comment, level: depth, id: id, html: "<p>Comment \(id) 🙂 with <b>markup</b></p>", name: nil, headingLevel: nil, replies: replies, otherContent: nil, author: "Author \(id)", timestamp: Date(timeIntervalSince1970: 1_600_000_000 + Double(depth)))
+    }
+
+    private func topics(count: Int) -> [TalkPageItem] {
+        return (0..<count).map { index in
+            let nestedReply = comment(id: "c-\(index)-2", depth: 3)
+            let replies = [comment(id: "c-\(index)-0", depth: 1, replies: [comment(id: "c-\(index)-1", depth: 2, replies: [nestedReply])])]
+            return TalkPageItem(type: .heading, level: 0, id: "h-\(index)", html: "Topic \(index)", name: "h-Topic_\(index)", headingLevel: 2, replies: replies, otherContent: index % 2 == 0 ? "Other content" : nil, author: nil, timestamp: nil)
+        }
+    }
+
+    private func assertEqual(_ lhs: TalkPageItem, _ rhs: TalkPageItem, file: StaticString = #filePath, line: UInt = #line) {
+        XCTAssertEqual(lhs.type, rhs.type, file: file, line: line)
+        XCTAssertEqual(lhs.level, rhs.level, file: file, line: line)
+        XCTAssertEqual(lhs.id, rhs.id, file: file, line: line)
+        XCTAssertEqual(lhs.html, rhs.html, file: file, line: line)
+        XCTAssertEqual(lhs.name, rhs.name, file: file, line: line)
+        XCTAssertEqual(lhs.headingLevel, rhs.headingLevel, file: file, line: line)
+        XCTAssertEqual(lhs.otherContent, rhs.otherContent, file: file, line: line)
+        XCTAssertEqual(lhs.author, rhs.author, file: file, line: line)
+        XCTAssertEqual(lhs.timestamp, rhs.timestamp, file: file, line: line)
+        XCTAssertEqual(lhs.replies.count, rhs.replies.count, file: file, line: line)
+        for (lhsReply, rhsReply) in zip(lhs.replies, rhs.replies) {
+            assertEqual(lhsReply, rhsReply, file: file, line: line)
+        }
+    }
+
+    func testRoundTripPreservesNestedReplies() throws {
+        let original = topics(count: 25)
+        let reader = try TalkPageCacheFile.Reader(data: TalkPageCacheFile.encode(original))
+
+        XCTAssertEqual(reader.topicCount, 25)
+        let decoded = try reader.allTopics()
+        XCTAssertEqual(decoded.count, original.count)
+        for (lhs, rhs) in zip(original, decoded) {
+            assertEqual(lhs, rhs)
+        }
+    }
+
+    func testTopicsDecodeIndependently() throws {
+        let original = topics(count: 100)
+        let reader = try TalkPageCacheFile.Reader(data: TalkPageCacheFile.encode(original))
+
+        assertEqual(try reader.topic(at: 73), original[73])
+        let firstScreen = try reader.topics(in: 0..<10)
+        XCTAssertEqual(firstScreen.map { $0.id }, original.prefix(10).map { $0.id })
+        XCTAssertEqual(try reader.topics(in: 95..<200).count, 5)
+    }
+
+    func testTruncatedFileFailsToDecode() throws {
+        let data = TalkPageCacheFile.encode(topics(count: 3))
+        XCTAssertThrowsError(try TalkPageCacheFile.Reader(data: data.prefix(12)))
+
+        XCTAssertThrowsError(try TalkPageCacheFile.Reader(data: data.prefix(data.count - 4)))
+    }
+
+    func testLegacyJSONCacheIsMigrated() throws {
+        let original = topics(count: 4)
+        let legacyData = try JSONEncoder().encode(TalkPageCache(talkPages: original))
+        try legacyData.write(to: directoryURL.appendingPathComponent("en.wikipedia.org-Talk:Cat").appendingPathExtension("json"))
+
+        let store = TalkPageCacheStore(directoryURL: directoryURL)
+        let reader = try XCTUnwrap(store.reader(for: "en.wikipedia.org-Talk:Cat"))
+        XCTAssertEqual(try reader.allTopics().map { $0.id }, original.map { $0.id })
+        XCTAssertFalse(FileManager.default.fileExists(atPath: directoryURL.appendingPathComponent("en.wikipedia.org-Talk:Cat.json").path))
+        XCTAssertNotNil(TalkPageCacheStore(directoryURL: directoryURL).reader(for: "en.wikipedia.org-Talk:Cat"))
+    }
+
+    func testEvictionKeepsMostRecentlyAccessedPages() throws {
+        let store = TalkPageCacheStore(directoryURL: directoryURL)
+        let pageCount = TalkPageCacheStore.maxCachedTalkPageCount + 5
+        for index in 0..<pageCount {
+            store.save(topics(count: 1), for: "page-\(index)")
+        }
+        // Reading the oldest page makes it the most recently accessed
+        XCTAssertNotNil(store.reader(for: "page-0"))
+
+        store.deleteStaleCachedItems(cleanupLevel: .low)
+
+        XCTAssertNotNil(store.reader(for: "page-0"))
+        for index in 1...5 {
+            XCTAssertNil(store.reader(for: "page-\(index)"), "page-\(index) should have been evicted")
+        }
+        XCTAssertNotNil(store.reader(for: "page-\(pageCount - 1)"))
+
+        store.deleteStaleCachedItems(cleanupLevel: .high)
+        XCTAssertNil(store.reader(for: "page-0"))
+    }
+}
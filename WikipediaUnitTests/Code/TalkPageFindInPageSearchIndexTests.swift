@@ -0,0 +1,110 @@
+import XCTest
+@testable import Wikipedia
+
+class TalkPageFindInPageSearchIndexTests: XCTestCase {
+
+    private let traitCollection = UITraitCollection(preferredContentSizeCategory: .large)
+
+    private func comment(id: String, html: String) -> TalkPageCellCommentViewModel {
+        return TalkPageCellCommentViewModel(commentId: id, html: html, author: "Author", authorTalkPageURL: "", timestamp: nil, replyDepth: 0, talkPageURL: nil)!
+    }
+
+    private func topic(id: String, titleHtml: String, leadCommentHtml: String?, otherContentHtml: String? = nil, replyHtmls: [String] = []) -> TalkPageCellViewModel {
+        let leadComment = leadCommentHtml.map { comment(id: "\(id)-lead", html: $0) }
+        let replies = replyHtmls.enumerated().map { comment(id: "\(id)-\($0.offset)", html: $0.element) }
+        return TalkPageCellViewModel(id: id, topicTitleHtml: titleHtml, timestamp: nil, topicName: id, leadComment: leadComment, otherContentHtml: otherContentHtml, replies: replies, activeUsersCount: nil, isUserPermanent: false, dateFormatter: nil)
+    }
+
+    private lazy var topics: [TalkPageCellViewModel] = [
+        topic(id: "1", titleHtml: "Earth <b>Science</b>", leadCommentHtml: "<p>The Earth is the third planet.</p>", replyHtmls: ["Earthquakes happen on <i>Earth</i>.", "Mars is next."]),
+        topic(id: "2", titleHtml: "İstanbul", leadCommentHtml: nil, otherContentHtml: "Unsigned note about the earth's crust"),
+        topic(id: "3", titleHtml: "Heart", leadCommentHtml: "Hearth and heart", replyHtmls: ["EARTH, Earth, earth"])
+    ]
+
+    private func buildIndex() -> TalkPageFindInPageSearchIndex {
+        return TalkPageFindInPageSearchIndex.build(from: TalkPageFindInPageSearchIndex.Source(topics: topics, traitCollection: traitCollection, theme: .light))
+    }
+
+    /// The text each result covers, rendered the same way the cells render it
+    private func matchedText(_ result: TalkPageFindInPageSearchController.SearchResult) -> String? {
+        let attributedString: NSAttributedString?
+        switch result.location {
+        case .topicTitle(let topicIndex, _):
+            attributedString = topics[topicIndex].topicTitleAttributedString(traitCollection: traitCollection, theme: .light)
+        case .topicLeadComment(let topicIndex, _):
+            attributedString = topics[topicIndex].leadCommentAttributedString(traitCollection: traitCollection, theme: .light)
+        case .topicOtherContent(let topicIndex):
+            attributedString = topics[topicIndex].otherContentAttributedString(traitCollection: traitCollection, theme: .light)
+        case .reply(let topicIndex, _, let replyIndex, _):
+            attributedString = topics[topicIndex].replies[replyIndex].commentAttributedString(traitCollection: traitCollection, theme: .light)
+        }
+        guard let attributedString, let range = result.range else {
+            return nil
+        }
+        return (attributedString.string as NSString).substring(with: range)
+    }
+
+    private func summary(of results: [TalkPageFindInPageSearchController.SearchResult]) -> [String] {
+        return results.map { "\($0.location) \(String(describing: $0.range))" }
+    }
+
+    func testResultsAreCaseInsensitiveAndInOrder() {
+        let results = buildIndex().search(term: "earth").results
+
+        XCTAssertEqual(results.map { matchedText($0) }, ["Earth", "Earth", "Earth", "Earth", "earth", "earth", "EARTH", "Earth", "earth"])
+        guard case .topicTitle(topicIndex: 0, _) = results.first?.location else {
+            return XCTFail("The first topic's title should be the first result")
+        }
+        guard case .reply(topicIndex: 2, _, replyIndex: 0, _) = results.last?.location else {
+            return XCTFail("The last topic's reply should be the last result")
+        }
+    }
+
+    func testRangesAccountForCharactersThatChangeLengthWhenLowercased() {
+        // "İ" lowercases to two UTF-16 units
+        let results = buildIndex().search(term: "stanbul").results
+
+        XCTAssertEqual(results.count, 1)
+        XCTAssertEqual(results.first?.range, NSRange(location: 1, length: 7))
+        XCTAssertEqual(results.first.flatMap { matchedText($0) }, "stanbul")
+    }
+
+    func testOverlappingOccurrencesAreNotReturnedTwice() {
+        let repeatedTopics = [topic(id: "1", titleHtml: "aaaa", leadCommentHtml: nil)]
+        let index = TalkPageFindInPageSearchIndex.build(from: TalkPageFindInPageSearchIndex.Source(topics: repeatedTopics, traitCollection: traitCollection, theme: .light))
+        XCTAssertEqual(index.search(term: "aa").results.map { $0.range }, [NSRange(location: 0, length: 2), NSRange(location: 2, length: 2)])
+    }
+
+    func testNarrowedQueriesMatchFullSearches() {
+        let index = buildIndex()
+        var previousQuery: TalkPageFindInPageSearchIndex.Query?
+
+        // Typing, deleting, and replacing the term
+        for term in ["e", "ea", "ear", "eart", "earth", "earthq", "earth", "art", "hear", "heart", "x", ""] {
+            let narrowedQuery = index.search(term: term, narrowing: previousQuery)
+            XCTAssertEqual(summary(of: narrowedQuery.results), summary(of: index.search(term: term).results), "Results for \"\(term)\" should not depend on the previous query")
+            previousQuery = narrowedQuery
+        }
+    }
+
+    func testIndexIsCurrentOnlyForSameTopics() {
+        let index = buildIndex()
+
+        XCTAssertTrue(index.isCurrent(for: topics))
+        XCTAssertFalse(index.isCurrent(for: Array(topics.dropLast())))
+        XCTAssertFalse(index.isCurrent(for: [topic(id: "1", titleHtml: "Earth <b>Science</b>", leadCommentHtml: nil)] + topics.dropFirst()), "A refetched topic is a different view model")
+    }
+
+    func testSearchWaitsForPreparedIndex() {
+        let controller = TalkPageFindInPageSearchController()
+        controller.prepareIndex(for: topics, traitCollection: traitCollection, theme: .light)
+
+        let searched = expectation(description: "Searched")
+        controller.search(term: "earth", in: topics, traitCollection: traitCollection, theme: .light) { results in
+            XCTAssertTrue(Thread.isMainThread)
+            XCTAssertEqual(self.summary(of: results), self.summary(of: self.buildIndex().search(term: "earth").results))
+            searched.fulfill()
+        }
+        wait(for: [searched], timeout: 5)
+    }
+}
@@ -0,0 +1,169 @@
+import XCTest
+@testable import WMF
+
+class WMFCrossProcessCoreDataSynchronizerTests: XCTestCase {
+
+    var directoryURL: URL!
+
+    override func setUpWithError() throws {
+        directoryURL = FileManager.default.temporaryDirectory.appendingPathComponent(UUID().uuidString, isDirectory: true)
+        try FileManager.default.createDirectory(at: directoryURL, withIntermediateDirectories: true)
+    }
+
+    override func tearDownWithError() throws {
+        try? FileManager.default.removeItem(at: directoryURL)
+    }
+
+    /// Linear congruential generator so failures are reproducible
+    private struct Generator {
+        var state: UInt64 = 0x5EED
+
+        mutating func next(_ upperBound: Int) -> Int {
+            state = state &* 6364136223846793005 &+ 1442695040888963407
+            return Int((state >> 33) % UInt64(upperBound))
+        }
+    }
+
+    /// Each context has its own persistent store coordinator on the same SQLite file and its own synchronizer, standing in for two processes.
+    /// The process about to write first merges whatever the other has journaled, so it merges runs of saves of varying length in one go.
+    func testInterleavedSavesAreNotLost() throws {
+        let identifier = "org.wikimedia.test.\(UUID().uuidString)"
+        let contexts = [try XCTUnwrap(CacheController.createCacheContext(cacheURL: directoryURL)), try XCTUnwrap(CacheController.createCacheContext(cacheURL: directoryURL))]
+        let synchronizers: [WMFCrossProcessCoreDataSynchronizer] = contexts.enumerated().map { (index, context) in
+            let synchronizer = WMFCrossProcessCoreDataSynchronizer(identifier: identifier, storageDirectory: directoryURL, processIdentifier: UInt64(index + 1))
+            synchronizer.startSynchronizingContexts([context])
+            return synchronizer
+        }
+        defer {
+            synchronizers.forEach { $0.stop() }
+        }
+
+        let saveCount = 10_000
+        var generator = Generator()
+        var expectedByteCounts: [String: Int64] = [:]
+        var liveKeys: [String] = []
+        var deletedObjectIDs: [NSManagedObjectID] = []
+        // Objects stay registered, and would keep stale values, unless merges refresh them
+        var materializedItems: [[CacheItem]] = [[], []]
+        var nextKey = 0
+
+        for save in 0..<saveCount {
+            let writer = generator.next(4) == 0 ? 1 - (save % 2) : (save / 7) % 2
+            synchronizers[writer].readChanges()
+            let context = contexts[writer]
+            let operation = liveKeys.count < 20 ? 0 : generator.next(10)
+            var saveError: Error?
+
+            context.performAndWait {
+                switch operation {
+                case 0..<3:
+                    let key = "item-\(nextKey)"
+                    nextKey += 1
+                    guard let item = CacheDBWriterHelper.createCacheItem(with: URL(string: "https://upload.wikimedia.org/\(key)")!, itemKey: key, variant: nil, in: context) else {
+                        XCTFail("Unable to create \(key)")
+                        return
+                    }
+                    item.byteCount = Int64(save)
+                    expectedByteCounts[key] = item.byteCount
+                    liveKeys.append(key)
+                    materializedItems[writer].append(item)
+                case 3..<8:
+                    let key = liveKeys[generator.next(liveKeys.count)]
+                    guard let item = CacheDBWriterHelper.cacheItem(with: key, variant: nil, in: context) else {
+                        XCTFail("\(key) written by the other process wasn't merged")
+                        return
+                    }
+                    item.byteCount = Int64(save)
+                    expectedByteCounts[key] = item.byteCount
+                    materializedItems[writer].append(item)
+                default:
+                    let index = generator.next(liveKeys.count)
+                    let key = liveKeys.remove(at: index)
+                    guard let item = CacheDBWriterHelper.cacheItem(with: key, variant: nil, in: context) else {
+                        XCTFail("\(key) written by the other process wasn't merged")
+                        return
+                    }
+                    deletedObjectIDs.append(item.objectID)
+                    expectedByteCounts.removeValue(forKey: key)
+                    context.delete(item)
+                }
+
+                do {
+                    try context.save()
+                } catch let error {
+                    saveError = error
+                }
+            }
+
+            if let saveError {
+                XCTFail("Save \(save) failed: \(saveError)")
+                return
+            }
+        }
+
+        for (synchronizer, context) in zip(synchronizers, contexts) {
+            synchronizer.readChanges()
+            context.performAndWait {
+                let fetchRequest: NSFetchRequest<CacheItem> = CacheItem.fetchRequest()
+                let items = (try? context.fetch(fetchRequest)) ?? []
+                var byteCounts: [String: Int64] = [:]
+                for item in items {
+                    guard let key = item.key else {
+                        continue
+                    }
+                    byteCounts[key] = item.byteCount
+                }
+                XCTAssertEqual(byteCounts, expectedByteCounts)
+
+                for objectID in deletedObjectIDs {
+                    XCTAssertThrowsError(try context.existingObject(with: objectID), "Deletions should be merged")
+                }
+            }
+        }
+
+        let journalURL = directoryURL.appendingPathComponent("\(identifier).journal")
+        let journalSize = try XCTUnwrap(journalURL.resourceValues(forKeys: [.fileSizeKey]).fileSize)
+        XCTAssertLessThan(journalSize, 1024 * 1024, "Entries both processes have read should be compacted away")
+        withExtendedLifetime(materializedItems) {}
+    }
+
+    func testNewProcessDoesNotReplayEarlierChanges() throws {
+        let identifier = "org.wikimedia.test.\(UUID().uuidString)"
+        let writerContext = try XCTUnwrap(CacheController.createCacheContext(cacheURL: directoryURL))
+        let writer = WMFCrossProcessCoreDataSynchronizer(identifier: identifier, storageDirectory: directoryURL, processIdentifier: 1)
+        writer.startSynchronizingContexts([writerContext])
+        defer {
+            writer.stop()
+        }
+
+        writerContext.performAndWait {
+            _ = CacheDBWriterHelper.createCacheItem(with: URL(string: "https://upload.wikimedia.org/Cat.jpg")!, itemKey: "Cat.jpg", variant: nil, in: writerContext)
+            XCTAssertNoThrow(try writerContext.save())
+        }
+
+        let readerContext = try XCTUnwrap(CacheController.createCacheContext(cacheURL: directoryURL))
+        let reader = WMFCrossProcessCoreDataSynchronizer(identifier: identifier, storageDirectory: directoryURL, processIdentifier: 2)
+        reader.startSynchronizingContexts([readerContext])
+        defer {
+            reader.stop()
+        }
+
+        var didMerge = false
+        let observer = NotificationCenter.default.addObserver(forName: .NSManagedObjectContextObjectsDidChange, object: readerContext, queue: nil) { _ in
+            didMerge = true
+        }
+        defer {
+            NotificationCenter.default.removeObserver(observer)
+        }
+
+        reader.readChanges()
+        XCTAssertFalse(didMerge)
+
+        writerContext.performAndWait {
+            _ = CacheDBWriterHelper.createCacheItem(with: URL(string: "https://upload.wikimedia.org/Dog.jpg")!, itemKey: "Dog.jpg", variant: nil, in: writerContext)
+            XCTAssertNoThrow(try writerContext.save())
+        }
+        reader.readChanges()
+        XCTAssertTrue(didMerge)
+    }
+}
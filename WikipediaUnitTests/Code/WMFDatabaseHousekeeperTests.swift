@@ -1,5 +1,6 @@
 import XCTest
-import WMF
+@testable import Wikipedia
+@testable import WMF
 
 class WMFDatabaseHousekeeperTests: XCTestCase {
     
@@ -35,4 +36,181 @@ class WMFDatabaseHousekeeperTests: XCTestCase {
         }
         XCTAssertEqual("2017/03/02 00:00 +0000", formatter.string(from: d1_plus1))
     }
+    
+    // MARK: - Article reference index
+    
+    private static let articleCount = 20_000
+    private static let groupCount = 50_000
+    
+    private func articleURL(_ index: Int) -> URL {
+        return URL(string: "https://en.wikipedia.org/wiki/Article_\(index)")!
+    }
+    
+    /// Deterministic content for group `index`, covering each way a group can reference articles
+    private func populateGroup(_ group: WMFContentGroup, index: Int, midnightUTCDate: Date) {
+        group.key = "https://en.wikipedia.org/group/\(index)"
+        group.midnightUTCDate = midnightUTCDate
+        let first = (index * 7) % Self.articleCount
+        let second = (index * 13 + 5) % Self.articleCount
+        switch index % 5 {
+        case 0:
+            group.contentType = .URL
+            group.setFullContentObject([articleURL(first), articleURL(second)] as NSArray)
+        case 1:
+            group.contentType = .topReadPreview
+            let preview = WMFFeedTopReadArticlePreview()
+            preview.articleURL = articleURL(first)
+            group.setFullContentObject([preview] as NSArray)
+        case 2:
+            group.contentType = .story
+            let preview = WMFFeedArticlePreview()
+            preview.articleURL = articleURL(second)
+            if let story = try? WMFFeedNewsStory(dictionary: ["articlePreviews": [preview]]) {
+                group.setFullContentObject([story] as NSArray)
+            }
+        case 3:
+            group.contentType = .image
+            group.articleURL = articleURL(first)
+        default:
+            group.contentType = .URL
+            group.contentPreview = articleURL(second) as NSURL
+        }
+    }
+    
+    /// The full scan the housekeeper did before article references were indexed
+    private func legacyReferencedArticleKeys(in moc: NSManagedObjectContext, oldestFeedDateMidnightUTC: Date) throws -> Set<String> {
+        var referencedArticleKeys = Set<String>()
+        for group in try moc.fetch(WMFContentGroup.fetchRequest()) {
+            if let midnightUTCDate = group.midnightUTCDate, midnightUTCDate < oldestFeedDateMidnightUTC {
+                continue
+            }
+            if let key = group.articleURL?.wmf_databaseKey {
+                referencedArticleKeys.insert(key)
+            }
+            if let previewURL = group.contentPreview as? NSURL, let key = previewURL.wmf_databaseKey {
+                referencedArticleKeys.insert(key)
+            }
+            guard let content = group.fullContent?.object as? [Any] else {
+                continue
+            }
+            for obj in content {
+                switch (group.contentType, obj) {
+                case (.URL, let url as NSURL):
+                    if let key = url.wmf_databaseKey {
+                        referencedArticleKeys.insert(key)
+                    }
+                case (.topReadPreview, let preview as WMFFeedTopReadArticlePreview):
+                    if let key = (preview.articleURL as NSURL).wmf_databaseKey {
+                        referencedArticleKeys.insert(key)
+                    }
+                case (.story, let story as WMFFeedNewsStory):
+                    for preview in story.articlePreviews ?? [] {
+                        if let key = (preview.articleURL as NSURL).wmf_databaseKey {
+                            referencedArticleKeys.insert(key)
+                        }
+                    }
+                default:
+                    break
+                }
+            }
+        }
+        return referencedArticleKeys
+    }
+    
+    func testIndexedHousekeepingMatchesFullScan() throws {
+        let dataStore = MWKDataStore.temporary()
+        defer {
+            dataStore.removeFolderAtBasePath()
+        }
+        let moc = dataStore.viewContext
+        
+        let today = Date() as NSDate
+        let recentDate = try XCTUnwrap(today.wmf_midnightUTCDateFromLocalDate(byAddingDays: 0))
+        let staleDate = try XCTUnwrap(today.wmf_midnightUTCDateFromLocalDate(byAddingDays: -(WMFExploreFeedMaximumNumberOfDays + 10)))
+        let oldestFeedDateMidnightUTC = try XCTUnwrap(today.wmf_midnightUTCDateFromLocalDate(byAddingDays: -WMFExploreFeedMaximumNumberOfDays))
+        
+        for index in 0..<Self.articleCount {
+            let article = try XCTUnwrap(moc.createArticle(withKey: (articleURL(index) as NSURL).wmf_databaseKey, variant: nil))
+            if index % 97 == 0 {
+                article.savedDate = Date()
+            } else if index % 89 == 0 {
+                article.viewedDate = Date()
+            }
+        }
+        
+        for index in 0..<Self.groupCount {
+            let group = WMFContentGroup(context: moc)
+            // Every tenth group is older than the feed keeps, so only its articles become unreferenced
+            populateGroup(group, index: index, midnightUTCDate: index % 10 == 9 ? staleDate : recentDate)
+            if index % 1000 == 999 {
+                try moc.save()
+            }
+        }
+        try moc.save()
+        
+        // Groups saved before the index existed have no references and must be backfilled
+        let legacyGroupsPredicate = NSPredicate(format: "key ENDSWITH '3'")
+        let markLegacy = NSBatchUpdateRequest(entityName: "WMFContentGroup")
+        markLegacy.predicate = legacyGroupsPredicate
+        markLegacy.propertiesToUpdate = ["articleReferencesVersion": 0]
+        try moc.execute(markLegacy)
+        let deleteLegacyReferences = NSBatchDeleteRequest(fetchRequest: NSFetchRequest<NSFetchRequestResult>(entityName: "WMFContentGroupArticleReference"))
+        deleteLegacyReferences.fetchRequest.predicate = NSPredicate(format: "contentGroup.key ENDSWITH '3'")
+        try moc.execute(deleteLegacyReferences)
+        moc.reset()
+        
+        let referencedArticleKeys = try legacyReferencedArticleKeys(in: moc, oldestFeedDateMidnightUTC: oldestFeedDateMidnightUTC)
+        let candidatesRequest = WMFArticle.fetchRequest()
+        candidatesRequest.predicate = NSPredicate(format: "viewedDate == NULL && savedDate == NULL && isDownloaded == NO && placesSortOrder == 0 && isExcludedFromFeed == NO")
+        let expectedDeletedKeys = Set(try moc.fetch(candidatesRequest).compactMap { $0.key }).subtracting(referencedArticleKeys)
+        XCTAssertFalse(expectedDeletedKeys.isEmpty)
+        XCTAssertFalse(referencedArticleKeys.isEmpty)
+        moc.reset()
+        
+        let deletedURLs = try WMFDatabaseHousekeeper().performHousekeepingOnManagedObjectContext(moc, navigationStateController: NavigationStateController(dataStore: dataStore), cleanupLevel: .low)
+        XCTAssertEqual(Set(deletedURLs.compactMap { ($0 as NSURL).wmf_databaseKey }), expectedDeletedKeys)
+        
+        let remainingRequest = NSFetchRequest<NSDictionary>(entityName: "WMFArticle")
+        remainingRequest.resultType = .dictionaryResultType
+        remainingRequest.propertiesToFetch = ["key"]
+        let remainingKeys = Set(try moc.fetch(remainingRequest).compactMap { $0["key"] as? String })
+        XCTAssertTrue(remainingKeys.isDisjoint(with: expectedDeletedKeys))
+        XCTAssertEqual(remainingKeys.count, Self.articleCount - expectedDeletedKeys.count)
+        
+        let staleGroupsRequest = WMFContentGroup.fetchRequest()
+        staleGroupsRequest.predicate = NSPredicate(format: "midnightUTCDate < %@", oldestFeedDateMidnightUTC as NSDate)
+        XCTAssertEqual(try moc.count(for: staleGroupsRequest), 0)
+        let orphanedReferencesRequest = NSFetchRequest<NSManagedObject>(entityName: "WMFContentGroupArticleReference")
+        orphanedReferencesRequest.predicate = NSPredicate(format: "contentGroup == NULL")
+        XCTAssertEqual(try moc.count(for: orphanedReferencesRequest), 0, "References should be deleted with their group")
+    }
+    
+    func testArticleReferencesFollowContentChanges() throws {
+        let dataStore = MWKDataStore.temporary()
+        defer {
+            dataStore.removeFolderAtBasePath()
+        }
+        let moc = dataStore.viewContext
+        
+        let group = WMFContentGroup(context: moc)
+        group.key = "https://en.wikipedia.org/group/related"
+        group.contentType = .URL
+        group.setFullContentObject([articleURL(1), articleURL(2)] as NSArray)
+        try moc.save()
+        
+        let referencedKeys: () -> Set<String> = {
+            Set((group.articleReferences ?? []).compactMap { $0.value(forKey: "articleKey") as? String })
+        }
+        XCTAssertEqual(referencedKeys(), Set([1, 2].compactMap { (self.articleURL($0) as NSURL).wmf_databaseKey }))
+        XCTAssertEqual(group.articleReferencesVersion, WMFContentGroupArticleReferencesVersion)
+        
+        group.setFullContentObject([articleURL(2), articleURL(3)] as NSArray)
+        try moc.save()
+        XCTAssertEqual(referencedKeys(), Set([2, 3].compactMap { (self.articleURL($0) as NSURL).wmf_databaseKey }))
+        XCTAssertEqual(group.articleReferences?.count, 2)
+        
+        group.wasDismissed = true
+        moc.updateContentGroupArticleReferences()
+        XCTAssertTrue(moc.insertedObjects.isEmpty && moc.deletedObjects.isEmpty, "Changes to other keys shouldn't rebuild references")
+    }
 }
@@ -0,0 +1,14 @@
+#import "WMFFeedContentSource.h"
+
+NS_ASSUME_NONNULL_BEGIN
+
+@interface WMFFeedContentSource (Testing)
+
+/**
+ * Saves a feed day that was fetched or loaded from a fixture, without fetching it.
+ */
+- (void)saveContentForFeedDay:(WMFFeedDayResponse *)feedDay pageViews:(NSDictionary<NSURL *, NSDictionary<NSDate *, NSNumber *> *> *)pageViews onDate:(NSDate *)date inManagedObjectContext:(NSManagedObjectContext *)moc completion:(nullable dispatch_block_t)completion NS_SWIFT_NAME(saveContent(for:pageViews:on:in:completion:));
+
+@end
+
+NS_ASSUME_NONNULL_END
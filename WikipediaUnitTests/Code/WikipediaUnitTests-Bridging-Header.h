@@ -1,6 +1,8 @@
 #import "WMFAsyncTestCase.h"
 #import "WMFTestFixtureUtilities.h"
 #import "MWKDataStore+TemporaryDataStore.h"
+#import "WMFFeedContentSource+Testing.h"
+#import "NSURL+WMFLinkParsing+Testing.h"
 #import "WMFRandomFileUtilities.h"
 #import "WMFHTTPHangingProtocol.h"
 #import "Nocilla.h"
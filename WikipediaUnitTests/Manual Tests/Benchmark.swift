@@ -0,0 +1,196 @@
+import Foundation
+
+/// Generates the same values for the same seed, so every run of a benchmark works on the same data
+struct SeededRandomNumberGenerator: RandomNumberGenerator {
+    private var state: UInt64
+
+    init(seed: UInt64) {
+        state = seed
+    }
+
+    // SplitMix64
+    mutating func next() -> UInt64 {
+        state &+= 0x9E3779B97F4A7C15
+        var z = state
+        z = (z ^ (z >> 30)) &* 0xBF58476D1CE4E5B9
+        z = (z ^ (z >> 27)) &* 0x94D049BB133111EB
+        return z ^ (z >> 31)
+    }
+
+    private static let syllables = ["ka", "lo", "mi", "ne", "ru", "sa", "to", "vi", "an", "el", "or", "us", "ta", "ri", "do", "pe"]
+
+    /// A title like `Kalomi Nerusa` with 1 to `maxWordCount` words
+    mutating func title(maxWordCount: Int = 3) -> String {
+        let wordCount = Int.random(in: 1...maxWordCount, using: &self)
+        let words = (0..<wordCount).map { _ -> String in
+            let syllableCount = Int.random(in: 2...4, using: &self)
+            let word = (0..<syllableCount).map { _ in Self.syllables.randomElement(using: &self) ?? "" }.joined()
+            return word.prefix(1).uppercased() + word.dropFirst()
+        }
+        return words.joined(separator: " ")
+    }
+}
+
+/// How many times a benchmark runs. Overridden by `WMF_BENCHMARK_WARMUP_ITERATIONS`, `WMF_BENCHMARK_ITERATIONS` and `WMF_BENCHMARK_REGRESSION_THRESHOLD` in the test environment.
+struct BenchmarkConfiguration {
+    /// Runs before measuring that aren't recorded, to fill caches and settle the process
+    var warmupIterations: Int
+    var iterations: Int
+    /// How much slower than the baseline's median a median can be before it's a regression, 0.1 is 10%
+    var regressionThreshold: Double
+
+    init(warmupIterations: Int = 1, iterations: Int = 5, regressionThreshold: Double = 0.1) {
+        self.warmupIterations = warmupIterations
+        self.iterations = iterations
+        self.regressionThreshold = regressionThreshold
+    }
+
+    func overridden(by environment: [String: String] = ProcessInfo.processInfo.environment) -> BenchmarkConfiguration {
+        var configuration = self
+        if let warmupIterations = environment["WMF_BENCHMARK_WARMUP_ITERATIONS"].flatMap({ Int($0) }), warmupIterations >= 0 {
+            configuration.warmupIterations = warmupIterations
+        }
+        if let iterations = environment["WMF_BENCHMARK_ITERATIONS"].flatMap({ Int($0) }), iterations > 0 {
+            configuration.iterations = iterations
+        }
+        if let regressionThreshold = environment["WMF_BENCHMARK_REGRESSION_THRESHOLD"].flatMap({ Double($0) }), regressionThreshold >= 0 {
+            configuration.regressionThreshold = regressionThreshold
+        }
+        return configuration
+    }
+}
+
+struct BenchmarkResult: Codable, Equatable {
+    let name: String
+    let seed: UInt64
+    /// Seconds for each measured iteration, in the order they ran
+    let samples: [TimeInterval]
+    let median: TimeInterval
+    let mean: TimeInterval
+    let min: TimeInterval
+    let max: TimeInterval
+    let standardDeviation: TimeInterval
+    var baselineMedian: TimeInterval?
+    /// Relative change of the median from the baseline's, 0.25 is 25% slower
+    var change: Double?
+    var isRegression = false
+
+    init(name: String, seed: UInt64, samples: [TimeInterval]) {
+        self.name = name
+        self.seed = seed
+        self.samples = samples
+        let sortedSamples = samples.sorted()
+        let count = sortedSamples.count
+        if count == 0 {
+            median = 0
+        } else if count % 2 == 0 {
+            median = (sortedSamples[count / 2 - 1] + sortedSamples[count / 2]) / 2
+        } else {
+            median = sortedSamples[count / 2]
+        }
+        mean = count > 0 ? samples.reduce(0, +) / Double(count) : 0
+        min = sortedSamples.first ?? 0
+        max = sortedSamples.last ?? 0
+        let mean = self.mean
+        standardDeviation = count > 1 ? sqrt(samples.reduce(0) { $0 + ($1 - mean) * ($1 - mean) } / Double(count - 1)) : 0
+    }
+
+    mutating func compare(toBaseline baseline: BenchmarkResult, regressionThreshold: Double) {
+        guard baseline.median > 0 else {
+            return
+        }
+        baselineMedian = baseline.median
+        let change = median / baseline.median - 1
+        self.change = change
+        isRegression = change > regressionThreshold
+    }
+
+    var summary: String {
+        var summary = String(format: "%@: median %.4fs, mean %.4fs, min %.4fs, max %.4fs, stddev %.4fs over %d iterations", name, median, mean, min, max, standardDeviation, samples.count)
+        if let baselineMedian, let change {
+            summary += String(format: ", %+.1f%% vs baseline %.4fs%@", change * 100, baselineMedian, isRegression ? " REGRESSION" : "")
+        }
+        return summary
+    }
+}
+
+/// Results of a benchmark run, written as JSON so later runs can use them as a baseline
+struct BenchmarkReport: Codable {
+    var date: Date
+    var operatingSystemVersion: String
+    var results: [BenchmarkResult]
+
+    init(date: Date = Date(), results: [BenchmarkResult] = []) {
+        self.date = date
+        self.operatingSystemVersion = ProcessInfo.processInfo.operatingSystemVersionString
+        self.results = results
+    }
+
+    static func load(from url: URL) throws -> BenchmarkReport {
+        let decoder = JSONDecoder()
+        decoder.dateDecodingStrategy = .iso8601
+        return try decoder.decode(BenchmarkReport.self, from: Data(contentsOf: url))
+    }
+
+    func write(to url: URL) throws {
+        let encoder = JSONEncoder()
+        encoder.dateEncodingStrategy = .iso8601
+        encoder.outputFormatting = [.prettyPrinted, .sortedKeys]
+        try encoder.encode(self).write(to: url, options: .atomic)
+    }
+}
+
+/// Runs benchmark scenarios and compares them to a baseline report.
+/// Reads the baseline from the report at `WMF_BENCHMARK_BASELINE_PATH` and writes results to `WMF_BENCHMARK_RESULTS_PATH`, or a temporary file, when set in the test environment.
+final class BenchmarkRunner {
+    let configuration: BenchmarkConfiguration
+    let resultsURL: URL
+    private let baselineResults: [String: BenchmarkResult]
+    private(set) var report = BenchmarkReport()
+
+    init(configuration: BenchmarkConfiguration = BenchmarkConfiguration().overridden(), baselineURL: URL? = nil, resultsURL: URL? = nil) {
+        let environment = ProcessInfo.processInfo.environment
+        self.configuration = configuration
+        self.resultsURL = resultsURL ?? environment["WMF_BENCHMARK_RESULTS_PATH"].map { URL(fileURLWithPath: $0) } ?? FileManager.default.temporaryDirectory.appendingPathComponent("benchmark-results.json")
+        let baselineURL = baselineURL ?? environment["WMF_BENCHMARK_BASELINE_PATH"].map { URL(fileURLWithPath: $0) }
+        let baseline = baselineURL.flatMap { try? BenchmarkReport.load(from: $0) }
+        var baselineResults: [String: BenchmarkResult] = [:]
+        for result in baseline?.results ?? [] {
+            baselineResults[result.name] = result
+        }
+        self.baselineResults = baselineResults
+    }
+
+    /// Runs `setUp` then times `run` for each iteration. `setUp` gets a generator seeded with `seed` each iteration, so every iteration measures the same work.
+    /// `tearDown` runs after each iteration and isn't timed either.
+    @discardableResult
+    func measure<State>(_ name: String, seed: UInt64, setUp: (inout SeededRandomNumberGenerator) throws -> State, run: (State) throws -> Void, tearDown: (State) throws -> Void = { _ in }) throws -> BenchmarkResult {
+        var samples: [TimeInterval] = []
+        samples.reserveCapacity(configuration.iterations)
+        for iteration in 0..<(configuration.warmupIterations + configuration.iterations) {
+            var generator = SeededRandomNumberGenerator(seed: seed)
+            let state = try setUp(&generator)
+            let start = CFAbsoluteTimeGetCurrent()
+            try run(state)
+            let duration = CFAbsoluteTimeGetCurrent() - start
+            try tearDown(state)
+            if iteration >= configuration.warmupIterations {
+                samples.append(duration)
+            }
+        }
+
+        var result = BenchmarkResult(name: name, seed: seed, samples: samples)
+        if let baseline = baselineResults[name] {
+            result.compare(toBaseline: baseline, regressionThreshold: configuration.regressionThreshold)
+        }
+        report.results.removeAll { $0.name == name }
+        report.results.append(result)
+        print(result.summary)
+        return result
+    }
+
+    func writeReport() throws {
+        try report.write(to: resultsURL)
+        print("Benchmark results written to \(resultsURL.path)")
+    }
+}
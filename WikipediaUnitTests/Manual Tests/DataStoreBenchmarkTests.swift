@@ -0,0 +1,284 @@
+import XCTest
+@testable import Wikipedia
+@testable import WMF
+
+/// Scripted data store scenarios measured with `BenchmarkRunner`. Each scenario builds its data from a fixed seed, so results are comparable across runs.
+/// Run with the Performance Testing scheme, optionally setting `WMF_BENCHMARK_BASELINE_PATH` to the results of an earlier run to fail on regressions.
+class DataStoreBenchmarkTests: XCTestCase {
+
+    private static let runner = BenchmarkRunner()
+    private let timeout: TimeInterval = 60
+
+    private func makeDataStore() -> MWKDataStore {
+        var dataStore: MWKDataStore!
+        let dataStoreExpectation = expectation(description: "Waiting for temp database setup")
+        MWKDataStore.createTemporaryDataStore { result in
+            dataStore = result
+            dataStoreExpectation.fulfill()
+        }
+        wait(for: [dataStoreExpectation], timeout: timeout)
+        return dataStore
+    }
+
+    private func articleURL(title: String) -> URL {
+        return URL(string: "https://en.wikipedia.org/wiki/\(title.replacingOccurrences(of: " ", with: "_"))")!
+    }
+
+    private func record(_ result: BenchmarkResult, file: StaticString = #filePath, line: UInt = #line) throws {
+        try Self.runner.writeReport()
+        if result.isRegression, let change = result.change {
+            XCTFail(String(format: "%@ is %.1f%% slower than the baseline", result.name, change * 100), file: file, line: line)
+        }
+    }
+
+    // MARK: - Reading lists
+
+    private static let savedArticleCount = 10_000
+    private static let readingListCount = 100
+
+    func testBulkSavingArticlesIntoReadingLists() throws {
+        let result = try Self.runner.measure("bulk-save-10k-articles-100-lists", seed: 1, setUp: { (generator) -> (MWKDataStore, [[WMFArticle]]) in
+            let dataStore = makeDataStore()
+            dataStore.readingListsController.maxListsPerUser = Self.readingListCount + 1
+            let moc = dataStore.viewContext
+            var articles: [WMFArticle] = []
+            var titles: Set<String> = []
+            while articles.count < Self.savedArticleCount {
+                let title = generator.title()
+                guard titles.insert(title).inserted, let article = moc.fetchOrCreateArticle(with: articleURL(title: title)) else {
+                    continue
+                }
+                articles.append(article)
+            }
+            try moc.save()
+            let articlesPerList = Self.savedArticleCount / Self.readingListCount
+            let articlesByList = stride(from: 0, to: articles.count, by: articlesPerList).map { Array(articles[$0..<min($0 + articlesPerList, articles.count)]) }
+            return (dataStore, articlesByList)
+        }, run: { (dataStore, articlesByList) in
+            for (index, articles) in articlesByList.enumerated() {
+                let list = try dataStore.readingListsController.createReadingList(named: "List \(index)")
+                try dataStore.readingListsController.add(articles: articles, to: list)
+            }
+        }, tearDown: { (dataStore, _) in
+            dataStore.removeFolderAtBasePath()
+        })
+        try record(result)
+    }
+
+    // MARK: - Feed
+
+    private static let feedDayCount = 30
+
+    /// The fixture's articles are renamed for each day, except every fourth one, so some articles are in the feed on more than one day like they are in practice
+    private func feedDayJSON(from fixtureJSON: [String: Any], day: Int, generator: inout SeededRandomNumberGenerator) -> [String: Any] {
+        var articleIndex = 0
+        func renamed(_ article: Any) -> Any {
+            guard var article = article as? [String: Any] else {
+                return article
+            }
+            defer {
+                articleIndex += 1
+            }
+            guard articleIndex % 4 != 0 else {
+                return article
+            }
+            let title = "\(generator.title()) \(day)"
+            article["normalizedtitle"] = title
+            article["content_urls"] = ["desktop": ["page": articleURL(title: title).absoluteString]]
+            return article
+        }
+
+        var json = fixtureJSON
+        if let featured = json["tfa"] {
+            json["tfa"] = renamed(featured)
+        }
+        if var mostRead = json["mostread"] as? [String: Any], let articles = mostRead["articles"] as? [Any] {
+            mostRead["articles"] = articles.map { renamed($0) }
+            json["mostread"] = mostRead
+        }
+        if let news = json["news"] as? [[String: Any]] {
+            json["news"] = news.map { story -> [String: Any] in
+                var story = story
+                if let links = story["links"] as? [Any] {
+                    story["links"] = links.map { renamed($0) }
+                }
+                return story
+            }
+        }
+        return json
+    }
+
+    func testImportingFeedDays() throws {
+        let fixtureJSON = try XCTUnwrap(wmf_bundle().wmf_jsonFromContentsOfFile("FeedDayResponse-en") as? [String: Any])
+        let siteURL = try XCTUnwrap(URL(string: "https://en.wikipedia.org"))
+        let today = Date()
+
+        let result = try Self.runner.measure("feed-import-30-days", seed: 2, setUp: { (generator) -> (MWKDataStore, WMFFeedContentSource, [(Date, WMFFeedDayResponse)]) in
+            let dataStore = makeDataStore()
+            let contentSource = WMFFeedContentSource(siteURL: siteURL, userDataStore: dataStore)
+            var feedDays: [(Date, WMFFeedDayResponse)] = []
+            for day in 0..<Self.feedDayCount {
+                let json = feedDayJSON(from: fixtureJSON, day: day, generator: &generator)
+                let feedDay = try XCTUnwrap(MTLJSONAdapter.model(of: WMFFeedDayResponse.self, fromJSONDictionary: json, languageVariantCode: nil) as? WMFFeedDayResponse)
+                let date = try XCTUnwrap(Calendar.current.date(byAdding: .day, value: -day, to: today))
+                feedDays.append((date, feedDay))
+            }
+            return (dataStore, contentSource, feedDays)
+        }, run: { (dataStore, contentSource, feedDays) in
+            let moc = dataStore.viewContext
+            let importExpectation = expectation(description: "Waiting for feed days to be saved")
+            importExpectation.expectedFulfillmentCount = feedDays.count
+            for (date, feedDay) in feedDays {
+                contentSource.saveContent(for: feedDay, pageViews: [:], on: date, in: moc) {
+                    importExpectation.fulfill()
+                }
+            }
+            wait(for: [importExpectation], timeout: timeout)
+            try moc.save()
+        }, tearDown: { (dataStore, _, _) in
+            dataStore.removeFolderAtBasePath()
+        })
+        try record(result)
+    }
+
+    // MARK: - Cache groups
+
+    private static let cacheGroupCount = 200
+    private static let cacheItemsPerGroup = 50
+
+    func testCreatingAndDeletingCacheGroups() throws {
+        let result = try Self.runner.measure("cache-groups-create-delete", seed: 3, setUp: { (generator) -> (URL, NSManagedObjectContext, [[String]]) in
+            let cacheURL = FileManager.default.temporaryDirectory.appendingPathComponent(UUID().uuidString, isDirectory: true)
+            let context = try XCTUnwrap(CacheController.createCacheContext(cacheURL: cacheURL))
+            // Groups share a pool of items, like articles sharing images and styles
+            let itemPool = (0..<(Self.cacheGroupCount * Self.cacheItemsPerGroup / 2)).map { "upload.wikimedia.org__\(generator.title(maxWordCount: 2).replacingOccurrences(of: " ", with: "_"))_\($0).jpg" }
+            let itemKeysByGroup = (0..<Self.cacheGroupCount).map { _ -> [String] in
+                var seenItemKeys: Set<String> = []
+                return (0..<Self.cacheItemsPerGroup).compactMap { _ in itemPool.randomElement(using: &generator) }.filter { seenItemKeys.insert($0).inserted }
+            }
+            return (cacheURL, context, itemKeysByGroup)
+        }, run: { (_, context, itemKeysByGroup) in
+            var saveError: Error?
+            context.performAndWait {
+                do {
+                    for (index, itemKeys) in itemKeysByGroup.enumerated() {
+                        guard let group = CacheDBWriterHelper.fetchOrCreateCacheGroup(with: "en.wikipedia.org/wiki/Group_\(index)", in: context) else {
+                            continue
+                        }
+                        for itemKey in itemKeys {
+                            guard let item = CacheDBWriterHelper.fetchOrCreateCacheItem(with: URL(string: "https://\(itemKey)")!, itemKey: itemKey, variant: "640", in: context) else {
+                                continue
+                            }
+                            group.addToCacheItems(item)
+                            item.isDownloaded = true
+                        }
+                    }
+                    try context.save()
+
+                    // Remove every group with the items only it has, as removing a saved article does
+                    for index in 0..<itemKeysByGroup.count {
+                        guard let group = CacheDBWriterHelper.cacheGroup(with: "en.wikipedia.org/wiki/Group_\(index)", in: context) else {
+                            continue
+                        }
+                        for case let item as CacheItem in group.cacheItems ?? [] where item.cacheGroups?.count == 1 {
+                            context.delete(item)
+                        }
+                        context.delete(group)
+                    }
+                    try context.save()
+                } catch let error {
+                    saveError = error
+                }
+            }
+            if let saveError {
+                throw saveError
+            }
+        }, tearDown: { (cacheURL, _, _) in
+            try? FileManager.default.removeItem(at: cacheURL)
+        })
+        try record(result)
+    }
+
+    // MARK: - Cache writes
+
+    func testReplayingArticleSaveUnbatched() throws {
+        try measureReplayingArticleSave("cache-writes-article-save-unbatched", maxBatchSize: 1)
+    }
+
+    func testReplayingArticleSaveBatched() throws {
+        try measureReplayingArticleSave("cache-writes-article-save-batched", maxBatchSize: CacheDBWriteBehindQueue.defaultMaxBatchSize)
+    }
+
+    /// Times replaying the cache writes made while saving an article, with `maxBatchSize: 1` saving once per write as before the write-behind queue
+    private func measureReplayingArticleSave(_ name: String, maxBatchSize: Int, file: StaticString = #filePath, line: UInt = #line) throws {
+        let result = try Self.runner.measure(name, seed: 5, setUp: { (_) -> (URL, CacheDBWriteBehindQueue) in
+            let cacheURL = FileManager.default.temporaryDirectory.appendingPathComponent(UUID().uuidString, isDirectory: true)
+            let context = try XCTUnwrap(CacheController.createCacheContext(cacheURL: cacheURL))
+            return (cacheURL, CacheDBWriteBehindQueue(context: context, maxBatchSize: maxBatchSize))
+        }, run: { (_, queue) in
+            let group = DispatchGroup()
+            for write in CacheDBWriteBehindQueueTests.recordedArticleSave {
+                group.enter()
+                CacheDBWriteBehindQueueTests.enqueue(write, on: queue) { _ in
+                    group.leave()
+                }
+            }
+            // Don't wait for the flush delay, which would be timed along with the saves
+            queue.flush()
+            group.wait()
+        }, tearDown: { (cacheURL, _) in
+            try? FileManager.default.removeItem(at: cacheURL)
+        })
+        try record(result, file: file, line: line)
+    }
+
+    // MARK: - Housekeeping
+
+    private static let agedArticleCount = 20_000
+    private static let agedGroupCount = 5_000
+    private static let agedStoreDayCount = 90
+
+    func testHousekeepingAgedStore() throws {
+        let result = try Self.runner.measure("housekeeping-aged-store", seed: 4, setUp: { (generator) -> MWKDataStore in
+            let dataStore = makeDataStore()
+            let moc = dataStore.viewContext
+            let today = Date() as NSDate
+            var articleURLs: [URL] = []
+            for index in 0..<Self.agedArticleCount {
+                let url = articleURL(title: "\(generator.title()) \(index)")
+                guard let article = moc.createArticle(withKey: (url as NSURL).wmf_databaseKey, variant: nil) else {
+                    continue
+                }
+                articleURLs.append(url)
+                // A few articles have user state and are never deleted
+                switch Int.random(in: 0..<100, using: &generator) {
+                case 0..<3:
+                    article.savedDate = Date()
+                case 3..<10:
+                    article.viewedDate = Date()
+                default:
+                    break
+                }
+            }
+            for index in 0..<Self.agedGroupCount {
+                let group = WMFContentGroup(context: moc)
+                group.key = "https://en.wikipedia.org/group/\(index)"
+                group.midnightUTCDate = today.wmf_midnightUTCDateFromLocalDate(byAddingDays: -Int.random(in: 0..<Self.agedStoreDayCount, using: &generator))
+                group.contentType = .URL
+                let content = (0..<4).compactMap { _ in articleURLs.randomElement(using: &generator) }
+                group.setFullContentObject(content as NSArray)
+                if index % 1000 == 999 {
+                    try moc.save()
+                }
+            }
+            try moc.save()
+            moc.reset()
+            return dataStore
+        }, run: { (dataStore) in
+            try WMFDatabaseHousekeeper().performHousekeepingOnManagedObjectContext(dataStore.viewContext, navigationStateController: NavigationStateController(dataStore: dataStore), cleanupLevel: .low)
+        }, tearDown: { (dataStore) in
+            dataStore.removeFolderAtBasePath()
+        })
+        try record(result)
+    }
+}
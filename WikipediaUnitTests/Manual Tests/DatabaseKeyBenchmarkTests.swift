@@ -0,0 +1,34 @@
+import XCTest
+
+/// Compares memoized `wmf_databaseKey` lookups to computing every key from `wmf_databaseURL`.
+/// Run with the Performance Testing scheme.
+class DatabaseKeyBenchmarkTests: XCTestCase {
+
+    private static let runner = BenchmarkRunner()
+    private static let lookupCount = 1_000_000
+    private static let distinctURLCount = 5_000
+
+    /// Lookups cycle through a set of URL strings with new URL instances, like URLs bridged from Swift or decoded from responses
+    private func measureLookups(_ name: String, databaseKey: @escaping (NSURL) -> String?) throws -> BenchmarkResult {
+        return try Self.runner.measure(name, seed: 39, setUp: { (generator) -> [NSURL] in
+            let urlStrings = DatabaseKeyTestCorpus.fuzzedURLStrings(count: Self.distinctURLCount, seed: generator.next())
+            return (0..<Self.lookupCount).compactMap { NSURL(string: urlStrings[$0 % urlStrings.count]) }
+        }, run: { (urls) in
+            var keyCount = 0
+            for url in urls where databaseKey(url) != nil {
+                keyCount += 1
+            }
+            XCTAssertEqual(keyCount, urls.count)
+        })
+    }
+
+    func testDatabaseKeyLookups() throws {
+        let uncached = try measureLookups("database-key-1m-uncached-lookups") { DatabaseKeyTestCorpus.uncachedDatabaseKey(for: $0) }
+        let memoized = try measureLookups("database-key-1m-memoized-lookups") { $0.wmf_databaseKey }
+        print(String(format: "Memoized database key lookups: %.3fs, uncached: %.3fs (%.1fx)", memoized.median, uncached.median, uncached.median / max(memoized.median, .leastNonzeroMagnitude)))
+        try Self.runner.writeReport()
+        for result in [uncached, memoized] where result.isRegression {
+            XCTFail(String(format: "%@ is %.1f%% slower than the baseline", result.name, (result.change ?? 0) * 100))
+        }
+    }
+}
@@ -0,0 +1,57 @@
+import XCTest
+@testable import Wikipedia
+
+/// Measures each stage of transforming a large diff: grouping items, building view models, and a theme change.
+/// Run with the Performance Testing scheme.
+class DiffTransformerBenchmarkTests: XCTestCase {
+
+    private static let runner = BenchmarkRunner()
+    private static let itemCount = 20_000
+
+    private let traitCollection = UITraitCollection(preferredContentSizeCategory: .large)
+
+    private func response(generator: inout SeededRandomNumberGenerator) -> DiffResponse {
+        return DiffTransformerTestCorpus.response(itemCount: Self.itemCount, seed: generator.next())
+    }
+
+    func testDiffTransformerStages() throws {
+        let transformer = DiffTransformer(type: .compare, siteURL: URL(string: "https://en.wikipedia.org")!)
+        let traitCollection = self.traitCollection
+
+        let legacyItems = try Self.runner.measure("diff-transformer-20k-legacy-items", seed: 47, setUp: { generator in
+            response(generator: &generator)
+        }, run: { response in
+            XCTAssertEqual(DiffTransformerTestCorpus.legacyTransformDiffItems(from: response).count, Self.itemCount)
+        })
+
+        let groups = try Self.runner.measure("diff-transformer-20k-groups", seed: 47, setUp: { generator in
+            response(generator: &generator)
+        }, run: { response in
+            XCTAssertFalse(DiffTransformer.groups(from: response, type: .compare).isEmpty)
+        })
+
+        let viewModels = try Self.runner.measure("diff-transformer-20k-view-models", seed: 47, setUp: { generator in
+            DiffTransformer.groups(from: response(generator: &generator), type: .compare)
+        }, run: { groups in
+            XCTAssertEqual(transformer.viewModels(from: groups, theme: .standard, traitCollection: traitCollection).count, groups.count)
+        })
+
+        // Only the items a cell shows build their attributed strings for the new theme
+        let themeChange = try Self.runner.measure("diff-transformer-20k-theme-change", seed: 47, setUp: { generator in
+            transformer.viewModels(from: DiffTransformer.groups(from: response(generator: &generator), type: .compare), theme: .standard, traitCollection: traitCollection)
+        }, run: { viewModels in
+            for var viewModel in viewModels {
+                viewModel.theme = .dark
+            }
+            for viewModel in viewModels.prefix(20) {
+                (viewModel as? DiffListChangeViewModel)?.items.forEach { _ = $0.textAttributedString }
+            }
+        })
+
+        print(String(format: "Diff transform of %d items: legacy items %.3fs, groups %.3fs, view models %.3fs, theme change %.3fs", Self.itemCount, legacyItems.median, groups.median, viewModels.median, themeChange.median))
+        try Self.runner.writeReport()
+        for result in [legacyItems, groups, viewModels, themeChange] where result.isRegression {
+            XCTFail(String(format: "%@ is %.1f%% slower than the baseline", result.name, (result.change ?? 0) * 100))
+        }
+    }
+}
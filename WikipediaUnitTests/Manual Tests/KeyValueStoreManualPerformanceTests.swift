@@ -0,0 +1,85 @@
+import XCTest
+import WMFData
+
+class KeyValueStoreManualPerformanceTests: XCTestCase {
+
+    private struct Fixture: Codable {
+        let id: Int
+        let title: String
+        let tags: [String]
+    }
+
+    private var directoryURL: URL!
+
+    override func setUp() {
+        super.setUp()
+        directoryURL = FileManager.default.temporaryDirectory.appendingPathComponent(UUID().uuidString, isDirectory: true)
+    }
+
+    override func tearDown() {
+        try? FileManager.default.removeItem(at: directoryURL)
+        super.tearDown()
+    }
+
+    /// 10,000 operations across 1,000 keys: 60% loads, 30% saves and 10% removals
+    private func runMixedOperations(on store: WMFKeyValueStore) {
+        let fixture = Fixture(id: 1, title: "Earth", tags: ["planet", "home"])
+        for index in 0..<10_000 {
+            let key = "Key \((index * 7919) % 1_000)"
+            switch index % 10 {
+            case 0..<6:
+                let _: Fixture? = try? store.load(key: key)
+            case 6..<9:
+                try? store.save(key: key, value: fixture)
+            default:
+                try? store.remove(key: key)
+            }
+        }
+    }
+
+    func testPerformanceMixedOperationsLogStructuredStore() throws {
+        let store = try WMFLogStructuredKeyValueStore(fileURL: directoryURL.appendingPathComponent("Store.log"))
+
+        self.measure {
+            runMixedOperations(on: store)
+        }
+    }
+
+    func testPerformanceMixedOperationsFilePerKeyStore() {
+        let store = FilePerKeyStore(directoryURL: directoryURL.appendingPathComponent("Files", isDirectory: true))
+
+        self.measure {
+            runMixedOperations(on: store)
+        }
+    }
+}
+
+/// Writes each value to its own JSON file, like `SharedContainerCacheStore`
+private final class FilePerKeyStore: WMFKeyValueStore {
+
+    private let directoryURL: URL
+
+    init(directoryURL: URL) {
+        self.directoryURL = directoryURL
+        try? FileManager.default.createDirectory(at: directoryURL, withIntermediateDirectories: true)
+    }
+
+    private func fileURL(key: [String]) -> URL {
+        return directoryURL.appendingPathComponent(key.joined(separator: "."))
+    }
+
+    func load<T: Codable>(key: String...) throws -> T? {
+        guard let data = try? Data(contentsOf: fileURL(key: key)) else {
+            return nil
+        }
+        return try JSONDecoder().decode(T.self, from: data)
+    }
+
+    func save<T: Codable>(key: String..., value: T) throws {
+        try JSONEncoder().encode(value).write(to: fileURL(key: key), options: .atomic)
+    }
+
+    func remove(key: String...) throws {
+        try? FileManager.default.removeItem(at: fileURL(key: key))
+    }
+}
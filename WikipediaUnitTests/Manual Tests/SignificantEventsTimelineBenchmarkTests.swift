@@ -0,0 +1,82 @@
+import XCTest
+@testable import Wikipedia
+@testable import WMF
+
+/// Measures paging through a 50 page significant events timeline, appending each page to the view model against rebuilding the view model from every page fetched so far.
+/// Run with the Performance Testing scheme.
+class SignificantEventsTimelineBenchmarkTests: XCTestCase {
+
+    private static let runner = BenchmarkRunner()
+    private static let pageCount = 50
+    private static let eventsPerPage = 20
+
+    private let traitCollection = UITraitCollection(preferredContentSizeCategory: .large)
+
+    /// Pages made from the fixture's events, with new revision IDs and timestamps going back a few hours per event
+    private func pages(generator: inout SeededRandomNumberGenerator) throws -> [SignificantEvents] {
+        let data = try XCTUnwrap(wmf_bundle().wmf_data(fromContentsOfFile: "SignificantEvents-ViewModelVariations", ofType: "json"))
+        let fixture = try XCTUnwrap(try JSONSerialization.jsonObject(with: data) as? [String: Any])
+        let templateEvents = try XCTUnwrap(fixture["timeline"] as? [[String: Any]])
+        let isoDateFormatter = ISO8601DateFormatter()
+
+        var date = Date(timeIntervalSince1970: 1_600_000_000)
+        var revId = 980_000_000
+        var pages: [SignificantEvents] = []
+        for pageIndex in 0..<Self.pageCount {
+            var timeline: [[String: Any]] = []
+            for _ in 0..<Self.eventsPerPage {
+                var event = templateEvents.randomElement(using: &generator) ?? [:]
+                event["revid"] = revId
+                event["parentid"] = revId - 1
+                event["timestamp"] = isoDateFormatter.string(from: date)
+                timeline.append(event)
+                revId -= Int.random(in: 1...20, using: &generator)
+                date.addTimeInterval(-TimeInterval(Int.random(in: 600...43_200, using: &generator)))
+            }
+
+            var page = fixture
+            page["timeline"] = timeline
+            page["nextRvStartId"] = pageIndex < Self.pageCount - 1 ? revId : 0
+            page["sha"] = pageIndex == 0 ? fixture["sha"] : nil
+            pages.append(try JSONDecoder().decode(SignificantEvents.self, from: JSONSerialization.data(withJSONObject: page)))
+        }
+        return pages
+    }
+
+    func testTimelinePaging() throws {
+        let traitCollection = self.traitCollection
+
+        // The timelines fetched so far after each page, joined outside of the measured block
+        let rebuild = try Self.runner.measure("significant-events-50-pages-rebuild", seed: 48, setUp: { generator in
+            var timelines: [SignificantEvents] = []
+            for page in try pages(generator: &generator) {
+                timelines.append(try timelines.last?.appending(page) ?? page)
+            }
+            return timelines
+        }, run: { timelines in
+            var viewModel: ArticleAsLivingDocViewModel?
+            for significantEvents in timelines {
+                viewModel = ArticleAsLivingDocViewModel(significantEvents: significantEvents, traitCollection: traitCollection, theme: .standard)
+            }
+            XCTAssertNotNil(viewModel)
+        })
+
+        let incremental = try Self.runner.measure("significant-events-50-pages-incremental", seed: 48, setUp: { generator in
+            try pages(generator: &generator)
+        }, run: { pages in
+            var viewModel = ArticleAsLivingDocViewModel(significantEvents: pages[0], traitCollection: traitCollection, theme: .standard)
+            for page in pages.dropFirst() {
+                if let pageViewModel = ArticleAsLivingDocViewModel(significantEvents: page, traitCollection: traitCollection, theme: .standard) {
+                    viewModel = viewModel?.appending(pageViewModel)
+                }
+            }
+            XCTAssertNotNil(viewModel)
+        })
+
+        print(String(format: "Paging %d significant events pages: rebuild %.3fs, incremental %.3fs", Self.pageCount, rebuild.median, incremental.median))
+        try Self.runner.writeReport()
+        for result in [rebuild, incremental] where result.isRegression {
+            XCTFail(String(format: "%@ is %.1f%% slower than the baseline", result.name, (result.change ?? 0) * 100))
+        }
+    }
+}
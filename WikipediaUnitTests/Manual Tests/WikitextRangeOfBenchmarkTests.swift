@@ -0,0 +1,183 @@
+import XCTest
+import WMFData
+
+/// Measures `WMFWikitextUtils.rangeOf` against the regex based implementation it replaced, finding a selection in a long article.
+/// Run with the Performance Testing scheme.
+class WikitextRangeOfBenchmarkTests: XCTestCase {
+
+    private static let runner = BenchmarkRunner()
+    private static let paragraphCount = 20
+
+    private static let filler = "The '''cat''' ('''''Felis catus''''') is the only [[Domestication of animals|domesticated]] species in the family [[Felidae]].<ref name=\"Felidae\">{{Cite book |last=Wozencraft |title=Mammal Species of the World}}</ref> It is valued by humans for companionship and its ability to kill [[vermin]]. "
+    private static let selectedWikitext = "12 to 16 hours{{sfn|Smith|2001|p=4}} a day"
+    private static let htmlInfo = WMFWikitextUtils.HtmlInfo(textBeforeTargetText: "Adult cats sleep", targetText: "12 to 16 hours a day", textAfterTargetText: ", often in short naps.")
+
+    /// A long article with the selection in the middle, so most of the text is near misses
+    private static func articleWikitext() -> (wikitext: String, expectedRange: NSRange) {
+        var paragraphs = ""
+        for _ in 0..<paragraphCount {
+            paragraphs += String(repeating: filler, count: 10) + "\n\n"
+        }
+        let wikitext = paragraphs + "Adult cats sleep \(selectedWikitext), often in short naps.\n\n" + paragraphs
+        return (wikitext, (wikitext as NSString).range(of: selectedWikitext))
+    }
+
+    func testRangeOfInLongArticle() throws {
+        let legacy = try Self.runner.measure("wikitext-range-of-long-article-legacy", seed: 36, setUp: { _ in
+            Self.articleWikitext()
+        }, run: { article in
+            _ = LegacyRangeOf.rangeOf(htmlInfo: Self.htmlInfo, inWikitext: article.wikitext)
+        })
+
+        let aligned = try Self.runner.measure("wikitext-range-of-long-article", seed: 36, setUp: { _ in
+            Self.articleWikitext()
+        }, run: { article in
+            XCTAssertEqual(WMFWikitextUtils.rangeOf(htmlInfo: Self.htmlInfo, inWikitext: article.wikitext), article.expectedRange)
+        })
+
+        let article = Self.articleWikitext()
+        let legacyFound = LegacyRangeOf.rangeOf(htmlInfo: Self.htmlInfo, inWikitext: article.wikitext) == article.expectedRange
+        print(String(format: "rangeOf in %d UTF-16 units: legacy %.4fs (found: %@), aligned %.4fs", (article.wikitext as NSString).length, legacy.median, legacyFound ? "yes" : "no", aligned.median))
+        try Self.runner.writeReport()
+        for result in [legacy, aligned] where result.isRegression {
+            XCTFail(String(format: "%@ is %.1f%% slower than the baseline", result.name, (result.change ?? 0) * 100))
+        }
+    }
+}
+
+/// The regex based implementation `rangeOf` replaced, kept to compare against
+private enum LegacyRangeOf {
+
+    private static let adjacentWordCount = 6
+    private static let adjacentCharacterCount = 200
+
+    static func rangeOf(htmlInfo: WMFWikitextUtils.HtmlInfo, inWikitext wikitext: String) -> NSRange {
+
+        guard !htmlInfo.targetText.isEmpty else {
+            return NSRange(location: NSNotFound, length: 0)
+        }
+
+        let htmlWordsBeforeTargetText = lastWordsOfText(text: htmlInfo.textBeforeTargetText, wordCount: adjacentWordCount)
+        let htmlWordsAfterTargetText = firstWordsOfText(text: htmlInfo.textAfterTargetText, wordCount: adjacentWordCount)
+
+        let regex = looseTargetTextRegex(htmlTargetText: htmlInfo.targetText)
+        guard let matches = regex?.matches(in: wikitext, range: NSRange(location: 0, length: wikitext.count)) else {
+            return NSRange(location: NSNotFound, length: 0)
+        }
+
+        var bestScoredMatch: NSTextCheckingResult?
+        var bestScore: Int?
+        for match in matches {
+            let score = scoreForMatch(match: match, wikitext: wikitext, htmlWordsBeforeTargetText: htmlWordsBeforeTargetText, htmlWordsAfterTargetText: htmlWordsAfterTargetText)
+
+            if let currentBestScore = bestScore,
+               score > currentBestScore {
+                bestScore = score
+                bestScoredMatch = match
+            } else if bestScoredMatch == nil {
+                bestScore = score
+                bestScoredMatch = match
+            }
+        }
+
+        return bestScoredMatch?.range ?? NSRange(location: NSNotFound, length: 0)
+    }
+
+    private static func lastWordsOfText(text: String, wordCount: Int) -> [String] {
+        return text.split(separator: " ").suffix(wordCount).map {String($0)}
+    }
+    
+    private static func firstWordsOfText(text: String, wordCount: Int) -> [String] {
+        return text.split(separator: " ").prefix(wordCount).map {String($0)}
+    }
+    
+    private static func looseTargetTextRegex(htmlTargetText: String) -> NSRegularExpression? {
+        
+        // Regex pattern is built up here
+        
+        // We replace all spaces in the htmlTargetText with additional regex that allows for square brackets, templates, html tags, etc.
+        let spaceRegexPattern = "\\s+"
+        let spaceReplaceRegexPattern = "(?:(?:\\[\\[[^\\]\\|]+\\|)|\\{\\{[^\\}]*\\}\\}|<[^>]*>|\\W)+"
+        let spaceRegex = try? NSRegularExpression(pattern: spaceRegexPattern)
+        var looseRegexPattern = htmlTargetText
+        if let matches = spaceRegex?.matches(in: htmlTargetText, range: NSRange(location: 0, length: htmlTargetText.count)) {
+            for match in matches.reversed() {
+                looseRegexPattern = (looseRegexPattern as NSString).replacingCharacters(in: match.range, with: spaceReplaceRegexPattern)
+            }
+        }
+        
+        return try? NSRegularExpression(pattern: looseRegexPattern)
+    }
+    
+    private static func scoreForMatch(match: NSTextCheckingResult, wikitext: String, htmlWordsBeforeTargetText: [String], htmlWordsAfterTargetText: [String]) -> Int {
+        let wikitextRangeBeforeMatchLocation = max(0, match.range.location - adjacentCharacterCount)
+        let wikitextRangeBeforeMatch = NSRange(location: wikitextRangeBeforeMatchLocation, length: match.range.location - wikitextRangeBeforeMatchLocation)
+        
+        let wikitextBeforeMatch = wordsOnly((wikitext as NSString).substring(with: wikitextRangeBeforeMatch))
+        let wikitextWordsBeforeMatch = lastWordsOfText(text: wikitextBeforeMatch, wordCount: adjacentWordCount)
+        
+        let wikitextRangeAfterMatchLocation = match.range.location + match.range.length
+        let wikitextRangeAfterMatch = NSRange(location: wikitextRangeAfterMatchLocation, length: min(adjacentCharacterCount, wikitext.count - wikitextRangeAfterMatchLocation))
+        
+        let wikitextAfterMatch = wordsOnly((wikitext as NSString).substring(with: wikitextRangeAfterMatch))
+        let wikitextWordsAfterMatch = firstWordsOfText(text: wikitextAfterMatch, wordCount: adjacentWordCount)
+        
+        let wordsBeforeScore = calculateScore(htmlWords: htmlWordsBeforeTargetText.reversed(), wikitextWords: wikitextWordsBeforeMatch.reversed())
+        let wordsAfterScore = calculateScore(htmlWords: htmlWordsAfterTargetText, wikitextWords: wikitextWordsAfterMatch)
+        
+        return wordsBeforeScore + wordsAfterScore
+    }
+    
+    private static func calculateScore(htmlWords: [String], wikitextWords: [String]) -> Int {
+        
+        var score: Int = 0
+        
+        for (htmlIndex, htmlWord) in htmlWords.enumerated() {
+            let indexInWikitextWords = wikitextWords.firstIndex(of: htmlWord)
+            
+            var wordScore: Int
+            if let indexInWikitextWords {
+                let distance = indexInWikitextWords - htmlIndex
+                wordScore = wikitextWords.count - htmlIndex - distance
+            } else {
+                wordScore = 0
+            }
+            
+            score += wordScore
+        }
+        
+        return score
+    }
+    
+    /// Replaces parenthesis and characters within with empty string
+    /// Replaces templates and characters within with empty string
+    /// Replaces any non-word character with empty space
+    /// Trims whitespace off final output
+    private static func wordsOnly(_ text: String) -> String {
+        let parenthesisRegexPattern = "\\(.*?\\)"
+        let templateRegexPattern = "\\{\\{.*\\}\\}"
+        let nonWordRegexPattern = "\\W+"
+        
+        var finalText = text
+        
+        if let parenthesisMatches = try? NSRegularExpression(pattern: parenthesisRegexPattern).matches(in: finalText, range: NSRange(location: 0, length: finalText.count)) {
+            for match in parenthesisMatches.reversed() {
+                finalText = (finalText as NSString).replacingCharacters(in: match.range, with: "")
+            }
+        }
+        
+        if let templateMatches = try? NSRegularExpression(pattern: templateRegexPattern).matches(in: finalText, range: NSRange(location: 0, length: finalText.count)) {
+            for match in templateMatches.reversed() {
+                finalText = (finalText as NSString).replacingCharacters(in: match.range, with: "")
+            }
+        }
+        
+        if let nonWordMatches = try? NSRegularExpression(pattern: nonWordRegexPattern).matches(in: finalText, range: NSRange(location: 0, length: finalText.count)) {
+            for match in nonWordMatches.reversed() {
+                finalText = (finalText as NSString).replacingCharacters(in: match.range, with: " ")
+            }
+        }
+        
+        return finalText.trimmingCharacters(in: .whitespaces)
+    }
+}